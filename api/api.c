@@ -458,6 +458,133 @@ static int API_dev_read(va_list ap)
 	return 0;
 }
 
+/* Checks the device_info and the vector list of a vectored storage read */
+static int api_dev_stor_vec(struct device_info *di, struct stor_vec *vec,
+			    int n)
+{
+	int i;
+
+	if (di == NULL)
+		return API_EINVAL;
+	if (di->cookie == NULL || !(di->type & DEV_TYP_STOR))
+		return API_ENODEV;
+
+	if (vec == NULL || n <= 0)
+		return API_EINVAL;
+
+	for (i = 0; i < n; i++)
+		if (vec[i].buf == NULL)
+			return API_EINVAL;
+
+	return 0;
+}
+
+/*
+ * pseudo signature:
+ *
+ * int API_dev_readv(
+ *	struct device_info *di,
+ *	struct stor_vec *vec,
+ *	int n,
+ *	lbasize_t *act_len
+ * )
+ *
+ * vec: n ranges of blocks to read, each to its own buffer; ranges that
+ *      are adjacent on the disk and in memory are read in one go
+ *
+ * act_len: ptr to where to put the # of blocks actually read, the reads
+ *          stop at the first range that comes up short
+ */
+static int API_dev_readv(va_list ap)
+{
+	struct device_info *di;
+	struct stor_vec *vec;
+	lbasize_t *act_len;
+	int n, err;
+
+	di = (struct device_info *)va_arg(ap, u_int32_t);
+	vec = (struct stor_vec *)va_arg(ap, u_int32_t);
+	n = va_arg(ap, int);
+
+	err = api_dev_stor_vec(di, vec, n);
+	if (err)
+		return err;
+
+	act_len = (lbasize_t *)va_arg(ap, u_int32_t);
+	if (!act_len)
+		return API_EINVAL;
+
+	*act_len = dev_readv_stor(di->cookie, vec, n);
+
+	return 0;
+}
+
+/*
+ * pseudo signature:
+ *
+ * int API_dev_read_submit(
+ *	struct device_info *di,
+ *	struct stor_vec *vec,
+ *	int n
+ * )
+ *
+ * Queues a vectored read and returns at once; vec and the buffers must
+ * stay put until API_dev_read_poll() reports the read done.  Only one
+ * read can be outstanding, API_EBUSY otherwise.
+ */
+static int API_dev_read_submit(va_list ap)
+{
+	struct device_info *di;
+	struct stor_vec *vec;
+	int n, err;
+
+	di = (struct device_info *)va_arg(ap, u_int32_t);
+	vec = (struct stor_vec *)va_arg(ap, u_int32_t);
+	n = va_arg(ap, int);
+
+	err = api_dev_stor_vec(di, vec, n);
+	if (err)
+		return err;
+
+	return dev_read_submit_stor(di->cookie, vec, n);
+}
+
+/*
+ * pseudo signature:
+ *
+ * int API_dev_read_poll(
+ *	struct device_info *di,
+ *	int *done,
+ *	lbasize_t *act_len
+ * )
+ *
+ * Moves the submitted read on by a bounded number of blocks and returns.
+ *
+ * done: ptr to where to put 1 once the read is finished, 0 while it is not
+ *
+ * act_len: ptr to where to put the # of blocks read when done; the call
+ *          returns API_EIO if that is short of the request
+ */
+static int API_dev_read_poll(va_list ap)
+{
+	struct device_info *di;
+	lbasize_t *act_len;
+	int *done;
+
+	di = (struct device_info *)va_arg(ap, u_int32_t);
+	if (di == NULL)
+		return API_EINVAL;
+	if (di->cookie == NULL || !(di->type & DEV_TYP_STOR))
+		return API_ENODEV;
+
+	done = (int *)va_arg(ap, u_int32_t);
+	act_len = (lbasize_t *)va_arg(ap, u_int32_t);
+	if (!done || !act_len)
+		return API_EINVAL;
+
+	return dev_read_poll_stor(di->cookie, done, act_len);
+}
+
 
 /*
  * pseudo signature:
@@ -663,6 +790,9 @@ void api_init(void)
 	calls_table[API_DISPLAY_GET_INFO] = &API_display_get_info;
 	calls_table[API_DISPLAY_DRAW_BITMAP] = &API_display_draw_bitmap;
 	calls_table[API_DISPLAY_CLEAR] = &API_display_clear;
+	calls_table[API_DEV_READV] = &API_dev_readv;
+	calls_table[API_DEV_READ_SUBMIT] = &API_dev_read_submit;
+	calls_table[API_DEV_READ_POLL] = &API_dev_read_poll;
 	calls_no = API_MAXCALL;
 
 	debugf("API initialized with %d calls\n", calls_no);
@@ -40,6 +40,9 @@ int	dev_close_stor(void *);
 int	dev_close_net(void *);
 
 lbasize_t	dev_read_stor(void *, void *, lbasize_t, lbastart_t);
+lbasize_t	dev_readv_stor(void *, struct stor_vec *, int);
+int		dev_read_submit_stor(void *, struct stor_vec *, int);
+int		dev_read_poll_stor(void *, int *, lbasize_t *);
 int		dev_read_net(void *, void *, int);
 int		dev_write_net(void *, void *, int);
 
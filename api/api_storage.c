@@ -388,3 +388,113 @@ lbasize_t dev_read_stor(void *cookie, void *buf, lbasize_t len, lbastart_t start
 
 	return (dd->block_read(dev_stor_index(dd), start, len, buf));
 }
+
+
+/*
+ * Ranges that continue each other on the disk and in memory are read with
+ * one block_read() call, a list of single blocks as well as a split up
+ * large read.  Stops at the first short read, returns the blocks read.
+ */
+lbasize_t dev_readv_stor(void *cookie, struct stor_vec *vec, int n)
+{
+	lbasize_t len, act, total = 0;
+	lbastart_t start;
+	char *buf;
+	block_dev_desc_t *dd = (block_dev_desc_t *)cookie;
+	int i;
+
+	for (i = 0; i < n; ) {
+		start = vec[i].start;
+		buf = vec[i].buf;
+		len = vec[i++].len;
+		while (i < n && vec[i].start == start + len &&
+		       vec[i].buf == buf + len * dd->blksz)
+			len += vec[i++].len;
+
+		act = dev_read_stor(cookie, buf, len, start);
+		total += act;
+		if (act != len)
+			break;
+	}
+
+	return total;
+}
+
+
+#ifndef CONFIG_API_STOR_POLL_BLKS
+#define CONFIG_API_STOR_POLL_BLKS	128
+#endif
+
+/*
+ * The one submitted read.  The block drivers are synchronous, so each
+ * poll reads at most CONFIG_API_STOR_POLL_BLKS blocks of it and returns:
+ * the application gets to run between the chunks instead of waiting for
+ * the whole list.
+ */
+static struct {
+	void		*cookie;
+	struct stor_vec	*vec;
+	int		n;
+	int		error;
+	lbasize_t	pos;		/* blocks read of vec[0] */
+	lbasize_t	total;
+} stor_req;
+
+int dev_read_submit_stor(void *cookie, struct stor_vec *vec, int n)
+{
+	if (stor_req.cookie != NULL)
+		return API_EBUSY;
+
+	stor_req.cookie = cookie;
+	stor_req.vec = vec;
+	stor_req.n = n;
+	stor_req.error = 0;
+	stor_req.pos = 0;
+	stor_req.total = 0;
+
+	return 0;
+}
+
+/*
+ * *done is set once the whole list is read or a read came up short;
+ * *act_len is then the number of blocks read, and the request is gone.
+ */
+int dev_read_poll_stor(void *cookie, int *done, lbasize_t *act_len)
+{
+	block_dev_desc_t *dd = (block_dev_desc_t *)cookie;
+	lbasize_t len, act, budget = CONFIG_API_STOR_POLL_BLKS;
+	struct stor_vec *v;
+
+	if (stor_req.cookie != cookie)
+		return API_EINVAL;
+
+	while (budget && stor_req.n && !stor_req.error) {
+		v = stor_req.vec;
+		len = min(v->len - stor_req.pos, budget);
+		act = dev_read_stor(cookie,
+				    (char *)v->buf + stor_req.pos * dd->blksz,
+				    len, v->start + stor_req.pos);
+		stor_req.total += act;
+		budget -= act;
+		if (act != len) {
+			stor_req.error = API_EIO;
+			break;
+		}
+
+		stor_req.pos += act;
+		if (stor_req.pos == v->len) {
+			stor_req.vec++;
+			stor_req.n--;
+			stor_req.pos = 0;
+		}
+	}
+
+	*done = !stor_req.n || stor_req.error;
+	if (*done) {
+		*act_len = stor_req.total;
+		stor_req.cookie = NULL;
+		return stor_req.error;
+	}
+
+	return 0;
+}
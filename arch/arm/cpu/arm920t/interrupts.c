@@ -31,6 +31,7 @@
 
 #include <common.h>
 #include <asm/proc-armv/ptrace.h>
+#include <prof.h>
 
 #if defined (CONFIG_ARCH_INTEGRATOR)
 void do_irq (struct pt_regs *pt_regs)
@@ -39,5 +40,6 @@ void do_irq (struct pt_regs *pt_regs)
 	/* Just clear it - count handled in */
 	/* integratorap.c                   */
 	*(volatile ulong *)(CONFIG_SYS_TIMERBASE + 0x0C) = 0;
+	prof_sample(pt_regs->ARM_pc);
 }
 #endif
@@ -272,10 +272,13 @@ void flush_dcache_all(void)
  */
 void invalidate_dcache_range(unsigned long start, unsigned long stop)
 {
+	/*
+	 * Outer cache first: a line fetched into L1 in between would
+	 * otherwise come from the stale copy in L2.
+	 */
+	v7_outer_cache_inval_range(start, stop);
 
 	v7_dcache_maint_range(start, stop, ARMV7_DCACHE_INVAL_RANGE);
-
-	v7_outer_cache_inval_range(start, stop);
 }
 
 /*
@@ -292,11 +295,37 @@ void flush_dcache_range(unsigned long start, unsigned long stop)
 
 void arm_init_before_mmu(void)
 {
+#ifndef CONFIG_SYS_L2CACHE_OFF
 	v7_outer_cache_enable();
+#endif
 	invalidate_dcache_all();
 	v7_inval_tlb();
 }
 
+#ifdef CONFIG_SYS_L2CACHE_BOOTM
+/*
+ * The L2 is kept off while drivers run but turned on while bootm copies
+ * and uncompresses the OS image, which does not involve any DMA.
+ */
+void arch_preload_os(void)
+{
+	if (!dcache_status())
+		return;
+
+	v7_outer_cache_inval_all();
+	v7_outer_cache_enable();
+}
+
+void arch_postload_os(void)
+{
+	if (!dcache_status())
+		return;
+
+	flush_dcache_all();
+	v7_outer_cache_disable();
+}
+#endif
+
 /*
  * Flush range from all levels of d-cache/unified-cache used:
  * Affects the range [start, start + size - 1]
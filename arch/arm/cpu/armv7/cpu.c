@@ -44,6 +44,19 @@ void save_boot_params_default(u32 r0, u32 r1, u32 r2, u32 r3)
 void save_boot_params(u32 r0, u32 r1, u32 r2, u32 r3)
 	__attribute__((weak, alias("save_boot_params_default")));
 
+#ifdef CONFIG_ARMV7_VFP
+/* Switch VFP off again, the kernel enables it when it needs it */
+static void vfp_disable(void)
+{
+	u32 cpacr;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	if ((cpacr & (0xf << 20)) == (0xf << 20))
+		/* vmsr fpexc, 0 */
+		asm volatile("mcr p10, 7, %0, c8, c0, 0" : : "r" (0));
+}
+#endif
+
 int cleanup_before_linux(void)
 {
 	/*
@@ -54,6 +67,10 @@ int cleanup_before_linux(void)
 	 */
 	disable_interrupts();
 
+#ifdef CONFIG_ARMV7_VFP
+	vfp_disable();
+#endif
+
 	/*
 	 * Turn off I-cache and invalidate it
 	 */
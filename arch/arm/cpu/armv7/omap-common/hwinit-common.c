@@ -32,6 +32,7 @@
 #include <asm/sizes.h>
 #include <asm/emif.h>
 #include <asm/omap_common.h>
+#include <spl.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -23,35 +23,23 @@
  * MA 02111-1307 USA
  */
 #include <common.h>
+#include <spl.h>
 #include <asm/u-boot.h>
 #include <asm/utils.h>
 #include <asm/arch/sys_proto.h>
-#include <nand.h>
 #include <mmc.h>
-#include <fat.h>
 #include <version.h>
 #include <asm/omap_common.h>
 #include <asm/arch/mmc_host_def.h>
-#include <i2c.h>
-#include <image.h>
-#include <malloc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 u32* boot_params_ptr = NULL;
-struct spl_image_info spl_image;
 
 /* Define global data structure pointer to it*/
 static gd_t gdata __attribute__ ((section(".data")));
 static bd_t bdata __attribute__ ((section(".data")));
 
-inline void hang(void)
-{
-	puts("### ERROR ### Please RESET the board ###\n");
-	for (;;)
-		;
-}
-
 void board_init_f(ulong dummy)
 {
 	/*
@@ -64,93 +52,64 @@ void board_init_f(ulong dummy)
 	relocate_code(CONFIG_SPL_STACK, &gdata, CONFIG_SPL_TEXT_BASE);
 }
 
-void spl_parse_image_header(const struct image_header *header)
+/* Hooks of the generic SPL in common/spl */
+u32 spl_boot_device(void)
 {
-	u32 header_size = sizeof(struct image_header);
-
-	if (__be32_to_cpu(header->ih_magic) == IH_MAGIC) {
-		spl_image.size = __be32_to_cpu(header->ih_size) + header_size;
-		spl_image.entry_point = __be32_to_cpu(header->ih_load);
-		/* Load including the header */
-		spl_image.load_addr = spl_image.entry_point - header_size;
-		spl_image.os = header->ih_os;
-		spl_image.name = (const char *)&header->ih_name;
-		debug("spl: payload image: %s load addr: 0x%x size: %d\n",
-			spl_image.name, spl_image.load_addr, spl_image.size);
-	} else {
-		/* Signature not found - assume u-boot.bin */
-		printf("mkimage signature not found - ih_magic = %x\n",
-			header->ih_magic);
-		puts("Assuming u-boot.bin ..\n");
-		/* Let's assume U-Boot will not be more than 200 KB */
-		spl_image.size = 200 * 1024;
-		spl_image.entry_point = CONFIG_SYS_TEXT_BASE;
-		spl_image.load_addr = CONFIG_SYS_TEXT_BASE;
-		spl_image.os = IH_OS_U_BOOT;
-		spl_image.name = "U-Boot";
+	switch (omap_boot_device()) {
+	case BOOT_DEVICE_MMC1:
+		return SPL_BOOT_DEVICE_MMC1;
+	case BOOT_DEVICE_MMC2:
+		return SPL_BOOT_DEVICE_MMC2;
+	case BOOT_DEVICE_NAND:
+		return SPL_BOOT_DEVICE_NAND;
 	}
+	return SPL_BOOT_DEVICE_NONE;
 }
 
-static void jump_to_image_no_args(void)
+u32 spl_mmc_boot_mode(void)
 {
-	typedef void (*image_entry_noargs_t)(u32 *)__attribute__ ((noreturn));
-	image_entry_noargs_t image_entry =
-			(image_entry_noargs_t) spl_image.entry_point;
-
-	debug("image entry point: 0x%X\n", spl_image.entry_point);
-	/* Pass the saved boot_params from rom code */
-#if defined(CONFIG_VIRTIO) || defined(CONFIG_ZEBU)
-	image_entry = (image_entry_noargs_t)0x80100000;
-#endif
-	u32 boot_params_ptr_addr = (u32)&boot_params_ptr;
-	image_entry((u32 *)boot_params_ptr_addr);
+	switch (omap_boot_mode()) {
+	case MMCSD_MODE_RAW:
+		return SPL_MMC_MODE_RAW;
+	case MMCSD_MODE_FAT:
+		return SPL_MMC_MODE_FAT;
+	}
+	return 0;
 }
 
-void jump_to_image_no_args(void) __attribute__ ((noreturn));
-void board_init_r(gd_t *id, ulong dummy)
+void spl_nand_setup(void)
 {
-	u32 boot_device;
-	debug(">>spl:board_init_r()\n");
-
-	mem_malloc_init(CONFIG_SYS_SPL_MALLOC_START,
-			CONFIG_SYS_SPL_MALLOC_SIZE);
-
-	timer_init();
-
-#ifdef CONFIG_SPL_BOARD_INIT
-	spl_board_init();
-#endif
-
-	boot_device = omap_boot_device();
-	debug("boot device - %d\n", boot_device);
-	switch (boot_device) {
-#ifdef CONFIG_SPL_MMC_SUPPORT
-	case BOOT_DEVICE_MMC1:
-	case BOOT_DEVICE_MMC2:
-		spl_mmc_load_image();
+	switch (omap_boot_mode()) {
+	case NAND_MODE_HW_ECC:
+		debug("spl: nand - using hw ecc\n");
+		gpmc_init();
 		break;
-#endif
-#ifdef CONFIG_SPL_NAND_SUPPORT
-	case BOOT_DEVICE_NAND:
-		spl_nand_load_image();
-		break;
-#endif
 	default:
-		printf("SPL: Un-supported Boot Device - %d!!!\n", boot_device);
+		puts("spl: ERROR: This bootmode is not implemented - hanging");
 		hang();
-		break;
 	}
+}
 
-	switch (spl_image.os) {
-	case IH_OS_U_BOOT:
-		debug("Jumping to U-Boot\n");
-		jump_to_image_no_args();
+/* Pass the saved boot_params from rom code */
+void *spl_uboot_args(void)
+{
+	return &boot_params_ptr;
+}
+
+#ifdef CONFIG_GENERIC_MMC
+int board_mmc_init(bd_t *bis)
+{
+	switch (omap_boot_device()) {
+	case BOOT_DEVICE_MMC1:
+		omap_mmc_init(0);
+		break;
+	case BOOT_DEVICE_MMC2:
+		omap_mmc_init(1);
 		break;
-	default:
-		puts("Unsupported OS image.. Jumping nevertheless..\n");
-		jump_to_image_no_args();
 	}
+	return 0;
 }
+#endif
 
 /* This requires UART clocks to be enabled */
 void preloader_console_init(void)
@@ -167,7 +167,7 @@ void init_omap_revision(void)
 	}
 }
 
-#ifndef CONFIG_SYS_L2CACHE_OFF
+#if !defined(CONFIG_SYS_L2CACHE_OFF) || defined(CONFIG_SYS_L2CACHE_BOOTM)
 void v7_outer_cache_enable(void)
 {
 	set_pl310_ctrl_reg(1);
@@ -0,0 +1,54 @@
+/*
+ * Cycle counter of the ARMv7 performance monitor for "time"
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * The SoC timers behind get_ticks() often run at 32 kHz or 1 MHz, too
+ * coarse for timing single block reads.  The PMU counts CPU cycles; it
+ * is set to count every 64th so that the 32 bit register wraps only
+ * after minutes, and extended to 64 bits in software.
+ */
+
+#include <common.h>
+#include <time_acct.h>
+
+#ifndef CONFIG_SYS_ARMV7_PMU_HZ
+#error CONFIG_SYS_ARMV7_PMU_HZ must be set to the CPU clock
+#endif
+
+#define PMCR_E		(1 << 0)	/* enable the counters */
+#define PMCR_C		(1 << 2)	/* reset the cycle counter */
+#define PMCR_D		(1 << 3)	/* count every 64th cycle */
+#define PMCNTEN_C	(1 << 31)	/* the cycle counter */
+
+static int pmu_started;
+static u32 pmu_last;
+static unsigned long long pmu_high;
+
+unsigned long long time_cycles(void)
+{
+	u32 now;
+
+	if (!pmu_started) {
+		asm volatile("mcr p15, 0, %0, c9, c12, 0"
+			     : : "r" (PMCR_E | PMCR_C | PMCR_D));
+		asm volatile("mcr p15, 0, %0, c9, c12, 1"
+			     : : "r" (PMCNTEN_C));
+		pmu_started = 1;
+	}
+
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r" (now));
+	if (now < pmu_last)
+		pmu_high += 1ULL << 32;
+	pmu_last = now;
+
+	return pmu_high | now;
+}
+
+ulong time_cycles_hz(void)
+{
+	return CONFIG_SYS_ARMV7_PMU_HZ / 64;
+}
@@ -25,11 +25,15 @@ void omap3_dma_init(void);
 int omap3_dma_conf_transfer(uint32_t chan, uint32_t *src, uint32_t *dst,
 		uint32_t sze);
 int omap3_dma_start_transfer(uint32_t chan);
+void omap3_dma_stop_transfer(uint32_t chan);
 int omap3_dma_wait_for_transfer(uint32_t chan);
 int omap3_dma_conf_chan(uint32_t chan, struct dma4_chan *config);
 int omap3_dma_get_conf_chan(uint32_t chan, struct dma4_chan *config);
 
 /* Register settings */
+#define CCR_SYNCHRO(req)		(((req) & 0x1f) | (((req) & 0x60) << 14))
+#define CCR_FS				(1 << 5)
+#define CCR_SEL_SRC_DST_SYNC		(1 << 24)
 #define CSDP_DATA_TYPE_8BIT             0x0
 #define CSDP_DATA_TYPE_16BIT            0x1
 #define CSDP_DATA_TYPE_32BIT            0x2
@@ -66,6 +70,11 @@ int omap3_dma_get_conf_chan(uint32_t chan, struct dma4_chan *config);
 #define CCR_RD_ACTIVE_MASK              (1 << 9)
 #define CCR_WR_ACTIVE_MASK              (1 << 10)
 
+#define CICR_BLOCK_IE			(1 << 5)
+#define CICR_TRANS_ERR_IE		(1 << 8)
+#define CICR_SUPERVISOR_ERR_IE		(1 << 10)
+#define CICR_MISALIGNED_ERR_IE		(1 << 11)
+
 #define CSR_TRANS_ERR			(1 << 8)
 #define CSR_SUPERVISOR_ERR		(1 << 10)
 #define CSR_MISALIGNED_ADRS_ERR		(1 << 11)
@@ -55,6 +55,14 @@ typedef struct t2 {
 #define OMAP_HSMMC2_BASE	0x480B4000
 #define OMAP_HSMMC3_BASE	0x480AD000
 
+/* System DMA requests of the controllers, as CCR synchro control */
+#define OMAP_HSMMC1_DMA_TX	61
+#define OMAP_HSMMC1_DMA_RX	62
+#define OMAP_HSMMC2_DMA_TX	47
+#define OMAP_HSMMC2_DMA_RX	48
+#define OMAP_HSMMC3_DMA_TX	77
+#define OMAP_HSMMC3_DMA_RX	78
+
 struct hsmmc {
 	unsigned char res1[0x10];
 	unsigned int sysconfig;		/* 0x10 */
@@ -101,6 +109,7 @@ struct hsmmc {
 #define BLEN_512BYTESLEN		(0x200 << 0)
 #define NBLK_STPCNT			(0x0 << 16)
 #define DE_DISABLE			(0x0 << 0)
+#define DE_ENABLE			(0x1 << 0)
 #define BCE_DISABLE			(0x0 << 1)
 #define BCE_ENABLE			(0x1 << 1)
 #define ACEN_DISABLE			(0x0 << 2)
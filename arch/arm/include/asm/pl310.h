@@ -27,7 +27,10 @@
 #include <linux/types.h>
 
 /* Register bit fields */
+#define PL310_CTRL_ENABLE			(1 << 0)
 #define PL310_AUX_CTRL_ASSOCIATIVITY_MASK	(1 << 16)
+#define PL310_AUX_CTRL_WAY_SIZE_SHIFT		17
+#define PL310_AUX_CTRL_WAY_SIZE_MASK		(7 << 17)
 
 struct pl310_regs {
 	u32 pl310_cache_id;
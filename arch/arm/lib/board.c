@@ -362,6 +362,36 @@ void board_init_f(ulong bootflag)
 	addr -= gd->mon_len;
 	addr &= ~(4096 - 1);
 
+#ifdef CONFIG_SYS_RELOC_TEXT_BASE
+	/*
+	 * Linked for where it runs: stay there if nothing reserved
+	 * above is in the way and what is reserved below still fits
+	 * into SDRAM.  Loaded there, by the SPL or a debugger,
+	 * relocate_code() then neither copies nor fixes up the image.
+	 */
+	{
+		/* board info, global data and the abort stack */
+		ulong below = sizeof(bd_t) + sizeof(gd_t) + 128;
+
+#ifndef CONFIG_SPL_BUILD
+		below += TOTAL_MALLOC_LEN;
+#endif
+#ifdef CONFIG_USE_IRQ
+		below += CONFIG_STACKSIZE_IRQ + CONFIG_STACKSIZE_FIQ;
+#endif
+#ifdef CONFIG_STACKSIZE
+		below += CONFIG_STACKSIZE;
+#endif
+		if (_TEXT_BASE <= addr &&
+		    _TEXT_BASE >= CONFIG_SYS_SDRAM_BASE + below)
+			addr = _TEXT_BASE;
+		else
+			printf("Warning: U-Boot linked at %08lx does not fit "
+			       "into SDRAM, relocating to %08lx\n",
+			       _TEXT_BASE, addr);
+	}
+#endif
+
 	debug("Reserving %ldk for U-Boot at: %08lx\n", gd->mon_len >> 10, addr);
 
 #ifndef CONFIG_SPL_BUILD
@@ -419,6 +449,15 @@ void board_init_f(ulong bootflag)
 	dram_init_banksize();
 	display_dram_config();	/* and display it */
 
+#if defined(CONFIG_SYS_ARM_EARLY_DCACHE) && !defined(CONFIG_SPL_BUILD)
+	/*
+	 * The TLB table and the DRAM banks are known now, so the MMU can
+	 * map DRAM cacheable and the relocation runs with the D-cache on.
+	 * relocate_code() flushes it before jumping to the new copy.
+	 */
+	dcache_enable();
+#endif
+
 	gd->relocaddr = addr;
 	gd->start_addr_sp = addr_sp;
 	gd->reloc_off = addr - _TEXT_BASE;
@@ -639,5 +678,6 @@ void board_init_r(gd_t *id, ulong dest_addr)
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	for (;;);
 }
@@ -29,6 +29,7 @@
 #include <fdt.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdt_stage.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -55,7 +56,7 @@ static struct tag *params;
 
 static ulong get_sp(void);
 #if defined(CONFIG_OF_LIBFDT)
-static int bootm_linux_fdt(int machid, bootm_headers_t *images);
+static int bootm_linux_fdt_prep(bootm_headers_t *images, int relocate);
 #endif
 
 void arch_lmb_reserve(struct lmb *lmb)
@@ -83,6 +84,7 @@ void arch_lmb_reserve(struct lmb *lmb)
 static void announce_and_cleanup(void)
 {
 	printf("\nStarting kernel ...\n\n");
+	serial_flush();
 
 #ifdef CONFIG_USB_DEVICE
 	{
@@ -93,38 +95,30 @@ static void announce_and_cleanup(void)
 	cleanup_before_linux();
 }
 
-int do_bootm_linux(int flag, int argc, char *argv[], bootm_headers_t *images)
+/*
+ * Build the ATAGs, or fix up the device tree, that the kernel is started
+ * with.  Unless relocate is clear, the ramdisk and the device tree are
+ * moved into place first, which the "ramdisk" and "fdt" subcommands of
+ * bootm have done otherwise.
+ */
+static int boot_prep_linux(bootm_headers_t *images, int relocate)
 {
+#if defined (CONFIG_SETUP_MEMORY_TAGS) || \
+    defined (CONFIG_CMDLINE_TAG) || \
+    defined (CONFIG_INITRD_TAG) || \
+    defined (CONFIG_SERIAL_TAG) || \
+    defined (CONFIG_REVISION_TAG)
 	bd_t	*bd = gd->bd;
-	char	*s;
-	int	machid = bd->bi_arch_number;
-	void	(*kernel_entry)(int zero, int arch, uint params);
-
+#endif
 #ifdef CONFIG_CMDLINE_TAG
 	char *commandline = getenv ("bootargs");
 #endif
 
-	if ((flag != 0) && (flag != BOOTM_STATE_OS_GO))
-		return 1;
-
-	s = getenv ("machid");
-	if (s) {
-		machid = simple_strtoul (s, NULL, 16);
-		printf ("Using machid 0x%x from environment\n", machid);
-	}
-
-	show_boot_progress (15);
-
 #ifdef CONFIG_OF_LIBFDT
 	if (images->ft_len)
-		return bootm_linux_fdt(machid, images);
+		return bootm_linux_fdt_prep(images, relocate);
 #endif
 
-	kernel_entry = (void (*)(int, int, uint))images->ep;
-
-	debug ("## Transferring control to Linux (at address %08lx) ...\n",
-	       (ulong) kernel_entry);
-
 #if defined (CONFIG_SETUP_MEMORY_TAGS) || \
     defined (CONFIG_CMDLINE_TAG) || \
     defined (CONFIG_INITRD_TAG) || \
@@ -149,11 +143,88 @@ int do_bootm_linux(int flag, int argc, char *argv[], bootm_headers_t *images)
 #endif
 	setup_end_tag(bd);
 #endif
+	return 0;
+}
+
+static void boot_jump_linux(bootm_headers_t *images)
+{
+	bd_t	*bd = gd->bd;
+	char	*s;
+	int	machid = bd->bi_arch_number;
+	void	(*kernel_entry)(int zero, int arch, uint params);
+	uint	params = bd->bi_boot_params;
+
+	s = getenv ("machid");
+	if (s) {
+		machid = simple_strtoul (s, NULL, 16);
+		printf ("Using machid 0x%x from environment\n", machid);
+	}
+
+#ifdef CONFIG_OF_LIBFDT
+	if (images->ft_len)
+		params = (uint)images->ft_addr;
+#endif
+	kernel_entry = (void (*)(int, int, uint))images->ep;
+
+	debug ("## Transferring control to Linux (at address %08lx) ...\n",
+	       (ulong) kernel_entry);
 
 	announce_and_cleanup();
 
-	kernel_entry(0, machid, bd->bi_boot_params);
+	kernel_entry(0, machid, params);
 	/* does not return */
+}
+
+#ifdef CONFIG_CMD_BOOTZ
+#define LINUX_ARM_ZIMAGE_MAGIC	0x016f2818
+
+struct arm_z_header {
+	uint32_t	code[9];
+	uint32_t	zi_magic;
+	uint32_t	zi_start;	/* link address, 0 if position independent */
+	uint32_t	zi_end;
+} __attribute__ ((__packed__));
+
+int bootz_setup(void *image, void **start, ulong *len)
+{
+	struct arm_z_header *zi = (struct arm_z_header *)image;
+
+	if (zi->zi_magic != LINUX_ARM_ZIMAGE_MAGIC) {
+		puts("Bad Linux ARM zImage magic!\n");
+		return 1;
+	}
+
+	*start = (void *)zi->zi_start;
+	*len = zi->zi_end - zi->zi_start;
+
+	printf("Kernel image @ %#08lx [ %#08x - %#08x ]\n",
+	       (ulong)image, zi->zi_start, zi->zi_end);
+
+	return 0;
+}
+#endif
+
+/*
+ * A plain bootm prepares and starts the kernel in one go; the "prep"
+ * and "go" subcommands do one half each.
+ */
+int do_bootm_linux(int flag, int argc, char *argv[], bootm_headers_t *images)
+{
+	int ret;
+
+	if ((flag != 0) && (flag != BOOTM_STATE_OS_PREP) &&
+	    (flag != BOOTM_STATE_OS_GO))
+		return 1;
+
+	if (flag != BOOTM_STATE_OS_GO) {
+		ret = boot_prep_linux(images, flag == 0);
+		if (ret || flag == BOOTM_STATE_OS_PREP)
+			return ret;
+	}
+
+	bootstage_mark(15);
+
+	boot_jump_linux(images);
 
 	return 1;
 }
@@ -174,10 +245,9 @@ static int fixup_memory_node(void *blob)
 	return fdt_fixup_memory_banks(blob, start, size, CONFIG_NR_DRAM_BANKS);
 }
 
-static int bootm_linux_fdt(int machid, bootm_headers_t *images)
+static int bootm_linux_fdt_prep(bootm_headers_t *images, int relocate)
 {
 	ulong rd_len;
-	void (*kernel_entry)(int zero, int dt_machid, void *dtblob);
 	ulong of_size = images->ft_len;
 	char **of_flat_tree = &images->ft_addr;
 	ulong *initrd_start = &images->initrd_start;
@@ -185,22 +255,22 @@ static int bootm_linux_fdt(int machid, bootm_headers_t *images)
 	struct lmb *lmb = &images->lmb;
 	int ret;
 
-	kernel_entry = (void (*)(int, int, void *))images->ep;
+	if (relocate) {
+		boot_fdt_add_mem_rsv_regions(lmb, *of_flat_tree);
 
-	boot_fdt_add_mem_rsv_regions(lmb, *of_flat_tree);
+		rd_len = images->rd_end - images->rd_start;
+		ret = boot_ramdisk_high(lmb, images->rd_start, rd_len,
+					initrd_start, initrd_end);
+		if (ret)
+			return ret;
 
-	rd_len = images->rd_end - images->rd_start;
-	ret = boot_ramdisk_high(lmb, images->rd_start, rd_len,
-				initrd_start, initrd_end);
-	if (ret)
-		return ret;
-
-	ret = boot_relocate_fdt(lmb, of_flat_tree, &of_size);
-	if (ret)
-		return ret;
+		ret = boot_relocate_fdt(lmb, of_flat_tree, &of_size);
+		if (ret)
+			return ret;
+	}
 
-	debug("## Transferring control to Linux (at address %08lx) ...\n",
-	       (ulong) kernel_entry);
+	/* write the fixups below out in one go */
+	fdt_stage_begin(*of_flat_tree);
 
 	fdt_chosen(*of_flat_tree, 1);
 
@@ -210,12 +280,14 @@ static int bootm_linux_fdt(int machid, bootm_headers_t *images)
 
 	fdt_initrd(*of_flat_tree, *initrd_start, *initrd_end, 1);
 
-	announce_and_cleanup();
+	ret = fdt_stage_commit(*of_flat_tree);
+	if (ret)
+		return ret;
 
-	kernel_entry(0, machid, *of_flat_tree);
-	/* does not return */
+	if (bootstage_fdt_add_report(*of_flat_tree))
+		puts("WARNING: could not add boot stages to the FDT\n");
 
-	return 1;
+	return 0;
 }
 #endif
 
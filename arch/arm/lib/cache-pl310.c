@@ -35,18 +35,37 @@ static void pl310_cache_sync(void)
 	writel(0, &pl310->pl310_cache_sync);
 }
 
-static void pl310_background_op_all_ways(u32 *op_reg)
+static int pl310_enabled(void)
 {
-	u32 assoc_16, associativity, way_mask;
+	return readl(&pl310->pl310_ctrl) & PL310_CTRL_ENABLE;
+}
+
+static u32 pl310_associativity(void)
+{
+	if (readl(&pl310->pl310_aux_ctrl) & PL310_AUX_CTRL_ASSOCIATIVITY_MASK)
+		return 16;
+	return 8;
+}
+
+/* Size of the cache in bytes: ways of 16KB << (way size field - 1) */
+static u32 pl310_cache_size(void)
+{
+	u32 way_size;
+
+	way_size = (readl(&pl310->pl310_aux_ctrl) &
+			PL310_AUX_CTRL_WAY_SIZE_MASK) >>
+			PL310_AUX_CTRL_WAY_SIZE_SHIFT;
+	if (!way_size)
+		way_size = 1;
+
+	return pl310_associativity() * ((16 * 1024) << (way_size - 1));
+}
 
-	assoc_16 = readl(&pl310->pl310_aux_ctrl) &
-			PL310_AUX_CTRL_ASSOCIATIVITY_MASK;
-	if (assoc_16)
-		associativity = 16;
-	else
-		associativity = 8;
+static void pl310_background_op_all_ways(u32 *op_reg)
+{
+	u32 way_mask;
 
-	way_mask = (1 << associativity) - 1;
+	way_mask = (1 << pl310_associativity()) - 1;
 	/* Invalidate all ways */
 	writel(way_mask, op_reg);
 	/* Wait for all ways to be invalidated */
@@ -71,6 +90,18 @@ void v7_outer_cache_flush_range(u32 start, u32 stop)
 	/* PL310 currently supports only 32 bytes cache line */
 	u32 pa, line_size = 32;
 
+	if (!pl310_enabled())
+		return;
+
+	/*
+	 * A loaded OS image is larger than the cache: cleaning it one
+	 * line at a time costs more than cleaning every way once.
+	 */
+	if (stop - start >= pl310_cache_size()) {
+		v7_outer_cache_flush_all();
+		return;
+	}
+
 	/*
 	 * Align to the beginning of cache-line - this ensures that
 	 * the first 5 bits are 0 as required by PL310 TRM
@@ -89,6 +120,9 @@ void v7_outer_cache_inval_range(u32 start, u32 stop)
 	/* PL310 currently supports only 32 bytes cache line */
 	u32 pa, line_size = 32;
 
+	if (!pl310_enabled())
+		return;
+
 	/*
 	 * If start address is not aligned to cache-line do not
 	 * invalidate the first cache-line
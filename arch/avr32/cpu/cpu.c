@@ -78,6 +78,8 @@ void prepare_to_boot(void)
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
+
 	/* This will reset the CPU core, caches, MMU and all internal busses */
 	__builtin_mtdr(8, 1 << 13);	/* set DC:DBE */
 	__builtin_mtdr(8, 1 << 30);	/* set DC:RES */
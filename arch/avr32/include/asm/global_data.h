@@ -63,6 +63,7 @@ typedef	struct	global_data {
 #define	GD_FLG_LOGINIT		0x00020	/* Log Buffer has been initialized	*/
 #define GD_FLG_DISABLE_CONSOLE	0x00040	/* Disable console (in & out)		*/
 #define GD_FLG_ENV_READY	0x00080	/* Environment imported into hash table	*/
+#define GD_FLG_QUIET		0x00100	/* Output held back until an error */
 
 #define DECLARE_GLOBAL_DATA_PTR register gd_t *gd asm("r5")
 
@@ -110,6 +110,7 @@ static int display_banner (void)
 
 void hang(void)
 {
+	serial_flush();
 	for (;;) ;
 }
 
@@ -79,6 +79,7 @@ static void bfin_reset(void)
  */
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
 	if (board_reset)
 		board_reset();
 	if (ANOMALY_05000353 || ANOMALY_05000386)
@@ -403,6 +403,7 @@ void hang(void)
 	status_led_set(STATUS_LED_CRASH, STATUS_LED_BLINKING);
 #endif
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	while (1)
 		/* If a JTAG emulator is hooked up, we'll automatically trigger
 		 * a breakpoint in it.  If one isn't, this is just a NOP.
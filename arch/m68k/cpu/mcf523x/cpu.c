@@ -38,6 +38,7 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	volatile ccm_t *ccm = (ccm_t *) MMAP_CCM;
 
+	serial_flush();
 	ccm->rcr = CCM_RCR_SOFTRST;
 	/* we don't return! */
 	return 0;
@@ -42,6 +42,7 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	volatile rcm_t *rcm = (rcm_t *)(MMAP_RCM);
 
+	serial_flush();
 	udelay(1000);
 
 	rcm->rcr = RCM_RCR_SOFTRST;
@@ -143,6 +144,8 @@ int checkcpu(void)
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
+
 	/* Call the board specific reset actions first. */
 	if(board_reset) {
 		board_reset();
@@ -180,6 +183,7 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	volatile wdog_t *wdp = (wdog_t *) (MMAP_WDOG);
 
+	serial_flush();
 	wdp->wdog_wrrr = 0;
 	udelay(1000);
 
@@ -260,6 +264,7 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	volatile rcm_t *rcm = (rcm_t *)(MMAP_RCM);
 
+	serial_flush();
 	udelay(1000);
 
 	rcm->rcr = RCM_RCR_SOFTRST;
@@ -38,6 +38,7 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	volatile rcm_t *rcm = (rcm_t *) (MMAP_RCM);
 
+	serial_flush();
 	udelay(1000);
 	rcm->rcr |= RCM_RCR_SOFTRST;
 
@@ -38,6 +38,7 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	volatile gptmr_t *gptmr = (gptmr_t *) (MMAP_GPTMR);
 
+	serial_flush();
 	gptmr->pre = 10;
 	gptmr->cnt = 1;
 
@@ -201,5 +201,6 @@ void board_init (void)
 void hang (void)
 {
 	puts ("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	for (;;) ;
 }
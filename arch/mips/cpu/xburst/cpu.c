@@ -71,6 +71,7 @@ void __attribute__((weak)) _machine_restart(void)
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
 	_machine_restart();
 
 	fprintf(stderr, "*** reset failed ***\n");
@@ -39,7 +39,7 @@ int do_bootm_linux(int flag, int argc, char * const argv[], bootm_headers_t *ima
 	/* find kernel entry point */
 	theKernel = (void (*)(int, char **, char **, int *))images->ep;
 
-	show_boot_progress (15);
+	bootstage_mark(15);
 
 	debug ("## Transferring control to Linux (at address %08lx) ...\n",
 		(ulong) theKernel);
@@ -62,6 +62,7 @@ int cleanup_before_linux(void)
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
 	disable_interrupts();
 
 	/*
@@ -431,6 +431,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	for (;;)
 		;
 }
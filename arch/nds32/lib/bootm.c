@@ -69,7 +69,7 @@ int do_bootm_linux(int flag, int argc, char *argv[], bootm_headers_t *images)
 		printf("Using machid 0x%x from environment\n", machid);
 	}
 
-	show_boot_progress(15);
+	bootstage_mark(15);
 
 	debug("## Transferring control to Linux (at address %08lx) ...\n",
 	       (ulong)theKernel);
@@ -176,5 +176,6 @@ void hang (void)
 {
 	disable_interrupts ();
 	puts("### ERROR ### Please reset board ###\n");
+	serial_flush();
 	for (;;);
 }
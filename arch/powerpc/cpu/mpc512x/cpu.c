@@ -96,6 +96,7 @@ do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		;
 
 	printf ("Resetting the board.\n");
+	serial_flush();
 	udelay(200);
 
 	/* Perform reset */
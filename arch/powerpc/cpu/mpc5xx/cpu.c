@@ -142,10 +142,14 @@ int do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 {
 #if defined(CONFIG_PATI)
 	volatile ulong *addr = (ulong *) CONFIG_SYS_RESET_ADDRESS;
+
+	serial_flush();
 	*addr = 1;
 #else
 	ulong addr;
 
+	serial_flush();
+
 	/* Interrupts off, enable reset */
 	__asm__ volatile	("  mtspr	81, %r0		\n\t"
 				 "  mfmsr	%r3		\n\t"
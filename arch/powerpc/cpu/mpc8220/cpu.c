@@ -57,6 +57,8 @@ int do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 	volatile gptmr8220_t *gptmr = (volatile gptmr8220_t *) MMAP_GPTMR;
 	ulong msr;
 
+	serial_flush();
+
 	/* Interrupts and MMU off */
 	__asm__ __volatile__ ("mfmsr    %0":"=r" (msr):);
 
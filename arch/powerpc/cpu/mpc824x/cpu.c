@@ -96,6 +96,8 @@ int do_reset (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	ulong msr, addr;
 
+	serial_flush();
+
 	/* Interrupts and MMU off */
 	__asm__ ("mtspr    81, 0");
 
@@ -244,6 +244,7 @@ do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 
 	volatile immap_t *immap = (immap_t *) CONFIG_SYS_IMMR;
 
+	serial_flush();
 	immap->im_clkrst.car_rmr = RMR_CSRE;	/* Checkstop Reset enable */
 
 	/* Interrupts and MMU off */
@@ -137,6 +137,7 @@ do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 	volatile immap_t *immap = (immap_t *) CONFIG_SYS_IMMR;
 
 	puts("Resetting the board.\n");
+	serial_flush();
 
 #ifdef MPC83xx_RESET
 
@@ -485,6 +485,7 @@ int do_reset (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	volatile immap_t *immap = (immap_t *) CONFIG_SYS_IMMR;
 
+	serial_flush();
 	immap->im_clkrst.car_plprcr |= PLPRCR_CSR;	/* Checkstop Reset enable */
 
 	/* Interrupts and MMU off */
@@ -524,6 +525,8 @@ int do_reset (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
  */
 int do_reset (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
+
 	/* prevent triggering the watchdog */
 	disable_interrupts ();
 
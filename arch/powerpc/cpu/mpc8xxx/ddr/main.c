@@ -14,6 +14,7 @@
 
 #include <common.h>
 #include <i2c.h>
+#include <version.h>
 #include <asm/fsl_ddr_sdram.h>
 
 #include "ddr.h"
@@ -27,6 +28,16 @@ extern void fsl_ddr_set_lawbar(
 extern void fsl_ddr_set_memctl_regs(const fsl_ddr_cfg_regs_t *regs,
 				   unsigned int ctrl_num);
 
+/*
+ * Waits for what the processor specific fsl_ddr_set_memctl_regs() has
+ * left running, for controllers that initialize memory in the background.
+ */
+void __fsl_ddr_wait_init(unsigned int ctrl_num)
+{
+}
+void fsl_ddr_wait_init(unsigned int ctrl_num)
+	__attribute__((weak, alias("__fsl_ddr_wait_init")));
+
 #if defined(SPD_EEPROM_ADDRESS) || \
     defined(SPD_EEPROM_ADDRESS1) || defined(SPD_EEPROM_ADDRESS2) || \
     defined(SPD_EEPROM_ADDRESS3) || defined(SPD_EEPROM_ADDRESS4)
@@ -53,15 +64,116 @@ u8 spd_i2c_addr[CONFIG_NUM_DDR_CONTROLLERS][CONFIG_DIMM_SLOTS_PER_CTLR] = {
 };
 #endif
 
+static int spd_read(u8 i2c_address, uint offset, uchar *buf, int len)
+{
+#ifdef CONFIG_SYS_SPD_BUS_SPEED
+	unsigned int speed = i2c_get_bus_speed();
+	int ret;
+
+	/* most SPD EEPROMs do fast mode, fall back for those that don't */
+	if (i2c_set_bus_speed(CONFIG_SYS_SPD_BUS_SPEED) == 0) {
+		ret = i2c_read(i2c_address, offset, 1, buf, len);
+		i2c_set_bus_speed(speed);
+		if (ret == 0)
+			return 0;
+	}
+#endif
+	return i2c_read(i2c_address, offset, 1, buf, len);
+}
+
+#ifdef CONFIG_SYS_SPD_CACHE_ADDR
+/*
+ * The SPD contents of the last boot, kept by the board in memory that
+ * survives a reset.  An entry is used again when its CRC checks out and
+ * the checksum bytes of the EEPROM still match: two bytes are read
+ * instead of the whole SPD.
+ */
+struct spd_cache {
+	u32 magic;
+	u32 i2c_address;
+	generic_spd_eeprom_t spd;
+	u32 crc;
+};
+
+#define SPD_CACHE_MAGIC		0x53504443	/* "SPDC" */
+
+#if defined(CONFIG_FSL_DDR3)
+#define SPD_CKSUM_OFFSET	offsetof(generic_spd_eeprom_t, crc)
+#define SPD_CKSUM_LEN		2
+#else
+#define SPD_CKSUM_OFFSET	offsetof(generic_spd_eeprom_t, cksum)
+#define SPD_CKSUM_LEN		1
+#endif
+
+static struct spd_cache *spd_cache_entry(u8 i2c_address)
+{
+	struct spd_cache *cache = (struct spd_cache *)CONFIG_SYS_SPD_CACHE_ADDR;
+	u8 *addr = &spd_i2c_addr[0][0];
+	int i;
+
+	for (i = 0; i < sizeof(spd_i2c_addr); i++)
+		if (addr[i] == i2c_address)
+			return &cache[i];
+	return NULL;
+}
+
+static int spd_cache_get(generic_spd_eeprom_t *spd, u8 i2c_address)
+{
+	struct spd_cache *c = spd_cache_entry(i2c_address);
+	uchar cksum[SPD_CKSUM_LEN];
+
+	if (!c || c->magic != SPD_CACHE_MAGIC ||
+	    c->i2c_address != i2c_address ||
+	    crc32(0, (uchar *)&c->spd, sizeof(c->spd)) != c->crc)
+		return -1;
+
+	if (spd_read(i2c_address, SPD_CKSUM_OFFSET, cksum, SPD_CKSUM_LEN) ||
+	    memcmp(cksum, (uchar *)&c->spd + SPD_CKSUM_OFFSET, SPD_CKSUM_LEN))
+		return -1;
+
+	memcpy(spd, &c->spd, sizeof(*spd));
+	return 0;
+}
+
+static void spd_cache_put(const generic_spd_eeprom_t *spd, u8 i2c_address)
+{
+	struct spd_cache *c = spd_cache_entry(i2c_address);
+
+	if (!c)
+		return;
+	c->magic = SPD_CACHE_MAGIC;
+	c->i2c_address = i2c_address;
+	memcpy(&c->spd, spd, sizeof(c->spd));
+	c->crc = crc32(0, (uchar *)&c->spd, sizeof(c->spd));
+}
+#else
+static inline int spd_cache_get(generic_spd_eeprom_t *spd, u8 i2c_address)
+{
+	return -1;
+}
+
+static inline void spd_cache_put(const generic_spd_eeprom_t *spd,
+				 u8 i2c_address)
+{
+}
+#endif
+
 static void __get_spd(generic_spd_eeprom_t *spd, u8 i2c_address)
 {
-	int ret = i2c_read(i2c_address, 0, 1, (uchar *)spd,
-				sizeof(generic_spd_eeprom_t));
+	int ret;
+
+	if (spd_cache_get(spd, i2c_address) == 0)
+		return;
+
+	ret = spd_read(i2c_address, 0, (uchar *)spd,
+		       sizeof(generic_spd_eeprom_t));
 
 	if (ret) {
 		printf("DDR: failed to read SPD from address %u\n", i2c_address);
 		memset(spd, 0, sizeof(generic_spd_eeprom_t));
+		return;
 	}
+	spd_cache_put(spd, i2c_address);
 }
 
 __attribute__((weak, alias("__get_spd")))
@@ -480,6 +592,108 @@ fsl_ddr_compute(fsl_ddr_info_t *pinfo, unsigned int start_step,
 	return total_mem;
 }
 
+#ifdef CONFIG_FSL_DDR_CACHE
+/*
+ * The register set computed on an earlier boot, stored by the board in
+ * flash or EEPROM.  It is programmed as is when the key still matches:
+ * the CRC of the SPD of all slots, the DDR clock, the "hwconfig"
+ * options and the U-Boot build.
+ */
+struct fsl_ddr_cache {
+	u32 magic;
+	u32 key;
+	u32 memctl_interleaved;
+	u32 reserved;
+	unsigned long long total_memory;
+	common_timing_params_t timing[CONFIG_NUM_DDR_CONTROLLERS];
+	fsl_ddr_cfg_regs_t regs[CONFIG_NUM_DDR_CONTROLLERS];
+	u32 crc;
+};
+
+#define FSL_DDR_CACHE_MAGIC	0x44445243	/* "DDRC" */
+
+/* Read/write len bytes of the cache storage; 0 on success */
+int __fsl_ddr_cache_read(void *buf, int len)
+{
+#ifdef CONFIG_SYS_DDR_CACHE_EEPROM_OFFSET
+	return eeprom_read(CONFIG_SYS_DEF_EEPROM_ADDR,
+			   CONFIG_SYS_DDR_CACHE_EEPROM_OFFSET, buf, len);
+#else
+	return -1;
+#endif
+}
+int fsl_ddr_cache_read(void *buf, int len)
+	__attribute__((weak, alias("__fsl_ddr_cache_read")));
+
+int __fsl_ddr_cache_write(const void *buf, int len)
+{
+#ifdef CONFIG_SYS_DDR_CACHE_EEPROM_OFFSET
+	return eeprom_write(CONFIG_SYS_DEF_EEPROM_ADDR,
+			    CONFIG_SYS_DDR_CACHE_EEPROM_OFFSET,
+			    (uchar *)buf, len);
+#else
+	return -1;
+#endif
+}
+int fsl_ddr_cache_write(const void *buf, int len)
+	__attribute__((weak, alias("__fsl_ddr_cache_write")));
+
+static u32 fsl_ddr_cache_key(const fsl_ddr_info_t *pinfo)
+{
+	char buffer[128];	/* what options.c looks at of hwconfig */
+	unsigned int freq = get_ddr_freq(0);
+	u32 key;
+
+	key = crc32(0, (const uchar *)pinfo->spd_installed_dimms,
+		    sizeof(pinfo->spd_installed_dimms));
+	key = crc32(key, (const uchar *)&freq, sizeof(freq));
+	if (getenv_f("hwconfig", buffer, sizeof(buffer)) > 0)
+		key = crc32(key, (const uchar *)buffer, strlen(buffer));
+	return crc32(key, (const uchar *)U_BOOT_VERSION_STRING,
+		     sizeof(U_BOOT_VERSION_STRING));
+}
+
+static int fsl_ddr_cache_restore(fsl_ddr_info_t *pinfo, u32 key,
+				 unsigned long long *total_memory,
+				 unsigned int *memctl_interleaved)
+{
+	struct fsl_ddr_cache cache;
+
+	if (fsl_ddr_cache_read(&cache, sizeof(cache)) ||
+	    cache.magic != FSL_DDR_CACHE_MAGIC || cache.key != key ||
+	    crc32(0, (uchar *)&cache, offsetof(struct fsl_ddr_cache, crc)) !=
+	    cache.crc)
+		return -1;
+
+	memcpy(pinfo->common_timing_params, cache.timing, sizeof(cache.timing));
+	memcpy(pinfo->fsl_ddr_config_reg, cache.regs, sizeof(cache.regs));
+	*total_memory = cache.total_memory;
+	*memctl_interleaved = cache.memctl_interleaved;
+	debug("DDR: using the stored controller setup\n");
+	return 0;
+}
+
+static void fsl_ddr_cache_save(const fsl_ddr_info_t *pinfo, u32 key,
+			       unsigned long long total_memory,
+			       unsigned int memctl_interleaved)
+{
+	struct fsl_ddr_cache cache;
+
+	memset(&cache, 0, sizeof(cache));
+	cache.magic = FSL_DDR_CACHE_MAGIC;
+	cache.key = key;
+	cache.memctl_interleaved = memctl_interleaved;
+	cache.total_memory = total_memory;
+	memcpy(cache.timing, pinfo->common_timing_params, sizeof(cache.timing));
+	memcpy(cache.regs, pinfo->fsl_ddr_config_reg, sizeof(cache.regs));
+	cache.crc = crc32(0, (uchar *)&cache,
+			  offsetof(struct fsl_ddr_cache, crc));
+
+	if (fsl_ddr_cache_write(&cache, sizeof(cache)))
+		debug("DDR: cannot store the controller setup\n");
+}
+#endif /* CONFIG_FSL_DDR_CACHE */
+
 /*
  * fsl_ddr_sdram() -- this is the main function to be called by
  *	initdram() in the board file.
@@ -492,6 +706,9 @@ phys_size_t fsl_ddr_sdram(void)
 	unsigned int memctl_interleaved;
 	unsigned long long total_memory;
 	fsl_ddr_info_t info;
+#ifdef CONFIG_FSL_DDR_CACHE
+	u32 cache_key = 0;
+#endif
 
 	/* Reset info structure. */
 	memset(&info, 0, sizeof(fsl_ddr_info_t));
@@ -502,7 +719,20 @@ phys_size_t fsl_ddr_sdram(void)
 		total_memory = fsl_ddr_interactive(&info);
 	else
 #endif
+#ifdef CONFIG_FSL_DDR_CACHE
+	{
+		for (i = 0; i < CONFIG_NUM_DDR_CONTROLLERS; i++)
+			fsl_ddr_get_spd(info.spd_installed_dimms[i], i);
+		cache_key = fsl_ddr_cache_key(&info);
+		if (fsl_ddr_cache_restore(&info, cache_key, &total_memory,
+					  &memctl_interleaved) == 0)
+			goto program;
+		total_memory = fsl_ddr_compute(&info,
+					       STEP_COMPUTE_DIMM_PARMS, 0);
+	}
+#else
 		total_memory = fsl_ddr_compute(&info, STEP_GET_SPD, 0);
+#endif
 
 	/* Check for memory controller interleaving. */
 	memctl_interleaved = 0;
@@ -532,6 +762,14 @@ phys_size_t fsl_ddr_sdram(void)
 		}
 	}
 
+#ifdef CONFIG_FSL_DDR_CACHE
+#ifdef CONFIG_FSL_DDR_INTERACTIVE
+	if (!getenv("ddr_interactive"))
+#endif
+		fsl_ddr_cache_save(&info, cache_key, total_memory,
+				   memctl_interleaved);
+program:
+#endif
 	/* Program configuration registers. */
 	for (i = 0; i < CONFIG_NUM_DDR_CONTROLLERS; i++) {
 		debug("Programming controller %u\n", i);
@@ -544,6 +782,10 @@ phys_size_t fsl_ddr_sdram(void)
 		fsl_ddr_set_memctl_regs(&(info.fsl_ddr_config_reg[i]), i);
 	}
 
+	for (i = 0; i < CONFIG_NUM_DDR_CONTROLLERS; i++)
+		if (info.common_timing_params[i].ndimms_present)
+			fsl_ddr_wait_init(i);
+
 	if (memctl_interleaved) {
 		const unsigned int ctrl_num = 0;
 
@@ -421,9 +421,9 @@ static unsigned char spd_read(uchar chip, uint addr)
 {
 	unsigned char data[2];
 
-	if (i2c_probe(chip) == 0)
-		if (i2c_read(chip, addr, 1, data, 1) == 0)
-			return data[0];
+	/* an empty slot fails the read as well, no need to probe first */
+	if (i2c_read(chip, addr, 1, data, 1) == 0)
+		return data[0];
 
 	return 0;
 }
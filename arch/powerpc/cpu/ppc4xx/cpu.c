@@ -701,6 +701,8 @@ int ppc440spe_revB() {
 
 int do_reset (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
+
 #if defined(CONFIG_BOARD_RESET)
 	board_reset();
 #else
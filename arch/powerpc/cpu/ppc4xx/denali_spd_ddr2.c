@@ -218,7 +218,7 @@ static unsigned char spd_read(u8 chip, unsigned int addr)
 {
 	u8 data[2];
 
-	if (0 != i2c_probe(chip) || 0 != i2c_read(chip, addr, 1, data, 1)) {
+	if (0 != i2c_read(chip, addr, 1, data, 1)) {
 		debug("spd_read(0x%02X, 0x%02X) failed\n", chip, addr);
 		return 0;
 	}
@@ -1065,6 +1065,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	show_boot_progress(-30);
 	for (;;)
 		;
@@ -39,6 +39,7 @@
 #include <fdt.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdt_stage.h>
 
 #endif
 
@@ -69,7 +70,8 @@ static void boot_jump_linux(bootm_headers_t *images)
 	debug ("## Transferring control to Linux (at address %08lx) ...\n",
 		(ulong)kernel);
 
-	show_boot_progress (15);
+	bootstage_mark(15);
+	serial_flush();
 
 #if defined(CONFIG_SYS_INIT_RAM_LOCK) && !defined(CONFIG_E500)
 	unlock_ram_in_cache();
@@ -288,16 +290,26 @@ static int boot_body_linux(bootm_headers_t *images)
 	 * if the user wants it (the logic is in the subroutines).
 	 */
 	if (of_size) {
+		/* write the fixups below out in one go */
+		fdt_stage_begin(*of_flat_tree);
+
 		if (fdt_chosen(*of_flat_tree, 1) < 0) {
 			puts ("ERROR: ");
 			puts ("/chosen node create failed");
 			puts (" - must RESET the board to recover.\n");
+			fdt_stage_commit(*of_flat_tree);
 			return -1;
 		}
 #ifdef CONFIG_OF_BOARD_SETUP
 		/* Call the board-specific fixup routine */
 		ft_board_setup(*of_flat_tree, gd->bd);
 #endif
+		ret = fdt_stage_commit(*of_flat_tree);
+		if (ret)
+			return ret;
+
+		if (bootstage_fdt_add_report(*of_flat_tree))
+			puts("WARNING: could not add boot stages to the FDT\n");
 
 		/* Delete the old LMB reservation */
 		lmb_free(lmb, (phys_addr_t)(u32)*of_flat_tree,
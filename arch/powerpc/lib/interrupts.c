@@ -27,6 +27,7 @@
 #include <common.h>
 #include <asm/processor.h>
 #include <watchdog.h>
+#include <prof.h>
 #ifdef CONFIG_STATUS_LED
 #include <status_led.h>
 #endif
@@ -118,6 +119,8 @@ void timer_interrupt (struct pt_regs *regs)
 	/* call cpu specific function from $(CPU)/interrupts.c */
 	timer_interrupt_cpu (regs);
 
+	prof_sample(regs->nip);
+
 	/* Restore Decrementer Count */
 	set_dec (decrementer_count);
 
@@ -54,7 +54,7 @@ int cleanup_before_linux(void)
 
 void *map_physmem(phys_addr_t paddr, unsigned long len, unsigned long flags)
 {
-	return (void *)(gd->ram_buf + paddr);
+	return (void *)(gd->ram_buf + paddr - CONFIG_SYS_SDRAM_BASE);
 }
 
 void flush_dcache_range(unsigned long start, unsigned long stop)
@@ -19,8 +19,11 @@
  * MA 02111-1307 USA
  */
 
+#define _GNU_SOURCE		/* REG_RIP */
 #include <fcntl.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <termios.h>
 #include <unistd.h>
 #include <time.h>
@@ -28,6 +31,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
 #include <linux/types.h>
 
 #include <os.h>
@@ -44,9 +52,42 @@ ssize_t os_write(int fd, const void *buf, size_t count)
 	return write(fd, buf, count);
 }
 
-int os_open(const char *pathname, int flags)
+off_t os_lseek(int fd, off_t offset, int whence)
 {
-	return open(pathname, flags);
+	if (whence == OS_SEEK_SET)
+		whence = SEEK_SET;
+	else if (whence == OS_SEEK_CUR)
+		whence = SEEK_CUR;
+	else if (whence == OS_SEEK_END)
+		whence = SEEK_END;
+	else
+		return -1;
+	return lseek(fd, offset, whence);
+}
+
+int os_open(const char *pathname, int os_flags)
+{
+	int flags;
+
+	switch (os_flags & OS_O_MASK) {
+	case OS_O_RDONLY:
+	default:
+		flags = O_RDONLY;
+		break;
+
+	case OS_O_WRONLY:
+		flags = O_WRONLY;
+		break;
+
+	case OS_O_RDWR:
+		flags = O_RDWR;
+		break;
+	}
+
+	if (os_flags & OS_O_CREAT)
+		flags |= O_CREAT;
+
+	return open(pathname, flags, 0777);
 }
 
 int os_close(int fd)
@@ -98,6 +139,21 @@ void *os_malloc(size_t length)
 			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 }
 
+void *os_malloc_at(unsigned long addr, size_t length)
+{
+	void *p = mmap((void *)addr, length, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	/* only a hint to mmap(): anything already there is kept */
+	if (p == MAP_FAILED)
+		return NULL;
+	if (p != (void *)addr) {
+		munmap(p, length);
+		return NULL;
+	}
+	return p;
+}
+
 void os_usleep(unsigned long usec)
 {
 	usleep(usec);
@@ -121,3 +177,57 @@ u64 os_get_nsec(void)
 	return tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000;
 #endif
 }
+
+int os_tap_open(const char *ifname)
+{
+	struct ifreq ifr;
+	int fd;
+
+	fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+	if (fd < 0)
+		return -1;
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+	if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void (*os_prof_handler)(unsigned long pc);
+
+static void os_prof_signal(int sig, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+	unsigned long pc = 0;
+
+#if defined(__x86_64__)
+	pc = uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+	pc = uc->uc_mcontext.gregs[REG_EIP];
+#endif
+	if (os_prof_handler)
+		os_prof_handler(pc);
+}
+
+int os_prof_timer(unsigned int hz, void (*handler)(unsigned long pc))
+{
+	struct itimerval it;
+	struct sigaction sa;
+
+	memset(&it, 0, sizeof(it));
+	if (hz) {
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = os_prof_signal;
+		sa.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(SIGPROF, &sa, NULL))
+			return -1;
+		os_prof_handler = handler;
+		it.it_interval.tv_usec = 1000000 / hz;
+		it.it_value = it.it_interval;
+	}
+	return setitimer(ITIMER_PROF, &it, NULL) ? -1 : 0;
+}
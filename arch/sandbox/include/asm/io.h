@@ -39,3 +39,11 @@ static inline void unmap_physmem(void *vaddr, unsigned long flags)
 {
 
 }
+
+/* There is no I/O space, registers are memory in the host's order */
+#define readb(addr)		(*(volatile u8 *)(addr))
+#define readw(addr)		(*(volatile u16 *)(addr))
+#define readl(addr)		(*(volatile u32 *)(addr))
+#define writeb(val, addr)	(*(volatile u8 *)(addr) = (val))
+#define writew(val, addr)	(*(volatile u16 *)(addr) = (val))
+#define writel(val, addr)	(*(volatile u32 *)(addr) = (val))
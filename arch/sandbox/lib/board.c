@@ -116,7 +116,7 @@ typedef int (init_fnc_t) (void);
 
 void __dram_init_banksize(void)
 {
-	gd->bd->bi_dram[0].start = 0;
+	gd->bd->bi_dram[0].start = CONFIG_SYS_SDRAM_BASE;
 	gd->bd->bi_dram[0].size =  gd->ram_size;
 }
 
@@ -161,8 +161,14 @@ void board_init_f(ulong bootflag)
 			hang();
 	}
 
+	/*
+	 * Where the addresses of the emulated RAM can be used as they are,
+	 * commands like md and tftpboot work on it without map_physmem().
+	 */
 	size = CONFIG_SYS_SDRAM_SIZE;
-	mem = os_malloc(CONFIG_SYS_SDRAM_SIZE);
+	mem = os_malloc_at(CONFIG_SYS_SDRAM_BASE, CONFIG_SYS_SDRAM_SIZE);
+	if (!mem)
+		mem = os_malloc(CONFIG_SYS_SDRAM_SIZE);
 
 	assert(mem);
 	gd->ram_buf = mem;
@@ -257,6 +263,11 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	board_late_init();
 #endif
 
+#if defined(CONFIG_CMD_NET)
+	puts("Net:   ");
+	eth_initialize(gd->bd);
+#endif
+
 #ifdef CONFIG_POST
 	post_run(NULL, POST_RAM | post_bootmode_get(0));
 #endif
@@ -274,6 +285,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	for (;;)
 		;
 }
@@ -23,12 +23,25 @@
  */
 
 #include <common.h>
+#include <os.h>
+#include <prof.h>
 
 int interrupt_init(void)
 {
+#ifdef CONFIG_PROF_BOOT
+	prof_timer_enable(1);
+#endif
 	return 0;
 }
 
+#ifdef CONFIG_CMD_PROF
+/* SIGPROF stands in for the timer interrupt */
+void prof_timer_enable(int on)
+{
+	os_prof_timer(on ? CONFIG_SYS_HZ : 0, prof_sample);
+}
+#endif
+
 void enable_interrupts(void)
 {
 	return;
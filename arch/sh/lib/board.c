@@ -222,6 +222,7 @@ void sh_generic_init(void)
 void hang(void)
 {
 	puts("Board ERROR\n");
+	serial_flush();
 	for (;;)
 		;
 }
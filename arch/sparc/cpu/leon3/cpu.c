@@ -54,6 +54,7 @@ void cpu_reset(void)
 
 int do_reset(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
 	cpu_reset();
 
 	return 1;
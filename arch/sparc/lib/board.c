@@ -425,6 +425,7 @@ void board_init_f(ulong bootflag)
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 #ifdef CONFIG_SHOW_BOOT_PROGRESS
 	show_boot_progress(-30);
 #endif
@@ -124,6 +124,7 @@ int cpu_init_r(void) __attribute__((weak, alias("x86_cpu_init_r")));
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	printf("resetting ...\n");
+	serial_flush();
 
 	/* wait 50 ms */
 	udelay(50000);
@@ -280,7 +280,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	static gd_t gd_data;
 	init_fnc_t **init_fnc_ptr;
 
-	show_boot_progress(0x21);
+	bootstage_mark(0x21);
 
 	/* Global data pointer is now writable */
 	gd = &gd_data;
@@ -291,7 +291,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 
 	gd->bd = &bd_data;
 	memset(gd->bd, 0, sizeof(bd_t));
-	show_boot_progress(0x22);
+	bootstage_mark(0x22);
 
 	gd->baudrate =  CONFIG_BAUDRATE;
 
@@ -302,7 +302,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 		if ((*init_fnc_ptr)() != 0)
 			hang();
 	}
-	show_boot_progress(0x23);
+	bootstage_mark(0x23);
 
 #ifdef CONFIG_SERIAL_MULTI
 	serial_initialize();
@@ -312,14 +312,14 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	/* configure available FLASH banks */
 	size = flash_init();
 	display_flash_config(size);
-	show_boot_progress(0x24);
+	bootstage_mark(0x24);
 #endif
 
-	show_boot_progress(0x25);
+	bootstage_mark(0x25);
 
 	/* initialize environment */
 	env_relocate();
-	show_boot_progress(0x26);
+	bootstage_mark(0x26);
 
 
 #ifdef CONFIG_CMD_NET
@@ -334,7 +334,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	pci_init();
 #endif
 
-	show_boot_progress(0x27);
+	bootstage_mark(0x27);
 
 
 	stdio_init();
@@ -363,7 +363,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 
 	/* enable exceptions */
 	enable_interrupts();
-	show_boot_progress(0x28);
+	bootstage_mark(0x28);
 
 #ifdef CONFIG_STATUS_LED
 	status_led_set(STATUS_LED_BOOT, STATUS_LED_BLINKING);
@@ -432,7 +432,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 	post_run(NULL, POST_RAM | post_bootmode_get(0));
 #endif
 
-	show_boot_progress(0x29);
+	bootstage_mark(0x29);
 
 	/* main_loop() can return to retry autoboot, if so just run it again. */
 	for (;;)
@@ -444,6 +444,7 @@ void board_init_r(gd_t *id, ulong dest_addr)
 void hang(void)
 {
 	puts("### ERROR ### Please RESET the board ###\n");
+	serial_flush();
 	for (;;)
 		;
 }
@@ -117,7 +117,7 @@ int altera_done_fn(int cookie)
  * writing the complete buffer in one function is much faster,
  * then calling it for every bit
  */
-int altera_write_fn(void *buf, size_t len, int flush, int cookie)
+int altera_write_fn(const void *buf, size_t len, int flush, int cookie)
 {
 	size_t bytecount = 0;
 	gpio_t *gpiop = (gpio_t *)MMAP_GPIO;
@@ -140,7 +140,7 @@ int altera_write_fn(void *buf, size_t len, int flush, int cookie)
 			i--;
 		} while (i > 0);
 
-		if (bytecount % len_40 == 0) {
+		if (len_40 == 0 || bytecount % len_40 == 0) {
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
 			WATCHDOG_RESET();
 #endif
@@ -339,7 +339,7 @@ int xilinx_wr_fn(int assert_write, int flush, int cookie)
 	return assert_write;
 }
 
-int xilinx_fastwr_fn(void *buf, size_t len, int flush, int cookie)
+int xilinx_fastwr_fn(const void *buf, size_t len, int flush, int cookie)
 {
 	size_t bytecount = 0;
 	gpio_t *gpiop = (gpio_t *)MMAP_GPIO;
@@ -359,7 +359,7 @@ int xilinx_fastwr_fn(void *buf, size_t len, int flush, int cookie)
 			writeb(0x04, &gpiop->ppd_qspi);
 			val <<= 1;
 		}
-		if (bytecount % len_40 == 0) {
+		if (len_40 == 0 || bytecount % len_40 == 0) {
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
 			WATCHDOG_RESET();
 #endif
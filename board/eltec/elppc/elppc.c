@@ -119,6 +119,7 @@ phys_size_t initdram (int board_type)
  */
 int do_reset (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
 	out8 (MPC107_EUMB_PI, 1);
 	return (0);
 }
@@ -64,7 +64,9 @@ phys_size_t fixed_sdram(void)
 		sizeof(ddr_cfg_regs));
 	ddr_cfg_regs.ddr_cdr1 = DDR_CDR1_DHC_EN;
 	fsl_ddr_set_memctl_regs(&ddr_cfg_regs, 1);
+	fsl_ddr_wait_init(1);
 #endif
+	fsl_ddr_wait_init(0);
 
 	/*
 	 * setup laws for DDR. If not interleaving, presuming half memory on
@@ -239,6 +239,7 @@ phys_size_t fixed_sdram (void)
 	}
 
 	fsl_ddr_set_memctl_regs(&ddr_cfg_regs, 0);
+	fsl_ddr_wait_init(0);
 
 	set_ddr_laws(0, ddr_size, LAW_TRGT_IF_DDR_1);
 	return ddr_size;
@@ -52,6 +52,7 @@ phys_size_t fixed_sdram(void)
 	ddr_size = (phys_size_t) CONFIG_SYS_SDRAM_SIZE * 1024 * 1024;
 	ddr_cfg_regs.ddr_cdr1 = DDR_CDR1_DHC_EN;
 	fsl_ddr_set_memctl_regs(&ddr_cfg_regs, 0);
+	fsl_ddr_wait_init(0);
 
 	/*
 	 * setup laws for DDR. If not interleaving, presuming half memory on
@@ -71,6 +71,7 @@ phys_size_t initdram (int board_type)
 
 int do_reset (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
 	out32 (REG (CPC0, SPOR), 0);
 	iobarrier_rw ();
 	while (1);
@@ -91,6 +91,7 @@ int misc_init_r( void )
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	printf( "Resetting...\n" );
+	serial_flush();
 
 	/* Disabe and invalidate cache */
 	icache_disable();
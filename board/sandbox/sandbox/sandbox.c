@@ -21,6 +21,7 @@
 
 #include <common.h>
 
+#include <netdev.h>
 #include <os.h>
 
 /*
@@ -39,6 +40,17 @@ ulong get_timer(ulong base)
 	return (os_get_nsec() / 1000000) - base;
 }
 
+/* nanoseconds of the host clock */
+unsigned long long get_ticks(void)
+{
+	return os_get_nsec();
+}
+
+ulong get_tbclk(void)
+{
+	return 1000000000;
+}
+
 int timer_init(void)
 {
 	return 0;
@@ -49,3 +61,10 @@ int dram_init(void)
 	gd->ram_size = CONFIG_DRAM_SIZE;
 	return 0;
 }
+
+#ifdef CONFIG_SANDBOX_ETH
+int board_eth_init(bd_t *bis)
+{
+	return sandbox_eth_initialize(bis);
+}
+#endif
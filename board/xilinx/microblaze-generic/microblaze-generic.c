@@ -33,12 +33,15 @@
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+	serial_flush();
+
 #ifdef CONFIG_SYS_GPIO_0
 	*((unsigned long *)(CONFIG_SYS_GPIO_0_ADDR)) =
 	    ++(*((unsigned long *)(CONFIG_SYS_GPIO_0_ADDR)));
 #endif
 #ifdef CONFIG_SYS_RESET_ADDRESS
 	puts ("Reseting board\n");
+	serial_flush();
 	asm ("bra r0");
 #endif
 	return 0;
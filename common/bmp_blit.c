@@ -0,0 +1,141 @@
+/*
+ * Copying bitmap rows to the frame buffer
+ *
+ * The BMP display code of lcd.c and cfb_console.c copies the rows of a
+ * bitmap that is already in the format of the frame buffer through
+ * bmp_blit().  A board with a 2D engine can do it there instead; by
+ * default every row goes through dma_memcpy(), which leaves the rows
+ * too short for the DMA engine to memcpy().
+ *
+ * With CONFIG_VIDEO_BMP_GZIP, bmp_display_gz() shows a gzipped bitmap
+ * without unpacking all of it: the rows are gunzipped a band at a time
+ * into a small buffer behind a copy of the header, and every band is
+ * handed to the display code as a bitmap of its own.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <watchdog.h>
+#include <dma.h>
+#include <malloc.h>
+#include <bmp_layout.h>
+
+void __bmp_blit(void *dst, long dst_pitch, const void *src, long src_pitch,
+		ulong len, uint rows)
+{
+	uchar *d = dst;
+	const uchar *s = src;
+
+	while (rows--) {
+		WATCHDOG_RESET();
+		if (dma_memcpy(d, s, len))
+			memcpy(d, s, len);
+		d += dst_pitch;
+		s += src_pitch;
+	}
+}
+void bmp_blit(void *dst, long dst_pitch, const void *src, long src_pitch,
+	      ulong len, uint rows)
+	__attribute__((weak, alias("__bmp_blit")));
+
+#ifdef CONFIG_VIDEO_BMP_GZIP
+#ifndef CONFIG_SYS_VIDEO_BMP_BAND_SIZE
+#define CONFIG_SYS_VIDEO_BMP_BAND_SIZE	(64 << 10)
+#endif
+
+int bmp_display_gz(ulong addr, int x, int y, int cols, int rows,
+		   int (*display)(ulong addr, int x, int y))
+{
+	bmp_image_t head, *bmp;
+	ulong offset, pitch, width, height, bpp;
+	ulong row, band, n;
+	uchar *buf;
+	int ret = 0;
+
+	if (gunzip_read_start((void *)addr, CONFIG_SYS_VIDEO_LOGO_MAX_SIZE))
+		return -1;
+
+	if (gunzip_read(&head, sizeof(head)) != sizeof(head))
+		head.header.signature[0] = 0;
+	offset = le32_to_cpu(head.header.data_offset);
+	if (head.header.signature[0] != 'B' ||
+	    head.header.signature[1] != 'M' || offset < sizeof(head) ||
+	    le32_to_cpu(head.header.compression) != BMP_BI_RGB) {
+		gunzip_read_end();
+		return -1;
+	}
+
+	width = le32_to_cpu(head.header.width);
+	height = le32_to_cpu(head.header.height);
+	bpp = le16_to_cpu(head.header.bit_count);
+	pitch = (((width * bpp + 7) / 8) + 3) & ~0x3;
+	if (!pitch || !height) {
+		gunzip_read_end();
+		return -1;
+	}
+
+	band = 1;
+	if (offset + pitch < CONFIG_SYS_VIDEO_BMP_BAND_SIZE)
+		band = (CONFIG_SYS_VIDEO_BMP_BAND_SIZE - offset) / pitch;
+	band = min(band, height);
+	buf = malloc(offset + band * pitch);
+	if (!buf) {
+		gunzip_read_end();
+		puts("Error: malloc in gunzip failed!\n");
+		return 1;
+	}
+
+	/* the header with the colour table */
+	bmp = (bmp_image_t *)buf;
+	memcpy(bmp, &head, sizeof(head));
+	if (gunzip_read(buf + sizeof(head), offset - sizeof(head)) !=
+	    offset - sizeof(head)) {
+		puts("Error: no valid bmp.gz image\n");
+		ret = 1;
+		goto out;
+	}
+
+#ifdef CONFIG_SPLASH_SCREEN_ALIGN
+	if (x == BMP_ALIGN_CENTER)
+		x = max(0, (int)(cols - width) / 2);
+	else if (x < 0)
+		x = max(0, (int)(cols - width) + x + 1);
+
+	if (y == BMP_ALIGN_CENTER)
+		y = max(0, (int)(rows - height) / 2);
+	else if (y < 0)
+		y = max(0, (int)(rows - height) + y + 1);
+#endif /* CONFIG_SPLASH_SCREEN_ALIGN */
+
+	if (x < 0 || y < 0 || x >= cols || y >= rows)
+		goto out;
+
+	/* the rows that fit, from the bottom one on, as lcd.c draws them */
+	if (y + height > rows)
+		height = rows - y;
+
+	for (row = 0; row < height; row += n) {
+		n = min(band, height - row);
+		if (gunzip_read(buf + offset, n * pitch) != n * pitch) {
+			printf("Error: bmp.gz image at %lx is cut short\n",
+			       addr);
+			ret = 1;
+			break;
+		}
+		/* the band goes where its top row is */
+		bmp->header.height = cpu_to_le32(n);
+		ret = display((ulong)bmp, x, y + height - row - n);
+		if (ret)
+			break;
+	}
+
+out:
+	free(buf);
+	gunzip_read_end();
+	return ret;
+}
+#endif /* CONFIG_VIDEO_BMP_GZIP */
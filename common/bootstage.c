@@ -0,0 +1,148 @@
+/*
+ * Boot stage timing: every bootstage_mark() records when it was
+ * reached, so that the time spent between stages can be reported here
+ * or by the kernel.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#ifdef CONFIG_OF_LIBFDT
+#include <libfdt.h>
+#endif
+
+struct bootstage_record {
+	ulong time_us;
+	const char *name;
+	int id;
+};
+
+static struct bootstage_record record[CONFIG_BOOTSTAGE_RECORDS];
+static int rec_count;		/* stages recorded */
+static int rec_lost;		/* stages that did not fit */
+
+ulong __timer_get_boot_us(void)
+{
+	static ulong base_time;
+	static int started;
+
+	if (!started) {
+		base_time = get_timer(0);
+		started = 1;
+	}
+	return lldiv((u64)get_timer(base_time) * 1000000, CONFIG_SYS_HZ);
+}
+ulong timer_get_boot_us(void)
+	__attribute__((weak, alias("__timer_get_boot_us")));
+
+ulong bootstage_mark_name(int id, const char *name)
+{
+	ulong now = timer_get_boot_us();
+
+	if (rec_count < CONFIG_BOOTSTAGE_RECORDS) {
+		struct bootstage_record *rec = &record[rec_count++];
+
+		rec->time_us = now;
+		rec->name = name;
+		rec->id = id;
+	} else {
+		rec_lost++;
+	}
+
+	show_boot_progress(id);
+	return now;
+}
+
+void bootstage_report(void)
+{
+	ulong prev = 0;
+	int i;
+
+	puts("Timer summary in microseconds:\n");
+	printf("%11s%11s  %s\n", "Mark", "Elapsed", "Stage");
+	printf("%11u%11u  %s\n", 0, 0, "reset");
+	for (i = 0; i < rec_count; i++) {
+		struct bootstage_record *rec = &record[i];
+
+		printf("%11lu%11lu  %s (%d)%s\n", rec->time_us,
+		       rec->time_us - prev, rec->name, rec->id,
+		       rec->id < 0 ? " error" : "");
+		prev = rec->time_us;
+	}
+	if (rec_lost)
+		printf("%d stages not recorded, raise "
+		       "CONFIG_BOOTSTAGE_RECORDS\n", rec_lost);
+}
+
+#ifdef CONFIG_OF_LIBFDT
+/*
+ * The records go into a /bootstage node with one subnode per stage,
+ * numbered in the order they were reached:
+ *
+ *	bootstage {
+ *		0 {
+ *			name = "bootm_start";
+ *			id = <1>;
+ *			mark = <123456>;	(microseconds)
+ *		};
+ *		...
+ *	};
+ */
+int bootstage_fdt_add_report(void *blob)
+{
+	char name[12];
+	int parent, node, i, err;
+
+	parent = fdt_path_offset(blob, "/bootstage");
+	if (parent < 0) {
+		parent = fdt_add_subnode(blob, 0, "bootstage");
+		if (parent < 0)
+			return parent;
+	}
+
+	for (i = 0; i < rec_count; i++) {
+		struct bootstage_record *rec = &record[i];
+
+		sprintf(name, "%d", i);
+		node = fdt_add_subnode(blob, parent, name);
+		if (node < 0)
+			return node;
+		err = fdt_setprop_string(blob, node, "name", rec->name);
+		if (!err)
+			err = fdt_setprop_cell(blob, node, "id", rec->id);
+		if (!err)
+			err = fdt_setprop_cell(blob, node, "mark",
+					       rec->time_us);
+		if (err)
+			return err;
+	}
+	return 0;
+}
+#else
+int bootstage_fdt_add_report(void *blob)
+{
+	return 0;
+}
+#endif /* CONFIG_OF_LIBFDT */
+
+#ifdef CONFIG_CMD_BOOTSTAGE
+static int do_bootstage(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	if (argc != 2 || strcmp(argv[1], "report"))
+		return cmd_usage(cmdtp);
+
+	bootstage_report();
+	return 0;
+}
+
+U_BOOT_CMD(bootstage, 2, 1, do_bootstage,
+	"boot stage timing",
+	"report - print the time at which each boot stage was reached"
+);
+#endif /* CONFIG_CMD_BOOTSTAGE */
@@ -0,0 +1,411 @@
+/*
+ * Time the core algorithms, to see what a change or an optimization
+ * for one architecture is worth
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Every test runs over the same inputs on all boards and in sandbox:
+ * the checksums and memory functions over CONFIG_SYS_BENCH_LEN bytes of
+ * pseudo-random data, hsearch_r() and libfdt over tables they build
+ * themselves.  There are no compressors in U-Boot, so the decompressors
+ * are timed on an image the user has loaded.  A test is repeated until
+ * it has run for CONFIG_SYS_BENCH_MS; the result is reported per second.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <div64.h>
+#include <asm/io.h>
+#include <search.h>
+#include <u-boot/crc.h>
+#ifdef CONFIG_SHA1
+#include <sha1.h>
+#endif
+#ifdef CONFIG_SHA256
+#include <sha256.h>
+#endif
+#ifdef CONFIG_MD5
+#include <u-boot/md5.h>
+#endif
+#ifdef CONFIG_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef CONFIG_LZMA
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+#include <lzma/LzmaTools.h>
+#endif
+#ifdef CONFIG_LZO
+#include <linux/lzo.h>
+#endif
+#ifdef CONFIG_LZ4
+#include <lz4.h>
+#endif
+#if defined(CONFIG_OF_LIBFDT) || defined(CONFIG_FIT)
+#include <libfdt.h>
+#endif
+
+#ifndef CONFIG_SYS_BENCH_LEN
+#define CONFIG_SYS_BENCH_LEN	(1 << 20)
+#endif
+#ifndef CONFIG_SYS_BENCH_MS
+#define CONFIG_SYS_BENCH_MS	1000
+#endif
+#ifndef CONFIG_SYS_BENCH_UNC_LEN
+#define CONFIG_SYS_BENCH_UNC_LEN	(8 << 20)
+#endif
+
+#define BENCH_HASH_KEYS		512
+#define BENCH_FDT_NODES		64
+#define BENCH_FDT_SIZE		(16 << 10)
+
+struct bench_ctx {
+	uchar	*src;		/* CONFIG_SYS_BENCH_LEN each */
+	uchar	*dst;
+	uchar	*in;		/* an image for the decompressors */
+	ulong	in_len;
+	uchar	*out;
+	struct hsearch_data htab;
+	void	*fdt;
+};
+
+struct bench {
+	const char *name;
+	const char *unit;	/* "MB" for bytes, else what is counted */
+	/* one round; returns the bytes or operations done, < 0 on error */
+	long (*run)(struct bench_ctx *ctx);
+	int need_image;
+};
+
+/*-------------------------------------------------------------------------*/
+
+static long bench_crc32(struct bench_ctx *ctx)
+{
+	crc32(0, ctx->src, CONFIG_SYS_BENCH_LEN);
+	return CONFIG_SYS_BENCH_LEN;
+}
+
+#ifdef CONFIG_SHA1
+static long bench_sha1(struct bench_ctx *ctx)
+{
+	sha1_csum(ctx->src, CONFIG_SYS_BENCH_LEN, ctx->dst);
+	return CONFIG_SYS_BENCH_LEN;
+}
+#endif
+
+#ifdef CONFIG_SHA256
+static long bench_sha256(struct bench_ctx *ctx)
+{
+	sha256_context c;
+
+	sha256_starts(&c);
+	sha256_update(&c, ctx->src, CONFIG_SYS_BENCH_LEN);
+	sha256_finish(&c, ctx->dst);
+	return CONFIG_SYS_BENCH_LEN;
+}
+#endif
+
+#ifdef CONFIG_MD5
+static long bench_md5(struct bench_ctx *ctx)
+{
+	md5(ctx->src, CONFIG_SYS_BENCH_LEN, ctx->dst);
+	return CONFIG_SYS_BENCH_LEN;
+}
+#endif
+
+static long bench_memcpy(struct bench_ctx *ctx)
+{
+	memcpy(ctx->dst, ctx->src, CONFIG_SYS_BENCH_LEN);
+	return CONFIG_SYS_BENCH_LEN;
+}
+
+static long bench_memset(struct bench_ctx *ctx)
+{
+	memset(ctx->dst, 0x5a, CONFIG_SYS_BENCH_LEN);
+	return CONFIG_SYS_BENCH_LEN;
+}
+
+static long bench_hsearch(struct bench_ctx *ctx)
+{
+	char key[16];
+	ENTRY e, *ep;
+	int i;
+
+	e.data = NULL;
+	for (i = 0; i < BENCH_HASH_KEYS; i++) {
+		/* an environment sized table, looked up the way getenv does */
+		sprintf(key, "var%d", (i * 37) % BENCH_HASH_KEYS);
+		e.key = key;
+		if (!hsearch_r(e, FIND, &ep, &ctx->htab))
+			return -1;
+	}
+	return BENCH_HASH_KEYS;
+}
+
+#if defined(CONFIG_OF_LIBFDT) || defined(CONFIG_FIT)
+static long bench_fdt(struct bench_ctx *ctx)
+{
+	char path[32];
+	int i, node, len;
+
+	for (i = 0; i < BENCH_FDT_NODES; i++) {
+		sprintf(path, "/soc/dev@%x", (i * 37) % BENCH_FDT_NODES);
+		node = fdt_path_offset(ctx->fdt, path);
+		if (node < 0 || !fdt_getprop(ctx->fdt, node, "reg", &len))
+			return -1;
+	}
+	return BENCH_FDT_NODES;
+}
+#endif
+
+#ifdef CONFIG_GZIP
+static long bench_gunzip(struct bench_ctx *ctx)
+{
+	unsigned long len = ctx->in_len;
+
+	if (gunzip(ctx->out, CONFIG_SYS_BENCH_UNC_LEN, ctx->in, &len))
+		return -1;
+	return len;
+}
+#endif
+
+#ifdef CONFIG_BZIP2
+static long bench_bzip2(struct bench_ctx *ctx)
+{
+	unsigned int len = CONFIG_SYS_BENCH_UNC_LEN;
+
+	if (bunzip2((char *)ctx->out, &len, (char *)ctx->in,
+		    ctx->in_len) != BZ_OK)
+		return -1;
+	return len;
+}
+#endif
+
+#ifdef CONFIG_LZMA
+static long bench_lzma(struct bench_ctx *ctx)
+{
+	SizeT len = CONFIG_SYS_BENCH_UNC_LEN;
+
+	if (lzmaBuffToBuffDecompress(ctx->out, &len, ctx->in,
+				     ctx->in_len) != SZ_OK)
+		return -1;
+	return len;
+}
+#endif
+
+#ifdef CONFIG_LZO
+static long bench_lzo(struct bench_ctx *ctx)
+{
+	size_t len = CONFIG_SYS_BENCH_UNC_LEN;
+
+	if (lzop_decompress(ctx->in, ctx->in_len, ctx->out,
+			    &len) != LZO_E_OK)
+		return -1;
+	return len;
+}
+#endif
+
+#ifdef CONFIG_LZ4
+static long bench_lz4(struct bench_ctx *ctx)
+{
+	size_t len = CONFIG_SYS_BENCH_UNC_LEN;
+
+	if (lz4_decompress(ctx->in, ctx->in_len, ctx->out,
+			   &len) != LZ4_E_OK)
+		return -1;
+	return len;
+}
+#endif
+
+static const struct bench benches[] = {
+	{ "crc32",	"MB",	bench_crc32 },
+#ifdef CONFIG_SHA1
+	{ "sha1",	"MB",	bench_sha1 },
+#endif
+#ifdef CONFIG_SHA256
+	{ "sha256",	"MB",	bench_sha256 },
+#endif
+#ifdef CONFIG_MD5
+	{ "md5",	"MB",	bench_md5 },
+#endif
+	{ "memcpy",	"MB",	bench_memcpy },
+	{ "memset",	"MB",	bench_memset },
+	{ "hsearch",	"lookups", bench_hsearch },
+#if defined(CONFIG_OF_LIBFDT) || defined(CONFIG_FIT)
+	{ "fdt",	"lookups", bench_fdt },
+#endif
+#ifdef CONFIG_GZIP
+	{ "gunzip",	"MB",	bench_gunzip, 1 },
+#endif
+#ifdef CONFIG_BZIP2
+	{ "bzip2",	"MB",	bench_bzip2, 1 },
+#endif
+#ifdef CONFIG_LZMA
+	{ "lzma",	"MB",	bench_lzma, 1 },
+#endif
+#ifdef CONFIG_LZO
+	{ "lzo",	"MB",	bench_lzo, 1 },
+#endif
+#ifdef CONFIG_LZ4
+	{ "lz4",	"MB",	bench_lz4, 1 },
+#endif
+};
+
+/*-------------------------------------------------------------------------*/
+
+static int bench_setup(struct bench_ctx *ctx)
+{
+	char key[16];
+	ENTRY e, *ep;
+	u32 seed = 1;
+	int i;
+
+	ctx->src = malloc(CONFIG_SYS_BENCH_LEN);
+	ctx->dst = malloc(CONFIG_SYS_BENCH_LEN);
+	if (!ctx->src || !ctx->dst)
+		return -1;
+	/* the same data everywhere */
+	for (i = 0; i < CONFIG_SYS_BENCH_LEN; i++) {
+		seed = seed * 1103515245 + 12345;
+		ctx->src[i] = seed >> 16;
+	}
+
+	if (!hcreate_r(BENCH_HASH_KEYS * 2, &ctx->htab))
+		return -1;
+	for (i = 0; i < BENCH_HASH_KEYS; i++) {
+		sprintf(key, "var%d", i);
+		e.key = key;
+		e.data = "0123456789abcdef";
+		if (!hsearch_r(e, ENTER, &ep, &ctx->htab))
+			return -1;
+	}
+
+#if defined(CONFIG_OF_LIBFDT) || defined(CONFIG_FIT)
+	ctx->fdt = malloc(BENCH_FDT_SIZE);
+	if (!ctx->fdt)
+		return -1;
+	fdt_create(ctx->fdt, BENCH_FDT_SIZE);
+	fdt_finish_reservemap(ctx->fdt);
+	fdt_begin_node(ctx->fdt, "");
+	fdt_begin_node(ctx->fdt, "soc");
+	for (i = 0; i < BENCH_FDT_NODES; i++) {
+		sprintf(key, "dev@%x", i);
+		fdt_begin_node(ctx->fdt, key);
+		fdt_property_string(ctx->fdt, "compatible", "bench,dev");
+		fdt_property_cell(ctx->fdt, "reg", i << 12);
+		fdt_property_cell(ctx->fdt, "interrupts", i);
+		fdt_end_node(ctx->fdt);
+	}
+	fdt_end_node(ctx->fdt);
+	fdt_end_node(ctx->fdt);
+	if (fdt_finish(ctx->fdt))
+		return -1;
+#endif
+	return 0;
+}
+
+static void bench_cleanup(struct bench_ctx *ctx)
+{
+	free(ctx->src);
+	free(ctx->dst);
+	hdestroy_r(&ctx->htab);
+	free(ctx->fdt);
+}
+
+static int bench_one(const struct bench *b, struct bench_ctx *ctx)
+{
+	ulong start, ms;
+	u64 done = 0;
+	long n;
+
+	if (b->need_image && !ctx->in_len) {
+		printf("%-8s: needs an image (bench %s addr len)\n",
+		       b->name, b->name);
+		return 0;
+	}
+
+	start = get_timer(0);
+	do {
+		WATCHDOG_RESET();
+		n = b->run(ctx);
+		if (n < 0) {
+			printf("%-8s: failed\n", b->name);
+			return -1;
+		}
+		done += n;
+		ms = get_timer(start);
+	} while (ms < CONFIG_SYS_BENCH_MS);
+
+	if (!strcmp(b->unit, "MB")) {
+		/* in decimal megabytes, two places */
+		n = lldiv(done, ms * 10);
+		printf("%-8s: %5ld.%02ld MB/s\n", b->name, n / 100, n % 100);
+	} else {
+		printf("%-8s: %8lu %s/s\n", b->name,
+		       (ulong)lldiv(done * 1000, ms), b->unit);
+	}
+	return 0;
+}
+
+int do_bench(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct bench_ctx ctx;
+	const char *name = argc > 1 ? argv[1] : "all";
+	ulong addr;
+	int i, found = 0, ret = 0;
+
+	memset(&ctx, 0, sizeof(ctx));
+	if (argc == 4) {
+		addr = simple_strtoul(argv[2], NULL, 16);
+		ctx.in_len = simple_strtoul(argv[3], NULL, 16);
+		ctx.in = map_physmem(addr, ctx.in_len, MAP_WRBACK);
+		/* uncompress right behind the image */
+		addr = (addr + ctx.in_len + 0xfff) & ~0xfffUL;
+		ctx.out = map_physmem(addr, CONFIG_SYS_BENCH_UNC_LEN,
+				      MAP_WRBACK);
+	} else if (argc != 1 && argc != 2) {
+		return cmd_usage(cmdtp);
+	}
+
+	if (bench_setup(&ctx)) {
+		puts("bench: out of memory\n");
+		bench_cleanup(&ctx);
+		return 1;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(benches); i++) {
+		if (strcmp(name, "all") && strcmp(name, benches[i].name))
+			continue;
+		found = 1;
+		if (!strcmp(name, "all") && benches[i].need_image)
+			continue;
+		if (bench_one(&benches[i], &ctx))
+			ret = 1;
+		if (ctrlc())
+			break;
+	}
+	bench_cleanup(&ctx);
+	if (ctx.in) {
+		unmap_physmem(ctx.in, ctx.in_len);
+		unmap_physmem(ctx.out, CONFIG_SYS_BENCH_UNC_LEN);
+	}
+
+	if (!found)
+		return cmd_usage(cmdtp);
+	return ret;
+}
+
+U_BOOT_CMD(
+	bench,	4,	0,	do_bench,
+	"time the core algorithms",
+	"[test]\n"
+	"    - run the test, or all that need no image: crc32, sha1,\n"
+	"      sha256, md5, memcpy, memset, hsearch, fdt\n"
+	"bench gunzip|bzip2|lzma|lzo|lz4 addr len\n"
+	"    - decompress the image at addr, len bytes, repeatedly"
+);
@@ -0,0 +1,49 @@
+/*
+ * Block cache statistics and configuration
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+#include <blkcache.h>
+
+static int do_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct block_cache_stats stats;
+
+	if (argc == 2 && strcmp(argv[1], "show") == 0) {
+		blkcache_stats(&stats);
+		printf("    hits: %u\n"
+		       "    misses: %u\n"
+		       "    entries: %u\n"
+		       "    max blocks/entry: %u\n"
+		       "    max cache entries: %u\n",
+		       stats.hits, stats.misses, stats.entries,
+		       stats.max_blocks_per_entry, stats.max_entries);
+		return 0;
+	}
+
+	if (argc == 4 && strcmp(argv[1], "configure") == 0) {
+		blkcache_configure(simple_strtoul(argv[2], NULL, 0),
+				   simple_strtoul(argv[3], NULL, 0));
+		return 0;
+	}
+
+	return cmd_usage(cmdtp);
+}
+
+U_BOOT_CMD(
+	blkcache,	4,	0,	do_blkcache,
+	"block cache diagnostics and control",
+	"show\n"
+	"    - show and reset the hit/miss statistics\n"
+	"blkcache configure blocks entries\n"
+	"    - cache reads of up to 'blocks' blocks in up to 'entries'\n"
+	"      entries, 0 entries disables the cache"
+);
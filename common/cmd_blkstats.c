@@ -0,0 +1,209 @@
+/*
+ * Block and MTD device I/O statistics
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Every command a driver sends to a device is counted, with the bytes
+ * it moved and the time it took, in a histogram of decades from 100us
+ * to 1s.  Reads served by the block cache never reach a device and
+ * are not counted.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <div64.h>
+#include <part.h>
+#include <blkstats.h>
+
+#ifndef CONFIG_SYS_BLKSTATS_DEVICES
+#define CONFIG_SYS_BLKSTATS_DEVICES	8
+#endif
+
+/* <100us, <1ms, <10ms, <100ms, <1s, longer */
+#define BLKSTATS_BUCKETS	6
+
+#define BLKSTATS_MTD		-1	/* iftype of MTD devices */
+
+struct blkstats_dir {
+	ulong cmds;
+	unsigned long long bytes;
+	unsigned long long cycles;
+	unsigned long long max;
+	ulong hist[BLKSTATS_BUCKETS];
+};
+
+struct blkstats_dev {
+	int iftype;
+	int dev;
+	const char *name;		/* MTD devices */
+	struct blkstats_dir dir[2];
+};
+
+static struct blkstats_dev blkstats[CONFIG_SYS_BLKSTATS_DEVICES];
+static int blkstats_used;
+
+/* bucket limits in timebase ticks, worked out on first use */
+static unsigned long long blkstats_limit[BLKSTATS_BUCKETS - 1];
+
+static struct blkstats_dev *blkstats_find(int iftype, int dev,
+					  const char *name)
+{
+	struct blkstats_dev *d;
+	int i;
+
+	for (i = 0; i < blkstats_used; i++) {
+		d = &blkstats[i];
+		if (d->iftype == iftype && d->dev == dev && d->name == name)
+			return d;
+	}
+	if (blkstats_used == CONFIG_SYS_BLKSTATS_DEVICES)
+		return NULL;
+
+	d = &blkstats[blkstats_used++];
+	memset(d, 0, sizeof(*d));
+	d->iftype = iftype;
+	d->dev = dev;
+	d->name = name;
+	return d;
+}
+
+static void blkstats_add(struct blkstats_dev *d, int dir, unsigned long bytes,
+			 unsigned long long start)
+{
+	unsigned long long cycles = get_ticks() - start;
+	struct blkstats_dir *s;
+	int i;
+
+	if (!d)
+		return;
+
+	if (!blkstats_limit[0]) {
+		unsigned long long limit = get_tbclk();
+
+		for (i = BLKSTATS_BUCKETS - 2; i >= 0; i--) {
+			blkstats_limit[i] = limit ? limit : 1;
+			do_div(limit, 10);
+		}
+	}
+
+	s = &d->dir[dir];
+	s->cmds++;
+	s->bytes += bytes;
+	s->cycles += cycles;
+	if (cycles > s->max)
+		s->max = cycles;
+	for (i = 0; i < BLKSTATS_BUCKETS - 1; i++)
+		if (cycles < blkstats_limit[i])
+			break;
+	s->hist[i]++;
+}
+
+unsigned long long blkstats_start(void)
+{
+	return get_ticks();
+}
+
+void blkstats_end(int iftype, int dev, int dir, unsigned long bytes,
+		  unsigned long long start)
+{
+	blkstats_add(blkstats_find(iftype, dev, NULL), dir, bytes, start);
+}
+
+void blkstats_mtd_end(const char *name, int dir, unsigned long bytes,
+		      unsigned long long start)
+{
+	blkstats_add(blkstats_find(BLKSTATS_MTD, 0, name), dir, bytes, start);
+}
+
+static const char *blkstats_ifname(int iftype)
+{
+	switch (iftype) {
+	case IF_TYPE_IDE:
+		return "ide";
+	case IF_TYPE_SCSI:
+		return "scsi";
+	case IF_TYPE_USB:
+		return "usb";
+	case IF_TYPE_MMC:
+		return "mmc";
+	case IF_TYPE_SATA:
+		return "sata";
+	case IF_TYPE_HOST:
+		return "host";
+	case IF_TYPE_AOE:
+		return "aoe";
+	default:
+		return "?";
+	}
+}
+
+static ulong blkstats_us(unsigned long long cycles)
+{
+	ulong hz = get_tbclk();
+
+	if (hz >= 1000000)
+		do_div(cycles, hz / 1000000);
+	else if (hz)
+		cycles = lldiv(cycles * 1000000, hz);
+	return cycles;
+}
+
+static void blkstats_print(struct blkstats_dev *d)
+{
+	static const char * const dirs[2] = { "read", "write" };
+	struct blkstats_dir *s;
+	char name[16];
+	int i, j;
+
+	if (d->name)
+		strncpy(name, d->name, sizeof(name) - 1);
+	else
+		sprintf(name, "%s %d", blkstats_ifname(d->iftype), d->dev);
+	name[sizeof(name) - 1] = '\0';
+
+	for (i = 0; i < 2; i++) {
+		s = &d->dir[i];
+		if (!s->cmds)
+			continue;
+		printf("%-10s %-5s %8lu %12llu %10lu %8lu %8lu ",
+		       name, dirs[i], s->cmds, s->bytes,
+		       blkstats_us(s->cycles) / 1000,
+		       blkstats_us(lldiv(s->cycles, s->cmds)),
+		       blkstats_us(s->max));
+		for (j = 0; j < BLKSTATS_BUCKETS; j++)
+			printf(" %lu", s->hist[j]);
+		putc('\n');
+	}
+}
+
+static int do_blkstats(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	int i;
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		blkstats_used = 0;
+		return 0;
+	}
+	if (argc != 1)
+		return cmd_usage(cmdtp);
+
+	printf("%-10s %-5s %8s %12s %10s %8s %8s  %s\n", "device", "dir",
+	       "cmds", "bytes", "total ms", "avg us", "max us",
+	       "<100us <1ms <10ms <100ms <1s >=1s");
+	for (i = 0; i < blkstats_used; i++)
+		blkstats_print(&blkstats[i]);
+	return 0;
+}
+
+U_BOOT_CMD(
+	blkstats,	2,	0,	do_blkstats,
+	"block and MTD device I/O statistics",
+	"\n"
+	"    - show the commands, bytes and time of each device\n"
+	"blkstats reset\n"
+	"    - clear them"
+);
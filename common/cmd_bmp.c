@@ -227,6 +227,24 @@ static int bmp_display(ulong addr, int x, int y)
 	bmp_image_t *bmp = (bmp_image_t *)addr;
 	unsigned long len;
 
+#ifdef CONFIG_VIDEO_BMP_GZIP
+	/* a gzipped image is shown as it is unpacked, if it can be */
+	if (!((bmp->header.signature[0]=='B') &&
+	      (bmp->header.signature[1]=='M'))) {
+#if defined(CONFIG_LCD)
+		ret = bmp_display_gz(addr, x, y, panel_info.vl_col,
+				     panel_info.vl_row, lcd_display_bitmap);
+		if (ret >= 0)
+			return ret;
+#elif defined(CONFIG_VIDEO)
+		extern int video_display_bitmap (ulong, int, int);
+
+		/* which knows the screen size, and falls back by itself */
+		return video_display_bitmap(addr, x, y);
+#endif
+	}
+#endif
+
 	if (!((bmp->header.signature[0]=='B') &&
 	      (bmp->header.signature[1]=='M')))
 		bmp = gunzip_bmp(addr, &len);
@@ -48,6 +48,8 @@ int do_go (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	addr = simple_strtoul(argv[1], NULL, 16);
 
 	printf ("## Starting application at 0x%08lX ...\n", addr);
+	serial_flush();
+	eth_halt_all();
 
 	/*
 	 * pass address parameter as argv[0] (aka command name),
@@ -37,6 +37,12 @@
 #include <linux/ctype.h>
 #include <asm/byteorder.h>
 #include <linux/compiler.h>
+#include <load_hash.h>
+#include <mp_job.h>
+#include <dma.h>
+#include <net.h>
+#include <probe.h>
+#include <tpm.h>
 
 #if defined(CONFIG_CMD_USB)
 #include <usb.h>
@@ -62,6 +68,10 @@
 #include <linux/lzo.h>
 #endif /* CONFIG_LZO */
 
+#ifdef CONFIG_LZ4
+#include <lz4.h>
+#endif /* CONFIG_LZ4 */
+
 DECLARE_GLOBAL_DATA_PTR;
 
 #ifndef CONFIG_SYS_BOOTM_LEN
@@ -167,8 +177,33 @@ void __arch_preboot_os(void)
 }
 void arch_preboot_os(void) __attribute__((weak, alias("__arch_preboot_os")));
 
+/* Called around copying and uncompressing the OS image */
+void __arch_preload_os(void)
+{
+}
+void arch_preload_os(void) __attribute__((weak, alias("__arch_preload_os")));
+
+void __arch_postload_os(void)
+{
+}
+void arch_postload_os(void) __attribute__((weak, alias("__arch_postload_os")));
+
 #define IH_INITRD_ARCH IH_ARCH_DEFAULT
 
+/*
+ * The messages of "quiet" must not go on into a kernel loaded over the
+ * pre-console buffer: print them and stop holding output back.
+ */
+static void bootm_quiet_check(void)
+{
+#ifdef CONFIG_CONSOLE_QUIET_BOOT
+	if ((gd->flags & GD_FLG_QUIET) &&
+	    images.os.load < CONFIG_PRE_CON_BUF_ADDR + CONFIG_PRE_CON_BUF_SZ &&
+	    images.os.load + CONFIG_SYS_BOOTM_LEN > CONFIG_PRE_CON_BUF_ADDR)
+		console_quiet_flush();
+#endif
+}
+
 static void bootm_start_lmb(void)
 {
 #ifdef CONFIG_LMB
@@ -184,16 +219,95 @@ static void bootm_start_lmb(void)
 
 	arch_lmb_reserve(&images.lmb);
 	board_lmb_reserve(&images.lmb);
+#ifdef CONFIG_CONSOLE_QUIET_BOOT
+	/* "quiet" output keeps going to the pre-console buffer */
+	if (gd->flags & GD_FLG_QUIET)
+		lmb_reserve(&images.lmb, CONFIG_PRE_CON_BUF_ADDR,
+			    CONFIG_PRE_CON_BUF_SZ);
+#endif
 #else
 # define lmb_reserve(lmb, base, size)
 #endif
 }
 
+#if defined(CONFIG_FIT) && (defined(CONFIG_MP_JOBS) || defined(CONFIG_DMA_MEMCPY))
+/*
+ * An uncompressed FIT kernel that has to be moved is copied by a
+ * secondary core, or else a DMA engine, while the boot core checks the
+ * ramdisk and FDT.  This is only done when those come from the same
+ * FIT and the kernel does not land on it, so the copy can not
+ * overwrite anything that is still to be read; otherwise
+ * bootm_load_os() copies as before.
+ */
+#ifdef CONFIG_MP_JOBS
+static struct mp_job bootm_copy_job;
+#endif
+static int bootm_copy_dma;
+
+static void bootm_copy_start(ulong blob_start, int argc)
+{
+	image_info_t *os = &images.os;
+
+	if (!images.fit_uname_os || argc > 2)
+		return;
+	if (os->comp != IH_COMP_NONE || os->load == os->image_start)
+		return;
+	if (os->load < os->end && os->load + os->image_len > blob_start)
+		return;
+
+#ifdef CONFIG_MP_JOBS
+	bootm_copy_job.func = mp_job_memcpy;
+	bootm_copy_job.arg[0] = os->load;
+	bootm_copy_job.arg[1] = os->image_start;
+	bootm_copy_job.arg[2] = os->image_len;
+	if (mp_job_start(&bootm_copy_job) == 0) {
+		debug("   Copying kernel to %08lx on another core\n",
+		      os->load);
+		return;
+	}
+#endif
+
+	if (dma_memcpy_start((void *)os->load, (void *)os->image_start,
+			     os->image_len) == 0) {
+		debug("   Copying kernel to %08lx by DMA\n", os->load);
+		bootm_copy_dma = 1;
+	}
+}
+
+/* Wait for bootm_copy_start(); returns 1 if the kernel has been copied */
+static int bootm_copy_wait(void)
+{
+	if (bootm_copy_dma) {
+		bootm_copy_dma = 0;
+		return dma_memcpy_wait() == 0;
+	}
+
+#ifdef CONFIG_MP_JOBS
+	if (bootm_copy_job.state != MP_JOB_IDLE) {
+		mp_job_wait(&bootm_copy_job);
+		bootm_copy_job.state = MP_JOB_IDLE;
+		return 1;
+	}
+#endif
+	return 0;
+}
+#else
+static inline void bootm_copy_start(ulong blob_start, int argc) { }
+static inline int bootm_copy_wait(void) { return 0; }
+#endif
+
 static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	void		*os_hdr;
 	int		ret;
 
+	/* a kernel copy still running from an earlier "bootm start" */
+	bootm_copy_wait();
+
+#ifdef CONFIG_LMB
+	/* give back the region tables an earlier attempt has grown */
+	lmb_init(&images.lmb);
+#endif
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = getenv_yesno("verify");
 
@@ -222,21 +336,21 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 		if (fit_image_get_type(images.fit_hdr_os,
 					images.fit_noffset_os, &images.os.type)) {
 			puts("Can't get image type!\n");
-			show_boot_progress(-109);
+			bootstage_mark(-109);
 			return 1;
 		}
 
 		if (fit_image_get_comp(images.fit_hdr_os,
 					images.fit_noffset_os, &images.os.comp)) {
 			puts("Can't get image compression!\n");
-			show_boot_progress(-110);
+			bootstage_mark(-110);
 			return 1;
 		}
 
 		if (fit_image_get_os(images.fit_hdr_os,
 					images.fit_noffset_os, &images.os.os)) {
 			puts("Can't get image OS!\n");
-			show_boot_progress(-111);
+			bootstage_mark(-111);
 			return 1;
 		}
 
@@ -245,7 +359,7 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 		if (fit_image_get_load(images.fit_hdr_os, images.fit_noffset_os,
 					&images.os.load)) {
 			puts("Can't get image load address!\n");
-			show_boot_progress(-112);
+			bootstage_mark(-112);
 			return 1;
 		}
 		break;
@@ -277,6 +391,8 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 		images.ep += images.os.load;
 	}
 
+	bootm_copy_start((ulong)os_hdr, argc);
+
 	if (((images.os.type == IH_TYPE_KERNEL) ||
 	     (images.os.type == IH_TYPE_KERNEL_NOLOAD) ||
 	     (images.os.type == IH_TYPE_MULTI)) &&
@@ -311,7 +427,8 @@ static int bootm_start(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]
 #define BOOTM_ERR_RESET		-1
 #define BOOTM_ERR_OVERLAP	-2
 #define BOOTM_ERR_UNIMPLEMENTED	-3
-static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
+static int __bootm_load_os(image_info_t os, ulong *load_end,
+			   int boot_progress)
 {
 	uint8_t comp = os.comp;
 	ulong load = os.load;
@@ -321,9 +438,9 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	ulong image_len = os.image_len;
 	__maybe_unused uint unc_len = CONFIG_SYS_BOOTM_LEN;
 	int no_overlap = 0;
-#if defined(CONFIG_LZMA) || defined(CONFIG_LZO)
+#if defined(CONFIG_LZMA) || defined(CONFIG_LZO) || defined(CONFIG_LZ4)
 	int ret;
-#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) */
+#endif /* defined(CONFIG_LZMA) || defined(CONFIG_LZO) || ... */
 
 	const char *type_name = genimg_get_type_name(os.type);
 
@@ -332,23 +449,35 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 		if (load == blob_start || load == image_start) {
 			printf("   XIP %s ... ", type_name);
 			no_overlap = 1;
+		} else if (bootm_copy_wait()) {
+			printf("   Loading %s ... ", type_name);
+			no_overlap = 1;
 		} else {
 			printf("   Loading %s ... ", type_name);
-			memmove_wd((void *)load, (void *)image_start,
-					image_len, CHUNKSZ);
+			if (dma_memcpy((void *)load, (void *)image_start,
+				       image_len))
+				memmove_wd((void *)load, (void *)image_start,
+					   image_len, CHUNKSZ);
 		}
 		*load_end = load + image_len;
 		puts("OK\n");
 		break;
 #ifdef CONFIG_GZIP
 	case IH_COMP_GZIP:
+		if (load_unzip_get(image_start, image_len, load,
+				   &image_len) == 0) {
+			printf("   %s uncompressed while loading ... ",
+				type_name);
+			*load_end = load + image_len;
+			break;
+		}
 		printf("   Uncompressing %s ... ", type_name);
 		if (gunzip((void *)load, unc_len,
 				(uchar *)image_start, &image_len) != 0) {
 			puts("GUNZIP: uncompress, out-of-mem or overwrite "
 				"error - must RESET board to recover\n");
 			if (boot_progress)
-				show_boot_progress(-6);
+				bootstage_mark(-6);
 			return BOOTM_ERR_RESET;
 		}
 
@@ -358,19 +487,13 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 #ifdef CONFIG_BZIP2
 	case IH_COMP_BZIP2:
 		printf("   Uncompressing %s ... ", type_name);
-		/*
-		 * If we've got less than 4 MB of malloc() space,
-		 * use slower decompression algorithm which requires
-		 * at most 2300 KB of memory.
-		 */
-		int i = BZ2_bzBuffToBuffDecompress((char *)load,
-					&unc_len, (char *)image_start, image_len,
-					CONFIG_SYS_MALLOC_LEN < (4096 * 1024), 0);
+		int i = bunzip2((char *)load, &unc_len, (char *)image_start,
+				image_len);
 		if (i != BZ_OK) {
 			printf("BUNZIP2: uncompress or overwrite error %d "
 				"- must RESET board to recover\n", i);
 			if (boot_progress)
-				show_boot_progress(-6);
+				bootstage_mark(-6);
 			return BOOTM_ERR_RESET;
 		}
 
@@ -389,7 +512,7 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 		if (ret != SZ_OK) {
 			printf("LZMA: uncompress or overwrite error %d "
 				"- must RESET board to recover\n", ret);
-			show_boot_progress(-6);
+			bootstage_mark(-6);
 			return BOOTM_ERR_RESET;
 		}
 		*load_end = load + unc_len;
@@ -397,34 +520,58 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	}
 #endif /* CONFIG_LZMA */
 #ifdef CONFIG_LZO
-	case IH_COMP_LZO:
+	case IH_COMP_LZO: {
+		size_t lzo_len = unc_len;
+
 		printf("   Uncompressing %s ... ", type_name);
 
 		ret = lzop_decompress((const unsigned char *)image_start,
 					  image_len, (unsigned char *)load,
-					  &unc_len);
+					  &lzo_len);
 		if (ret != LZO_E_OK) {
 			printf("LZO: uncompress or overwrite error %d "
 			      "- must RESET board to recover\n", ret);
 			if (boot_progress)
-				show_boot_progress(-6);
+				bootstage_mark(-6);
 			return BOOTM_ERR_RESET;
 		}
 
-		*load_end = load + unc_len;
+		*load_end = load + lzo_len;
 		break;
+	}
 #endif /* CONFIG_LZO */
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t lz4_len = unc_len;
+
+		printf("   Uncompressing %s ... ", type_name);
+
+		ret = lz4_decompress((const unsigned char *)image_start,
+				     image_len, (unsigned char *)load,
+				     &lz4_len);
+		if (ret != LZ4_E_OK) {
+			printf("LZ4: uncompress or overwrite error %d "
+			      "- must RESET board to recover\n", ret);
+			if (boot_progress)
+				bootstage_mark(-6);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + lz4_len;
+		break;
+	}
+#endif /* CONFIG_LZ4 */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
 	}
 
-	flush_cache(load, (*load_end - load) * sizeof(ulong));
+	flush_cache(load, *load_end - load);
 
 	puts("OK\n");
 	debug("   kernel loaded at 0x%08lx, end = 0x%08lx\n", load, *load_end);
 	if (boot_progress)
-		show_boot_progress(7);
+		bootstage_mark(7);
 
 	if (!no_overlap && (load < blob_end) && (*load_end > blob_start)) {
 		debug("images.os.start = 0x%lX, images.os.end = 0x%lx\n",
@@ -438,6 +585,17 @@ static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
 	return 0;
 }
 
+static int bootm_load_os(image_info_t os, ulong *load_end, int boot_progress)
+{
+	int ret;
+
+	arch_preload_os();
+	ret = __bootm_load_os(os, load_end, boot_progress);
+	arch_postload_os();
+
+	return ret;
+}
+
 static int bootm_start_standalone(ulong iflag, int argc, char * const argv[])
 {
 	char  *s;
@@ -489,7 +647,9 @@ int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 		if (state == BOOTM_STATE_START) {
 			argc--;
 			argv++;
-			return bootm_start(cmdtp, flag, argc, argv);
+			ret = bootm_start(cmdtp, flag, argc, argv);
+			fit_hash_release();
+			return ret;
 		}
 	} else {
 		/* Unrecognized command */
@@ -510,6 +670,7 @@ int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 			/* should never occur */
 			break;
 		case BOOTM_STATE_LOADOS:
+			bootm_quiet_check();
 			ret = bootm_load_os(images.os, &load_end, 0);
 			if (ret)
 				return ret;
@@ -561,8 +722,14 @@ int do_bootm_subcommand(cmd_tbl_t *cmdtp, int flag, int argc,
 				printf("prep subcommand not supported\n");
 			break;
 		case BOOTM_STATE_OS_GO:
+			probe_finish_all();
 			disable_interrupts();
+			/* as in do_bootm(): no NIC left running into our buffers */
+			nc_sync();
+			eth_halt_all();
+			tpm_measure_flush();
 			arch_preboot_os();
+			serial_flush();
 			boot_fn(BOOTM_STATE_OS_GO, argc, argv, &images);
 			break;
 	}
@@ -610,9 +777,15 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			return do_bootm_subcommand(cmdtp, flag, argc, argv);
 	}
 
-	if (bootm_start(cmdtp, flag, argc, argv))
+	ret = bootm_start(cmdtp, flag, argc, argv);
+	/* hashes not picked up by now are stale */
+	fit_hash_release();
+	if (ret)
 		return 1;
 
+	/* the OS gets the devices in the state a finished probe leaves */
+	probe_finish_all();
+
 	/*
 	 * We have reached the point of no return: we are going to
 	 * overwrite all exception vector code, so we cannot easily
@@ -632,6 +805,11 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	 */
 	usb_stop();
 #endif
+	/* nor must a network device left up, see CONFIG_NET_KEEP_LINK */
+	nc_sync();
+	eth_halt_all();
+
+	bootm_quiet_check();
 
 	ret = bootm_load_os(images.os, &load_end, 1);
 
@@ -649,14 +827,14 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			} else {
 				puts("ERROR: new format image overwritten - "
 					"must RESET the board to recover\n");
-				show_boot_progress(-113);
+				bootstage_mark(-113);
 				do_reset(cmdtp, flag, argc, argv);
 			}
 		}
 		if (ret == BOOTM_ERR_UNIMPLEMENTED) {
 			if (iflag)
 				enable_interrupts();
-			show_boot_progress(-7);
+			bootstage_mark(-7);
 			return 1;
 		}
 	}
@@ -671,7 +849,7 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return 0;
 	}
 
-	show_boot_progress(8);
+	bootstage_mark(8);
 
 #ifdef CONFIG_SILENT_CONSOLE
 	if (images.os.os == IH_OS_LINUX)
@@ -685,15 +863,17 @@ int do_bootm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			enable_interrupts();
 		printf("ERROR: booting os '%s' (%d) is not supported\n",
 			genimg_get_os_name(images.os.os), images.os.os);
-		show_boot_progress(-8);
+		bootstage_mark(-8);
 		return 1;
 	}
 
+	tpm_measure_flush();
 	arch_preboot_os();
+	serial_flush();
 
 	boot_fn(0, argc, argv, &images);
 
-	show_boot_progress(-9);
+	bootstage_mark(-9);
 #ifdef DEBUG
 	puts("\n## Control returned to monitor - resetting...\n");
 #endif
@@ -717,6 +897,23 @@ int bootm_maybe_autostart(cmd_tbl_t *cmdtp, const char *cmd)
 	return 0;
 }
 
+#ifdef CONFIG_TPM_MEASURE
+/* Measure a legacy image, with the SHA-1 taken while it was loaded */
+static void image_measure_kernel(const image_header_t *hdr)
+{
+	ulong data = image_get_data(hdr);
+	ulong len = image_get_data_size(hdr);
+	uint8_t digest[TPM_DIGEST_SIZE];
+
+	if (load_hash_get_sha1(data, len, image_get_dcrc(hdr), digest) == 0)
+		tpm_measure_digest(CONFIG_TPM_MEASURE_PCR, digest);
+	else
+		tpm_measure(CONFIG_TPM_MEASURE_PCR, (void *)data, len);
+}
+#else
+static inline void image_measure_kernel(const image_header_t *hdr) {}
+#endif
+
 /**
  * image_get_kernel - verify legacy format kernel image
  * @img_addr: in RAM address of the legacy format image to be verified
@@ -735,34 +932,35 @@ static image_header_t *image_get_kernel(ulong img_addr, int verify)
 
 	if (!image_check_magic(hdr)) {
 		puts("Bad Magic Number\n");
-		show_boot_progress(-1);
+		bootstage_mark(-1);
 		return NULL;
 	}
-	show_boot_progress(2);
+	bootstage_mark(2);
 
 	if (!image_check_hcrc(hdr)) {
 		puts("Bad Header Checksum\n");
-		show_boot_progress(-2);
+		bootstage_mark(-2);
 		return NULL;
 	}
 
-	show_boot_progress(3);
+	bootstage_mark(3);
 	image_print_contents(hdr);
 
 	if (verify) {
 		puts("   Verifying Checksum ... ");
 		if (!image_check_dcrc(hdr)) {
 			printf("Bad Data CRC\n");
-			show_boot_progress(-3);
+			bootstage_mark(-3);
 			return NULL;
 		}
 		puts("OK\n");
 	}
-	show_boot_progress(4);
+	image_measure_kernel(hdr);
+	bootstage_mark(4);
 
 	if (!image_check_target_arch(hdr)) {
 		printf("Unsupported Architecture 0x%x\n", image_get_arch(hdr));
-		show_boot_progress(-4);
+		bootstage_mark(-4);
 		return NULL;
 	}
 	return hdr;
@@ -788,30 +986,32 @@ static int fit_check_kernel(const void *fit, int os_noffset, int verify)
 
 	if (verify) {
 		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_check_hashes(fit, os_noffset)) {
+		if (!fit_image_check_measure(fit, os_noffset)) {
 			puts("Bad Data Hash\n");
-			show_boot_progress(-104);
+			bootstage_mark(-104);
 			return 0;
 		}
 		puts("OK\n");
+	} else {
+		fit_image_measure(fit, os_noffset);
 	}
-	show_boot_progress(105);
+	bootstage_mark(105);
 
 	if (!fit_image_check_target_arch(fit, os_noffset)) {
 		puts("Unsupported Architecture\n");
-		show_boot_progress(-105);
+		bootstage_mark(-105);
 		return 0;
 	}
 
-	show_boot_progress(106);
+	bootstage_mark(106);
 	if (!fit_image_check_type(fit, os_noffset, IH_TYPE_KERNEL) &&
 	    !fit_image_check_type(fit, os_noffset, IH_TYPE_KERNEL_NOLOAD)) {
 		puts("Not a kernel image\n");
-		show_boot_progress(-106);
+		bootstage_mark(-106);
 		return 0;
 	}
 
-	show_boot_progress(107);
+	bootstage_mark(107);
 	return 1;
 }
 #endif /* CONFIG_FIT */
@@ -864,7 +1064,7 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 		debug("*  kernel: cmdline image address = 0x%08lx\n", img_addr);
 	}
 
-	show_boot_progress(1);
+	bootstage_mark(1);
 
 	/* copy from dataflash if needed */
 	img_addr = genimg_get_image(img_addr);
@@ -878,7 +1078,7 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 		hdr = image_get_kernel(img_addr, images->verify);
 		if (!hdr)
 			return NULL;
-		show_boot_progress(5);
+		bootstage_mark(5);
 
 		/* get os_data and os_len */
 		switch (image_get_type(hdr)) {
@@ -897,7 +1097,7 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 		default:
 			printf("Wrong Image Type for %s command\n",
 				cmdtp->name);
-			show_boot_progress(-5);
+			bootstage_mark(-5);
 			return NULL;
 		}
 
@@ -912,7 +1112,7 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 		images->legacy_hdr_os = hdr;
 
 		images->legacy_hdr_valid = 1;
-		show_boot_progress(6);
+		bootstage_mark(6);
 		break;
 #if defined(CONFIG_FIT)
 	case IMAGE_FORMAT_FIT:
@@ -922,10 +1122,10 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 
 		if (!fit_check_format(fit_hdr)) {
 			puts("Bad FIT kernel image format!\n");
-			show_boot_progress(-100);
+			bootstage_mark(-100);
 			return NULL;
 		}
-		show_boot_progress(100);
+		bootstage_mark(100);
 
 		if (!fit_uname_kernel) {
 			/*
@@ -934,11 +1134,11 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 			 * fit_conf_get_node() will try to find default config
 			 * node
 			 */
-			show_boot_progress(101);
+			bootstage_mark(101);
 			cfg_noffset = fit_conf_get_node(fit_hdr,
 							fit_uname_config);
 			if (cfg_noffset < 0) {
-				show_boot_progress(-101);
+				bootstage_mark(-101);
 				return NULL;
 			}
 			/* save configuration uname provided in the first
@@ -949,7 +1149,10 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 								NULL);
 			printf("   Using '%s' configuration\n",
 				images->fit_uname_cfg);
-			show_boot_progress(103);
+			bootstage_mark(103);
+
+			if (images->verify)
+				fit_hash_prefetch(fit_hdr, cfg_noffset);
 
 			os_noffset = fit_conf_get_kernel_node(fit_hdr,
 								cfg_noffset);
@@ -957,28 +1160,28 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 							NULL);
 		} else {
 			/* get kernel component image node offset */
-			show_boot_progress(102);
+			bootstage_mark(102);
 			os_noffset = fit_image_get_node(fit_hdr,
 							fit_uname_kernel);
 		}
 		if (os_noffset < 0) {
-			show_boot_progress(-103);
+			bootstage_mark(-103);
 			return NULL;
 		}
 
 		printf("   Trying '%s' kernel subimage\n", fit_uname_kernel);
 
-		show_boot_progress(104);
+		bootstage_mark(104);
 		if (!fit_check_kernel(fit_hdr, os_noffset, images->verify))
 			return NULL;
 
 		/* get kernel image data address and length */
 		if (fit_image_get_data(fit_hdr, os_noffset, &data, &len)) {
 			puts("Could not find kernel subimage data!\n");
-			show_boot_progress(-107);
+			bootstage_mark(-107);
 			return NULL;
 		}
-		show_boot_progress(108);
+		bootstage_mark(108);
 
 		*os_len = len;
 		*os_data = (ulong)data;
@@ -989,7 +1192,7 @@ static void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 #endif
 	default:
 		printf("Wrong Image Format for %s command\n", cmdtp->name);
-		show_boot_progress(-108);
+		bootstage_mark(-108);
 		return NULL;
 	}
 
@@ -1037,6 +1240,142 @@ U_BOOT_CMD(
 	"\tgo      - start OS"
 );
 
+/*******************************************************************/
+/* bootz - boot a Linux zImage without a uImage header */
+/*******************************************************************/
+#if defined(CONFIG_CMD_BOOTZ)
+/*
+ * Find the kernel in a zImage at "image": where it has to run (NULL if
+ * anywhere) and how long it is.  0 if "image" is a zImage.
+ */
+int __bootz_setup(void *image, void **start, ulong *len)
+{
+	/* Please define bootz_setup() for your platform */
+	puts("Your platform's zImage format isn't supported yet!\n");
+	return -1;
+}
+int bootz_setup(void *image, void **start, ulong *len)
+	__attribute__((weak, alias("__bootz_setup")));
+
+static int bootz_start(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	void *zi_start;
+	ulong zi_len, addr;
+	int ret;
+
+#ifdef CONFIG_LMB
+	lmb_init(&images.lmb);
+#endif
+	memset((void *)&images, 0, sizeof(images));
+	bootm_start_lmb();
+
+	addr = argc < 2 ? load_addr : simple_strtoul(argv[1], NULL, 16);
+
+	if (bootz_setup((void *)addr, &zi_start, &zi_len))
+		return 1;
+
+	/*
+	 * The decompressor runs wherever it is, so the zImage is only
+	 * moved when it was linked to an address; the kernel's own
+	 * checksums stand in for the header CRC of bootm.
+	 */
+	if (zi_start && (ulong)zi_start != addr) {
+		printf("   Moving zImage to %08lx ... ", (ulong)zi_start);
+		if (dma_memcpy(zi_start, (void *)addr, zi_len))
+			memmove(zi_start, (void *)addr, zi_len);
+		flush_cache((ulong)zi_start, zi_len);
+		puts("OK\n");
+		addr = (ulong)zi_start;
+	}
+
+	tpm_measure(CONFIG_TPM_MEASURE_PCR, (void *)addr, zi_len);
+
+	images.os.os = IH_OS_LINUX;
+	images.os.type = IH_TYPE_KERNEL;
+	images.os.start = images.os.image_start = images.os.load = addr;
+	images.os.image_len = zi_len;
+	images.os.end = addr + zi_len;
+	images.ep = addr;
+	lmb_reserve(&images.lmb, addr, zi_len);
+
+	/* find ramdisk */
+	ret = boot_get_ramdisk(argc, argv, &images, IH_INITRD_ARCH,
+			       &images.rd_start, &images.rd_end);
+	if (ret) {
+		puts("Ramdisk image is corrupt or invalid\n");
+		return 1;
+	}
+
+#if defined(CONFIG_OF_LIBFDT)
+	/* find flattened device tree */
+	ret = boot_get_fdt(flag, argc, argv, &images,
+			   &images.ft_addr, &images.ft_len);
+	if (ret) {
+		puts("Could not find a valid device tree\n");
+		return 1;
+	}
+
+	set_working_fdt_addr(images.ft_addr);
+#endif
+	images.state = BOOTM_STATE_START;
+
+	return 0;
+}
+
+int do_bootz(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (bootz_start(cmdtp, flag, argc, argv))
+		return 1;
+
+	/* the OS gets the devices in the state a finished probe leaves */
+	probe_finish_all();
+
+	disable_interrupts();
+
+#if defined(CONFIG_CMD_USB)
+	usb_stop();
+#endif
+	nc_sync();
+	eth_halt_all();
+
+	bootstage_mark(8);
+
+#ifdef CONFIG_SILENT_CONSOLE
+	fixup_silent_linux();
+#endif
+
+	tpm_measure_flush();
+	arch_preboot_os();
+	serial_flush();
+
+	do_bootm_linux(0, argc, argv, &images);
+
+	bootstage_mark(-9);
+#ifdef DEBUG
+	puts("\n## Control returned to monitor - resetting...\n");
+#endif
+	do_reset(cmdtp, flag, argc, argv);
+
+	return 1;
+}
+
+U_BOOT_CMD(
+	bootz,	CONFIG_SYS_MAXARGS,	1,	do_bootz,
+	"boot Linux zImage image from memory",
+	"[addr [initrd] [fdt]]\n"
+	"    - boot Linux zImage stored in memory\n"
+	"\tThe argument 'initrd' is optional and specifies the address\n"
+	"\tof a ramdisk image in memory, as for bootm.\n"
+#if defined(CONFIG_OF_LIBFDT)
+	"\tWhen booting a Linux kernel which requires a flat device-tree\n"
+	"\ta third argument is required which is the address of the\n"
+	"\tdevice-tree blob. To boot that kernel without an initrd image,\n"
+	"\tuse a '-' for the second argument.\n"
+#endif
+);
+#endif	/* CONFIG_CMD_BOOTZ */
+
 /*******************************************************************/
 /* bootd - boot default image */
 /*******************************************************************/
@@ -1340,7 +1679,7 @@ static int do_bootm_netbsd(int flag, int argc, char * const argv[],
 		"(at address %08lx) ...\n",
 		(ulong)loader);
 
-	show_boot_progress(15);
+	bootstage_mark(15);
 
 	/*
 	 * NetBSD Stage-2 Loader Parameters:
@@ -1398,7 +1737,7 @@ static int do_bootm_rtems(int flag, int argc, char * const argv[],
 	printf("## Transferring control to RTEMS (at address %08lx) ...\n",
 		(ulong)entry_point);
 
-	show_boot_progress(15);
+	bootstage_mark(15);
 
 	/*
 	 * RTEMS Parameters:
@@ -1431,7 +1770,7 @@ static int do_bootm_ose(int flag, int argc, char * const argv[],
 	printf("## Transferring control to OSE (at address %08lx) ...\n",
 		(ulong)entry_point);
 
-	show_boot_progress(15);
+	bootstage_mark(15);
 
 	/*
 	 * OSE Parameters:
@@ -1512,7 +1851,7 @@ static int do_bootm_integrity(int flag, int argc, char * const argv[],
 	printf("## Transferring control to INTEGRITY (at address %08lx) ...\n",
 		(ulong)entry_point);
 
-	show_boot_progress(15);
+	bootstage_mark(15);
 
 	/*
 	 * INTEGRITY Parameters:
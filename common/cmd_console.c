@@ -27,6 +27,9 @@
 #include <common.h>
 #include <command.h>
 #include <stdio_dev.h>
+#ifdef CONFIG_CONSOLE_STATS
+#include <div64.h>
+#endif
 
 extern void _do_coninfo (void);
 int do_coninfo (cmd_tbl_t * cmd, int flag, int argc, char * const argv[])
@@ -56,6 +59,15 @@ int do_coninfo (cmd_tbl_t * cmd, int flag, int argc, char * const argv[])
 			}
 		}
 		putc ('\n');
+#ifdef CONFIG_CONSOLE_STATS
+		if (dev->out_bytes) {
+			unsigned long long us;
+
+			us = lldiv(dev->out_ticks * 1000000, get_tbclk());
+			printf ("         %lu bytes written in %llu us\n",
+				dev->out_bytes, us);
+		}
+#endif
 	}
 	return 0;
 }
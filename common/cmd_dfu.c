@@ -0,0 +1,44 @@
+/*
+ * Write images sent with USB Device Firmware Upgrade
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <usb/dfu.h>
+
+#ifndef CONFIG_USB_DFU_BUF_SIZE
+#define CONFIG_USB_DFU_BUF_SIZE	(32 << 20)
+#endif
+
+static int do_dfu(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	ulong addr, size = CONFIG_USB_DFU_BUF_SIZE;
+
+#ifdef CONFIG_USB_DFU_BUF_ADDR
+	addr = CONFIG_USB_DFU_BUF_ADDR;
+#else
+	addr = load_addr;
+#endif
+	if (argc > 1)
+		addr = simple_strtoul(argv[1], NULL, 16);
+	if (argc > 2)
+		size = simple_strtoul(argv[2], NULL, 16);
+
+	printf("dfu: buffer 0x%08lx, %lu KiB, ctrl-c to quit\n",
+	       addr, size >> 10);
+
+	return dfu_run((void *)addr, size) ? 1 : 0;
+}
+
+U_BOOT_CMD(
+	dfu,	3,	0,	do_dfu,
+	"write images sent over USB with DFU",
+	"[addr [size]]\n"
+	"    - serve a DFU host, one alternate setting per area of\n"
+	"      'dfu_alt_info', keeping the data in 'size' bytes at 'addr'"
+);
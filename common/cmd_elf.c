@@ -15,6 +15,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <dma.h>
 #include <linux/ctype.h>
 #include <net.h>
 #include <elf.h>
@@ -92,6 +93,7 @@ int do_bootelf (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		addr = load_elf_image_shdr(addr);
 
 	printf ("## Starting application at 0x%08lx ...\n", addr);
+	eth_halt_all();
 
 	/*
 	 * pass address parameter as argv[0] (aka command name),
@@ -229,6 +231,7 @@ int do_bootvx (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	printf ("## Using bootline (@ 0x%lx): %s\n", bootaddr,
 			(char *) bootaddr);
 	printf ("## Starting vxWorks at 0x%08lx ...\n", addr);
+	eth_halt_all();
 
 	((void (*)(void)) addr) ();
 
@@ -270,6 +273,17 @@ int valid_elf_image (unsigned long addr)
 	return 1;
 }
 
+/*
+ * Copy a segment or section to where it runs, through a DMA engine if
+ * there is one for copies this big, else with the CPU.  The image may
+ * have been loaded close to its destination, so this may overlap.
+ */
+static void load_elf_copy(void *dst, const void *src, unsigned long len)
+{
+	if (dma_memcpy(dst, src, len))
+		memmove(dst, src, len);
+}
+
 /* ======================================================================
  * A very simple elf loader, assumes the image is valid, returns the
  * entry point address.
@@ -284,17 +298,22 @@ static unsigned long load_elf_image_phdr(unsigned long addr)
 	phdr = (Elf32_Phdr *) (addr + ehdr->e_phoff);
 
 	/* Load each program header */
-	for (i = 0; i < ehdr->e_phnum; ++i) {
+	for (i = 0; i < ehdr->e_phnum; ++i, ++phdr) {
 		void *dst = (void *) phdr->p_paddr;
 		void *src = (void *) addr + phdr->p_offset;
+
+		/* notes, the interpreter etc. take no room at run time */
+		if (phdr->p_type != PT_LOAD || !phdr->p_memsz)
+			continue;
+
 		debug("Loading phdr %i to 0x%p (%i bytes)\n",
 			i, dst, phdr->p_filesz);
 		if (phdr->p_filesz)
-			memcpy(dst, src, phdr->p_filesz);
+			load_elf_copy(dst, src, phdr->p_filesz);
 		if (phdr->p_filesz != phdr->p_memsz)
 			memset(dst + phdr->p_filesz, 0x00, phdr->p_memsz - phdr->p_filesz);
-		flush_cache((unsigned long)dst, phdr->p_filesz);
-		++phdr;
+		/* the .bss part has to reach memory, too */
+		flush_cache((unsigned long)dst, phdr->p_memsz);
 	}
 
 	return ehdr->e_entry;
@@ -342,9 +361,9 @@ static unsigned long load_elf_image_shdr(unsigned long addr)
 			memset ((void *)shdr->sh_addr, 0, shdr->sh_size);
 		} else {
 			image = (unsigned char *) addr + shdr->sh_offset;
-			memcpy ((void *) shdr->sh_addr,
-				(const void *) image,
-				shdr->sh_size);
+			load_elf_copy ((void *) shdr->sh_addr,
+				       (const void *) image,
+				       shdr->sh_size);
 		}
 		flush_cache (shdr->sh_addr, shdr->sh_size);
 	}
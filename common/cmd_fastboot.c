@@ -0,0 +1,77 @@
+/*
+ * Download images over USB with the fastboot protocol
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <usb/fastboot.h>
+
+#ifndef CONFIG_USB_FASTBOOT_BUF_SIZE
+#define CONFIG_USB_FASTBOOT_BUF_SIZE	(32 << 20)
+#endif
+
+static int do_fastboot(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	ulong addr, size = CONFIG_USB_FASTBOOT_BUF_SIZE;
+	ulong len = 0;
+	char buf[12];
+	char *boot_argv[2];
+	int action;
+
+#ifdef CONFIG_USB_FASTBOOT_BUF_ADDR
+	addr = CONFIG_USB_FASTBOOT_BUF_ADDR;
+#else
+	addr = load_addr;
+#endif
+	if (argc > 1)
+		addr = simple_strtoul(argv[1], NULL, 16);
+	if (argc > 2)
+		size = simple_strtoul(argv[2], NULL, 16);
+
+	printf("fastboot: buffer 0x%08lx, %lu KiB, ctrl-c to quit\n",
+	       addr, size >> 10);
+
+	action = fastboot_run((void *)addr, size, &len);
+	if (action < 0) {
+		puts("fastboot: USB device controller not available\n");
+		return 1;
+	}
+
+	if (len) {
+		sprintf(buf, "%lX", len);
+		setenv("filesize", buf);
+		sprintf(buf, "%lX", addr);
+		setenv("fileaddr", buf);
+	}
+
+	switch (action) {
+	case FASTBOOT_BOOT:
+		if (!len) {
+			puts("fastboot: nothing to boot\n");
+			return 1;
+		}
+		sprintf(buf, "%lx", addr);
+		boot_argv[0] = "bootm";
+		boot_argv[1] = buf;
+		return do_bootm(cmdtp, 0, 2, boot_argv);
+	case FASTBOOT_REBOOT:
+		do_reset(cmdtp, 0, 0, NULL);
+		break;
+	}
+	return 0;
+}
+
+U_BOOT_CMD(
+	fastboot,	3,	0,	do_fastboot,
+	"download and flash images over USB",
+	"[addr [size]]\n"
+	"    - serve the fastboot host tool, keeping downloads in the\n"
+	"      'size' bytes at 'addr'; partitions for flash and erase\n"
+	"      are listed in 'fastboot_partitions'"
+);
@@ -32,6 +32,7 @@
 #include <fdt.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdt_index.h>
 
 #define MAX_LEVEL	32		/* how deeply nested we will go */
 #define SCRATCHPAD	1024		/* bytes of scratchpad memory */
@@ -55,6 +56,8 @@ void set_working_fdt_addr(void *addr)
 	char buf[17];
 
 	working_fdt = addr;
+	/* a new blob may have been loaded where the old one was */
+	fdt_index_invalidate(addr);
 
 	sprintf(buf, "%lx", (unsigned long)addr);
 	setenv("fdtaddr", buf);
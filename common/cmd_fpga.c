@@ -64,6 +64,23 @@ int fpga_loadbitstream(unsigned long dev, char* fpgadata, size_t size)
 	unsigned char *dataptr;
 	unsigned int i;
 	int rc;
+#ifdef CONFIG_FPGA_GZIP
+	/* the header of a compressed bitstream, unpacked */
+	unsigned char header[512];
+	char *zdata = NULL;
+	long hlen = 0;
+
+	if (size > 2 && fpgadata[0] == 0x1f && (u8)fpgadata[1] == 0x8b) {
+		zdata = fpgadata;
+		if (gunzip_read_start(zdata, size))
+			return FPGA_FAIL;
+		hlen = gunzip_read(header, sizeof(header));
+		gunzip_read_end();
+		if (hlen <= 0)
+			return FPGA_FAIL;
+		fpgadata = (char *)header;
+	}
+#endif
 
 	dataptr = (unsigned char *)fpgadata;
 
@@ -139,6 +156,16 @@ int fpga_loadbitstream(unsigned long dev, char* fpgadata, size_t size)
 	dataptr+=4;
 	printf("  bytes in bitstream = %d\n", swapsize);
 
+#ifdef CONFIG_FPGA_GZIP
+	if (zdata) {
+		if (dataptr - header > hlen) {
+			printf("%s: Bitstream header too long\n", __FUNCTION__);
+			return FPGA_FAIL;
+		}
+		return fpga_load_gz(dev, zdata, size, dataptr - header,
+				    swapsize);
+	}
+#endif
 	rc = fpga_load(dev, dataptr, swapsize);
 	return rc;
 #else
@@ -383,4 +410,9 @@ U_BOOT_CMD (fpga, 6, 1, do_fpga,
 	"\tFor loadmk operating on FIT format uImage address must include\n"
 	"\tsubimage unit name in the form of addr:<subimg_uname>"
 #endif
+#if defined(CONFIG_FPGA_GZIP)
+	"\n"
+	"\tload, loadb and loadmk also take gzip compressed data, which\n"
+	"\tis unpacked on the way to the device"
+#endif
 );
@@ -0,0 +1,123 @@
+/*
+ * Message digests of memory with any built-in algorithm
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <hash.h>
+
+static void hash_to_str(const u8 *digest, int size, char *str)
+{
+	int i;
+
+	for (i = 0; i < size; i++)
+		sprintf(str + 2 * i, "%02x", digest[i]);
+}
+
+/*
+ * The digest to verify against: in memory at *addr, given in hex, or
+ * in hex in the environment variable of that name.
+ */
+static int hash_parse_expected(const char *arg, u8 *digest, int size)
+{
+	char byte[3] = { 0 };
+	const char *s;
+	char *end;
+	int i;
+
+	if (*arg == '*') {
+		memcpy(digest,
+		       (void *)simple_strtoul(arg + 1, NULL, 16), size);
+		return 0;
+	}
+
+	s = arg;
+	if (strlen(s) != 2 * size) {
+		s = getenv(arg);
+		if (!s || strlen(s) != 2 * size)
+			return -1;
+	}
+
+	for (i = 0; i < size; i++) {
+		byte[0] = s[2 * i];
+		byte[1] = s[2 * i + 1];
+		digest[i] = simple_strtoul(byte, &end, 16);
+		if (*end)
+			return -1;
+	}
+	return 0;
+}
+
+static int do_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	u8 digest[HASH_MAX_DIGEST_SIZE], expected[HASH_MAX_DIGEST_SIZE];
+	char str[2 * HASH_MAX_DIGEST_SIZE + 1];
+	struct hash_algo *algo;
+	ulong addr, len;
+	int verify = 0;
+
+	if (argc > 1 && !strcmp(argv[1], "-v")) {
+		verify = 1;
+		argc--;
+		argv++;
+	}
+	if (argc < 4 || argc > 5 || (verify && argc != 5))
+		return cmd_usage(cmdtp);
+
+	algo = hash_lookup_algo(argv[1]);
+	if (!algo) {
+		printf("Unknown hash algorithm '%s', have: ", argv[1]);
+		hash_show_algos();
+		putc('\n');
+		return 1;
+	}
+
+	addr = simple_strtoul(argv[2], NULL, 16);
+	len = simple_strtoul(argv[3], NULL, 16);
+
+	algo->hash_func_ws((const unsigned char *)addr, len, digest,
+			   algo->chunk_size);
+	hash_to_str(digest, algo->digest_size, str);
+
+	if (verify) {
+		if (hash_parse_expected(argv[4], expected, algo->digest_size)) {
+			printf("Bad %s digest '%s'\n", algo->name, argv[4]);
+			return 1;
+		}
+		if (memcmp(digest, expected, algo->digest_size)) {
+			printf("%s for %08lx ... %08lx ==> %s ** ERROR **\n",
+			       algo->name, addr, addr + len - 1, str);
+			return 1;
+		}
+		return 0;
+	}
+
+	printf("%s for %08lx ... %08lx ==> %s\n",
+	       algo->name, addr, addr + len - 1, str);
+
+	if (argc == 5) {
+		if (*argv[4] == '*')
+			memcpy((void *)simple_strtoul(argv[4] + 1, NULL, 16),
+			       digest, algo->digest_size);
+		else
+			setenv(argv[4], str);
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	hash,	6,	1,	do_hash,
+	"compute or verify a message digest",
+	"algorithm address count [[*]dest]\n"
+	"    - print the digest, store it at *dest or in env variable dest\n"
+	"hash -v algorithm address count [*]sum\n"
+	"    - verify the digest against the one at *sum, the hex string\n"
+	"      sum, or the one in env variable sum\n"
+	"algorithm: sha1, sha256, md5 or crc32 as configured"
+);
@@ -48,6 +48,10 @@
 
 #include <ide.h>
 #include <ata.h>
+#include <ata_bmdma.h>
+#include <blkcache.h>
+#include <blkstats.h>
+#include <probe.h>
 
 #ifdef CONFIG_STATUS_LED
 # include <status_led.h>
@@ -121,6 +125,17 @@ ulong ide_bus_offset[CONFIG_SYS_IDE_MAXBUS] = {
 
 static int ide_bus_ok[CONFIG_SYS_IDE_MAXBUS];
 
+#ifdef CONFIG_ATA_BMDMA
+/* Bus master DMA registers of each bus, set by ide_preinit(); 0 = PIO only */
+ulong ide_bmdma_base[CONFIG_SYS_IDE_MAXBUS];
+
+/* UDMA mode the device has been switched to, -1 for PIO */
+static int ide_udma[CONFIG_SYS_IDE_MAXDEVICE];
+
+#define IDE_SETF_XFER		0x03	/* Set Features: transfer mode	*/
+#define IDE_XFER_UDMA(mode)	(0x40 | (mode))
+#endif
+
 block_dev_desc_t ide_dev_desc[CONFIG_SYS_IDE_MAXDEVICE];
 /* ------------------------------------------------------------------------- */
 
@@ -145,6 +160,16 @@ static void  ide_reset (void);
 
 static void  ide_ident (block_dev_desc_t *dev_desc);
 static uchar ide_wait  (int dev, ulong t);
+static int   ide_init_start(void);
+static int   ide_init_finish(void);
+
+/* the drives spin up while the rest of the board comes up */
+static struct probe_defer ide_probe = PROBE_DEFER_INIT("IDE", ide_init_finish);
+#ifdef CONFIG_ATA_BMDMA
+static void  ide_dma_init (int device, const hd_driveid_t *id);
+static ulong ide_dma_read (int device, lbaint_t blknr, ulong blkcnt,
+			   void *buffer, int pwrsave);
+#endif
 
 #define IDE_TIME_OUT	2000	/* 2 sec timeout */
 
@@ -176,6 +201,8 @@ int do_ide(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 {
 	int rcode = 0;
 
+	probe_finish(&ide_probe);
+
 	switch (argc) {
 	case 0:
 	case 1:
@@ -188,7 +215,8 @@ int do_ide(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 #endif
 			     ": ");
 
-			ide_init();
+			if (!ide_init_start())
+				ide_init_finish();
 			return 0;
 		} else if (strncmp(argv[1], "inf", 3) == 0) {
 			int i;
@@ -345,7 +373,9 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	const void *fit_hdr = NULL;
 #endif
 
-	show_boot_progress(41);
+	probe_finish(&ide_probe);
+
+	bootstage_mark(41);
 	switch (argc) {
 	case 1:
 		addr = CONFIG_SYS_LOAD_ADDR;
@@ -360,41 +390,41 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		boot_device = argv[2];
 		break;
 	default:
-		show_boot_progress(-42);
+		bootstage_mark(-42);
 		return cmd_usage(cmdtp);
 	}
-	show_boot_progress(42);
+	bootstage_mark(42);
 
 	if (!boot_device) {
 		puts("\n** No boot device **\n");
-		show_boot_progress(-43);
+		bootstage_mark(-43);
 		return 1;
 	}
-	show_boot_progress(43);
+	bootstage_mark(43);
 
 	dev = simple_strtoul(boot_device, &ep, 16);
 
 	if (ide_dev_desc[dev].type == DEV_TYPE_UNKNOWN) {
 		printf("\n** Device %d not available\n", dev);
-		show_boot_progress(-44);
+		bootstage_mark(-44);
 		return 1;
 	}
-	show_boot_progress(44);
+	bootstage_mark(44);
 
 	if (*ep) {
 		if (*ep != ':') {
 			puts("\n** Invalid boot device, use `dev[:part]' **\n");
-			show_boot_progress(-45);
+			bootstage_mark(-45);
 			return 1;
 		}
 		part = simple_strtoul(++ep, NULL, 16);
 	}
-	show_boot_progress(45);
+	bootstage_mark(45);
 	if (get_partition_info(&ide_dev_desc[dev], part, &info)) {
-		show_boot_progress(-46);
+		bootstage_mark(-46);
 		return 1;
 	}
-	show_boot_progress(46);
+	bootstage_mark(46);
 	if ((strncmp((char *)info.type, BOOT_PART_TYPE, sizeof(info.type)) != 0)
 	    &&
 	    (strncmp((char *)info.type, BOOT_PART_COMP, sizeof(info.type)) != 0)
@@ -402,10 +432,10 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		printf("\n** Invalid partition type \"%.32s\"" " (expect \""
 			BOOT_PART_TYPE "\")\n",
 			info.type);
-		show_boot_progress(-47);
+		bootstage_mark(-47);
 		return 1;
 	}
-	show_boot_progress(47);
+	bootstage_mark(47);
 
 	printf("\nLoading from IDE device %d, partition %d: "
 	       "Name: %.32s  Type: %.32s\n", dev, part, info.name, info.type);
@@ -416,23 +446,23 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	if (ide_dev_desc[dev].
 	    block_read(dev, info.start, 1, (ulong *) addr) != 1) {
 		printf("** Read error on %d:%d\n", dev, part);
-		show_boot_progress(-48);
+		bootstage_mark(-48);
 		return 1;
 	}
-	show_boot_progress(48);
+	bootstage_mark(48);
 
 	switch (genimg_get_format((void *) addr)) {
 	case IMAGE_FORMAT_LEGACY:
 		hdr = (image_header_t *) addr;
 
-		show_boot_progress(49);
+		bootstage_mark(49);
 
 		if (!image_check_hcrc(hdr)) {
 			puts("\n** Bad Header Checksum **\n");
-			show_boot_progress(-50);
+			bootstage_mark(-50);
 			return 1;
 		}
-		show_boot_progress(50);
+		bootstage_mark(50);
 
 		image_print_contents(hdr);
 
@@ -447,7 +477,7 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		break;
 #endif
 	default:
-		show_boot_progress(-49);
+		bootstage_mark(-49);
 		puts("** Unknown image type\n");
 		return 1;
 	}
@@ -459,20 +489,20 @@ int do_diskboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	if (ide_dev_desc[dev].block_read(dev, info.start + 1, cnt,
 					 (ulong *)(addr + info.blksz)) != cnt) {
 		printf("** Read error on %d:%d\n", dev, part);
-		show_boot_progress(-51);
+		bootstage_mark(-51);
 		return 1;
 	}
-	show_boot_progress(51);
+	bootstage_mark(51);
 
 #if defined(CONFIG_FIT)
 	/* This cannot be done earlier, we need complete FIT image in RAM first */
 	if (genimg_get_format((void *) addr) == IMAGE_FORMAT_FIT) {
 		if (!fit_check_format(fit_hdr)) {
-			show_boot_progress(-140);
+			bootstage_mark(-140);
 			puts("** Bad FIT image format\n");
 			return 1;
 		}
-		show_boot_progress(141);
+		bootstage_mark(141);
 		fit_print_contents(fit_hdr);
 	}
 #endif
@@ -537,18 +567,28 @@ inline int ide_set_piomode(int pio_mode)
 	__attribute__ ((weak, alias("__ide_set_piomode")));
 #endif
 
-void ide_init(void)
+#ifdef CONFIG_ATA_BMDMA
+/*
+ * Set up the controller timing for the fastest UDMA mode it shares with
+ * the drive and return that mode, or -1 to stay with PIO.
+ */
+int __ide_set_udma(int dev, const hd_driveid_t *id)
+{
+	return -1;
+}
+
+int ide_set_udma(int dev, const hd_driveid_t *id)
+	__attribute__ ((weak, alias("__ide_set_udma")));
+#endif
+
+/* Reset the buses; the drives then take up to ATA_RESET_TIME to be ready */
+static int ide_init_start(void)
 {
 
 #ifdef CONFIG_IDE_8xx_DIRECT
 	volatile immap_t *immr = (immap_t *) CONFIG_SYS_IMMR;
 	volatile pcmconf8xx_t *pcmp = &(immr->im_pcmcia);
-#endif
-	unsigned char c;
-	int i, bus;
-
-#if defined(CONFIG_SC3)
-	unsigned int ata_reset_time = ATA_RESET_TIME;
+	int i;
 #endif
 #ifdef CONFIG_IDE_8xx_PCCARD
 	extern int pcmcia_on(void);
@@ -562,7 +602,7 @@ void ide_init(void)
 
 	if (ide_preinit()) {
 		puts("ide_preinit failed\n");
-		return;
+		return -1;
 	}
 #endif /* CONFIG_IDE_PREINIT */
 
@@ -576,7 +616,7 @@ void ide_init(void)
 	/* initialize the PCMCIA IDE adapter card */
 	pcmcia_on();
 	if (!ide_devices_found)
-		return;
+		return -1;
 	udelay(1000000);	/* 1 s */
 #endif /* CONFIG_IDE_8xx_PCCARD */
 
@@ -618,6 +658,32 @@ void ide_init(void)
 	set_pcmcia_timing(pio_mode);
 #endif /* CONFIG_IDE_8xx_DIRECT */
 
+	return 0;
+}
+
+void ide_init(void)
+{
+	if (ide_init_start())
+		return;
+
+	probe_defer(&ide_probe);
+	if (probe_pending(&ide_probe))
+		puts("deferred\n");
+}
+
+/* Wait for the drives to come out of reset and identify them */
+static int ide_init_finish(void)
+{
+	unsigned char c;
+	int i, bus;
+
+#if defined(CONFIG_SC3)
+	unsigned int ata_reset_time = ATA_RESET_TIME;
+#endif
+#ifdef CONFIG_IDE_8xx_PCCARD
+	extern int ide_devices_found;	/* Initialized in check_ide_device() */
+#endif
+
 	/*
 	 * Wait for IDE to get ready.
 	 * According to spec, this can take up to 31 seconds!
@@ -657,7 +723,7 @@ void ide_init(void)
 				puts("** Timeout **\n");
 				/* LED's off */
 				ide_led((LED_IDE1 | LED_IDE2), 0);
-				return;
+				return -1;
 			}
 			if ((i >= 100) && ((i % 100) == 0))
 				putc('.');
@@ -688,6 +754,7 @@ void ide_init(void)
 #ifdef CONFIG_IDE_LED
 		int led = (IDE_BUS(i) == 0) ? LED_IDE1 : LED_IDE2;
 #endif
+		dev_invalidate(IF_TYPE_IDE, i);
 		ide_dev_desc[i].type = DEV_TYPE_UNKNOWN;
 		ide_dev_desc[i].if_type = IF_TYPE_IDE;
 		ide_dev_desc[i].dev = i;
@@ -711,6 +778,7 @@ void ide_init(void)
 		}
 	}
 	WATCHDOG_RESET();
+	return 0;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -718,6 +786,7 @@ void ide_init(void)
 #ifdef CONFIG_PARTITIONS
 block_dev_desc_t *ide_get_dev(int dev)
 {
+	probe_finish(&ide_probe);
 	return (dev < CONFIG_SYS_IDE_MAXDEVICE) ? &ide_dev_desc[dev] : NULL;
 }
 #endif
@@ -998,6 +1067,9 @@ static void ide_ident(block_dev_desc_t *dev_desc)
 
 	device = dev_desc->dev;
 	printf("  Device %d: ", device);
+#ifdef CONFIG_ATA_BMDMA
+	ide_udma[device] = -1;
+#endif
 
 	ide_led(DEVICE_LED(device), 1);	/* LED on       */
 	/* Select device
@@ -1204,6 +1276,11 @@ static void ide_ident(block_dev_desc_t *dev_desc)
 	dev_desc->blksz = ATA_BLOCKSIZE;
 	dev_desc->lun = 0;	/* just to fill something in... */
 
+#ifdef CONFIG_ATA_BMDMA
+	if (ide_bmdma_base[IDE_BUS(device)])
+		ide_dma_init(device, &iop);
+#endif
+
 #if 0				/* only used to test the powersaving mode,
 				 * if enabled, the drive goes after 5 sec
 				 * in standby mode */
@@ -1228,6 +1305,9 @@ ulong ide_read(int device, lbaint_t blknr, ulong blkcnt, void *buffer)
 	ulong n = 0;
 	unsigned char c;
 	unsigned char pwrsave = 0;	/* power save */
+	lbaint_t first = blknr;
+	void *buf = buffer;
+	unsigned long long t;
 
 #ifdef CONFIG_LBA48
 	unsigned char lba48 = 0;
@@ -1240,6 +1320,12 @@ ulong ide_read(int device, lbaint_t blknr, ulong blkcnt, void *buffer)
 	debug("ide_read dev %d start %lX, blocks %lX buffer at %lX\n",
 	      device, blknr, blkcnt, (ulong) buffer);
 
+	if (blkcache_read(IF_TYPE_IDE, device, blknr, blkcnt, ATA_BLOCKSIZE,
+			  buffer) ||
+	    blkcache_readahead(&ide_dev_desc[device], blknr, blkcnt, buffer))
+		return blkcnt;
+
+	t = blkstats_start();
 	ide_led(DEVICE_LED(device), 1);	/* LED on       */
 
 	/* Select device
@@ -1272,6 +1358,19 @@ ulong ide_read(int device, lbaint_t blknr, ulong blkcnt, void *buffer)
 			pwrsave = 1;
 	}
 
+#ifdef CONFIG_ATA_BMDMA
+	if (ide_udma[device] >= 0) {
+		ulong done = ide_dma_read(device, blknr, blkcnt, buffer,
+					  pwrsave);
+
+		/* anything left over is read by PIO below */
+		n += done;
+		blknr += done;
+		blkcnt -= done;
+		buffer += done * ATA_BLOCKSIZE;
+		pwrsave = 0;
+	}
+#endif
 
 	while (blkcnt-- > 0) {
 
@@ -1346,16 +1445,137 @@ ulong ide_read(int device, lbaint_t blknr, ulong blkcnt, void *buffer)
 	}
 IDE_READ_E:
 	ide_led(DEVICE_LED(device), 0);	/* LED off      */
+	blkstats_end(IF_TYPE_IDE, device, BLKSTATS_READ, n * ATA_BLOCKSIZE, t);
+	blkcache_fill(IF_TYPE_IDE, device, first, n, ATA_BLOCKSIZE, buf);
 	return (n);
 }
 
 /* ------------------------------------------------------------------------- */
 
+#ifdef CONFIG_ATA_BMDMA
+static void ide_dma_init(int device, const hd_driveid_t *id)
+{
+	int mode;
+	uchar c;
+
+	mode = ide_set_udma(device, id);
+	if (mode < 0)
+		return;
+
+	ide_outb(device, ATA_DEV_HD, ATA_LBA | ATA_DEVICE(device));
+	c = ide_wait(device, IDE_TIME_OUT);
+	if (c & ATA_STAT_BUSY)
+		return;
+
+	ide_outb(device, ATA_ERROR_REG, IDE_SETF_XFER);
+	ide_outb(device, ATA_SECT_CNT, IDE_XFER_UDMA(mode));
+	ide_outb(device, ATA_LBA_LOW, 0);
+	ide_outb(device, ATA_LBA_MID, 0);
+	ide_outb(device, ATA_LBA_HIGH, 0);
+	ide_outb(device, ATA_COMMAND, ATA_CMD_SETF);
+	udelay(50);
+
+	c = ide_wait(device, IDE_TIME_OUT);
+	if (c & (ATA_STAT_BUSY | ATA_STAT_ERR)) {
+		printf("UDMA%d rejected, status 0x%02x, using PIO ", mode, c);
+		return;
+	}
+
+	debug("device %d: UDMA%d\n", device, mode);
+	ide_udma[device] = mode;
+}
+
+/*
+ * Read with READ DMA (EXT), at most BMDMA_MAX_XFER bytes per command.
+ * Returns the number of blocks read; on an error DMA is switched off
+ * for the device and the caller reads the rest by PIO.
+ */
+static ulong ide_dma_read(int device, lbaint_t blknr, ulong blkcnt,
+			  void *buffer, int pwrsave)
+{
+	ulong base = ide_bmdma_base[IDE_BUS(device)];
+	ulong n = 0;
+	int lba48 = 0;
+	uchar c;
+	int err;
+
+#ifdef CONFIG_LBA48
+	lba48 = ide_dev_desc[device].lba48;
+#endif
+	while (n < blkcnt) {
+		ulong cnt = blkcnt - n;
+
+		if (cnt > BMDMA_MAX_XFER / ATA_BLOCKSIZE)
+			cnt = BMDMA_MAX_XFER / ATA_BLOCKSIZE;
+		if (!lba48 && cnt > 256)
+			cnt = 256;
+
+		c = ide_wait(device, IDE_TIME_OUT);
+		if (c & ATA_STAT_BUSY)
+			break;
+
+		if (ata_bmdma_setup(base, buffer, cnt * ATA_BLOCKSIZE))
+			break;
+
+#ifdef CONFIG_LBA48
+		if (lba48) {
+			/* write high bits */
+			ide_outb(device, ATA_SECT_CNT, (cnt >> 8) & 0xFF);
+			ide_outb(device, ATA_LBA_LOW, (blknr >> 24) & 0xFF);
+#ifdef CONFIG_SYS_64BIT_LBA
+			ide_outb(device, ATA_LBA_MID, (blknr >> 32) & 0xFF);
+			ide_outb(device, ATA_LBA_HIGH, (blknr >> 40) & 0xFF);
+#else
+			ide_outb(device, ATA_LBA_MID, 0);
+			ide_outb(device, ATA_LBA_HIGH, 0);
+#endif
+		}
+#endif
+		ide_outb(device, ATA_SECT_CNT, cnt & 0xFF);
+		ide_outb(device, ATA_LBA_LOW, (blknr >> 0) & 0xFF);
+		ide_outb(device, ATA_LBA_MID, (blknr >> 8) & 0xFF);
+		ide_outb(device, ATA_LBA_HIGH, (blknr >> 16) & 0xFF);
+
+		if (lba48) {
+			ide_outb(device, ATA_DEV_HD,
+				 ATA_LBA | ATA_DEVICE(device));
+			ide_outb(device, ATA_COMMAND, ATA_CMD_RD_DMA_EXT);
+		} else {
+			ide_outb(device, ATA_DEV_HD, ATA_LBA |
+				 ATA_DEVICE(device) | ((blknr >> 24) & 0xF));
+			ide_outb(device, ATA_COMMAND, ATA_CMD_RD_DMA);
+		}
+		ata_bmdma_start(base);
+
+		err = ata_bmdma_wait(base, pwrsave ? IDE_SPIN_UP_TIME_OUT :
+				     IDE_TIME_OUT);
+		pwrsave = 0;
+
+		c = ide_wait(device, IDE_TIME_OUT);	/* clears IRQ */
+		if (err ||
+		    (c & (ATA_STAT_BUSY | ATA_STAT_DRQ | ATA_STAT_ERR))) {
+			printf("IDE DMA read error dev %d: status 0x%02x, "
+			       "using PIO\n", device, c);
+			ide_udma[device] = -1;
+			break;
+		}
+
+		n += cnt;
+		blknr += cnt;
+		buffer += cnt * ATA_BLOCKSIZE;
+	}
+	return n;
+}
+#endif /* CONFIG_ATA_BMDMA */
+
+/* ------------------------------------------------------------------------- */
+
 
 ulong ide_write(int device, lbaint_t blknr, ulong blkcnt, const void *buffer)
 {
 	ulong n = 0;
 	unsigned char c;
+	unsigned long long t;
 
 #ifdef CONFIG_LBA48
 	unsigned char lba48 = 0;
@@ -1366,6 +1586,9 @@ ulong ide_write(int device, lbaint_t blknr, ulong blkcnt, const void *buffer)
 	}
 #endif
 
+	dev_invalidate(IF_TYPE_IDE, device);
+
+	t = blkstats_start();
 	ide_led(DEVICE_LED(device), 1);	/* LED on       */
 
 	/* Select device
@@ -1438,6 +1661,7 @@ ulong ide_write(int device, lbaint_t blknr, ulong blkcnt, const void *buffer)
 	}
 WR_OUT:
 	ide_led(DEVICE_LED(device), 0);	/* LED off      */
+	blkstats_end(IF_TYPE_IDE, device, BLKSTATS_WRITE, n * ATA_BLOCKSIZE, t);
 	return (n);
 }
 
@@ -1601,6 +1825,7 @@ int ide_device_present(int dev)
 {
 	if (dev >= CONFIG_SYS_IDE_MAXBUS)
 		return 0;
+	probe_finish(&ide_probe);
 	return (ide_dev_desc[dev].type == DEV_TYPE_UNKNOWN ? 0 : 1);
 }
 #endif
@@ -34,7 +34,7 @@
 DECLARE_GLOBAL_DATA_PTR;
 
 #if defined(CONFIG_CMD_LOADB)
-static ulong load_serial_ymodem (ulong offset);
+static ulong load_serial_ymodem (ulong offset, int mode);
 #endif
 
 #if defined(CONFIG_CMD_LOADS)
@@ -439,6 +439,7 @@ int do_load_serial_bin (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[
 	ulong addr;
 	int load_baudrate, current_baudrate;
 	int rcode = 0;
+	int ymodem;
 	char *s;
 
 	/* pre-set offset from CONFIG_SYS_LOAD_ADDR */
@@ -462,26 +463,38 @@ int do_load_serial_bin (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[
 			load_baudrate = current_baudrate;
 	}
 
+	ymodem = strncmp(argv[0], "loady", 5) == 0;
+
 	if (load_baudrate != current_baudrate) {
-		printf ("## Switch baudrate to %d bps and press ENTER ...\n",
-			load_baudrate);
+		printf ("## Switch baudrate to %d bps and %s ...\n",
+			load_baudrate,
+			ymodem ? "start the transfer" : "press ENTER");
 		udelay(50000);
 		gd->baudrate = load_baudrate;
 		serial_setbrg ();
 		udelay(50000);
-		for (;;) {
+		/*
+		 * The ymodem receiver keeps asking for the first block
+		 * until the sender has switched, too; the first good
+		 * block confirms the new rate.
+		 */
+		while (!ymodem) {
 			if (getc() == '\r')
 				break;
 		}
 	}
 
-	if (strcmp(argv[0],"loady")==0) {
-		printf ("## Ready for binary (ymodem) download "
+	if (ymodem) {
+		int mode = strcmp(argv[0], "loadyg") == 0 ?
+			xyzModem_ymodem_g : xyzModem_ymodem;
+
+		printf ("## Ready for binary (ymodem%s) download "
 			"to 0x%08lX at %d bps...\n",
+			mode == xyzModem_ymodem_g ? "-g" : "",
 			offset,
 			load_baudrate);
 
-		addr = load_serial_ymodem (offset);
+		addr = load_serial_ymodem (offset, mode);
 
 	} else {
 
@@ -963,11 +976,11 @@ static int getcxmodem(void) {
 		return (getc());
 	return -1;
 }
-static ulong load_serial_ymodem (ulong offset)
+static ulong load_serial_ymodem (ulong offset, int mode)
 {
 	int size;
 	char buf[32];
-	int err;
+	int err = 0;
 	int res;
 	connection_info_t info;
 	char ymodemBuf[1024];
@@ -975,17 +988,29 @@ static ulong load_serial_ymodem (ulong offset)
 	ulong addr = 0;
 
 	size = 0;
-	info.mode = xyzModem_ymodem;
+	info.mode = mode;
 	res = xyzModem_stream_open (&info, &err);
 	if (!res) {
 
-		while ((res =
-			xyzModem_stream_read (ymodemBuf, 1024, &err)) > 0) {
+		do {
+			char *dst;
+
 			store_addr = addr + offset;
+			/* RAM gets the data without bouncing them */
+			dst = (char *)store_addr;
+#ifndef CONFIG_SYS_NO_FLASH
+			if (addr2info (store_addr) ||
+			    addr2info (store_addr + sizeof(ymodemBuf) - 1))
+				dst = ymodemBuf;
+#endif
+			res = xyzModem_stream_read (dst, sizeof(ymodemBuf),
+						    &err);
+			if (res <= 0)
+				break;
 			size += res;
 			addr += res;
 #ifndef CONFIG_SYS_NO_FLASH
-			if (addr2info (store_addr)) {
+			if (dst == ymodemBuf) {
 				int rc;
 
 				rc = flash_write ((char *) ymodemBuf,
@@ -994,13 +1019,13 @@ static ulong load_serial_ymodem (ulong offset)
 					flash_perror (rc);
 					return (~0);
 				}
-			} else
-#endif
-			{
-				memcpy ((char *) (store_addr), ymodemBuf,
-					res);
 			}
+#endif
+		} while (1);
 
+		if (err && err != xyzModem_eof) {
+			printf ("%s\n", xyzModem_error (err));
+			xyzModem_stream_terminate (true, &getcxmodem);
 		}
 	} else {
 		printf ("%s\n", xyzModem_error (err));
@@ -1086,6 +1111,15 @@ U_BOOT_CMD(
 	" with offset 'off' and baudrate 'baud'"
 );
 
+U_BOOT_CMD(
+	loadyg, 3, 0,	do_load_serial_bin,
+	"load binary file over serial line (ymodem-g mode)",
+	"[ off ] [ baud ]\n"
+	"    - load binary file over serial line"
+	" with offset 'off' and baudrate 'baud',\n"
+	"      streamed without acks (the line must be error free)"
+);
+
 #endif
 
 /* -------------------------------------------------------------------- */
@@ -0,0 +1,32 @@
+/*
+ * Show how much of the malloc arena is in use, to help size
+ * CONFIG_SYS_MALLOC_LEN and the object pools
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <mem_pool.h>
+#include <ext2fs.h>
+
+static int do_mallinfo(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	malloc_stats();
+
+#if defined(CONFIG_MEM_POOL) && defined(CONFIG_CMD_EXT2)
+	mem_pool_stats("ext2 nodes", &ext2fs_node_pool);
+#endif
+	return 0;
+}
+
+U_BOOT_CMD(
+	mallinfo,	1,	1,	do_mallinfo,
+	"show malloc arena usage",
+	""
+);
@@ -33,6 +33,12 @@
 #include <dataflash.h>
 #endif
 #include <watchdog.h>
+#include <load_hash.h>
+#include <dma.h>
+#include <div64.h>
+#ifdef CONFIG_SYS_MEMTEST_FAST
+#include <mp_job.h>
+#endif
 
 #ifdef	CMD_MEM_DEBUG
 #define	PRINTF(fmt,args...)	printf (fmt ,##args)
@@ -191,6 +197,9 @@ int do_mem_mw ( cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		count = 1;
 	}
 
+	/* a CRC recorded while loading would no longer be valid */
+	load_hash_invalidate();
+
 	while (count-- > 0) {
 		if (size == 4)
 			*((ulong  *)addr) = (ulong )writeval;
@@ -259,9 +268,53 @@ int do_mem_mwc ( cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 }
 #endif /* CONFIG_MX_CYCLIC */
 
+/* Throughput of the long runs, short ones are not worth a line */
+static void mem_print_rate(ulong bytes, ulong start)
+{
+	ulong ms = get_timer(start);
+
+	if (ms >= 1000)
+		printf("%lu KiB in %lu ms, %lu MB/s\n", bytes >> 10, ms,
+		       (ulong)(lldiv((u64)bytes * 1000, ms) >> 20));
+}
+
+/*
+ * Returns the number of leading elements that are the same.  The data
+ * is compared with memcmp() in chunks; only the chunk that differs is
+ * gone through element by element, in the bus width asked for.
+ */
+static ulong mem_cmp_same(ulong addr1, ulong addr2, int size, ulong count)
+{
+	ulong n, same = 0;
+
+	while (same < count) {
+		n = min(count - same, (ulong)(CHUNKSZ / size));
+		if (memcmp((void *)(addr1 + same * size),
+			   (void *)(addr2 + same * size), n * size))
+			break;
+		same += n;
+		WATCHDOG_RESET();
+	}
+
+	addr1 += same * size;
+	addr2 += same * size;
+	for (; same < count; same++, addr1 += size, addr2 += size) {
+		if (size == 4) {
+			if (*(ulong *)addr1 != *(ulong *)addr2)
+				break;
+		} else if (size == 2) {
+			if (*(ushort *)addr1 != *(ushort *)addr2)
+				break;
+		} else if (*(u_char *)addr1 != *(u_char *)addr2) {
+			break;
+		}
+	}
+	return same;
+}
+
 int do_mem_cmp (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	ulong	addr1, addr2, count, ngood;
+	ulong	addr1, addr2, count, ngood, start;
 	int	size;
 	int     rcode = 0;
 
@@ -295,54 +348,32 @@ int do_mem_cmp (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	}
 #endif
 
-	ngood = 0;
+	start = get_timer(0);
+	ngood = mem_cmp_same(addr1, addr2, size, count);
+	addr1 += ngood * size;
+	addr2 += ngood * size;
 
-	while (count-- > 0) {
+	if (ngood < count) {
 		if (size == 4) {
-			ulong word1 = *(ulong *)addr1;
-			ulong word2 = *(ulong *)addr2;
-			if (word1 != word2) {
-				printf("word at 0x%08lx (0x%08lx) "
-					"!= word at 0x%08lx (0x%08lx)\n",
-					addr1, word1, addr2, word2);
-				rcode = 1;
-				break;
-			}
+			printf("word at 0x%08lx (0x%08lx) "
+				"!= word at 0x%08lx (0x%08lx)\n",
+				addr1, *(ulong *)addr1, addr2, *(ulong *)addr2);
+		} else if (size == 2) {
+			printf("halfword at 0x%08lx (0x%04x) "
+				"!= halfword at 0x%08lx (0x%04x)\n",
+				addr1, *(ushort *)addr1, addr2, *(ushort *)addr2);
+		} else {
+			printf("byte at 0x%08lx (0x%02x) "
+				"!= byte at 0x%08lx (0x%02x)\n",
+				addr1, *(u_char *)addr1, addr2, *(u_char *)addr2);
 		}
-		else if (size == 2) {
-			ushort hword1 = *(ushort *)addr1;
-			ushort hword2 = *(ushort *)addr2;
-			if (hword1 != hword2) {
-				printf("halfword at 0x%08lx (0x%04x) "
-					"!= halfword at 0x%08lx (0x%04x)\n",
-					addr1, hword1, addr2, hword2);
-				rcode = 1;
-				break;
-			}
-		}
-		else {
-			u_char byte1 = *(u_char *)addr1;
-			u_char byte2 = *(u_char *)addr2;
-			if (byte1 != byte2) {
-				printf("byte at 0x%08lx (0x%02x) "
-					"!= byte at 0x%08lx (0x%02x)\n",
-					addr1, byte1, addr2, byte2);
-				rcode = 1;
-				break;
-			}
-		}
-		ngood++;
-		addr1 += size;
-		addr2 += size;
-
-		/* reset watchdog from time to time */
-		if ((count % (64 << 10)) == 0)
-			WATCHDOG_RESET();
+		rcode = 1;
 	}
 
 	printf("Total of %ld %s%s were the same\n",
 		ngood, size == 4 ? "word" : size == 2 ? "halfword" : "byte",
 		ngood == 1 ? "" : "s");
+	mem_print_rate(ngood * size, start);
 	return rcode;
 }
 
@@ -372,6 +403,8 @@ int do_mem_cp ( cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return 1;
 	}
 
+	load_hash_invalidate();
+
 #ifndef CONFIG_SYS_NO_FLASH
 	/* check if we are copying to Flash */
 	if ( (addr2info(dest) != NULL)
@@ -439,6 +472,10 @@ int do_mem_cp ( cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	}
 #endif
 
+	/* the engine copies bytes, so this is fine for any size */
+	if (dma_memcpy((void *)dest, (void *)addr, count * size) == 0)
+		return 0;
+
 	while (count-- > 0) {
 		if (size == 4)
 			*((ulong  *)dest) = *((ulong  *)addr);
@@ -610,6 +647,307 @@ int do_mem_loopw (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 }
 #endif /* CONFIG_LOOPW */
 
+#ifdef CONFIG_SYS_MEMTEST_FAST
+/*
+ * Fast memory test: "mtest -f".
+ *
+ * The range is worked through in blocks, which are handed to the
+ * secondary cores when there are any (CONFIG_MP_JOBS), and tested by
+ * the boot core otherwise; ctrl-C, the watchdog and the error reports
+ * are taken care of between the blocks.  The words are 64 bits wide
+ * and are read and written a cache line at a time, with the caches
+ * on, so the blocks should be well beyond the size of the caches.
+ *
+ * Each iteration runs:
+ *  - an address test: every word of the whole range is written with
+ *    its address, then all are read back, which finds aliasing;
+ *  - March C- on each block, on a background that changes from one
+ *    iteration to the next;
+ *  - moving inversions on each block, walking a one bit through the
+ *    64 bits over the iterations.
+ */
+#ifndef CONFIG_SYS_MEMTEST_FAST_BLOCK
+#define CONFIG_SYS_MEMTEST_FAST_BLOCK	(4 << 20)
+#endif
+
+#if defined(CONFIG_MP_JOBS) && defined(CONFIG_SYS_MP_JOB_CPUS)
+#define MTEST_JOBS	CONFIG_SYS_MP_JOB_CPUS
+#elif defined(CONFIG_MP_JOBS) && defined(CONFIG_MAX_CPUS)
+#define MTEST_JOBS	CONFIG_MAX_CPUS
+#else
+#define MTEST_JOBS	1
+#endif
+
+#define MTEST_LINE	64		/* bytes handled in one go */
+
+enum {
+	MTEST_ADDR_FILL,
+	MTEST_ADDR_CHECK,
+	MTEST_MARCH,
+	MTEST_MOVINV,
+};
+
+struct mtest_block {
+	struct mp_job	job;		/* arg[0] start, arg[1] end, arg[2] test */
+	u64		pattern;
+	/* the first bad word */
+	ulong		bad;
+	u64		expected, actual;
+};
+
+static void mtest_bad(struct mtest_block *b, volatile u64 *p, u64 expected,
+		      u64 actual)
+{
+	if (!b->job.result++) {
+		b->bad = (ulong)p;
+		b->expected = expected;
+		b->actual = actual;
+	}
+}
+
+/* The value the address test writes to p */
+static inline u64 mtest_addr(volatile u64 *p)
+{
+	ulong a = (ulong)p;
+
+	return ((u64)~a << 32) | a;
+}
+
+static void mtest_fill(volatile u64 *p, volatile u64 *end, u64 v)
+{
+	for (; p < end; p += 8) {
+		p[0] = v; p[1] = v; p[2] = v; p[3] = v;
+		p[4] = v; p[5] = v; p[6] = v; p[7] = v;
+	}
+}
+
+/* Check a line for v, one word at a time if it does not match */
+static inline void mtest_line(struct mtest_block *b, volatile u64 *p, u64 v)
+{
+	u64 w[8], diff = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		w[i] = p[i];
+		diff |= w[i] ^ v;
+	}
+	if (diff)
+		for (i = 0; i < 8; i++)
+			if (w[i] != v)
+				mtest_bad(b, &p[i], v, w[i]);
+}
+
+/* Read r from every word and write w, upwards or downwards */
+static void mtest_rw(struct mtest_block *b, volatile u64 *start,
+		     volatile u64 *end, u64 r, u64 w, int down)
+{
+	volatile u64 *p;
+
+	if (!down) {
+		for (p = start; p < end; p += 8) {
+			mtest_line(b, p, r);
+			mtest_fill(p, p + 8, w);
+		}
+	} else {
+		for (p = end; p > start; ) {
+			p -= 8;
+			mtest_line(b, p, r);
+			mtest_fill(p, p + 8, w);
+		}
+	}
+}
+
+static void mtest_check(struct mtest_block *b, volatile u64 *p,
+			volatile u64 *end, u64 v)
+{
+	for (; p < end; p += 8)
+		mtest_line(b, p, v);
+}
+
+/* A job: test one block */
+static void mtest_block_run(struct mp_job *job)
+{
+	struct mtest_block *b = (struct mtest_block *)job;
+	volatile u64 *start = (volatile u64 *)job->arg[0];
+	volatile u64 *end = (volatile u64 *)job->arg[1];
+	volatile u64 *p;
+	u64 v = b->pattern, w;
+	int i;
+
+	job->result = 0;
+
+	switch (job->arg[2]) {
+	case MTEST_ADDR_FILL:
+		for (p = start; p < end; p += 8)
+			for (i = 0; i < 8; i++)
+				p[i] = mtest_addr(&p[i]);
+		break;
+	case MTEST_ADDR_CHECK:
+		for (p = start; p < end; p++) {
+			w = *p;
+			if (w != mtest_addr(p))
+				mtest_bad(b, p, mtest_addr(p), w);
+		}
+		break;
+	case MTEST_MARCH:
+		mtest_fill(start, end, v);
+		mtest_rw(b, start, end, v, ~v, 0);
+		mtest_rw(b, start, end, ~v, v, 0);
+		mtest_rw(b, start, end, v, ~v, 1);
+		mtest_rw(b, start, end, ~v, v, 1);
+		mtest_check(b, start, end, v);
+		break;
+	case MTEST_MOVINV:
+		mtest_fill(start, end, v);
+		mtest_rw(b, start, end, v, ~v, 0);
+		mtest_rw(b, start, end, ~v, v, 1);
+		mtest_check(b, start, end, v);
+		break;
+	}
+}
+
+static struct mtest_block mtest_blocks[MTEST_JOBS];
+
+/*
+ * Run one test over [start, end) a block at a time.  Returns the
+ * number of bad words, or -1 if interrupted.
+ */
+static long mtest_fast_pass(ulong start, ulong end, int test, u64 pattern,
+			    const char *name)
+{
+	struct mtest_block *b;
+	long errs = 0;
+	ulong pos = start;
+	int n, i;
+
+	while (pos < end) {
+		/* one block for each free core, the last one for this one */
+		for (n = 0; n < MTEST_JOBS && pos < end; ) {
+			b = &mtest_blocks[n++];
+			b->job.func = mtest_block_run;
+			b->job.arg[0] = pos;
+			b->job.arg[1] = min(end - pos,
+				(ulong)CONFIG_SYS_MEMTEST_FAST_BLOCK) + pos;
+			b->job.arg[2] = test;
+			b->pattern = pattern;
+			pos = b->job.arg[1];
+
+			if (n == MTEST_JOBS || pos >= end ||
+			    mp_job_start(&b->job)) {
+				mtest_block_run(&b->job);
+				b->job.state = MP_JOB_DONE;
+				break;
+			}
+		}
+
+		for (i = 0; i < n; i++) {
+			b = &mtest_blocks[i];
+			if (!mp_job_wait(&b->job))
+				continue;
+			printf("\nFAILURE (%s) @ 0x%08lx: expected 0x%016llx, "
+			       "actual 0x%016llx, %ld bad in the block\n",
+			       name, b->bad, b->expected, b->actual,
+			       b->job.result);
+			errs += b->job.result;
+		}
+
+		WATCHDOG_RESET();
+		if (ctrlc())
+			return -1;
+	}
+	return errs;
+}
+
+static int mtest_fast(int argc, char * const argv[])
+{
+	static const u64 background[] = {
+		0x0000000000000000ULL,
+		0x5555555555555555ULL,
+		0x3333333333333333ULL,
+		0x0f0f0f0f0f0f0f0fULL,
+		0x00ff00ff00ff00ffULL,
+		0x0000ffff0000ffffULL,
+		0x00000000ffffffffULL,
+	};
+	static const struct {
+		const char	*name;
+		int		test;
+		int		accesses;	/* per word */
+	} tests[] = {
+		{ "address",		MTEST_ADDR_FILL,	2 },
+		{ "march C-",		MTEST_MARCH,		10 },
+		{ "moving inversions",	MTEST_MOVINV,		6 },
+	};
+	ulong start, end, ms, rate;
+	ulong errs = 0;
+	int iterations = 1;
+	int iteration_limit;
+	long ret;
+	u64 pattern;
+	ulong t;
+	int i;
+
+	if (argc > 1)
+		start = simple_strtoul(argv[1], NULL, 16);
+	else
+		start = CONFIG_SYS_MEMTEST_START;
+
+	if (argc > 2)
+		end = simple_strtoul(argv[2], NULL, 16);
+	else
+		end = CONFIG_SYS_MEMTEST_END;
+
+	if (argc > 3)
+		iteration_limit = simple_strtoul(argv[3], NULL, 16);
+	else
+		iteration_limit = 0;
+
+	start = (start + MTEST_LINE - 1) & ~(MTEST_LINE - 1);
+	end &= ~(MTEST_LINE - 1);
+	if (end <= start)
+		return 1;
+
+	printf("Testing %08lx ... %08lx:\n", start, end);
+
+	for (;;) {
+		if (iteration_limit && iterations > iteration_limit) {
+			printf("Tested %d iteration(s) with %lu errors.\n",
+				iterations - 1, errs);
+			return errs != 0;
+		}
+
+		printf("Iteration: %6d\n", iterations);
+
+		for (i = 0; i < ARRAY_SIZE(tests); i++) {
+			if (tests[i].test == MTEST_MARCH)
+				pattern = background[(iterations - 1) %
+						     ARRAY_SIZE(background)];
+			else
+				pattern = 1ULL << ((iterations - 1) % 64);
+
+			t = get_timer(0);
+			ret = mtest_fast_pass(start, end, tests[i].test,
+					      pattern, tests[i].name);
+			if (ret >= 0 && tests[i].test == MTEST_ADDR_FILL)
+				ret = mtest_fast_pass(start, end,
+					MTEST_ADDR_CHECK, 0, tests[i].name);
+			if (ret < 0) {
+				putc('\n');
+				return 1;
+			}
+			ms = get_timer(t);
+			errs += ret;
+
+			rate = lldiv((u64)(end - start) * tests[i].accesses,
+				     ms ? ms : 1) * 1000 >> 20;
+			printf("  %-18s %6lu MB/s%s\n", tests[i].name, rate,
+			       ret ? ", FAILED" : "");
+		}
+		iterations++;
+	}
+}
+#endif /* CONFIG_SYS_MEMTEST_FAST */
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -654,6 +992,11 @@ int do_mem_mtest (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	ulong	pattern;
 #endif
 
+#ifdef CONFIG_SYS_MEMTEST_FAST
+	if (argc > 1 && !strcmp(argv[1], "-f"))
+		return mtest_fast(argc - 1, argv + 1);
+#endif
+
 	if (argc > 1)
 		start = (ulong *)simple_strtoul(argv[1], NULL, 16);
 	else
@@ -1079,7 +1422,7 @@ mod_mem(cmd_tbl_t *cmdtp, int incrflag, int flag, int argc, char * const argv[])
 
 int do_mem_crc (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	ulong addr, length;
+	ulong addr, length, start;
 	ulong crc;
 	ulong *ptr;
 
@@ -1091,10 +1434,12 @@ int do_mem_crc (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	length = simple_strtoul (argv[2], NULL, 16);
 
+	start = get_timer(0);
 	crc = crc32_wd (0, (const uchar *) addr, length, CHUNKSZ_CRC32);
 
 	printf ("CRC32 for %08lx ... %08lx ==> %08lx\n",
 			addr, addr + length - 1, crc);
+	mem_print_rate(length, start);
 
 	if (argc > 3) {
 		ptr = (ulong *) simple_strtoul (argv[3], NULL, 16);
@@ -1108,7 +1453,7 @@ int do_mem_crc (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 int do_mem_crc (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	ulong addr, length;
+	ulong addr, length, start;
 	ulong crc;
 	ulong *ptr;
 	ulong vcrc;
@@ -1136,11 +1481,13 @@ usage:
 	addr += base_address;
 	length = simple_strtoul(*av++, NULL, 16);
 
+	start = get_timer(0);
 	crc = crc32_wd (0, (const uchar *) addr, length, CHUNKSZ_CRC32);
 
 	if (!verify) {
 		printf ("CRC32 for %08lx ... %08lx ==> %08lx\n",
 				addr, addr + length - 1, crc);
+		mem_print_rate(length, start);
 		if (ac > 2) {
 			ptr = (ulong *) simple_strtoul (*av++, NULL, 16);
 			*ptr = crc;
@@ -1248,6 +1595,10 @@ U_BOOT_CMD(
 	mtest,	5,	1,	do_mem_mtest,
 	"simple RAM read/write test",
 	"[start [end [pattern [iterations]]]]"
+#ifdef CONFIG_SYS_MEMTEST_FAST
+	"\nmtest -f [start [end [iterations]]]\n"
+	"    - fast test: address, March C- and moving inversions"
+#endif
 );
 
 #ifdef CONFIG_MX_CYCLIC
@@ -24,6 +24,7 @@
 #include <common.h>
 #include <command.h>
 #include <mmc.h>
+#include <load_hash.h>
 
 static int curr_device = -1;
 #ifndef CONFIG_GENERIC_MMC
@@ -91,7 +92,6 @@ enum mmc_state {
 	MMC_INVALID,
 	MMC_READ,
 	MMC_WRITE,
-	MMC_ERASE,
 };
 static void print_mmcinfo(struct mmc *mmc)
 {
@@ -112,7 +112,8 @@ static void print_mmcinfo(struct mmc *mmc)
 	puts("Capacity: ");
 	print_size(mmc->capacity, "\n");
 
-	printf("Bus Width: %d-bit\n", mmc->bus_width);
+	printf("Bus Width: %d-bit%s\n", mmc->bus_width,
+		mmc->timing == MMC_TIMING_MMC_DDR52 ? " DDR" : "");
 }
 
 int do_mmcinfo (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -148,6 +149,63 @@ U_BOOT_CMD(
 	""
 );
 
+/*
+ * mmc erase [-t|-d|-s|-S] blk# cnt | part <num> | all
+ */
+static int mmc_erase_cmd(int argc, char * const argv[])
+{
+	struct mmc *mmc = find_mmc_device(curr_device);
+	disk_partition_t info;
+	uint arg = MMC_ERASE_ARG;
+	ulong blk, cnt, n;
+
+	if (argc > 0 && argv[0][0] == '-') {
+		if (!strcmp(argv[0], "-t"))
+			arg = MMC_TRIM_ARG;
+		else if (!strcmp(argv[0], "-d"))
+			arg = MMC_DISCARD_ARG;
+		else if (!strcmp(argv[0], "-s"))
+			arg = MMC_SECURE_ERASE_ARG;
+		else if (!strcmp(argv[0], "-S"))
+			arg = MMC_SECURE_TRIM1_ARG;
+		else
+			return -1;
+		argc--;
+		argv++;
+	}
+
+	if (!mmc) {
+		printf("no mmc device at slot %x\n", curr_device);
+		return 1;
+	}
+	mmc_init(mmc);
+
+	if (argc == 1 && !strcmp(argv[0], "all")) {
+		blk = 0;
+		cnt = mmc->block_dev.lba;
+	} else if (argc == 2 && !strcmp(argv[0], "part")) {
+		if (get_partition_info(&mmc->block_dev,
+				       simple_strtoul(argv[1], NULL, 10),
+				       &info)) {
+			printf("no partition %s on mmc%d\n", argv[1],
+			       curr_device);
+			return 1;
+		}
+		blk = info.start;
+		cnt = info.size;
+	} else if (argc == 2) {
+		blk = simple_strtoul(argv[0], NULL, 16);
+		cnt = simple_strtoul(argv[1], NULL, 16);
+	} else
+		return -1;
+
+	printf("\nMMC erase: dev # %d, block # %ld, count %ld ... ",
+	       curr_device, blk, cnt);
+	n = mmc_erase_blocks(curr_device, blk, cnt, arg);
+	printf("%ld blocks erase: %s\n", n, (n == cnt) ? "OK" : "ERROR");
+	return (n == cnt) ? 0 : 1;
+}
+
 int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	enum mmc_state state;
@@ -249,14 +307,16 @@ int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 				curr_device, mmc->part_num);
 
 		return 0;
+	} else if (strcmp(argv[1], "erase") == 0) {
+		int ret = mmc_erase_cmd(argc - 2, argv + 2);
+
+		return ret < 0 ? cmd_usage(cmdtp) : ret;
 	}
 
 	if (strcmp(argv[1], "read") == 0)
 		state = MMC_READ;
 	else if (strcmp(argv[1], "write") == 0)
 		state = MMC_WRITE;
-	else if (strcmp(argv[1], "erase") == 0)
-		state = MMC_ERASE;
 	else
 		state = MMC_INVALID;
 
@@ -266,11 +326,10 @@ int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		u32 blk, cnt, n;
 		void *addr;
 
-		if (state != MMC_ERASE) {
-			addr = (void *)simple_strtoul(argv[idx], NULL, 16);
-			++idx;
-		} else
-			addr = 0;
+		if (argc != 5)
+			return cmd_usage(cmdtp);
+		addr = (void *)simple_strtoul(argv[idx], NULL, 16);
+		++idx;
 		blk = simple_strtoul(argv[idx], NULL, 16);
 		cnt = simple_strtoul(argv[idx + 1], NULL, 16);
 
@@ -286,18 +345,18 @@ int do_mmcops(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 		switch (state) {
 		case MMC_READ:
+			load_hash_start((ulong)addr);
 			n = mmc->block_dev.block_read(curr_device, blk,
 						      cnt, addr);
 			/* flush cache after read */
 			flush_cache((ulong)addr, cnt * 512); /* FIXME */
+			if (n == cnt)
+				load_hash_finish();
 			break;
 		case MMC_WRITE:
 			n = mmc->block_dev.block_write(curr_device, blk,
 						      cnt, addr);
 			break;
-		case MMC_ERASE:
-			n = mmc->block_dev.block_erase(curr_device, blk, cnt);
-			break;
 		default:
 			BUG();
 		}
@@ -315,7 +374,9 @@ U_BOOT_CMD(
 	"MMC sub system",
 	"read addr blk# cnt\n"
 	"mmc write addr blk# cnt\n"
-	"mmc erase blk# cnt\n"
+	"mmc erase [-t|-d|-s|-S] blk# cnt | part <num> | all\n"
+	"    - erase, trim (-t), discard (-d), secure erase (-s) or\n"
+	"      secure trim (-S) blocks, a partition or the device\n"
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
 	"mmc dev [dev] [part] - show or set current mmc device [partition]\n"
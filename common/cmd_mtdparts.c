@@ -143,6 +143,35 @@ static char last_ids[MTDIDS_MAXLEN];
 static char last_parts[MTDPARTS_MAXLEN];
 static char last_partition[PARTITION_MAXLEN];
 
+/*
+ * Set when one of the variables above no longer matches its copy, so
+ * that mtdparts_init() only looks at the environment after a change.
+ */
+static int mtdparts_stale = 1;
+
+static void mtdparts_env_changed(struct env_notifier *n, const char *value)
+{
+	if (!value || strcmp(value, n->priv) != 0)
+		mtdparts_stale = 1;
+}
+
+static struct env_notifier mtdparts_notifier[] = {
+	{ .name = "mtdids", .changed = mtdparts_env_changed, .priv = last_ids, },
+	{ .name = "mtdparts", .changed = mtdparts_env_changed, .priv = last_parts, },
+	{ .name = "partition", .changed = mtdparts_env_changed,
+	  .priv = last_partition, },
+};
+
+/*
+ * Partitions by name for find_dev_and_part(), built from the device
+ * list when it is first needed after a change.  Open addressing; with
+ * more partitions than fit the lists are walked instead.
+ */
+#define PART_HASH_SIZE		64
+static struct part_info *part_hash[PART_HASH_SIZE];
+static u8 part_hash_num[PART_HASH_SIZE];
+static int part_hash_valid;
+
 /* low level jffs2 cache cleaning routine */
 extern void jffs2_free_cache(struct part_info *part);
 
@@ -162,6 +191,93 @@ static struct part_info* mtd_part_info(struct mtd_device *dev, unsigned int part
 static struct mtdids* id_find_by_mtd_id(const char *mtd_id, unsigned int mtd_id_len);
 static int device_del(struct mtd_device *dev);
 
+static unsigned int part_hash_index(const char *name)
+{
+	unsigned int h = 0;
+
+	while (*name)
+		h = h * 31 + (unsigned char)*name++;
+	return h & (PART_HASH_SIZE - 1);
+}
+
+/**
+ * Fill in the partition name hash from the device list, the first of
+ * several partitions with the same name winning as in a list walk.
+ *
+ * @return 0 on success, 1 if there are too many partitions
+ */
+static int part_hash_build(void)
+{
+	struct list_head *dentry, *pentry;
+	struct mtd_device *dev;
+	struct part_info *part;
+	unsigned int i, n = 0;
+	u8 pnum;
+
+	memset(part_hash, 0, sizeof(part_hash));
+	list_for_each(dentry, &devices) {
+		dev = list_entry(dentry, struct mtd_device, link);
+		pnum = 0;
+		list_for_each(pentry, &dev->parts) {
+			part = list_entry(pentry, struct part_info, link);
+			if (++n >= PART_HASH_SIZE)
+				return 1;
+			i = part_hash_index(part->name);
+			while (part_hash[i] &&
+			       strcmp(part_hash[i]->name, part->name) != 0)
+				i = (i + 1) & (PART_HASH_SIZE - 1);
+			if (!part_hash[i]) {
+				part_hash[i] = part;
+				part_hash_num[i] = pnum;
+			}
+			pnum++;
+		}
+	}
+	part_hash_valid = 1;
+
+	return 0;
+}
+
+/**
+ * Look a partition up by name.
+ *
+ * @param name partition name
+ * @param part_num partition number within its device (output)
+ * @return pointer to the part_info, NULL if there is no such partition
+ */
+static struct part_info *part_find_by_name(const char *name, u8 *part_num)
+{
+	struct list_head *dentry, *pentry;
+	struct mtd_device *dev;
+	struct part_info *part;
+	unsigned int i;
+
+	if (part_hash_valid || part_hash_build() == 0) {
+		i = part_hash_index(name);
+		while ((part = part_hash[i]) != NULL) {
+			if (strcmp(part->name, name) == 0) {
+				*part_num = part_hash_num[i];
+				return part;
+			}
+			i = (i + 1) & (PART_HASH_SIZE - 1);
+		}
+		return NULL;
+	}
+
+	list_for_each(dentry, &devices) {
+		dev = list_entry(dentry, struct mtd_device, link);
+		*part_num = 0;
+		list_for_each(pentry, &dev->parts) {
+			part = list_entry(pentry, struct part_info, link);
+			if (strcmp(part->name, name) == 0)
+				return part;
+			(*part_num)++;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Parses a string into a number.  The number stored at ptr is
  * potentially suffixed with K (for kilobytes, or 1024 bytes),
@@ -238,6 +354,9 @@ static void index_partitions(void)
 
 	debug("--- index partitions ---\n");
 
+	/* partitions were added or removed */
+	part_hash_valid = 0;
+
 	if (current_mtd_dev) {
 		mtddevnum = 0;
 		list_for_each(dentry, &devices) {
@@ -276,13 +395,13 @@ static void current_save(void)
 		sprintf(buf, "%s%d,%d", MTD_DEV_TYPE(current_mtd_dev->id->type),
 					current_mtd_dev->id->num, current_mtd_partnum);
 
-		setenv("partition", buf);
 		strncpy(last_partition, buf, 16);
+		setenv("partition", buf);
 
 		debug("=> partition %s\n", buf);
 	} else {
-		setenv("partition", NULL);
 		last_partition[0] = '\0';
+		setenv("partition", NULL);
 
 		debug("=> partition NULL\n");
 	}
@@ -741,6 +860,7 @@ static int device_delall(struct list_head *head)
 		free(dev_tmp);
 	}
 	INIT_LIST_HEAD(&devices);
+	part_hash_valid = 0;
 
 	return 0;
 }
@@ -1348,21 +1468,15 @@ static void list_partitions(void)
 int find_dev_and_part(const char *id, struct mtd_device **dev,
 		u8 *part_num, struct part_info **part)
 {
-	struct list_head *dentry, *pentry;
 	u8 type, dnum, pnum;
 	const char *p;
 
 	debug("--- find_dev_and_part ---\nid = %s\n", id);
 
-	list_for_each(dentry, &devices) {
-		*part_num = 0;
-		*dev = list_entry(dentry, struct mtd_device, link);
-		list_for_each(pentry, &(*dev)->parts) {
-			*part = list_entry(pentry, struct part_info, link);
-			if (strcmp((*part)->name, id) == 0)
-				return 0;
-			(*part_num)++;
-		}
+	*part = part_find_by_name(id, part_num);
+	if (*part) {
+		*dev = (*part)->dev;
+		return 0;
 	}
 
 	p = id;
@@ -1572,6 +1686,7 @@ static int parse_mtdparts(const char *const mtdparts)
 		}
 
 		list_add_tail(&dev->link, &devices);
+		part_hash_valid = 0;
 		err = 0;
 	}
 	if (err == 1) {
@@ -1709,14 +1824,22 @@ int mtdparts_init(void)
 
 	debug("\n---mtdparts_init---\n");
 	if (!initialized) {
+		int i;
+
 		INIT_LIST_HEAD(&mtdids);
 		INIT_LIST_HEAD(&devices);
 		memset(last_ids, 0, MTDIDS_MAXLEN);
 		memset(last_parts, 0, MTDPARTS_MAXLEN);
 		memset(last_partition, 0, PARTITION_MAXLEN);
+		for (i = 0; i < ARRAY_SIZE(mtdparts_notifier); i++)
+			env_notifier_register(&mtdparts_notifier[i]);
 		initialized = 1;
 	}
 
+	/* nothing changed since the last successful run */
+	if (!mtdparts_stale)
+		return 0;
+
 	/* get variables */
 	ids = getenv("mtdids");
 	parts = getenv("mtdparts");
@@ -1805,8 +1928,10 @@ int mtdparts_init(void)
 		return mtd_devices_init();
 
 	/* do not process current partition if mtdparts variable is null */
-	if (!parts)
+	if (!parts) {
+		mtdparts_stale = 0;
 		return 0;
+	}
 
 	/* is current partition set in environment? if so, use it */
 	if ((tmp_ep[0] != '\0') && (strcmp(tmp_ep, last_partition) != 0)) {
@@ -1826,6 +1951,7 @@ int mtdparts_init(void)
 		current_save();
 	}
 
+	mtdparts_stale = 0;
 	return 0;
 }
 
@@ -27,6 +27,7 @@
 #include <asm/byteorder.h>
 #include <jffs2/jffs2.h>
 #include <nand.h>
+#include <load_hash.h>
 
 #if defined(CONFIG_CMD_MTDPARTS)
 
@@ -585,10 +586,13 @@ int do_nand(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		s = strchr(cmd, '.');
 		if (!s || !strcmp(s, ".jffs2") ||
 		    !strcmp(s, ".e") || !strcmp(s, ".i")) {
-			if (read)
+			if (read) {
+				load_hash_start(addr);
 				ret = nand_read_skip_bad(nand, off, &rwsize,
 							 (u_char *)addr);
-			else
+				if (!ret)
+					load_hash_finish();
+			} else
 				ret = nand_write_skip_bad(nand, off, &rwsize,
 							  (u_char *)addr, 0);
 #ifdef CONFIG_CMD_NAND_TRIMFFS
@@ -737,8 +741,8 @@ U_BOOT_CMD(
 #ifdef CONFIG_CMD_NAND_TRIMFFS
 	"nand write.trimffs - addr off|partition size\n"
 	"    write 'size' bytes starting at offset 'off' from memory address\n"
-	"    'addr', skipping bad blocks and dropping any pages at the end\n"
-	"    of eraseblocks that contain only 0xFF\n"
+	"    'addr', skipping bad blocks and any pages that contain\n"
+	"    only 0xFF\n"
 #endif
 #ifdef CONFIG_CMD_NAND_YAFFS
 	"nand write.yaffs - addr off|partition size\n"
@@ -787,7 +791,7 @@ static int nand_load_image(cmd_tbl_t *cmdtp, nand_info_t *nand,
 	if (s != NULL &&
 	    (strcmp(s, ".jffs2") && strcmp(s, ".e") && strcmp(s, ".i"))) {
 		printf("Unknown nand load suffix '%s'\n", s);
-		show_boot_progress(-53);
+		bootstage_mark(-53);
 		return 1;
 	}
 
@@ -797,16 +801,16 @@ static int nand_load_image(cmd_tbl_t *cmdtp, nand_info_t *nand,
 	r = nand_read_skip_bad(nand, offset, &cnt, (u_char *) addr);
 	if (r) {
 		puts("** Read error\n");
-		show_boot_progress (-56);
+		bootstage_mark(-56);
 		return 1;
 	}
-	show_boot_progress (56);
+	bootstage_mark(56);
 
 	switch (genimg_get_format ((void *)addr)) {
 	case IMAGE_FORMAT_LEGACY:
 		hdr = (image_header_t *)addr;
 
-		show_boot_progress (57);
+		bootstage_mark(57);
 		image_print_contents (hdr);
 
 		cnt = image_get_image_size (hdr);
@@ -820,29 +824,40 @@ static int nand_load_image(cmd_tbl_t *cmdtp, nand_info_t *nand,
 		break;
 #endif
 	default:
-		show_boot_progress (-57);
+		bootstage_mark(-57);
 		puts ("** Unknown image type\n");
 		return 1;
 	}
-	show_boot_progress (57);
+	bootstage_mark(57);
 
+	load_hash_start(addr);
 	r = nand_read_skip_bad(nand, offset, &cnt, (u_char *) addr);
+#if defined(CONFIG_FIT)
+	/* with the blob there, the external data can be read as well */
+	if (!r && genimg_get_format ((void *)addr) == IMAGE_FORMAT_FIT &&
+	    fit_get_total_size ((const void *)addr) > cnt) {
+		cnt = fit_get_total_size ((const void *)addr);
+		load_hash_start(addr);
+		r = nand_read_skip_bad(nand, offset, &cnt, (u_char *) addr);
+	}
+#endif
 	if (r) {
 		puts("** Read error\n");
-		show_boot_progress (-58);
+		bootstage_mark(-58);
 		return 1;
 	}
-	show_boot_progress (58);
+	load_hash_finish();
+	bootstage_mark(58);
 
 #if defined(CONFIG_FIT)
 	/* This cannot be done earlier, we need complete FIT image in RAM first */
 	if (genimg_get_format ((void *)addr) == IMAGE_FORMAT_FIT) {
 		if (!fit_check_format (fit_hdr)) {
-			show_boot_progress (-150);
+			bootstage_mark(-150);
 			puts ("** Bad FIT image format\n");
 			return 1;
 		}
-		show_boot_progress (151);
+		bootstage_mark(151);
 		fit_print_contents (fit_hdr);
 	}
 #endif
@@ -884,7 +899,7 @@ int do_nandboot(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 	}
 #endif
 
-	show_boot_progress(52);
+	bootstage_mark(52);
 	switch (argc) {
 	case 1:
 		addr = CONFIG_SYS_LOAD_ADDR;
@@ -907,26 +922,26 @@ int do_nandboot(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 #if defined(CONFIG_CMD_MTDPARTS)
 usage:
 #endif
-		show_boot_progress(-53);
+		bootstage_mark(-53);
 		return cmd_usage(cmdtp);
 	}
 
-	show_boot_progress(53);
+	bootstage_mark(53);
 	if (!boot_device) {
 		puts("\n** No boot device **\n");
-		show_boot_progress(-54);
+		bootstage_mark(-54);
 		return 1;
 	}
-	show_boot_progress(54);
+	bootstage_mark(54);
 
 	idx = simple_strtoul(boot_device, NULL, 16);
 
 	if (idx < 0 || idx >= CONFIG_SYS_MAX_NAND_DEVICE || !nand_info[idx].name) {
 		printf("\n** Device %d not available\n", idx);
-		show_boot_progress(-55);
+		bootstage_mark(-55);
 		return 1;
 	}
-	show_boot_progress(55);
+	bootstage_mark(55);
 
 	return nand_load_image(cmdtp, &nand_info[idx], offset, addr, argv[0]);
 }
@@ -27,8 +27,10 @@
 #include <common.h>
 #include <command.h>
 #include <net.h>
+#include <load_stream.h>
 
 static int netboot_common(enum proto_t, cmd_tbl_t *, int, char * const []);
+static void netboot_update_env(void);
 
 int do_bootp (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -41,16 +43,59 @@ U_BOOT_CMD(
 	"[loadAddress] [[hostIPaddr:]bootfilename]"
 );
 
+#ifdef CONFIG_CMD_TFTP_MULTI
+static int do_tftp_multi(cmd_tbl_t *cmdtp, int argc, char * const argv[])
+{
+	ulong addr;
+	int i;
+
+	if (argc < 3 || (argc & 1) == 0)
+		return cmd_usage(cmdtp);
+
+	TftpMultiClear();
+	for (i = 1; i < argc; i += 2) {
+		if (strict_strtoul(argv[i], 16, &addr) < 0)
+			return cmd_usage(cmdtp);
+		if (TftpMultiAdd(addr, argv[i + 1])) {
+			puts("Too many files\n");
+			return 1;
+		}
+	}
+
+	if (NetLoop(TFTPMULTI) < 0)
+		return 1;
+
+	netboot_update_env();
+	return 0;
+}
+#endif
+
 int do_tftpb (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
+#ifdef CONFIG_CMD_TFTP_MULTI
+	if (argc > 1 && strcmp(argv[1], "multi") == 0)
+		return do_tftp_multi(cmdtp, argc - 1, argv + 1);
+	if (argc > 3)
+		return cmd_usage(cmdtp);
+#endif
 	return netboot_common(TFTPGET, cmdtp, argc, argv);
 }
 
+#ifdef CONFIG_CMD_TFTP_MULTI
+U_BOOT_CMD(
+	tftpboot,	CONFIG_SYS_MAXARGS,	1,	do_tftpb,
+	"boot image via network using TFTP protocol",
+	"[loadAddress] [[hostIPaddr:]bootfilename]\n"
+	"tftpboot multi addr file [addr file ...]\n"
+	"    - load several files at once, each to its address"
+);
+#else
 U_BOOT_CMD(
 	tftpboot,	3,	1,	do_tftpb,
 	"boot image via network using TFTP protocol",
 	"[loadAddress] [[hostIPaddr:]bootfilename]"
 );
+#endif
 
 #ifdef CONFIG_CMD_TFTPPUT
 int do_tftpput(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -84,6 +129,54 @@ U_BOOT_CMD(
 );
 #endif
 
+#ifdef CONFIG_CMD_TFTPFLASH
+#ifndef CONFIG_SYS_TFTPFLASH_BUF_SIZE
+#define CONFIG_SYS_TFTPFLASH_BUF_SIZE	(4 << 20)
+#endif
+
+static int do_tftpflash(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct dl_part part;
+	char *s;
+	int size;
+
+	if (argc < 2 || argc > 3)
+		return cmd_usage(cmdtp);
+
+	if (dl_part_find(getenv("flash_areas"), argv[1], &part)) {
+		printf("No area \"%s\" in flash_areas\n", argv[1]);
+		return 1;
+	}
+	if (argc == 3)
+		copy_filename(BootFile, argv[2], sizeof(BootFile));
+
+	/* the ring buffer */
+	if ((s = getenv("loadaddr")) != NULL)
+		load_addr = simple_strtoul(s, NULL, 16);
+	if (load_stream_start(&part, (void *)load_addr,
+			      CONFIG_SYS_TFTPFLASH_BUF_SIZE))
+		return 1;
+
+	size = NetLoop(TFTPGET);
+	if (size < 0) {
+		load_stream_abort();
+		return 1;
+	}
+	netboot_update_env();
+
+	return load_stream_finish(size) ? 1 : 0;
+}
+
+U_BOOT_CMD(
+	tftpflash,	3,	1,	do_tftpflash,
+	"write a file to flash while it is being received by TFTP",
+	"area [[hostIPaddr:]filename]\n"
+	"    - area is one of \"flash_areas\"; the file goes through a\n"
+	"      ring buffer at loadaddr, so it may be larger than RAM"
+);
+#endif
+
 
 #ifdef CONFIG_CMD_RARP
 int do_rarpb (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -124,6 +217,19 @@ U_BOOT_CMD(
 );
 #endif
 
+#if defined(CONFIG_CMD_WGET)
+int do_wget(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	return netboot_common(WGET, cmdtp, argc, argv);
+}
+
+U_BOOT_CMD(
+	wget,	3,	1,	do_wget,
+	"boot image via network using HTTP protocol",
+	"[loadAddress] [[hostIPaddr:]path]"
+);
+#endif
+
 static void netboot_update_env (void)
 {
 	char tmp[22];
@@ -230,36 +336,36 @@ static int netboot_common(enum proto_t proto, cmd_tbl_t *cmdtp, int argc,
 		break;
 #endif
 	default:
-		show_boot_progress (-80);
+		bootstage_mark(-80);
 		return cmd_usage(cmdtp);
 	}
 
-	show_boot_progress (80);
+	bootstage_mark(80);
 	if ((size = NetLoop(proto)) < 0) {
-		show_boot_progress (-81);
+		bootstage_mark(-81);
 		return 1;
 	}
 
-	show_boot_progress (81);
+	bootstage_mark(81);
 	/* NetLoop ok, update environment */
 	netboot_update_env();
 
 	/* done if no file was loaded (no errors though) */
 	if (size == 0) {
-		show_boot_progress (-82);
+		bootstage_mark(-82);
 		return 0;
 	}
 
 	/* flush cache */
 	flush_cache(load_addr, size);
 
-	show_boot_progress(82);
+	bootstage_mark(82);
 	rcode = bootm_maybe_autostart(cmdtp, argv[0]);
 
 	if (rcode < 0)
-		show_boot_progress (-83);
+		bootstage_mark(-83);
 	else
-		show_boot_progress (84);
+		bootstage_mark(84);
 	return rcode;
 }
 
@@ -418,3 +524,45 @@ U_BOOT_CMD(
 );
 
 #endif	/* CONFIG_CMD_DNS */
+
+#if defined(CONFIG_CMD_AOE)
+int do_aoe(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int major = 0xffff, minor = 0xff;
+	char *ep;
+	int n;
+
+	if (argc == 2 && !strcmp(argv[1], "info")) {
+		aoe_print_devs();
+		return 0;
+	}
+
+	if (argc < 2 || argc > 3 || strcmp(argv[1], "discover"))
+		return cmd_usage(cmdtp);
+
+	if (argc == 3) {
+		major = simple_strtoul(argv[2], &ep, 10);
+		if (*ep != '.')
+			return cmd_usage(cmdtp);
+		minor = simple_strtoul(ep + 1, NULL, 10);
+	}
+
+	n = aoe_discover(major, minor);
+	if (n <= 0) {
+		puts("No AoE target found\n");
+		return 1;
+	}
+	aoe_print_devs();
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	aoe,	3,	1,	do_aoe,
+	"ATA over Ethernet block devices",
+	"discover [shelf.slot]\n"
+	"    - find the AoE targets, or only shelf.slot\n"
+	"aoe info\n"
+	"    - list the devices found"
+);
+#endif	/* CONFIG_CMD_AOE */
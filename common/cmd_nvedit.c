@@ -89,11 +89,12 @@ static const unsigned long baudrate_table[] = CONFIG_SYS_BAUDRATE_TABLE;
 #define	N_BAUDRATES (sizeof(baudrate_table) / sizeof(baudrate_table[0]))
 
 /*
- * This variable is incremented on each do_env_set(), so it can
- * be used via get_env_id() as an indication, if the environment
+ * This variable is incremented on each do_env_set() and import, so
+ * it can be used via get_env_id() as an indication, if the environment
  * has changed or not. So it is possible to reread an environment
  * variable only if the environment was changed ... done so for
- * example in NetInitLoop()
+ * example in eth_set_current().  Code that needs a few variables in
+ * parsed form can subscribe to them with env_notifier_register().
  */
 static int env_id = 1;
 
@@ -102,6 +103,33 @@ int get_env_id(void)
 	return env_id;
 }
 
+static struct env_notifier *env_notifiers;
+
+void env_notifier_register(struct env_notifier *n)
+{
+	n->next = env_notifiers;
+	env_notifiers = n;
+	n->changed(n, getenv(n->name));
+}
+
+static void env_notify(const char *name, const char *value)
+{
+	struct env_notifier *n;
+
+	for (n = env_notifiers; n; n = n->next)
+		if (strcmp(n->name, name) == 0)
+			n->changed(n, value);
+}
+
+void env_notify_all(void)
+{
+	struct env_notifier *n;
+
+	env_id++;
+	for (n = env_notifiers; n; n = n->next)
+		n->changed(n, getenv(n->name));
+}
+
 /*
  * Command interface: print one or all environment variables
  *
@@ -303,6 +331,9 @@ int _do_env_set(int flag, int argc, char * const argv[])
 	/* Delete only ? */
 	if (argc < 3 || argv[2] == NULL) {
 		int rc = hdelete_r(name, &env_htab);
+
+		if (rc)
+			env_notify(name, NULL);
 		return !rc;
 	}
 
@@ -336,6 +367,7 @@ int _do_env_set(int flag, int argc, char * const argv[])
 			name, errno);
 		return 1;
 	}
+	env_notify(name, ep->data);
 
 	/*
 	 * Some variables should be updated when the corresponding
@@ -891,6 +923,7 @@ static int do_env_import(cmd_tbl_t *cmdtp, int flag,
 		return 1;
 	}
 	gd->flags |= GD_FLG_ENV_READY;
+	env_notify_all();
 
 	return 0;
 
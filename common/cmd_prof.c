@@ -0,0 +1,250 @@
+/*
+ * Sampling profiler
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * The timer interrupt (the decrementer on PowerPC, the board's timer
+ * IRQ on ARM, SIGPROF in sandbox) hands the interrupted pc to
+ * prof_sample(), which only stores it.  "prof" sorts the samples and
+ * counts them per function of the builtin symbol table
+ * (CONFIG_KALLSYMS), or per CONFIG_SYS_PROF_GRAIN bytes of code without
+ * one, which shows where driver polling loops spend their time.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <prof.h>
+
+#ifndef CONFIG_SYS_PROF_SAMPLES
+#define CONFIG_SYS_PROF_SAMPLES	4096
+#endif
+#ifndef CONFIG_SYS_PROF_GRAIN
+#define CONFIG_SYS_PROF_GRAIN	64
+#endif
+
+#ifdef CONFIG_PROF_BOOT
+static volatile int prof_on = 1;
+#else
+static volatile int prof_on;
+#endif
+static ulong prof_count;
+static ulong prof_dropped;
+static ulong prof_pc[CONFIG_SYS_PROF_SAMPLES];
+
+struct prof_hit {
+	ulong addr;
+	const char *name;
+	ulong count;
+};
+
+void prof_sample(ulong pc)
+{
+	if (!prof_on)
+		return;
+	if (prof_count < CONFIG_SYS_PROF_SAMPLES)
+		prof_pc[prof_count++] = pc;
+	else
+		prof_dropped++;
+}
+
+void __prof_timer_enable(int on)
+{
+}
+void prof_timer_enable(int on)
+	__attribute__((weak, alias("__prof_timer_enable")));
+
+void prof_boot_done(void)
+{
+#ifdef CONFIG_PROF_BOOT
+	static int done;
+
+	if (!done) {
+		prof_on = 0;
+		prof_timer_enable(0);
+		done = 1;
+	}
+#endif
+}
+
+static int prof_cmp_pc(const void *a, const void *b)
+{
+	ulong x = *(const ulong *)a, y = *(const ulong *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int prof_cmp_count(const void *a, const void *b)
+{
+	const struct prof_hit *x = a, *y = b;
+
+	return x->count < y->count ? 1 : -(x->count > y->count);
+}
+
+#ifdef CONFIG_KALLSYMS
+extern const char system_map[] __attribute__((weak));
+
+/* One entry of the symbol table: its address, and the next entry */
+static const char *prof_map_entry(const char *sym, ulong *addr,
+				  const char **name)
+{
+	char *end;
+
+	*addr = simple_strtoul(sym, &end, 16);
+	*name = end + 1;
+	return end + strlen(end) + 1;
+}
+
+/*
+ * The table holds link addresses, the samples are taken where U-Boot
+ * runs; the difference is that of a function whose name we know.
+ */
+static long prof_reloc_off(void)
+{
+	const char *sym = system_map, *name;
+	ulong addr;
+
+	while (sym && *sym) {
+		sym = prof_map_entry(sym, &addr, &name);
+		if (!strcmp(name, "prof_sample"))
+			return (ulong)prof_sample - addr;
+	}
+	return 0;
+}
+
+/* Count the sorted samples per function, in one pass over the table */
+static int prof_group(ulong *pc, ulong count, struct prof_hit *hits)
+{
+	const char *sym = system_map, *name = NULL, *next_name;
+	ulong addr = 0, next = 0;
+	long off = prof_reloc_off();
+	int n = 0;
+	ulong i;
+
+	if (sym && *sym)
+		sym = prof_map_entry(sym, &next, &next_name);
+	else
+		next = ~0UL;
+
+	for (i = 0; i < count; i++) {
+		ulong link = pc[i] - off;
+
+		while (link >= next) {
+			addr = next;
+			name = next_name;
+			if (*sym)
+				sym = prof_map_entry(sym, &next, &next_name);
+			else
+				next = ~0UL;
+		}
+		if (!n || hits[n - 1].addr != addr || hits[n - 1].name != name) {
+			hits[n].addr = addr;
+			hits[n].name = name;
+			hits[n].count = 0;
+			n++;
+		}
+		hits[n - 1].count++;
+	}
+	return n;
+}
+#else
+static int prof_group(ulong *pc, ulong count, struct prof_hit *hits)
+{
+	int n = 0;
+	ulong i, addr;
+
+	for (i = 0; i < count; i++) {
+		addr = pc[i] & ~(CONFIG_SYS_PROF_GRAIN - 1UL);
+		if (!n || hits[n - 1].addr != addr) {
+			hits[n].addr = addr;
+			hits[n].name = NULL;
+			hits[n].count = 0;
+			n++;
+		}
+		hits[n - 1].count++;
+	}
+	return n;
+}
+#endif
+
+static int prof_show(int top)
+{
+	struct prof_hit *hits;
+	ulong count;
+	int n, i, was_on;
+
+	was_on = prof_on;
+	prof_on = 0;
+	count = prof_count;
+
+	printf("%lu samples", count);
+	if (prof_dropped)
+		printf(", %lu dropped: buffer full", prof_dropped);
+	putc('\n');
+	if (!count)
+		goto out;
+
+	hits = malloc(count * sizeof(*hits));
+	if (!hits) {
+		puts("prof: out of memory\n");
+		prof_on = was_on;
+		return 1;
+	}
+
+	qsort(prof_pc, count, sizeof(prof_pc[0]), prof_cmp_pc);
+	n = prof_group(prof_pc, count, hits);
+	qsort(hits, n, sizeof(*hits), prof_cmp_count);
+
+#ifndef CONFIG_KALLSYMS
+	printf("run-time addresses, prof_sample() is at %08lx\n",
+	       (ulong)prof_sample);
+#endif
+	puts("  count      %  function\n");
+	for (i = 0; i < n && i < top; i++) {
+		printf("%7lu %3lu.%lu%%  ", hits[i].count,
+		       hits[i].count * 100 / count,
+		       hits[i].count * 1000 / count % 10);
+		if (hits[i].name)
+			printf("%s\n", hits[i].name);
+		else
+			printf("%08lx\n", hits[i].addr);
+	}
+	free(hits);
+out:
+	prof_on = was_on;
+	return 0;
+}
+
+static int do_prof(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc < 2 || !strcmp(argv[1], "show"))
+		return prof_show(argc > 2 ? simple_strtoul(argv[2], NULL, 10)
+				 : 20);
+
+	if (!strcmp(argv[1], "start")) {
+		prof_on = 0;
+		prof_count = 0;
+		prof_dropped = 0;
+		prof_on = 1;
+		prof_timer_enable(1);
+		return 0;
+	}
+	if (!strcmp(argv[1], "stop")) {
+		prof_on = 0;
+		prof_timer_enable(0);
+		return 0;
+	}
+
+	return cmd_usage(cmdtp);
+}
+
+U_BOOT_CMD(
+	prof,	3,	0,	do_prof,
+	"sampling profiler",
+	"start - clear the samples and start taking them\n"
+	"prof stop - stop taking samples\n"
+	"prof [show [n]] - show the n (20) functions hit most often"
+);
@@ -26,6 +26,9 @@
 
 #define MAX_TFTP_PATH_LEN 127
 
+#ifndef CONFIG_PXE_MULTI_SLOT_SIZE
+#define CONFIG_PXE_MULTI_SLOT_SIZE	0x10000
+#endif
 
 /*
  * Like getenv, but prints an error if envvar isn't defined in the
@@ -133,21 +136,19 @@ static int get_bootfile_path(char *bootfile_path, size_t bootfile_path_size)
 
 /*
  * As in pxelinux, paths to files referenced from files we retrieve are
- * relative to the location of bootfile. get_relfile takes such a path and
- * joins it with the bootfile path to get the full path to the target file. If
- * the bootfile path is NULL, we use file_path as is.
+ * relative to the location of bootfile. get_relpath takes such a path and
+ * joins it with the bootfile path to get the full path to the target file,
+ * in relfile, which holds MAX_TFTP_PATH_LEN + 1 bytes. If the bootfile path
+ * is NULL, we use file_path as is.
  *
  * Returns 1 for success, or < 0 on error.
  */
-static int get_relfile(char *file_path, void *file_addr)
+static int get_relpath(char *file_path, char *relfile)
 {
 	size_t path_len;
-	char relfile[MAX_TFTP_PATH_LEN+1];
-	char addr_buf[10];
-	char *tftp_argv[] = {"tftp", NULL, NULL, NULL};
 	int err;
 
-	err = get_bootfile_path(relfile, sizeof(relfile));
+	err = get_bootfile_path(relfile, MAX_TFTP_PATH_LEN + 1);
 
 	if (err < 0)
 		return err;
@@ -165,6 +166,27 @@ static int get_relfile(char *file_path, void *file_addr)
 
 	strcat(relfile, file_path);
 
+	return 1;
+}
+
+/*
+ * Retrieves the file at file_path, relative to the bootfile path as
+ * described above, to file_addr.
+ *
+ * Returns 1 for success, or < 0 on error.
+ */
+static int get_relfile(char *file_path, void *file_addr)
+{
+	char relfile[MAX_TFTP_PATH_LEN+1];
+	char addr_buf[10];
+	char *tftp_argv[] = {"tftp", NULL, NULL, NULL};
+	int err;
+
+	err = get_relpath(file_path, relfile);
+
+	if (err < 0)
+		return err;
+
 	printf("Retrieving file: %s\n", relfile);
 
 	sprintf(addr_buf, "%p", file_addr);
@@ -238,67 +260,106 @@ static int get_pxelinux_path(char *file, void *pxefile_addr_r)
 	return get_pxe_file(path, pxefile_addr_r);
 }
 
+/* uuid, mac, 8 prefixes of the IP address and "default" */
+#define PXE_MAX_NAMES	11
+
 /*
- * Looks for a pxe file with a name based on the pxeuuid environment variable.
+ * Fills names with the names of the config files to look for in the
+ * 'pxelinux.cfg' folder, the most specific first: one based on the pxeuuid
+ * environment variable, one based on the 'ethaddr' environment variable,
+ * then ones based on our IP address and "default". See pxelinux
+ * documentation for details on what these file names look like.  We match
+ * that exactly.
  *
- * Returns 1 on success or < 0 on error.
+ * Returns the number of names.
  */
-static int pxe_uuid_path(void *pxefile_addr_r)
+static int pxe_config_names(char names[][MAX_TFTP_PATH_LEN+1])
 {
+	size_t base_len = strlen(PXELINUX_DIR);
 	char *uuid_str;
+	int mask_pos, n = 0;
 
 	uuid_str = from_env("pxeuuid");
 
-	if (!uuid_str)
-		return -ENOENT;
+	if (uuid_str) {
+		if (base_len + strlen(uuid_str) > MAX_TFTP_PATH_LEN)
+			printf("path (%s%s) too long, skipping\n",
+					PXELINUX_DIR, uuid_str);
+		else
+			strcpy(names[n++], uuid_str);
+	}
+
+	if (format_mac_pxe(names[n], sizeof(names[n])) > 0)
+		n++;
+
+	for (mask_pos = 8; mask_pos > 0; mask_pos--) {
+		sprintf(names[n], "%08X", ntohl(NetOurIP));
+		names[n++][mask_pos] = '\0';
+	}
 
-	return get_pxelinux_path(uuid_str, pxefile_addr_r);
+	strcpy(names[n++], "default");
+
+	return n;
 }
 
+#ifdef CONFIG_CMD_TFTP_MULTI
 /*
- * Looks for a pxe file with a name based on the 'ethaddr' environment
- * variable.
+ * Asks for as many of the config files as TFTP multi takes at a time,
+ * each to a slot of CONFIG_PXE_MULTI_SLOT_SIZE bytes from pxefile_addr_r
+ * on, instead of waiting for the server's answer to each in turn. The
+ * most specific one found is moved to pxefile_addr_r; only if there is
+ * none are the next ones asked for.
  *
- * Returns 1 on success or < 0 on error.
+ * Returns the index of the name of the file found, or < 0 on error.
  */
-static int pxe_mac_path(void *pxefile_addr_r)
+static int pxe_get_multi(char names[][MAX_TFTP_PATH_LEN+1], int count,
+			 void *pxefile_addr_r)
 {
-	char mac_str[21];
-	int err;
+	char path[MAX_TFTP_PATH_LEN+1], relfile[MAX_TFTP_PATH_LEN+1];
+	void *slot;
+	long size;
+	int first, i, n, err;
 
-	err = format_mac_pxe(mac_str, sizeof(mac_str));
+	for (first = 0; first < count; first += n) {
+		TftpMultiClear();
+		TftpMultiProbe(CONFIG_PXE_MULTI_SLOT_SIZE - 1);
 
-	if (err < 0)
-		return err;
+		for (n = 0; first + n < count; n++) {
+			sprintf(path, PXELINUX_DIR "%s", names[first + n]);
 
-	return get_pxelinux_path(mac_str, pxefile_addr_r);
-}
+			err = get_relpath(path, relfile);
 
-/*
- * Looks for pxe files with names based on our IP address. See pxelinux
- * documentation for details on what these file names look like.  We match
- * that exactly.
- *
- * Returns 1 on success or < 0 on error.
- */
-static int pxe_ipaddr_paths(void *pxefile_addr_r)
-{
-	char ip_addr[9];
-	int mask_pos, err;
+			if (err < 0)
+				return err;
 
-	sprintf(ip_addr, "%08X", ntohl(NetOurIP));
+			slot = pxefile_addr_r + n * CONFIG_PXE_MULTI_SLOT_SIZE;
 
-	for (mask_pos = 7; mask_pos >= 0;  mask_pos--) {
-		err = get_pxelinux_path(ip_addr, pxefile_addr_r);
+			if (TftpMultiAdd((ulong)slot, relfile))
+				break;
 
-		if (err > 0)
-			return err;
+			printf("Retrieving file: %s\n", relfile);
+		}
+
+		if (NetLoop(TFTPMULTI) < 0)
+			return -EIO;
+
+		for (i = 0; i < n; i++) {
+			size = TftpMultiSize(i);
 
-		ip_addr[mask_pos] = '\0';
+			if (size < 0)
+				continue;
+
+			slot = pxefile_addr_r + i * CONFIG_PXE_MULTI_SLOT_SIZE;
+			memmove(pxefile_addr_r, slot, size);
+			*(char *)(pxefile_addr_r + size) = '\0';
+
+			return first + i;
+		}
 	}
 
 	return -ENOENT;
 }
+#endif
 
 /*
  * Entry point for the 'pxe get' command.
@@ -310,6 +371,9 @@ static int pxe_ipaddr_paths(void *pxefile_addr_r)
  * MAC addr comes from ethaddr env variable, if defined
  * IP
  *
+ * The name of the file found is kept in the pxecfg env variable, and that
+ * file is tried first by the next 'pxe get'.
+ *
  * see http://syslinux.zytor.com/wiki/index.php/PXELINUX
  *
  * Returns 0 on success or 1 on error.
@@ -317,9 +381,10 @@ static int pxe_ipaddr_paths(void *pxefile_addr_r)
 static int
 do_pxe_get(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	char *pxefile_addr_str;
+	char names[PXE_MAX_NAMES][MAX_TFTP_PATH_LEN+1];
+	char *pxefile_addr_str, *pxecfg;
 	void *pxefile_addr_r;
-	int err;
+	int count, err, i;
 
 	if (argc != 1)
 		return cmd_usage(cmdtp);
@@ -335,17 +400,36 @@ do_pxe_get(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (err < 0)
 		return 1;
 
+	pxecfg = getenv("pxecfg");
+
+	if (pxecfg && get_pxelinux_path(pxecfg, pxefile_addr_r) > 0) {
+		printf("Config file found\n");
+
+		return 0;
+	}
+
+	count = pxe_config_names(names);
+
+#ifdef CONFIG_CMD_TFTP_MULTI
+	i = pxe_get_multi(names, count, pxefile_addr_r);
+#else
 	/*
 	 * Keep trying paths until we successfully get a file we're looking
 	 * for.
 	 */
-	if (pxe_uuid_path(pxefile_addr_r) > 0
-		|| pxe_mac_path(pxefile_addr_r) > 0
-		|| pxe_ipaddr_paths(pxefile_addr_r) > 0
-		|| get_pxelinux_path("default", pxefile_addr_r) > 0) {
+	for (i = 0; i < count; i++)
+		if (get_pxelinux_path(names[i], pxefile_addr_r) > 0)
+			break;
 
+	if (i == count)
+		i = -ENOENT;
+#endif
+
+	if (i >= 0) {
 		printf("Config file found\n");
 
+		setenv("pxecfg", names[i]);
+
 		return 0;
 	}
 
@@ -27,10 +27,51 @@
 #include <command.h>
 #include <part.h>
 #include <sata.h>
+#include <blkcache.h>
+#include <time_acct.h>
+#include <blkstats.h>
 
 int sata_curr_device = -1;
 block_dev_desc_t sata_dev_desc[CONFIG_SYS_SATA_MAX_DEVICE];
 
+/* the SATA drivers provide sata_read/write, the cache sits on top */
+static ulong sata_bread(int dev, ulong blknr, lbaint_t blkcnt, void *buffer)
+{
+	unsigned long long t, s;
+	ulong n;
+
+	if (blkcache_read(IF_TYPE_SATA, dev, blknr, blkcnt,
+			  sata_dev_desc[dev].blksz, buffer) ||
+	    blkcache_readahead(&sata_dev_desc[dev], blknr, blkcnt, buffer))
+		return blkcnt;
+
+	t = time_acct_start();
+	s = blkstats_start();
+	n = sata_read(dev, blknr, blkcnt, buffer);
+	blkstats_end(IF_TYPE_SATA, dev, BLKSTATS_READ,
+		     n * sata_dev_desc[dev].blksz, s);
+	time_acct_end(TIME_ACCT_BLOCK, t);
+	blkcache_fill(IF_TYPE_SATA, dev, blknr, n, sata_dev_desc[dev].blksz,
+		      buffer);
+	return n;
+}
+
+static ulong sata_bwrite(int dev, ulong blknr, lbaint_t blkcnt,
+			 const void *buffer)
+{
+	unsigned long long t, s;
+	ulong n;
+
+	dev_invalidate(IF_TYPE_SATA, dev);
+	t = time_acct_start();
+	s = blkstats_start();
+	n = sata_write(dev, blknr, blkcnt, buffer);
+	blkstats_end(IF_TYPE_SATA, dev, BLKSTATS_WRITE,
+		     n * sata_dev_desc[dev].blksz, s);
+	time_acct_end(TIME_ACCT_BLOCK, t);
+	return n;
+}
+
 int __sata_initialize(void)
 {
 	int rc;
@@ -44,8 +85,9 @@ int __sata_initialize(void)
 		sata_dev_desc[i].type = DEV_TYPE_HARDDISK;
 		sata_dev_desc[i].lba = 0;
 		sata_dev_desc[i].blksz = 512;
-		sata_dev_desc[i].block_read = sata_read;
-		sata_dev_desc[i].block_write = sata_write;
+		sata_dev_desc[i].block_read = sata_bread;
+		sata_dev_desc[i].block_write = sata_bwrite;
+		dev_invalidate(IF_TYPE_SATA, i);
 
 		rc = init_sata(i);
 		rc = scan_sata(i);
@@ -159,7 +201,7 @@ int do_sata(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			printf("\nSATA read: device %d block # %ld, count %ld ... ",
 				sata_curr_device, blk, cnt);
 
-			n = sata_read(sata_curr_device, blk, cnt, (u32 *)addr);
+			n = sata_bread(sata_curr_device, blk, cnt, (u32 *)addr);
 
 			/* flush cache after read */
 			flush_cache(addr, cnt * sata_dev_desc[sata_curr_device].blksz);
@@ -177,7 +219,7 @@ int do_sata(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			printf("\nSATA write: device %d block # %ld, count %ld ... ",
 				sata_curr_device, blk, cnt);
 
-			n = sata_write(sata_curr_device, blk, cnt, (u32 *)addr);
+			n = sata_bwrite(sata_curr_device, blk, cnt, (u32 *)addr);
 
 			printf("%ld blocks written: %s\n",
 				n, (n == cnt) ? "OK" : "ERROR");
@@ -33,6 +33,9 @@
 #include <scsi.h>
 #include <image.h>
 #include <pci.h>
+#include <blkcache.h>
+#include <time_acct.h>
+#include <blkstats.h>
 
 #ifdef CONFIG_SCSI_SYM53C8XX
 #define SCSI_VEND_ID	0x1000
@@ -68,11 +71,13 @@ void scsi_setup_test_unit_ready(ccb * pccb);
 void scsi_setup_read_capacity(ccb * pccb);
 void scsi_setup_read6(ccb * pccb, unsigned long start, unsigned short blocks);
 void scsi_setup_read_ext(ccb * pccb, unsigned long start, unsigned short blocks);
+void scsi_setup_write_ext(ccb * pccb, unsigned long start, unsigned short blocks);
 void scsi_setup_inquiry(ccb * pccb);
 void scsi_ident_cpy (unsigned char *dest, unsigned char *src, unsigned int len);
 
 
 ulong scsi_read(int device, ulong blknr, ulong blkcnt, void *buffer);
+ulong scsi_write(int device, ulong blknr, ulong blkcnt, const void *buffer);
 
 
 /*********************************************************************************
@@ -102,6 +107,8 @@ void scsi_scan(int mode)
 		scsi_dev_desc[i].dev=i;
 		scsi_dev_desc[i].part_type=PART_TYPE_UNKNOWN;
 		scsi_dev_desc[i].block_read=scsi_read;
+		scsi_dev_desc[i].block_write=scsi_write;
+		dev_invalidate(IF_TYPE_SCSI, i);
 	}
 	scsi_max_devs=0;
 	for(i=0;i<CONFIG_SYS_SCSI_MAX_SCSI_ID;i++) {
@@ -426,6 +433,17 @@ int do_scsi (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 				printf ("%ld blocks read: %s\n",n,(n==cnt) ? "OK" : "ERROR");
 				return 0;
 			}
+			if (strcmp(argv[1],"write") == 0) {
+				ulong addr = simple_strtoul(argv[2], NULL, 16);
+				ulong blk  = simple_strtoul(argv[3], NULL, 16);
+				ulong cnt  = simple_strtoul(argv[4], NULL, 16);
+				ulong n;
+				printf ("\nSCSI write: device %d block # %ld, count %ld ... ",
+						scsi_curr_dev, blk, cnt);
+				n = scsi_write(scsi_curr_dev, blk, cnt, (ulong *)addr);
+				printf ("%ld blocks written: %s\n",n,(n==cnt) ? "OK" : "ERROR");
+				return 0;
+			}
 	} /* switch */
 	return cmd_usage(cmdtp);
 }
@@ -440,8 +458,14 @@ ulong scsi_read(int device, ulong blknr, ulong blkcnt, void *buffer)
 {
 	ulong start,blks, buf_addr;
 	unsigned short smallblks;
+	unsigned long long t, s;
+	int ok;
 	ccb* pccb=(ccb *)&tempccb;
 	device&=0xff;
+	if (blkcache_read(IF_TYPE_SCSI, device, blknr, blkcnt,
+			  scsi_dev_desc[device].blksz, buffer) ||
+	    blkcache_readahead(&scsi_dev_desc[device], blknr, blkcnt, buffer))
+		return blkcnt;
 	/* Setup  device
 	 */
 	pccb->target=scsi_dev_desc[device].target;
@@ -467,7 +491,13 @@ ulong scsi_read(int device, ulong blknr, ulong blkcnt, void *buffer)
 			blks=0;
 		}
 		debug ("scsi_read_ext: startblk %lx, blccnt %x buffer %lx\n",start,smallblks,buf_addr);
-		if(scsi_exec(pccb)!=TRUE) {
+		t = time_acct_start();
+		s = blkstats_start();
+		ok = scsi_exec(pccb);
+		blkstats_end(IF_TYPE_SCSI, device, BLKSTATS_READ,
+			     ok == TRUE ? pccb->datalen : 0, s);
+		time_acct_end(TIME_ACCT_BLOCK, t);
+		if(ok!=TRUE) {
 			scsi_print_error(pccb);
 			blkcnt-=blks;
 			break;
@@ -475,6 +505,65 @@ ulong scsi_read(int device, ulong blknr, ulong blkcnt, void *buffer)
 		buf_addr+=pccb->datalen;
 	} while(blks!=0);
 	debug ("scsi_read_ext: end startblk %lx, blccnt %x buffer %lx\n",start,smallblks,buf_addr);
+	blkcache_fill(IF_TYPE_SCSI, device, blknr, blkcnt,
+		      scsi_dev_desc[device].blksz, buffer);
+	return(blkcnt);
+}
+
+/****************************************************************************************
+ * scsi_write
+ */
+
+#define SCSI_MAX_WRITE_BLK 0xFFFF /* almost the maximum amount of the scsi_ext command.. */
+
+ulong scsi_write(int device, ulong blknr, ulong blkcnt, const void *buffer)
+{
+	ulong start,blks, buf_addr;
+	unsigned short smallblks;
+	unsigned long long t, s;
+	int ok;
+	ccb* pccb=(ccb *)&tempccb;
+	device&=0xff;
+	dev_invalidate(IF_TYPE_SCSI, device);
+	/* Setup  device
+	 */
+	pccb->target=scsi_dev_desc[device].target;
+	pccb->lun=scsi_dev_desc[device].lun;
+	buf_addr=(unsigned long)buffer;
+	start=blknr;
+	blks=blkcnt;
+	debug ("\nscsi_write: dev %d startblk %lx, blccnt %lx buffer %lx\n",device,start,blks,(unsigned long)buffer);
+	do {
+		pccb->pdata=(unsigned char *)buf_addr;
+		if(blks>SCSI_MAX_WRITE_BLK) {
+			pccb->datalen=scsi_dev_desc[device].blksz * SCSI_MAX_WRITE_BLK;
+			smallblks=SCSI_MAX_WRITE_BLK;
+			scsi_setup_write_ext(pccb,start,smallblks);
+			start+=SCSI_MAX_WRITE_BLK;
+			blks-=SCSI_MAX_WRITE_BLK;
+		}
+		else {
+			pccb->datalen=scsi_dev_desc[device].blksz * blks;
+			smallblks=(unsigned short) blks;
+			scsi_setup_write_ext(pccb,start,smallblks);
+			start+=blks;
+			blks=0;
+		}
+		debug ("scsi_write_ext: startblk %lx, blccnt %x buffer %lx\n",start,smallblks,buf_addr);
+		t = time_acct_start();
+		s = blkstats_start();
+		ok = scsi_exec(pccb);
+		blkstats_end(IF_TYPE_SCSI, device, BLKSTATS_WRITE,
+			     ok == TRUE ? pccb->datalen : 0, s);
+		time_acct_end(TIME_ACCT_BLOCK, t);
+		if(ok!=TRUE) {
+			scsi_print_error(pccb);
+			blkcnt-=blks;
+			break;
+		}
+		buf_addr+=pccb->datalen;
+	} while(blks!=0);
+	debug ("scsi_write_ext: end startblk %lx, blccnt %x buffer %lx\n",start,smallblks,buf_addr);
 	return(blkcnt);
 }
 
@@ -571,6 +660,26 @@ void scsi_setup_read_ext(ccb * pccb, unsigned long start, unsigned short blocks)
 		pccb->cmd[7],pccb->cmd[8]);
 }
 
+void scsi_setup_write_ext(ccb * pccb, unsigned long start, unsigned short blocks)
+{
+	pccb->cmd[0]=SCSI_WRITE10;
+	pccb->cmd[1]=pccb->lun<<5;
+	pccb->cmd[2]=((unsigned char) (start>>24))&0xff;
+	pccb->cmd[3]=((unsigned char) (start>>16))&0xff;
+	pccb->cmd[4]=((unsigned char) (start>>8))&0xff;
+	pccb->cmd[5]=((unsigned char) (start))&0xff;
+	pccb->cmd[6]=0;
+	pccb->cmd[7]=((unsigned char) (blocks>>8))&0xff;
+	pccb->cmd[8]=(unsigned char) blocks & 0xff;
+	pccb->cmd[9]=0;
+	pccb->cmdlen=10;
+	pccb->msgout[0]=SCSI_IDENTIFY; /* NOT USED */
+	debug ("scsi_setup_write_ext: cmd: %02X %02X startblk %02X%02X%02X%02X blccnt %02X%02X\n",
+		pccb->cmd[0],pccb->cmd[1],
+		pccb->cmd[2],pccb->cmd[3],pccb->cmd[4],pccb->cmd[5],
+		pccb->cmd[7],pccb->cmd[8]);
+}
+
 void scsi_setup_read6(ccb * pccb, unsigned long start, unsigned short blocks)
 {
 	pccb->cmd[0]=SCSI_READ6;
@@ -612,7 +721,9 @@ U_BOOT_CMD(
 	"scsi device [dev] - show or set current device\n"
 	"scsi part [dev] - print partition table of one or all SCSI devices\n"
 	"scsi read addr blk# cnt - read `cnt' blocks starting at block `blk#'\n"
-	"     to memory address `addr'"
+	"     to memory address `addr'\n"
+	"scsi write addr blk# cnt - write `cnt' blocks starting at block\n"
+	"     `blk#' from memory address `addr'"
 );
 
 U_BOOT_CMD(
@@ -110,36 +110,109 @@ static int do_spi_flash_probe(int argc, char * const argv[])
 	return 0;
 }
 
+/**
+ * Program the pages of a region whose new contents differ from what the
+ * flash holds.  Programming can only clear bits, so this is only valid
+ * where old has no 0 bit that data needs as 1.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset of the region
+ * @param len		length of the region
+ * @param buf		new contents
+ * @param old		current contents, NULL if the region is erased
+ * @return 0 if OK, else the error of spi_flash_write()
+ */
+static int spi_flash_write_changed(struct spi_flash *flash, u32 offset,
+		size_t len, const char *buf, const char *old)
+{
+	size_t i, todo;
+	int ret;
+
+	for (; len; offset += todo, buf += todo, len -= todo) {
+		todo = min(len, flash->page_size - offset % flash->page_size);
+
+		if (old) {
+			if (memcmp(buf, old, todo) == 0) {
+				old += todo;
+				continue;
+			}
+			old += todo;
+		} else {
+			for (i = 0; i < todo && (u8)buf[i] == 0xff; i++)
+				;
+			if (i == todo)
+				continue;
+		}
+
+		ret = spi_flash_write(flash, offset, todo, buf);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 /**
  * Write a block of data to SPI flash, first checking if it is different from
  * what is already there.
  *
+ * The block lies within one sector.  If the data only clears bits, the
+ * changed pages are programmed without an erase; otherwise the rest of
+ * the sector is read back and written again after the erase.
+ *
  * If the data being written is the same, then *skipped is incremented by len.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
  * @param len		number of bytes to write
  * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
+ * @param cmp_buf	read buffer of one sector to use to compare data
  * @param skipped	Count of skipped data (incremented by this function)
  * @return NULL if OK, else a string containing the stage which failed
  */
 static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
 {
+	u32 sector = offset - offset % flash->sector_size;
+	size_t head = offset - sector;
+	size_t tail = flash->sector_size - head - len;
+	size_t i;
+
 	debug("offset=%#x, sector_size=%#x, len=%#x\n",
 		offset, flash->sector_size, len);
-	if (spi_flash_read(flash, offset, len, cmp_buf))
+	if (spi_flash_read(flash, offset, len, cmp_buf + head))
 		return "read";
-	if (memcmp(cmp_buf, buf, len) == 0) {
+	if (memcmp(cmp_buf + head, buf, len) == 0) {
 		debug("Skip region %x size %x: no change\n",
 			offset, len);
 		*skipped += len;
 		return NULL;
 	}
-	if (spi_flash_erase(flash, offset, len))
+
+	/* Only 1 -> 0 transitions: no erase needed */
+	for (i = 0; i < len && (buf[i] & ~cmp_buf[head + i]) == 0; i++)
+		;
+	if (i == len) {
+		debug("Program region %x size %zx without erase\n",
+			offset, len);
+		if (spi_flash_write_changed(flash, offset, len, buf,
+					    cmp_buf + head))
+			return "write";
+		return NULL;
+	}
+
+	/* Keep the parts of the sector outside the block */
+	if (head && spi_flash_read(flash, sector, head, cmp_buf))
+		return "read";
+	if (tail && spi_flash_read(flash, offset + len, tail,
+				   cmp_buf + head + len))
+		return "read";
+	memcpy(cmp_buf + head, buf, len);
+
+	if (spi_flash_erase(flash, sector, flash->sector_size))
 		return "erase";
-	if (spi_flash_write(flash, offset, len, buf))
+	if (spi_flash_write_changed(flash, sector, flash->sector_size,
+				    cmp_buf, NULL))
 		return "write";
 	return NULL;
 }
@@ -147,6 +220,7 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 /**
  * Update an area of SPI flash by erasing and writing any blocks which need
  * to change. Existing blocks with the correct data are left unchanged.
+ * The area need not be sector aligned.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
@@ -166,7 +240,8 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	cmp_buf = malloc(flash->sector_size);
 	if (cmp_buf) {
 		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min(end - buf, flash->sector_size);
+			todo = min(end - buf, flash->sector_size -
+				   offset % flash->sector_size);
 			err_oper = spi_flash_update_block(flash, offset, todo,
 					buf, cmp_buf, &skipped);
 		}
@@ -308,5 +383,6 @@ U_BOOT_CMD(
 	"sf erase offset [+]len		- erase `len' bytes from `offset'\n"
 	"				  `+len' round up `len' to block size\n"
 	"sf update addr offset len	- erase and write `len' bytes from memory\n"
-	"				  at `addr' to flash at `offset'"
+	"				  at `addr' to flash at `offset',\n"
+	"				  skipping sectors that do not change"
 );
@@ -0,0 +1,121 @@
+/*
+ * "spl export": prepare the boot parameters of a kernel once, so that
+ * SPL can start the kernel directly with them (CONFIG_SPL_OS_BOOT).
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <image.h>
+#include <asm/setup.h>
+#ifdef CONFIG_OF_LIBFDT
+#include <libfdt.h>
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+extern bootm_headers_t images;
+
+enum spl_export_type {
+	SPL_EXPORT_ATAGS,
+	SPL_EXPORT_FDT,
+};
+
+static int spl_bootm(cmd_tbl_t *bootm, char *state)
+{
+	char *argv[] = { "bootm", state, NULL };
+
+	return do_bootm(bootm, 0, 2, argv);
+}
+
+/*
+ * Run bootm up to and including "prep" on the kernel (and initrd and
+ * device tree) given in argv, which leaves the ATAGs or the fixed up
+ * device tree in RAM.
+ */
+static int spl_export(int type, int argc, char * const argv[])
+{
+	cmd_tbl_t *bootm = find_cmd("bootm");
+	char *start_argv[5] = { "bootm", "start" };
+	ulong addr = 0, size = 0;
+	char buf[12];
+	int i;
+
+	if (!bootm || argc > 3)
+		return 1;
+	for (i = 0; i < argc; i++)
+		start_argv[i + 2] = argv[i];
+	if (do_bootm(bootm, 0, argc + 2, start_argv))
+		return 1;
+	if (spl_bootm(bootm, "loados"))
+		return 1;
+#ifdef CONFIG_SYS_BOOT_RAMDISK_HIGH
+	if (argc > 1 && strcmp(argv[1], "-") && spl_bootm(bootm, "ramdisk"))
+		return 1;
+#endif
+	if (type == SPL_EXPORT_FDT) {
+#ifdef CONFIG_OF_LIBFDT
+		if (!images.ft_len) {
+			puts("No device tree given\n");
+			return 1;
+		}
+		if (spl_bootm(bootm, "fdt"))
+			return 1;
+#else
+		puts("Device tree support not compiled in\n");
+		return 1;
+#endif
+	}
+	if (spl_bootm(bootm, "prep"))
+		return 1;
+
+	if (type == SPL_EXPORT_ATAGS) {
+		struct tag *t = (struct tag *)gd->bd->bi_boot_params;
+
+		addr = (ulong)t;
+		while (t->hdr.size)
+			t = tag_next(t);
+		size = (ulong)t + sizeof(struct tag_header) - addr;
+	} else {
+#ifdef CONFIG_OF_LIBFDT
+		addr = (ulong)images.ft_addr;
+		size = fdt_totalsize(images.ft_addr);
+#endif
+	}
+
+	printf("Exported %s at 0x%08lx, size 0x%lx\n",
+	       type == SPL_EXPORT_ATAGS ? "ATAGs" : "device tree", addr, size);
+	setenv_addr("fileaddr", (void *)addr);
+	sprintf(buf, "%lX", size);
+	setenv("filesize", buf);
+	return 0;
+}
+
+static int do_spl(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int type;
+
+	if (argc < 4 || strcmp(argv[1], "export"))
+		return cmd_usage(cmdtp);
+
+	if (!strcmp(argv[2], "atags"))
+		type = SPL_EXPORT_ATAGS;
+	else if (!strcmp(argv[2], "fdt"))
+		type = SPL_EXPORT_FDT;
+	else
+		return cmd_usage(cmdtp);
+
+	return spl_export(type, argc - 3, argv + 3) ? 1 : 0;
+}
+
+U_BOOT_CMD(spl, 6, 0, do_spl,
+	"prepare the boot parameters for SPL to start a kernel",
+	"export atags|fdt kernel_addr [initrd_addr|-] [fdt_addr]\n"
+	"    - prepare the ATAGs or the device tree that the kernel at\n"
+	"      kernel_addr would be started with, and leave their address\n"
+	"      and size in fileaddr and filesize"
+);
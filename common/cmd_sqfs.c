@@ -0,0 +1,124 @@
+/*
+ * Squashfs commands, after those for ext2
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+#include <squashfs.h>
+
+/* Mount the squashfs on <interface> <dev[:part]> */
+static int sqfs_mount_dev(char * const argv[])
+{
+	block_dev_desc_t *dev_desc;
+	int dev, part = 1;
+	char *ep;
+
+	dev = (int)simple_strtoul(argv[2], &ep, 16);
+	dev_desc = get_dev(argv[1], dev);
+	if (dev_desc == NULL) {
+		printf("** Block device %s %d not supported\n", argv[1], dev);
+		return -1;
+	}
+	if (*ep) {
+		if (*ep != ':') {
+			puts("** Invalid boot device, use `dev[:part]' **\n");
+			return -1;
+		}
+		part = (int)simple_strtoul(++ep, NULL, 16);
+	}
+
+	if (sqfs_mount(dev_desc, part)) {
+		printf("** Bad squashfs partition or disk - %s %d:%d **\n",
+		       argv[1], dev, part);
+		return -1;
+	}
+	return 0;
+}
+
+int do_sqfsls(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	if (argc < 3)
+		return cmd_usage(cmdtp);
+
+	if (sqfs_mount_dev(argv))
+		return 1;
+
+	ret = sqfs_ls(argc == 4 ? argv[3] : "/");
+	sqfs_close();
+
+	return ret ? 1 : 0;
+}
+
+U_BOOT_CMD(
+	sqfsls,	4,	1,	do_sqfsls,
+	"list files in a directory (default /)",
+	"<interface> <dev[:part]> [directory]\n"
+	"    - list files from 'dev' on 'interface' in a 'directory'"
+);
+
+int do_sqfsload(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	char *filename, *addr_str;
+	ulong addr, count = 0;
+	char buf[12];
+	long len;
+
+	if (argc < 3 || argc > 6)
+		return cmd_usage(cmdtp);
+
+	if (argc > 3) {
+		addr = simple_strtoul(argv[3], NULL, 16);
+	} else {
+		addr_str = getenv("loadaddr");
+		if (addr_str != NULL)
+			addr = simple_strtoul(addr_str, NULL, 16);
+		else
+			addr = CONFIG_SYS_LOAD_ADDR;
+	}
+	filename = argc > 4 ? argv[4] : getenv("bootfile");
+	if (argc > 5)
+		count = simple_strtoul(argv[5], NULL, 16);
+
+	if (!filename) {
+		puts("** No boot file defined **\n");
+		return 1;
+	}
+
+	if (sqfs_mount_dev(argv))
+		return 1;
+
+	printf("Loading file \"%s\" from %s device %s\n",
+	       filename, argv[1], argv[2]);
+	len = sqfs_read(filename, (void *)addr, count);
+	sqfs_close();
+	if (len < 0) {
+		printf("** Unable to read \"%s\" from %s %s **\n",
+		       filename, argv[1], argv[2]);
+		return 1;
+	}
+
+	/* Loading ok, update default load address */
+	load_addr = addr;
+
+	printf("%ld bytes read\n", len);
+	sprintf(buf, "%lX", len);
+	setenv("filesize", buf);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	sqfsload,	6,	0,	do_sqfsload,
+	"load binary file from a squashfs filesystem",
+	"<interface> <dev[:part]> [addr] [filename] [bytes]\n"
+	"    - load binary file 'filename' from 'dev' on 'interface'\n"
+	"      to address 'addr' from squashfs filesystem"
+);
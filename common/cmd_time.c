@@ -21,17 +21,65 @@
 
 #include <common.h>
 #include <command.h>
+#include <div64.h>
+#include <time_acct.h>
+
+#ifndef CONFIG_SYS_TIME_ENTRIES
+#define CONFIG_SYS_TIME_ENTRIES	16
+#endif
+
+/* what the commands run by "time" have taken so far, by name */
+struct time_entry {
+	char name[16];
+	ulong runs;
+	unsigned long long total;
+	unsigned long long acct[TIME_ACCT_KINDS];
+};
+
+static struct time_entry time_table[CONFIG_SYS_TIME_ENTRIES];
+
+unsigned long long __time_cycles(void)
+{
+	return get_ticks();
+}
+unsigned long long time_cycles(void)
+	__attribute__((weak, alias("__time_cycles")));
+
+ulong __time_cycles_hz(void)
+{
+	return get_tbclk();
+}
+ulong time_cycles_hz(void) __attribute__((weak, alias("__time_cycles_hz")));
+
+#ifdef CONFIG_CMD_TIME_ACCT
+static const char * const time_acct_names[TIME_ACCT_KINDS] = {
+	[TIME_ACCT_BLOCK]	= "block I/O",
+	[TIME_ACCT_NET]		= "network",
+};
+
+unsigned long long time_acct[TIME_ACCT_KINDS];
+static int time_acct_depth;
+
+unsigned long long time_acct_start(void)
+{
+	if (time_acct_depth++)
+		return 0;
+	return time_cycles();
+}
+
+void time_acct_end(enum time_acct_kind kind, unsigned long long start)
+{
+	if (!--time_acct_depth)
+		time_acct[kind] += time_cycles() - start;
+}
+#endif
 
-/*
- * TODO(clchiou): This function actually minics the bottom-half of the
- * run_command() function.  Since this function has ARM-dependent timer
- * codes, we cannot merge it with the run_command() for now.
- */
 static int run_command_and_time_it(int flag, int argc, char * const argv[],
-		ulong *cycles)
+		unsigned long long *cycles, unsigned long long *acct)
 {
 	cmd_tbl_t *cmdtp = find_cmd(argv[0]);
 	int retval = 0;
+	int i;
 
 	if (!cmdtp) {
 		printf("%s: command not found\n", argv[0]);
@@ -40,51 +88,148 @@ static int run_command_and_time_it(int flag, int argc, char * const argv[],
 	if (argc > cmdtp->maxargs)
 		return cmd_usage(cmdtp);
 
-	/*
-	 * TODO(clchiou): get_timer_masked() is only defined in certain ARM
-	 * boards.  We could use the new timer API that Graeme is proposing
-	 * so that this piece of code would be arch-independent.
-	 */
-	*cycles = get_timer_masked();
+#ifdef CONFIG_CMD_TIME_ACCT
+	for (i = 0; i < TIME_ACCT_KINDS; i++)
+		acct[i] = time_acct[i];
+#endif
+	*cycles = time_cycles();
 	retval = cmdtp->cmd(cmdtp, flag, argc, argv);
-	*cycles = get_timer_masked() - *cycles;
+	*cycles = time_cycles() - *cycles;
+	for (i = 0; i < TIME_ACCT_KINDS; i++) {
+#ifdef CONFIG_CMD_TIME_ACCT
+		acct[i] = time_acct[i] - acct[i];
+#else
+		acct[i] = 0;
+#endif
+	}
 
 	return retval;
 }
 
-static void report_time(ulong cycles)
+/* seconds and microseconds, without overflowing the multiplication */
+static void print_seconds(unsigned long long cycles)
+{
+	ulong hz = time_cycles_hz();
+	unsigned long long sec = lldiv(cycles, hz);
+	ulong usec = lldiv((cycles - sec * hz) * 1000000, hz);
+
+	if (sec >= 60)
+		printf("%lu minutes, ", (ulong)lldiv(sec, 60));
+	printf("%lu.%06lu s", (ulong)(sec % 60), usec);
+}
+
+#ifdef CONFIG_CMD_TIME_ACCT
+/* the part of the time spent in the drivers, the rest is computing */
+static void report_acct(unsigned long long cycles,
+			const unsigned long long *acct)
+{
+	unsigned long long cpu = cycles;
+	int i;
+
+	for (i = 0; i < TIME_ACCT_KINDS; i++) {
+		printf("      %-10s ", time_acct_names[i]);
+		print_seconds(acct[i]);
+		putc('\n');
+		cpu -= min(cpu, acct[i]);
+	}
+	printf("      %-10s ", "cpu");
+	print_seconds(cpu);
+	putc('\n');
+}
+#else
+static inline void report_acct(unsigned long long cycles,
+			       const unsigned long long *acct)
+{
+}
+#endif
+
+static void report_time(unsigned long long cycles,
+			const unsigned long long *acct)
 {
-	ulong minutes, seconds, milliseconds;
-	ulong total_seconds, remainder;
-
-	total_seconds = cycles / CONFIG_SYS_HZ;
-	remainder = cycles % CONFIG_SYS_HZ;
-	minutes = total_seconds / 60;
-	seconds = total_seconds % 60;
-	/* approximate millisecond value */
-	milliseconds = (remainder * 1000 + CONFIG_SYS_HZ / 2) / CONFIG_SYS_HZ;
-
-	printf("\ntime:");
-	if (minutes)
-		printf(" %lu minutes,", minutes);
-	printf(" %lu.%03lu seconds, %lu ticks\n",
-			seconds, milliseconds, cycles);
+	printf("\ntime: ");
+	print_seconds(cycles);
+	printf(", %llu ticks\n", cycles);
+	report_acct(cycles, acct);
+}
+
+static void time_account(const char *name, unsigned long long cycles,
+			 const unsigned long long *acct)
+{
+	struct time_entry *e, *free_e = NULL;
+	int i;
+
+	for (e = time_table; e < time_table + CONFIG_SYS_TIME_ENTRIES; e++) {
+		if (!e->runs) {
+			if (!free_e)
+				free_e = e;
+		} else if (!strncmp(e->name, name, sizeof(e->name) - 1)) {
+			break;
+		}
+	}
+	if (e == time_table + CONFIG_SYS_TIME_ENTRIES) {
+		if (!free_e)
+			return;		/* table full, not counted */
+		e = free_e;
+		strncpy(e->name, name, sizeof(e->name) - 1);
+	}
+
+	e->runs++;
+	e->total += cycles;
+	for (i = 0; i < TIME_ACCT_KINDS; i++)
+		e->acct[i] += acct[i];
+}
+
+static void time_show_table(void)
+{
+	struct time_entry *e;
+#ifdef CONFIG_CMD_TIME_ACCT
+	int i;
+#endif
+
+	printf("%-15s %6s  total\n", "command", "runs");
+	for (e = time_table; e < time_table + CONFIG_SYS_TIME_ENTRIES; e++) {
+		if (!e->runs)
+			continue;
+		printf("%-15s %6lu  ", e->name, e->runs);
+		print_seconds(e->total);
+#ifdef CONFIG_CMD_TIME_ACCT
+		for (i = 0; i < TIME_ACCT_KINDS; i++) {
+			printf(", %s ", time_acct_names[i]);
+			print_seconds(e->acct[i]);
+		}
+#endif
+		putc('\n');
+	}
 }
 
 static int do_time(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	ulong cycles = 0;
+	unsigned long long cycles = 0;
+	unsigned long long acct[TIME_ACCT_KINDS] = { 0 };
 	int retval = 0;
 
 	if (argc == 1)
 		return cmd_usage(cmdtp);
 
-	retval = run_command_and_time_it(0, argc - 1, argv + 1, &cycles);
-	report_time(cycles);
+	if (argc == 2 && !strcmp(argv[1], "-s")) {
+		time_show_table();
+		return 0;
+	}
+	if (argc == 2 && !strcmp(argv[1], "-c")) {
+		memset(time_table, 0, sizeof(time_table));
+		return 0;
+	}
+
+	retval = run_command_and_time_it(0, argc - 1, argv + 1, &cycles, acct);
+	report_time(cycles, acct);
+	if (cycles)
+		time_account(argv[1], cycles, acct);
 
 	return retval;
 }
 
 U_BOOT_CMD(time, CONFIG_SYS_MAXARGS, 0, do_time,
 		"run commands and summarize execution time",
-		"command [args...]\n");
+		"command [args...]\n"
+		"time -s - show the time taken by each command so far\n"
+		"time -c - clear that table\n");
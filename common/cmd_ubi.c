@@ -199,6 +199,12 @@ static struct ubi_volume *ubi_find_volume(char *volume)
 	struct ubi_volume *vol = NULL;
 	int i;
 
+	/* ubi_volume_begin_write() may be called before "ubi part" */
+	if (!ubi_dev.selected) {
+		printf("Error, no UBI device/partition selected!\n");
+		return NULL;
+	}
+
 	for (i = 0; i < ubi->vtbl_slots; i++) {
 		vol = ubi->volumes[i];
 		if (vol && !strcmp(vol->name, volume))
@@ -263,26 +269,30 @@ out_err:
 	return err;
 }
 
-static int ubi_volume_write(char *volume, void *buf, size_t size)
+/*
+ * A volume update may come in pieces: ubi_volume_begin_write() is told
+ * the size of the whole image and given its first piece, and takes the
+ * rest from ubi_volume_continue_write().  UBI writes each logical
+ * eraseblock as soon as it is complete, so only one of them is held in
+ * memory, not the image.
+ */
+int ubi_volume_continue_write(char *volume, void *buf, size_t size)
 {
 	int err = 1;
-	int rsvd_bytes = 0;
 	struct ubi_volume *vol;
 
 	vol = ubi_find_volume(volume);
 	if (vol == NULL)
 		return ENODEV;
 
-	rsvd_bytes = vol->reserved_pebs * (ubi->leb_size - vol->data_pad);
-	if (size < 0 || size > rsvd_bytes) {
-		printf("size > volume size! Aborting!\n");
+	if (!vol->updating) {
+		printf("No update of volume %s in progress\n", volume);
 		return EINVAL;
 	}
 
-	err = ubi_start_update(ubi, vol, size);
-	if (err < 0) {
-		printf("Cannot start volume update\n");
-		return -err;
+	if (vol->upd_received + size > vol->upd_bytes) {
+		printf("More data than the update started with! Aborting!\n");
+		return EINVAL;
 	}
 
 	err = ubi_more_update_data(ubi, vol, buf, size);
@@ -292,8 +302,6 @@ static int ubi_volume_write(char *volume, void *buf, size_t size)
 	}
 
 	if (err) {
-		size = err;
-
 		err = ubi_check_volume(ubi, vol->vol_id);
 		if (err < 0)
 			return -err;
@@ -306,13 +314,51 @@ static int ubi_volume_write(char *volume, void *buf, size_t size)
 
 		vol->checked = 1;
 		ubi_gluebi_updated(vol);
-	}
 
-	printf("%d bytes written to volume %s\n", size, volume);
+		printf("%lld bytes written to volume %s\n", vol->upd_bytes,
+		       volume);
+	}
 
 	return 0;
 }
 
+int ubi_volume_begin_write(char *volume, void *buf, size_t size,
+			   size_t full_size)
+{
+	int err = 1;
+	int rsvd_bytes = 0;
+	struct ubi_volume *vol;
+
+	vol = ubi_find_volume(volume);
+	if (vol == NULL)
+		return ENODEV;
+
+	rsvd_bytes = vol->reserved_pebs * (ubi->leb_size - vol->data_pad);
+	if (size > full_size || full_size > rsvd_bytes) {
+		printf("size > volume size! Aborting!\n");
+		return EINVAL;
+	}
+
+	err = ubi_start_update(ubi, vol, full_size);
+	if (err < 0) {
+		printf("Cannot start volume update\n");
+		return -err;
+	}
+
+	/* nothing more to do for an empty image */
+	if (!full_size) {
+		printf("0 bytes written to volume %s\n", volume);
+		return 0;
+	}
+
+	return ubi_volume_continue_write(volume, buf, size);
+}
+
+static int ubi_volume_write(char *volume, void *buf, size_t size)
+{
+	return ubi_volume_begin_write(volume, buf, size, size);
+}
+
 static int ubi_volume_read(char *volume, char *buf, size_t size)
 {
 	int err, lnum, off, len, tbuf_size;
@@ -435,6 +481,7 @@ static int do_ubi(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 {
 	size_t size = 0;
 	ulong addr = 0;
+	char *s;
 	int err = 0;
 
 	if (argc < 2)
@@ -579,6 +626,18 @@ static int do_ubi(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		addr = simple_strtoul(argv[2], NULL, 16);
 		size = simple_strtoul(argv[4], NULL, 16);
 
+		/* E.g., write.part address volume size [fullsize] */
+		s = strchr(argv[1], '.');
+		if (s && !strcmp(s, ".part")) {
+			if (argc == 6)
+				return ubi_volume_begin_write(argv[3],
+						(void *)addr, size,
+						simple_strtoul(argv[5], NULL,
+							       16));
+			return ubi_volume_continue_write(argv[3],
+						(void *)addr, size);
+		}
+
 		return ubi_volume_write(argv[3], (void *)addr, size);
 	}
 
@@ -617,6 +676,9 @@ U_BOOT_CMD(
 		" - create volume name with size\n"
 	"ubi write[vol] address volume size"
 		" - Write volume from address with size\n"
+	"ubi write.part address volume size [fullsize]"
+		" - Write part of a volume from address with size;\n"
+		"   the first part gives the size of the whole image\n"
 	"ubi read[vol] address volume [size]"
 		" - Read volume to address with size\n"
 	"ubi remove[vol] volume"
@@ -231,16 +231,8 @@ do_imgextract(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 				int i;
 
 				printf("   Uncompressing part %d ... ", part);
-				/*
-				 * If we've got less than 4 MB of malloc()
-				 * space, use slower decompression algorithm
-				 * which requires at most 2300 KB of memory.
-				 */
-				i = BZ2_bzBuffToBuffDecompress(
-					(char *)ntohl(hdr->ih_load),
-					&unc_len, (char *)data, len,
-					CONFIG_SYS_MALLOC_LEN < (4096 * 1024),
-					0);
+				i = bunzip2((char *)dest, &unc_len,
+					    (char *)data, len);
 				if (i != BZ_OK) {
 					printf("BUNZIP2 ERROR %d - "
 						"image not loaded\n", i);
@@ -29,6 +29,8 @@
 #include <command.h>
 #include <linux/ctype.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*
  * Use puts() instead of printf() to avoid printf buffer overflow
  * for long help messages
@@ -135,10 +137,85 @@ cmd_tbl_t *find_cmd_tbl (const char *cmd, cmd_tbl_t *table, int table_len)
 	return NULL;	/* not found or ambiguous command */
 }
 
+/*
+ * The linker scripts sort the command table by name.  It is checked
+ * once anyway, as a board linker script may not; the table is then
+ * searched linearly as before.
+ */
+static int cmd_tbl_sorted(cmd_tbl_t *start, cmd_tbl_t *end)
+{
+	static int sorted = -1;
+	cmd_tbl_t *prev, *cmdtp;
+
+	if (sorted < 0) {
+		sorted = 1;
+		for (prev = NULL, cmdtp = start; cmdtp != end; cmdtp++) {
+			if (prev && strcmp(prev->name, cmdtp->name) >= 0) {
+				debug("command table not sorted at %s\n",
+				      cmdtp->name);
+				sorted = 0;
+				break;
+			}
+			prev = cmdtp;
+		}
+	}
+	return sorted;
+}
+
+/* Same as find_cmd_tbl(), on a table sorted by name */
+static cmd_tbl_t *find_cmd_sorted(const char *cmd, int len,
+				  cmd_tbl_t *table, int table_len)
+{
+	int lo = 0, hi = table_len;
+
+	/* the names starting with cmd follow each other, shortest first */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (strncmp(table[mid].name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == table_len || strncmp(table[lo].name, cmd, len) != 0)
+		return NULL;			/* not found */
+	if (table[lo].name[len] == '\0')
+		return &table[lo];		/* full match */
+	if (lo + 1 < table_len && strncmp(table[lo + 1].name, cmd, len) == 0)
+		return NULL;			/* ambiguous command */
+	return &table[lo];			/* abbreviated command */
+}
+
 cmd_tbl_t *find_cmd (const char *cmd)
 {
-	int len = &__u_boot_cmd_end - &__u_boot_cmd_start;
-	return find_cmd_tbl(cmd, &__u_boot_cmd_start, len);
+	static cmd_tbl_t *last_cmdtp;
+	static char last_cmd[16];
+	cmd_tbl_t *cmdtp;
+	int table_len = &__u_boot_cmd_end - &__u_boot_cmd_start;
+	const char *p;
+	int len;
+
+	/* the table can not be checked, nor the cache kept, in flash */
+	if (!cmd || !(gd->flags & GD_FLG_RELOC) ||
+	    !cmd_tbl_sorted(&__u_boot_cmd_start, &__u_boot_cmd_end))
+		return find_cmd_tbl(cmd, &__u_boot_cmd_start, table_len);
+
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen (cmd) : (p - cmd);
+
+	/* scripts tend to run the same command over and over */
+	if (last_cmdtp && strncmp(cmd, last_cmd, len) == 0 &&
+	    last_cmd[len] == '\0')
+		return last_cmdtp;
+
+	cmdtp = find_cmd_sorted(cmd, len, &__u_boot_cmd_start, table_len);
+	last_cmdtp = NULL;
+	if (cmdtp && len < sizeof(last_cmd)) {
+		memcpy(last_cmd, cmd, len);
+		last_cmd[len] = '\0';
+		last_cmdtp = cmdtp;
+	}
+	return cmdtp;
 }
 
 int cmd_usage(const cmd_tbl_t *cmdtp)
@@ -445,7 +522,6 @@ int cmd_get_data_size(char* arg, int default_size)
 #endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
-DECLARE_GLOBAL_DATA_PTR;
 
 void fixup_cmdtable(cmd_tbl_t *cmdtp, int size)
 {
@@ -29,6 +29,10 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if defined(CONFIG_CONSOLE_QUIET_BOOT) && !defined(CONFIG_PRE_CONSOLE_BUFFER)
+#error "CONFIG_CONSOLE_QUIET_BOOT needs CONFIG_PRE_CONSOLE_BUFFER"
+#endif
+
 #ifdef CONFIG_SYS_CONSOLE_IS_IN_ENV
 /*
  * if overwrite_console returns 1, the stdin, stderr and stdout
@@ -89,6 +93,37 @@ static int console_setfile(int file, struct stdio_dev * dev)
 	return error;
 }
 
+#ifdef CONFIG_CONSOLE_STATS
+/* Count what goes to each device, and how long writing it takes */
+static void console_dev_putc(struct stdio_dev *dev, const char c)
+{
+	unsigned long long start = get_ticks();
+
+	dev->putc(c);
+	dev->out_ticks += get_ticks() - start;
+	dev->out_bytes++;
+}
+
+static void console_dev_puts(struct stdio_dev *dev, const char *s)
+{
+	unsigned long long start = get_ticks();
+
+	dev->puts(s);
+	dev->out_ticks += get_ticks() - start;
+	dev->out_bytes += strlen(s);
+}
+#else
+static inline void console_dev_putc(struct stdio_dev *dev, const char c)
+{
+	dev->putc(c);
+}
+
+static inline void console_dev_puts(struct stdio_dev *dev, const char *s)
+{
+	dev->puts(s);
+}
+#endif /* CONFIG_CONSOLE_STATS */
+
 #if defined(CONFIG_CONSOLE_MUX)
 /** Console I/O multiplexing *******************************************/
 
@@ -142,7 +177,7 @@ static void console_putc(int file, const char c)
 	for (i = 0; i < cd_count[file]; i++) {
 		dev = console_devices[file][i];
 		if (dev->putc != NULL)
-			dev->putc(c);
+			console_dev_putc(dev, c);
 	}
 }
 
@@ -154,7 +189,7 @@ static void console_puts(int file, const char *s)
 	for (i = 0; i < cd_count[file]; i++) {
 		dev = console_devices[file][i];
 		if (dev->puts != NULL)
-			dev->puts(s);
+			console_dev_puts(dev, s);
 	}
 }
 
@@ -180,12 +215,12 @@ static inline int console_tstc(int file)
 
 static inline void console_putc(int file, const char c)
 {
-	stdio_devices[file]->putc(c);
+	console_dev_putc(stdio_devices[file], c);
 }
 
 static inline void console_puts(int file, const char *s)
 {
-	stdio_devices[file]->puts(s);
+	console_dev_puts(stdio_devices[file], s);
 }
 
 static inline void console_printdevs(int file)
@@ -301,6 +336,9 @@ int getc(void)
 	if (!gd->have_console)
 		return 0;
 
+	/* stdin may not be the UART that output is waiting for */
+	serial_tx_poll();
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Get from the standard input */
 		return fgetc(stdin);
@@ -320,6 +358,8 @@ int tstc(void)
 	if (!gd->have_console)
 		return 0;
 
+	serial_tx_poll();
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Test the standard input */
 		return ftstc(stdin);
@@ -332,13 +372,18 @@ int tstc(void)
 #if defined(CONFIG_PRE_CONSOLE_BUFFER) || defined(CONFIG_PRE_CONSOLE_PUTC)
 #define CIRC_BUF_IDX(idx) ((idx) % (unsigned long)CONFIG_PRE_CON_BUF_SZ)
 
-static void pre_console_putc(const char c)
+static void pre_console_buffer_putc(const char c)
 {
 #ifdef CONFIG_PRE_CONSOLE_BUFFER
 	char *buffer = (char *)CONFIG_PRE_CON_BUF_ADDR;
 
 	buffer[CIRC_BUF_IDX(gd->precon_buf_idx++)] = c;
 #endif
+}
+
+static void pre_console_putc(const char c)
+{
+	pre_console_buffer_putc(c);
 #ifdef CONFIG_PRE_CONSOLE_PUTC
 	board_pre_console_putc(c);
 #endif
@@ -365,11 +410,47 @@ static void print_pre_console_buffer(void)
 }
 
 #else
+static inline void pre_console_buffer_putc(const char c) {}
 static inline void pre_console_putc(const char c) {}
 static inline void pre_console_puts(const char *s) {}
 static inline void print_pre_console_buffer(void) {}
 #endif
 
+#ifdef CONFIG_CONSOLE_QUIET_BOOT
+/*
+ * With "quiet" set, output goes on to the pre-console buffer after the
+ * console is up, and is only printed once something goes wrong: the
+ * user stops the boot, hits ^C, bootcmd returns or U-Boot panics.
+ * After a good boot it is still there for whoever looks.
+ */
+void console_quiet_flush(void)
+{
+	if (!(gd->flags & GD_FLG_QUIET))
+		return;
+
+	gd->flags &= ~GD_FLG_QUIET;
+	print_pre_console_buffer();
+}
+
+static inline int console_quiet(void)
+{
+	return gd->flags & GD_FLG_QUIET;
+}
+
+static void console_quiet_puts(const char *s)
+{
+	while (*s)
+		pre_console_buffer_putc(*s++);
+}
+#else
+static inline int console_quiet(void)
+{
+	return 0;
+}
+
+static inline void console_quiet_puts(const char *s) {}
+#endif /* CONFIG_CONSOLE_QUIET_BOOT */
+
 void putc(const char c)
 {
 #ifdef CONFIG_SILENT_CONSOLE
@@ -385,6 +466,9 @@ void putc(const char c)
 	if (!gd->have_console)
 		return pre_console_putc(c);
 
+	if (console_quiet())
+		return pre_console_buffer_putc(c);
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Send to the standard output */
 		fputc(stdout, c);
@@ -409,6 +493,9 @@ void puts(const char *s)
 	if (!gd->have_console)
 		return pre_console_puts(s);
 
+	if (console_quiet())
+		return console_quiet_puts(s);
+
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Send to the standard output */
 		fputs(stdout, s);
@@ -467,10 +554,20 @@ static int ctrlc_disabled = 0;	/* see disable_ctrl() */
 static int ctrlc_was_pressed = 0;
 int ctrlc(void)
 {
+#ifdef CONFIG_SYS_CTRLC_POLL_MS
+	static ulong last_poll;
+
+	if (!ctrlc_disabled && gd->have_console) {
+		if (get_timer(last_poll) < CONFIG_SYS_CTRLC_POLL_MS)
+			return 0;
+		last_poll = get_timer(0);
+	}
+#endif
 	if (!ctrlc_disabled && gd->have_console) {
 		if (tstc()) {
 			switch (getc()) {
 			case 0x03:		/* ^C - Control C */
+				console_quiet_flush();
 				ctrlc_was_pressed = 1;
 				return 1;
 			default:
@@ -592,6 +689,14 @@ int console_init_f(void)
 		gd->flags |= GD_FLG_SILENT;
 #endif
 
+#ifdef CONFIG_CONSOLE_QUIET_BOOT
+	/* keep what is in the buffer there, with what follows */
+	if (getenv("quiet") != NULL) {
+		gd->flags |= GD_FLG_QUIET;
+		return 0;
+	}
+#endif
+
 	print_pre_console_buffer();
 
 	return 0;
@@ -0,0 +1,839 @@
+/*
+ * dl_part.c -- storage areas the download commands write images to
+ *
+ * Images come in over USB or the network a piece at a time, and are
+ * written as they come: MMC areas take whole blocks at their place, NAND
+ * areas are erased a block ahead of the data and skip the bad blocks on
+ * the way.  FAT files can only be written whole.  UBI volumes are updated
+ * a piece at a time, UBI collecting whole logical eraseblocks itself.
+ * Sparse images are unpacked as they come, so that only their data is
+ * written.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <nand.h>
+#include <fat.h>
+#include <div64.h>
+#include <dl_part.h>
+#include <sparse_format.h>
+#include <asm/unaligned.h>
+#ifdef CONFIG_CMD_UBI
+#include <ubi_uboot.h>
+#endif
+
+static int dl_part_parse(char *entry, struct dl_part *part)
+{
+	char *argv[5];
+	char *p;
+	int argc = 0;
+
+	while ((p = strsep(&entry, " \t")) != NULL && argc < 5)
+		if (*p)
+			argv[argc++] = p;
+	if (argc < 2)
+		return -1;
+
+	memset(part, 0, sizeof(*part));
+	strncpy(part->name, argv[0], sizeof(part->name) - 1);
+
+	if (!strcmp(argv[1], "mmc") && argc == 5) {
+		part->type = DL_PART_MMC;
+		part->dev = simple_strtoul(argv[2], NULL, 16);
+		part->start = simple_strtoul(argv[3], NULL, 16);
+		part->size = simple_strtoul(argv[4], NULL, 16);
+	} else if (!strcmp(argv[1], "nand") && argc == 4) {
+		part->type = DL_PART_NAND;
+		part->start = simple_strtoul(argv[2], NULL, 16);
+		part->size = simple_strtoul(argv[3], NULL, 16);
+	} else if (!strcmp(argv[1], "fat") && argc == 4) {
+		part->type = DL_PART_FAT;
+		part->dev = simple_strtoul(argv[2], NULL, 16);
+		part->part = simple_strtoul(argv[3], NULL, 16);
+	} else if (!strcmp(argv[1], "ubi") && argc == 2) {
+		part->type = DL_PART_UBI;
+	} else {
+		printf("%s: bad area \"%s\"\n", __func__, argv[0]);
+		return -1;
+	}
+	return 0;
+}
+
+/* The index'th area, or the one called name */
+static int dl_part_scan(const char *list, const char *name, int index,
+			struct dl_part *part)
+{
+	char entry[128];
+	const char *end;
+	int len, n;
+
+	for (n = 0; list && *list; n++) {
+		end = strchr(list, ';');
+		len = end ? end - list : strlen(list);
+		if (len >= sizeof(entry))
+			len = sizeof(entry) - 1;
+		memcpy(entry, list, len);
+		entry[len] = '\0';
+		list = end ? end + 1 : NULL;
+
+		if (dl_part_parse(entry, part))
+			continue;
+		if (name ? !strcmp(part->name, name) : n == index)
+			return 0;
+	}
+	return -1;
+}
+
+int dl_part_find(const char *list, const char *name, struct dl_part *part)
+{
+	return dl_part_scan(list, name, 0, part);
+}
+
+int dl_part_get(const char *list, int index, struct dl_part *part)
+{
+	return dl_part_scan(list, NULL, index, part);
+}
+
+/*-------------------------------------------------------------------------*/
+
+#ifdef CONFIG_GENERIC_MMC
+static int dl_mmc_open(struct dl_part *part)
+{
+	struct mmc *mmc = find_mmc_device(part->dev);
+
+	if (!mmc || mmc_init(mmc)) {
+		printf("%s: no MMC device %d\n", part->name, part->dev);
+		return -1;
+	}
+	part->unit = mmc->write_bl_len;
+	return 0;
+}
+
+static int dl_mmc_write(struct dl_part *part, void *buf, ulong len)
+{
+	struct mmc *mmc = find_mmc_device(part->dev);
+	ulong blk = lldiv(part->pos, part->unit);
+	ulong blocks = len / part->unit;
+
+	if (blk + blocks > part->size) {
+		printf("%s: image too large\n", part->name);
+		return -1;
+	}
+
+	if (mmc->block_dev.block_write(part->dev, part->start + blk,
+				       blocks, buf) != blocks) {
+		printf("%s: MMC write failed\n", part->name);
+		return -1;
+	}
+	return 0;
+}
+
+static int dl_mmc_erase(struct dl_part *part)
+{
+	struct mmc *mmc;
+
+	if (dl_mmc_open(part))
+		return -1;
+	mmc = find_mmc_device(part->dev);
+
+	if (mmc->block_dev.block_erase(part->dev, part->start,
+				       part->size) != part->size) {
+		printf("%s: MMC erase failed\n", part->name);
+		return -1;
+	}
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_CMD_NAND
+static int dl_nand_erase_range(struct dl_part *part, u64 off, u64 len)
+{
+	nand_info_t *nand = &nand_info[nand_curr_device];
+	nand_erase_options_t opts;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.offset = off;
+	opts.length = len;
+	opts.quiet = 1;
+
+	if (nand_erase_opts(nand, &opts)) {
+		printf("%s: NAND erase failed\n", part->name);
+		return -1;
+	}
+	return 0;
+}
+
+static int dl_nand_open(struct dl_part *part)
+{
+	nand_info_t *nand = &nand_info[nand_curr_device];
+
+	if (part->start & (nand->erasesize - 1)) {
+		printf("%s: not on an erase block\n", part->name);
+		return -1;
+	}
+	part->unit = nand->writesize;
+	part->nand_off = part->start;
+	return 0;
+}
+
+/* At the start of an erase block: find a good one and erase it */
+static int dl_nand_enter_block(struct dl_part *part)
+{
+	nand_info_t *nand = &nand_info[nand_curr_device];
+	u64 end = (u64)part->start + part->size;
+
+	if (part->nand_off & (nand->erasesize - 1))
+		return 0;
+
+	while (part->nand_off < end &&
+	       nand_block_isbad(nand, part->nand_off)) {
+		printf("%s: skipping bad block 0x%08llx\n",
+		       part->name, part->nand_off);
+		part->nand_off += nand->erasesize;
+	}
+	if (part->nand_off >= end) {
+		printf("%s: image too large\n", part->name);
+		return -1;
+	}
+	return dl_nand_erase_range(part, part->nand_off, nand->erasesize);
+}
+
+static int dl_nand_write(struct dl_part *part, void *buf, ulong len)
+{
+	nand_info_t *nand = &nand_info[nand_curr_device];
+	size_t n;
+
+	while (len) {
+		if (dl_nand_enter_block(part))
+			return -1;
+
+		n = nand->erasesize - (part->nand_off & (nand->erasesize - 1));
+		if (n > len)
+			n = len;
+		if (nand_write(nand, part->nand_off, &n, buf)) {
+			printf("%s: NAND write failed\n", part->name);
+			return -1;
+		}
+		part->nand_off += n;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/* What the image did not cover is erased, as a flash tool would */
+static int dl_nand_close(struct dl_part *part)
+{
+	nand_info_t *nand = &nand_info[nand_curr_device];
+	u64 end = (u64)part->start + part->size;
+	u64 off;
+
+	off = (part->nand_off + nand->erasesize - 1) &
+		~(u64)(nand->erasesize - 1);
+	if (off >= end)
+		return 0;
+	return dl_nand_erase_range(part, off, end - off);
+}
+#endif
+
+#ifdef CONFIG_FAT_WRITE
+static int dl_fat_write(struct dl_part *part, void *buf, ulong len)
+{
+	block_dev_desc_t *dev_desc = get_dev("mmc", part->dev);
+
+	if (part->pos) {
+		printf("%s: FAT files are written whole\n", part->name);
+		return -1;
+	}
+	if (!dev_desc || fat_register_device(dev_desc, part->part)) {
+		printf("%s: no FAT on mmc %d:%d\n", part->name,
+		       part->dev, part->part);
+		return -1;
+	}
+	if (file_fat_write(part->name, buf, len) < 0) {
+		printf("%s: FAT write failed\n", part->name);
+		return -1;
+	}
+	part->pos += len;
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_CMD_UBI
+static int dl_ubi_write(struct dl_part *part, void *buf, ulong len)
+{
+	int ret;
+
+	if (!part->image_len) {
+		printf("%s: size of the image not known\n", part->name);
+		return -1;
+	}
+	if (part->pos + len > part->image_len) {
+		printf("%s: image larger than %lu bytes\n", part->name,
+		       part->image_len);
+		return -1;
+	}
+	if (!part->pos)
+		ret = ubi_volume_begin_write(part->name, buf, len,
+					     part->image_len);
+	else
+		ret = ubi_volume_continue_write(part->name, buf, len);
+	if (ret)
+		return -1;
+	part->pos += len;
+	return 0;
+}
+
+static int dl_ubi_close(struct dl_part *part)
+{
+	if (part->pos != part->image_len) {
+		printf("%s: image incomplete, volume left corrupted\n",
+		       part->name);
+		return -1;
+	}
+	return 0;
+}
+#endif
+
+/*-------------------------------------------------------------------------*/
+
+/* Write whole blocks or pages */
+static int dl_part_write_units(struct dl_part *part, void *buf, ulong len)
+{
+	int ret = -1;
+
+	switch (part->type) {
+#ifdef CONFIG_GENERIC_MMC
+	case DL_PART_MMC:
+		ret = dl_mmc_write(part, buf, len);
+		break;
+#endif
+#ifdef CONFIG_CMD_NAND
+	case DL_PART_NAND:
+		ret = dl_nand_write(part, buf, len);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (!ret)
+		part->pos += len;
+	return ret;
+}
+
+int dl_part_open(struct dl_part *part)
+{
+	int ret = -1;
+
+	part->pos = 0;
+	part->tail = NULL;
+	part->tail_len = 0;
+	part->unit = 0;
+	part->sparse = NULL;
+
+	switch (part->type) {
+#ifdef CONFIG_GENERIC_MMC
+	case DL_PART_MMC:
+		ret = dl_mmc_open(part);
+		break;
+#endif
+#ifdef CONFIG_CMD_NAND
+	case DL_PART_NAND:
+		ret = dl_nand_open(part);
+		break;
+#endif
+#ifdef CONFIG_FAT_WRITE
+	case DL_PART_FAT:
+		return 0;
+#endif
+#ifdef CONFIG_CMD_UBI
+	case DL_PART_UBI:
+		return 0;
+#endif
+	default:
+		printf("%s: storage not supported\n", part->name);
+		return -1;
+	}
+	if (ret)
+		return ret;
+
+	part->tail = malloc(part->unit);
+	if (!part->tail)
+		return -1;
+	return 0;
+}
+
+static int dl_part_write_data(struct dl_part *part, void *buf, ulong len)
+{
+	u8 *p = buf;
+	ulong n;
+
+	/* top up what was left over from the last piece */
+	if (part->tail_len) {
+		n = min(len, part->unit - part->tail_len);
+		memcpy(part->tail + part->tail_len, p, n);
+		part->tail_len += n;
+		p += n;
+		len -= n;
+		if (part->tail_len < part->unit)
+			return 0;
+		part->tail_len = 0;
+		if (dl_part_write_units(part, part->tail, part->unit))
+			return -1;
+	}
+
+	n = len - len % part->unit;
+	if (n && dl_part_write_units(part, p, n))
+		return -1;
+
+	part->tail_len = len - n;
+	memcpy(part->tail, p + n, part->tail_len);
+	return 0;
+}
+
+#ifdef CONFIG_SPARSE_IMAGE
+/*
+ * The data of RAW chunks goes through as that of a plain image.  The
+ * blocks of the other chunks are only written where nothing better
+ * can be done: DONT_CARE ones are skipped on MMC and just erased on
+ * NAND, FILL ones of 0xffffffff are erased on NAND, and long ones of
+ * zeros are erased on MMC cards that read erased blocks as zeros.
+ * Large images come from fastboot as several sparse images, each
+ * covering the rest with DONT_CARE, so those blocks must not be
+ * trimmed.  A piece of a block or page at the ends of a chunk goes
+ * through the tail like data.
+ */
+#define DL_SPARSE_FILL_SIZE	(64 << 10)
+#define DL_SPARSE_ERASE_MIN	(64 << 10)
+
+enum dl_sparse_state {
+	DL_SPARSE_FILE_HDR,
+	DL_SPARSE_CHUNK_HDR,
+	DL_SPARSE_RAW,
+	DL_SPARSE_FILL,
+	DL_SPARSE_DONE,
+};
+
+struct dl_sparse {
+	enum dl_sparse_state state;
+	union {
+		sparse_header_t	file;
+		chunk_header_t	chunk;
+		u32		fill;
+	} hdr;				/* being collected */
+	ulong		have, need;	/* bytes of hdr */
+	ulong		skip;		/* input to drop before going on */
+	u64		left;		/* of the RAW data */
+	u64		len;		/* of the FILL chunk in the image */
+	u32		blk_sz;
+	u32		blocks;		/* the chunks may still cover */
+	u32		chunks;		/* still to come */
+	u16		chunk_hdr_sz;
+	u32		pattern;	/* the fill_buf holds, in file order */
+	u8		*fill_buf;
+	ulong		fill_size;
+};
+
+#ifdef CONFIG_GENERIC_MMC
+/* Returns 1 if the blocks have to be written after all */
+static int dl_mmc_gap(struct dl_part *part, u64 len, u32 fill,
+		      int dont_care)
+{
+	struct mmc *mmc = find_mmc_device(part->dev);
+	ulong blk = lldiv(part->pos, part->unit);
+	ulong blocks = lldiv(len, part->unit);
+	uint grp = mmc->erase_grp_size;
+
+	if (blk + blocks > part->size) {
+		printf("%s: image too large\n", part->name);
+		return -1;
+	}
+
+	if (!dont_care) {
+		if (fill || len < DL_SPARSE_ERASE_MIN ||
+		    !(mmc->erase_caps & MMC_ERASE_CAP_ZERO))
+			return 1;
+		/* only a card that trims can leave the blocks around alone */
+		if (!(mmc->erase_caps & MMC_ERASE_CAP_TRIM) && grp > 1 &&
+		    ((part->start + blk) % grp || blocks % grp))
+			return 1;
+		if (mmc_erase_blocks(part->dev, part->start + blk, blocks,
+				     MMC_ERASE_ARG) != blocks) {
+			printf("%s: MMC erase failed\n", part->name);
+			return -1;
+		}
+	}
+	part->pos += len;
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_CMD_NAND
+/* Returns 1 if the pages have to be written after all */
+static int dl_nand_gap(struct dl_part *part, u64 len, u32 fill,
+		       int dont_care)
+{
+	nand_info_t *nand = &nand_info[nand_curr_device];
+	u64 left = len, n;
+
+	if (!dont_care && fill != 0xffffffff)
+		return 1;
+
+	/* the erase blocks passed are erased like those written */
+	while (left) {
+		if (dl_nand_enter_block(part))
+			return -1;
+		n = nand->erasesize - (part->nand_off & (nand->erasesize - 1));
+		if (n > left)
+			n = left;
+		part->nand_off += n;
+		left -= n;
+	}
+	part->pos += len;
+	return 0;
+}
+#endif
+
+static void dl_sparse_pattern(struct dl_sparse *sp, u32 fill)
+{
+	u32 *p = (u32 *)sp->fill_buf;
+	ulong i;
+
+	if (sp->pattern == fill)
+		return;
+	for (i = 0; i < sp->fill_size / 4; i++)
+		p[i] = fill;
+	sp->pattern = fill;
+}
+
+/* len bytes of the image filled with fill, or not mattering */
+static int dl_sparse_gap(struct dl_part *part, u64 len, u32 fill,
+			 int dont_care)
+{
+	struct dl_sparse *sp = part->sparse;
+	ulong mask = part->unit - 1;
+	u64 units;
+	ulong n;
+	int ret = 1;
+
+	if (dont_care)
+		fill = part->type == DL_PART_NAND ? 0xffffffff : 0;
+	dl_sparse_pattern(sp, fill);
+
+	while (len && (part->tail_len || len <= mask)) {
+		n = part->unit - part->tail_len;
+		if (n > len)
+			n = len;
+		if (dl_part_write_data(part, sp->fill_buf, n))
+			return -1;
+		len -= n;
+	}
+
+	units = len & ~(u64)mask;
+	if (!units)
+		return 0;
+
+	switch (part->type) {
+#ifdef CONFIG_GENERIC_MMC
+	case DL_PART_MMC:
+		ret = dl_mmc_gap(part, units, fill, dont_care);
+		break;
+#endif
+#ifdef CONFIG_CMD_NAND
+	case DL_PART_NAND:
+		ret = dl_nand_gap(part, units, fill, dont_care);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (ret < 0)
+		return ret;
+
+	while (ret && units) {
+		n = units > sp->fill_size ? sp->fill_size : units;
+		if (dl_part_write_units(part, sp->fill_buf, n))
+			return -1;
+		units -= n;
+	}
+
+	n = len & mask;
+	return n ? dl_part_write_data(part, sp->fill_buf, n) : 0;
+}
+
+static void dl_sparse_expect(struct dl_sparse *sp,
+			     enum dl_sparse_state state, ulong need)
+{
+	sp->state = state;
+	sp->have = 0;
+	sp->need = need;
+}
+
+static void dl_sparse_next_chunk(struct dl_sparse *sp)
+{
+	if (sp->chunks)
+		dl_sparse_expect(sp, DL_SPARSE_CHUNK_HDR,
+				 sizeof(chunk_header_t));
+	else
+		sp->state = DL_SPARSE_DONE;
+}
+
+static int dl_sparse_file_hdr(struct dl_part *part)
+{
+	struct dl_sparse *sp = part->sparse;
+	sparse_header_t *h = &sp->hdr.file;
+
+	sp->blk_sz = le32_to_cpu(h->blk_sz);
+	sp->blocks = le32_to_cpu(h->total_blks);
+	sp->chunks = le32_to_cpu(h->total_chunks);
+	sp->chunk_hdr_sz = le16_to_cpu(h->chunk_hdr_sz);
+
+	if (le16_to_cpu(h->major_version) != SPARSE_HEADER_MAJOR_VER ||
+	    le16_to_cpu(h->file_hdr_sz) < sizeof(sparse_header_t) ||
+	    sp->chunk_hdr_sz < sizeof(chunk_header_t) ||
+	    !sp->blk_sz || sp->blk_sz % 4) {
+		printf("%s: bad sparse image header\n", part->name);
+		return -1;
+	}
+
+	sp->skip = le16_to_cpu(h->file_hdr_sz) - sizeof(sparse_header_t);
+	dl_sparse_next_chunk(sp);
+	return 0;
+}
+
+static int dl_sparse_chunk_hdr(struct dl_part *part)
+{
+	struct dl_sparse *sp = part->sparse;
+	chunk_header_t *c = &sp->hdr.chunk;
+	u32 blocks = le32_to_cpu(c->chunk_sz);
+	u32 total = le32_to_cpu(c->total_sz);
+	u64 len = (u64)blocks * sp->blk_sz;
+	u64 data = total - sp->chunk_hdr_sz;
+	int ok;
+
+	if (blocks > sp->blocks || total < sp->chunk_hdr_sz) {
+		printf("%s: bad sparse image chunk\n", part->name);
+		return -1;
+	}
+	sp->blocks -= blocks;
+	sp->chunks--;
+	sp->skip = sp->chunk_hdr_sz - sizeof(chunk_header_t);
+
+	switch (le16_to_cpu(c->chunk_type)) {
+	case CHUNK_TYPE_RAW:
+		ok = data == len;
+		sp->left = len;
+		if (len)
+			sp->state = DL_SPARSE_RAW;
+		else
+			dl_sparse_next_chunk(sp);
+		break;
+	case CHUNK_TYPE_FILL:
+		ok = data == sizeof(u32);
+		sp->len = len;
+		dl_sparse_expect(sp, DL_SPARSE_FILL, sizeof(u32));
+		break;
+	case CHUNK_TYPE_DONT_CARE:
+		ok = data == 0;
+		if (ok && dl_sparse_gap(part, len, 0, 1))
+			return -1;
+		dl_sparse_next_chunk(sp);
+		break;
+	case CHUNK_TYPE_CRC32:
+		/* not checked: the image is never all in memory */
+		ok = 1;
+		sp->skip += data;
+		dl_sparse_next_chunk(sp);
+		break;
+	default:
+		ok = 0;
+		break;
+	}
+
+	if (!ok) {
+		printf("%s: bad sparse image chunk\n", part->name);
+		return -1;
+	}
+	return 0;
+}
+
+static int dl_sparse_write(struct dl_part *part, u8 *p, ulong len)
+{
+	struct dl_sparse *sp = part->sparse;
+	ulong n;
+	int ret;
+
+	while (len) {
+		if (sp->skip) {
+			n = min(len, sp->skip);
+			sp->skip -= n;
+			p += n;
+			len -= n;
+			continue;
+		}
+
+		switch (sp->state) {
+		case DL_SPARSE_RAW:
+			n = len;
+			if (n > sp->left)
+				n = sp->left;
+			if (dl_part_write_data(part, p, n))
+				return -1;
+			sp->left -= n;
+			p += n;
+			len -= n;
+			if (!sp->left)
+				dl_sparse_next_chunk(sp);
+			continue;
+		case DL_SPARSE_DONE:
+			/* anything after the last chunk is no part of it */
+			return 0;
+		default:
+			break;
+		}
+
+		n = min(len, sp->need - sp->have);
+		memcpy((u8 *)&sp->hdr + sp->have, p, n);
+		sp->have += n;
+		p += n;
+		len -= n;
+		if (sp->have < sp->need)
+			continue;
+
+		switch (sp->state) {
+		case DL_SPARSE_FILE_HDR:
+			ret = dl_sparse_file_hdr(part);
+			break;
+		case DL_SPARSE_CHUNK_HDR:
+			ret = dl_sparse_chunk_hdr(part);
+			break;
+		default:
+			/* the value as it is in the file, for the pattern */
+			ret = dl_sparse_gap(part, sp->len, sp->hdr.fill, 0);
+			dl_sparse_next_chunk(sp);
+			break;
+		}
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static int dl_sparse_start(struct dl_part *part)
+{
+	struct dl_sparse *sp;
+
+	sp = malloc(sizeof(*sp));
+	if (!sp)
+		return -1;
+	memset(sp, 0, sizeof(*sp));
+	sp->fill_size = max((ulong)DL_SPARSE_FILL_SIZE, part->unit);
+	sp->fill_buf = malloc(sp->fill_size);
+	if (!sp->fill_buf) {
+		free(sp);
+		return -1;
+	}
+	memset(sp->fill_buf, 0, sp->fill_size);
+
+	dl_sparse_expect(sp, DL_SPARSE_FILE_HDR, sizeof(sparse_header_t));
+	part->sparse = sp;
+	return 0;
+}
+
+static int dl_sparse_end(struct dl_part *part)
+{
+	struct dl_sparse *sp = part->sparse;
+	int ret = 0;
+
+	if (!sp)
+		return 0;
+	if (sp->state != DL_SPARSE_DONE) {
+		printf("%s: sparse image incomplete\n", part->name);
+		ret = -1;
+	}
+	free(sp->fill_buf);
+	free(sp);
+	part->sparse = NULL;
+	return ret;
+}
+#endif
+
+int dl_part_write(struct dl_part *part, void *buf, ulong len)
+{
+#ifdef CONFIG_FAT_WRITE
+	if (part->type == DL_PART_FAT)
+		return dl_fat_write(part, buf, len);
+#endif
+#ifdef CONFIG_CMD_UBI
+	if (part->type == DL_PART_UBI)
+		return dl_ubi_write(part, buf, len);
+#endif
+
+#ifdef CONFIG_SPARSE_IMAGE
+	if (!part->pos && !part->tail_len && !part->sparse && len >= 4 &&
+	    get_unaligned_le32(buf) == SPARSE_HEADER_MAGIC &&
+	    dl_sparse_start(part))
+		return -1;
+	if (part->sparse)
+		return dl_sparse_write(part, buf, len);
+#endif
+	return dl_part_write_data(part, buf, len);
+}
+
+int dl_part_close(struct dl_part *part)
+{
+	int ret = 0;
+
+#ifdef CONFIG_SPARSE_IMAGE
+	ret = dl_sparse_end(part);
+#endif
+	if (part->tail_len) {
+		memset(part->tail + part->tail_len,
+		       part->type == DL_PART_NAND ? 0xff : 0,
+		       part->unit - part->tail_len);
+		if (dl_part_write_units(part, part->tail, part->unit))
+			ret = -1;
+		part->tail_len = 0;
+	}
+
+#ifdef CONFIG_CMD_NAND
+	if (!ret && part->type == DL_PART_NAND)
+		ret = dl_nand_close(part);
+#endif
+#ifdef CONFIG_CMD_UBI
+	if (!ret && part->type == DL_PART_UBI)
+		ret = dl_ubi_close(part);
+#endif
+
+	free(part->tail);
+	part->tail = NULL;
+	return ret;
+}
+
+int dl_part_erase(struct dl_part *part)
+{
+	switch (part->type) {
+#ifdef CONFIG_GENERIC_MMC
+	case DL_PART_MMC:
+		return dl_mmc_erase(part);
+#endif
+#ifdef CONFIG_CMD_NAND
+	case DL_PART_NAND:
+		return dl_nand_erase_range(part, part->start, part->size);
+#endif
+#ifdef CONFIG_CMD_UBI
+	case DL_PART_UBI:
+		/* an update to nothing wipes the volume out */
+		return ubi_volume_begin_write(part->name, NULL, 0, 0) ? -1 : 0;
+#endif
+	default:
+		printf("%s: can't be erased\n", part->name);
+		return -1;
+	}
+}
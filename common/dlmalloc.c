@@ -930,7 +930,7 @@ struct mallinfo mALLINFo();
 #endif	/* 0 */			/* Moved to malloc.h */
 
 #include <malloc.h>
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLINFO)
 #if __STD_C
 static void malloc_update_mallinfo (void);
 void malloc_stats (void);
@@ -938,7 +938,7 @@ void malloc_stats (void);
 static void malloc_update_mallinfo ();
 void malloc_stats();
 #endif
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLINFO */
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1615,9 +1615,9 @@ static struct mallinfo current_mallinfo = {  0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 /* Tracking mmaps */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLINFO)
 static unsigned int n_mmaps = 0;
-#endif	/* DEBUG */
+#endif
 static unsigned long mmapped_mem = 0;
 #if HAVE_MMAP
 static unsigned int max_n_mmaps = 0;
@@ -3092,7 +3092,7 @@ size_t malloc_usable_size(mem) Void_t* mem;
 
 /* Utility to update current_mallinfo for malloc_stats and mallinfo() */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLINFO)
 static void malloc_update_mallinfo()
 {
   int i;
@@ -3130,7 +3130,7 @@ static void malloc_update_mallinfo()
   current_mallinfo.keepcost = chunksize(top);
 
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLINFO */
 
 
 
@@ -3149,10 +3149,12 @@ static void malloc_update_mallinfo()
 
 */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLINFO)
 void malloc_stats()
 {
   malloc_update_mallinfo();
+  printf("arena bytes      = %10u\n",
+	  (unsigned int)(mem_malloc_end - mem_malloc_start));
   printf("max system bytes = %10u\n",
 	  (unsigned int)(max_total_mem));
   printf("system bytes     = %10u\n",
@@ -3164,19 +3166,19 @@ void malloc_stats()
 	  (unsigned int)max_n_mmaps);
 #endif
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLINFO */
 
 /*
   mallinfo returns a copy of updated current mallinfo.
 */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLINFO)
 struct mallinfo mALLINFo()
 {
   malloc_update_mallinfo();
   return current_mallinfo;
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLINFO */
 
 
 
@@ -0,0 +1,293 @@
+/*
+ * Journaled environment storage
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * The environment area holds a base image, checked by the CRC in the
+ * env_t header like the plain format but covering only the variables
+ * up to the terminating empty string, followed by erased (0xFF) space.
+ * saveenv appends the variables changed since the last save to that
+ * space as a record:
+ *
+ *	magic, length and CRC32 of the data, each 32 bits little endian
+ *	"name=value\0" for each changed, "name=\0" for each deleted one
+ *
+ * Records are replayed over the base on import; a record that does not
+ * check out (power lost while writing it) ends the replay.  When the
+ * next record does not fit, the area is erased and a new base written.
+ */
+
+#include <common.h>
+#include <environment.h>
+#include <malloc.h>
+#include <search.h>
+#include <errno.h>
+#include <linux/stddef.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define ENV_JOURNAL_MAGIC	0x4a564e45	/* "ENVJ" */
+#define ENV_JOURNAL_HDR_SIZE	12
+#define ENV_DATA_OFFSET		offsetof(env_t, data)
+
+static env_t *jimg;		/* what the environment area holds */
+static char *jsnap;		/* the variables jimg stands for, exported */
+static char *jpending;		/* jsnap after the write in progress */
+static size_t jend;		/* end of the last record; 0: use a new base */
+static size_t jpending_end;
+
+static int env_journal_alloc(void)
+{
+	if (!jimg)
+		jimg = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	if (!jsnap)
+		jsnap = malloc(ENV_SIZE);
+
+	return jimg && jsnap ? 0 : -1;
+}
+
+static u32 get_le32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+static void put_le32(unsigned char *p, u32 val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+	p[2] = val >> 16;
+	p[3] = val >> 24;
+}
+
+/* Length of the base image including the empty string ending it, or 0 */
+static size_t env_journal_baselen(const unsigned char *data)
+{
+	size_t i;
+
+	for (i = 0; i < ENV_SIZE; i++)
+		if (!data[i] && (i == 0 || !data[i - 1]))
+			return i + 1;
+	return 0;
+}
+
+/*
+ * Replays the records following the base; returns where the next one
+ * goes, or 0 if there is something else than erased space there.
+ */
+static size_t env_journal_replay(size_t pos)
+{
+	const unsigned char *img = (const unsigned char *)jimg;
+	const unsigned char *rec;
+	size_t end;
+	u32 len;
+
+	for (;;) {
+		/* records start on any alignment the storage needs */
+		for (end = pos; pos < CONFIG_ENV_SIZE && img[pos] == 0xff; pos++)
+			;
+		if (pos == CONFIG_ENV_SIZE)
+			return end;
+		if (pos + ENV_JOURNAL_HDR_SIZE > CONFIG_ENV_SIZE)
+			return 0;
+
+		rec = img + pos;
+		len = get_le32(rec + 4);
+		if (get_le32(rec) != ENV_JOURNAL_MAGIC ||
+		    len > CONFIG_ENV_SIZE - pos - ENV_JOURNAL_HDR_SIZE ||
+		    crc32(0, rec + ENV_JOURNAL_HDR_SIZE, len) !=
+		    get_le32(rec + 8)) {
+			printf("*** Warning - bad environment journal record "
+			       "at 0x%lx, dropped\n", (ulong)pos);
+			return 0;
+		}
+
+		if (len && !himport_r(&env_htab,
+				      (char *)rec + ENV_JOURNAL_HDR_SIZE, len,
+				      '\0', H_NOCLEAR))
+			return 0;
+		pos += ENV_JOURNAL_HDR_SIZE + len;
+	}
+}
+
+int env_journal_import(const char *buf)
+{
+	unsigned char *data;
+	size_t baselen;
+	uint32_t crc;
+
+	if (env_journal_alloc()) {
+		set_default_env("!malloc() failed");
+		return 0;
+	}
+	memcpy(jimg, buf, CONFIG_ENV_SIZE);
+	memcpy(&crc, &jimg->crc, sizeof(crc));
+	data = jimg->data;
+	jend = 0;
+
+	baselen = env_journal_baselen(data);
+	if (baselen && crc32(0, data, baselen) == crc) {
+		/* the import must not run into the erased space */
+		memcpy(jsnap, data, baselen);
+		memset(jsnap + baselen, 0, ENV_SIZE - baselen);
+		if (!himport_r(&env_htab, jsnap, ENV_SIZE, '\0', 0))
+			goto fail;
+		jend = env_journal_replay(ENV_DATA_OFFSET + baselen);
+	} else if (crc32(0, data, ENV_SIZE) == crc) {
+		/* the plain format: converted by the next saveenv */
+		if (!himport_r(&env_htab, (char *)data, ENV_SIZE, '\0', 0))
+			goto fail;
+	} else {
+		set_default_env("!bad CRC");
+		return 0;
+	}
+
+	if (hexport_r(&env_htab, '\0', &jsnap, ENV_SIZE, 0, NULL) < 0)
+		jend = 0;
+
+	gd->flags |= GD_FLG_ENV_READY;
+	env_notify_all();
+	return 1;
+
+fail:
+	error("Cannot import environment: errno = %d\n", errno);
+	set_default_env("!import failed");
+	return 0;
+}
+
+/* Compares the names of two "name=value" strings */
+static int env_journal_keycmp(const char *a, const char *b)
+{
+	while (*a != '=' && *a == *b) {
+		a++;
+		b++;
+	}
+	if (*a == '=' && *b == '=')
+		return 0;
+	if (*a == '=')
+		return -1;
+	if (*b == '=')
+		return 1;
+	return (unsigned char)*a - (unsigned char)*b;
+}
+
+/*
+ * Writes the differences between two sorted exports to buf; returns
+ * their length, or -1 if they do not fit in size bytes.
+ */
+static int env_journal_diff(const char *old, const char *cur, char *buf,
+			    size_t size)
+{
+	size_t len = 0, n;
+	const char *s;
+	int cmp;
+
+	while (*old || *cur) {
+		if (!*old)
+			cmp = 1;
+		else if (!*cur)
+			cmp = -1;
+		else
+			cmp = env_journal_keycmp(old, cur);
+
+		if (cmp < 0) {
+			/* deleted: "name=" */
+			s = old;
+			n = strchr(old, '=') - old + 1;
+		} else if (cmp > 0 || strcmp(old, cur)) {
+			s = cur;
+			n = strlen(cur);
+		} else {
+			s = NULL;
+			n = 0;
+		}
+
+		if (s) {
+			if (len + n + 2 > size)
+				return -1;
+			memcpy(buf + len, s, n);
+			len += n;
+			buf[len++] = '\0';
+		}
+
+		if (cmp <= 0)
+			old += strlen(old) + 1;
+		if (cmp >= 0)
+			cur += strlen(cur) + 1;
+	}
+
+	if (len)
+		buf[len++] = '\0';
+	return len;
+}
+
+int env_journal_prepare(size_t align, env_t **img, size_t *off, size_t *len)
+{
+	unsigned char *p;
+	size_t start, baselen;
+	int n;
+
+	if (env_journal_alloc())
+		return -1;
+
+	jpending = NULL;
+	if (hexport_r(&env_htab, '\0', &jpending, ENV_SIZE, 0, NULL) < 0) {
+		error("Cannot export environment: errno = %d\n", errno);
+		return -1;
+	}
+	*img = jimg;
+
+	start = ALIGN(jend, align);
+	if (jend && start + ENV_JOURNAL_HDR_SIZE < CONFIG_ENV_SIZE) {
+		p = (unsigned char *)jimg + start;
+		n = env_journal_diff(jsnap, jpending,
+				     (char *)p + ENV_JOURNAL_HDR_SIZE,
+				     CONFIG_ENV_SIZE - start -
+				     ENV_JOURNAL_HDR_SIZE);
+		if (n == 0) {
+			/* nothing changed, nothing to write */
+			*off = start;
+			*len = 0;
+			jpending_end = jend;
+			return 0;
+		}
+		if (n > 0 && start + ALIGN(ENV_JOURNAL_HDR_SIZE + n, align) <=
+			     CONFIG_ENV_SIZE) {
+			put_le32(p, ENV_JOURNAL_MAGIC);
+			put_le32(p + 4, n);
+			put_le32(p + 8, crc32(0, p + ENV_JOURNAL_HDR_SIZE, n));
+			*off = start;
+			*len = ALIGN(ENV_JOURNAL_HDR_SIZE + n, align);
+			jpending_end = start + ENV_JOURNAL_HDR_SIZE + n;
+			return 0;
+		}
+	}
+
+	/* a new base, and nothing behind it */
+	memcpy(jimg->data, jpending, ENV_SIZE);
+	baselen = env_journal_baselen(jimg->data);
+	memset(jimg->data + baselen, 0xff, ENV_SIZE - baselen);
+	jimg->crc = crc32(0, jimg->data, baselen);
+
+	*off = 0;
+	*len = min(ALIGN(ENV_DATA_OFFSET + baselen, align),
+		   (size_t)CONFIG_ENV_SIZE);
+	jpending_end = ENV_DATA_OFFSET + baselen;
+	return 1;
+}
+
+void env_journal_done(int err)
+{
+	if (err) {
+		/* what is stored is unknown now: start over next time */
+		jend = 0;
+		free(jpending);
+	} else {
+		jend = jpending_end;
+		free(jsnap);
+		jsnap = jpending;
+	}
+	jpending = NULL;
+}
@@ -98,6 +98,48 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	return (n == blk_cnt) ? 0 : -1;
 }
 
+#ifdef CONFIG_ENV_JOURNAL
+int saveenv(void)
+{
+	struct mmc *mmc = find_mmc_device(CONFIG_SYS_MMC_ENV_DEV);
+	size_t	start, len;
+	env_t	*img;
+	u32	offset;
+	int	ret;
+
+	if (init_mmc_for_env(mmc) || mmc_get_env_addr(mmc, &offset))
+		return 1;
+
+	ret = env_journal_prepare(1, &img, &start, &len);
+	if (ret < 0)
+		return 1;
+
+	if (ret == 0 && len == 0) {
+		puts("Environment unchanged\n");
+		env_journal_done(0);
+		return 0;
+	}
+
+	/* blocks are rewritten: only those of the new record when appending */
+	if (ret == 0) {
+		len += start % mmc->write_bl_len;
+		start -= start % mmc->write_bl_len;
+	} else {
+		len = CONFIG_ENV_SIZE;
+	}
+
+	printf("Writing to MMC(%d)... ", CONFIG_SYS_MMC_ENV_DEV);
+	ret = write_env(mmc, len, offset + start, (u_char *)img + start);
+	env_journal_done(ret);
+	if (ret) {
+		puts("failed\n");
+		return 1;
+	}
+
+	puts("done\n");
+	return 0;
+}
+#else
 int saveenv(void)
 {
 	env_t	env_new;
@@ -126,6 +168,7 @@ int saveenv(void)
 	puts("done\n");
 	return 0;
 }
+#endif /* CONFIG_ENV_JOURNAL */
 #endif /* CONFIG_CMD_SAVEENV */
 
 static inline int read_env(struct mmc *mmc, unsigned long size,
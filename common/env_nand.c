@@ -173,6 +173,40 @@ int writeenv(size_t offset, u_char *buf)
 	return 0;
 }
 
+#ifdef CONFIG_ENV_JOURNAL
+/*
+ * Like writeenv(), but only writes the len bytes at from in the area;
+ * from and len are multiples of the page size.
+ */
+static int writeenv_part(size_t offset, size_t from, size_t len, u_char *buf)
+{
+	size_t end = offset + CONFIG_ENV_RANGE;
+	size_t blocksize, pos = 0, skip, n;
+
+	blocksize = nand_info[0].erasesize;
+
+	while (len && offset < end) {
+		if (nand_block_isbad(&nand_info[0], offset)) {
+			offset += blocksize;
+			continue;
+		}
+		if (from < pos + blocksize) {
+			skip = from - pos;
+			n = min(len, blocksize - skip);
+			if (nand_write(&nand_info[0], offset + skip, &n,
+				       buf + from))
+				return 1;
+			from += n;
+			len -= n;
+		}
+		offset += blocksize;
+		pos += blocksize;
+	}
+
+	return len ? 1 : 0;
+}
+#endif
+
 #ifdef CONFIG_ENV_OFFSET_REDUND
 static unsigned char env_flags;
 
@@ -227,7 +261,50 @@ int saveenv(void)
 
 	return ret;
 }
-#else /* ! CONFIG_ENV_OFFSET_REDUND */
+#elif defined(CONFIG_ENV_JOURNAL)
+int saveenv(void)
+{
+	nand_erase_options_t nand_erase_options;
+	size_t	start, len;
+	env_t	*img;
+	int	ret;
+
+	if (CONFIG_ENV_RANGE < CONFIG_ENV_SIZE)
+		return 1;
+
+	/* a page is programmed once: each record starts a new one */
+	ret = env_journal_prepare(nand_info[0].writesize, &img, &start, &len);
+	if (ret < 0)
+		return 1;
+
+	if (ret) {
+		memset(&nand_erase_options, 0, sizeof(nand_erase_options));
+		nand_erase_options.length = CONFIG_ENV_RANGE;
+		nand_erase_options.offset = CONFIG_ENV_OFFSET;
+
+		puts("Erasing Nand...\n");
+		if (nand_erase_opts(&nand_info[0], &nand_erase_options)) {
+			env_journal_done(1);
+			return 1;
+		}
+	} else if (!len) {
+		puts("Environment unchanged\n");
+		env_journal_done(0);
+		return 0;
+	}
+
+	puts("Writing to Nand... ");
+	ret = writeenv_part(CONFIG_ENV_OFFSET, start, len, (u_char *)img);
+	env_journal_done(ret);
+	if (ret) {
+		puts("FAILED!\n");
+		return 1;
+	}
+
+	puts("done\n");
+	return 0;
+}
+#else /* ! CONFIG_ENV_OFFSET_REDUND && ! CONFIG_ENV_JOURNAL */
 int saveenv(void)
 {
 	int	ret = 0;
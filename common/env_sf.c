@@ -243,14 +243,8 @@ out:
 	free(tmp_env2);
 }
 #else
-int saveenv(void)
+static int env_sf_probe(void)
 {
-	u32	saved_size, saved_offset, sector = 1;
-	char	*res, *saved_buffer = NULL;
-	int	ret = 1;
-	env_t	env_new;
-	ssize_t	len;
-
 	if (!env_flash) {
 		env_flash = spi_flash_probe(CONFIG_ENV_SPI_BUS,
 			CONFIG_ENV_SPI_CS,
@@ -260,6 +254,15 @@ int saveenv(void)
 			return 1;
 		}
 	}
+	return 0;
+}
+
+/* Erases the env sectors and writes len bytes of buf to them */
+static int env_sf_rewrite(const void *buf, size_t len)
+{
+	u32	saved_size, saved_offset, sector = 1;
+	char	*saved_buffer = NULL;
+	int	ret = 1;
 
 	/* Is the sector larger than the env (i.e. embedded) */
 	if (CONFIG_ENV_SECT_SIZE > CONFIG_ENV_SIZE) {
@@ -281,14 +284,6 @@ int saveenv(void)
 			sector++;
 	}
 
-	res = (char *)&env_new.data;
-	len = hexport_r(&env_htab, '\0', &res, ENV_SIZE, 0, NULL);
-	if (len < 0) {
-		error("Cannot export environment: errno = %d\n", errno);
-		goto done;
-	}
-	env_new.crc = crc32(0, env_new.data, ENV_SIZE);
-
 	puts("Erasing SPI flash...");
 	ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
 		sector * CONFIG_ENV_SECT_SIZE);
@@ -296,8 +291,7 @@ int saveenv(void)
 		goto done;
 
 	puts("Writing to SPI flash...");
-	ret = spi_flash_write(env_flash, CONFIG_ENV_OFFSET,
-		CONFIG_ENV_SIZE, &env_new);
+	ret = spi_flash_write(env_flash, CONFIG_ENV_OFFSET, len, buf);
 	if (ret)
 		goto done;
 
@@ -318,6 +312,58 @@ int saveenv(void)
 	return ret;
 }
 
+#ifdef CONFIG_ENV_JOURNAL
+int saveenv(void)
+{
+	size_t	start, len;
+	env_t	*img;
+	int	ret;
+
+	if (env_sf_probe())
+		return 1;
+
+	ret = env_journal_prepare(1, &img, &start, &len);
+	if (ret < 0)
+		return 1;
+
+	if (ret) {
+		ret = env_sf_rewrite(img, len);
+	} else if (len) {
+		/* appended to erased space: no sector is erased */
+		puts("Writing to SPI flash...");
+		ret = spi_flash_write(env_flash, CONFIG_ENV_OFFSET + start,
+			len, (u_char *)img + start);
+		if (!ret)
+			puts("done\n");
+	} else {
+		puts("Environment unchanged\n");
+	}
+
+	env_journal_done(ret);
+	return ret ? 1 : 0;
+}
+#else
+int saveenv(void)
+{
+	env_t	env_new;
+	ssize_t	len;
+	char	*res;
+
+	if (env_sf_probe())
+		return 1;
+
+	res = (char *)&env_new.data;
+	len = hexport_r(&env_htab, '\0', &res, ENV_SIZE, 0, NULL);
+	if (len < 0) {
+		error("Cannot export environment: errno = %d\n", errno);
+		return 1;
+	}
+	env_new.crc = crc32(0, env_new.data, ENV_SIZE);
+
+	return env_sf_rewrite(&env_new, CONFIG_ENV_SIZE);
+}
+#endif /* CONFIG_ENV_JOURNAL */
+
 void env_relocate_spec(void)
 {
 	char buf[CONFIG_ENV_SIZE];
@@ -31,6 +31,8 @@
 #include <fdt.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdt_index.h>
+#include <fdt_stage.h>
 #include <exports.h>
 
 /*
@@ -55,7 +57,7 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
 	const u32 *val;
 	int off;
 
-	off = fdt_path_offset(fdt, path);
+	off = fdt_index_path_offset(fdt, path);
 	if (off < 0)
 		return dflt;
 
@@ -81,7 +83,7 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create)
 {
-	int nodeoff = fdt_path_offset(fdt, node);
+	int nodeoff = fdt_index_path_offset(fdt, node);
 
 	if (nodeoff < 0)
 		return nodeoff;
@@ -89,7 +91,7 @@ int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 	if ((!create) && (fdt_get_property(fdt, nodeoff, prop, 0) == NULL))
 		return 0; /* create flag not set; so exit quietly */
 
-	return fdt_setprop(fdt, nodeoff, prop, val, len);
+	return fdt_stage_setprop(fdt, nodeoff, prop, val, len);
 }
 
 #ifdef CONFIG_OF_STDOUT_VIA_ALIAS
@@ -122,7 +124,7 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 	if (!sername[0])
 		sprintf(sername, "serial%d", CONFIG_CONS_INDEX - 1);
 
-	err = node = fdt_path_offset(fdt, "/aliases");
+	err = node = fdt_index_path_offset(fdt, "/aliases");
 	if (node >= 0) {
 		int len;
 		path = fdt_getprop(fdt, node, sername, &len);
@@ -131,7 +133,7 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 			err = -FDT_ERR_NOSPACE;
 			if (p) {
 				memcpy(p, path, len);
-				err = fdt_setprop(fdt, chosenoff,
+				err = fdt_stage_setprop(fdt, chosenoff,
 					"linux,stdout-path", p, len);
 				free(p);
 			}
@@ -157,7 +159,7 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end, int force)
 	uint64_t addr, size;
 
 	/* Find the "chosen" node.  */
-	nodeoffset = fdt_path_offset (fdt, "/chosen");
+	nodeoffset = fdt_index_path_offset (fdt, "/chosen");
 
 	/* If there is no "chosen" node in the blob return */
 	if (nodeoffset < 0) {
@@ -192,7 +194,7 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end, int force)
 	path = fdt_getprop(fdt, nodeoffset, "linux,initrd-start", NULL);
 	if ((path == NULL) || force) {
 		tmp = __cpu_to_be32(initrd_start);
-		err = fdt_setprop(fdt, nodeoffset,
+		err = fdt_stage_setprop(fdt, nodeoffset,
 			"linux,initrd-start", &tmp, sizeof(tmp));
 		if (err < 0) {
 			printf("WARNING: "
@@ -201,7 +203,7 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end, int force)
 			return err;
 		}
 		tmp = __cpu_to_be32(initrd_end);
-		err = fdt_setprop(fdt, nodeoffset,
+		err = fdt_stage_setprop(fdt, nodeoffset,
 			"linux,initrd-end", &tmp, sizeof(tmp));
 		if (err < 0) {
 			printf("WARNING: could not set linux,initrd-end %s.\n",
@@ -230,7 +232,7 @@ int fdt_chosen(void *fdt, int force)
 	/*
 	 * Find the "chosen" node.
 	 */
-	nodeoffset = fdt_path_offset (fdt, "/chosen");
+	nodeoffset = fdt_index_path_offset (fdt, "/chosen");
 
 	/*
 	 * If there is no "chosen" node in the blob, create it.
@@ -256,7 +258,7 @@ int fdt_chosen(void *fdt, int force)
 	if (str != NULL) {
 		path = fdt_getprop(fdt, nodeoffset, "bootargs", NULL);
 		if ((path == NULL) || force) {
-			err = fdt_setprop(fdt, nodeoffset,
+			err = fdt_stage_setprop(fdt, nodeoffset,
 				"bootargs", str, strlen(str)+1);
 			if (err < 0)
 				printf("WARNING: could not set bootargs %s.\n",
@@ -273,7 +275,7 @@ int fdt_chosen(void *fdt, int force)
 #ifdef OF_STDOUT_PATH
 	path = fdt_getprop(fdt, nodeoffset, "linux,stdout-path", NULL);
 	if ((path == NULL) || force) {
-		err = fdt_setprop(fdt, nodeoffset,
+		err = fdt_stage_setprop(fdt, nodeoffset,
 			"linux,stdout-path", OF_STDOUT_PATH, strlen(OF_STDOUT_PATH)+1);
 		if (err < 0)
 			printf("WARNING: could not set linux,stdout-path %s.\n",
@@ -323,7 +325,7 @@ void do_fixup_by_prop(void *fdt,
 	off = fdt_node_offset_by_prop_value(fdt, -1, pname, pval, plen);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, 0) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_stage_setprop(fdt, off, prop, val, len);
 		off = fdt_node_offset_by_prop_value(fdt, off, pname, pval, plen);
 	}
 }
@@ -347,11 +349,11 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
-	off = fdt_node_offset_by_compatible(fdt, -1, compat);
+	off = fdt_index_node_offset_by_compatible(fdt, -1, compat);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, 0) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
-		off = fdt_node_offset_by_compatible(fdt, off, compat);
+			fdt_stage_setprop(fdt, off, prop, val, len);
+		off = fdt_index_node_offset_by_compatible(fdt, off, compat);
 	}
 }
 
@@ -404,7 +406,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 
 	/* update, or add and update /memory node */
-	nodeoffset = fdt_path_offset(blob, "/memory");
+	nodeoffset = fdt_index_path_offset(blob, "/memory");
 	if (nodeoffset < 0) {
 		nodeoffset = fdt_add_subnode(blob, 0, "memory");
 		if (nodeoffset < 0)
@@ -412,7 +414,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 					fdt_strerror(nodeoffset));
 		return nodeoffset;
 	}
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
+	err = fdt_stage_setprop(blob, nodeoffset, "device_type", "memory",
 			sizeof("memory"));
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n", "device_type",
@@ -431,7 +433,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 		len += size_cell_len;
 	}
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
+	err = fdt_stage_setprop(blob, nodeoffset, "reg", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 				"reg", fdt_strerror(err));
@@ -453,7 +455,7 @@ void fdt_fixup_ethernet(void *fdt)
 	const char *path;
 	unsigned char mac_addr[6];
 
-	node = fdt_path_offset(fdt, "/aliases");
+	node = fdt_index_path_offset(fdt, "/aliases");
 	if (node < 0)
 		return;
 
@@ -629,7 +631,7 @@ int fdt_fixup_nor_flash_size(void *blob)
 	int i;
 
 	for (i = 0; i < 2; i++) {
-		off = fdt_node_offset_by_compatible(blob, -1, compat[i]);
+		off = fdt_index_node_offset_by_compatible(blob, -1, compat[i]);
 		while (off != -FDT_ERR_NOTFOUND) {
 			int idx;
 
@@ -663,8 +665,8 @@ int fdt_fixup_nor_flash_size(void *blob)
 			}
 
 			/* Move to next compatible node */
-			off = fdt_node_offset_by_compatible(blob, off,
-							    compat[i]);
+			off = fdt_index_node_offset_by_compatible(blob, off,
+								  compat[i]);
 		}
 	}
 
@@ -872,7 +874,7 @@ void fdt_fixup_mtdparts(void *blob, void *node_info, int node_info_size)
 
 	for (i = 0; i < node_info_size; i++) {
 		idx = 0;
-		noff = fdt_node_offset_by_compatible(blob, -1, ni[i].compat);
+		noff = fdt_index_node_offset_by_compatible(blob, -1, ni[i].compat);
 		while (noff != -FDT_ERR_NOTFOUND) {
 			debug("%s: %s, mtd dev type %d\n",
 				fdt_get_name(blob, noff, 0),
@@ -884,8 +886,8 @@ void fdt_fixup_mtdparts(void *blob, void *node_info, int node_info_size)
 			}
 
 			/* Jump to next flash node */
-			noff = fdt_node_offset_by_compatible(blob, noff,
-							     ni[i].compat);
+			noff = fdt_index_node_offset_by_compatible(blob,
+					noff, ni[i].compat);
 		}
 	}
 }
@@ -893,14 +895,14 @@ void fdt_fixup_mtdparts(void *blob, void *node_info, int node_info_size)
 
 void fdt_del_node_and_alias(void *blob, const char *alias)
 {
-	int off = fdt_path_offset(blob, alias);
+	int off = fdt_index_path_offset(blob, alias);
 
 	if (off < 0)
 		return;
 
 	fdt_del_node(blob, off);
 
-	off = fdt_path_offset(blob, "/aliases");
+	off = fdt_index_path_offset(blob, "/aliases");
 	fdt_delprop(blob, off, alias);
 }
 
@@ -1162,14 +1164,14 @@ u64 fdt_translate_address(void *blob, int node_offset, const u32 *in_addr)
 int fdt_node_offset_by_compat_reg(void *blob, const char *compat,
 					phys_addr_t compat_off)
 {
-	int len, off = fdt_node_offset_by_compatible(blob, -1, compat);
+	int len, off = fdt_index_node_offset_by_compatible(blob, -1, compat);
 	while (off != -FDT_ERR_NOTFOUND) {
 		u32 *reg = (u32 *)fdt_getprop(blob, off, "reg", &len);
 		if (reg) {
 			if (compat_off == fdt_translate_address(blob, off, reg))
 				return off;
 		}
-		off = fdt_node_offset_by_compatible(blob, off, compat);
+		off = fdt_index_node_offset_by_compatible(blob, off, compat);
 	}
 
 	return -FDT_ERR_NOTFOUND;
@@ -1204,7 +1206,7 @@ int fdt_set_phandle(void *fdt, int nodeoffset, uint32_t phandle)
 	int ret;
 
 #ifdef DEBUG
-	int off = fdt_node_offset_by_phandle(fdt, phandle);
+	int off = fdt_index_node_offset_by_phandle(fdt, phandle);
 
 	if ((off >= 0) && (off != nodeoffset)) {
 		char buf[64];
@@ -1312,7 +1314,7 @@ int fdt_set_node_status(void *fdt, int nodeoffset,
 int fdt_set_status_by_alias(void *fdt, const char* alias,
 			    enum fdt_status status, unsigned int error_code)
 {
-	int offset = fdt_path_offset(fdt, alias);
+	int offset = fdt_index_path_offset(fdt, alias);
 
 	return fdt_set_node_status(fdt, offset, status, error_code);
 }
@@ -1323,7 +1325,7 @@ int fdt_add_edid(void *blob, const char *compat, unsigned char *edid_buf)
 	int noff;
 	int ret;
 
-	noff = fdt_node_offset_by_compatible(blob, -1, compat);
+	noff = fdt_index_node_offset_by_compatible(blob, -1, compat);
 	if (noff != -FDT_ERR_NOTFOUND) {
 		debug("%s: %s\n", fdt_get_name(blob, noff, 0), compat);
 add_edid:
@@ -1368,7 +1370,7 @@ int fdt_verify_alias_address(void *fdt, int anode, const char *alias, u64 addr)
 		return 1;
 	}
 
-	node = fdt_path_offset(fdt, path);
+	node = fdt_index_path_offset(fdt, path);
 	if (node < 0) {
 		printf("Warning: device tree alias '%s' points to invalid "
 		       "node %s.\n", alias, path);
@@ -172,6 +172,11 @@ flash_write (char *src, ulong addr, ulong cnt)
 	}
 
 	/* finally write data to flash */
+#ifdef CONFIG_SYS_FLASH_PARALLEL_BANKS
+	if (info_first != info_last)
+		return write_buff_banks(info_first, info_last, (uchar *)src,
+					addr, cnt);
+#endif
 	for (info = info_first; info <= info_last && cnt>0; ++info) {
 		ulong len;
 
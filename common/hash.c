@@ -0,0 +1,85 @@
+/*
+ * Hash algorithms by name
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Each algorithm has one entry: the SHA ones go to the hash engine
+ * with CONFIG_SHA_HW_ACCEL (include/hw_sha.h), the portable code in
+ * lib/ otherwise.  Engines for other algorithms are added the same way.
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <u-boot/md5.h>
+#include <sha1.h>
+#include <sha256.h>
+#ifdef CONFIG_SHA_HW_ACCEL
+#include <hw_sha.h>
+#endif
+
+/* Most significant byte first, as the crc32 command prints it */
+static void crc32_wd_buf(const unsigned char *input, unsigned int ilen,
+			 unsigned char *output, unsigned int chunk_sz)
+{
+	uint32_t crc = crc32_wd(0, input, ilen, chunk_sz);
+
+	output[0] = crc >> 24;
+	output[1] = crc >> 16;
+	output[2] = crc >> 8;
+	output[3] = crc;
+}
+
+#ifdef CONFIG_MD5
+static void md5_wd_buf(const unsigned char *input, unsigned int ilen,
+		       unsigned char *output, unsigned int chunk_sz)
+{
+	md5_wd((unsigned char *)input, ilen, output, chunk_sz);
+}
+#endif
+
+#if defined(CONFIG_SHA1) && !defined(CONFIG_SHA_HW_ACCEL)
+static void sha1_wd_buf(const unsigned char *input, unsigned int ilen,
+			unsigned char *output, unsigned int chunk_sz)
+{
+	sha1_csum_wd((unsigned char *)input, ilen, output, chunk_sz);
+}
+#endif
+
+static struct hash_algo hash_algo[] = {
+#ifdef CONFIG_SHA_HW_ACCEL
+	{ "sha1",	20,		hw_sha1,	CHUNKSZ_SHA1, },
+	{ "sha256",	SHA256_SUM_LEN,	hw_sha256,	CHUNKSZ_SHA256, },
+#else
+#ifdef CONFIG_SHA1
+	{ "sha1",	20,		sha1_wd_buf,	CHUNKSZ_SHA1, },
+#endif
+#ifdef CONFIG_SHA256
+	{ "sha256",	SHA256_SUM_LEN,	sha256_csum_wd,	CHUNKSZ_SHA256, },
+#endif
+#endif
+#ifdef CONFIG_MD5
+	{ "md5",	16,		md5_wd_buf,	CHUNKSZ_MD5, },
+#endif
+	{ "crc32",	4,		crc32_wd_buf,	CHUNKSZ_CRC32, },
+};
+
+struct hash_algo *hash_lookup_algo(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++)
+		if (!strcmp(name, hash_algo[i].name))
+			return &hash_algo[i];
+	return NULL;
+}
+
+void hash_show_algos(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hash_algo); i++)
+		printf("%s%s", i ? " " : "", hash_algo[i].name);
+}
@@ -92,6 +92,10 @@
 #include <common.h>        /* readline */
 #include <hush.h>
 #include <command.h>        /* find_cmd */
+#include <load_hash.h>
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+#include <u-boot/crc.h>
+#endif
 #endif
 #ifndef __U_BOOT__
 #include <ctype.h>     /* isalpha, isdigit */
@@ -1520,7 +1524,7 @@ shell_terminal_error:
  */
 static int run_pipe_real(struct pipe *pi)
 {
-	int i;
+	int i, sp;
 #ifndef __U_BOOT__
 	int nextin, nextout;
 	int pipefds[2];				/* pipefds[0] is for reading */
@@ -1606,6 +1610,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* the tree may be run again, leave child->sp alone */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1614,11 +1620,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string((child->argv + i));
@@ -1680,6 +1686,7 @@ static int run_pipe_real(struct pipe *pi)
 #else
 				/* OK - call function to do the command */
 
+				load_hash_command(cmdtp);
 				rcode = (cmdtp->cmd)
 (cmdtp, flag,child->argc-i,&child->argv[i]);
 				if ( !cmdtp->repeatable )
@@ -1777,12 +1784,33 @@ static int run_pipe_real(struct pipe *pi)
 	return -1;
 }
 
+#ifdef __U_BOOT__
+/*
+ * A "for" loop left half way puts its variable back, so that the
+ * tree can be run again.
+ */
+static void for_list_abort(struct pipe *for_pipe, char **list,
+			   char **save_list, char *save_name)
+{
+	if (!list)
+		return;
+	while (*list)
+		free(*list++);
+	free(for_pipe->progs->argv[0]);
+	free(save_list);
+	for_pipe->progs->argv[0] = save_name;
+}
+#endif
+
 static int run_list_real(struct pipe *pi)
 {
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
 	struct pipe *rpipe;
+#ifdef __U_BOOT__
+	struct pipe *for_pipe = NULL;
+#endif
 	int flag_rep = 0;
 #ifndef __U_BOOT__
 	int save_num_progs;
@@ -1821,6 +1849,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
+					for_list_abort(for_pipe, list,
+						       save_list, save_name);
 					return 1;
 				}
 #endif
@@ -1852,6 +1882,9 @@ static int run_list_real(struct pipe *pi)
 				save_list = list;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
+#ifdef __U_BOOT__
+				for_pipe = pi;
+#endif
 				flag_rep = 1;
 			}
 			if (!(*list)) {
@@ -1921,6 +1954,7 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
+			for_list_abort(for_pipe, list, save_list, save_name);
 			return -2;	/* exit */
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
@@ -3198,6 +3232,167 @@ int parse_stream_outer(struct in_str *inp, int flag)
 #endif /* __U_BOOT__ */
 }
 
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+/*
+ * Parsed scripts, kept by their text so that running one again, from
+ * "run", "source" or bootcmd, does not parse it once more.  The trees
+ * are run as parse_stream_outer() would, without being freed; the
+ * variables in them are still expanded each time they run.
+ */
+#ifndef CONFIG_SYS_HUSH_SCRIPT_CACHE_SIZE
+#define CONFIG_SYS_HUSH_SCRIPT_CACHE_SIZE	8
+#endif
+
+struct hush_script {
+	struct hush_script *next;	/* most recently run first */
+	uint32_t	crc;
+	int		len;
+	int		flag;
+	int		busy;		/* running, maybe from itself */
+	int		num_lists;
+	struct pipe	**lists;
+	char		text[];
+};
+
+static struct hush_script *hush_scripts;
+
+static void hush_script_free(struct hush_script *hs)
+{
+	int i;
+
+	for (i = 0; i < hs->num_lists; i++)
+		free_pipe_list(hs->lists[i], 0);
+	free(hs->lists);
+	free(hs);
+}
+
+/*
+ * Parse all of s the way parse_stream_outer() does.  NULL if there is
+ * a syntax error, which the usual path then reports.
+ */
+static struct hush_script *hush_script_parse(const char *s, int len, int flag)
+{
+	struct hush_script *hs;
+	struct p_context ctx;
+	struct in_str input;
+	o_string temp = NULL_O_STRING;
+	struct pipe **lists;
+	const char *p;
+	char *text;
+	int rcode;
+
+	hs = xmalloc(sizeof(*hs) + len + 2);
+	hs->len = len;
+	hs->flag = flag;
+	hs->busy = 0;
+	hs->num_lists = 0;
+	hs->lists = NULL;
+	strcpy(hs->text, s);
+	hs->crc = crc32(0, (const uchar *)s, len);
+
+	/* parsed from a copy with the newline parse_string_outer() adds */
+	text = xmalloc(len + 2);
+	strcpy(text, s);
+	p = strchr(s, '\n');
+	if (!p || *++p)
+		strcat(text, "\n");
+	setup_string_in_str(&input, text);
+
+	do {
+		ctx.type = flag;
+		initialize_context(&ctx);
+		update_ifs_map();
+		if (!(flag & FLAG_PARSE_SEMICOLON))
+			mapset((uchar *)";$&|", 0);
+		input.promptmode = 1;
+		rcode = parse_stream(&temp, &ctx, &input, '\n');
+		if (rcode == 1 || ctx.old_flag != 0) {
+			if (ctx.old_flag != 0)
+				free(ctx.stack);
+			free_pipe_list(ctx.list_head, 0);
+			b_free(&temp);
+			free(text);
+			hush_script_free(hs);
+			return NULL;
+		}
+		done_word(&temp, &ctx);
+		done_pipe(&ctx, PIPE_SEQ);
+		b_free(&temp);
+
+		lists = xrealloc(hs->lists,
+				 (hs->num_lists + 1) * sizeof(*lists));
+		lists[hs->num_lists++] = ctx.list_head;
+		hs->lists = lists;
+	} while (rcode != -1 && !(flag & FLAG_EXIT_FROM_LOOP));
+
+	free(text);
+	return hs;
+}
+
+static struct hush_script *hush_script_get(const char *s, int flag)
+{
+	struct hush_script **p, **last = NULL, *hs;
+	int len = strlen(s);
+	uint32_t crc = crc32(0, (const uchar *)s, len);
+	int n = 0;
+
+	for (p = &hush_scripts; (hs = *p) != NULL; p = &hs->next) {
+		if (hs->crc == crc && hs->len == len && hs->flag == flag &&
+		    !strcmp(hs->text, s)) {
+			/* to the front */
+			*p = hs->next;
+			hs->next = hush_scripts;
+			hush_scripts = hs;
+			return hs;
+		}
+		if (!hs->busy)
+			last = p;
+		n++;
+	}
+
+	hs = hush_script_parse(s, len, flag);
+	if (!hs)
+		return NULL;
+
+	/* make room, dropping the script that ran least recently */
+	if (n >= CONFIG_SYS_HUSH_SCRIPT_CACHE_SIZE && last) {
+		struct hush_script *old = *last;
+
+		*last = old->next;
+		hush_script_free(old);
+	}
+	hs->next = hush_scripts;
+	hush_scripts = hs;
+	return hs;
+}
+
+/* Run s from the cache; -1 if it has to be parsed as usual */
+static int hush_script_run(const char *s, int flag)
+{
+	struct hush_script *hs = hush_script_get(s, flag);
+	int code = 0;
+	int i;
+
+	/* a tree can not run inside itself: "for" changes it meanwhile */
+	if (!hs || hs->busy)
+		return -1;
+
+	hs->busy = 1;
+	for (i = 0; i < hs->num_lists; i++) {
+		code = run_list_real(hs->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	hs->busy = 0;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif /* CONFIG_HUSH_SCRIPT_CACHE */
+
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
@@ -3210,6 +3405,13 @@ int parse_string_outer(const char *s, int flag)
 	int rcode;
 	if ( !s || !*s)
 		return 1;
+#ifdef CONFIG_HUSH_SCRIPT_CACHE
+	if (!(flag & FLAG_REPARSING)) {
+		rcode = hush_script_run(s, flag);
+		if (rcode >= 0)
+			return rcode;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
@@ -72,6 +72,117 @@ next:
 const char cpu_hwconfig[] __attribute__((weak)) = "";
 const char board_hwconfig[] __attribute__((weak)) = "";
 
+#ifndef HWCONFIG_TEST
+/*
+ * Board code asks for hwconfig options dozens of times while it brings
+ * up DDR, USB and PCI.  After relocation the options of the "hwconfig"
+ * variable, board_hwconfig and cpu_hwconfig are split up once into a
+ * table, in the order they are searched, and split up again only when
+ * the variable changes.  The entries point into the strings, as the
+ * parsing functions' results do.  With more options than fit in the
+ * table, or before relocation, the strings are parsed every time.
+ */
+#ifndef CONFIG_SYS_HWCONFIG_OPTS
+#define CONFIG_SYS_HWCONFIG_OPTS	32
+#endif
+
+struct hwconfig_opt {
+	const char *name;
+	size_t namelen;
+	const char *arg;	/* after the ':', or NULL */
+	size_t arglen;
+	int src;		/* the string it is in */
+};
+
+static struct {
+	int count;		/* -1: too many options */
+	struct hwconfig_opt opt[CONFIG_SYS_HWCONFIG_OPTS];
+} hwconfig_cache;
+
+static int hwconfig_split(const char *str, int src)
+{
+	const char *end, *colon;
+	struct hwconfig_opt *o;
+
+	for (; *str; str = *end ? end + 1 : end) {
+		end = strchr(str, ';');
+		if (!end)
+			end = str + strlen(str);
+		if (end == str)
+			continue;
+		if (hwconfig_cache.count == CONFIG_SYS_HWCONFIG_OPTS)
+			return -1;
+
+		o = &hwconfig_cache.opt[hwconfig_cache.count++];
+		o->name = str;
+		o->src = src;
+		colon = memchr(str, ':', end - str);
+		if (colon) {
+			o->namelen = colon - str;
+			o->arg = colon + 1;
+			o->arglen = end - colon - 1;
+		} else {
+			o->namelen = end - str;
+			o->arg = NULL;
+			o->arglen = 0;
+		}
+	}
+	return 0;
+}
+
+static void hwconfig_env_changed(struct env_notifier *n, const char *value)
+{
+	hwconfig_cache.count = 0;
+	if ((value && hwconfig_split(value, 0)) ||
+	    hwconfig_split(board_hwconfig, 1) ||
+	    hwconfig_split(cpu_hwconfig, 2))
+		hwconfig_cache.count = -1;
+}
+
+static struct env_notifier hwconfig_notifier = {
+	.name		= "hwconfig",
+	.changed	= hwconfig_env_changed,
+};
+
+static int hwconfig_cache_ready(void)
+{
+	static int registered;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+	if (!registered) {
+		registered = 1;
+		env_notifier_register(&hwconfig_notifier);
+	}
+	return hwconfig_cache.count >= 0;
+}
+
+/* As hwconfig_parse() on each of the strings in turn */
+static const char *hwconfig_lookup(const char *opt, size_t *arglen)
+{
+	size_t optlen = strlen(opt);
+	struct hwconfig_opt *o;
+	int i, skip = -1;
+
+	for (i = 0; i < hwconfig_cache.count; i++) {
+		o = &hwconfig_cache.opt[i];
+		if (o->src == skip || o->namelen != optlen ||
+		    strncmp(o->name, opt, optlen))
+			continue;
+		if (!arglen)
+			return o->name;
+		if (!o->arg) {
+			/* no argument in this string: try the next one */
+			skip = o->src;
+			continue;
+		}
+		*arglen = o->arglen;
+		return o->arg;
+	}
+	return NULL;
+}
+#endif /* HWCONFIG_TEST */
+
 static const char *__hwconfig(const char *opt, size_t *arglen,
 			      const char *env_hwconfig)
 {
@@ -84,6 +195,10 @@ static const char *__hwconfig(const char *opt, size_t *arglen,
 					"and before environment is ready\n");
 			return NULL;
 		}
+#ifndef HWCONFIG_TEST
+		if (hwconfig_cache_ready())
+			return hwconfig_lookup(opt, arglen);
+#endif
 		env_hwconfig = getenv("hwconfig");
 	}
 
@@ -44,6 +44,8 @@
 #endif
 
 #include <image.h>
+#include <load_hash.h>
+#include <dma.h>
 
 #if defined(CONFIG_FIT) || defined(CONFIG_OF_LIBFDT)
 #include <fdt.h>
@@ -54,6 +56,12 @@
 #if defined(CONFIG_FIT)
 #include <u-boot/md5.h>
 #include <sha1.h>
+#include <sha256.h>
+#ifdef CONFIG_SHA_HW_ACCEL
+#include <hw_sha.h>
+#endif
+#include <mp_job.h>
+#include <tpm.h>
 
 static int fit_check_ramdisk(const void *fit, int os_noffset,
 		uint8_t arch, int verify);
@@ -70,6 +78,7 @@ static const image_header_t *image_get_ramdisk(ulong rd_addr, uint8_t arch,
 #else
 #include "mkimage.h"
 #include <u-boot/md5.h>
+#include <sha256.h>
 #include <time.h>
 #include <image.h>
 #endif /* !USE_HOSTCC*/
@@ -155,6 +164,7 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_GZIP,	"gzip",		"gzip compressed",	},
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
+	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -186,7 +196,17 @@ int image_check_dcrc(const image_header_t *hdr)
 {
 	ulong data = image_get_data(hdr);
 	ulong len = image_get_data_size(hdr);
-	ulong dcrc = crc32_wd(0, (unsigned char *)data, len, CHUNKSZ_CRC32);
+	ulong dcrc;
+#if !defined(USE_HOSTCC) && defined(CONFIG_LOAD_HASH)
+	uint32_t crc;
+
+	/* computed while the image was loaded? */
+	if (load_hash_get_dcrc(data, len, &crc) == 0 &&
+	    crc == image_get_dcrc(hdr))
+		return 1;
+#endif
+
+	dcrc = crc32_wd(0, (unsigned char *)data, len, CHUNKSZ_CRC32);
 
 	return (dcrc == image_get_dcrc(hdr));
 }
@@ -372,37 +392,37 @@ static const image_header_t *image_get_ramdisk(ulong rd_addr, uint8_t arch,
 
 	if (!image_check_magic(rd_hdr)) {
 		puts("Bad Magic Number\n");
-		show_boot_progress(-10);
+		bootstage_mark(-10);
 		return NULL;
 	}
 
 	if (!image_check_hcrc(rd_hdr)) {
 		puts("Bad Header Checksum\n");
-		show_boot_progress(-11);
+		bootstage_mark(-11);
 		return NULL;
 	}
 
-	show_boot_progress(10);
+	bootstage_mark(10);
 	image_print_contents(rd_hdr);
 
 	if (verify) {
 		puts("   Verifying Checksum ... ");
 		if (!image_check_dcrc(rd_hdr)) {
 			puts("Bad Data CRC\n");
-			show_boot_progress(-12);
+			bootstage_mark(-12);
 			return NULL;
 		}
 		puts("OK\n");
 	}
 
-	show_boot_progress(11);
+	bootstage_mark(11);
 
 	if (!image_check_os(rd_hdr, IH_OS_LINUX) ||
 	    !image_check_arch(rd_hdr, arch) ||
 	    !image_check_type(rd_hdr, IH_TYPE_RAMDISK)) {
 		printf("No Linux %s Ramdisk Image\n",
 				genimg_get_arch_name(arch));
-		show_boot_progress(-13);
+		bootstage_mark(-13);
 		return NULL;
 	}
 
@@ -742,6 +762,18 @@ ulong genimg_get_image(ulong img_addr)
 		read_dataflash(img_addr + h_size, d_size,
 				(char *)(ram_addr + h_size));
 
+#if defined(CONFIG_FIT)
+		/* and what follows the blob, now that it is all there */
+		if (genimg_get_format((void *)ram_addr) == IMAGE_FORMAT_FIT) {
+			h_size += d_size;
+			d_size = fit_get_total_size((const void *)ram_addr) -
+				 h_size;
+			if (d_size)
+				read_dataflash(img_addr + h_size, d_size,
+					       (char *)(ram_addr + h_size));
+		}
+#endif
+
 	}
 #endif /* CONFIG_HAS_DATAFLASH */
 
@@ -894,7 +926,7 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 			printf("## Loading init Ramdisk from Legacy "
 					"Image at %08lx ...\n", rd_addr);
 
-			show_boot_progress(9);
+			bootstage_mark(9);
 			rd_hdr = image_get_ramdisk(rd_addr, arch,
 							images->verify);
 
@@ -911,13 +943,13 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 			printf("## Loading init Ramdisk from FIT "
 					"Image at %08lx ...\n", rd_addr);
 
-			show_boot_progress(120);
+			bootstage_mark(120);
 			if (!fit_check_format(fit_hdr)) {
 				puts("Bad FIT ramdisk image format!\n");
-				show_boot_progress(-120);
+				bootstage_mark(-120);
 				return 1;
 			}
-			show_boot_progress(121);
+			bootstage_mark(121);
 
 			if (!fit_uname_ramdisk) {
 				/*
@@ -925,13 +957,13 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 				 * node first. If config unit node name is NULL
 				 * fit_conf_get_node() will try to find default config node
 				 */
-				show_boot_progress(122);
+				bootstage_mark(122);
 				cfg_noffset = fit_conf_get_node(fit_hdr,
 							fit_uname_config);
 				if (cfg_noffset < 0) {
 					puts("Could not find configuration "
 						"node\n");
-					show_boot_progress(-122);
+					bootstage_mark(-122);
 					return 1;
 				}
 				fit_uname_config = fdt_get_name(fit_hdr,
@@ -945,20 +977,20 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 							rd_noffset, NULL);
 			} else {
 				/* get ramdisk component image node offset */
-				show_boot_progress(123);
+				bootstage_mark(123);
 				rd_noffset = fit_image_get_node(fit_hdr,
 						fit_uname_ramdisk);
 			}
 			if (rd_noffset < 0) {
 				puts("Could not find subimage node\n");
-				show_boot_progress(-124);
+				bootstage_mark(-124);
 				return 1;
 			}
 
 			printf("   Trying '%s' ramdisk subimage\n",
 				fit_uname_ramdisk);
 
-			show_boot_progress(125);
+			bootstage_mark(125);
 			if (!fit_check_ramdisk(fit_hdr, rd_noffset, arch,
 						images->verify))
 				return 1;
@@ -967,10 +999,10 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 			if (fit_image_get_data(fit_hdr, rd_noffset, &data,
 						&size)) {
 				puts("Could not find ramdisk subimage data!\n");
-				show_boot_progress(-127);
+				bootstage_mark(-127);
 				return 1;
 			}
-			show_boot_progress(128);
+			bootstage_mark(128);
 
 			rd_data = (ulong)data;
 			rd_len = size;
@@ -978,10 +1010,10 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 			if (fit_image_get_load(fit_hdr, rd_noffset, &rd_load)) {
 				puts("Can't get ramdisk subimage load "
 					"address!\n");
-				show_boot_progress(-129);
+				bootstage_mark(-129);
 				return 1;
 			}
-			show_boot_progress(129);
+			bootstage_mark(129);
 
 			images->fit_hdr_rd = fit_hdr;
 			images->fit_uname_rd = fit_uname_ramdisk;
@@ -1001,7 +1033,7 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 		 * Now check if we have a legacy mult-component image,
 		 * get second entry data start address and len.
 		 */
-		show_boot_progress(13);
+		bootstage_mark(13);
 		printf("## Loading init Ramdisk from multi component "
 				"Legacy Image at %08lx ...\n",
 				(ulong)images->legacy_hdr_os);
@@ -1011,7 +1043,7 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
 		/*
 		 * no initrd image
 		 */
-		show_boot_progress(14);
+		bootstage_mark(14);
 		rd_len = rd_data = 0;
 	}
 
@@ -1077,6 +1109,18 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 	debug("## initrd_high = 0x%08lx, copy_to_ram = %d\n",
 			initrd_high, initrd_copy_to_ram);
 
+#ifdef CONFIG_SYS_BOOT_RAMDISK_INPLACE
+	/*
+	 * A ramdisk that is aligned and already below initrd_high does
+	 * not need to be moved, as long as it is in memory nothing else
+	 * has claimed.  mkimage -B lays out FIT images for this.
+	 */
+	if (rd_data && initrd_copy_to_ram && !(rd_data & 0xfff) &&
+	    (!initrd_high || rd_data + rd_len <= initrd_high) &&
+	    lmb_is_free(lmb, rd_data, rd_len))
+		initrd_copy_to_ram = 0;
+#endif
+
 	if (rd_data) {
 		if (!initrd_copy_to_ram) {	/* zero-copy ramdisk support */
 			debug("   in-place initrd\n");
@@ -1095,14 +1139,16 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 				puts("ramdisk - allocation error\n");
 				goto error;
 			}
-			show_boot_progress(12);
+			bootstage_mark(12);
 
 			*initrd_end = *initrd_start + rd_len;
 			printf("   Loading Ramdisk to %08lx, end %08lx ... ",
 					*initrd_start, *initrd_end);
 
-			memmove_wd((void *)*initrd_start,
-					(void *)rd_data, rd_len, CHUNKSZ);
+			if (dma_memcpy((void *)*initrd_start,
+				       (void *)rd_data, rd_len))
+				memmove_wd((void *)*initrd_start,
+					   (void *)rd_data, rd_len, CHUNKSZ);
 
 #ifdef CONFIG_MP
 			/*
@@ -1189,11 +1235,13 @@ static int fit_check_fdt(const void *fit, int fdt_noffset, int verify)
 
 	if (verify) {
 		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_check_hashes(fit, fdt_noffset)) {
+		if (!fit_image_check_measure(fit, fdt_noffset)) {
 			fdt_error("Bad Data Hash");
 			return 0;
 		}
 		puts("OK\n");
+	} else {
+		fit_image_measure(fit, fdt_noffset);
 	}
 
 	if (!fit_image_check_type(fit, fdt_noffset, IH_TYPE_FLATDT)) {
@@ -2005,6 +2053,14 @@ void fit_image_print(const void *fit, int image_noffset, const char *p)
 		printf("unavailable\n");
 	else
 		printf("0x%08lx\n", (ulong)data);
+#else
+	/* where the data is found in the blob, see mkimage -B */
+	printf("%s  Data Offset:  ", p);
+	if (ret)
+		printf("unavailable\n");
+	else
+		printf("0x%08lx\n", (ulong)((const char *)data -
+					    (const char *)fit));
 #endif
 
 	printf("%s  Data Size:    ", p);
@@ -2385,6 +2441,37 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 	return 0;
 }
 
+/**
+ * fit_image_get_data_position - get where external data of an image is
+ * @fit: pointer to the FIT format image header
+ * @noffset: component image node offset
+ * @offset: pointer to ulong, will hold the offset of the data from @fit
+ * @size: pointer to size_t, will hold the data size
+ *
+ * The data of an image built with mkimage -E is not in a "data" property,
+ * but follows the blob, at "data-offset" from the first multiple of four
+ * after fdt_totalsize(fit), "data-size" bytes long.  Only the blob has to
+ * be read to find out, so a loader can then fetch the images it needs.
+ *
+ * returns:
+ *     0, on success
+ *     -1, if the image has no external data
+ */
+int fit_image_get_data_position(const void *fit, int noffset,
+		ulong *offset, size_t *size)
+{
+	const uint32_t *off, *len;
+
+	off = fdt_getprop(fit, noffset, FIT_DATA_OFFSET_PROP, NULL);
+	len = fdt_getprop(fit, noffset, FIT_DATA_SIZE_PROP, NULL);
+	if (off == NULL || len == NULL)
+		return -1;
+
+	*offset = FIT_EXTERNAL_DATA(fit) + uimage_to_cpu(*off);
+	*size = uimage_to_cpu(*len);
+	return 0;
+}
+
 /**
  * fit_image_get_data - get data property and its size for a given component image node
  * @fit: pointer to the FIT format image header
@@ -2394,7 +2481,8 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
  *
  * fit_image_get_data() finds data property in a given component image node.
  * If the property is found its data start address and size are returned to
- * the caller.
+ * the caller.  For external data, see fit_image_get_data_position(), the
+ * data is expected right behind the blob.
  *
  * returns:
  *     0, on success
@@ -2403,10 +2491,16 @@ int fit_image_get_entry(const void *fit, int noffset, ulong *entry)
 int fit_image_get_data(const void *fit, int noffset,
 		const void **data, size_t *size)
 {
+	ulong offset;
 	int len;
 
 	*data = fdt_getprop(fit, noffset, FIT_DATA_PROP, &len);
 	if (*data == NULL) {
+		if (!fit_image_get_data_position(fit, noffset, &offset,
+						 size)) {
+			*data = (const char *)fit + offset;
+			return 0;
+		}
 		fit_get_debug(fit, noffset, FIT_DATA_PROP, len);
 		*size = 0;
 		return -1;
@@ -2416,6 +2510,39 @@ int fit_image_get_data(const void *fit, int noffset,
 	return 0;
 }
 
+/**
+ * fit_get_total_size - get FIT image size with external data
+ * @fit: pointer to the FIT format image header
+ *
+ * Needs the whole blob; for images without external data this is its
+ * size, as with fit_get_size().
+ *
+ * returns:
+ *     size of the FIT image in memory
+ */
+ulong fit_get_total_size(const void *fit)
+{
+	ulong total = fdt_totalsize(fit);
+	ulong offset;
+	size_t size;
+	int images_noffset, noffset, ndepth;
+
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return total;
+
+	for (ndepth = 0, noffset = fdt_next_node(fit, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth == 1 &&
+		    !fit_image_get_data_position(fit, noffset, &offset, &size) &&
+		    offset + size > total)
+			total = offset + size;
+	}
+
+	return total;
+}
+
 /**
  * fit_image_hash_get_algo - get hash algorithm name
  * @fit: pointer to the FIT format image header
@@ -2521,7 +2648,7 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
  *     0, on success
  *    -1, when algo is unsupported
  */
-static int calculate_hash(const void *data, int data_len, const char *algo,
+int calculate_hash(const void *data, int data_len, const char *algo,
 			uint8_t *value, int *value_len)
 {
 	if (strcmp(algo, "crc32") == 0) {
@@ -2530,9 +2657,23 @@ static int calculate_hash(const void *data, int data_len, const char *algo,
 		*((uint32_t *)value) = cpu_to_uimage(*((uint32_t *)value));
 		*value_len = 4;
 	} else if (strcmp(algo, "sha1") == 0) {
+#ifdef CONFIG_SHA_HW_ACCEL
+		hw_sha1((unsigned char *)data, data_len,
+				(unsigned char *)value, CHUNKSZ_SHA1);
+#else
 		sha1_csum_wd((unsigned char *) data, data_len,
 				(unsigned char *) value, CHUNKSZ_SHA1);
+#endif
 		*value_len = 20;
+	} else if (strcmp(algo, "sha256") == 0) {
+#ifdef CONFIG_SHA_HW_ACCEL
+		hw_sha256((unsigned char *)data, data_len,
+				(unsigned char *)value, CHUNKSZ_SHA256);
+#else
+		sha256_csum_wd((unsigned char *)data, data_len,
+				(unsigned char *)value, CHUNKSZ_SHA256);
+#endif
+		*value_len = SHA256_SUM_LEN;
 	} else if (strcmp(algo, "md5") == 0) {
 		md5_wd((unsigned char *)data, data_len, value, CHUNKSZ_MD5);
 		*value_len = 16;
@@ -2716,20 +2857,179 @@ int fit_image_hash_set_value(void *fit, int noffset, uint8_t *value,
 }
 #endif /* USE_HOSTCC */
 
+#if defined(CONFIG_MP_JOBS) && !defined(USE_HOSTCC)
+/*
+ * With idle secondary cores, the kernel, ramdisk and FDT of a
+ * configuration are hashed side by side: fit_hash_prefetch() starts a
+ * job for each of their hash nodes, and fit_image_check_hashes() picks
+ * up the result instead of hashing the data itself.
+ */
+#define FIT_HASH_JOBS	8
+
+struct fit_hash_job {
+	struct mp_job	job;		/* must be first		*/
+	const void	*fit;		/* NULL when unused		*/
+	int		noffset;	/* hash node			*/
+	int		value_len;
+	uint8_t		value[FIT_MAX_HASH_LEN];
+};
+
+static struct fit_hash_job fit_hash_jobs[FIT_HASH_JOBS];
+
+/* The same as calculate_hash(), without watchdog and hash engine */
+static void fit_hash_job_fn(struct mp_job *job)
+{
+	struct fit_hash_job *hj = (struct fit_hash_job *)job;
+	uchar *data = (uchar *)job->arg[0];
+	ulong len = job->arg[1];
+	const char *algo = (const char *)job->arg[2];
+	sha256_context ctx;
+
+	job->result = 0;
+	if (strcmp(algo, "crc32") == 0) {
+		*((uint32_t *)hj->value) = cpu_to_uimage(crc32(0, data, len));
+		hj->value_len = 4;
+	} else if (strcmp(algo, "sha1") == 0) {
+		sha1_csum(data, len, hj->value);
+		hj->value_len = 20;
+	} else if (strcmp(algo, "sha256") == 0) {
+		sha256_starts(&ctx);
+		sha256_update(&ctx, data, len);
+		sha256_finish(&ctx, hj->value);
+		hj->value_len = SHA256_SUM_LEN;
+	} else if (strcmp(algo, "md5") == 0) {
+		md5(data, len, hj->value);
+		hj->value_len = 16;
+	} else {
+		job->result = -1;
+	}
+}
+
+static void fit_hash_prefetch_image(const void *fit, int image_noffset)
+{
+	struct fit_hash_job *hj;
+	const void *data;
+	size_t size;
+	char *algo;
+	int noffset;
+	int ndepth;
+	int i;
+
+	if (image_noffset < 0 ||
+	    fit_image_get_data(fit, image_noffset, &data, &size))
+		return;
+
+	for (ndepth = 0, noffset = fdt_next_node(fit, image_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node(fit, noffset, &ndepth)) {
+		if (ndepth != 1 ||
+		    strncmp(fit_get_name(fit, noffset, NULL),
+				FIT_HASH_NODENAME,
+				strlen(FIT_HASH_NODENAME)) != 0 ||
+		    fit_image_hash_get_algo(fit, noffset, &algo))
+			continue;
+
+		for (i = 0; i < FIT_HASH_JOBS && fit_hash_jobs[i].fit; i++)
+			;
+		if (i == FIT_HASH_JOBS)
+			return;
+
+		hj = &fit_hash_jobs[i];
+		hj->job.func = fit_hash_job_fn;
+		hj->job.arg[0] = (ulong)data;
+		hj->job.arg[1] = size;
+		hj->job.arg[2] = (ulong)algo;
+		/* no core left, the rest is hashed when it is checked */
+		if (mp_job_start(&hj->job))
+			return;
+		hj->fit = fit;
+		hj->noffset = noffset;
+	}
+}
+
 /**
- * fit_image_check_hashes - verify data intergity
+ * fit_hash_prefetch - start hashing the images of a configuration
+ * @fit: pointer to the FIT format image header
+ * @cfg_noffset: configuration node offset
+ *
+ * fit_hash_prefetch() hands the hashes of the kernel, ramdisk and FDT
+ * images of the configuration to secondary cores, as far as there are
+ * idle ones.  fit_hash_release() must be called once the images have
+ * been checked.
+ */
+void fit_hash_prefetch(const void *fit, int cfg_noffset)
+{
+	fit_hash_release();
+
+	fit_hash_prefetch_image(fit, fit_conf_get_kernel_node(fit,
+								cfg_noffset));
+	fit_hash_prefetch_image(fit, fit_conf_get_ramdisk_node(fit,
+								cfg_noffset));
+	fit_hash_prefetch_image(fit, fit_conf_get_fdt_node(fit, cfg_noffset));
+}
+
+/**
+ * fit_hash_release - drop the hashes fit_hash_prefetch() left unused
+ *
+ * The data may change after this, the results can not be used later.
+ */
+void fit_hash_release(void)
+{
+	int i;
+
+	for (i = 0; i < FIT_HASH_JOBS; i++) {
+		if (!fit_hash_jobs[i].fit)
+			continue;
+		mp_job_wait(&fit_hash_jobs[i].job);
+		fit_hash_jobs[i].fit = NULL;
+	}
+}
+
+/* Return 0 and the prefetched hash of a hash node, -1 if there is none */
+static int fit_hash_collect(const void *fit, int noffset, uint8_t *value,
+				int *value_len)
+{
+	struct fit_hash_job *hj;
+	int i;
+
+	for (i = 0; i < FIT_HASH_JOBS; i++) {
+		hj = &fit_hash_jobs[i];
+		if (hj->fit != fit || hj->noffset != noffset)
+			continue;
+
+		hj->fit = NULL;
+		if (mp_job_wait(&hj->job))
+			return -1;
+		memcpy(value, hj->value, hj->value_len);
+		*value_len = hj->value_len;
+		return 0;
+	}
+	return -1;
+}
+#else
+static inline int fit_hash_collect(const void *fit, int noffset,
+					uint8_t *value, int *value_len)
+{
+	return -1;
+}
+#endif /* CONFIG_MP_JOBS && !USE_HOSTCC */
+
+/**
+ * fit_image_hashes - verify data intergity, measure the image
  * @fit: pointer to the FIT format image header
  * @image_noffset: component image node offset
+ * @measure: queue the image for a TPM measurement as well
  *
- * fit_image_check_hashes() goes over component image hash nodes,
+ * fit_image_hashes() goes over component image hash nodes,
  * re-calculates each data hash and compares with the value stored in hash
- * node.
+ * node.  A verified SHA-1 is what gets measured, the data is only hashed
+ * once more for that if the image has none.
  *
  * returns:
  *     1, if all hashes are valid
  *     0, otherwise (or on error)
  */
-int fit_image_check_hashes(const void *fit, int image_noffset)
+static int fit_image_hashes(const void *fit, int image_noffset, int measure)
 {
 	const void	*data;
 	size_t		size;
@@ -2741,6 +3041,9 @@ int fit_image_check_hashes(const void *fit, int image_noffset)
 	int		noffset;
 	int		ndepth;
 	char		*err_msg = "";
+#if defined(CONFIG_TPM_MEASURE) && !defined(USE_HOSTCC)
+	int		measured = !measure;
+#endif
 
 	/* Get image data and data length */
 	if (fit_image_get_data(fit, image_noffset, &data, &size)) {
@@ -2779,7 +3082,9 @@ int fit_image_check_hashes(const void *fit, int image_noffset)
 				goto error;
 			}
 
-			if (calculate_hash(data, size, algo, value,
+			if (fit_hash_collect(fit, noffset, value,
+						&value_len) &&
+			    calculate_hash(data, size, algo, value,
 						&value_len)) {
 				err_msg = " error!\n"
 						"Unsupported hash algorithm";
@@ -2793,10 +3098,20 @@ int fit_image_check_hashes(const void *fit, int image_noffset)
 				err_msg = " error!\nBad hash value";
 				goto error;
 			}
+#if defined(CONFIG_TPM_MEASURE) && !defined(USE_HOSTCC)
+			if (!measured && value_len == TPM_DIGEST_SIZE &&
+			    strcmp(algo, "sha1") == 0)
+				measured = !tpm_measure_digest(
+						CONFIG_TPM_MEASURE_PCR, value);
+#endif
 			printf("+ ");
 		}
 	}
 
+#if defined(CONFIG_TPM_MEASURE) && !defined(USE_HOSTCC)
+	if (!measured)
+		tpm_measure(CONFIG_TPM_MEASURE_PCR, data, size);
+#endif
 	return 1;
 
 error:
@@ -2806,6 +3121,27 @@ error:
 	return 0;
 }
 
+int fit_image_check_hashes(const void *fit, int image_noffset)
+{
+	return fit_image_hashes(fit, image_noffset, 0);
+}
+
+#if defined(CONFIG_TPM_MEASURE) && !defined(USE_HOSTCC)
+int fit_image_check_measure(const void *fit, int image_noffset)
+{
+	return fit_image_hashes(fit, image_noffset, 1);
+}
+
+void fit_image_measure(const void *fit, int image_noffset)
+{
+	const void *data;
+	size_t size;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size) == 0)
+		tpm_measure(CONFIG_TPM_MEASURE_PCR, data, size);
+}
+#endif
+
 /**
  * fit_all_image_check_hashes - verify data intergity for all images
  * @fit: pointer to the FIT format image header
@@ -3168,25 +3504,27 @@ static int fit_check_ramdisk(const void *fit, int rd_noffset, uint8_t arch,
 
 	if (verify) {
 		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_check_hashes(fit, rd_noffset)) {
+		if (!fit_image_check_measure(fit, rd_noffset)) {
 			puts("Bad Data Hash\n");
-			show_boot_progress(-125);
+			bootstage_mark(-125);
 			return 0;
 		}
 		puts("OK\n");
+	} else {
+		fit_image_measure(fit, rd_noffset);
 	}
 
-	show_boot_progress(126);
+	bootstage_mark(126);
 	if (!fit_image_check_os(fit, rd_noffset, IH_OS_LINUX) ||
 	    !fit_image_check_arch(fit, rd_noffset, arch) ||
 	    !fit_image_check_type(fit, rd_noffset, IH_TYPE_RAMDISK)) {
 		printf("No Linux %s Ramdisk Image\n",
 				genimg_get_arch_name(arch));
-		show_boot_progress(-126);
+		bootstage_mark(-126);
 		return 0;
 	}
 
-	show_boot_progress(127);
+	bootstage_mark(127);
 	return 1;
 }
 #endif /* USE_HOSTCC */
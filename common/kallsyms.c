@@ -12,7 +12,7 @@ extern const char system_map[] __attribute__((weak));
 
 /* Given an address, return a pointer to the symbol name and store
  * the base address in caddr.  So if the symbol map had an entry:
- *		03fb9b7c_spi_cs_deactivate
+ *		03fb9b7c _spi_cs_deactivate
  * Then the following call:
  *		unsigned long base;
  *		const char *sym = symbol_lookup(0x03fb9b80, &base);
@@ -32,7 +32,8 @@ const char *symbol_lookup(unsigned long addr, unsigned long *caddr)
 
 	while (*sym) {
 		sym_addr = simple_strtoul(sym, &esym, 16);
-		sym = esym;
+		/* the space keeps names like "crc32" out of the address */
+		sym = esym + 1;
 		if (sym_addr > addr)
 			break;
 		*caddr = sym_addr;
@@ -35,6 +35,7 @@
 #include <stdarg.h>
 #include <linux/types.h>
 #include <stdio_dev.h>
+#include <malloc.h>
 #if defined(CONFIG_POST)
 #include <post.h>
 #endif
@@ -103,7 +104,7 @@ static int lcd_getfgcolor (void);
 static void console_scrollup (void)
 {
 	/* Copy up rows ignoring the first one */
-	memcpy (CONSOLE_ROW_FIRST, CONSOLE_ROW_SECOND, CONSOLE_SCROLL_SIZE);
+	memmove (CONSOLE_ROW_FIRST, CONSOLE_ROW_SECOND, CONSOLE_SCROLL_SIZE);
 
 	/* Clear the last one */
 	memset (CONSOLE_ROW_LAST, COLOR_MASK(lcd_color_bg), CONSOLE_ROW_SIZE);
@@ -211,6 +212,76 @@ void lcd_printf(const char *fmt, ...)
 /* ** Low-Level Graphics Routines					*/
 /************************************************************************/
 
+#if defined(CONFIG_LCD_GLYPH_CACHE) && \
+	(LCD_BPP == LCD_COLOR8 || LCD_BPP == LCD_COLOR16)
+/*
+ * The font rendered in the framebuffer's pixel format for the current
+ * colour pair, so that a character is drawn with one copy per row.
+ * Allocated on first use, and rendered again when the colours change.
+ */
+#define GLYPH_LINE_SIZE	(VIDEO_FONT_WIDTH * NBITS(LCD_BPP) / 8)
+#define GLYPH_SIZE	(VIDEO_FONT_HEIGHT * GLYPH_LINE_SIZE)
+
+static uchar *glyph_cache;
+static int glyph_fg, glyph_bg;
+
+static uchar *lcd_glyphs (void)
+{
+	int i, c;
+
+	if (!glyph_cache) {
+		glyph_cache = malloc (VIDEO_FONT_CHARS * GLYPH_SIZE);
+		if (!glyph_cache)
+			return NULL;
+	} else if (glyph_fg == lcd_color_fg && glyph_bg == lcd_color_bg) {
+		return glyph_cache;
+	}
+
+	for (i = 0; i < VIDEO_FONT_SIZE; ++i) {
+		uchar bits = video_fontdata[i];
+#if LCD_BPP == LCD_COLOR16
+		ushort *d = (ushort *)(glyph_cache + i * GLYPH_LINE_SIZE);
+#else
+		uchar *d = glyph_cache + i * GLYPH_LINE_SIZE;
+#endif
+
+		for (c = 0; c < VIDEO_FONT_WIDTH; ++c, bits <<= 1)
+			*d++ = (bits & 0x80) ? lcd_color_fg : lcd_color_bg;
+	}
+	glyph_fg = lcd_color_fg;
+	glyph_bg = lcd_color_bg;
+
+	return glyph_cache;
+}
+
+static int lcd_drawchars_cached (uchar *dest, uchar *str, int count)
+{
+	uchar *glyphs = lcd_glyphs ();
+	int i;
+
+	if (!glyphs)
+		return -1;
+
+	for (i = 0; i < count; ++i, dest += GLYPH_LINE_SIZE) {
+		uchar *glyph = glyphs + str[i] * GLYPH_SIZE;
+		uchar *d = dest;
+		ushort row;
+
+		for (row = 0; row < VIDEO_FONT_HEIGHT; ++row) {
+			memcpy (d, glyph, GLYPH_LINE_SIZE);
+			glyph += GLYPH_LINE_SIZE;
+			d += lcd_line_length;
+		}
+	}
+	return 0;
+}
+#else
+static inline int lcd_drawchars_cached (uchar *dest, uchar *str, int count)
+{
+	return -1;
+}
+#endif /* CONFIG_LCD_GLYPH_CACHE */
+
 static void lcd_drawchars (ushort x, ushort y, uchar *str, int count)
 {
 	uchar *dest;
@@ -222,6 +293,9 @@ static void lcd_drawchars (ushort x, ushort y, uchar *str, int count)
 
 	dest = (uchar *)(lcd_base + y * lcd_line_length + x * (1 << LCD_BPP) / 8);
 
+	if (lcd_drawchars_cached (dest, str, count) == 0)
+		return;
+
 	for (row=0;  row < VIDEO_FONT_HEIGHT;  ++row, dest += lcd_line_length)  {
 		uchar *s = str;
 		int i;
@@ -604,13 +678,106 @@ void bitmap_plot (int x, int y)
 #if defined(CONFIG_CMD_BMP) || defined(CONFIG_SPLASH_SCREEN)
 /*
  * Display the BMP file located at address bmp_image.
- * Only uncompressed.
+ * Only uncompressed, or RLE8 with CONFIG_LCD_BMP_RLE8.
  */
 
-#ifdef CONFIG_SPLASH_SCREEN_ALIGN
-#define BMP_ALIGN_CENTER	0x7FFF
+/* Frame buffers that hold the colour index of a BMP as it is */
+#if defined(CONFIG_CPU_PXA) || defined(CONFIG_ATMEL_LCD)
+#define LCD_BMP_PLAIN_INDEX
+#endif
+
+#ifdef CONFIG_LCD_BMP_RLE8
+/* Draw cnt pixels of a run, all of colour *src if enc is set */
+static void lcd_rle8_draw(uchar *fb, int bpix, ushort *cmap,
+			  const uchar *src, int cnt, int enc)
+{
+	ushort *fb16 = (ushort *)fb;
+	int i;
+
+	if (bpix != 16) {
+		if (enc)
+			memset(fb, *src, cnt);
+		else
+			memcpy(fb, src, cnt);
+		return;
+	}
+
+	for (i = 0; i < cnt; i++)
+		fb16[i] = cmap[enc ? *src : src[i]];
+}
+
+/*
+ * Decode straight into the frame buffer.  (x, y) is where the top left
+ * corner of the bitmap goes; only width x height pixels of it are drawn.
+ */
+static int lcd_display_rle8_bitmap(bmp_image_t *bmp, ushort *cmap,
+				   int x, int y, int width, int height)
+{
+	int bpix = NBITS(panel_info.vl_bpix);
+	uchar *bm = (uchar *)bmp + le32_to_cpu(bmp->header.data_offset);
+	uchar *end = (uchar *)bmp + le32_to_cpu(bmp->header.file_size);
+	int row = le32_to_cpu(bmp->header.height) - 1;	/* from the top */
+	int col = 0;
+	uchar *fb;
+	int cnt, run;
+
+#ifndef LCD_BMP_PLAIN_INDEX
+	if (bpix != 16) {
+		printf("Error: RLE8 bitmaps need a 16 bit/pixel panel here\n");
+		return 1;
+	}
 #endif
 
+	while (bm + 1 < end && row >= 0) {
+		if (bm[0] == 0 && bm[1] < 3) {
+			switch (bm[1]) {
+			case 0:			/* end of line */
+				row--;
+				col = 0;
+				bm += 2;
+				continue;
+			case 1:			/* end of bitmap */
+				return 0;
+			default:		/* move */
+				if (bm + 3 >= end)
+					return 0;
+				col += bm[2];
+				row -= bm[3];
+				bm += 4;
+				continue;
+			}
+		}
+
+		/* a run of bm[0] pixels, or bm[1] given ones */
+		if (bm[0]) {
+			run = bm[0];
+		} else {
+			run = bm[1];
+			if (bm + 2 + run > end)
+				break;
+		}
+
+		cnt = run;
+		if (row < height && col < width) {
+			if (col + cnt > width)
+				cnt = width - col;
+			fb = (uchar *)lcd_base + (y + row) * lcd_line_length +
+				(x + col) * bpix / 8;
+			lcd_rle8_draw(fb, bpix, cmap, bm[0] ? bm + 1 : bm + 2,
+				      cnt, bm[0] != 0);
+		}
+		col += run;
+
+		if (bm[0])
+			bm += 2;
+		else
+			bm += 2 + ((run + 1) & ~1);	/* padded to 16 bits */
+	}
+
+	return 0;
+}
+#endif /* CONFIG_LCD_BMP_RLE8 */
+
 int lcd_display_bitmap(ulong bmp_image, int x, int y)
 {
 #if !defined(CONFIG_MCC200)
@@ -738,6 +905,13 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 	if ((y + height)>panel_info.vl_row)
 		height = panel_info.vl_row - y;
 
+#ifdef CONFIG_LCD_BMP_RLE8
+	if (bmp_bpix == 8 &&
+	    le32_to_cpu(bmp->header.compression) == BMP_BI_RLE8)
+		return lcd_display_rle8_bitmap(bmp, cmap_base, x, y,
+					       width, height);
+#endif
+
 	bmap = (uchar *)bmp + le32_to_cpu (bmp->header.data_offset);
 	fb   = (uchar *) (lcd_base +
 		(y + height - 1) * lcd_line_length + x * bpix / 8);
@@ -745,6 +919,14 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 	switch (bmp_bpix) {
 	case 1: /* pass through */
 	case 8:
+#ifdef LCD_BMP_PLAIN_INDEX
+		if (bpix != 16) {
+			/* same format: whole rows, bottom up */
+			bmp_blit(fb, -lcd_line_length, bmap, padded_line,
+				 width, height);
+			break;
+		}
+#endif
 		if (bpix != 16)
 			byte_width = width;
 		else
@@ -764,30 +946,31 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 					fb += sizeof(uint16_t) / sizeof(*fb);
 				}
 			}
-			bmap += (width - padded_line);
+			bmap += (padded_line - width);
 			fb   -= (byte_width + lcd_line_length);
 		}
 		break;
 
 #if defined(CONFIG_BMP_16BPP)
 	case 16:
+#if defined(CONFIG_ATMEL_LCD_BGR555)
 		for (i = 0; i < height; ++i) {
 			WATCHDOG_RESET();
 			for (j = 0; j < width; j++) {
-#if defined(CONFIG_ATMEL_LCD_BGR555)
 				*(fb++) = ((bmap[0] & 0x1f) << 2) |
 					(bmap[1] & 0x03);
 				*(fb++) = (bmap[0] & 0xe0) |
 					((bmap[1] & 0x7c) >> 2);
 				bmap += 2;
-#else
-				*(fb++) = *(bmap++);
-				*(fb++) = *(bmap++);
-#endif
 			}
 			bmap += (padded_line - width) * 2;
 			fb   -= (width * 2 + lcd_line_length);
 		}
+#else
+		/* same format: whole rows, bottom up */
+		bmp_blit(fb, -lcd_line_length, bmap, padded_line * 2,
+			 width * 2, height);
+#endif
 		break;
 #endif /* CONFIG_BMP_16BPP */
 
@@ -833,6 +1016,10 @@ static void *lcd_logo (void)
 
 		if (!((bmp->header.signature[0]=='B') &&
 		      (bmp->header.signature[1]=='M'))) {
+			if (bmp_display_gz(addr, x, y, panel_info.vl_col,
+					   panel_info.vl_row,
+					   lcd_display_bitmap) == 0)
+				return ((void *)lcd_base);
 			addr = (ulong)gunzip_bmp(addr, &len);
 		}
 #endif
@@ -0,0 +1,162 @@
+/*
+ * Checksum images while they are being loaded
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Verifying a large legacy image after it has been loaded reads all of
+ * it back from DRAM once more.  Instead, the data CRC is accumulated
+ * while the loader writes it, when it is still in the cache, and
+ * image_check_dcrc() just compares the result.  The CRC starts after
+ * the first sizeof(image_header_t) bytes, which is where the data of a
+ * legacy image begins.
+ *
+ * Loaders that do not report their writes (ext2load, fatload, "sf
+ * read", loadb, ...) could modify the image behind our back.  So the
+ * command loop calls load_hash_command() before each command, which
+ * drops the result unless the command is known to leave memory alone;
+ * a cached CRC that does not match is not trusted either, in both
+ * cases image_check_dcrc() falls back to reading the image.
+ *
+ * For measured boot the SHA-1 of the data is accumulated the same way,
+ * and only handed out together with a CRC that is being trusted.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <image.h>
+#include <load_hash.h>
+#ifdef CONFIG_TPM_MEASURE
+#include <sha1.h>
+#endif
+
+enum {
+	LOAD_HASH_IDLE,		/* nothing recorded			*/
+	LOAD_HASH_RUNNING,	/* a load is in progress		*/
+	LOAD_HASH_DONE,		/* the last load completed in order	*/
+};
+
+static int	load_hash_state;
+static ulong	load_hash_addr;	/* where the load started		*/
+static ulong	load_hash_next;	/* next address we expect data for	*/
+static uint32_t	load_hash_crc;	/* CRC after the header so far		*/
+#ifdef CONFIG_TPM_MEASURE
+static sha1_context load_hash_sha1;
+#endif
+
+void load_hash_start(ulong addr)
+{
+	load_hash_addr = addr;
+	load_hash_next = addr;
+	load_hash_crc = 0;
+#ifdef CONFIG_TPM_MEASURE
+	sha1_starts(&load_hash_sha1);
+#endif
+	load_hash_state = LOAD_HASH_RUNNING;
+	load_unzip_start(addr);
+}
+
+void load_hash_update(ulong addr, const void *data, ulong len)
+{
+	ulong data_start = load_hash_addr + sizeof(image_header_t);
+	const uchar *p = data;
+
+	load_unzip_update(addr, data, len);
+
+	if (load_hash_state == LOAD_HASH_DONE) {
+		/* something is loading over the recorded image */
+		if (addr < load_hash_next && addr + len > load_hash_addr)
+			load_hash_state = LOAD_HASH_IDLE;
+		return;
+	}
+	if (load_hash_state != LOAD_HASH_RUNNING)
+		return;
+
+	if (addr != load_hash_next) {
+		/* out of order or rewritten: give up, bootm checks itself */
+		load_hash_state = LOAD_HASH_IDLE;
+		return;
+	}
+	load_hash_next += len;
+
+	/* skip whatever part of this piece is still header */
+	if (addr < data_start) {
+		ulong skip = min(data_start - addr, len);
+
+		p += skip;
+		len -= skip;
+	}
+	if (len) {
+		load_hash_crc = crc32_wd(load_hash_crc, p, len, CHUNKSZ_CRC32);
+#ifdef CONFIG_TPM_MEASURE
+		sha1_update(&load_hash_sha1, (unsigned char *)p, len);
+#endif
+	}
+}
+
+void load_hash_finish(void)
+{
+	if (load_hash_state == LOAD_HASH_RUNNING)
+		load_hash_state = LOAD_HASH_DONE;
+	load_unzip_finish();
+}
+
+void load_hash_invalidate(void)
+{
+	load_hash_state = LOAD_HASH_IDLE;
+	load_unzip_invalidate();
+}
+
+/*
+ * Commands that run between a load and bootm without writing memory.
+ * The loaders that track their data start over themselves.
+ */
+static const char load_hash_keep[] =
+	"boot bootd bootm iminfo setenv printenv echo run test true false "
+	"sleep help version bdinfo";
+
+void load_hash_command(cmd_tbl_t *cmdtp)
+{
+	const char *p = load_hash_keep;
+	int len = strlen(cmdtp->name);
+
+	if (load_hash_state == LOAD_HASH_IDLE)
+		return;
+
+	while ((p = strstr(p, cmdtp->name)) != NULL) {
+		if ((p == load_hash_keep || p[-1] == ' ') &&
+		    (p[len] == ' ' || p[len] == '\0'))
+			return;
+		p += len;
+	}
+	debug("load hash: dropped by \"%s\"\n", cmdtp->name);
+	load_hash_invalidate();
+}
+
+int load_hash_get_dcrc(ulong addr, ulong len, uint32_t *crc)
+{
+	if (load_hash_state != LOAD_HASH_DONE ||
+	    addr != load_hash_addr + sizeof(image_header_t) ||
+	    addr + len != load_hash_next)
+		return -1;
+
+	debug("load hash: using CRC of %08lx..%08lx\n", addr, addr + len);
+	*crc = load_hash_crc;
+	return 0;
+}
+
+#ifdef CONFIG_TPM_MEASURE
+int load_hash_get_sha1(ulong addr, ulong len, uint32_t dcrc, uint8_t *digest)
+{
+	sha1_context ctx = load_hash_sha1;
+	uint32_t crc;
+
+	if (load_hash_get_dcrc(addr, len, &crc) || crc != dcrc)
+		return -1;
+
+	sha1_finish(&ctx, digest);
+	return 0;
+}
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Program images to storage while they are being loaded
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Loading an image to memory and writing it to flash afterwards takes
+ * the sum of both times, and memory as large as the image.  Here the
+ * loader's data go to a ring buffer instead, and whatever has arrived
+ * in order is programmed from the load loop in pieces small enough to
+ * fit between two packets, while the sender prepares the next ones.
+ * Only when the ring is full does the loader wait for the flash, which
+ * delays its acknowledge and so slows the sender down.
+ *
+ * Areas that cannot be written in pieces (FAT files) are collected
+ * whole in the buffer and written at the end.  UBI volumes are written in
+ * pieces, but only once the size of the image is known, from the TFTP
+ * "tsize" option.
+ */
+
+#include <common.h>
+#include <load_hash.h>
+#include <load_stream.h>
+
+#ifndef CONFIG_SYS_LOAD_STREAM_PIECE
+#define CONFIG_SYS_LOAD_STREAM_PIECE	(64 << 10)
+#endif
+
+static struct {
+	int		active;
+	int		failed;
+	struct dl_part	part;
+	u8		*buf;
+	ulong		size;		/* of the ring			*/
+	ulong		written;	/* bytes programmed		*/
+	ulong		committed;	/* bytes received in order	*/
+	ulong		high;		/* end of the furthest data	*/
+} ls;
+
+int load_stream_start(const struct dl_part *part, void *buf, ulong size)
+{
+	memset(&ls, 0, sizeof(ls));
+	ls.part = *part;
+
+	/* whole pieces, so that one never wraps around the ring */
+	if (dl_part_streams(part))
+		size -= size % CONFIG_SYS_LOAD_STREAM_PIECE;
+	if (!size) {
+		puts("Stream buffer too small\n");
+		return -1;
+	}
+	ls.buf = buf;
+	ls.size = size;
+
+	if (dl_part_open(&ls.part))
+		return -1;
+	ls.active = 1;
+	return 0;
+}
+
+int load_stream_active(void)
+{
+	return ls.active;
+}
+
+/* Program up to len bytes of what has come in order */
+static int load_stream_write(ulong len)
+{
+	ulong pos = ls.written % ls.size;
+
+	if (len > ls.size - pos)
+		len = ls.size - pos;
+	if (dl_part_write(&ls.part, ls.buf + pos, len)) {
+		ls.failed = 1;
+		return -1;
+	}
+	ls.written += len;
+	return 0;
+}
+
+int load_stream_store(ulong offset, const void *data, ulong len)
+{
+	const u8 *p = data;
+	ulong pos, n;
+
+	if (ls.failed)
+		return -1;
+
+	if (!dl_part_streams(&ls.part)) {
+		if (offset + len > ls.size) {
+			printf("%s: image larger than the buffer\n",
+			       ls.part.name);
+			ls.failed = 1;
+			return -1;
+		}
+	} else {
+		/* sent again after it has been programmed */
+		if (offset + len <= ls.written)
+			return 0;
+		if (offset < ls.written) {
+			p += ls.written - offset;
+			len -= ls.written - offset;
+			offset = ls.written;
+		}
+
+		/* the ring is full: make room before taking more */
+		while (offset + len > ls.written + ls.size) {
+			if (ls.committed == ls.written) {
+				puts("Stream buffer too small\n");
+				ls.failed = 1;
+				return -1;
+			}
+			if (load_stream_write(ls.committed - ls.written))
+				return -1;
+		}
+	}
+
+	for (pos = offset; pos < offset + len; pos += n) {
+		n = min(offset + len - pos, ls.size - pos % ls.size);
+		memcpy(ls.buf + pos % ls.size, p + (pos - offset), n);
+	}
+
+	if (offset <= ls.committed && offset + len > ls.committed)
+		ls.committed = offset + len;
+	if (offset + len > ls.high)
+		ls.high = offset + len;
+	return 0;
+}
+
+void load_stream_commit(ulong end)
+{
+	if (end > ls.high)
+		end = ls.high;
+	if (end > ls.committed)
+		ls.committed = end;
+}
+
+/* Told before the first piece is programmed, for UBI volumes */
+void load_stream_size(ulong len)
+{
+	if (ls.active && !ls.written)
+		ls.part.image_len = len;
+}
+
+void load_stream_reset(void)
+{
+	if (!ls.active)
+		return;
+	if (ls.written) {
+		/* start the area over */
+		dl_part_close(&ls.part);
+		if (dl_part_open(&ls.part))
+			ls.failed = 1;
+	}
+	ls.written = 0;
+	ls.committed = 0;
+	ls.high = 0;
+}
+
+int load_stream_poll(void)
+{
+	if (!ls.active || !dl_part_streams(&ls.part))
+		return 0;
+	if (ls.failed)
+		return -1;
+
+	if (ls.committed - ls.written < CONFIG_SYS_LOAD_STREAM_PIECE)
+		return 0;
+	return load_stream_write(CONFIG_SYS_LOAD_STREAM_PIECE);
+}
+
+int load_stream_finish(ulong len)
+{
+	int ret = ls.failed ? -1 : 0;
+
+	if (!ls.active)
+		return -1;
+	ls.active = 0;
+	/* the data never were where the load address says */
+	load_hash_invalidate();
+
+	if (!ret && ls.committed != len) {
+		printf("%s: image incomplete\n", ls.part.name);
+		ret = -1;
+	}
+
+	if (!dl_part_streams(&ls.part)) {
+		if (!ret)
+			ret = dl_part_write(&ls.part, ls.buf, len);
+	} else {
+		while (!ret && ls.written < len)
+			ret = load_stream_write(len - ls.written);
+	}
+
+	if (dl_part_close(&ls.part))
+		ret = -1;
+	if (!ret)
+		printf("%lu bytes written to %s\n", len, ls.part.name);
+	return ret;
+}
+
+void load_stream_abort(void)
+{
+	if (!ls.active)
+		return;
+	ls.active = 0;
+	load_hash_invalidate();
+	dl_part_close(&ls.part);
+}
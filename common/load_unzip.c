@@ -0,0 +1,235 @@
+/*
+ * Uncompress gzip'ed kernels while they are being loaded
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * When a legacy kernel image compressed with gzip is loaded, bootm
+ * reads it back from DRAM and inflates it to its load address only
+ * after the whole file has arrived.  Instead, the data is fed to an
+ * inflate stream as the loader writes it, so the CPU decompresses
+ * while the network or the storage device is busy with the next piece,
+ * and bootm merely finds the kernel in place.
+ *
+ * This relies on the write notifications of CONFIG_LOAD_HASH.  It only
+ * happens when the image header has been seen, its header checksum is
+ * right, and the decompressed kernel can overlap neither the compressed
+ * one nor U-Boot's own memory.
+ * Every problem just drops the result: the compressed image is still
+ * stored at the load address, so bootm uncompresses it as usual.
+ */
+
+#include <common.h>
+#include <image.h>
+#include <load_hash.h>
+#include <malloc.h>
+#include <lmb.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifndef CONFIG_SYS_BOOTM_LEN
+#define CONFIG_SYS_BOOTM_LEN	0x800000	/* same default as bootm */
+#endif
+
+enum {
+	LOAD_UNZIP_IDLE,	/* not looking at this load		*/
+	LOAD_UNZIP_HEADER,	/* waiting for the complete header	*/
+	LOAD_UNZIP_RUNNING,	/* inflating the data			*/
+	LOAD_UNZIP_ENDED,	/* end of gzip stream seen		*/
+};
+
+/* the load in progress */
+static int	unzip_state;
+static ulong	unzip_hdr;	/* where the image header is		*/
+static ulong	unzip_next;	/* next address we expect data for	*/
+static ulong	unzip_dst;	/* load address from the header		*/
+static ulong	unzip_len;	/* uncompressed length			*/
+
+/* the last image that was uncompressed completely */
+static int	done_valid;
+static ulong	done_hdr;
+static ulong	done_end;	/* end of the compressed image		*/
+static ulong	done_dst;
+static ulong	done_len;
+static uint32_t	done_dcrc;
+
+static inline int ranges_overlap(ulong a, ulong alen, ulong b, ulong blen)
+{
+	return a < b + blen && b < a + alen;
+}
+
+/*
+ * An image sent from anywhere must not inflate itself over U-Boot: the
+ * destination has to be clear of the malloc arena, of the stack up to
+ * the global data above it, and of what bootm keeps out of through lmb,
+ * which on the architectures that implement it is all of U-Boot from
+ * the stack to the top of RAM.
+ */
+static int load_unzip_dst_ok(ulong dst, ulong len)
+{
+	ulong sp = (ulong)&len - 1024;
+#ifdef CONFIG_LMB
+	struct lmb lmb;
+	int i;
+#endif
+
+	if (ranges_overlap(dst, len, mem_malloc_start,
+			   mem_malloc_end - mem_malloc_start))
+		return 0;
+	if ((ulong)gd > sp &&
+	    ranges_overlap(dst, len, sp, (ulong)gd + sizeof(gd_t) - sp))
+		return 0;
+
+#ifdef CONFIG_LMB
+	lmb_init(&lmb);
+	lmb_add(&lmb, (phys_addr_t)getenv_bootm_low(), getenv_bootm_size());
+	arch_lmb_reserve(&lmb);
+	board_lmb_reserve(&lmb);
+
+	for (i = 0; i < lmb.reserved.cnt; i++)
+		if (ranges_overlap(dst, len, lmb.reserved.region[i].base,
+				   lmb.reserved.region[i].size))
+			return 0;
+#endif
+	return 1;
+}
+
+static void load_unzip_abort(void)
+{
+	if (unzip_state == LOAD_UNZIP_RUNNING)
+		gunzip_stream_end();
+	unzip_state = LOAD_UNZIP_IDLE;
+}
+
+void load_unzip_start(ulong addr)
+{
+	load_unzip_abort();
+	unzip_hdr = addr;
+	unzip_next = addr;
+	if (getenv_yesno("loadunzip"))
+		unzip_state = LOAD_UNZIP_HEADER;
+}
+
+/* Look at the complete header, set up the stream if the image qualifies */
+static int load_unzip_check_header(void)
+{
+	image_header_t *hdr = (image_header_t *)unzip_hdr;
+	ulong size;
+
+	if (!image_check_magic(hdr) || !image_check_hcrc(hdr) ||
+	    !image_check_type(hdr, IH_TYPE_KERNEL) ||
+	    image_get_comp(hdr) != IH_COMP_GZIP)
+		return -1;
+
+	size = image_get_image_size(hdr);
+	unzip_dst = image_get_load(hdr);
+	if (ranges_overlap(unzip_dst, CONFIG_SYS_BOOTM_LEN, unzip_hdr, size)) {
+		debug("load unzip: %08lx overlaps the image\n", unzip_dst);
+		return -1;
+	}
+	if (!load_unzip_dst_ok(unzip_dst, CONFIG_SYS_BOOTM_LEN)) {
+		printf("load unzip: %08lx overlaps U-Boot, not uncompressed\n",
+		       unzip_dst);
+		return -1;
+	}
+	/* the previous result may be in the way */
+	if (done_valid &&
+	    (ranges_overlap(unzip_dst, CONFIG_SYS_BOOTM_LEN,
+			    done_hdr, done_end - done_hdr) ||
+	     ranges_overlap(unzip_dst, CONFIG_SYS_BOOTM_LEN,
+			    done_dst, done_len)))
+		done_valid = 0;
+
+	return gunzip_stream_start((void *)unzip_dst, CONFIG_SYS_BOOTM_LEN);
+}
+
+void load_unzip_update(ulong addr, const void *data, ulong len)
+{
+	ulong data_start = unzip_hdr + image_get_header_size();
+	ulong data_end, from, to;
+
+	/* anything written over the last result spoils it */
+	if (done_valid && (ranges_overlap(addr, len, done_dst, done_len) ||
+			   ranges_overlap(addr, len, done_hdr,
+					  done_end - done_hdr)))
+		done_valid = 0;
+
+	if (unzip_state == LOAD_UNZIP_IDLE)
+		return;
+	if (addr != unzip_next) {
+		load_unzip_abort();
+		return;
+	}
+	unzip_next += len;
+
+	if (unzip_state == LOAD_UNZIP_HEADER) {
+		if (unzip_next < data_start)
+			return;
+		if (load_unzip_check_header()) {
+			unzip_state = LOAD_UNZIP_IDLE;
+			return;
+		}
+		unzip_state = LOAD_UNZIP_RUNNING;
+	}
+	if (unzip_state != LOAD_UNZIP_RUNNING)
+		return;
+
+	/* feed whatever part of [addr, unzip_next) is image data */
+	data_end = data_start +
+		image_get_data_size((image_header_t *)unzip_hdr);
+	from = max(addr, data_start);
+	to = min(unzip_next, data_end);
+	if (from >= to)
+		return;
+
+	switch (gunzip_stream_feed((const uchar *)data + (from - addr),
+				   to - from, &unzip_len)) {
+	case 0:
+		break;
+	case 1:
+		unzip_state = LOAD_UNZIP_ENDED;
+		break;
+	default:
+		unzip_state = LOAD_UNZIP_IDLE;
+		break;
+	}
+}
+
+void load_unzip_finish(void)
+{
+	image_header_t *hdr = (image_header_t *)unzip_hdr;
+
+	if (unzip_state == LOAD_UNZIP_ENDED &&
+	    unzip_next >= unzip_hdr + image_get_image_size(hdr)) {
+		done_hdr = unzip_hdr;
+		done_end = unzip_hdr + image_get_image_size(hdr);
+		done_dst = unzip_dst;
+		done_len = unzip_len;
+		done_dcrc = image_get_dcrc(hdr);
+		done_valid = 1;
+		debug("load unzip: %08lx..%08lx uncompressed\n",
+		      done_dst, done_dst + done_len);
+	}
+	load_unzip_abort();
+}
+
+void load_unzip_invalidate(void)
+{
+	load_unzip_abort();
+	done_valid = 0;
+}
+
+int load_unzip_get(ulong data, ulong len, ulong load, ulong *unc_len)
+{
+	image_header_t *hdr = (image_header_t *)done_hdr;
+
+	if (!done_valid || data != done_hdr + image_get_header_size() ||
+	    data + len != done_end || load != done_dst ||
+	    image_get_dcrc(hdr) != done_dcrc)
+		return -1;
+
+	*unc_len = done_len;
+	return 0;
+}
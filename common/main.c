@@ -30,6 +30,7 @@
 #include <common.h>
 #include <watchdog.h>
 #include <command.h>
+#include <load_hash.h>
 #include <version.h>
 #ifdef CONFIG_MODEM_SUPPORT
 #include <malloc.h>		/* for free() prototype */
@@ -40,7 +41,11 @@
 #endif
 
 #include <post.h>
+#include <prof.h>
 #include <linux/ctype.h>
+#ifdef CONFIG_AUTOBOOT_FAST_GPIO
+#include <asm/gpio.h>
+#endif
 
 #if defined(CONFIG_SILENT_CONSOLE) || defined(CONFIG_POST) || defined(CONFIG_CMDLINE_EDITING)
 DECLARE_GLOBAL_DATA_PTR;
@@ -87,6 +92,92 @@ extern void mdm_init(void); /* defined in board.c */
  * returns: 0 -  no key string, allow autoboot 1 - got key string, abort
  */
 #if defined(CONFIG_BOOTDELAY) && (CONFIG_BOOTDELAY >= 0)
+#ifdef CONFIG_AUTOBOOT_FAST
+/*
+ * Fast autoboot: boot straight away, without the countdown, if the
+ * board says so; by default always, or while CONFIG_AUTOBOOT_FAST_GPIO
+ * is active.  The boot is only stopped by a key already waiting in the
+ * UART, CONFIG_AUTOBOOT_FAST_KEY if defined.
+ */
+int __board_autoboot_fast(void)
+{
+#ifdef CONFIG_AUTOBOOT_FAST_GPIO
+	int val;
+
+	if (gpio_request(CONFIG_AUTOBOOT_FAST_GPIO, "autoboot"))
+		return 0;
+	gpio_direction_input(CONFIG_AUTOBOOT_FAST_GPIO);
+	val = gpio_get_value(CONFIG_AUTOBOOT_FAST_GPIO);
+	gpio_free(CONFIG_AUTOBOOT_FAST_GPIO);
+#ifdef CONFIG_AUTOBOOT_FAST_GPIO_ACTIVE_LOW
+	val = !val;
+#endif
+	return val;
+#else
+	return 1;
+#endif
+}
+int board_autoboot_fast(void)
+	__attribute__((weak, alias("__board_autoboot_fast")));
+
+static int autoboot_fast_abort(void)
+{
+	int abort = 0;
+
+	/* a single look at the receive FIFO */
+	if (tstc()) {
+#ifdef CONFIG_AUTOBOOT_FAST_KEY
+		abort = (getc() == CONFIG_AUTOBOOT_FAST_KEY);
+#else
+		(void) getc();
+		abort = 1;
+#endif
+	}
+
+#ifdef CONFIG_SILENT_CONSOLE
+	if (abort)
+		gd->flags &= ~GD_FLG_SILENT;
+#endif
+	if (abort)
+		console_quiet_flush();
+
+	return abort;
+}
+#endif /* CONFIG_AUTOBOOT_FAST */
+
+#ifdef CONFIG_AUTOBOOT_PRELOAD
+#ifndef CONFIG_CMD_PXE
+static inline int run_command2(const char *cmd, int flag);
+#endif
+
+/*
+ * Run "bootpreload" before the countdown, so that the kernel is loaded
+ * while we would otherwise only wait for a key; the time it takes is
+ * taken off the boot delay.  Control-C checking is off meanwhile, so
+ * that a key pressed during the load is left for abortboot() to see.
+ * "bootpreloaded" is set to 1 when the commands succeeded.
+ *
+ * returns: the time spent in ms
+ */
+static ulong autoboot_preload(void)
+{
+	char *s = getenv("bootpreload");
+	ulong start;
+	int prev, rc;
+
+	if (s == NULL)
+		return 0;
+
+	start = get_timer(0);
+	prev = disable_ctrlc(1);
+	rc = run_command2(s, 0);
+	disable_ctrlc(prev);
+	setenv("bootpreloaded", rc ? NULL : "1");
+
+	return get_timer(start);
+}
+#endif /* CONFIG_AUTOBOOT_PRELOAD */
+
 # if defined(CONFIG_AUTOBOOT_KEYED)
 #ifndef CONFIG_MENU
 static inline
@@ -112,6 +203,16 @@ int abortboot(int bootdelay)
 	u_int presskey_max = 0;
 	u_int i;
 
+#ifdef CONFIG_AUTOBOOT_FAST
+	if (board_autoboot_fast())
+		return autoboot_fast_abort();
+#endif
+
+#ifdef CONFIG_AUTOBOOT_PRELOAD
+	/* counts against etime; the loop below looks at least once */
+	autoboot_preload();
+#endif
+
 #  ifdef CONFIG_AUTOBOOT_PROMPT
 	printf(CONFIG_AUTOBOOT_PROMPT);
 #  endif
@@ -195,6 +296,8 @@ int abortboot(int bootdelay)
 	if (abort)
 		gd->flags &= ~GD_FLG_SILENT;
 #endif
+	if (abort)
+		console_quiet_flush();
 
 	return abort;
 }
@@ -211,6 +314,24 @@ static inline
 int abortboot(int bootdelay)
 {
 	int abort = 0;
+	int first = 0;
+
+#ifdef CONFIG_AUTOBOOT_FAST
+	if (board_autoboot_fast())
+		return autoboot_fast_abort();
+#endif
+
+#ifdef CONFIG_AUTOBOOT_PRELOAD
+	if (bootdelay > 0) {
+		/* in 10ms steps, leaving one to look for a key */
+		ulong skip = autoboot_preload() / 10;
+
+		if (skip > bootdelay * 100 - 1)
+			skip = bootdelay * 100 - 1;
+		bootdelay -= skip / 100;
+		first = skip % 100;
+	}
+#endif
 
 #ifdef CONFIG_MENUPROMPT
 	printf(CONFIG_MENUPROMPT);
@@ -237,7 +358,7 @@ int abortboot(int bootdelay)
 
 		--bootdelay;
 		/* delay 100 * 10ms */
-		for (i=0; !abort && i<100; ++i) {
+		for (i=first; !abort && i<100; ++i) {
 			if (tstc()) {	/* we got a key press	*/
 				abort  = 1;	/* don't auto boot	*/
 				bootdelay = 0;	/* no more delay	*/
@@ -250,6 +371,7 @@ int abortboot(int bootdelay)
 			}
 			udelay(10000);
 		}
+		first = 0;
 
 		printf("\b\b\b%2d ", bootdelay);
 	}
@@ -260,6 +382,8 @@ int abortboot(int bootdelay)
 	if (abort)
 		gd->flags &= ~GD_FLG_SILENT;
 #endif
+	if (abort)
+		console_quiet_flush();
 
 	return abort;
 }
@@ -313,6 +437,9 @@ void main_loop (void)
 	char bcs_set[16];
 #endif /* CONFIG_BOOTCOUNT_LIMIT */
 
+	/* the boot is over, the rest is waiting for input */
+	prof_boot_done();
+
 #ifdef CONFIG_BOOTCOUNT_LIMIT
 	bootcount = bootcount_load();
 	bootcount++;
@@ -415,6 +542,9 @@ void main_loop (void)
 #endif /* CONFIG_MENUKEY */
 #endif /* CONFIG_BOOTDELAY */
 
+	/* no boot: let the user see what happened */
+	console_quiet_flush();
+
 	/*
 	 * Main Loop for Monitor Command Processing
 	 */
@@ -1375,6 +1505,8 @@ int run_command (const char *cmd, int flag)
 		}
 #endif
 
+		load_hash_command(cmdtp);
+
 		/* OK - call function to do the command */
 		if ((cmdtp->cmd) (cmdtp, flag, argc, argv) != 0) {
 			rc = -1;
@@ -0,0 +1,80 @@
+/*
+ * Pools of equally sized objects
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mem_pool.h>
+
+static int mem_pool_fill(struct mem_pool *pool)
+{
+	char *p;
+	ulong i;
+
+	pool->base = memalign(pool->align, pool->size * pool->count);
+	if (!pool->base)
+		return -1;
+
+	/* Thread the objects onto the free list, lowest address first */
+	p = pool->base + pool->size * pool->count;
+	for (i = 0; i < pool->count; i++) {
+		p -= pool->size;
+		*(void **)p = pool->free_list;
+		pool->free_list = p;
+	}
+	return 0;
+}
+
+static int mem_pool_owns(struct mem_pool *pool, void *obj)
+{
+	char *p = obj;
+
+	return pool->base && p >= pool->base &&
+		p < pool->base + pool->size * pool->count;
+}
+
+void *mem_pool_alloc(struct mem_pool *pool)
+{
+	void *obj;
+
+	if (!pool->base && pool->count && mem_pool_fill(pool))
+		pool->count = 0;	/* no room; use malloc from now on */
+
+	obj = pool->free_list;
+	if (!obj) {
+		pool->misses++;
+		return memalign(pool->align, pool->size);
+	}
+
+	pool->free_list = *(void **)obj;
+	if (++pool->used > pool->max_used)
+		pool->max_used = pool->used;
+	return obj;
+}
+
+void mem_pool_free(struct mem_pool *pool, void *obj)
+{
+	if (!obj)
+		return;
+
+	if (!mem_pool_owns(pool, obj)) {
+		free(obj);
+		return;
+	}
+
+	*(void **)obj = pool->free_list;
+	pool->free_list = obj;
+	pool->used--;
+}
+
+void mem_pool_stats(const char *name, struct mem_pool *pool)
+{
+	printf("%-12s %5lu x %5lu bytes, %5lu in use, %5lu max, %lu misses\n",
+	       name, pool->count, pool->size, pool->used, pool->max_used,
+	       pool->misses);
+}
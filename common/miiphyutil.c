@@ -188,6 +188,20 @@ int mdio_register(struct mii_dev *bus)
 	return 0;
 }
 
+/*
+ * The bus registered after bus, the first one for NULL; NULL after the
+ * last one.
+ */
+struct mii_dev *mdio_next_dev(struct mii_dev *bus)
+{
+	struct list_head *entry = bus ? bus->link.next : mii_devs.next;
+
+	if (entry == &mii_devs)
+		return NULL;
+
+	return list_entry(entry, struct mii_dev, link);
+}
+
 void mdio_list_devices(void)
 {
 	struct list_head *entry;
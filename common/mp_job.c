@@ -0,0 +1,169 @@
+/*
+ * Run work items on the secondary cores
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * U-Boot itself only runs on the boot core.  The first time a job is
+ * started, the other cores are released into mp_job_loop(), where each
+ * spins on a mailbox of its own.  The boot core hands a job to a core
+ * by writing it to the mailbox; the core clears it again once it has
+ * set the job to MP_JOB_DONE.  There is no queue: a job either gets an
+ * idle core right away, or the caller runs it itself.
+ *
+ * The cores have to be cache coherent; the barriers only order the
+ * stores of the job against those of its state.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <mp_job.h>
+
+#ifndef CONFIG_SYS_MP_JOB_CPUS
+#ifdef CONFIG_MAX_CPUS
+#define CONFIG_SYS_MP_JOB_CPUS		CONFIG_MAX_CPUS
+#else
+#error CONFIG_MP_JOBS needs CONFIG_SYS_MP_JOB_CPUS
+#endif
+#endif
+
+#ifndef CONFIG_SYS_MP_JOB_STACK_SIZE
+#define CONFIG_SYS_MP_JOB_STACK_SIZE	(16 << 10)
+#endif
+
+/* How long a released core may take to reach mp_job_loop(), in ms */
+#define MP_JOB_START_TIMEOUT		10
+
+struct mp_job_cpu {
+	struct mp_job * volatile job;	/* mailbox, NULL when idle	*/
+	volatile int	running;	/* the core is polling		*/
+};
+
+static struct mp_job_cpu mp_job_cpu[CONFIG_SYS_MP_JOB_CPUS];
+static int mp_job_released;
+
+int __cpu_job_release(int nr, void (*entry)(void *), void *arg, ulong sp)
+{
+	return -1;
+}
+int cpu_job_release(int nr, void (*entry)(void *), void *arg, ulong sp)
+	__attribute__((weak, alias("__cpu_job_release")));
+
+/* Runs on the secondary cores, forever */
+static void mp_job_loop(void *arg)
+{
+	struct mp_job_cpu *cpu = arg;
+	struct mp_job *job;
+
+	cpu->running = 1;
+	for (;;) {
+		job = cpu->job;
+		if (!job)
+			continue;
+		__sync_synchronize();
+		job->func(job);
+		__sync_synchronize();
+		job->state = MP_JOB_DONE;
+		__sync_synchronize();
+		cpu->job = NULL;
+	}
+}
+
+static void mp_job_release(void)
+{
+	ulong start;
+	void *stack;
+	int nr;
+
+	mp_job_released = 1;
+
+	for (nr = 1; nr < CONFIG_SYS_MP_JOB_CPUS; nr++) {
+		stack = malloc(CONFIG_SYS_MP_JOB_STACK_SIZE);
+		if (!stack)
+			break;
+		__sync_synchronize();
+		if (cpu_job_release(nr, mp_job_loop, &mp_job_cpu[nr],
+				(ulong)stack + CONFIG_SYS_MP_JOB_STACK_SIZE)) {
+			free(stack);
+			continue;
+		}
+
+		start = get_timer(0);
+		while (!mp_job_cpu[nr].running &&
+		       get_timer(start) < MP_JOB_START_TIMEOUT)
+			;
+		if (!mp_job_cpu[nr].running)
+			/* the stack stays, the core may still get there */
+			printf("CPU %d did not start, no jobs for it\n", nr);
+	}
+}
+
+int mp_job_start(struct mp_job *job)
+{
+	struct mp_job_cpu *cpu;
+	int nr;
+
+	if (!mp_job_released)
+		mp_job_release();
+
+	for (nr = 1; nr < CONFIG_SYS_MP_JOB_CPUS; nr++) {
+		cpu = &mp_job_cpu[nr];
+		if (!cpu->running || cpu->job)
+			continue;
+		job->state = MP_JOB_BUSY;
+		__sync_synchronize();
+		cpu->job = job;
+		return 0;
+	}
+	return -1;
+}
+
+void mp_job_run(struct mp_job *job)
+{
+	if (mp_job_start(job) == 0)
+		return;
+	job->func(job);
+	job->state = MP_JOB_DONE;
+}
+
+long mp_job_wait(struct mp_job *job)
+{
+	while (job->state == MP_JOB_BUSY)
+		WATCHDOG_RESET();
+	__sync_synchronize();
+	return job->result;
+}
+
+void mp_job_memcpy(struct mp_job *job)
+{
+	memcpy((void *)job->arg[0], (void *)job->arg[1], job->arg[2]);
+	job->result = 0;
+}
+
+void mp_job_crc32(struct mp_job *job)
+{
+	job->result = crc32(0, (const uchar *)job->arg[0], job->arg[1]);
+}
+
+void mp_job_memtest(struct mp_job *job)
+{
+	volatile ulong *start = (volatile ulong *)job->arg[0];
+	ulong n = job->arg[1] / sizeof(ulong);
+	ulong i;
+	long errs = 0;
+
+	for (i = 0; i < n; i++)
+		start[i] = (ulong)&start[i];
+	for (i = 0; i < n; i++)
+		if (start[i] != (ulong)&start[i])
+			errs++;
+	for (i = 0; i < n; i++)
+		start[i] = ~(ulong)&start[i];
+	for (i = 0; i < n; i++)
+		if (start[i] != ~(ulong)&start[i])
+			errs++;
+	job->result = errs;
+}
@@ -0,0 +1,60 @@
+/*
+ * Deferred device probing
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <probe.h>
+
+static struct probe_defer *probe_list;
+
+void probe_defer(struct probe_defer *p)
+{
+	struct probe_defer **pp;
+
+	/* a driver re-initialized before its first use is queued once */
+	for (pp = &probe_list; *pp; pp = &(*pp)->next)
+		if (*pp == p)
+			break;
+	if (!*pp) {
+		p->next = NULL;
+		*pp = p;
+	}
+	p->pending = 1;
+	p->ret = 0;
+}
+
+int probe_finish(struct probe_defer *p)
+{
+	struct probe_defer **pp;
+	int i;
+
+	if (!p->pending)
+		return p->ret;
+
+	for (pp = &probe_list; *pp; pp = &(*pp)->next) {
+		if (*pp == p) {
+			*pp = p->next;
+			break;
+		}
+	}
+	/* cleared first: finish() may call the driver back */
+	p->pending = 0;
+
+	/* in the column layout of the board_init_r messages */
+	printf("%s:", p->name);
+	for (i = strlen(p->name) + 1; i < 7; i++)
+		putc(' ');
+	p->ret = p->finish();
+	return p->ret;
+}
+
+void probe_finish_all(void)
+{
+	while (probe_list)
+		probe_finish(probe_list);
+}
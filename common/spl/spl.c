@@ -0,0 +1,257 @@
+/*
+ * (C) Copyright 2010
+ * Texas Instruments, <www.ti.com>
+ *
+ * Aneesh V <aneesh@ti.com>
+ *
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+#include <common.h>
+#include <spl.h>
+#include <image.h>
+#include <malloc.h>
+#ifdef CONFIG_SPL_LZO_SUPPORT
+#include <linux/lzo.h>
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Size assumed for a u-boot.bin without mkimage header */
+#ifndef CONFIG_SYS_MONITOR_LEN
+#define CONFIG_SYS_MONITOR_LEN	(200 * 1024)
+#endif
+
+/* Room a compressed image may unpack to */
+#ifndef CONFIG_SYS_SPL_LZO_MAX_LEN
+#define CONFIG_SYS_SPL_LZO_MAX_LEN	(8 << 20)
+#endif
+
+struct spl_image_info spl_image;
+
+void hang(void)
+{
+	puts("### ERROR ### Please RESET the board ###\n");
+	for (;;)
+		;
+}
+
+/*
+ * An SD/MMC card holds the image in its FAT file system if the FAT
+ * loader is built in.  SoCs whose boot ROM knows better override this.
+ */
+u32 __spl_mmc_boot_mode(void)
+{
+#ifdef CONFIG_SPL_FAT_SUPPORT
+	return SPL_MMC_MODE_FAT;
+#else
+	return SPL_MMC_MODE_RAW;
+#endif
+}
+u32 spl_mmc_boot_mode(void)
+	__attribute__((weak, alias("__spl_mmc_boot_mode")));
+
+/* Bus setup needed before nand_init(), if any */
+void __spl_nand_setup(void)
+{
+}
+void spl_nand_setup(void)
+	__attribute__((weak, alias("__spl_nand_setup")));
+
+/* Argument U-Boot is started with */
+void *__spl_uboot_args(void)
+{
+	return NULL;
+}
+void *spl_uboot_args(void)
+	__attribute__((weak, alias("__spl_uboot_args")));
+
+void spl_parse_image_header(const struct image_header *header)
+{
+	u32 header_size = sizeof(struct image_header);
+
+	if (__be32_to_cpu(header->ih_magic) == IH_MAGIC) {
+		spl_image.size = __be32_to_cpu(header->ih_size) + header_size;
+		spl_image.entry_point = __be32_to_cpu(header->ih_load);
+		/* Load including the header */
+		spl_image.load_addr = spl_image.entry_point - header_size;
+		spl_image.os = header->ih_os;
+		/* u-boot.img is made with an entry point of 0 */
+		if (spl_image.os == IH_OS_LINUX)
+			spl_image.entry_point = __be32_to_cpu(header->ih_ep);
+		spl_image.name = (const char *)&header->ih_name;
+		spl_image.comp = header->ih_comp;
+#ifdef CONFIG_SPL_LZO_SUPPORT
+		/*
+		 * Compressed, the image is read to a buffer of its own
+		 * and unpacked to where it runs by spl_uncompress_image().
+		 */
+		if (spl_image.comp == IH_COMP_LZO) {
+			spl_image.comp_dest = __be32_to_cpu(header->ih_load);
+			spl_image.load_addr = CONFIG_SYS_SPL_LZO_LOAD_ADDR;
+		}
+#endif
+		debug("spl: payload image: %s load addr: 0x%x size: %d\n",
+			spl_image.name, spl_image.load_addr, spl_image.size);
+	} else {
+		/* Signature not found - assume u-boot.bin */
+		printf("mkimage signature not found - ih_magic = %x\n",
+			header->ih_magic);
+		puts("Assuming u-boot.bin ..\n");
+		spl_image.size = CONFIG_SYS_MONITOR_LEN;
+		spl_image.entry_point = CONFIG_SYS_TEXT_BASE;
+		spl_image.load_addr = CONFIG_SYS_TEXT_BASE;
+		spl_image.os = IH_OS_U_BOOT;
+		spl_image.name = "U-Boot";
+		spl_image.comp = IH_COMP_NONE;
+	}
+}
+
+#ifdef CONFIG_SPL_LZO_SUPPORT
+/*
+ * Unpack an image made with mkimage -C lzo, e.g. u-boot-lzo.img: the
+ * loaders have fetched less from the boot medium, the rest of the
+ * work is done at RAM speed.
+ */
+static void spl_uncompress_image(void)
+{
+	const u8 *src = (const u8 *)spl_image.load_addr +
+		sizeof(struct image_header);
+	size_t len = CONFIG_SYS_SPL_LZO_MAX_LEN;
+
+	if (spl_image.comp == IH_COMP_NONE)
+		return;
+
+	if (spl_image.comp != IH_COMP_LZO ||
+	    lzop_decompress(src, spl_image.size - sizeof(struct image_header),
+			    (u8 *)spl_image.comp_dest, &len) != LZO_E_OK) {
+		puts("SPL: can't uncompress the image\n");
+		hang();
+	}
+	debug("spl: unpacked %zu bytes to 0x%x\n", len, spl_image.comp_dest);
+}
+#else
+static inline void spl_uncompress_image(void)
+{
+	if (spl_image.comp != IH_COMP_NONE) {
+		puts("SPL: compressed images are not supported\n");
+		hang();
+	}
+}
+#endif
+
+static void jump_to_image_no_args(void) __attribute__ ((noreturn));
+static void jump_to_image_no_args(void)
+{
+	typedef void (*image_entry_noargs_t)(void *)__attribute__ ((noreturn));
+	image_entry_noargs_t image_entry =
+			(image_entry_noargs_t) spl_image.entry_point;
+
+	debug("image entry point: 0x%X\n", spl_image.entry_point);
+#if defined(CONFIG_VIRTIO) || defined(CONFIG_ZEBU)
+	image_entry = (image_entry_noargs_t)0x80100000;
+#endif
+	image_entry(spl_uboot_args());
+}
+
+#ifdef CONFIG_SPL_OS_BOOT
+/*
+ * Return 1 to start U-Boot rather than the kernel.  The default does so
+ * when a 'c' is waiting on the console; boards can look at a GPIO or a
+ * flag of their own instead.
+ */
+int __spl_start_uboot(void)
+{
+#ifdef CONFIG_SPL_SERIAL_SUPPORT
+	if (serial_tstc() && serial_getc() == 'c')
+		return 1;
+#endif
+	return 0;
+}
+int spl_start_uboot(void)
+	__attribute__((weak, alias("__spl_start_uboot")));
+
+static void jump_to_image_linux(void *arg)
+{
+	typedef void (*image_entry_arg_t)(int, int, void *)
+		__attribute__ ((noreturn));
+	image_entry_arg_t image_entry =
+		(image_entry_arg_t) spl_image.entry_point;
+
+	debug("Entering kernel arg pointer: 0x%p\n", arg);
+	image_entry(0, CONFIG_MACH_TYPE, arg);
+}
+#endif /* CONFIG_SPL_OS_BOOT */
+
+void board_init_r(gd_t *id, ulong dummy)
+{
+	u32 boot_device;
+	debug(">>spl:board_init_r()\n");
+
+	mem_malloc_init(CONFIG_SYS_SPL_MALLOC_START,
+			CONFIG_SYS_SPL_MALLOC_SIZE);
+
+	timer_init();
+
+#ifdef CONFIG_SPL_BOARD_INIT
+	spl_board_init();
+#endif
+
+	boot_device = spl_boot_device();
+	debug("boot device - %d\n", boot_device);
+	switch (boot_device) {
+#ifdef CONFIG_SPL_MMC_SUPPORT
+	case SPL_BOOT_DEVICE_MMC1:
+	case SPL_BOOT_DEVICE_MMC2:
+		spl_mmc_load_image();
+		break;
+#endif
+#ifdef CONFIG_SPL_NAND_SUPPORT
+	case SPL_BOOT_DEVICE_NAND:
+		spl_nand_load_image();
+		break;
+#endif
+#ifdef CONFIG_SPL_SPI_LOAD
+	case SPL_BOOT_DEVICE_SPI:
+		spl_spi_load_image();
+		break;
+#endif
+	default:
+		printf("SPL: Un-supported Boot Device - %d!!!\n", boot_device);
+		hang();
+		break;
+	}
+
+	spl_uncompress_image();
+
+	switch (spl_image.os) {
+	case IH_OS_U_BOOT:
+		debug("Jumping to U-Boot\n");
+		jump_to_image_no_args();
+		break;
+#ifdef CONFIG_SPL_OS_BOOT
+	case IH_OS_LINUX:
+		debug("Jumping to Linux\n");
+		jump_to_image_linux((void *)CONFIG_SYS_SPL_ARGS_ADDR);
+		break;
+#endif
+	default:
+		puts("Unsupported OS image.. Jumping nevertheless..\n");
+		jump_to_image_no_args();
+	}
+}
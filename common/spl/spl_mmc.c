@@ -23,33 +23,14 @@
  * MA 02111-1307 USA
  */
 #include <common.h>
-#include <asm/u-boot.h>
-#include <asm/utils.h>
-#include <asm/arch/sys_proto.h>
+#include <spl.h>
 #include <mmc.h>
 #include <fat.h>
-#include <version.h>
-#include <asm/omap_common.h>
-#include <asm/arch/mmc_host_def.h>
+#include <image.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
-#ifdef CONFIG_GENERIC_MMC
-int board_mmc_init(bd_t *bis)
-{
-	switch (omap_boot_device()) {
-	case BOOT_DEVICE_MMC1:
-		omap_mmc_init(0);
-		break;
-	case BOOT_DEVICE_MMC2:
-		omap_mmc_init(1);
-		break;
-	}
-	return 0;
-}
-#endif
-
-static void mmc_load_image_raw(struct mmc *mmc)
+static int mmc_load_image_raw(struct mmc *mmc, unsigned long sector)
 {
 	u32 image_size_sectors, err;
 	const struct image_header *header;
@@ -58,9 +39,7 @@ static void mmc_load_image_raw(struct mmc *mmc)
 						sizeof(struct image_header));
 
 	/* read image header to find the image size & load address */
-	err = mmc->block_dev.block_read(0,
-			CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR, 1,
-			(void *)header);
+	err = mmc->block_dev.block_read(0, sector, 1, (void *)header);
 
 	if (err <= 0)
 		goto end;
@@ -68,22 +47,20 @@ static void mmc_load_image_raw(struct mmc *mmc)
 	spl_parse_image_header(header);
 
 	/* convert size to sectors - round up */
-	image_size_sectors = (spl_image.size + MMCSD_SECTOR_SIZE - 1) /
-				MMCSD_SECTOR_SIZE;
+	image_size_sectors = (spl_image.size + mmc->read_bl_len - 1) /
+				mmc->read_bl_len;
 
 	/* Read the header too to avoid extra memcpy */
-	err = mmc->block_dev.block_read(0,
-			CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR,
-			image_size_sectors, (void *)spl_image.load_addr);
+	err = mmc->block_dev.block_read(0, sector, image_size_sectors,
+					(void *)spl_image.load_addr);
 
 end:
-	if (err <= 0) {
+	if (err <= 0)
 		printf("spl: mmc blk read err - %d\n", err);
-		hang();
-	}
+	return err;
 }
 
-static void mmc_load_image_fat(struct mmc *mmc)
+static int mmc_load_image_fat(struct mmc *mmc, const char *filename)
 {
 	s32 err;
 	struct image_header *header;
@@ -91,31 +68,53 @@ static void mmc_load_image_fat(struct mmc *mmc)
 	header = (struct image_header *)(CONFIG_SYS_TEXT_BASE -
 						sizeof(struct image_header));
 
-	err = fat_register_device(&mmc->block_dev,
-				CONFIG_SYS_MMC_SD_FAT_BOOT_PARTITION);
-	if (err) {
-		printf("spl: fat register err - %d\n", err);
-		hang();
-	}
-
-	err = file_fat_read(CONFIG_SPL_FAT_LOAD_PAYLOAD_NAME,
-				(u8 *)header, sizeof(struct image_header));
+	err = file_fat_read(filename, (u8 *)header,
+				sizeof(struct image_header));
 	if (err <= 0)
 		goto end;
 
 	spl_parse_image_header(header);
 
-	err = file_fat_read(CONFIG_SPL_FAT_LOAD_PAYLOAD_NAME,
-				(u8 *)spl_image.load_addr, 0);
+	err = file_fat_read(filename, (u8 *)spl_image.load_addr, 0);
 
 end:
-	if (err <= 0) {
+	if (err <= 0)
 		printf("spl: error reading image %s, err - %d\n",
-			CONFIG_SPL_FAT_LOAD_PAYLOAD_NAME, err);
-		hang();
-	}
+			filename, err);
+	return err;
 }
 
+#ifdef CONFIG_SPL_OS_BOOT
+/*
+ * Load the parameters made by "spl export" and the kernel.  Returns 0
+ * when U-Boot is to be loaded instead.
+ */
+static int mmc_load_image_raw_os(struct mmc *mmc)
+{
+	if (mmc->block_dev.block_read(0,
+			CONFIG_SYS_MMCSD_RAW_MODE_ARGS_SECTOR,
+			CONFIG_SYS_MMCSD_RAW_MODE_ARGS_SECTORS,
+			(void *)CONFIG_SYS_SPL_ARGS_ADDR) <= 0)
+		return 0;
+
+	if (mmc_load_image_raw(mmc,
+			CONFIG_SYS_MMCSD_RAW_MODE_KERNEL_SECTOR) <= 0)
+		return 0;
+	return spl_image.os == IH_OS_LINUX;
+}
+
+static int mmc_load_image_fat_os(struct mmc *mmc)
+{
+	if (file_fat_read(CONFIG_SPL_FAT_LOAD_ARGS_NAME,
+			(u8 *)CONFIG_SYS_SPL_ARGS_ADDR, 0) <= 0)
+		return 0;
+
+	if (mmc_load_image_fat(mmc, CONFIG_SPL_FAT_LOAD_KERNEL_NAME) <= 0)
+		return 0;
+	return spl_image.os == IH_OS_LINUX;
+}
+#endif
+
 void spl_mmc_load_image(void)
 {
 	struct mmc *mmc;
@@ -135,15 +134,33 @@ void spl_mmc_load_image(void)
 		printf("spl: mmc init failed: err - %d\n", err);
 		hang();
 	}
-	boot_mode = omap_boot_mode();
-	if (boot_mode == MMCSD_MODE_RAW) {
+	boot_mode = spl_mmc_boot_mode();
+	if (boot_mode == SPL_MMC_MODE_RAW) {
 		debug("boot mode - RAW\n");
-		mmc_load_image_raw(mmc);
-	} else if (boot_mode == MMCSD_MODE_FAT) {
+#ifdef CONFIG_SPL_OS_BOOT
+		if (!spl_start_uboot() && mmc_load_image_raw_os(mmc))
+			return;
+#endif
+		err = mmc_load_image_raw(mmc,
+			CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_SECTOR);
+	} else if (boot_mode == SPL_MMC_MODE_FAT) {
 		debug("boot mode - FAT\n");
-		mmc_load_image_fat(mmc);
+		err = fat_register_device(&mmc->block_dev,
+				CONFIG_SYS_MMC_SD_FAT_BOOT_PARTITION);
+		if (err) {
+			printf("spl: fat register err - %d\n", err);
+			hang();
+		}
+#ifdef CONFIG_SPL_OS_BOOT
+		if (!spl_start_uboot() && mmc_load_image_fat_os(mmc))
+			return;
+#endif
+		err = mmc_load_image_fat(mmc, CONFIG_SPL_FAT_LOAD_PAYLOAD_NAME);
 	} else {
 		puts("spl: wrong MMC boot mode\n");
 		hang();
 	}
+
+	if (err <= 0)
+		hang();
 }
@@ -0,0 +1,51 @@
+/*
+ * Load U-Boot from SPI flash in the SPL
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <spl.h>
+#include <spi.h>
+#include <spi_flash.h>
+#include <image.h>
+
+#ifndef CONFIG_SF_DEFAULT_SPEED
+# define CONFIG_SF_DEFAULT_SPEED	1000000
+#endif
+#ifndef CONFIG_SF_DEFAULT_MODE
+# define CONFIG_SF_DEFAULT_MODE		SPI_MODE_3
+#endif
+
+void spl_spi_load_image(void)
+{
+	struct spi_flash *flash;
+	struct image_header *header;
+
+	flash = spi_flash_probe(CONFIG_SPL_SPI_BUS, CONFIG_SPL_SPI_CS,
+				CONFIG_SF_DEFAULT_SPEED,
+				CONFIG_SF_DEFAULT_MODE);
+	if (!flash) {
+		puts("spl: spi probe failed\n");
+		hang();
+	}
+
+	/*use CONFIG_SYS_TEXT_BASE as temporary storage area */
+	header = (struct image_header *)(CONFIG_SYS_TEXT_BASE);
+
+	/* Load the header, then the whole image including it */
+	if (spi_flash_read(flash, CONFIG_SYS_SPI_U_BOOT_OFFS,
+			   sizeof(*header), (void *)header)) {
+		puts("spl: spi read failed\n");
+		hang();
+	}
+	spl_parse_image_header(header);
+	if (spi_flash_read(flash, CONFIG_SYS_SPI_U_BOOT_OFFS,
+			   spl_image.size, (void *)spl_image.load_addr)) {
+		puts("spl: spi read failed\n");
+		hang();
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * Measured boot: extend TPM PCRs with the digests of the booted images
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * The measurements are queued while the images are loaded and checked,
+ * and only sent to the TPM right before the OS is started: one session
+ * for all extends instead of opening the slow LPC link for each, and
+ * no TPM round trip between the loading and the checking of images.
+ * Digests FIT verification has already calculated are used as they
+ * are, the data is only hashed here when there was no SHA-1 to reuse.
+ */
+
+#include <common.h>
+#include <image.h>
+#include <sha1.h>
+#include <tpm.h>
+#include <asm/unaligned.h>
+
+#ifndef CONFIG_TPM_MEASURE_MAX
+#define CONFIG_TPM_MEASURE_MAX	16
+#endif
+
+#define TPM_TAG_RQU_COMMAND	0x00c1
+#define TPM_ORD_EXTEND		0x00000014
+#define TPM_EXTEND_CMD_SIZE	(10 + 4 + TPM_DIGEST_SIZE)
+#define TPM_EXTEND_RSP_SIZE	(10 + TPM_DIGEST_SIZE)
+
+struct tpm_measurement {
+	u32	pcr;
+	u8	digest[TPM_DIGEST_SIZE];
+};
+
+static struct tpm_measurement tpm_queue[CONFIG_TPM_MEASURE_MAX];
+static int tpm_queued;
+static int tpm_ready;
+
+/* TPM_Extend of one PCR, in a session tis_open() started */
+static int tpm_extend(u32 pcr, const u8 *digest)
+{
+	u8 buf[TPM_EXTEND_CMD_SIZE];
+	size_t len = sizeof(buf);
+
+	put_unaligned_be16(TPM_TAG_RQU_COMMAND, buf);
+	put_unaligned_be32(TPM_EXTEND_CMD_SIZE, buf + 2);
+	put_unaligned_be32(TPM_ORD_EXTEND, buf + 6);
+	put_unaligned_be32(pcr, buf + 10);
+	memcpy(buf + 14, digest, TPM_DIGEST_SIZE);
+
+	if (tis_sendrecv(buf, TPM_EXTEND_CMD_SIZE, buf, &len))
+		return -1;
+
+	/* tag, size, return code, new PCR value */
+	if (len < TPM_EXTEND_RSP_SIZE || get_unaligned_be32(buf + 6)) {
+		printf("TPM: extend of PCR %u failed (%#x)\n", pcr,
+		       len < 10 ? 0 : get_unaligned_be32(buf + 6));
+		return -1;
+	}
+
+	return 0;
+}
+
+int tpm_measure_flush(void)
+{
+	int i, ret = 0;
+
+	if (!tpm_queued)
+		return 0;
+
+	if (!tpm_ready) {
+		if (tis_init()) {
+			puts("TPM: not found, measurements dropped\n");
+			tpm_queued = 0;
+			return -1;
+		}
+		tpm_ready = 1;
+	}
+
+	if (tis_open()) {
+		tpm_queued = 0;
+		return -1;
+	}
+
+	for (i = 0; i < tpm_queued && !ret; i++)
+		ret = tpm_extend(tpm_queue[i].pcr, tpm_queue[i].digest);
+	tis_close();
+
+	debug("TPM: %d of %d measurements extended\n", ret ? i - 1 : i,
+	      tpm_queued);
+	tpm_queued = 0;
+
+	return ret;
+}
+
+int tpm_measure_digest(u32 pcr, const u8 *digest)
+{
+	if (tpm_queued == CONFIG_TPM_MEASURE_MAX && tpm_measure_flush())
+		return -1;
+
+	tpm_queue[tpm_queued].pcr = pcr;
+	memcpy(tpm_queue[tpm_queued].digest, digest, TPM_DIGEST_SIZE);
+	tpm_queued++;
+
+	return 0;
+}
+
+int tpm_measure(u32 pcr, const void *data, ulong len)
+{
+	u8 digest[TPM_DIGEST_SIZE];
+
+	sha1_csum_wd((unsigned char *)data, len, digest, CHUNKSZ_SHA1);
+
+	return tpm_measure_digest(pcr, digest);
+}
@@ -200,6 +200,14 @@ static int update_flash(ulong addr_source, ulong addr_first, ulong size)
 		return 1;
 	}
 
+#ifdef CONFIG_SYS_FLASH_ERASE_PIPELINE
+	printf("Erasing and copying 0x%08lx - 0x%08lx", addr_first, addr_last);
+	if (flash_erase_write((uchar *)addr_source, addr_first, size) > 0) {
+		printf("Error: could not update flash\n");
+		return 1;
+	}
+	printf(" done\n");
+#else
 	printf("Erasing 0x%08lx - 0x%08lx", addr_first, addr_last);
 	if (flash_sect_erase(addr_first, addr_last) > 0) {
 		printf("Error: could not erase flash\n");
@@ -212,6 +220,7 @@ static int update_flash(ulong addr_source, ulong addr_first, ulong size)
 		return 1;
 	}
 	printf("done\n");
+#endif
 
 	/* enable protection on processed sectors */
 	if (update_flash_protect(1, addr_first, addr_last) > 0) {
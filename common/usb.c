@@ -222,6 +222,18 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 
 }
 
+/*-------------------------------------------------------------------
+ * Host controller limits
+ */
+#define USB_DEFAULT_MAX_XFER	(20 * 512)
+
+static int __usb_max_xfer_len(struct usb_device *dev)
+{
+	return USB_DEFAULT_MAX_XFER;
+}
+int usb_max_xfer_len(struct usb_device *dev)
+	__attribute__((weak, alias("__usb_max_xfer_len")));
+
 /*-------------------------------------------------------------------
  * submits bulk message, and waits for completion. returns 0 if Ok or
  * -1 if Error.
@@ -246,6 +258,57 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 		return -1;
 }
 
+/*-------------------------------------------------------------------
+ * Queued bulk messages: usb_bulk_msg_queue() starts a transfer and
+ * returns 0, or 1 if the transfer has already completed; either way
+ * usb_bulk_msg_wait() collects the result.  Only one transfer can be
+ * queued at a time, and other transfers issued before the wait must not
+ * use its endpoint.  This lets a driver set up the next stage while the
+ * data of the previous one is still on the bus.
+ *
+ * The default for host controllers that cannot queue transfers simply
+ * does the whole transfer at once.
+ */
+static struct {
+	int result;
+	int act_len;
+} usb_queued;
+
+static int __submit_bulk_queue(struct usb_device *dev, unsigned long pipe,
+			       void *buffer, int transfer_len)
+{
+	usb_queued.result = usb_bulk_msg(dev, pipe, buffer, transfer_len,
+					 &usb_queued.act_len,
+					 USB_CNTL_TIMEOUT * 5);
+	return 1;
+}
+int submit_bulk_queue(struct usb_device *dev, unsigned long pipe,
+		      void *buffer, int transfer_len)
+	__attribute__((weak, alias("__submit_bulk_queue")));
+
+static int __submit_bulk_wait(struct usb_device *dev, int *actual_length,
+			      int timeout)
+{
+	*actual_length = usb_queued.act_len;
+	return usb_queued.result;
+}
+int submit_bulk_wait(struct usb_device *dev, int *actual_length, int timeout)
+	__attribute__((weak, alias("__submit_bulk_wait")));
+
+int usb_bulk_msg_queue(struct usb_device *dev, unsigned int pipe,
+			void *data, int len)
+{
+	if (len < 0)
+		return -1;
+	return submit_bulk_queue(dev, pipe, data, len);
+}
+
+int usb_bulk_msg_wait(struct usb_device *dev, int *actual_length,
+			int timeout)
+{
+	return submit_bulk_wait(dev, actual_length, timeout);
+}
+
 
 /*-------------------------------------------------------------------
  * Max Packet stuff
@@ -1031,19 +1094,69 @@ int usb_get_port_status(struct usb_device *dev, int port, void *data)
 }
 
 
+/*
+ * Timing from the USB 2.0 spec, 7.1.7.3 and 7.1.7.5, as Linux has it:
+ * a new connection is stable after 100 ms, the hub ends a port reset on
+ * its own after 10 to 20 ms, and the device gets 10 ms to recover from
+ * it, plus some slop.
+ */
+#define HUB_DEBOUNCE_STEP	25
+#define HUB_DEBOUNCE_STABLE	100
+#define HUB_DEBOUNCE_TIMEOUT	1500
+#define HUB_RESET_STEP		10
+#define HUB_RESET_TIMEOUT	500
+#define HUB_RESET_RECOVERY	50
+
 static void usb_hub_power_on(struct usb_hub_device *hub)
 {
 	int i;
 	struct usb_device *dev;
 
 	dev = hub->pusb_dev;
-	/* Enable power to the ports */
+	/* Enable power to the ports, and wait for all of them together */
 	USB_HUB_PRINTF("enabling power on all ports\n");
 	for (i = 0; i < dev->maxchild; i++) {
 		usb_set_port_feature(dev, i + 1, USB_PORT_FEAT_POWER);
 		USB_HUB_PRINTF("port %d returns %lX\n", i + 1, dev->status);
-		wait_ms(hub->desc.bPwrOn2PwrGood * 2);
 	}
+	wait_ms(max(hub->desc.bPwrOn2PwrGood * 2, 100));
+}
+
+/*
+ * Waits until the connection state of the ports in mask has not changed
+ * for HUB_DEBOUNCE_STABLE ms, so that all the ports of a hub are
+ * debounced together rather than one after the other.
+ */
+static void hub_ports_debounce(struct usb_device *dev, u32 mask)
+{
+	struct usb_port_status portsts;
+	u32 conn, last = 0;
+	int i, total, stable = 0;
+
+	for (total = 0; total < HUB_DEBOUNCE_TIMEOUT;
+	     total += HUB_DEBOUNCE_STEP) {
+		conn = 0;
+		for (i = 0; i < dev->maxchild && i < 32; i++) {
+			if (!(mask & (1 << i)))
+				continue;
+			if (usb_get_port_status(dev, i + 1, &portsts) < 0)
+				continue;
+			if (le16_to_cpu(portsts.wPortStatus) &
+			    USB_PORT_STAT_CONNECTION)
+				conn |= 1 << i;
+		}
+
+		if (total && conn == last)
+			stable += HUB_DEBOUNCE_STEP;
+		else
+			stable = 0;
+		last = conn;
+
+		if (stable >= HUB_DEBOUNCE_STABLE)
+			return;
+		wait_ms(HUB_DEBOUNCE_STEP);
+	}
+	USB_HUB_PRINTF("ports %x still bouncing\n", mask);
 }
 
 void usb_hub_reset(void)
@@ -1075,7 +1188,7 @@ static inline char *portspeed(int portstatus)
 static int hub_port_reset(struct usb_device *dev, int port,
 			unsigned short *portstat)
 {
-	int tries;
+	int tries, waited;
 	struct usb_port_status portsts;
 	unsigned short portstatus, portchange;
 
@@ -1083,15 +1196,23 @@ static int hub_port_reset(struct usb_device *dev, int port,
 	for (tries = 0; tries < MAX_TRIES; tries++) {
 
 		usb_set_port_feature(dev, port + 1, USB_PORT_FEAT_RESET);
-		wait_ms(200);
 
-		if (usb_get_port_status(dev, port + 1, &portsts) < 0) {
-			USB_HUB_PRINTF("get_port_status failed status %lX\n",
-					dev->status);
-			return -1;
+		/* the hub ends the reset itself: wait for that, not longer */
+		for (waited = 0; waited < HUB_RESET_TIMEOUT;
+		     waited += HUB_RESET_STEP) {
+			wait_ms(HUB_RESET_STEP);
+
+			if (usb_get_port_status(dev, port + 1, &portsts) < 0) {
+				USB_HUB_PRINTF("get_port_status failed "
+						"status %lX\n", dev->status);
+				return -1;
+			}
+			portstatus = le16_to_cpu(portsts.wPortStatus);
+			portchange = le16_to_cpu(portsts.wPortChange);
+
+			if (!(portstatus & USB_PORT_STAT_RESET))
+				break;
 		}
-		portstatus = le16_to_cpu(portsts.wPortStatus);
-		portchange = le16_to_cpu(portsts.wPortChange);
 
 		USB_HUB_PRINTF("portstatus %x, change %x, %s\n",
 				portstatus, portchange,
@@ -1126,7 +1247,7 @@ static int hub_port_reset(struct usb_device *dev, int port,
 }
 
 
-void usb_hub_port_connect_change(struct usb_device *dev, int port)
+static void hub_port_connect(struct usb_device *dev, int port, int debounce)
 {
 	struct usb_device *usb;
 	struct usb_port_status portsts;
@@ -1155,7 +1276,8 @@ void usb_hub_port_connect_change(struct usb_device *dev, int port)
 		if (!(portstatus & USB_PORT_STAT_CONNECTION))
 			return;
 	}
-	wait_ms(200);
+	if (debounce)
+		hub_ports_debounce(dev, 1 << port);
 
 	/* Reset the port */
 	if (hub_port_reset(dev, port, &portstatus) < 0) {
@@ -1163,7 +1285,7 @@ void usb_hub_port_connect_change(struct usb_device *dev, int port)
 		return;
 	}
 
-	wait_ms(200);
+	wait_ms(HUB_RESET_RECOVERY);
 
 	/* Allocate a new device struct for it */
 	usb = usb_alloc_new_device();
@@ -1186,6 +1308,11 @@ void usb_hub_port_connect_change(struct usb_device *dev, int port)
 	}
 }
 
+void usb_hub_port_connect_change(struct usb_device *dev, int port)
+{
+	hub_port_connect(dev, port, 1);
+}
+
 
 int usb_hub_configure(struct usb_device *dev)
 {
@@ -1193,6 +1320,7 @@ int usb_hub_configure(struct usb_device *dev)
 	unsigned char buffer[USB_BUFSIZ], *bitmap;
 	struct usb_hub_descriptor *descriptor;
 	struct usb_hub_device *hub;
+	u32 debounced;
 #ifdef USB_HUB_DEBUG
 	struct usb_hub_status *hubsts;
 #endif
@@ -1311,6 +1439,14 @@ int usb_hub_configure(struct usb_device *dev)
 		"" : "no ");
 	usb_hub_power_on(hub);
 
+	/*
+	 * Debounce the ports together; only the resets and the addressing
+	 * go one port after the other, as only one device may answer at
+	 * address 0 at a time.
+	 */
+	debounced = dev->maxchild < 32 ? (1 << dev->maxchild) - 1 : ~0;
+	hub_ports_debounce(dev, debounced);
+
 	for (i = 0; i < dev->maxchild; i++) {
 		struct usb_port_status portsts;
 		unsigned short portstatus, portchange;
@@ -1327,7 +1463,7 @@ int usb_hub_configure(struct usb_device *dev)
 
 		if (portchange & USB_PORT_STAT_C_CONNECTION) {
 			USB_HUB_PRINTF("port %d connection change\n", i + 1);
-			usb_hub_port_connect_change(dev, i);
+			hub_port_connect(dev, i, i >= 32);
 		}
 		if (portchange & USB_PORT_STAT_C_ENABLE) {
 			USB_HUB_PRINTF("port %d enable change, status %x\n",
@@ -72,6 +72,9 @@ int overwrite_console(void)
 /* Size of the keyboard buffer */
 #define USB_KBD_BUFFER_LEN	0x20
 
+/* Reports the host controller takes in until the keyboard is polled */
+#define USB_KBD_INTQ_LEN	4
+
 /* Device name */
 #define DEVNAME			"usbkbd"
 
@@ -110,6 +113,11 @@ struct usb_kbd_pdata {
 	uint8_t		old[8];
 
 	uint8_t		flags;
+
+#ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
+	struct int_queue *intq;
+	uint8_t		intq_buf[USB_KBD_INTQ_LEN][8];
+#endif
 };
 
 /* Generic keyboard event polling. */
@@ -315,6 +323,15 @@ static inline void usb_kbd_poll_for_event(struct usb_device *dev)
 #if	defined(CONFIG_SYS_USB_EVENT_POLL)
 	usb_event_poll();
 	usb_kbd_irq_worker(dev);
+#elif	defined(CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE)
+	struct usb_kbd_pdata *data = dev->privptr;
+	uint8_t *report;
+
+	/* only memory is looked at until a report has come in */
+	while ((report = poll_int_queue(dev, data->intq)) != NULL) {
+		memcpy(data->new, report, sizeof(data->new));
+		usb_kbd_irq(dev);
+	}
 #elif	defined(CONFIG_SYS_USB_EVENT_POLL_VIA_CONTROL_EP)
 	struct usb_interface *iface;
 	struct usb_kbd_pdata *data = dev->privptr;
@@ -425,8 +442,19 @@ static int usb_kbd_probe(struct usb_device *dev, unsigned int ifnum)
 	usb_set_idle(dev, iface->desc.bInterfaceNumber, REPEAT_RATE, 0);
 
 	USB_KBD_PRINTF("USB KBD: enable interrupt pipe...\n");
+#ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
+	data->intq = create_int_queue(dev, pipe, USB_KBD_INTQ_LEN,
+				      maxp > 8 ? 8 : maxp, data->intq_buf);
+	if (!data->intq) {
+		printf("USB KBD: Error setting up the interrupt queue\n");
+		dev->privptr = NULL;
+		free(data);
+		return 0;
+	}
+#else
 	usb_submit_int_msg(dev, pipe, data->new, maxp > 8 ? 8 : maxp,
 				ep->bInterval);
+#endif
 
 	/* Success. */
 	return 1;
@@ -54,6 +54,9 @@
 #include <asm/processor.h>
 
 #include <part.h>
+#include <blkcache.h>
+#include <time_acct.h>
+#include <blkstats.h>
 #include <usb.h>
 
 #undef BBB_COMDAT_TRACE
@@ -154,6 +157,7 @@ struct us_data {
 	ccb		*srb;			/* current srb */
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
+	unsigned int	max_xfer;		/* bytes per READ/WRITE command */
 };
 
 static struct us_data usb_stor[USB_MAX_STOR_DEV];
@@ -241,6 +245,7 @@ int usb_stor_scan(int mode)
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
 	for (i = 0; i < USB_MAX_STOR_DEV; i++) {
+		dev_invalidate(IF_TYPE_USB, i);
 		memset(&usb_dev_desc[i], 0, sizeof(block_dev_desc_t));
 		usb_dev_desc[i].if_type = IF_TYPE_USB;
 		usb_dev_desc[i].dev = i;
@@ -498,7 +503,7 @@ int usb_stor_BBB_comdat(ccb *srb, struct us_data *us)
 	int actlen;
 	int dir_in;
 	unsigned int pipe;
-	umass_bbb_cbw_t cbw;
+	static umass_bbb_cbw_t cbw;	/* may still be sent after return */
 
 	dir_in = US_DIRECTION(srb->cmd[0]);
 
@@ -530,8 +535,24 @@ int usb_stor_BBB_comdat(ccb *srb, struct us_data *us)
 	/* copy the command data into the CBW command data buffer */
 	/* DST SRC LEN!!! */
 	memcpy(cbw.CBWCDB, srb->cmd, srb->cmdlen);
-	result = usb_bulk_msg(us->pusb_dev, pipe, &cbw, UMASS_BBB_CBW_SIZE,
-			      &actlen, USB_CNTL_TIMEOUT * 5);
+	/*
+	 * When the data comes in, queue the CBW and let the data phase wait
+	 * on the other endpoint right away; usb_stor_BBB_transport() then
+	 * collects the result of the CBW.
+	 */
+	if (dir_in && srb->datalen) {
+		result = usb_bulk_msg_queue(us->pusb_dev, pipe, &cbw,
+					    UMASS_BBB_CBW_SIZE);
+		if (result == 0)
+			return 1;
+		if (result > 0)
+			result = usb_bulk_msg_wait(us->pusb_dev, &actlen,
+						   USB_CNTL_TIMEOUT * 5);
+	} else {
+		result = usb_bulk_msg(us->pusb_dev, pipe, &cbw,
+				      UMASS_BBB_CBW_SIZE, &actlen,
+				      USB_CNTL_TIMEOUT * 5);
+	}
 	if (result < 0)
 		USB_STOR_PRINTF("usb_stor_BBB_comdat:usb_bulk_msg error\n");
 	return result;
@@ -671,7 +692,7 @@ int usb_stor_BBB_clear_endpt_stall(struct us_data *us, __u8 endpt)
 int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 {
 	int result, retry;
-	int dir_in;
+	int dir_in, queued;
 	int actlen, data_actlen;
 	unsigned int pipe, pipein, pipeout;
 	umass_bbb_csw_t csw;
@@ -691,7 +712,9 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 		usb_stor_BBB_reset(us);
 		return USB_STOR_TRANSPORT_FAILED;
 	}
-	wait_ms(5);
+	queued = result > 0;
+	if (!queued)
+		wait_ms(5);
 	pipein = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
 	pipeout = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
 	/* DATA phase + error handling */
@@ -706,6 +729,12 @@ int usb_stor_BBB_transport(ccb *srb, struct us_data *us)
 		pipe = pipeout;
 	result = usb_bulk_msg(us->pusb_dev, pipe, srb->pdata, srb->datalen,
 			      &data_actlen, USB_CNTL_TIMEOUT * 5);
+	if (queued && usb_bulk_msg_wait(us->pusb_dev, &actlen,
+					USB_CNTL_TIMEOUT * 5) < 0) {
+		USB_STOR_PRINTF("failed to send CBW\n");
+		usb_stor_BBB_reset(us);
+		return USB_STOR_TRANSPORT_FAILED;
+	}
 	/* special handling of STALL in DATA phase */
 	if ((result < 0) && (us->pusb_dev->status & USB_ST_STALLED)) {
 		USB_STOR_PRINTF("DATA:stall\n");
@@ -986,6 +1015,9 @@ static int usb_read_capacity(ccb *srb, struct us_data *ss)
 static int usb_read_10(ccb *srb, struct us_data *ss, unsigned long start,
 		       unsigned short blocks)
 {
+	unsigned long long t;
+	int ret;
+
 	memset(&srb->cmd[0], 0, 12);
 	srb->cmd[0] = SCSI_READ10;
 	srb->cmd[1] = srb->lun << 5;
@@ -997,12 +1029,18 @@ static int usb_read_10(ccb *srb, struct us_data *ss, unsigned long start,
 	srb->cmd[8] = (unsigned char) blocks & 0xff;
 	srb->cmdlen = 12;
 	USB_STOR_PRINTF("read10: start %lx blocks %x\n", start, blocks);
-	return ss->transport(srb, ss);
+	t = time_acct_start();
+	ret = ss->transport(srb, ss);
+	time_acct_end(TIME_ACCT_BLOCK, t);
+	return ret;
 }
 
 static int usb_write_10(ccb *srb, struct us_data *ss, unsigned long start,
 			unsigned short blocks)
 {
+	unsigned long long t;
+	int ret;
+
 	memset(&srb->cmd[0], 0, 12);
 	srb->cmd[0] = SCSI_WRITE10;
 	srb->cmd[1] = srb->lun << 5;
@@ -1014,7 +1052,10 @@ static int usb_write_10(ccb *srb, struct us_data *ss, unsigned long start,
 	srb->cmd[8] = (unsigned char) blocks & 0xff;
 	srb->cmdlen = 12;
 	USB_STOR_PRINTF("write10: start %lx blocks %x\n", start, blocks);
-	return ss->transport(srb, ss);
+	t = time_acct_start();
+	ret = ss->transport(srb, ss);
+	time_acct_end(TIME_ACCT_BLOCK, t);
+	return ret;
 }
 
 
@@ -1041,21 +1082,84 @@ static void usb_bin_fixup(struct usb_device_descriptor descriptor,
 }
 #endif /* CONFIG_USB_BIN_FIXUP */
 
-#define USB_MAX_READ_BLK 20
+/*
+ * Bytes moved by one READ_10 / WRITE_10 command.  The host controller
+ * driver and the quirk table below may lower it for a device.
+ */
+#ifndef CONFIG_USB_STORAGE_MAX_XFER
+#define CONFIG_USB_STORAGE_MAX_XFER	(1024 * 1024)
+#endif
+
+/*
+ * The transfer size used before the limit became configurable.  A device
+ * which fails a larger transfer is switched to it.
+ */
+#define USB_SAFE_XFER_BLK	20
+
+struct usb_stor_quirk {
+	unsigned short	vendor;
+	unsigned short	product;
+	unsigned int	max_xfer;	/* bytes */
+};
+
+/* Devices known to fail large transfers */
+static const struct usb_stor_quirk usb_stor_quirks[] = {
+	/* Genesys Logic USB to IDE bridges */
+	{ 0x05e3, 0x0701, 64 * 512 },
+	{ 0x05e3, 0x0702, 64 * 512 },
+};
+
+static unsigned int usb_stor_max_xfer(struct usb_device *dev)
+{
+	unsigned int max = CONFIG_USB_STORAGE_MAX_XFER;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(usb_stor_quirks); i++) {
+		if (dev->descriptor.idVendor == usb_stor_quirks[i].vendor &&
+		    dev->descriptor.idProduct == usb_stor_quirks[i].product &&
+		    usb_stor_quirks[i].max_xfer < max)
+			max = usb_stor_quirks[i].max_xfer;
+	}
+
+	i = usb_max_xfer_len(dev);
+	if (i < max)
+		max = i;
+
+	USB_STOR_PRINTF("max transfer %u bytes\n", max);
+	return max;
+}
+
+/* Blocks per command, READ_10 and WRITE_10 have a 16 bit count */
+static unsigned short usb_stor_max_blks(struct us_data *ss,
+					unsigned long blksz)
+{
+	unsigned long blks = ss->max_xfer / blksz;
+
+	if (blks > 0xffff)
+		blks = 0xffff;
+	return blks ? blks : 1;
+}
 
 unsigned long usb_stor_read(int device, unsigned long blknr,
 			    unsigned long blkcnt, void *buffer)
 {
 	unsigned long start, blks, buf_addr;
-	unsigned short smallblks;
+	unsigned short smallblks, max_blks;
 	struct usb_device *dev;
-	int retry, i;
+	struct us_data *ss;
+	unsigned long long t;
+	int retry, i, err;
 	ccb *srb = &usb_ccb;
 
 	if (blkcnt == 0)
 		return 0;
 
 	device &= 0xff;
+	if (blkcache_read(IF_TYPE_USB, device, blknr, blkcnt,
+			  usb_dev_desc[device].blksz, buffer) ||
+	    blkcache_readahead(&usb_dev_desc[device], blknr, blkcnt, buffer))
+		return blkcnt;
+
 	/* Setup  device */
 	USB_STOR_PRINTF("\nusb_read: dev %d \n", device);
 	dev = NULL;
@@ -1066,13 +1170,15 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 		if (dev->devnum == usb_dev_desc[device].target)
 			break;
 	}
+	ss = (struct us_data *)dev->privptr;
+	max_blks = usb_stor_max_blks(ss, usb_dev_desc[device].blksz);
 
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 	srb->lun = usb_dev_desc[device].lun;
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, (struct us_data *)dev->privptr)) {
+	if (usb_test_unit_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 		       srb->sense_buf[13]);
@@ -1086,19 +1192,31 @@ unsigned long usb_stor_read(int device, unsigned long blknr,
 		/* XXX need some comment here */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_READ_BLK)
-			smallblks = USB_MAX_READ_BLK;
+		if (blks > max_blks)
+			smallblks = max_blks;
 		else
 			smallblks = (unsigned short) blks;
 retry_it:
-		if (smallblks == USB_MAX_READ_BLK)
+		if (smallblks == max_blks)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_read_10(srb, (struct us_data *)dev->privptr, start,
-		    smallblks)) {
+		t = blkstats_start();
+		err = usb_read_10(srb, ss, start, smallblks);
+		blkstats_end(IF_TYPE_USB, device, BLKSTATS_READ,
+			     err ? 0 : srb->datalen, t);
+		if (err) {
 			USB_STOR_PRINTF("Read ERROR\n");
-			usb_request_sense(srb, (struct us_data *)dev->privptr);
+			usb_request_sense(srb, ss);
+			if (smallblks > USB_SAFE_XFER_BLK) {
+				/* the device may not cope with large transfers */
+				printf("USB storage: falling back to %d block "
+				       "transfers\n", USB_SAFE_XFER_BLK);
+				ss->max_xfer = USB_SAFE_XFER_BLK *
+					       usb_dev_desc[device].blksz;
+				max_blks = smallblks = USB_SAFE_XFER_BLK;
+				goto retry_it;
+			}
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1113,26 +1231,30 @@ retry_it:
 			start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_READ_BLK)
+	if (blkcnt >= max_blks)
 		debug("\n");
+	blkcache_fill(IF_TYPE_USB, device, blknr, blkcnt,
+		      usb_dev_desc[device].blksz, buffer);
 	return blkcnt;
 }
 
-#define USB_MAX_WRITE_BLK 20
-
 unsigned long usb_stor_write(int device, unsigned long blknr,
 				unsigned long blkcnt, const void *buffer)
 {
 	unsigned long start, blks, buf_addr;
-	unsigned short smallblks;
+	unsigned short smallblks, max_blks;
 	struct usb_device *dev;
-	int retry, i;
+	struct us_data *ss;
+	unsigned long long t;
+	int retry, i, err;
 	ccb *srb = &usb_ccb;
 
 	if (blkcnt == 0)
 		return 0;
 
 	device &= 0xff;
+	dev_invalidate(IF_TYPE_USB, device);
+
 	/* Setup  device */
 	USB_STOR_PRINTF("\nusb_write: dev %d \n", device);
 	dev = NULL;
@@ -1143,6 +1265,8 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		if (dev->devnum == usb_dev_desc[device].target)
 			break;
 	}
+	ss = (struct us_data *)dev->privptr;
+	max_blks = usb_stor_max_blks(ss, usb_dev_desc[device].blksz);
 
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
@@ -1150,7 +1274,7 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 	buf_addr = (unsigned long)buffer;
 	start = blknr;
 	blks = blkcnt;
-	if (usb_test_unit_ready(srb, (struct us_data *)dev->privptr)) {
+	if (usb_test_unit_ready(srb, ss)) {
 		printf("Device NOT ready\n   Request Sense returned %02X %02X"
 		       " %02X\n", srb->sense_buf[2], srb->sense_buf[12],
 			srb->sense_buf[13]);
@@ -1166,19 +1290,31 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		 */
 		retry = 2;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (blks > USB_MAX_WRITE_BLK)
-			smallblks = USB_MAX_WRITE_BLK;
+		if (blks > max_blks)
+			smallblks = max_blks;
 		else
 			smallblks = (unsigned short) blks;
 retry_it:
-		if (smallblks == USB_MAX_WRITE_BLK)
+		if (smallblks == max_blks)
 			usb_show_progress();
 		srb->datalen = usb_dev_desc[device].blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_write_10(srb, (struct us_data *)dev->privptr, start,
-		    smallblks)) {
+		t = blkstats_start();
+		err = usb_write_10(srb, ss, start, smallblks);
+		blkstats_end(IF_TYPE_USB, device, BLKSTATS_WRITE,
+			     err ? 0 : srb->datalen, t);
+		if (err) {
 			USB_STOR_PRINTF("Write ERROR\n");
-			usb_request_sense(srb, (struct us_data *)dev->privptr);
+			usb_request_sense(srb, ss);
+			if (smallblks > USB_SAFE_XFER_BLK) {
+				/* the device may not cope with large transfers */
+				printf("USB storage: falling back to %d block "
+				       "transfers\n", USB_SAFE_XFER_BLK);
+				ss->max_xfer = USB_SAFE_XFER_BLK *
+					       usb_dev_desc[device].blksz;
+				max_blks = smallblks = USB_SAFE_XFER_BLK;
+				goto retry_it;
+			}
 			if (retry--)
 				goto retry_it;
 			blkcnt -= blks;
@@ -1193,7 +1329,7 @@ retry_it:
 			start, smallblks, buf_addr);
 
 	usb_disable_asynch(0); /* asynch transfer allowed */
-	if (blkcnt >= USB_MAX_WRITE_BLK)
+	if (blkcnt >= max_blks)
 		debug("\n");
 	return blkcnt;
 
@@ -1244,6 +1380,7 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	ss->ifnum = ifnum;
 	ss->pusb_dev = dev;
 	ss->attention_done = 0;
+	ss->max_xfer = usb_stor_max_xfer(dev);
 
 	/* If the device has subclass and protocol, then use that.  Otherwise,
 	 * take data from the specific interface.
@@ -87,6 +87,7 @@ static struct
   int len, mode, total_retries;
   int total_SOH, total_STX, total_CAN;
   bool crc_mode, at_eof, tx_ack;
+  bool g_mode;			/* Y-modem-g: streamed, no ACKs */
 #ifdef USE_YMODEM_LENGTH
   unsigned long file_length, read_length;
 #endif
@@ -331,6 +332,15 @@ zm_dump (int line)
 #define ZM_DEBUG(x)
 #endif
 
+/* What the receiver sends to ask for (the next file's) blocks */
+static char
+xyzModem_want (void)
+{
+  if (xyz.g_mode)
+    return 'G';
+  return xyz.crc_mode ? 'C' : NAK;
+}
+
 /* Wait for the line to go idle */
 static void
 xyzModem_flush (void)
@@ -552,6 +562,13 @@ xyzModem_stream_open (connection_info_t * info, int *err)
   xyz.at_eof = false;
   xyz.tx_ack = false;
   xyz.mode = info->mode;
+  xyz.g_mode = false;
+  if (xyz.mode == xyzModem_ymodem_g)
+    {
+      /* the same protocol, only the receiver doesn't ACK the blocks */
+      xyz.mode = xyzModem_ymodem;
+      xyz.g_mode = true;
+    }
   xyz.total_retries = 0;
   xyz.total_SOH = 0;
   xyz.total_STX = 0;
@@ -561,7 +578,7 @@ xyzModem_stream_open (connection_info_t * info, int *err)
   xyz.file_length = 0;
 #endif
 
-  CYGACC_COMM_IF_PUTC (*xyz.__chan, (xyz.crc_mode ? 'C' : NAK));
+  CYGACC_COMM_IF_PUTC (*xyz.__chan, xyzModem_want ());
 
   if (xyz.mode == xyzModem_xmodem)
     {
@@ -585,7 +602,10 @@ xyzModem_stream_open (connection_info_t * info, int *err)
 	      parse_num ((char *) xyz.bufp, &xyz.file_length, NULL, " ");
 #endif
 	      /* The rest of the file name data block quietly discarded */
-	      xyz.tx_ack = true;
+	      if (xyz.g_mode)
+		CYGACC_COMM_IF_PUTC (*xyz.__chan, 'G');
+	      else
+		xyz.tx_ack = true;
 	    }
 	  xyz.next_blk = 1;
 	  xyz.len = 0;
@@ -593,10 +613,11 @@ xyzModem_stream_open (connection_info_t * info, int *err)
 	}
       else if (stat == xyzModem_timeout)
 	{
-	  if (--crc_retries <= 0)
+	  /* Y-modem-g is CRC only */
+	  if (--crc_retries <= 0 && !xyz.g_mode)
 	    xyz.crc_mode = false;
 	  CYGACC_CALL_IF_DELAY_US (5 * 100000);	/* Extra delay for startup */
-	  CYGACC_COMM_IF_PUTC (*xyz.__chan, (xyz.crc_mode ? 'C' : NAK));
+	  CYGACC_COMM_IF_PUTC (*xyz.__chan, xyzModem_want ());
 	  xyz.total_retries++;
 	  ZM_DEBUG (zm_dprintf ("NAK (%d)\n", __LINE__));
 	}
@@ -631,7 +652,7 @@ xyzModem_stream_read (char *buf, int size, int *err)
 		{
 		  if (xyz.blk == xyz.next_blk)
 		    {
-		      xyz.tx_ack = true;
+		      xyz.tx_ack = !xyz.g_mode;
 		      ZM_DEBUG (zm_dprintf
 				("ACK block %d (%d)\n", xyz.blk, __LINE__));
 		      xyz.next_blk = (xyz.next_blk + 1) & 0xFF;
@@ -675,7 +696,8 @@ xyzModem_stream_read (char *buf, int size, int *err)
 #endif
 		      break;
 		    }
-		  else if (xyz.blk == ((xyz.next_blk - 1) & 0xFF))
+		  else if (xyz.blk == ((xyz.next_blk - 1) & 0xFF) &&
+			   !xyz.g_mode)
 		    {
 		      /* Just re-ACK this so sender will get on with it */
 		      CYGACC_COMM_IF_PUTC (*xyz.__chan, ACK);
@@ -696,8 +718,7 @@ xyzModem_stream_read (char *buf, int size, int *err)
 		  ZM_DEBUG (zm_dprintf ("ACK (%d)\n", __LINE__));
 		  if (xyz.mode == xyzModem_ymodem)
 		    {
-		      CYGACC_COMM_IF_PUTC (*xyz.__chan,
-					   (xyz.crc_mode ? 'C' : NAK));
+		      CYGACC_COMM_IF_PUTC (*xyz.__chan, xyzModem_want ());
 		      xyz.total_retries++;
 		      ZM_DEBUG (zm_dprintf ("Reading Final Header\n"));
 		      stat = xyzModem_get_hdr ();
@@ -707,6 +728,9 @@ xyzModem_stream_read (char *buf, int size, int *err)
 		  xyz.at_eof = true;
 		  break;
 		}
+	      /* the sender doesn't wait for a NAK, nothing can be repeated */
+	      if (xyz.g_mode)
+		break;
 	      CYGACC_COMM_IF_PUTC (*xyz.__chan, (xyz.crc_mode ? 'C' : NAK));
 	      xyz.total_retries++;
 	      ZM_DEBUG (zm_dprintf ("NAK (%d)\n", __LINE__));
@@ -740,7 +764,8 @@ xyzModem_stream_close (int *err)
 {
   diag_printf
     ("xyzModem - %s mode, %d(SOH)/%d(STX)/%d(CAN) packets, %d retries\n",
-     xyz.crc_mode ? "CRC" : "Cksum", xyz.total_SOH, xyz.total_STX,
+     xyz.g_mode ? "CRC-G" : xyz.crc_mode ? "CRC" : "Cksum",
+     xyz.total_SOH, xyz.total_STX,
      xyz.total_CAN, xyz.total_retries);
   ZM_DEBUG (zm_flush ());
 }
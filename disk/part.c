@@ -25,6 +25,8 @@
 #include <command.h>
 #include <ide.h>
 #include <part.h>
+#include <blkcache.h>
+#include <fat.h>
 
 #undef	PART_DEBUG
 
@@ -40,6 +42,8 @@
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC) || \
+     defined(CONFIG_SANDBOX_BLOCK) || \
+     defined(CONFIG_CMD_AOE) || \
      defined(CONFIG_SYSTEMACE) )
 
 struct block_drvr {
@@ -68,6 +72,12 @@ static const struct block_drvr block_drvr[] = {
 #endif
 #if defined(CONFIG_CMD_MG_DISK)
 	{ .name = "mgd", .get_dev = mg_disk_get_dev, },
+#endif
+#if defined(CONFIG_SANDBOX_BLOCK)
+	{ .name = "host", .get_dev = host_get_dev, },
+#endif
+#if defined(CONFIG_CMD_AOE)
+	{ .name = "aoe", .get_dev = aoe_get_dev, },
 #endif
 	{ },
 };
@@ -97,11 +107,27 @@ block_dev_desc_t *get_dev(char* ifname, int dev)
 	}
 	return NULL;
 }
+
+/*
+ * The contents of a device have changed, by a write or an erase, or it
+ * may be another medium after a rescan: drop what is cached about it.
+ */
+void dev_invalidate(int iftype, int dev)
+{
+	blkcache_invalidate(iftype, dev);
+#ifdef CONFIG_CMD_FAT
+	fat_invalidate(iftype, dev);
+#endif
+}
 #else
 block_dev_desc_t *get_dev(char* ifname, int dev)
 {
 	return NULL;
 }
+
+void dev_invalidate(int iftype, int dev)
+{
+}
 #endif
 
 #if (defined(CONFIG_CMD_IDE) || \
@@ -110,6 +136,8 @@ block_dev_desc_t *get_dev(char* ifname, int dev)
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC) || \
+     defined(CONFIG_SANDBOX_BLOCK) || \
+     defined(CONFIG_CMD_AOE) || \
      defined(CONFIG_SYSTEMACE) )
 
 /* ------------------------------------------------------------------------- */
@@ -157,6 +185,7 @@ void dev_print (block_dev_desc_t *dev_desc)
 	case IF_TYPE_ATAPI:
 	case IF_TYPE_IDE:
 	case IF_TYPE_SATA:
+	case IF_TYPE_AOE:
 		printf ("Model: %s Firm: %s Ser#: %s\n",
 			dev_desc->vendor,
 			dev_desc->revision,
@@ -165,6 +194,7 @@ void dev_print (block_dev_desc_t *dev_desc)
 	case IF_TYPE_SD:
 	case IF_TYPE_MMC:
 	case IF_TYPE_USB:
+	case IF_TYPE_HOST:
 		printf ("Vendor: %s Rev: %s Prod: %s\n",
 			dev_desc->vendor,
 			dev_desc->revision,
@@ -246,6 +276,8 @@ void dev_print (block_dev_desc_t *dev_desc)
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC)		|| \
+     defined(CONFIG_SANDBOX_BLOCK) || \
+     defined(CONFIG_CMD_AOE) || \
      defined(CONFIG_SYSTEMACE) )
 
 #if defined(CONFIG_MAC_PARTITION) || \
@@ -374,6 +406,12 @@ static void print_part_header (const char *type, block_dev_desc_t * dev_desc)
 	case IF_TYPE_MMC:
 		puts ("MMC");
 		break;
+	case IF_TYPE_HOST:
+		puts ("HOST");
+		break;
+	case IF_TYPE_AOE:
+		puts ("AoE");
+		break;
 	default:
 		puts ("UNKNOWN");
 		break;
@@ -31,6 +31,8 @@
     defined(CONFIG_CMD_SCSI) || \
     defined(CONFIG_CMD_USB) || \
     defined(CONFIG_MMC) || \
+    defined(CONFIG_SANDBOX_BLOCK) || \
+    defined(CONFIG_CMD_AOE) || \
     defined(CONFIG_SYSTEMACE)
 
 #undef AMIGA_DEBUG
@@ -41,6 +41,8 @@
     defined(CONFIG_CMD_SCSI) || \
     defined(CONFIG_CMD_USB) || \
     defined(CONFIG_MMC) || \
+    defined(CONFIG_SANDBOX_BLOCK) || \
+    defined(CONFIG_CMD_AOE) || \
     defined(CONFIG_SYSTEMACE)
 
 /* Convert char[4] in little endian format to the host format integer
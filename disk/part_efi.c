@@ -43,6 +43,8 @@
     defined(CONFIG_CMD_SCSI) || \
     defined(CONFIG_CMD_USB) || \
     defined(CONFIG_MMC) || \
+    defined(CONFIG_SANDBOX_BLOCK) || \
+    defined(CONFIG_CMD_AOE) || \
     defined(CONFIG_SYSTEMACE)
 
 /* Convert char[2] in little endian format to the host format integer
@@ -114,52 +116,159 @@ static char *print_efiname(gpt_entry *pte)
 	return name;
 }
 
+/*
+ * A validated partition table: the entries and their number
+ */
+struct gpt_table {
+	block_dev_desc_t *dev_desc;
+	gpt_entry *pte;
+	int num;
+};
+
+#ifdef CONFIG_EFI_PARTITION_CACHE
+#ifndef CONFIG_SYS_EFI_PARTITION_CACHE_DEVICES
+#define CONFIG_SYS_EFI_PARTITION_CACHE_DEVICES	4
+#endif
+
+/*
+ * The table of a device is read and its CRCs checked the first time a
+ * partition of it is looked up, and kept until init_part() scans the
+ * device again (a new card, "usb reset", ...).
+ */
+static struct gpt_table gpt_cache[CONFIG_SYS_EFI_PARTITION_CACHE_DEVICES];
+static int gpt_cache_next;
+#endif
+
+static int gpt_read(block_dev_desc_t *dev_desc, struct gpt_table *t)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(gpt_header, gpt_head, 1);
+
+	/* This function validates AND fills in the GPT header and PTE */
+	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
+			 gpt_head, &t->pte) != 1)
+		return -1;
+
+	t->dev_desc = dev_desc;
+	t->num = le32_to_int(gpt_head->num_partition_entries);
+	debug("%s: gpt-entry at %p\n", __func__, t->pte);
+	return 0;
+}
+
+/*
+ * gpt_get() - the partition table of a device
+ * @tmp: filled in when the table is not cached
+ *
+ * Description: returns the table, or NULL if it is invalid.  The table
+ * must be released with gpt_put().
+ */
+static struct gpt_table *gpt_get(block_dev_desc_t *dev_desc,
+				 struct gpt_table *tmp)
+{
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	struct gpt_table *t;
+	int i;
+
+	for (i = 0; i < CONFIG_SYS_EFI_PARTITION_CACHE_DEVICES; i++)
+		if (gpt_cache[i].dev_desc == dev_desc)
+			return &gpt_cache[i];
+
+	/* the least recently read table makes room */
+	t = &gpt_cache[gpt_cache_next];
+	if (t->dev_desc) {
+		free(t->pte);
+		t->dev_desc = NULL;
+	}
+	if (gpt_read(dev_desc, t))
+		return NULL;
+	gpt_cache_next = (gpt_cache_next + 1) %
+			 CONFIG_SYS_EFI_PARTITION_CACHE_DEVICES;
+	return t;
+#else
+	if (gpt_read(dev_desc, tmp))
+		return NULL;
+	return tmp;
+#endif
+}
+
+static void gpt_put(struct gpt_table *t)
+{
+#ifndef CONFIG_EFI_PARTITION_CACHE
+	free(t->pte);
+#endif
+}
+
+/* Drops the cached table of a device */
+static void gpt_flush(block_dev_desc_t *dev_desc)
+{
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	int i;
+
+	for (i = 0; i < CONFIG_SYS_EFI_PARTITION_CACHE_DEVICES; i++) {
+		if (gpt_cache[i].dev_desc == dev_desc) {
+			free(gpt_cache[i].pte);
+			gpt_cache[i].dev_desc = NULL;
+		}
+	}
+#endif
+}
+
+static void gpt_part_info(gpt_entry *pte, disk_partition_t *info)
+{
+	/* The ulong casting limits the maximum disk size to 2 TB */
+	info->start = (ulong) le64_to_int(pte->starting_lba);
+	/* The ending LBA is inclusive, to calculate size, add 1 to it */
+	info->size = ((ulong)le64_to_int(pte->ending_lba) + 1)
+		     - info->start;
+	info->blksz = GPT_BLOCK_SIZE;
+
+	sprintf((char *)info->name, "%s", print_efiname(pte));
+	sprintf((char *)info->type, "U-Boot");
+
+	debug("%s: start 0x%lX, size 0x%lX, name %s", __func__,
+		info->start, info->size, info->name);
+}
+
 /*
  * Public Functions (include/part.h)
  */
 
 void print_part_efi(block_dev_desc_t * dev_desc)
 {
-	ALLOC_CACHE_ALIGN_BUFFER(gpt_header, gpt_head, 1);
-	gpt_entry *gpt_pte = NULL;
+	struct gpt_table tmp, *t;
 	int i = 0;
 
 	if (!dev_desc) {
 		printf("%s: Invalid Argument(s)\n", __func__);
 		return;
 	}
-	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			 gpt_head, &gpt_pte) != 1) {
+	t = gpt_get(dev_desc, &tmp);
+	if (!t) {
 		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
 		return;
 	}
 
-	debug("%s: gpt-entry at %p\n", __func__, gpt_pte);
-
 	printf("Part\tName\t\t\tStart LBA\tEnd LBA\n");
-	for (i = 0; i < le32_to_int(gpt_head->num_partition_entries); i++) {
+	for (i = 0; i < t->num; i++) {
 
-		if (is_pte_valid(&gpt_pte[i])) {
+		if (is_pte_valid(&t->pte[i])) {
 			printf("%3d\t%-18s\t0x%08llX\t0x%08llX\n", (i + 1),
-				print_efiname(&gpt_pte[i]),
-				le64_to_int(gpt_pte[i].starting_lba),
-				le64_to_int(gpt_pte[i].ending_lba));
+				print_efiname(&t->pte[i]),
+				le64_to_int(t->pte[i].starting_lba),
+				le64_to_int(t->pte[i].ending_lba));
 		} else {
 			break;	/* Stop at the first non valid PTE */
 		}
 	}
 
-	/* Remember to free pte */
-	free(gpt_pte);
+	gpt_put(t);
 	return;
 }
 
 int get_partition_info_efi(block_dev_desc_t * dev_desc, int part,
 				disk_partition_t * info)
 {
-	ALLOC_CACHE_ALIGN_BUFFER(gpt_header, gpt_head, 1);
-	gpt_entry *gpt_pte = NULL;
+	struct gpt_table tmp, *t;
+	int ret = 0;
 
 	/* "part" argument must be at least 1 */
 	if (!dev_desc || !info || part < 1) {
@@ -167,36 +276,96 @@ int get_partition_info_efi(block_dev_desc_t * dev_desc, int part,
 		return -1;
 	}
 
-	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			gpt_head, &gpt_pte) != 1) {
+	t = gpt_get(dev_desc, &tmp);
+	if (!t) {
 		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
 		return -1;
 	}
 
-	/* The ulong casting limits the maximum disk size to 2 TB */
-	info->start = (ulong) le64_to_int(gpt_pte[part - 1].starting_lba);
-	/* The ending LBA is inclusive, to calculate size, add 1 to it */
-	info->size = ((ulong)le64_to_int(gpt_pte[part - 1].ending_lba) + 1)
-		     - info->start;
-	info->blksz = GPT_BLOCK_SIZE;
+	if (part > t->num || !is_pte_valid(&t->pte[part - 1]))
+		ret = -1;
+	else
+		gpt_part_info(&t->pte[part - 1], info);
 
-	sprintf((char *)info->name, "%s",
-			print_efiname(&gpt_pte[part - 1]));
-	sprintf((char *)info->type, "U-Boot");
+	gpt_put(t);
+	return ret;
+}
 
-	debug("%s: start 0x%lX, size 0x%lX, name %s", __func__,
-		info->start, info->size, info->name);
+/*
+ * get_partition_info_efi_by_name() - looks a partition up by its name
+ *
+ * Description: returns the partition number, or -1 if there is none
+ * of that name.
+ */
+int get_partition_info_efi_by_name(block_dev_desc_t *dev_desc,
+				   const char *name, disk_partition_t *info)
+{
+	struct gpt_table tmp, *t;
+	int i, ret = -1;
 
-	/* Remember to free pte */
-	free(gpt_pte);
-	return 0;
+	if (!dev_desc || !name || !info)
+		return -1;
+
+	t = gpt_get(dev_desc, &tmp);
+	if (!t)
+		return -1;
+
+	for (i = 0; i < t->num; i++) {
+		if (is_pte_valid(&t->pte[i]) &&
+		    !strcmp(print_efiname(&t->pte[i]), name)) {
+			gpt_part_info(&t->pte[i], info);
+			ret = i + 1;
+			break;
+		}
+	}
+
+	gpt_put(t);
+	return ret;
+}
+
+/*
+ * get_partition_info_efi_by_guid() - looks a partition up by its
+ * unique partition GUID, given as "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+ *
+ * Description: returns the partition number, or -1 if there is none
+ * with that GUID.
+ */
+int get_partition_info_efi_by_guid(block_dev_desc_t *dev_desc,
+				   const char *guid, disk_partition_t *info)
+{
+	struct gpt_table tmp, *t;
+	efi_guid_t bin;
+	int i, ret = -1;
+
+	if (!dev_desc || !info || !uuid_str_valid(guid))
+		return -1;
+	uuid_str_to_bin(guid, bin.b);
+
+	t = gpt_get(dev_desc, &tmp);
+	if (!t)
+		return -1;
+
+	for (i = 0; i < t->num; i++) {
+		if (is_pte_valid(&t->pte[i]) &&
+		    !memcmp(t->pte[i].unique_partition_guid.b, bin.b,
+			    sizeof(bin.b))) {
+			gpt_part_info(&t->pte[i], info);
+			ret = i + 1;
+			break;
+		}
+	}
+
+	gpt_put(t);
+	return ret;
 }
 
 int test_part_efi(block_dev_desc_t * dev_desc)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(legacy_mbr, legacymbr, 1);
 
+	/* The device is being scanned again: a new table may be on it */
+	gpt_flush(dev_desc);
+
 	/* Read legacy MBR from block 0 and validate it */
 	if ((dev_desc->block_read(dev_desc->dev, 0, 1, (ulong *)legacymbr) != 1)
 		|| (is_pmbr_valid(legacymbr) != 1)) {
@@ -374,7 +543,7 @@ static gpt_entry *alloc_read_gpt_entries(block_dev_desc_t * dev_desc,
 	count = le32_to_int(pgpt_head->num_partition_entries) *
 		le32_to_int(pgpt_head->sizeof_partition_entry);
 
-	debug("%s: count = %lu * %lu = %u\n", __func__,
+	debug("%s: count = %lu * %lu = %zu\n", __func__,
 		le32_to_int(pgpt_head->num_partition_entries),
 		le32_to_int(pgpt_head->sizeof_partition_entry), count);
 
@@ -384,7 +553,7 @@ static gpt_entry *alloc_read_gpt_entries(block_dev_desc_t * dev_desc,
 	}
 
 	if (count == 0 || pte == NULL) {
-		printf("%s: ERROR: Can't allocate 0x%X bytes for GPT Entries\n",
+		printf("%s: ERROR: Can't allocate 0x%zX bytes for GPT Entries\n",
 			__func__, count);
 		return NULL;
 	}
@@ -425,8 +594,7 @@ static int is_pte_valid(gpt_entry * pte)
 	if (memcmp(pte->partition_type_guid.b, unused_guid.b,
 		sizeof(unused_guid.b)) == 0) {
 
-		debug("%s: Found an unused PTE GUID at 0x%08X\n", __func__,
-		(unsigned int)pte);
+		debug("%s: Found an unused PTE GUID at %p\n", __func__, pte);
 
 		return 0;
 	} else {
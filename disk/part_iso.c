@@ -31,6 +31,8 @@
     defined(CONFIG_CMD_SATA) || \
     defined(CONFIG_CMD_USB) || \
     defined(CONFIG_MMC) || \
+    defined(CONFIG_SANDBOX_BLOCK) || \
+    defined(CONFIG_CMD_AOE) || \
     defined(CONFIG_SYSTEMACE)
 
 /* #define	ISO_PART_DEBUG */
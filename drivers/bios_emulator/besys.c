@@ -228,6 +228,34 @@ void X86API BE_wrl(u32 addr, u32 val)
 	}
 }
 
+/****************************************************************************
+PARAMETERS:
+addr    - Emulator memory address
+len     - Number of bytes
+
+RETURNS:
+Pointer to the memory, or NULL
+
+REMARKS:
+Returns where the len bytes at addr are, when they all are in the low
+memory or in the copy of the BIOS image, which can be accessed directly.
+Bus memory, and any range that crosses into another region, is left to
+the functions above.
+****************************************************************************/
+u8 *X86API BE_memptr(u32 addr, u32 len)
+{
+	u32 end = addr + len - 1;
+
+	if (!len || end < addr)
+		return NULL;
+	if (addr >= 0xC0000 && end <= _BE_env.biosmem_limit &&
+	    _BE_env.vgaInfo.BIOSImage)
+		return (u8 *)(_BE_env.biosmem_base + addr - 0xC0000);
+	if (end < 0xA0000 && end < M.mem_size)
+		return M.mem_base + addr;
+	return NULL;
+}
+
 #if defined(DEBUG) || !defined(__i386__)
 
 /* For Non-Intel machines we may need to emulate some I/O port accesses that
@@ -57,6 +57,7 @@ static X86EMU_memFuncs _BE_mem __attribute__((section(GOT2_TYPE))) = {
 	BE_wrb,
 	BE_wrw,
 	BE_wrl,
+	BE_memptr,
 	};
 
 static X86EMU_pioFuncs _BE_pio __attribute__((section(GOT2_TYPE))) = {
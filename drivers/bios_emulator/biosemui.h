@@ -158,6 +158,7 @@ u32 X86API BE_rdl(u32 addr);
 void X86API BE_wrb(u32 addr, u8 val);
 void X86API BE_wrw(u32 addr, u16 val);
 void X86API BE_wrl(u32 addr, u32 val);
+u8 *X86API BE_memptr(u32 addr, u32 len);
 
 u8 X86API BE_inb(X86EMU_pioAddr port);
 u16 X86API BE_inw(X86EMU_pioAddr port);
@@ -116,6 +116,10 @@ rdl     - Function to read a dword from an address
 wrb     - Function to write a byte to an address
 wrw     - Function to write a word to an address
 wrl     - Function to write a dword to an address
+memptr  - Optional function returning a pointer to the plain memory behind
+	  len bytes at addr, or NULL when they are not all plain memory.
+	  The emulator then fetches code and runs REP MOVS and REP STOS
+	  without going through the functions above.
 ****************************************************************************/
 typedef struct {
 	u8(X86APIP rdb) (u32 addr);
@@ -124,6 +128,7 @@ typedef struct {
 	void (X86APIP wrb) (u32 addr, u8 val);
 	void (X86APIP wrw) (u32 addr, u16 val);
 	void (X86APIP wrl) (u32 addr, u32 val);
+	u8 *(X86APIP memptr) (u32 addr, u32 len);
 } X86EMU_memFuncs;
 
 /****************************************************************************
@@ -136,6 +141,7 @@ extern u32 X86API rdl(u32 addr);
 extern void X86API wrb(u32 addr, u8 val);
 extern void X86API wrw(u32 addr, u16 val);
 extern void X86API wrl(u32 addr, u32 val);
+extern u8 *X86API memptr(u32 addr, u32 len);
 
 #pragma pack()
 
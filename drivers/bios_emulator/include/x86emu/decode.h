@@ -72,6 +72,8 @@ void    store_data_word (uint offset, u16 val);
 void    store_data_word_abs (uint segment, uint offset, u16 val);
 void    store_data_long (uint offset, u32 val);
 void    store_data_long_abs (uint segment, uint offset, u32 val);
+int     rep_movs_fast (int size);
+int     rep_stos_fast (u32 val, int size);
 u8*     decode_rm_byte_register(int reg);
 u16*    decode_rm_word_register(int reg);
 u32*    decode_rm_long_register(int reg);
@@ -41,6 +41,64 @@
 
 /*----------------------------- Implementation ----------------------------*/
 
+/*
+ * Instructions are fetched through a window on the 4K page of plain
+ * memory the code runs in, instead of calling (*sys_rdb) for every byte.
+ * A page that is not plain memory is remembered, so it is not looked up
+ * again for every fetch.
+ */
+#define CODE_PAGE	0x1000
+
+static u8 *code_ptr;
+static u32 code_page = ~0;
+static u32 code_nomap = ~0;
+
+static void code_window_reset(void)
+{
+    code_ptr = NULL;
+    code_page = code_nomap = ~0;
+}
+
+/****************************************************************************
+PARAMETERS:
+len	- Number of instruction bytes to fetch at CS:IP
+
+RETURNS:
+Pointer to the bytes, or NULL to fetch them through (*sys_rdX)
+****************************************************************************/
+static u8 *code_window(u32 len)
+{
+    u32 addr = ((u32)M.x86.R_CS << 4) + M.x86.R_IP;
+    u32 page = addr & ~(CODE_PAGE - 1);
+
+    if (page != code_page) {
+	if (page == code_nomap)
+	    return NULL;
+	code_ptr = (*sys_memptr)(page, CODE_PAGE);
+	if (!code_ptr) {
+	    code_nomap = page;
+	    code_page = ~0;
+	    return NULL;
+	}
+	code_page = page;
+    }
+    if ((addr & (CODE_PAGE - 1)) + len > CODE_PAGE ||
+	M.x86.R_IP + len > 0x10000)
+	return NULL;
+    return code_ptr + (addr & (CODE_PAGE - 1));
+}
+
+static u8 fetch_code_byte(void)
+{
+    u8 *p = code_window(1);
+
+    if (p) {
+	M.x86.R_IP++;
+	return *p;
+    }
+    return (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+}
+
 /****************************************************************************
 REMARKS:
 Handles any pending asychronous interrupts.
@@ -92,6 +150,7 @@ void X86EMU_exec(void)
     u8 op1;
 
     M.x86.intr = 0;
+    code_window_reset();
     DB(x86emu_end_instr();)
 
     for (;;) {
@@ -117,7 +176,7 @@ DB(		if (M.x86.R_SP != 0) {
 		x86emu_intr_handle();
 	    }
 	}
-	op1 = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+	op1 = fetch_code_byte();
 	(*x86emu_optab[op1])(op1);
 	if (M.x86.debug & DEBUG_EXIT) {
 	    M.x86.debug &= ~DEBUG_EXIT;
@@ -156,7 +215,7 @@ void fetch_decode_modrm(
 
 DB( if (CHECK_IP_FETCH())
 	x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_byte();
     INC_DECODED_INST_LEN(1);
     *mod  = (fetched >> 6) & 0x03;
     *regh = (fetched >> 3) & 0x07;
@@ -179,7 +238,7 @@ u8 fetch_byte_imm(void)
 
 DB( if (CHECK_IP_FETCH())
 	x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_byte();
     INC_DECODED_INST_LEN(1);
     return fetched;
 }
@@ -197,10 +256,15 @@ NOTE: Do not inline this function, as (*sys_rdw) is already inline!
 u16 fetch_word_imm(void)
 {
     u16 fetched;
+    u8 *p;
 
 DB( if (CHECK_IP_FETCH())
 	x86emu_check_ip_access();)
-    fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+    p = code_window(2);
+    if (p)
+	fetched = p[0] | (p[1] << 8);
+    else
+	fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
     M.x86.R_IP += 2;
     INC_DECODED_INST_LEN(2);
     return fetched;
@@ -219,10 +283,15 @@ NOTE: Do not inline this function, as (*sys_rdw) is already inline!
 u32 fetch_long_imm(void)
 {
     u32 fetched;
+    u8 *p;
 
 DB( if (CHECK_IP_FETCH())
 	x86emu_check_ip_access();)
-    fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+    p = code_window(4);
+    if (p)
+	fetched = p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+    else
+	fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
     M.x86.R_IP += 4;
     INC_DECODED_INST_LEN(4);
     return fetched;
@@ -546,6 +615,99 @@ void store_data_long_abs(
     (*sys_wrl)(((u32)segment << 4) + offset, val);
 }
 
+/****************************************************************************
+PARAMETERS:
+segment	- Segment of the string
+offset	- Offset of the string
+len	- Length of the string in bytes
+
+RETURNS:
+Pointer to the string, or NULL if it wraps around the segment or is not
+all plain memory.
+****************************************************************************/
+static u8 *string_ptr(
+    uint segment,
+    uint offset,
+    u32 len)
+{
+    if (len == 0 || offset + len > 0x10000)
+	return NULL;
+    return (*sys_memptr)(((u32)segment << 4) + offset, len);
+}
+
+/****************************************************************************
+PARAMETERS:
+size	- Size of the elements, 1, 2 or 4
+
+RETURNS:
+1 if the REP MOVS was done, 0 if it has to be emulated element by element.
+
+REMARKS:
+Copies CX elements from DS:SI (or the override) to ES:DI in one go, when
+both strings are plain memory and the copy goes forwards.  A destination
+just above the source is left to the loop, as it repeats the elements.
+****************************************************************************/
+int rep_movs_fast(
+    int size)
+{
+    u32 len = (u32)M.x86.R_CX * size;
+    u8 *src, *dst;
+
+    if (ACCESS_FLAG(F_DF))
+	return 0;
+    src = string_ptr(get_data_segment(), M.x86.R_SI, len);
+    dst = string_ptr(M.x86.R_ES, M.x86.R_DI, len);
+    if (!src || !dst || (dst > src && dst < src + len))
+	return 0;
+    memmove(dst, src, len);
+    M.x86.R_SI += len;
+    M.x86.R_DI += len;
+    M.x86.R_CX = 0;
+    return 1;
+}
+
+/****************************************************************************
+PARAMETERS:
+val	- Value to store
+size	- Size of the elements, 1, 2 or 4
+
+RETURNS:
+1 if the REP STOS was done, 0 if it has to be emulated element by element.
+
+REMARKS:
+Fills CX elements at ES:DI in one go, when they are plain memory and the
+fill goes forwards.
+****************************************************************************/
+int rep_stos_fast(
+    u32 val,
+    int size)
+{
+    u32 len = (u32)M.x86.R_CX * size;
+    u8 *dst;
+    u32 i;
+
+    if (ACCESS_FLAG(F_DF))
+	return 0;
+    dst = string_ptr(M.x86.R_ES, M.x86.R_DI, len);
+    if (!dst)
+	return 0;
+    if (size == 1 || val == 0) {
+	memset(dst, val, len);
+    } else {
+	for (i = 0; i < len; i += size) {
+	    dst[i] = val;
+	    dst[i + 1] = val >> 8;
+	    if (size == 4) {
+		dst[i + 2] = val >> 16;
+		dst[i + 3] = val >> 24;
+	    }
+	}
+    }
+    M.x86.R_DI += len;
+    M.x86.R_CX = 0;
+    return 1;
+}
+
 /****************************************************************************
 PARAMETERS:
 reg - Register to decode
@@ -2534,6 +2534,8 @@ void x86emuOp_movs_byte(u8 X86EMU_UNUSED(op1))
 	/* dont care whether REPE or REPNE */
 	/* move them until CX is ZERO. */
 	count = M.x86.R_CX;
+	if (rep_movs_fast(1))
+	    count = 0;
 	M.x86.R_CX = 0;
 	M.x86.mode &= ~(SYSMODE_PREFIX_REPE | SYSMODE_PREFIX_REPNE);
     }
@@ -2577,6 +2579,8 @@ void x86emuOp_movs_word(u8 X86EMU_UNUSED(op1))
 	/* dont care whether REPE or REPNE */
 	/* move them until CX is ZERO. */
 	count = M.x86.R_CX;
+	if (rep_movs_fast(M.x86.mode & SYSMODE_PREFIX_DATA ? 4 : 2))
+	    count = 0;
 	M.x86.R_CX = 0;
 	M.x86.mode &= ~(SYSMODE_PREFIX_REPE | SYSMODE_PREFIX_REPNE);
     }
@@ -2758,6 +2762,7 @@ void x86emuOp_stos_byte(u8 X86EMU_UNUSED(op1))
     if (M.x86.mode & (SYSMODE_PREFIX_REPE | SYSMODE_PREFIX_REPNE)) {
 	/* dont care whether REPE or REPNE */
 	/* move them until CX is ZERO. */
+	rep_stos_fast(M.x86.R_AL, 1);
 	while (M.x86.R_CX != 0) {
 	    store_data_byte_abs(M.x86.R_ES, M.x86.R_DI, M.x86.R_AL);
 	    M.x86.R_CX -= 1;
@@ -2801,6 +2806,9 @@ void x86emuOp_stos_word(u8 X86EMU_UNUSED(op1))
 	/* dont care whether REPE or REPNE */
 	/* move them until CX is ZERO. */
 	count = M.x86.R_CX;
+	if (M.x86.mode & SYSMODE_PREFIX_DATA ?
+	    rep_stos_fast(M.x86.R_EAX, 4) : rep_stos_fast(M.x86.R_AX, 2))
+	    count = 0;
 	M.x86.R_CX = 0;
 	M.x86.mode &= ~(SYSMODE_PREFIX_REPE | SYSMODE_PREFIX_REPNE);
     }
@@ -131,6 +131,23 @@ void X86API wrl(u32 addr, u32 val)
 {
 }
 
+/****************************************************************************
+PARAMETERS:
+addr    - Emulator memory address
+len     - Number of bytes
+
+RETURNS:
+NULL
+
+REMARKS:
+Default memory pointer function, leaving all accesses to the functions
+above.
+****************************************************************************/
+u8 *X86API memptr(u32 addr, u32 len)
+{
+	return NULL;
+}
+
 /****************************************************************************
 PARAMETERS:
 addr    - PIO address to read
@@ -226,6 +243,7 @@ u32(X86APIP sys_rdl) (u32 addr) = rdl;
 void (X86APIP sys_wrb) (u32 addr, u8 val) = wrb;
 void (X86APIP sys_wrw) (u32 addr, u16 val) = wrw;
 void (X86APIP sys_wrl) (u32 addr, u32 val) = wrl;
+u8 *(X86APIP sys_memptr) (u32 addr, u32 len) = memptr;
 u8(X86APIP sys_inb) (X86EMU_pioAddr addr) = p_inb;
 u16(X86APIP sys_inw) (X86EMU_pioAddr addr) = p_inw;
 u32(X86APIP sys_inl) (X86EMU_pioAddr addr) = p_inl;
@@ -252,6 +270,7 @@ void X86EMU_setupMemFuncs(X86EMU_memFuncs * funcs)
 	sys_wrb = funcs->wrb;
 	sys_wrw = funcs->wrw;
 	sys_wrl = funcs->wrl;
+	sys_memptr = funcs->memptr ? funcs->memptr : memptr;
 }
 
 /****************************************************************************
@@ -36,6 +36,7 @@
 #include <ata.h>
 #include <linux/ctype.h>
 #include <ahci.h>
+#include <wait_bit.h>
 
 struct ahci_probe_ent *probe_ent = NULL;
 hd_driveid_t *ataid[AHCI_MAX_PORTS];
@@ -58,21 +59,11 @@ static void ahci_setup_port(struct ahci_ioports *port, unsigned long base,
 	port->scr_addr = base + PORT_SCR;
 }
 
-
-#define msleep(a) udelay(a * 1000)
-#define ssleep(a) msleep(a * 1000)
-
 static int waiting_for_cmd_completed(volatile u8 *offset,
 				     int timeout_msec,
 				     u32 sign)
 {
-	int i;
-	u32 status;
-
-	for (i = 0; ((status = readl(offset)) & sign) && i < timeout_msec; i++)
-		msleep(1);
-
-	return (i < timeout_msec) ? 0 : -1;
+	return wait_for_bit(NULL, offset, sign, 0, timeout_msec) ? -1 : 0;
 }
 
 
@@ -84,8 +75,9 @@ static int ahci_host_init(struct ahci_probe_ent *probe_ent)
 	unsigned short vendor;
 #endif
 	volatile u8 *mmio = (volatile u8 *)probe_ent->mmio_base;
+	struct wait_backoff wb;
 	u32 tmp, cap_save;
-	int i, j;
+	int i;
 	volatile u8 *port_mmio;
 
 	cap_save = readl(mmio + HOST_CAP);
@@ -100,7 +92,7 @@ static int ahci_host_init(struct ahci_probe_ent *probe_ent)
 	/* reset must complete within 1 second, or
 	 * the hardware should be considered fried.
 	 */
-	ssleep(1);
+	wait_for_bit(NULL, mmio + HOST_CTL, HOST_RESET, 0, 1000);
 
 	tmp = readl(mmio + HOST_CTL);
 	if (tmp & HOST_RESET) {
@@ -142,22 +134,21 @@ static int ahci_host_init(struct ahci_probe_ent *probe_ent)
 				 PORT_CMD_FIS_RX | PORT_CMD_START);
 			writel_with_flush(tmp, port_mmio + PORT_CMD);
 
-			/* spec says 500 msecs for each bit, so
-			 * this is slightly incorrect.
-			 */
-			msleep(500);
+			/* spec says 500 msecs for each bit */
+			wait_for_bit(NULL, port_mmio + PORT_CMD,
+				     PORT_CMD_LIST_ON | PORT_CMD_FIS_ON, 0,
+				     500);
 		}
 
 		writel(PORT_CMD_SPIN_UP, port_mmio + PORT_CMD);
 
-		j = 0;
-		while (j < 100) {
-			msleep(10);
+		/* up to a second for the link to come up */
+		wait_backoff_start(&wb, 1000);
+		do {
 			tmp = readl(port_mmio + PORT_SCR_STAT);
 			if ((tmp & 0xf) == 0x3)
 				break;
-			j++;
-		}
+		} while (!wait_backoff(&wb));
 
 		tmp = readl(port_mmio + PORT_SCR_ERR);
 		debug("PORT_SCR_ERR 0x%x\n", tmp);
@@ -304,10 +295,9 @@ static int ahci_init_one(pci_dev_t pdev)
 
 #define MAX_DATA_BYTE_COUNT  (4*1024*1024)
 
-static int ahci_fill_sg(u8 port, unsigned char *buf, int buf_len)
+static int ahci_fill_sg(struct ahci_sg *ahci_sg, unsigned char *buf,
+			int buf_len)
 {
-	struct ahci_ioports *pp = &(probe_ent->port[port]);
-	struct ahci_sg *ahci_sg = pp->cmd_tbl_sg;
 	u32 sg_count;
 	int i;
 
@@ -333,12 +323,25 @@ static int ahci_fill_sg(u8 port, unsigned char *buf, int buf_len)
 }
 
 
-static void ahci_fill_cmd_slot(struct ahci_ioports *pp, u32 opts)
+static u32 ahci_cmd_tbl(struct ahci_ioports *pp, int slot)
+{
+	return pp->cmd_tbl + slot * AHCI_CMD_TBL_SZ;
+}
+
+static void ahci_fill_cmd_slot(struct ahci_ioports *pp, int slot, u32 opts)
+{
+	struct ahci_cmd_hdr *cmd_slot = &pp->cmd_slot[slot];
+
+	cmd_slot->opts = cpu_to_le32(opts);
+	cmd_slot->status = 0;
+	cmd_slot->tbl_addr = cpu_to_le32(ahci_cmd_tbl(pp, slot) & 0xffffffff);
+	cmd_slot->tbl_addr_hi = 0;
+}
+
+/* Allow 150 ms for a command plus 1 ms for every 32 KiB of data */
+static int ahci_cmd_timeout(int buf_len)
 {
-	pp->cmd_slot->opts = cpu_to_le32(opts);
-	pp->cmd_slot->status = 0;
-	pp->cmd_slot->tbl_addr = cpu_to_le32(pp->cmd_tbl & 0xffffffff);
-	pp->cmd_slot->tbl_addr_hi = 0;
+	return 150 + buf_len / 32768;
 }
 
 
@@ -358,7 +361,7 @@ static void ahci_set_feature(u8 port)
 	fis[12] = __ilog2(probe_ent->udma_mask + 1) + 0x40 - 0x01;
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, 20);
-	ahci_fill_cmd_slot(pp, cmd_fis_len);
+	ahci_fill_cmd_slot(pp, 0, cmd_fis_len);
 	writel(1, port_mmio + PORT_CMD_ISSUE);
 	readl(port_mmio + PORT_CMD_ISSUE);
 
@@ -399,7 +402,7 @@ static int ahci_port_start(u8 port)
 	 */
 	pp->cmd_slot = (struct ahci_cmd_hdr *)mem;
 	debug("cmd_slot = %p\n", pp->cmd_slot);
-	mem += (AHCI_CMD_SLOT_SZ + 224);
+	mem += AHCI_CMD_LIST_SZ;
 
 	/*
 	 * Second item: Received-FIS area
@@ -408,8 +411,8 @@ static int ahci_port_start(u8 port)
 	mem += AHCI_RX_FIS_SZ;
 
 	/*
-	 * Third item: data area for storing a single command
-	 * and its scatter-gather table
+	 * Third item: data area for storing the commands of the first
+	 * CONFIG_AHCI_NCQ_SLOTS slots and their scatter-gather tables
 	 */
 	pp->cmd_tbl = mem;
 	debug("cmd_tbl_dma = 0x%x\n", pp->cmd_tbl);
@@ -432,7 +435,7 @@ static int ahci_port_start(u8 port)
 
 
 static int get_ahci_device_data(u8 port, u8 *fis, int fis_len, u8 *buf,
-				int buf_len)
+				int buf_len, int is_write)
 {
 
 	struct ahci_ioports *pp = &(probe_ent->port[port]);
@@ -456,13 +459,18 @@ static int get_ahci_device_data(u8 port, u8 *fis, int fis_len, u8 *buf,
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, fis_len);
 
-	sg_count = ahci_fill_sg(port, buf, buf_len);
+	sg_count = ahci_fill_sg(pp->cmd_tbl_sg, buf, buf_len);
+	if (sg_count < 0)
+		return -1;
 	opts = (fis_len >> 2) | (sg_count << 16);
-	ahci_fill_cmd_slot(pp, opts);
+	if (is_write)
+		opts |= AHCI_CMD_WRITE;
+	ahci_fill_cmd_slot(pp, 0, opts);
 
 	writel_with_flush(1, port_mmio + PORT_CMD_ISSUE);
 
-	if (waiting_for_cmd_completed(port_mmio + PORT_CMD_ISSUE, 150, 0x1)) {
+	if (waiting_for_cmd_completed(port_mmio + PORT_CMD_ISSUE,
+				      ahci_cmd_timeout(buf_len), 0x1)) {
 		printf("timeout exit!\n");
 		return -1;
 	}
@@ -473,6 +481,160 @@ static int get_ahci_device_data(u8 port, u8 *fis, int fis_len, u8 *buf,
 }
 
 
+static int ahci_id_has_lba48(hd_driveid_t *id)
+{
+	return id && (le16_to_cpu(id->command_set_2) & (1 << 10));
+}
+
+
+/*
+ * Restart the command engine of a port after an error, and read the NCQ
+ * error log: a drive does not take new commands after a failed queued
+ * command until this has been done.
+ */
+static void ahci_port_restart(u8 port)
+{
+	struct ahci_ioports *pp = &(probe_ent->port[port]);
+	volatile u8 *port_mmio = (volatile u8 *)pp->port_mmio;
+	u32 tmp;
+	u8 fis[20];
+	u8 *log;
+
+	tmp = readl(port_mmio + PORT_CMD) & ~PORT_CMD_START;
+	writel_with_flush(tmp, port_mmio + PORT_CMD);
+	if (waiting_for_cmd_completed(port_mmio + PORT_CMD, 500,
+				      PORT_CMD_LIST_ON))
+		printf("port %d: command list DMA does not stop\n", port);
+
+	writel(readl(port_mmio + PORT_SCR_ERR), port_mmio + PORT_SCR_ERR);
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+
+	if (readl(port_mmio + PORT_TFDATA) & (ATA_STAT_BUSY | ATA_STAT_DRQ)) {
+		writel_with_flush(tmp | PORT_CMD_CLO, port_mmio + PORT_CMD);
+		waiting_for_cmd_completed(port_mmio + PORT_CMD, 500,
+					  PORT_CMD_CLO);
+	}
+	writel_with_flush(tmp | PORT_CMD_START, port_mmio + PORT_CMD);
+
+	log = malloc(ATA_BLOCKSIZE);
+	if (!log)
+		return;
+	memset(fis, 0, 20);
+	fis[0] = 0x27;		/* Host to device FIS. */
+	fis[1] = 1 << 7;	/* Command FIS. */
+	fis[2] = ATA_CMD_RD_LOG_EXT;
+	fis[4] = 0x10;		/* NCQ command error log */
+	fis[12] = 1;
+	if (get_ahci_device_data(port, fis, 20, log, ATA_BLOCKSIZE, 0))
+		printf("port %d: cannot read NCQ error log\n", port);
+	free(log);
+}
+
+
+/*
+ * Use native command queueing if both the controller and the drive can
+ * do it; the slot count is bounded by both and CONFIG_AHCI_NCQ_SLOTS.
+ */
+static void ahci_setup_ncq(u8 port)
+{
+	struct ahci_ioports *pp = &(probe_ent->port[port]);
+	hd_driveid_t *id = ataid[port];
+	u16 sata_cap = le16_to_cpu(id->words76_79[0]);
+	u32 slots;
+
+	pp->ncq_slots = 0;
+	if (!(probe_ent->cap & HOST_CAP_NCQ) || sata_cap == 0xffff ||
+	    !(sata_cap & (1 << 8)) || !ahci_id_has_lba48(id))
+		return;
+
+	slots = (le16_to_cpu(id->queue_depth) & 0x1f) + 1;
+	if (slots > HOST_CAP_NCS(probe_ent->cap))
+		slots = HOST_CAP_NCS(probe_ent->cap);
+	if (slots > CONFIG_AHCI_NCQ_SLOTS)
+		slots = CONFIG_AHCI_NCQ_SLOTS;
+	if (slots > 1)
+		pp->ncq_slots = slots;
+	debug("port %d: %d NCQ slots\n", port, pp->ncq_slots);
+}
+
+
+/* Queued commands smaller than this are not worth splitting a request */
+#define AHCI_NCQ_MIN_SECTORS	128
+
+/*
+ * Split a transfer into one READ/WRITE FPDMA QUEUED command per slot and
+ * issue them all at once.  On failure the port is restarted and NCQ is
+ * turned off for it, the caller then retries without queueing.
+ */
+static int ahci_ncq_rw(u8 port, u32 lba, u32 count, u8 *buf, int is_write)
+{
+	struct ahci_ioports *pp = &(probe_ent->port[port]);
+	volatile u8 *port_mmio = (volatile u8 *)pp->port_mmio;
+	u32 chunk, n, mask, stat;
+	struct wait_backoff wb;
+	int tag, sg_count, timeout;
+	u8 *fis;
+
+	chunk = (count + pp->ncq_slots - 1) / pp->ncq_slots;
+	if (chunk < AHCI_NCQ_MIN_SECTORS)
+		chunk = AHCI_NCQ_MIN_SECTORS;
+
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+	timeout = ahci_cmd_timeout(count * ATA_BLOCKSIZE);
+
+	mask = 0;
+	for (tag = 0; count; tag++) {
+		n = count < chunk ? count : chunk;
+
+		fis = (u8 *)ahci_cmd_tbl(pp, tag);
+		memset(fis, 0, 20);
+		fis[0] = 0x27;		/* Host to device FIS. */
+		fis[1] = 1 << 7;	/* Command FIS. */
+		fis[2] = is_write ? ATA_CMD_WR_FPDMA : ATA_CMD_RD_FPDMA;
+		fis[3] = n & 0xff;	/* the sector count is in FEATURES */
+		fis[4] = lba & 0xff;
+		fis[5] = (lba >> 8) & 0xff;
+		fis[6] = (lba >> 16) & 0xff;
+		fis[7] = 1 << 6;	/* LBA mode */
+		fis[8] = (lba >> 24) & 0xff;
+		fis[11] = (n >> 8) & 0xff;
+		fis[12] = tag << 3;
+
+		sg_count = ahci_fill_sg((struct ahci_sg *)(ahci_cmd_tbl(pp, tag)
+					+ AHCI_CMD_TBL_HDR), buf,
+					n * ATA_BLOCKSIZE);
+		if (sg_count < 0)
+			return -1;
+		ahci_fill_cmd_slot(pp, tag, 5 | (sg_count << 16) |
+				   (is_write ? AHCI_CMD_WRITE : 0));
+		mask |= 1 << tag;
+
+		lba += n;
+		buf += n * ATA_BLOCKSIZE;
+		count -= n;
+	}
+
+	writel_with_flush(mask, port_mmio + PORT_SCR_ACT);
+	writel_with_flush(mask, port_mmio + PORT_CMD_ISSUE);
+
+	wait_backoff_start(&wb, timeout);
+	do {
+		stat = readl(port_mmio + PORT_IRQ_STAT);
+		if (stat & (PORT_IRQ_FATAL))
+			break;
+		if (!(readl(port_mmio + PORT_SCR_ACT) & mask) &&
+		    !(readl(port_mmio + PORT_CMD_ISSUE) & mask))
+			return 0;
+	} while (!wait_backoff(&wb));
+
+	printf("port %d: queued %s failed (irq stat %#x), disabling NCQ\n",
+	       port, is_write ? "write" : "read", stat);
+	ahci_port_restart(port);
+	pp->ncq_slots = 0;
+	return -1;
+}
+
+
 static char *ata_id_strcpy(u16 *target, u16 *src, int len)
 {
 	int i;
@@ -538,7 +700,7 @@ static int ata_scsiop_inquiry(ccb *pccb)
 		return -ENOMEM;
 
 	if (get_ahci_device_data(port, (u8 *) & fis, 20,
-				 tmpid, sizeof(hd_driveid_t))) {
+				 tmpid, sizeof(hd_driveid_t), 0)) {
 		debug("scsi_ahci: SCSI inquiry command failure.\n");
 		return -EIO;
 	}
@@ -552,18 +714,24 @@ static int ata_scsiop_inquiry(ccb *pccb)
 	ata_id_strcpy((u16 *) &pccb->pdata[32], (u16 *)ataid[port]->fw_rev, 4);
 
 	dump_ataid(ataid[port]);
+	ahci_setup_ncq(port);
 	return 0;
 }
 
 
 /*
- * SCSI READ10 command operation.
+ * SCSI READ10 and WRITE10 command operation.
  */
-static int ata_scsiop_read10(ccb * pccb)
+static int ata_scsiop_read_write10(ccb *pccb, int is_write)
 {
-	u32 len = 0;
+	struct ahci_ioports *pp = &(probe_ent->port[pccb->target]);
+	int lba48 = ahci_id_has_lba48(ataid[pccb->target]);
+	u32 lba, len, n;
+	u8 *buf = pccb->pdata;
 	u8 fis[20];
 
+	lba = (((u32) pccb->cmd[2]) << 24) | (((u32) pccb->cmd[3]) << 16) |
+	      (((u32) pccb->cmd[4]) << 8) | ((u32) pccb->cmd[5]);
 	len = (((u32) pccb->cmd[7]) << 8) | ((u32) pccb->cmd[8]);
 
 	/* For 10-byte and 16-byte SCSI R/W commands, transfer
@@ -575,28 +743,48 @@ static int ata_scsiop_read10(ccb * pccb)
 	 */
 	if (!len)
 		return 0;
-	memset(fis, 0, 20);
 
-	/* Construct the FIS */
-	fis[0] = 0x27;		/* Host to device FIS. */
-	fis[1] = 1 << 7;	/* Command FIS. */
-	fis[2] = ATA_CMD_RD_DMA;	/* Command byte. */
-
-	/* LBA address, only support LBA28 in this driver */
-	fis[4] = pccb->cmd[5];
-	fis[5] = pccb->cmd[4];
-	fis[6] = pccb->cmd[3];
-	fis[7] = (pccb->cmd[2] & 0x0f) | 0xe0;
-
-	/* Sector Count */
-	fis[12] = pccb->cmd[8];
-	fis[13] = pccb->cmd[7];
-
-	/* Read from ahci */
-	if (get_ahci_device_data(pccb->target, (u8 *) & fis, 20,
-				 pccb->pdata, pccb->datalen)) {
-		debug("scsi_ahci: SCSI READ10 command failure.\n");
-		return -EIO;
+	if (pp->ncq_slots &&
+	    !ahci_ncq_rw(pccb->target, lba, len, buf, is_write))
+		return 0;
+
+	while (len) {
+		/* LBA28 commands move at most 256 sectors */
+		n = (lba48 || len < 256) ? len : 256;
+
+		memset(fis, 0, 20);
+
+		/* Construct the FIS */
+		fis[0] = 0x27;		/* Host to device FIS. */
+		fis[1] = 1 << 7;	/* Command FIS. */
+		fis[4] = lba & 0xff;
+		fis[5] = (lba >> 8) & 0xff;
+		fis[6] = (lba >> 16) & 0xff;
+		if (lba48) {
+			fis[2] = is_write ? ATA_CMD_WR_DMA_EXT
+					  : ATA_CMD_RD_DMA_EXT;
+			fis[7] = 1 << 6;	/* LBA mode */
+			fis[8] = (lba >> 24) & 0xff;
+		} else {
+			fis[2] = is_write ? ATA_CMD_WR_DMA : ATA_CMD_RD_DMA;
+			fis[7] = ((lba >> 24) & 0x0f) | 0xe0;
+		}
+
+		/* Sector Count */
+		fis[12] = n & 0xff;
+		if (lba48)
+			fis[13] = (n >> 8) & 0xff;
+
+		if (get_ahci_device_data(pccb->target, (u8 *) & fis, 20,
+					 buf, n * ATA_BLOCKSIZE, is_write)) {
+			debug("scsi_ahci: SCSI %s10 command failure.\n",
+			      is_write ? "WRITE" : "READ");
+			return -EIO;
+		}
+
+		lba += n;
+		buf += n * ATA_BLOCKSIZE;
+		len -= n;
 	}
 
 	return 0;
@@ -617,7 +805,19 @@ static int ata_scsiop_read_capacity10(ccb *pccb)
 		return -EPERM;
 	}
 
-	cap = le32_to_cpu(ataid[pccb->target]->lba_capacity);
+	if (ahci_id_has_lba48(ataid[pccb->target])) {
+		hd_driveid_t *id = ataid[pccb->target];
+		u64 cap48;
+
+		cap48 = ((u64)le16_to_cpu(id->lba48_capacity[3]) << 48) |
+			((u64)le16_to_cpu(id->lba48_capacity[2]) << 32) |
+			((u64)le16_to_cpu(id->lba48_capacity[1]) << 16) |
+			le16_to_cpu(id->lba48_capacity[0]);
+		cap = cap48 > 0xffffffff ? 0xffffffff : cap48;
+	} else {
+		cap = le32_to_cpu(ataid[pccb->target]->lba_capacity);
+	}
+	cap = cpu_to_be32(cap);
 	memcpy(pccb->pdata, &cap, sizeof(cap));
 
 	pccb->pdata[4] = pccb->pdata[5] = 0;
@@ -643,7 +843,10 @@ int scsi_exec(ccb *pccb)
 
 	switch (pccb->cmd[0]) {
 	case SCSI_READ10:
-		ret = ata_scsiop_read10(pccb);
+		ret = ata_scsiop_read_write10(pccb, 0);
+		break;
+	case SCSI_WRITE10:
+		ret = ata_scsiop_read_write10(pccb, 1);
 		break;
 	case SCSI_RD_CAPAC:
 		ret = ata_scsiop_read_capacity10(pccb);
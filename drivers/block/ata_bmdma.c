@@ -0,0 +1,108 @@
+/*
+ * Bus master IDE DMA (SFF-8038i) helpers, shared by the PATA/SATA
+ * drivers that sit on a PCI IDE function.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <watchdog.h>
+#include <asm/io.h>
+#include <asm/byteorder.h>
+#include <ata.h>
+#include <ata_bmdma.h>
+
+struct bmdma_prd {
+	u32 addr;
+	u32 flags_len;
+};
+
+/* The table itself must not cross a 64 KiB boundary */
+static struct bmdma_prd bmdma_prd[BMDMA_PRD_ENTRIES]
+	__attribute__((aligned(BMDMA_PRD_ENTRIES * sizeof(struct bmdma_prd))));
+
+int ata_bmdma_udma_mode(const hd_driveid_t *id, int max_mode, int cable80)
+{
+	int mode;
+
+	if (!(id->field_valid & 0x04))		/* word 88 not valid */
+		return -1;
+
+	/* Above UDMA2 both ends must agree on an 80 wire cable */
+	if ((!cable80 || !(id->hw_config & 0x2000)) && max_mode > 2)
+		max_mode = 2;
+
+	for (mode = max_mode; mode >= 0; mode--)
+		if (id->dma_ultra & (1 << mode))
+			return mode;
+	return -1;
+}
+
+int ata_bmdma_setup(ulong base, void *buf, ulong len)
+{
+	ulong addr = CONFIG_SYS_ATA_BMDMA_BUS(buf);
+	ulong size = len;
+	int i = 0;
+
+	if ((addr & 1) || (len & 1) || !len || len > BMDMA_MAX_XFER)
+		return -1;
+
+	/* Entries may not cross a 64 KiB boundary; a length of 0 is 64 KiB */
+	while (len) {
+		ulong n = 0x10000 - (addr & 0xffff);
+
+		if (n > len)
+			n = len;
+		bmdma_prd[i].addr = cpu_to_le32(addr);
+		bmdma_prd[i].flags_len = cpu_to_le32(n & 0xffff);
+		addr += n;
+		len -= n;
+		i++;
+	}
+	bmdma_prd[i - 1].flags_len |= cpu_to_le32(BMDMA_PRD_EOT);
+
+	flush_cache((ulong)bmdma_prd, sizeof(bmdma_prd));
+	/*
+	 * Write back and drop the buffer, so that nothing stale is left in
+	 * the cache once the device has written it.
+	 */
+	flush_cache((ulong)buf, size);
+
+	outb(0, base + BMDMA_CMD);
+	outb(inb(base + BMDMA_STATUS) | BMDMA_STAT_ERR | BMDMA_STAT_INTR,
+	     base + BMDMA_STATUS);
+	outl(CONFIG_SYS_ATA_BMDMA_BUS(bmdma_prd), base + BMDMA_PRD);
+	outb(BMDMA_CMD_TO_MEM, base + BMDMA_CMD);
+	return 0;
+}
+
+void ata_bmdma_start(ulong base)
+{
+	outb(BMDMA_CMD_TO_MEM | BMDMA_CMD_START, base + BMDMA_CMD);
+}
+
+int ata_bmdma_wait(ulong base, ulong timeout)
+{
+	ulong start = get_timer(0);
+	u8 status;
+
+	for (;;) {
+		status = inb(base + BMDMA_STATUS);
+		if (status & (BMDMA_STAT_INTR | BMDMA_STAT_ERR))
+			break;
+		if (get_timer(start) > timeout)
+			break;
+		WATCHDOG_RESET();
+	}
+
+	outb(BMDMA_CMD_TO_MEM, base + BMDMA_CMD);
+	outb(status | BMDMA_STAT_ERR | BMDMA_STAT_INTR,
+	     base + BMDMA_STATUS);
+
+	if ((status & BMDMA_STAT_ERR) || !(status & BMDMA_STAT_INTR))
+		return -1;
+	return 0;
+}
@@ -0,0 +1,268 @@
+/*
+ * Block device read cache
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * File systems and the partition code read the same few blocks over
+ * and over: the partition table, FAT sectors, ext2 group descriptors
+ * and indirect blocks.  Small reads are kept in a list of entries that
+ * is ordered by last use; once it is full the least recently used entry
+ * is recycled.  Large reads are not cached, they are file data that is
+ * rarely read twice and would only push the metadata out.
+ *
+ * File data is instead helped by readahead (CONFIG_BLOCK_READAHEAD):
+ * fatload and ext2load read a cluster or a file system block at a time,
+ * and on USB and SD the cost of each command dominates.  When a miss
+ * starts where the previous one on the device ended, a whole window of
+ * CONFIG_BLOCK_READAHEAD blocks is read with one call, and the following
+ * sequential requests are copied out of it.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <part.h>
+#include <blkcache.h>
+#include <linux/list.h>
+
+#ifndef CONFIG_BLOCK_CACHE_MAX_BLOCKS
+#define CONFIG_BLOCK_CACHE_MAX_BLOCKS	8
+#endif
+#ifndef CONFIG_BLOCK_CACHE_ENTRIES
+#define CONFIG_BLOCK_CACHE_ENTRIES	32
+#endif
+
+struct block_cache_node {
+	struct list_head lh;
+	int iftype;
+	int dev;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	unsigned long blksz;
+	char *cache;
+};
+
+static LIST_HEAD(block_cache);
+
+#ifdef CONFIG_BLOCK_READAHEAD
+static struct {
+	int iftype;
+	int dev;
+	lbaint_t next;		/* where a sequential request would start */
+	int busy;		/* reading the window right now */
+	/* the window */
+	lbaint_t start;
+	lbaint_t blkcnt;
+	unsigned long blksz;
+	char *buf;
+	unsigned long size;	/* bytes allocated for buf */
+} ra = { .iftype = -1 };
+
+static int ra_window_read(int iftype, int dev, lbaint_t start,
+			  lbaint_t blkcnt, unsigned long blksz, void *buffer)
+{
+	if (ra.iftype != iftype || ra.dev != dev || ra.blksz != blksz ||
+	    !ra.blkcnt || start < ra.start ||
+	    start + blkcnt > ra.start + ra.blkcnt)
+		return 0;
+
+	memcpy(buffer, ra.buf + (start - ra.start) * blksz, blkcnt * blksz);
+	ra.next = start + blkcnt;
+	return 1;
+}
+
+int blkcache_readahead(block_dev_desc_t *desc, lbaint_t start,
+		       lbaint_t blkcnt, void *buffer)
+{
+	int seq;
+	lbaint_t n;
+
+	if (ra.busy)
+		return 0;
+
+	seq = ra.iftype == desc->if_type && ra.dev == desc->dev &&
+	      start == ra.next;
+	ra.iftype = desc->if_type;
+	ra.dev = desc->dev;
+	ra.next = start + blkcnt;
+
+	if (!seq || blkcnt >= CONFIG_BLOCK_READAHEAD ||
+	    start + blkcnt > desc->lba)
+		return 0;
+
+	n = min((lbaint_t)CONFIG_BLOCK_READAHEAD, desc->lba - start);
+	if (ra.size < n * desc->blksz) {
+		free(ra.buf);
+		ra.size = 0;
+		ra.buf = malloc(CONFIG_BLOCK_READAHEAD * desc->blksz);
+		if (!ra.buf)
+			return 0;
+		ra.size = CONFIG_BLOCK_READAHEAD * desc->blksz;
+	}
+
+	ra.blkcnt = 0;
+	ra.busy = 1;
+	n = desc->block_read(desc->dev, start, n, ra.buf);
+	ra.busy = 0;
+	debug("blkcache readahead: start %lu, count %lu\n", (ulong)start,
+	      (ulong)n);
+
+	ra.start = start;
+	ra.blkcnt = n;
+	ra.blksz = desc->blksz;
+
+	return ra_window_read(desc->if_type, desc->dev, start, blkcnt,
+			      desc->blksz, buffer);
+}
+#endif
+
+static struct block_cache_stats _stats = {
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_MAX_BLOCKS,
+	.max_entries = CONFIG_BLOCK_CACHE_ENTRIES,
+};
+
+static struct block_cache_node *cache_find(int iftype, int dev,
+					   lbaint_t start, lbaint_t blkcnt,
+					   unsigned long blksz)
+{
+	struct block_cache_node *node;
+
+	list_for_each_entry(node, &block_cache, lh) {
+		if (node->iftype == iftype && node->dev == dev &&
+		    node->blksz == blksz && node->start <= start &&
+		    node->start + node->blkcnt >= start + blkcnt) {
+			/* most recently used entries stay at the front */
+			if (block_cache.next != &node->lh) {
+				list_del(&node->lh);
+				list_add(&node->lh, &block_cache);
+			}
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+int blkcache_read(int iftype, int dev, lbaint_t start, lbaint_t blkcnt,
+		  unsigned long blksz, void *buffer)
+{
+	struct block_cache_node *node;
+
+#ifdef CONFIG_BLOCK_READAHEAD
+	if (!ra.busy && ra_window_read(iftype, dev, start, blkcnt, blksz,
+				       buffer)) {
+		++_stats.hits;
+		return 1;
+	}
+#endif
+	node = cache_find(iftype, dev, start, blkcnt, blksz);
+	if (node) {
+		memcpy(buffer, node->cache + (start - node->start) * blksz,
+		       blkcnt * blksz);
+		debug("blkcache hit: start %lu, count %lu\n",
+		      (ulong)start, (ulong)blkcnt);
+		++_stats.hits;
+		return 1;
+	}
+
+	debug("blkcache miss: start %lu, count %lu\n",
+	      (ulong)start, (ulong)blkcnt);
+	++_stats.misses;
+	return 0;
+}
+
+void blkcache_fill(int iftype, int dev, lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, const void *buffer)
+{
+	struct block_cache_node *node;
+	lbaint_t bytes = blkcnt * blksz;
+
+	if (!blkcnt || blkcnt > _stats.max_blocks_per_entry ||
+	    !_stats.max_entries)
+		return;
+
+	if (_stats.entries >= _stats.max_entries) {
+		/* recycle the least recently used entry */
+		node = list_entry(block_cache.prev, struct block_cache_node,
+				  lh);
+		list_del(&node->lh);
+		_stats.entries--;
+		if (node->blkcnt * node->blksz < bytes) {
+			free(node->cache);
+			node->cache = NULL;
+		}
+	} else {
+		node = malloc(sizeof(*node));
+		if (!node)
+			return;
+		node->cache = NULL;
+	}
+
+	if (!node->cache) {
+		node->cache = malloc(bytes);
+		if (!node->cache) {
+			free(node);
+			return;
+		}
+	}
+
+	node->iftype = iftype;
+	node->dev = dev;
+	node->start = start;
+	node->blkcnt = blkcnt;
+	node->blksz = blksz;
+	memcpy(node->cache, buffer, bytes);
+	list_add(&node->lh, &block_cache);
+	_stats.entries++;
+}
+
+void blkcache_invalidate(int iftype, int dev)
+{
+	struct block_cache_node *node, *n;
+
+#ifdef CONFIG_BLOCK_READAHEAD
+	if (ra.iftype == iftype && ra.dev == dev) {
+		ra.blkcnt = 0;
+		ra.iftype = -1;
+	}
+#endif
+
+	list_for_each_entry_safe(node, n, &block_cache, lh) {
+		if (node->iftype == iftype && node->dev == dev) {
+			list_del(&node->lh);
+			free(node->cache);
+			free(node);
+			_stats.entries--;
+		}
+	}
+}
+
+void blkcache_configure(unsigned blocks, unsigned entries)
+{
+	struct block_cache_node *node, *n;
+
+	if (blocks != _stats.max_blocks_per_entry ||
+	    entries != _stats.max_entries) {
+		/* drop everything, entries may be too small now */
+		list_for_each_entry_safe(node, n, &block_cache, lh) {
+			list_del(&node->lh);
+			free(node->cache);
+			free(node);
+		}
+		_stats.entries = 0;
+	}
+
+	_stats.max_blocks_per_entry = blocks;
+	_stats.max_entries = entries;
+	_stats.hits = 0;
+	_stats.misses = 0;
+}
+
+void blkcache_stats(struct block_cache_stats *stats)
+{
+	memcpy(stats, &_stats, sizeof(*stats));
+	_stats.hits = 0;
+	_stats.misses = 0;
+}
@@ -353,8 +353,9 @@ static void fsl_sata_dump_regs(fsl_sata_reg_t *reg)
 	printf("SYSPR:          %08x\n\r", in_be32(&reg->syspr));
 }
 
-static int fsl_ata_exec_ata_cmd(struct fsl_sata *sata, struct sata_fis_h2d *cfis,
-				int is_ncq, int tag, u8 *buffer, u32 len)
+/* Fill in the command descriptor and the command slot of a tag */
+static void fsl_ata_prep_cmd(struct fsl_sata *sata, struct sata_fis_h2d *cfis,
+			     int is_ncq, int tag, u8 *buffer, u32 len)
 {
 	cmd_hdr_entry_t *cmd_hdr;
 	cmd_desc_t *cmd_desc;
@@ -367,12 +368,6 @@ static int fsl_ata_exec_ata_cmd(struct fsl_sata *sata, struct sata_fis_h2d *cfis
 	fsl_sata_reg_t *reg = sata->reg_base;
 	int i;
 
-	/* Check xfer length */
-	if (len > SATA_HC_MAX_XFER_LEN) {
-		printf("max transfer length is 64MB\n\r");
-		return 0;
-	}
-
 	/* Setup the command descriptor */
 	cmd_desc = sata->cmd_desc + tag;
 
@@ -466,6 +461,35 @@ static int fsl_ata_exec_ata_cmd(struct fsl_sata *sata, struct sata_fis_h2d *cfis
 	/* PMP*/
 	val32 = (u32)(h2d->pm_port_c & 0x0f);
 	out_le32(&reg->cqpmp, val32);
+}
+
+/* Report and clear a command error */
+static void fsl_ata_cmd_error(struct fsl_sata *sata, int tag, u32 cer)
+{
+	fsl_sata_reg_t *reg = sata->reg_base;
+	u32 der;
+
+	fsl_sata_dump_sfis((struct sata_fis_d2h *)sata->cmd_desc[tag].sfis);
+	printf("CE at device\n\r");
+	fsl_sata_dump_regs(reg);
+	der = in_le32(&reg->der);
+	out_le32(&reg->cer, cer);
+	out_le32(&reg->der, der);
+}
+
+static int fsl_ata_exec_ata_cmd(struct fsl_sata *sata, struct sata_fis_h2d *cfis,
+				int is_ncq, int tag, u8 *buffer, u32 len)
+{
+	fsl_sata_reg_t *reg = sata->reg_base;
+	u32 val32;
+
+	/* Check xfer length */
+	if (len > SATA_HC_MAX_XFER_LEN) {
+		printf("max transfer length is 64MB\n\r");
+		return 0;
+	}
+
+	fsl_ata_prep_cmd(sata, cfis, is_ncq, tag, buffer, len);
 
 	/* Wait no active */
 	if (ata_wait_register(&reg->car, (1 << tag), 0, 10000))
@@ -487,15 +511,8 @@ static int fsl_ata_exec_ata_cmd(struct fsl_sata *sata, struct sata_fis_h2d *cfis
 
 	val32 = in_le32(&reg->cer);
 
-	if (val32) {
-		u32 der;
-		fsl_sata_dump_sfis((struct sata_fis_d2h *)cmd_desc->sfis);
-		printf("CE at device\n\r");
-		fsl_sata_dump_regs(reg);
-		der = in_le32(&reg->der);
-		out_le32(&reg->cer, val32);
-		out_le32(&reg->der, der);
-	}
+	if (val32)
+		fsl_ata_cmd_error(sata, tag, val32);
 
 	/* Clear complete flags */
 	val32 = in_le32(&reg->ccr);
@@ -665,19 +682,10 @@ static u32 fsl_sata_rw_cmd_ext(int dev, u32 start, u32 blkcnt, u8 *buffer, int i
 	return blkcnt;
 }
 
-u32 fsl_sata_rw_ncq_cmd(int dev, u32 start, u32 blkcnt, u8 *buffer, int is_write)
+static void fsl_sata_ncq_fis(struct sata_fis_h2d *cfis, u32 start, u32 blkcnt,
+			     int is_write)
 {
-	fsl_sata_t *sata = (fsl_sata_t *)sata_dev_desc[dev].priv;
-	struct sata_fis_h2d h2d, *cfis = &h2d;
-	int ncq_channel;
-	u64 block;
-
-	if (sata->lba48 != 1) {
-		printf("execute FPDMA command on non-LBA48 hard disk\n\r");
-		return -1;
-	}
-
-	block = (u64)start;
+	u64 block = (u64)start;
 
 	memset(cfis, 0, sizeof(struct sata_fis_h2d));
 
@@ -697,6 +705,20 @@ u32 fsl_sata_rw_ncq_cmd(int dev, u32 start, u32 blkcnt, u8 *buffer, int is_write
 	cfis->device = ATA_LBA;
 	cfis->features_exp = (blkcnt >> 8) & 0xff;
 	cfis->features = blkcnt & 0xff;
+}
+
+u32 fsl_sata_rw_ncq_cmd(int dev, u32 start, u32 blkcnt, u8 *buffer, int is_write)
+{
+	fsl_sata_t *sata = (fsl_sata_t *)sata_dev_desc[dev].priv;
+	struct sata_fis_h2d h2d, *cfis = &h2d;
+	int ncq_channel;
+
+	if (sata->lba48 != 1) {
+		printf("execute FPDMA command on non-LBA48 hard disk\n\r");
+		return -1;
+	}
+
+	fsl_sata_ncq_fis(cfis, start, blkcnt, is_write);
 
 	if (sata->queue_depth >= SATA_HC_MAX_CMD)
 		ncq_channel = SATA_HC_MAX_CMD - 1;
@@ -708,6 +730,72 @@ u32 fsl_sata_rw_ncq_cmd(int dev, u32 start, u32 blkcnt, u8 *buffer, int is_write
 	return blkcnt;
 }
 
+#ifndef CONFIG_SYS_FSL_SATA_NCQ_BLKS
+#define CONFIG_SYS_FSL_SATA_NCQ_BLKS	2048	/* 1MB per command */
+#endif
+
+/*
+ * Split a transfer into FPDMA commands and keep all the tags the drive
+ * supports busy with them: a new command is queued as soon as one has
+ * completed, so the drive always has the next data to fetch.  Returns
+ * blkcnt, or 0 if a command failed or timed out.
+ */
+static u32 fsl_sata_rw_ncq_queued(int dev, u32 start, u32 blkcnt, u8 *buffer,
+				  int is_write)
+{
+	fsl_sata_t *sata = (fsl_sata_t *)sata_dev_desc[dev].priv;
+	fsl_sata_reg_t *reg = sata->reg_base;
+	struct sata_fis_h2d h2d;
+	u32 total = blkcnt, busy = 0, done, cer, blks;
+	int depth, tag;
+	ulong last;
+
+	depth = min(sata->queue_depth, SATA_HC_MAX_CMD);
+	last = get_timer(0);
+	while (blkcnt || busy) {
+		for (tag = 0; tag < depth && blkcnt; tag++) {
+			if (busy & (1 << tag))
+				continue;
+
+			blks = min(blkcnt, CONFIG_SYS_FSL_SATA_NCQ_BLKS);
+			fsl_sata_ncq_fis(&h2d, start, blks, is_write);
+			fsl_ata_prep_cmd(sata, &h2d, 1, tag, buffer,
+					 ATA_SECT_SIZE * blks);
+			out_le32(&reg->cqr, 1 << tag);
+			busy |= 1 << tag;
+
+			start += blks;
+			blkcnt -= blks;
+			buffer += ATA_SECT_SIZE * blks;
+		}
+
+		cer = in_le32(&reg->cer);
+		if (cer) {
+			fsl_ata_cmd_error(sata, ffs(cer) - 1, cer);
+			break;
+		}
+
+		done = in_le32(&reg->ccr) & busy;
+		if (done) {
+			out_le32(&reg->ccr, done);
+			busy &= ~done;
+			last = get_timer(0);
+		} else if (get_timer(last) > 10000) {
+			printf("NCQ command time out\n\r");
+			break;
+		}
+	}
+
+	if (busy) {
+		/* let the queue drain before the tags are used again */
+		ata_wait_register(&reg->car, busy, 0, 10000);
+		out_le32(&reg->ccr, in_le32(&reg->ccr));
+		return 0;
+	}
+
+	return total;
+}
+
 void fsl_sata_flush_cache_ext(int dev)
 {
 	fsl_sata_t *sata = (fsl_sata_t *)sata_dev_desc[dev].priv;
@@ -764,6 +852,10 @@ u32 ata_low_level_rw_lba48(int dev, u32 blknr, u32 blkcnt, void *buffer, int is_
 	u8 *addr;
 	int max_blks;
 
+	if (((fsl_sata_t *)sata_dev_desc[dev].priv)->ncq)
+		return fsl_sata_rw_ncq_queued(dev, blknr, blkcnt, buffer,
+					      is_write);
+
 	start = blknr;
 	blks = blkcnt;
 	addr = (u8 *)buffer;
@@ -902,6 +994,14 @@ int scan_sata(int dev)
 	/* Get the NCQ queue depth from device */
 	sata->queue_depth = ata_id_queue_depth(id);
 
+	/* Queue the transfers on all the tags the drive supports */
+	sata->ncq = 0;
+#ifndef CONFIG_FSL_SATA_NCQ
+	if (fsl_sata_info[dev].flags == FLAGS_FPDMA)
+#endif
+		if (sata->lba48 && ata_id_has_ncq(id))
+			sata->ncq = 1;
+
 	/* Get the xfer mode from device */
 	fsl_sata_xfer_mode(dev, id);
 
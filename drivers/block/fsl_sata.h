@@ -319,6 +319,7 @@ typedef struct fsl_sata {
 	int		ata_device_type;	/* device type */
 	int		lba48;
 	int		queue_depth;		/* Max NCQ queue depth */
+	int		ncq;			/* queue FPDMA commands */
 	u16		pio;
 	u16		mwdma;
 	u16		udma;
@@ -0,0 +1,212 @@
+/*
+ * Sandbox block devices backed by files on the host
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * "host bind <dev> <file>" makes a disk image on the host available
+ * as block device "host" <dev>, for the partition code and the file
+ * systems.  Reads go through the block cache and readahead like those
+ * of a real interface, and every call to the device is counted, so
+ * that changes to the way the file systems read can be measured on a
+ * workstation: "host info" shows the number of reads and blocks.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+#include <blkcache.h>
+#include <load_hash.h>
+#include <os.h>
+#include <time_acct.h>
+#include <blkstats.h>
+
+#ifndef CONFIG_SYS_SANDBOX_BLOCK_DEVS
+#define CONFIG_SYS_SANDBOX_BLOCK_DEVS	4
+#endif
+
+#define HOST_BLOCK_SIZE		512
+
+struct host_block_dev {
+	block_dev_desc_t blk;
+	int fd;
+	char filename[64];
+	/* calls that reached the file */
+	unsigned long reads, read_blocks;
+	unsigned long writes, write_blocks;
+};
+
+static struct host_block_dev host_devs[CONFIG_SYS_SANDBOX_BLOCK_DEVS];
+
+static struct host_block_dev *host_find(int dev)
+{
+	if (dev < 0 || dev >= CONFIG_SYS_SANDBOX_BLOCK_DEVS ||
+	    host_devs[dev].blk.if_type != IF_TYPE_HOST)
+		return NULL;
+	return &host_devs[dev];
+}
+
+static unsigned long host_block_read(int dev, unsigned long start,
+				     lbaint_t blkcnt, void *buffer)
+{
+	struct host_block_dev *hd = host_find(dev);
+	unsigned long long t, s;
+	ssize_t len;
+
+	if (!hd || start + blkcnt > hd->blk.lba)
+		return 0;
+
+	if (blkcache_read(IF_TYPE_HOST, dev, start, blkcnt,
+			  HOST_BLOCK_SIZE, buffer) ||
+	    blkcache_readahead(&hd->blk, start, blkcnt, buffer)) {
+		load_hash_update((ulong)buffer, buffer,
+				 blkcnt * HOST_BLOCK_SIZE);
+		return blkcnt;
+	}
+
+	if (os_lseek(hd->fd, (off_t)start * HOST_BLOCK_SIZE,
+		     OS_SEEK_SET) < 0)
+		return 0;
+	t = time_acct_start();
+	s = blkstats_start();
+	len = os_read(hd->fd, buffer, blkcnt * HOST_BLOCK_SIZE);
+	blkstats_end(IF_TYPE_HOST, dev, BLKSTATS_READ, len > 0 ? len : 0, s);
+	time_acct_end(TIME_ACCT_BLOCK, t);
+	if (len != blkcnt * HOST_BLOCK_SIZE)
+		return 0;
+	hd->reads++;
+	hd->read_blocks += blkcnt;
+
+	load_hash_update((ulong)buffer, buffer, len);
+	blkcache_fill(IF_TYPE_HOST, dev, start, blkcnt, HOST_BLOCK_SIZE,
+		      buffer);
+	return blkcnt;
+}
+
+static unsigned long host_block_write(int dev, unsigned long start,
+				      lbaint_t blkcnt, const void *buffer)
+{
+	struct host_block_dev *hd = host_find(dev);
+	unsigned long long t, s;
+	ssize_t len;
+
+	if (!hd || start + blkcnt > hd->blk.lba)
+		return 0;
+
+	dev_invalidate(IF_TYPE_HOST, dev);
+	if (os_lseek(hd->fd, (off_t)start * HOST_BLOCK_SIZE,
+		     OS_SEEK_SET) < 0)
+		return 0;
+	t = time_acct_start();
+	s = blkstats_start();
+	len = os_write(hd->fd, buffer, blkcnt * HOST_BLOCK_SIZE);
+	blkstats_end(IF_TYPE_HOST, dev, BLKSTATS_WRITE, len > 0 ? len : 0, s);
+	time_acct_end(TIME_ACCT_BLOCK, t);
+	if (len != blkcnt * HOST_BLOCK_SIZE)
+		return 0;
+	hd->writes++;
+	hd->write_blocks += blkcnt;
+	return blkcnt;
+}
+
+int host_dev_bind(int dev, const char *filename)
+{
+	struct host_block_dev *hd;
+	block_dev_desc_t *blk;
+	off_t size;
+
+	if (dev < 0 || dev >= CONFIG_SYS_SANDBOX_BLOCK_DEVS)
+		return -1;
+	hd = &host_devs[dev];
+
+	if (hd->blk.if_type == IF_TYPE_HOST) {
+		os_close(hd->fd);
+		dev_invalidate(IF_TYPE_HOST, dev);
+	}
+	memset(hd, 0, sizeof(*hd));
+
+	hd->fd = os_open(filename, OS_O_RDWR);
+	if (hd->fd < 0) {
+		printf("host: cannot open %s\n", filename);
+		return -1;
+	}
+	size = os_lseek(hd->fd, 0, OS_SEEK_END);
+	if (size < HOST_BLOCK_SIZE) {
+		printf("host: %s is too small\n", filename);
+		os_close(hd->fd);
+		return -1;
+	}
+	strncpy(hd->filename, filename, sizeof(hd->filename) - 1);
+
+	blk = &hd->blk;
+	blk->if_type = IF_TYPE_HOST;
+	blk->dev = dev;
+	blk->part_type = PART_TYPE_UNKNOWN;
+	blk->type = DEV_TYPE_HARDDISK;
+	blk->lba = size / HOST_BLOCK_SIZE;
+	blk->blksz = HOST_BLOCK_SIZE;
+	strcpy(blk->vendor, "host");
+	strncpy(blk->product, filename, sizeof(blk->product) - 1);
+	strcpy(blk->revision, "1.0");
+	blk->block_read = host_block_read;
+	blk->block_write = host_block_write;
+	blk->priv = hd;
+
+	init_part(blk);
+	return 0;
+}
+
+block_dev_desc_t *host_get_dev(int dev)
+{
+	struct host_block_dev *hd = host_find(dev);
+
+	return hd ? &hd->blk : NULL;
+}
+
+static int do_host(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct host_block_dev *hd;
+	int dev;
+
+	if (argc == 4 && !strcmp(argv[1], "bind")) {
+		dev = simple_strtoul(argv[2], NULL, 10);
+		return host_dev_bind(dev, argv[3]) ? 1 : 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "info")) {
+		for (dev = 0; dev < CONFIG_SYS_SANDBOX_BLOCK_DEVS; dev++) {
+			hd = host_find(dev);
+			if (!hd)
+				continue;
+			printf("%d: %s, %lu blocks\n"
+			       "   %lu reads, %lu blocks; "
+			       "%lu writes, %lu blocks\n",
+			       dev, hd->filename, (ulong)hd->blk.lba,
+			       hd->reads, hd->read_blocks,
+			       hd->writes, hd->write_blocks);
+		}
+		return 0;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		for (dev = 0; dev < CONFIG_SYS_SANDBOX_BLOCK_DEVS; dev++) {
+			hd = &host_devs[dev];
+			hd->reads = hd->read_blocks = 0;
+			hd->writes = hd->write_blocks = 0;
+			blkcache_invalidate(IF_TYPE_HOST, dev);
+		}
+		return 0;
+	}
+
+	return cmd_usage(cmdtp);
+}
+
+U_BOOT_CMD(
+	host,	4,	0,	do_host,
+	"block devices backed by host files",
+	"bind <dev> <file> - make <file> block device host <dev>\n"
+	"host info - list the devices and their read and write counts\n"
+	"host reset - clear the counts and the block cache"
+);
@@ -51,15 +51,90 @@
  * The mapping for PCI IO-space.
  * NOTE this is the value for the sequoia board. Modify to suit.
  * #define CONFIG_SYS_PCI0_IO_SPACE   0xE8000000
+ *
+ * For UDMA reads through the bus master engine also define
+ * #define CONFIG_ATA_BMDMA
  */
 
 #include <common.h>
 #include <ata.h>
 #include <ide.h>
 #include <pci.h>
+#include <ata_bmdma.h>
 
 extern ulong ide_bus_offset[CONFIG_SYS_IDE_MAXBUS];
 
+#ifdef CONFIG_ATA_BMDMA
+extern ulong ide_bmdma_base[CONFIG_SYS_IDE_MAXBUS];
+
+static pci_dev_t sil680_dev = -1;
+#endif
+
+#ifdef CONFIG_ATA_BMDMA
+static void sil680_bmdma_init(pci_dev_t devbusfn)
+{
+	u32 bmdma;
+	u16 cmd;
+
+	pci_read_config_dword(devbusfn, PCI_BASE_ADDRESS_4, &bmdma);
+	bmdma &= 0xfffffffc;
+	if (!bmdma)
+		return;
+
+	pci_read_config_word(devbusfn, PCI_COMMAND, &cmd);
+	pci_write_config_word(devbusfn, PCI_COMMAND, cmd | PCI_COMMAND_MASTER);
+
+	ide_bmdma_base[0] = bmdma + CONFIG_SYS_PCI0_IO_SPACE;
+#if CONFIG_SYS_IDE_MAXBUS > 1
+	ide_bmdma_base[1] = bmdma + CONFIG_SYS_PCI0_IO_SPACE + 8;
+#endif
+	sil680_dev = devbusfn;
+}
+
+/* UDMA timing values, taken from the Linux driver */
+static const u16 sil680_udma_timing[2][7] = {
+	{ 0x2C, 0x1C, 0x14, 0x10, 0x0C, 0x08, 0x06 },	/* 100 MHz */
+	{ 0xAB, 0x5B, 0x4A, 0x1C, 0x10, 0x0C, 0x08 },	/* 133 MHz */
+};
+
+int ide_set_udma(int dev, const hd_driveid_t *id)
+{
+	int port = IDE_BUS(dev);
+	int unit = dev & 1;
+	int clk133, udma;
+	u8 cable, scsc, mode;
+	u16 ultra;
+
+	if (sil680_dev == -1)
+		return -1;
+
+	pci_read_config_byte(sil680_dev, 0xA0 + (port << 4), &cable);
+	pci_read_config_byte(sil680_dev, 0x8A, &scsc);
+	clk133 = (scsc & 0x30) ? 1 : 0;
+
+	udma = ata_bmdma_udma_mode(id, clk133 ? 6 : 5, cable & 0x01);
+	if (udma < 0)
+		return -1;
+
+	pci_read_config_byte(sil680_dev, 0x80 + 4 * port, &mode);
+	mode &= ~(0x03 << (unit * 4));
+	mode |= 0x03 << (unit * 4);
+	pci_write_config_byte(sil680_dev, 0x80 + 4 * port, mode);
+
+	pci_write_config_word(sil680_dev, (0xA8 + (port << 4)) | (unit << 1),
+			      0x10C1);
+
+	pci_read_config_word(sil680_dev, (0xAC + (port << 4)) | (unit << 1),
+			     &ultra);
+	ultra &= ~0x3F;
+	ultra |= sil680_udma_timing[clk133][udma];
+	pci_write_config_word(sil680_dev, (0xAC + (port << 4)) | (unit << 1),
+			      ultra);
+
+	return udma;
+}
+#endif /* CONFIG_ATA_BMDMA */
+
 int ide_preinit (void)
 {
 	int status;
@@ -98,6 +173,9 @@ int ide_preinit (void)
 		pci_write_config_dword(devbusfn, 0xB4, 0x62DD62DD);
 		pci_write_config_dword(devbusfn, 0xB8, 0x43924392);
 		pci_write_config_dword(devbusfn, 0xBC, 0x40094009);
+#ifdef CONFIG_ATA_BMDMA
+		sil680_bmdma_init(devbusfn);
+#endif
 	}
 	return (status);
 }
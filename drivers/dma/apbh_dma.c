@@ -501,18 +501,24 @@ static int mxs_dma_wait_complete(uint32_t timeout, unsigned int chan)
 }
 
 /*
- * Execute the DMA channel
+ * Start the DMA channel, without waiting for it to finish
  */
-int mxs_dma_go(int chan)
+int mxs_dma_start(int chan)
+{
+	mxs_dma_enable_irq(chan, 1);
+	return mxs_dma_enable(chan);
+}
+
+/*
+ * Wait for a DMA channel started by mxs_dma_start() and shut it down
+ */
+int mxs_dma_wait(int chan)
 {
 	uint32_t timeout = 10000;
 	int ret;
 
 	LIST_HEAD(tmp_desc_list);
 
-	mxs_dma_enable_irq(chan, 1);
-	mxs_dma_enable(chan);
-
 	/* Wait for DMA to finish. */
 	ret = mxs_dma_wait_complete(timeout, chan);
 
@@ -528,6 +534,15 @@ int mxs_dma_go(int chan)
 	return ret;
 }
 
+/*
+ * Execute the DMA channel
+ */
+int mxs_dma_go(int chan)
+{
+	mxs_dma_start(chan);
+	return mxs_dma_wait(chan);
+}
+
 /*
  * Initialize the DMA hardware
  */
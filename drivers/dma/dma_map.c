@@ -0,0 +1,89 @@
+/*
+ * Data cache maintenance around DMA transfers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <dma_map.h>
+
+#define DMA_LINE_START(p)	((ulong)(p) & ~(ARCH_DMA_MINALIGN - 1))
+#define DMA_LINE_END(p, len)	ALIGN((ulong)(p) + (len), ARCH_DMA_MINALIGN)
+
+void dma_map_range(const void *p, size_t len, unsigned int dir)
+{
+	if (!len)
+		return;
+
+	/*
+	 * Written back even when the device only writes the buffer: a
+	 * dirty line evicted during the transfer would overwrite the data.
+	 */
+	flush_dcache_range(DMA_LINE_START(p), DMA_LINE_END(p, len));
+}
+
+void dma_unmap_range(const void *p, size_t len, unsigned int dir)
+{
+	ulong start = (ulong)p, end = start + len;
+	ulong head = ALIGN(start, ARCH_DMA_MINALIGN);
+	ulong tail = end & ~(ARCH_DMA_MINALIGN - 1);
+
+	if (!len || !(dir & DMA_MAP_FROM_DEVICE))
+		return;
+
+	if (head >= tail) {
+		flush_dcache_range(DMA_LINE_START(p), DMA_LINE_END(p, len));
+		return;
+	}
+
+	/*
+	 * Drop the lines the CPU fetched ahead while the device was
+	 * writing.  Those it shares with other data are written back and
+	 * dropped instead, which is right unless the CPU wrote that data.
+	 */
+	if (start != head)
+		flush_dcache_range(DMA_LINE_START(start), head);
+	invalidate_dcache_range(head, tail);
+	if (end != tail)
+		flush_dcache_range(tail, tail + ARCH_DMA_MINALIGN);
+}
+
+int dma_bounce_start(struct dma_bounce *b, void *data, size_t len,
+		     unsigned int dir)
+{
+	b->user = b->buf = data;
+	b->len = len;
+	b->dir = dir;
+
+	if (len && (dir & DMA_MAP_FROM_DEVICE) &&
+	    (((ulong)data | len) & (ARCH_DMA_MINALIGN - 1))) {
+		b->buf = memalign(ARCH_DMA_MINALIGN,
+				  ALIGN(len, ARCH_DMA_MINALIGN));
+		if (!b->buf) {
+			debug("dma: no bounce buffer for %lu bytes\n",
+			      (ulong)len);
+			b->buf = data;
+			return -1;
+		}
+		if (dir & DMA_MAP_TO_DEVICE)
+			memcpy(b->buf, data, len);
+	}
+
+	dma_map_range(b->buf, len, dir);
+	return 0;
+}
+
+void dma_bounce_stop(struct dma_bounce *b)
+{
+	dma_unmap_range(b->buf, b->len, b->dir);
+
+	if (b->buf != b->user) {
+		memcpy(b->user, b->buf, b->len);
+		free(b->buf);
+		b->buf = b->user;
+	}
+}
@@ -0,0 +1,101 @@
+/*
+ * Memory to memory copies through a DMA engine
+ *
+ * Copies that the engines turn down are left to the caller, which
+ * does them with the CPU as it always has.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <watchdog.h>
+#include <dma.h>
+
+static struct dma_engine *dma_engines;
+static struct dma_engine *dma_busy;		/* copy in flight */
+static int dma_engines_probed;
+
+/*
+ * The CPU and board code register their engines from here.  This is
+ * done on the first copy, as the controllers are often set up before
+ * relocation, when nothing can be registered yet.
+ */
+static int __def_dma_init(void)
+{
+	return 0;
+}
+int cpu_dma_init(void) __attribute__((weak, alias("__def_dma_init")));
+int board_dma_init(void) __attribute__((weak, alias("__def_dma_init")));
+
+int dma_engine_register(struct dma_engine *dma)
+{
+	struct dma_engine **p = &dma_engines;
+
+	while (*p)
+		p = &(*p)->next;
+	dma->next = NULL;
+	*p = dma;
+
+	debug("dma: %s registered\n", dma->name);
+	return 0;
+}
+
+int dma_memcpy_start(void *dst, const void *src, size_t len)
+{
+	ulong d = (ulong)dst, s = (ulong)src;
+	struct dma_engine *dma;
+
+	if (!dma_engines_probed) {
+		dma_engines_probed = 1;
+		board_dma_init();
+		cpu_dma_init();
+	}
+
+	if (dma_busy || !len)
+		return -1;
+	if (d < s + len && s < d + len)
+		return -1;
+
+	for (dma = dma_engines; dma; dma = dma->next) {
+		if (len < dma->min_len)
+			continue;
+		if (!dma->coherent) {
+			flush_cache(s, len);
+			flush_cache(d, len);
+		}
+		if (dma->start(dma, d, s, len) == 0) {
+			dma_busy = dma;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+int dma_memcpy_wait(void)
+{
+	struct dma_engine *dma = dma_busy;
+	int ret;
+
+	if (!dma)
+		return 0;
+
+	while ((ret = dma->poll(dma)) == 0)
+		WATCHDOG_RESET();
+	dma_busy = NULL;
+
+	if (ret < 0) {
+		printf("dma: %s: copy failed\n", dma->name);
+		return -1;
+	}
+	return 0;
+}
+
+int dma_memcpy(void *dst, const void *src, size_t len)
+{
+	if (dma_memcpy_start(dst, src, len))
+		return -1;
+	return dma_memcpy_wait();
+}
@@ -29,6 +29,7 @@
 #include <common.h>
 #include <asm/io.h>
 #include <asm/fsl_dma.h>
+#include <dma.h>
 
 /* Controller can only transfer 2^26 - 1 bytes at a time */
 #define FSL_DMA_MAX_SIZE	(0x3ffffff)
@@ -77,8 +78,8 @@ static uint in_dma32(volatile unsigned *addr)
 #endif
 }
 
-static uint dma_check(void) {
-	volatile fsl_dma_t *dma = &dma_base->dma[0];
+static uint dma_check_chan(volatile fsl_dma_t *dma)
+{
 	uint status;
 
 	/* While the channel is busy, spin */
@@ -96,6 +97,11 @@ static uint dma_check(void) {
 	return status;
 }
 
+static uint dma_check(void)
+{
+	return dma_check_chan(&dma_base->dma[0]);
+}
+
 #if !defined(CONFIG_MPC83xx)
 void dma_init(void) {
 	volatile fsl_dma_t *dma = &dma_base->dma[0];
@@ -107,37 +113,47 @@ void dma_init(void) {
 }
 #endif
 
+/* Start one transfer of up to FSL_DMA_MAX_SIZE bytes */
+static void dma_xfer_chan(volatile fsl_dma_t *dma, phys_addr_t dest,
+			  phys_addr_t src, uint xfer_size)
+{
+	out_dma32(&dma->dar, (u32) (dest & 0xFFFFFFFF));
+	out_dma32(&dma->sar, (u32) (src & 0xFFFFFFFF));
+#if !defined(CONFIG_MPC83xx)
+	out_dma32(&dma->satr,
+		in_dma32(&dma->satr) | (u32)((u64)src >> 32));
+	out_dma32(&dma->datr,
+		in_dma32(&dma->datr) | (u32)((u64)dest >> 32));
+#endif
+	out_dma32(&dma->bcr, xfer_size);
+	dma_sync();
+
+	/* Prepare mode register */
+	out_dma32(&dma->mr, FSL_DMA_MR_DEFAULT);
+	dma_sync();
+
+	/* Start the transfer */
+	out_dma32(&dma->mr, FSL_DMA_MR_DEFAULT | FSL_DMA_MR_CS);
+	dma_sync();
+}
+
+static void dma_xfer(phys_addr_t dest, phys_addr_t src, uint xfer_size)
+{
+	dma_xfer_chan(&dma_base->dma[0], dest, src, xfer_size);
+}
+
 int dmacpy(phys_addr_t dest, phys_addr_t src, phys_size_t count) {
-	volatile fsl_dma_t *dma = &dma_base->dma[0];
 	uint xfer_size;
 
 	while (count) {
 		xfer_size = MIN(FSL_DMA_MAX_SIZE, count);
 
-		out_dma32(&dma->dar, (u32) (dest & 0xFFFFFFFF));
-		out_dma32(&dma->sar, (u32) (src & 0xFFFFFFFF));
-#if !defined(CONFIG_MPC83xx)
-		out_dma32(&dma->satr,
-			in_dma32(&dma->satr) | (u32)((u64)src >> 32));
-		out_dma32(&dma->datr,
-			in_dma32(&dma->datr) | (u32)((u64)dest >> 32));
-#endif
-		out_dma32(&dma->bcr, xfer_size);
-		dma_sync();
-
-		/* Prepare mode register */
-		out_dma32(&dma->mr, FSL_DMA_MR_DEFAULT);
-		dma_sync();
-
-		/* Start the transfer */
-		out_dma32(&dma->mr, FSL_DMA_MR_DEFAULT | FSL_DMA_MR_CS);
+		dma_xfer(dest, src, xfer_size);
 
 		count -= xfer_size;
 		src += xfer_size;
 		dest += xfer_size;
 
-		dma_sync();
-
 		if (dma_check())
 			return -1;
 	}
@@ -145,6 +161,64 @@ int dmacpy(phys_addr_t dest, phys_addr_t src, phys_size_t count) {
 	return 0;
 }
 
+#if defined(CONFIG_DMA_MEMCPY) && !defined(CONFIG_MPC83xx)
+/*
+ * dma_memcpy() engine: the copy runs in the background, poll() starts
+ * the next part of it whenever one is done.  The channel snoops the
+ * caches, see dma_init().
+ */
+static phys_addr_t fsl_dma_dest, fsl_dma_src;
+static phys_size_t fsl_dma_left;
+
+static void fsl_dma_next(void)
+{
+	uint xfer_size = MIN(FSL_DMA_MAX_SIZE, fsl_dma_left);
+
+	dma_xfer(fsl_dma_dest, fsl_dma_src, xfer_size);
+	fsl_dma_left -= xfer_size;
+	fsl_dma_src += xfer_size;
+	fsl_dma_dest += xfer_size;
+}
+
+static int fsl_dma_start(struct dma_engine *engine, ulong dst, ulong src,
+			 ulong len)
+{
+	fsl_dma_dest = virt_to_phys((void *)dst);
+	fsl_dma_src = virt_to_phys((void *)src);
+	fsl_dma_left = len;
+	fsl_dma_next();
+	return 0;
+}
+
+static int fsl_dma_poll(struct dma_engine *engine)
+{
+	volatile fsl_dma_t *dma = &dma_base->dma[0];
+
+	if (in_dma32(&dma->sr) & FSL_DMA_SR_CB)
+		return 0;
+	if (dma_check())
+		return -1;
+	if (!fsl_dma_left)
+		return 1;
+
+	fsl_dma_next();
+	return 0;
+}
+
+static struct dma_engine fsl_dma_engine = {
+	.name		= "fsl_dma",
+	.min_len	= CONFIG_SYS_DMA_MEMCPY_MIN,
+	.coherent	= 1,
+	.start		= fsl_dma_start,
+	.poll		= fsl_dma_poll,
+};
+
+int cpu_dma_init(void)
+{
+	return dma_engine_register(&fsl_dma_engine);
+}
+#endif
+
 /*
  * 85xx/86xx use dma to initialize SDRAM when !CONFIG_ECC_INIT_VIA_DDRCONTROLLER
  * while 83xx uses dma to initialize SDRAM when CONFIG_DDR_ECC_INIT_VIA_DMA
@@ -152,33 +226,81 @@ int dmacpy(phys_addr_t dest, phys_addr_t src, phys_size_t count) {
 #if ((!defined CONFIG_MPC83xx && defined(CONFIG_DDR_ECC) &&	\
 	!defined(CONFIG_ECC_INIT_VIA_DDRCONTROLLER)) ||		\
 	(defined(CONFIG_MPC83xx) && defined(CONFIG_DDR_ECC_INIT_VIA_DMA)))
-void dma_meminit(uint val, uint size)
+/* What a channel copies at a time, a power of 2 below FSL_DMA_MAX_SIZE */
+#define FSL_DMA_MEMINIT_CHUNK	(32 << 20)
+
+/* *last is the percentage shown, -1 before the first call */
+static void dma_meminit_progress(phys_size_t done, phys_size_t size,
+				 int *last)
+{
+	int pct;
+
+	/* just the large memories, initialized in a second or more */
+	if (size < (1ULL << 30))
+		return;
+
+	pct = (ulong)(done >> 20) * 100 / (ulong)(size >> 20);
+	if (pct == *last)
+		return;
+	if (*last < 0)
+		puts("ECC init:    ");
+	printf("\b\b\b\b%3d%%", pct);
+	if (pct == 100)
+		puts("\b\b\b\b\b\b\b\b\b\b\b\b\b\b"
+		     "              "
+		     "\b\b\b\b\b\b\b\b\b\b\b\b\b\b");
+	*last = pct;
+}
+
+/*
+ * 8K written by the CPU are doubled with one channel up to a chunk, then
+ * all channels copy that chunk over the rest of memory at the same time.
+ */
+void dma_meminit(uint val, phys_size_t size)
 {
 	uint *p = 0;
-	uint i = 0;
+	phys_size_t done, next;
+	uint xfer_size;
+	int i, busy, last = -1;
 
 	for (*p = 0; p < (uint *)(8 * 1024); p++) {
 		if (((uint)p & 0x1f) == 0)
 			ppcDcbz((ulong)p);
 
-		*p = (uint)CONFIG_MEM_INIT_VALUE;
+		*p = val;
 
 		if (((uint)p & 0x1c) == 0x1c)
 			ppcDcbf((ulong)p);
 	}
 
-	dmacpy(0x002000, 0, 0x002000); /* 8K */
-	dmacpy(0x004000, 0, 0x004000); /* 16K */
-	dmacpy(0x008000, 0, 0x008000); /* 32K */
-	dmacpy(0x010000, 0, 0x010000); /* 64K */
-	dmacpy(0x020000, 0, 0x020000); /* 128K */
-	dmacpy(0x040000, 0, 0x040000); /* 256K */
-	dmacpy(0x080000, 0, 0x080000); /* 512K */
-	dmacpy(0x100000, 0, 0x100000); /* 1M */
-	dmacpy(0x200000, 0, 0x200000); /* 2M */
-	dmacpy(0x400000, 0, 0x400000); /* 4M */
-
-	for (i = 1; i < size / 0x800000; i++)
-		dmacpy((0x800000 * i), 0, 0x800000);
+	for (done = 0x2000; done < FSL_DMA_MEMINIT_CHUNK && done < size;
+	     done <<= 1)
+		dmacpy(done, 0, MIN(done, size - done));
+
+	for (next = done; ; ) {
+		busy = 0;
+		for (i = 0; i < ARRAY_SIZE(dma_base->dma); i++) {
+			volatile fsl_dma_t *dma = &dma_base->dma[i];
+
+			if (in_dma32(&dma->mr) & FSL_DMA_MR_CS) {
+				if (in_dma32(&dma->sr) & FSL_DMA_SR_CB) {
+					busy++;
+					continue;
+				}
+				dma_check_chan(dma);
+			}
+			if (next < size) {
+				xfer_size = MIN(FSL_DMA_MEMINIT_CHUNK,
+						size - next);
+				dma_xfer_chan(dma, next, 0, xfer_size);
+				next += xfer_size;
+				busy++;
+			}
+		}
+		if (!busy)
+			break;
+		dma_meminit_progress(next, size, &last);
+	}
+	dma_meminit_progress(size, size, &last);
 }
 #endif
@@ -93,6 +93,17 @@ int omap3_dma_start_transfer(uint32_t chan)
 	return 0;
 }
 
+/* Abort a transfer, e.g. when the device it serves failed */
+void omap3_dma_stop_transfer(uint32_t chan)
+{
+	if (check_channel(chan))
+		return;
+
+	writel(readl(&dma4_cfg->chan[chan].ccr) & ~CCR_ENABLE_ENABLE,
+		&dma4_cfg->chan[chan].ccr);
+	reset_irq(chan);
+}
+
 /* Busy-waiting for a DMA transfer
  * This has to be called before another transfer is started
  * PARAMETER
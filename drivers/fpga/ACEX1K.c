@@ -170,7 +170,15 @@ static int ACEX1K_ps_load(Altera_desc *desc, const void *buf, size_t bsize)
 		/* Get ready for the burn */
 		CONFIG_FPGA_DELAY ();
 
-		/* Load the data */
+		/* Load the data, all of it at once if the board can */
+		if (*fn->write) {
+			if (fpga_block_write (fn->write, data, bsize, cookie)) {
+				puts ("** Block write failed.\n");
+				(*fn->abort) (cookie);
+				return FPGA_FAIL;
+			}
+			bytecount = bsize;
+		}
 		while (bytecount < bsize) {
 			unsigned char val=0;
 #ifdef CONFIG_SYS_FPGA_CHECK_CTRLC
@@ -211,6 +211,28 @@ int altera_info( Altera_desc *desc )
 	return ret_val;
 }
 
+Altera_write_fn altera_get_write(Altera_desc *desc)
+{
+	if (!desc || !desc->iface_fns || desc->iface != passive_serial)
+		return NULL;
+
+	switch (desc->family) {
+	case Altera_ACEX1K:
+	case Altera_CYC2:
+		/* the same loader, whichever is configured, serves both */
+#if defined(CONFIG_FPGA_ACEX1K)
+		return ((Altera_ACEX1K_Passive_Serial_fns *)
+			desc->iface_fns)->write;
+#elif defined(CONFIG_FPGA_CYCLON2)
+		return ((Altera_CYC2_Passive_Serial_fns *)
+			desc->iface_fns)->write;
+#endif
+	default:
+		break;
+	}
+	return NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 
 static int altera_validate (Altera_desc * desc, const char *fn)
@@ -29,6 +29,8 @@
 #include <xilinx.h>             /* xilinx specific definitions */
 #include <altera.h>             /* altera specific definitions */
 #include <lattice.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
 
 #if 0
 #define FPGA_DEBUG              /* define FPGA_DEBUG to get debug messages */
@@ -209,6 +211,125 @@ int fpga_add( fpga_type devtype, void *desc )
 	return devnum;
 }
 
+#ifdef CONFIG_FPGA_GZIP
+#ifndef CONFIG_SYS_FPGA_GZ_CHUNK
+#define CONFIG_SYS_FPGA_GZ_CHUNK	(64 << 10)
+#endif
+
+/*
+ * While fpga_load_gz() runs a device loader, the loader's data pointer
+ * is the compressed file: fpga_block_write() unpacks it to the chunk
+ * buffer and passes it on a chunk at a time.
+ */
+static struct {
+	int active;
+	u8 *chunk;
+} fpga_gz;
+
+static int fpga_gz_write(fpga_bwr_fn bwr, size_t bsize, int cookie)
+{
+	size_t done = 0;
+	long n;
+
+	fpga_gz.active = 0;		/* there is only one pass */
+	while (done < bsize) {
+		n = gunzip_read(fpga_gz.chunk,
+				min(bsize - done, (size_t)CONFIG_SYS_FPGA_GZ_CHUNK));
+		if (n <= 0) {
+			printf("%s: compressed bitstream too short or corrupt\n",
+				__FUNCTION__);
+			return FPGA_FAIL;
+		}
+		done += n;
+		if ((*bwr)(fpga_gz.chunk, n, done == bsize, cookie))
+			return FPGA_FAIL;
+	}
+	return FPGA_SUCCESS;
+}
+
+/* Whether the device loader takes its data through a block write */
+static int fpga_has_block_write(fpga_desc *desc)
+{
+	switch (desc->devtype) {
+#if defined(CONFIG_FPGA_XILINX)
+	case fpga_xilinx:
+		return xilinx_get_bwr(desc->devdesc) != NULL;
+#endif
+#if defined(CONFIG_FPGA_ALTERA)
+	case fpga_altera:
+		return altera_get_write(desc->devdesc) != NULL;
+#endif
+	default:
+		return 0;
+	}
+}
+
+int fpga_load_gz(int devnum, const void *buf, size_t bsize,
+		 size_t skip, size_t len)
+{
+	int ret_val = FPGA_FAIL;
+	fpga_desc *desc = fpga_validate(devnum, buf, bsize,
+					(char *)__FUNCTION__);
+	long n;
+
+	if (!desc)
+		return FPGA_FAIL;
+	if (!fpga_has_block_write(desc)) {
+		printf("%s: device %d has no block write function to take"
+		       " a compressed bitstream\n", __FUNCTION__, devnum);
+		return FPGA_FAIL;
+	}
+	if (bsize < 18) {
+		printf("%s: bad compressed bitstream\n", __FUNCTION__);
+		return FPGA_FAIL;
+	}
+	/* all of the file unpacked, as the gzip trailer has it */
+	if (!len)
+		len = get_unaligned_le32((u8 *)buf + bsize - 4) - skip;
+
+	fpga_gz.chunk = malloc(CONFIG_SYS_FPGA_GZ_CHUNK);
+	if (!fpga_gz.chunk || gunzip_read_start(buf, bsize)) {
+		puts("Out of memory\n");
+		goto out;
+	}
+	while (skip) {
+		n = gunzip_read(fpga_gz.chunk,
+				min(skip, (size_t)CONFIG_SYS_FPGA_GZ_CHUNK));
+		if (n <= 0)
+			goto out;
+		skip -= n;
+	}
+
+	fpga_gz.active = 1;
+	ret_val = fpga_load(devnum, buf, len);
+	if (fpga_gz.active) {
+		/* the loader never asked for its data */
+		fpga_gz.active = 0;
+		ret_val = FPGA_FAIL;
+	}
+
+out:
+	gunzip_read_end();
+	free(fpga_gz.chunk);
+	fpga_gz.chunk = NULL;
+	return ret_val;
+}
+#endif /* CONFIG_FPGA_GZIP */
+
+/*
+ * Hand the data of a device loader to the board's block write
+ * function, unpacking them first while fpga_load_gz() runs
+ */
+int fpga_block_write(fpga_bwr_fn bwr, const void *buf, size_t bsize,
+		     int cookie)
+{
+#ifdef CONFIG_FPGA_GZIP
+	if (fpga_gz.active)
+		return fpga_gz_write(bwr, bsize, cookie);
+#endif
+	return (*bwr)(buf, bsize, TRUE, cookie);
+}
+
 /*
  *	Generic multiplexing code
  */
@@ -217,6 +338,13 @@ int fpga_load(int devnum, const void *buf, size_t bsize)
 	int ret_val = FPGA_FAIL;           /* assume failure */
 	fpga_desc * desc = fpga_validate( devnum, buf, bsize, (char *)__FUNCTION__ );
 
+#ifdef CONFIG_FPGA_GZIP
+	/* a gzip file, but not while fpga_load_gz() already runs this */
+	if (desc && !fpga_gz.active && bsize > 2 &&
+	    ((u8 *)buf)[0] == 0x1f && ((u8 *)buf)[1] == 0x8b)
+		return fpga_load_gz(devnum, buf, bsize, 0, 0);
+#endif
+
 	if ( desc ) {
 		switch ( desc->devtype ) {
 		case fpga_xilinx:
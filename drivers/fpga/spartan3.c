@@ -188,7 +188,15 @@ static int Spartan3_sp_load(Xilinx_desc *desc, const void *buf, size_t bsize)
 		(*fn->cs) (TRUE, TRUE, cookie); /* Assert chip select, commit */
 		(*fn->clk) (TRUE, TRUE, cookie);	/* Assert the clock pin */
 
-		/* Load the data */
+		/* Load the data, all of it at once if the board can */
+		if (*fn->bwr) {
+			if (fpga_block_write (fn->bwr, data, bsize, cookie)) {
+				puts ("** Block write failed.\n");
+				(*fn->abort) (cookie);	/* abort the burn */
+				return FPGA_FAIL;
+			}
+			bytecount = bsize;
+		}
 		while (bytecount < bsize) {
 			/* XXX - do we check for an Ctrl-C press in here ??? */
 			/* XXX - Check the error bit? */
@@ -389,9 +397,14 @@ static int Spartan3_ss_load(Xilinx_desc *desc, const void *buf, size_t bsize)
 		} while ((*fn->init) (cookie));
 
 		/* Load the data */
-		if(*fn->bwr)
-			(*fn->bwr) (data, bsize, TRUE, cookie);
-		else {
+		if(*fn->bwr) {
+			if (fpga_block_write (fn->bwr, data, bsize, cookie)) {
+				puts ("** Block write failed.\n");
+				if (*fn->abort)
+					(*fn->abort) (cookie);
+				return FPGA_FAIL;
+			}
+		} else {
 			while (bytecount < bsize) {
 
 				/* Xilinx detects an error if INIT goes low (active)
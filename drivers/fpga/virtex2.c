@@ -259,8 +259,18 @@ static int Virtex2_ssm_load(Xilinx_desc *desc, const void *buf, size_t bsize)
 		udelay (10000);
 
 		/*
-		 * Load the data byte by byte
+		 * Load the data, all of it at once if the board can,
+		 * or else byte by byte
 		 */
+		if (*fn->bwr) {
+			if (fpga_block_write (fn->bwr, data, bsize, cookie)) {
+				printf ("%s:%d: ** Block write failed\n",
+						__FUNCTION__, __LINE__);
+				(*fn->abort) (cookie);
+				return FPGA_FAIL;
+			}
+			bytecount = bsize;
+		}
 		while (bytecount < bsize) {
 #ifdef CONFIG_SYS_FPGA_CHECK_CTRLC
 			if (ctrlc ()) {
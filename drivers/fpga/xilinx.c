@@ -238,6 +238,36 @@ int xilinx_info (Xilinx_desc * desc)
 	return ret_val;
 }
 
+Xilinx_bwr_fn xilinx_get_bwr(Xilinx_desc *desc)
+{
+	if (!desc || !desc->iface_fns)
+		return NULL;
+
+	switch (desc->family) {
+	case Xilinx_Spartan2:
+		if (desc->iface == slave_parallel)
+			return ((Xilinx_Spartan2_Slave_Parallel_fns *)
+				desc->iface_fns)->bwr;
+		break;
+	case Xilinx_Spartan3:
+		if (desc->iface == slave_parallel)
+			return ((Xilinx_Spartan3_Slave_Parallel_fns *)
+				desc->iface_fns)->bwr;
+		if (desc->iface == slave_serial)
+			return ((Xilinx_Spartan3_Slave_Serial_fns *)
+				desc->iface_fns)->bwr;
+		break;
+	case Xilinx_Virtex2:
+		if (desc->iface == slave_selectmap)
+			return ((Xilinx_Virtex2_Slave_SelectMap_fns *)
+				desc->iface_fns)->bwr;
+		break;
+	default:
+		break;
+	}
+	return NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 
 static int xilinx_validate (Xilinx_desc * desc, char *fn)
@@ -145,15 +145,17 @@ void i2c_init(int speed, int slaveadd)
 		bus_initialized[current_bus] = 1;
 }
 
-static int i2c_read_byte(u8 devaddr, u8 regoffset, u8 *value)
+/* Reads len bytes from regoffset on in one transfer */
+static int i2c_read_bytes(u8 devaddr, u8 regoffset, u8 *value, int len)
 {
 	int i2c_error = 0;
+	int got = 0;
 	u16 status;
 
 	/* wait until bus not busy */
 	wait_for_bb();
 
-	/* one byte only */
+	/* the register offset only */
 	writew(1, &i2c_base->cnt);
 	/* set slave address */
 	writew(devaddr, &i2c_base->sa);
@@ -181,8 +183,8 @@ static int i2c_read_byte(u8 devaddr, u8 regoffset, u8 *value)
 
 	/* set slave address */
 	writew(devaddr, &i2c_base->sa);
-	/* read one byte from slave */
-	writew(1, &i2c_base->cnt);
+	/* read all bytes with a repeated start */
+	writew(len, &i2c_base->cnt);
 	/* need stop bit here */
 	writew(I2C_CON_EN | I2C_CON_MST |
 		I2C_CON_STT | I2C_CON_STP,
@@ -198,10 +200,12 @@ static int i2c_read_byte(u8 devaddr, u8 regoffset, u8 *value)
 		if (status & I2C_STAT_RRDY) {
 #if defined(CONFIG_OMAP243X) || defined(CONFIG_OMAP34XX) || \
 	defined(CONFIG_OMAP44XX)
-			*value = readb(&i2c_base->data);
+			u8 c = readb(&i2c_base->data);
 #else
-			*value = readw(&i2c_base->data);
+			u8 c = readw(&i2c_base->data);
 #endif
+			if (got < len)
+				value[got++] = c;
 			writew(I2C_STAT_RRDY, &i2c_base->stat);
 		}
 		if (status & I2C_STAT_ARDY) {
@@ -214,7 +218,7 @@ read_exit:
 	flush_fifo();
 	writew(0xFFFF, &i2c_base->stat);
 	writew(0, &i2c_base->cnt);
-	return i2c_error;
+	return i2c_error || got != len;
 }
 
 static void flush_fifo(void)
@@ -276,8 +280,6 @@ int i2c_probe(uchar chip)
 
 int i2c_read(uchar chip, uint addr, int alen, uchar *buffer, int len)
 {
-	int i;
-
 	if (alen > 1) {
 		printf("I2C read: addr len %d not supported\n", alen);
 		return 1;
@@ -288,12 +290,10 @@ int i2c_read(uchar chip, uint addr, int alen, uchar *buffer, int len)
 		return 1;
 	}
 
-	for (i = 0; i < len; i++) {
-		if (i2c_read_byte(chip, addr + i, &buffer[i])) {
-			printf("I2C read: I/O error\n");
-			i2c_init(CONFIG_SYS_I2C_SPEED, CONFIG_SYS_I2C_SLAVE);
-			return 1;
-		}
+	if (len && i2c_read_bytes(chip, addr, buffer, len)) {
+		printf("I2C read: I/O error\n");
+		i2c_init(CONFIG_SYS_I2C_SPEED, CONFIG_SYS_I2C_SLAVE);
+		return 1;
 	}
 
 	return 0;
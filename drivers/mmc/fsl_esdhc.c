@@ -35,6 +35,7 @@
 #include <mmc.h>
 #include <fsl_esdhc.h>
 #include <fdt_support.h>
+#include <dma_map.h>
 #include <asm/io.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -60,12 +61,74 @@ struct fsl_esdhc {
 	uint	wml;
 	char	reserved1[8];
 	uint	fevt;
-	char	reserved2[168];
+	uint	admaes;
+	uint	adsaddr;
+	char	reserved2[160];
 	uint	hostver;
 	char	reserved3[780];
 	uint	scr;
 };
 
+#ifdef CONFIG_FSL_ESDHC_ADMA
+/*
+ * ADMA2 descriptor table.  A length of 0 does not mean 64 KiB on every
+ * eSDHC, so each descriptor moves at most 127 blocks of 512 bytes.
+ */
+#ifndef CONFIG_FSL_ESDHC_ADMA_DESCS
+#define CONFIG_FSL_ESDHC_ADMA_DESCS	128
+#endif
+#define ESDHC_ADMA_MAX_LEN	0xfe00
+
+#define ESDHC_ADMA_VALID	0x0001
+#define ESDHC_ADMA_END		0x0002
+#define ESDHC_ADMA_ACT_TRAN	0x0020
+
+struct esdhc_adma_desc {
+	u16	attr;
+	u16	len;
+	u32	addr;
+};
+
+static struct esdhc_adma_desc adma_desc[CONFIG_FSL_ESDHC_ADMA_DESCS]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
+
+/*
+ * Describe the whole buffer in one descriptor chain, so the controller
+ * moves it without stopping at the SDMA buffer boundaries.
+ */
+static unsigned int esdhc_adma_setup(unsigned int addr, unsigned int len)
+{
+	struct esdhc_adma_desc *desc = adma_desc;
+	unsigned int n;
+
+	while (len) {
+		n = min(len, (unsigned int)ESDHC_ADMA_MAX_LEN);
+		desc->attr = cpu_to_le16(ESDHC_ADMA_VALID |
+					 ESDHC_ADMA_ACT_TRAN);
+		desc->len = cpu_to_le16(n);
+		desc->addr = cpu_to_le32(addr);
+		addr += n;
+		len -= n;
+		desc++;
+	}
+	desc[-1].attr |= cpu_to_le16(ESDHC_ADMA_END);
+
+	dma_map_range(adma_desc, sizeof(adma_desc), DMA_MAP_TO_DEVICE);
+	return (unsigned int)adma_desc;
+}
+
+static void *esdhc_dma_buf(struct mmc_data *data)
+{
+	return data->flags & MMC_DATA_READ ? data->dest : (void *)data->src;
+}
+
+static unsigned int esdhc_dma_dir(struct mmc_data *data)
+{
+	return data->flags & MMC_DATA_READ ?
+		DMA_MAP_FROM_DEVICE : DMA_MAP_TO_DEVICE;
+}
+#endif
+
 /* Return the XFERTYP flags for a given command and data packet */
 uint esdhc_xfertyp(struct mmc_cmd *cmd, struct mmc_data *data)
 {
@@ -199,6 +262,12 @@ static int esdhc_setup_data(struct mmc *mmc, struct mmc_data *data)
 					wml_value << 16);
 		esdhc_write32(&regs->dsaddr, (u32)data->src);
 	}
+#ifdef CONFIG_FSL_ESDHC_ADMA
+	esdhc_write32(&regs->adsaddr,
+		      esdhc_adma_setup((u32)esdhc_dma_buf(data),
+				       data->blocks * data->blocksize));
+	esdhc_clrsetbits32(&regs->proctl, PROCTL_DMAS_MASK, PROCTL_DMAS_ADMA2);
+#endif
 #else	/* CONFIG_SYS_FSL_ESDHC_USE_PIO */
 	if (!(data->flags & MMC_DATA_READ)) {
 		if ((esdhc_read32(&regs->prsstat) & PRSSTAT_WPSPL) == 0) {
@@ -291,6 +360,11 @@ esdhc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 		err = esdhc_setup_data(mmc, data);
 		if(err)
 			return err;
+#ifdef CONFIG_FSL_ESDHC_ADMA
+		dma_map_range(esdhc_dma_buf(data),
+			      data->blocks * data->blocksize,
+			      esdhc_dma_dir(data));
+#endif
 	}
 
 	/* Figure out the transfer arguments */
@@ -333,16 +407,29 @@ esdhc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 #ifdef CONFIG_SYS_FSL_ESDHC_USE_PIO
 		esdhc_pio_read_write(mmc, data);
 #else
+		int err = 0;
+
 		do {
 			irqstat = esdhc_read32(&regs->irqstat);
 
-			if (irqstat & IRQSTAT_DTOE)
-				return TIMEOUT;
+			if (irqstat & IRQSTAT_DTOE) {
+				err = TIMEOUT;
+				break;
+			}
 
-			if (irqstat & DATA_ERR)
-				return COMM_ERR;
+			if (irqstat & (DATA_ERR | IRQSTAT_DMAE)) {
+				err = COMM_ERR;
+				break;
+			}
 		} while (!(irqstat & IRQSTAT_TC) &&
 				(esdhc_read32(&regs->prsstat) & PRSSTAT_DLA));
+#ifdef CONFIG_FSL_ESDHC_ADMA
+		dma_unmap_range(esdhc_dma_buf(data),
+				data->blocks * data->blocksize,
+				esdhc_dma_dir(data));
+#endif
+		if (err)
+			return err;
 #endif
 	}
 
@@ -525,7 +612,16 @@ int fsl_esdhc_initialize(bd_t *bis, struct fsl_esdhc_cfg *cfg)
 	mmc->f_min = 400000;
 	mmc->f_max = MIN(gd->sdhc_clk, 52000000);
 
+#ifdef CONFIG_FSL_ESDHC_ADMA
+	if (!(caps & ESDHC_HOSTCAPBLT_ADMAS)) {
+		printf("eSDHC does not support ADMA2\n");
+		return -1;
+	}
+	/* one descriptor chain covers a whole request */
+	mmc->b_max = CONFIG_FSL_ESDHC_ADMA_DESCS * (ESDHC_ADMA_MAX_LEN / 512);
+#else
 	mmc->b_max = 0;
+#endif
 	mmc_register(mmc);
 
 	return 0;
@@ -31,6 +31,10 @@
 #include <malloc.h>
 #include <linux/list.h>
 #include <div64.h>
+#include <load_hash.h>
+#include <blkcache.h>
+#include <time_acct.h>
+#include <blkstats.h>
 
 /* Set block count limit because of 16 bit register limit on some hardware*/
 #ifndef CONFIG_SYS_MMC_MAX_BLK_COUNT
@@ -150,6 +154,10 @@ int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
 
+	/* the block length is fixed at 512 bytes in DDR mode */
+	if (mmc->timing == MMC_TIMING_MMC_DDR52)
+		return 0;
+
 	cmd.cmdidx = MMC_CMD_SET_BLOCKLEN;
 	cmd.resp_type = MMC_RSP_R1;
 	cmd.cmdarg = len;
@@ -175,11 +183,12 @@ struct mmc *find_mmc_device(int dev_num)
 	return NULL;
 }
 
-static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
+static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+			 uint arg)
 {
 	struct mmc_cmd cmd;
 	ulong end;
-	int err, start_cmd, end_cmd;
+	int err, start_cmd, end_cmd, timeout;
 
 	if (mmc->high_capacity)
 		end = start + blkcnt - 1;
@@ -213,13 +222,19 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
 		goto err_out;
 
 	cmd.cmdidx = MMC_CMD_ERASE;
-	cmd.cmdarg = SECURE_ERASE;
+	cmd.cmdarg = arg;
 	cmd.resp_type = MMC_RSP_R1b;
 
 	err = mmc_send_cmd(mmc, &cmd, NULL);
 	if (err)
 		goto err_out;
 
+	/* up to 300 ms for each erase group the range touches */
+	timeout = (blkcnt / mmc->erase_grp_size + 2) * 300;
+	err = mmc_send_status(mmc, timeout);
+	if (err)
+		goto err_out;
+
 	return 0;
 
 err_out:
@@ -227,34 +242,135 @@ err_out:
 	return err;
 }
 
-static unsigned long
-mmc_berase(int dev_num, unsigned long start, lbaint_t blkcnt)
+/* Largest range one erase command is given */
+#ifndef CONFIG_SYS_MMC_ERASE_MAX
+#define CONFIG_SYS_MMC_ERASE_MAX	(4 << 20)	/* blocks: 2 GiB */
+#endif
+
+/* Erases a range with arg in as few commands as possible */
+static lbaint_t mmc_erase_range(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+				uint arg)
+{
+	lbaint_t blk = 0, blk_r;
+
+	while (blk < blkcnt) {
+		blk_r = min(blkcnt - blk, (lbaint_t)CONFIG_SYS_MMC_ERASE_MAX);
+		if (mmc_erase_t(mmc, start + blk, blk_r, arg))
+			break;
+		if (arg == MMC_SECURE_TRIM1_ARG &&
+		    mmc_erase_t(mmc, start + blk, blk_r, MMC_SECURE_TRIM2_ARG))
+			break;
+		blk += blk_r;
+	}
+
+	return blk;
+}
+
+ulong mmc_erase_blocks(int dev_num, ulong start, lbaint_t blkcnt, uint arg)
 {
-	int err = 0;
 	struct mmc *mmc = find_mmc_device(dev_num);
-	lbaint_t blk = 0, blk_r = 0;
+	lbaint_t grp, head, mid, n;
+	uint need = 0;
 
 	if (!mmc)
-		return -1;
+		return 0;
 
-	if ((start % mmc->erase_grp_size) || (blkcnt % mmc->erase_grp_size))
-		printf("\n\nCaution! Your devices Erase group is 0x%x\n"
-			"The erase range would be change to 0x%lx~0x%lx\n\n",
-		       mmc->erase_grp_size, start & ~(mmc->erase_grp_size - 1),
-		       ((start + blkcnt + mmc->erase_grp_size)
-		       & ~(mmc->erase_grp_size - 1)) - 1);
+	if (start + blkcnt > mmc->block_dev.lba) {
+		printf("MMC: block number 0x%lx exceeds max(0x%lx)\n",
+		       start + blkcnt, mmc->block_dev.lba);
+		return 0;
+	}
 
-	while (blk < blkcnt) {
-		blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
-			mmc->erase_grp_size : (blkcnt - blk);
-		err = mmc_erase_t(mmc, start + blk, blk_r);
-		if (err)
-			break;
+	switch (arg) {
+	case MMC_ERASE_ARG:
+		break;
+	case MMC_TRIM_ARG:
+		need = MMC_ERASE_CAP_TRIM;
+		break;
+	case MMC_DISCARD_ARG:
+		need = MMC_ERASE_CAP_DISCARD;
+		break;
+	case MMC_SECURE_ERASE_ARG:
+		need = MMC_ERASE_CAP_SECURE;
+		break;
+	case MMC_SECURE_TRIM1_ARG:
+		need = MMC_ERASE_CAP_SECURE | MMC_ERASE_CAP_TRIM;
+		break;
+	default:
+		return 0;
+	}
+	if ((mmc->erase_caps & need) != need) {
+		puts("Card doesn't support this kind of erase\n");
+		return 0;
+	}
 
-		blk += blk_r;
+	dev_invalidate(IF_TYPE_MMC, dev_num);
+
+	grp = mmc->erase_grp_size;
+	if (arg == MMC_TRIM_ARG || arg == MMC_DISCARD_ARG ||
+	    arg == MMC_SECURE_TRIM1_ARG || grp <= 1)
+		return mmc_erase_range(mmc, start, blkcnt, arg);
+
+	/*
+	 * An erase takes whole groups: the aligned middle goes in one
+	 * command, the partial groups at the ends are trimmed if the
+	 * card can, erased as whole groups otherwise.
+	 */
+	head = min((lbaint_t)((grp - start % grp) % grp), blkcnt);
+	mid = (blkcnt - head) / grp * grp;
+
+	if (!(mmc->erase_caps & MMC_ERASE_CAP_TRIM) &&
+	    (head || blkcnt - head - mid)) {
+		printf("\n\nCaution! Your devices Erase group is 0x%lx\n"
+		       "The erase range would be change to 0x%lx~0x%lx\n\n",
+		       (ulong)grp, start / grp * grp,
+		       (start + blkcnt + grp - 1) / grp * grp - 1);
+		return mmc_erase_range(mmc, start, blkcnt, arg);
 	}
 
-	return blk;
+	n = 0;
+	if (head) {
+		n = mmc_erase_range(mmc, start, head, MMC_TRIM_ARG);
+		if (n != head)
+			return n;
+	}
+	if (mid) {
+		n += mmc_erase_range(mmc, start + head, mid, arg);
+		if (n != head + mid)
+			return n;
+	}
+	if (n < blkcnt)
+		n += mmc_erase_range(mmc, start + n, blkcnt - n, MMC_TRIM_ARG);
+	return n;
+}
+
+static unsigned long
+mmc_berase(int dev_num, unsigned long start, lbaint_t blkcnt)
+{
+	return mmc_erase_blocks(dev_num, start, blkcnt, MMC_ERASE_ARG);
+}
+
+/*
+ * Announces the length of the next multi-block transfer, after which
+ * the card goes back to the transfer state without a STOP_TRANSMISSION.
+ */
+static int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt, int write)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blkcnt & 0xffff;
+	if (write && mmc->rel_wr)
+		cmd.cmdarg |= MMC_SET_BLOCK_COUNT_RELIABLE;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.flags = 0;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
+static int mmc_use_cmd23(struct mmc *mmc, lbaint_t blkcnt)
+{
+	return mmc->cmd23 && blkcnt > 1 && blkcnt <= 0xffff;
 }
 
 static ulong
@@ -270,6 +386,11 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 		return 0;
 	}
 
+	if (mmc_use_cmd23(mmc, blkcnt) && mmc_set_block_count(mmc, blkcnt, 1)) {
+		printf("mmc fail to set block count\n");
+		return 0;
+	}
+
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
 	else
@@ -296,7 +417,10 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 	/* SPI multiblock writes terminate using a special
 	 * token, not a STOP_TRANSMISSION request.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (mmc_use_cmd23(mmc, blkcnt)) {
+		/* the card leaves the transfer state to program the data */
+		mmc_send_status(mmc, timeout);
+	} else if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -316,18 +440,27 @@ mmc_write_blocks(struct mmc *mmc, ulong start, lbaint_t blkcnt, const void*src)
 static ulong
 mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 {
-	lbaint_t cur, blocks_todo = blkcnt;
+	lbaint_t cur, n, blocks_todo = blkcnt;
+	unsigned long long t, s;
 
 	struct mmc *mmc = find_mmc_device(dev_num);
 	if (!mmc)
 		return 0;
 
+	dev_invalidate(IF_TYPE_MMC, dev_num);
+
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
 	do {
 		cur = (blocks_todo > mmc->b_max) ?  mmc->b_max : blocks_todo;
-		if(mmc_write_blocks(mmc, start, cur, src) != cur)
+		t = time_acct_start();
+		s = blkstats_start();
+		n = mmc_write_blocks(mmc, start, cur, src);
+		blkstats_end(IF_TYPE_MMC, dev_num, BLKSTATS_WRITE,
+			     n * mmc->write_bl_len, s);
+		time_acct_end(TIME_ACCT_BLOCK, t);
+		if (n != cur)
 			return 0;
 		blocks_todo -= cur;
 		start += cur;
@@ -343,6 +476,9 @@ int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start, lbaint_t blkcnt)
 	struct mmc_data data;
 	int timeout = 1000;
 
+	if (mmc_use_cmd23(mmc, blkcnt) && mmc_set_block_count(mmc, blkcnt, 0))
+		return 0;
+
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
 	else
@@ -364,7 +500,7 @@ int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start, lbaint_t blkcnt)
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !mmc_use_cmd23(mmc, blkcnt)) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -381,9 +517,14 @@ int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start, lbaint_t blkcnt)
 	return blkcnt;
 }
 
+static int mmc_complete_init(struct mmc *mmc);
+
 static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 {
-	lbaint_t cur, blocks_todo = blkcnt;
+	lbaint_t cur, n, blocks_todo = blkcnt;
+	unsigned long long t, s;
+	ulong first = start;
+	void *buf = dst;
 
 	if (blkcnt == 0)
 		return 0;
@@ -392,24 +533,47 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 	if (!mmc)
 		return 0;
 
+	if (mmc->init_in_progress && mmc_complete_init(mmc))
+		return 0;
+
 	if ((start + blkcnt) > mmc->block_dev.lba) {
 		printf("MMC: block number 0x%lx exceeds max(0x%lx)\n",
 			start + blkcnt, mmc->block_dev.lba);
 		return 0;
 	}
 
+	if (blkcache_read(IF_TYPE_MMC, dev_num, start, blkcnt,
+			  mmc->read_bl_len, dst)) {
+		load_hash_update((ulong)dst, dst, blkcnt * mmc->read_bl_len);
+		return blkcnt;
+	}
+
+	if (blkcache_readahead(&mmc->block_dev, start, blkcnt, dst)) {
+		load_hash_update((ulong)dst, dst, blkcnt * mmc->read_bl_len);
+		return blkcnt;
+	}
+
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
 		return 0;
 
 	do {
 		cur = (blocks_todo > mmc->b_max) ?  mmc->b_max : blocks_todo;
-		if(mmc_read_blocks(mmc, dst, start, cur) != cur)
+		t = time_acct_start();
+		s = blkstats_start();
+		n = mmc_read_blocks(mmc, dst, start, cur);
+		blkstats_end(IF_TYPE_MMC, dev_num, BLKSTATS_READ,
+			     n * mmc->read_bl_len, s);
+		time_acct_end(TIME_ACCT_BLOCK, t);
+		if (n != cur)
 			return 0;
+		load_hash_update((ulong)dst, dst, cur * mmc->read_bl_len);
 		blocks_todo -= cur;
 		start += cur;
 		dst += cur * mmc->read_bl_len;
 	} while (blocks_todo > 0);
 
+	blkcache_fill(IF_TYPE_MMC, dev_num, first, blkcnt, mmc->read_bl_len,
+		      buf);
 	return blkcnt;
 }
 
@@ -435,47 +599,98 @@ int mmc_go_idle(struct mmc* mmc)
 	return 0;
 }
 
-int
-sd_send_op_cond(struct mmc *mmc)
+/*
+ * The card accepted 1.8V signalling: send CMD11 and let the host switch
+ * its I/O lines.  If the card refuses, we just carry on at 3.3V; once
+ * the host has failed after CMD11 went through, the card needs a power
+ * cycle.
+ */
+static int sd_switch_voltage(struct mmc *mmc)
 {
-	int timeout = 1000;
+	struct mmc_cmd cmd;
 	int err;
+
+	cmd.cmdidx = SD_CMD_SWITCH_UHS18V;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+	cmd.flags = 0;
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	if (err) {
+		mmc->ocr &= ~OCR_S18R;
+		return 0;
+	}
+
+	err = mmc->set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_180);
+	if (err) {
+		printf("%s: switch to 1.8V signalling failed\n", mmc->name);
+		return UNUSABLE_ERR;
+	}
+
+	return 0;
+}
+
+/* One ACMD41; the card keeps powering up between the polls */
+static int sd_poll_op_cond(struct mmc *mmc)
+{
 	struct mmc_cmd cmd;
+	int err;
 
-	do {
-		cmd.cmdidx = MMC_CMD_APP_CMD;
-		cmd.resp_type = MMC_RSP_R1;
-		cmd.cmdarg = 0;
-		cmd.flags = 0;
+	cmd.cmdidx = MMC_CMD_APP_CMD;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+	cmd.flags = 0;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	err = mmc_send_cmd(mmc, &cmd, NULL);
 
-		if (err)
-			return err;
+	if (err)
+		return err;
 
-		cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
-		cmd.resp_type = MMC_RSP_R3;
+	cmd.cmdidx = SD_CMD_APP_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
 
-		/*
-		 * Most cards do not answer if some reserved bits
-		 * in the ocr are set. However, Some controller
-		 * can set bit 7 (reserved for low voltages), but
-		 * how to manage low voltages SD card is not yet
-		 * specified.
-		 */
-		cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
-			(mmc->voltages & 0xff8000);
+	/*
+	 * Most cards do not answer if some reserved bits
+	 * in the ocr are set. However, Some controller
+	 * can set bit 7 (reserved for low voltages), but
+	 * how to manage low voltages SD card is not yet
+	 * specified.
+	 */
+	cmd.cmdarg = mmc_host_is_spi(mmc) ? 0 :
+		(mmc->voltages & 0xff8000);
 
-		if (mmc->version == SD_VERSION_2)
-			cmd.cmdarg |= OCR_HCS;
+	if (mmc->version == SD_VERSION_2)
+		cmd.cmdarg |= OCR_HCS;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	/* ask for 1.8V signalling if the host can do UHS-I */
+	if (mmc->version == SD_VERSION_2 &&
+	    (mmc->host_caps & MMC_MODE_UHS))
+		cmd.cmdarg |= OCR_S18R;
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+
+	if (err)
+		return err;
+
+	mmc->ocr = cmd.response[0];
+	udelay(1000);
+
+	return 0;
+}
+
+/* Poll until the card has powered up, after the first sd_poll_op_cond() */
+static int sd_finish_op_cond(struct mmc *mmc)
+{
+	int timeout = 1000;
+	struct mmc_cmd cmd;
+	int err;
+
+	while (!(mmc->ocr & OCR_BUSY) && timeout--) {
+		err = sd_poll_op_cond(mmc);
 
 		if (err)
 			return err;
-
-		udelay(1000);
-	} while ((!(cmd.response[0] & OCR_BUSY)) && timeout--);
+	}
 
 	if (timeout <= 0)
 		return UNUSABLE_ERR;
@@ -493,19 +708,53 @@ sd_send_op_cond(struct mmc *mmc)
 
 		if (err)
 			return err;
-	}
 
-	mmc->ocr = cmd.response[0];
+		mmc->ocr = cmd.response[0];
+	}
 
 	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
 	mmc->rca = 0;
 
+	if (mmc_host_is_spi(mmc) || !(mmc->host_caps & MMC_MODE_UHS))
+		mmc->ocr &= ~OCR_S18R;
+	if (mmc->ocr & OCR_S18R)
+		return sd_switch_voltage(mmc);
+
 	return 0;
 }
 
-int mmc_send_op_cond(struct mmc *mmc)
+/* One CMD1, with the voltages and access mode of the last answer */
+static int mmc_poll_op_cond(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
+
+	cmd.cmdidx = MMC_CMD_SEND_OP_COND;
+	cmd.resp_type = MMC_RSP_R3;
+	cmd.cmdarg = (mmc_host_is_spi(mmc) ? 0 :
+			(mmc->voltages &
+			(mmc->ocr & OCR_VOLTAGE_MASK)) |
+			(mmc->ocr & OCR_ACCESS_MODE));
+
+	if (mmc->host_caps & MMC_MODE_HC)
+		cmd.cmdarg |= OCR_HCS;
+
+	cmd.flags = 0;
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+
+	if (err)
+		return err;
+
+	mmc->ocr = cmd.response[0];
+	udelay(1000);
+
+	return 0;
+}
+
+/* Ask the card its capabilities, then start its power-up */
+static int mmc_start_op_cond(struct mmc *mmc)
 {
-	int timeout = 10000;
 	struct mmc_cmd cmd;
 	int err;
 
@@ -523,28 +772,25 @@ int mmc_send_op_cond(struct mmc *mmc)
  	if (err)
  		return err;
 
+	mmc->ocr = cmd.response[0];
  	udelay(1000);
 
-	do {
-		cmd.cmdidx = MMC_CMD_SEND_OP_COND;
-		cmd.resp_type = MMC_RSP_R3;
-		cmd.cmdarg = (mmc_host_is_spi(mmc) ? 0 :
-				(mmc->voltages &
-				(cmd.response[0] & OCR_VOLTAGE_MASK)) |
-				(cmd.response[0] & OCR_ACCESS_MODE));
-
-		if (mmc->host_caps & MMC_MODE_HC)
-			cmd.cmdarg |= OCR_HCS;
+	/* the first CMD1 with a voltage window starts the power-up */
+	return mmc_poll_op_cond(mmc);
+}
 
-		cmd.flags = 0;
+static int mmc_finish_op_cond(struct mmc *mmc)
+{
+	int timeout = 10000;
+	struct mmc_cmd cmd;
+	int err;
 
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	while (!(mmc->ocr & OCR_BUSY) && timeout--) {
+		err = mmc_poll_op_cond(mmc);
 
 		if (err)
 			return err;
-
-		udelay(1000);
-	} while (!(cmd.response[0] & OCR_BUSY) && timeout--);
+	}
 
 	if (timeout <= 0)
 		return UNUSABLE_ERR;
@@ -559,10 +805,11 @@ int mmc_send_op_cond(struct mmc *mmc)
 
 		if (err)
 			return err;
+
+		mmc->ocr = cmd.response[0];
 	}
 
 	mmc->version = MMC_VERSION_UNKNOWN;
-	mmc->ocr = cmd.response[0];
 
 	mmc->high_capacity = ((mmc->ocr & OCR_HCS) == OCR_HCS);
 	mmc->rca = 0;
@@ -636,7 +883,7 @@ int mmc_change_freq(struct mmc *mmc)
 	if (err)
 		return err;
 
-	cardtype = ext_csd[EXT_CSD_CARD_TYPE] & 0xf;
+	cardtype = ext_csd[EXT_CSD_CARD_TYPE] & 0x3f;
 
 	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING, 1);
 
@@ -654,11 +901,17 @@ int mmc_change_freq(struct mmc *mmc)
 		return 0;
 
 	/* High Speed is set, there are two types: 52MHz and 26MHz */
-	if (cardtype & MMC_HS_52MHZ)
+	if (cardtype & MMC_HS_52MHZ) {
 		mmc->card_caps |= MMC_MODE_HS_52MHz | MMC_MODE_HS;
-	else
+		if (cardtype & EXT_CSD_CARD_TYPE_DDR_1_8V)
+			mmc->card_caps |= MMC_MODE_DDR_52MHz;
+	} else
 		mmc->card_caps |= MMC_MODE_HS;
 
+	/* 1.2V I/O is not supported, so only the 1.8V HS200 type counts */
+	if (cardtype & EXT_CSD_CARD_TYPE_HS200_1_8V)
+		mmc->card_caps |= MMC_MODE_HS200;
+
 	return 0;
 }
 
@@ -764,6 +1017,13 @@ retry_scr:
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
 
+#ifdef CONFIG_MMC_CMD23
+	if (mmc->scr[0] & SD_CMD23_SUPPORT)
+		mmc->cmd23 = 1;
+#endif
+	if (!(mmc->scr[0] & SD_DATA_STAT_AFTER_ERASE))
+		mmc->erase_caps |= MMC_ERASE_CAP_ZERO;
+
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
 		return 0;
@@ -781,6 +1041,18 @@ retry_scr:
 			break;
 	}
 
+	/* UHS-I modes are only on offer once the card runs at 1.8V */
+	if (mmc->ocr & OCR_S18R) {
+		uint support = __be32_to_cpu(switch_status[3]);
+
+		if (support & SD_UHS_SDR50_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_SDR50;
+		if (support & SD_UHS_SDR104_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_SDR104;
+		if (support & SD_UHS_DDR50_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_DDR50;
+	}
+
 	/* If high-speed isn't supported, we return */
 	if (!(__be32_to_cpu(switch_status[3]) & SD_HIGHSPEED_SUPPORTED))
 		return 0;
@@ -852,6 +1124,110 @@ void mmc_set_bus_width(struct mmc *mmc, uint width)
 	mmc_set_ios(mmc);
 }
 
+/*
+ * Switch to HS200 once the bus width has been chosen: select the timing,
+ * raise the clock and let the host tune its sampling point.  If tuning
+ * fails the card is taken back to high speed.
+ */
+static int mmc_select_hs200(struct mmc *mmc)
+{
+	int err;
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING,
+			 EXT_CSD_TIMING_HS200);
+	if (err)
+		return err;
+
+	mmc->timing = MMC_TIMING_MMC_HS200;
+	mmc_set_clock(mmc, 200000000);
+
+	if (!mmc->execute_tuning)
+		return 0;
+
+	err = mmc->execute_tuning(mmc, MMC_CMD_SEND_TUNING_BLOCK_HS200);
+	if (err) {
+		printf("%s: HS200 tuning failed, using high speed\n",
+			mmc->name);
+		mmc->timing = MMC_TIMING_MMC_HS;
+		mmc_set_clock(mmc, 52000000);
+		mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_HS_TIMING,
+			   EXT_CSD_TIMING_HS);
+	}
+
+	return err;
+}
+
+/* Switch a card running at high speed on a 4 or 8 bit bus to DDR */
+static int mmc_select_ddr52(struct mmc *mmc)
+{
+	int err;
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_BUS_WIDTH,
+			 mmc->bus_width == 8 ? EXT_CSD_BUS_WIDTH_8_DDR :
+			 EXT_CSD_BUS_WIDTH_4_DDR);
+	if (err)
+		return err;
+
+	mmc->timing = MMC_TIMING_MMC_DDR52;
+	mmc_set_ios(mmc);
+
+	return 0;
+}
+
+/*
+ * Select the fastest UHS-I access mode both sides support, once the bus
+ * is 4 bits wide.  Returns 0 if one was selected, and the clock is set.
+ */
+static int sd_select_uhs(struct mmc *mmc)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(uint, switch_status, 16);
+	uint mode, timing, clock;
+	int err;
+
+	if (!(mmc->card_caps & MMC_MODE_4BIT))
+		return -1;
+
+	if (mmc->card_caps & MMC_MODE_UHS_SDR104) {
+		mode = SD_ACCESS_MODE_SDR104;
+		timing = MMC_TIMING_UHS_SDR104;
+		clock = 208000000;
+	} else if (mmc->card_caps & MMC_MODE_UHS_SDR50) {
+		mode = SD_ACCESS_MODE_SDR50;
+		timing = MMC_TIMING_UHS_SDR50;
+		clock = 100000000;
+	} else if (mmc->card_caps & MMC_MODE_UHS_DDR50) {
+		mode = SD_ACCESS_MODE_DDR50;
+		timing = MMC_TIMING_UHS_DDR50;
+		clock = 50000000;
+	} else
+		return -1;
+
+	err = sd_switch(mmc, SD_SWITCH_SWITCH, 0, mode, (u8 *)switch_status);
+	if (err)
+		return err;
+	if ((__be32_to_cpu(switch_status[4]) & 0x0f000000) != mode << 24)
+		return -1;
+
+	mmc->timing = timing;
+	mmc_set_clock(mmc, clock);
+
+	/* DDR50 has no tuning, SDR50 is tuned only if the host wants */
+	if (timing == MMC_TIMING_UHS_DDR50 || !mmc->execute_tuning)
+		return 0;
+
+	err = mmc->execute_tuning(mmc, SD_CMD_SEND_TUNING_BLOCK);
+	if (err) {
+		printf("%s: UHS tuning failed, using high speed\n",
+			mmc->name);
+		mmc->timing = MMC_TIMING_SD_HS;
+		mmc_set_clock(mmc, 50000000);
+		sd_switch(mmc, SD_SWITCH_SWITCH, 0, SD_ACCESS_MODE_SDR25,
+			  (u8 *)switch_status);
+	}
+
+	return 0;
+}
+
 int mmc_startup(struct mmc *mmc)
 {
 	int err, width;
@@ -1002,6 +1378,15 @@ int mmc_startup(struct mmc *mmc)
 	 */
 	mmc->erase_grp_size = 1;
 	mmc->part_config = MMCPART_NOAVAILABLE;
+	mmc->rel_wr = 0;
+	mmc->cmd23 = 0;
+	mmc->erase_caps = 0;
+#ifdef CONFIG_MMC_CMD23
+	/* mandatory since MMC 3.1, SD cards say so in the SCR */
+	if (!IS_SD(mmc) && !mmc_host_is_spi(mmc) &&
+	    mmc->version >= MMC_VERSION_3)
+		mmc->cmd23 = 1;
+#endif
 	if (!IS_SD(mmc) && (mmc->version >= MMC_VERSION_4)) {
 		/* check  ext_csd version and capacity */
 		err = mmc_send_ext_csd(mmc, ext_csd);
@@ -1026,8 +1411,9 @@ int mmc_startup(struct mmc *mmc)
 		 * the group size from the csd value.
 		 */
 		if (ext_csd[EXT_CSD_ERASE_GROUP_DEF])
+			/* in 512 KiB units, the group size is in blocks */
 			mmc->erase_grp_size =
-			      ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 512 * 1024;
+			      ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
 		else {
 			int erase_gsz, erase_gmul;
 			erase_gsz = (mmc->csd[2] & 0x00007c00) >> 10;
@@ -1039,6 +1425,24 @@ int mmc_startup(struct mmc *mmc)
 		/* store the partition info of emmc */
 		if (ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & PART_SUPPORT)
 			mmc->part_config = ext_csd[EXT_CSD_PART_CONF];
+
+		if (ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN)
+			mmc->erase_caps |= MMC_ERASE_CAP_TRIM;
+		if (ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_ER_EN)
+			mmc->erase_caps |= MMC_ERASE_CAP_SECURE;
+		/* DISCARD came with 4.5 */
+		if ((mmc->erase_caps & MMC_ERASE_CAP_TRIM) &&
+		    ext_csd[EXT_CSD_REV] >= 6)
+			mmc->erase_caps |= MMC_ERASE_CAP_DISCARD;
+		if (!ext_csd[EXT_CSD_ERASED_MEM_CONT])
+			mmc->erase_caps |= MMC_ERASE_CAP_ZERO;
+
+#ifdef CONFIG_MMC_RELIABLE_WRITE
+		/* only the 4.41 kind, which takes any number of blocks */
+		if (mmc->cmd23 && ext_csd[EXT_CSD_REV] >= 5 &&
+		    (ext_csd[EXT_CSD_WR_REL_PARAM] & EXT_CSD_WR_REL_PARAM_EN))
+			mmc->rel_wr = 1;
+#endif
 	}
 
 	if (IS_SD(mmc))
@@ -1074,10 +1478,14 @@ int mmc_startup(struct mmc *mmc)
 			mmc_set_bus_width(mmc, 4);
 		}
 
-		if (mmc->card_caps & MMC_MODE_HS)
-			mmc_set_clock(mmc, 50000000);
-		else
-			mmc_set_clock(mmc, 25000000);
+		/* otherwise fall back to high or default speed */
+		if (sd_select_uhs(mmc)) {
+			if (mmc->card_caps & MMC_MODE_HS) {
+				mmc->timing = MMC_TIMING_SD_HS;
+				mmc_set_clock(mmc, 50000000);
+			} else
+				mmc_set_clock(mmc, 25000000);
+		}
 	} else {
 		for (width = EXT_CSD_BUS_WIDTH_8; width >= 0; width--) {
 			/* Set the card to use 4 bit*/
@@ -1111,12 +1519,21 @@ int mmc_startup(struct mmc *mmc)
 		}
 
 		if (mmc->card_caps & MMC_MODE_HS) {
+			mmc->timing = MMC_TIMING_MMC_HS;
 			if (mmc->card_caps & MMC_MODE_HS_52MHz)
 				mmc_set_clock(mmc, 52000000);
 			else
 				mmc_set_clock(mmc, 26000000);
 		} else
 			mmc_set_clock(mmc, 20000000);
+
+		/* HS200 and DDR52 both need a 4 or 8 bit bus */
+		err = -1;
+		if (mmc->bus_width > 1 && (mmc->card_caps & MMC_MODE_HS200))
+			err = mmc_select_hs200(mmc);
+		if (err && mmc->bus_width > 1 &&
+		    (mmc->card_caps & MMC_MODE_DDR_52MHz))
+			mmc_select_ddr52(mmc);
 	}
 
 	/* fill in device description */
@@ -1184,25 +1601,38 @@ block_dev_desc_t *mmc_get_dev(int dev)
 {
 	struct mmc *mmc = find_mmc_device(dev);
 
+	if (mmc && mmc->init_in_progress)
+		mmc_complete_init(mmc);
+
 	return mmc ? &mmc->block_dev : NULL;
 }
 #endif
 
-int mmc_init(struct mmc *mmc)
+/*
+ * Reset the card and send it the first operating condition command,
+ * which starts its power-up; the card is then busy for up to a second
+ * and mmc_complete_init() polls it until it is ready.
+ */
+static int mmc_start_init(struct mmc *mmc)
 {
 	int err;
 
-	if (mmc->has_init)
-		return 0;
+	/* the card may have been changed */
+	dev_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
 
 	err = mmc->init(mmc);
 
 	if (err)
 		return err;
 
+	mmc->timing = MMC_TIMING_LEGACY;
 	mmc_set_bus_width(mmc, 1);
 	mmc_set_clock(mmc, 1);
 
+	/* start over at 3.3V in case a previous init switched to 1.8V */
+	if (mmc->host_caps & MMC_MODE_UHS)
+		mmc->set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_330);
+
 	/* Reset the Card */
 	err = mmc_go_idle(mmc);
 
@@ -1216,18 +1646,39 @@ int mmc_init(struct mmc *mmc)
 	err = mmc_send_if_cond(mmc);
 
 	/* Now try to get the SD card's operating condition */
-	err = sd_send_op_cond(mmc);
+	err = sd_poll_op_cond(mmc);
+	mmc->op_cond_sd = 1;
 
 	/* If the command timed out, we check for an MMC card */
 	if (err == TIMEOUT) {
-		err = mmc_send_op_cond(mmc);
+		err = mmc_start_op_cond(mmc);
+		mmc->op_cond_sd = 0;
 
-		if (err) {
-			printf("Card did not respond to voltage select!\n");
+		if (err)
 			return UNUSABLE_ERR;
-		}
 	}
 
+	if (err)
+		return err;
+
+	mmc->init_in_progress = 1;
+	return 0;
+}
+
+static int mmc_complete_init(struct mmc *mmc)
+{
+	int err;
+
+	mmc->init_in_progress = 0;
+
+	if (mmc->op_cond_sd)
+		err = sd_finish_op_cond(mmc);
+	else
+		err = mmc_finish_op_cond(mmc);
+
+	if (err)
+		return err;
+
 	err = mmc_startup(mmc);
 	if (err)
 		mmc->has_init = 0;
@@ -1236,6 +1687,25 @@ int mmc_init(struct mmc *mmc)
 	return err;
 }
 
+int mmc_init(struct mmc *mmc)
+{
+	int err;
+
+	if (mmc->has_init)
+		return 0;
+
+	if (!mmc->init_in_progress) {
+		err = mmc_start_init(mmc);
+
+		if (err == UNUSABLE_ERR)
+			printf("Card did not respond to voltage select!\n");
+		if (err)
+			return err;
+	}
+
+	return mmc_complete_init(mmc);
+}
+
 /*
  * CPU and board-specific MMC initializations.  Aliased function
  * signals caller to move on
@@ -1272,6 +1742,10 @@ int get_mmc_num(void)
 
 int mmc_initialize(bd_t *bis)
 {
+#ifdef CONFIG_MMC_EARLY_INIT
+	struct list_head *entry;
+
+#endif
 	INIT_LIST_HEAD (&mmc_devices);
 	cur_dev_num = 0;
 
@@ -1280,5 +1754,14 @@ int mmc_initialize(bd_t *bis)
 
 	print_mmc_devices(',');
 
+#ifdef CONFIG_MMC_EARLY_INIT
+	/* the cards power up while the board goes on booting */
+	list_for_each(entry, &mmc_devices) {
+		struct mmc *m = list_entry(entry, struct mmc, link);
+
+		mmc_start_init(m);
+	}
+#endif
+
 	return 0;
 }
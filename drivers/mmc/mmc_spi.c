@@ -49,9 +49,39 @@
 #define RTOUT 3000000 /* 1 sec */
 #define WTOUT 3000000 /* 1 sec */
 
+/*
+ * Not every SPI driver has spi_set_speed(), so the clock is changed by
+ * setting the slave up again at the new speed.
+ */
+struct mmc_spi_host {
+	struct spi_slave *spi;
+	uint bus, cs, mode;
+	uint speed;		/* the slave has been set up for */
+};
+
+#define mmc_spi_slave(mmc)	(((struct mmc_spi_host *)(mmc)->priv)->spi)
+
+static void mmc_spi_set_speed(struct mmc *mmc, uint hz)
+{
+	struct mmc_spi_host *host = mmc->priv;
+	struct spi_slave *spi;
+
+	if (hz == host->speed)
+		return;
+
+	spi = spi_setup_slave(host->bus, host->cs, hz, host->mode);
+	if (!spi) {
+		debug("%s: can't set up for %u hz\n", __func__, hz);
+		return;
+	}
+	spi_free_slave(host->spi);
+	host->spi = spi;
+	host->speed = hz;
+}
+
 static uint mmc_spi_sendcmd(struct mmc *mmc, ushort cmdidx, u32 cmdarg)
 {
-	struct spi_slave *spi = mmc->priv;
+	struct spi_slave *spi = mmc_spi_slave(mmc);
 	u8 cmdo[7];
 	u8 r1;
 	int i;
@@ -72,10 +102,17 @@ static uint mmc_spi_sendcmd(struct mmc *mmc, ushort cmdidx, u32 cmdarg)
 	return r1;
 }
 
+/*
+ * The blocks of a multiblock read are streamed: except for the last, a
+ * block is read together with its CRC in one transfer, the CRC landing
+ * where the next block goes.  Large transfers are what makes SPI drivers
+ * use DMA, and the CRC, when checked, is taken from the buffer before it
+ * is overwritten.
+ */
 static uint mmc_spi_readdata(struct mmc *mmc, void *xbuf,
 				u32 bcnt, u32 bsize)
 {
-	struct spi_slave *spi = mmc->priv;
+	struct spi_slave *spi = mmc_spi_slave(mmc);
 	u8 *buf = xbuf;
 	u8 r1;
 	u16 crc;
@@ -88,8 +125,13 @@ static uint mmc_spi_readdata(struct mmc *mmc, void *xbuf,
 		}
 		debug("%s:tok%d %x\n", __func__, i, r1);
 		if (r1 == SPI_TOKEN_SINGLE) {
-			spi_xfer(spi, bsize * 8, NULL, buf, 0);
-			spi_xfer(spi, 2 * 8, NULL, &crc, 0);
+			if (bcnt) {
+				spi_xfer(spi, (bsize + 2) * 8, NULL, buf, 0);
+				memcpy(&crc, buf + bsize, 2);
+			} else {
+				spi_xfer(spi, bsize * 8, NULL, buf, 0);
+				spi_xfer(spi, 2 * 8, NULL, &crc, 0);
+			}
 #ifdef CONFIG_MMC_SPI_CRC_ON
 			if (swab16(cyg_crc16(buf, bsize)) != crc) {
 				debug("%s: CRC error\n", mmc->name);
@@ -110,7 +152,7 @@ static uint mmc_spi_readdata(struct mmc *mmc, void *xbuf,
 static uint mmc_spi_writedata(struct mmc *mmc, const void *xbuf,
 			      u32 bcnt, u32 bsize, int multi)
 {
-	struct spi_slave *spi = mmc->priv;
+	struct spi_slave *spi = mmc_spi_slave(mmc);
 	const u8 *buf = xbuf;
 	u8 r1;
 	u16 crc;
@@ -172,7 +214,7 @@ static uint mmc_spi_writedata(struct mmc *mmc, const void *xbuf,
 static int mmc_spi_request(struct mmc *mmc, struct mmc_cmd *cmd,
 		struct mmc_data *data)
 {
-	struct spi_slave *spi = mmc->priv;
+	struct spi_slave *spi = mmc_spi_slave(mmc);
 	u8 r1;
 	int i;
 	int ret = 0;
@@ -235,19 +277,25 @@ done:
 	return ret;
 }
 
+/* Once the card is identified, run at what its TRAN_SPEED allows */
 static void mmc_spi_set_ios(struct mmc *mmc)
 {
-	struct spi_slave *spi = mmc->priv;
-	debug("%s: clock %u\n", __func__, mmc->clock);
-	if (mmc->clock)
-		spi_set_speed(spi, mmc->clock);
+	uint clock = mmc->clock;
+
+	if (mmc->tran_speed && clock > mmc->tran_speed)
+		clock = mmc->tran_speed;
+	debug("%s: clock %u\n", __func__, clock);
+	if (clock)
+		mmc_spi_set_speed(mmc, clock);
 }
 
 static int mmc_spi_init_p(struct mmc *mmc)
 {
-	struct spi_slave *spi = mmc->priv;
+	struct spi_slave *spi;
 	mmc->clock = 0;
-	spi_set_speed(spi, MMC_SPI_MIN_CLOCK);
+	mmc->tran_speed = 0;
+	mmc_spi_set_speed(mmc, MMC_SPI_MIN_CLOCK);
+	spi = mmc_spi_slave(mmc);
 	spi_claim_bus(spi);
 	/* cs deactivated for 100+ clock */
 	spi_xfer(spi, 18 * 8, NULL, NULL, 0);
@@ -257,17 +305,24 @@ static int mmc_spi_init_p(struct mmc *mmc)
 
 struct mmc *mmc_spi_init(uint bus, uint cs, uint speed, uint mode)
 {
+	struct mmc_spi_host *host;
 	struct mmc *mmc;
 
-	mmc = malloc(sizeof(*mmc));
+	mmc = malloc(sizeof(*mmc) + sizeof(*host));
 	if (!mmc)
 		return NULL;
-	memset(mmc, 0, sizeof(*mmc));
-	mmc->priv = spi_setup_slave(bus, cs, speed, mode);
-	if (!mmc->priv) {
+	memset(mmc, 0, sizeof(*mmc) + sizeof(*host));
+	host = (struct mmc_spi_host *)(mmc + 1);
+	host->bus = bus;
+	host->cs = cs;
+	host->mode = mode;
+	host->speed = speed;
+	host->spi = spi_setup_slave(bus, cs, speed, mode);
+	if (!host->spi) {
 		free(mmc);
 		return NULL;
 	}
+	mmc->priv = host;
 	sprintf(mmc->name, "MMC_SPI");
 	mmc->send_cmd = mmc_spi_request;
 	mmc->set_ios = mmc_spi_set_ios;
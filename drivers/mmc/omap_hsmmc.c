@@ -32,6 +32,10 @@
 #include <asm/io.h>
 #include <asm/arch/mmc_host_def.h>
 #include <asm/arch/sys_proto.h>
+#ifdef CONFIG_OMAP_HSMMC_DMA
+#include <asm/arch/dma.h>
+#include <dma_map.h>
+#endif
 
 /* If we fail after 1 second wait, something is really bad */
 #define MAX_RETRY_MS	1000
@@ -41,6 +45,123 @@ static int mmc_write_data(struct hsmmc *mmc_base, const char *buf,
 			unsigned int siz);
 static struct mmc hsmmc_dev[2];
 
+#ifdef CONFIG_OMAP_HSMMC_DMA
+#ifndef CONFIG_OMAP_HSMMC_DMA_CHAN
+#define CONFIG_OMAP_HSMMC_DMA_CHAN	0
+#endif
+
+static int mmc_dma_req(struct hsmmc *mmc_base, int read)
+{
+	switch ((u32)mmc_base) {
+	case OMAP_HSMMC1_BASE:
+		return read ? OMAP_HSMMC1_DMA_RX : OMAP_HSMMC1_DMA_TX;
+	case OMAP_HSMMC2_BASE:
+		return read ? OMAP_HSMMC2_DMA_RX : OMAP_HSMMC2_DMA_TX;
+	case OMAP_HSMMC3_BASE:
+		return read ? OMAP_HSMMC3_DMA_RX : OMAP_HSMMC3_DMA_TX;
+	}
+	return -1;
+}
+
+static void *mmc_dma_buf(struct mmc_data *data)
+{
+	return data->flags & MMC_DATA_READ ? data->dest : (void *)data->src;
+}
+
+static unsigned int mmc_dma_dir(struct mmc_data *data)
+{
+	return data->flags & MMC_DATA_READ ?
+		DMA_MAP_FROM_DEVICE : DMA_MAP_TO_DEVICE;
+}
+
+/*
+ * Have the system DMA move the data, one frame of a block for each
+ * request of the controller.  0 if it is set up, -1 if the data has to
+ * be moved by PIO.
+ */
+static int mmc_dma_setup(struct hsmmc *mmc_base, struct mmc_data *data)
+{
+	static int dma_ready;
+	struct dma4_chan chan;
+	int read = data->flags & MMC_DATA_READ;
+	void *buf = mmc_dma_buf(data);
+	int req = mmc_dma_req(mmc_base, read);
+
+	if (req < 0 || ((u32)buf & 0x3) || (data->blocksize & 0x3))
+		return -1;
+
+	if (!dma_ready) {
+		omap3_dma_init();
+		dma_ready = 1;
+	}
+
+	memset(&chan, 0, sizeof(chan));
+	chan.csr = 0x1DFE;
+	chan.cicr = CICR_BLOCK_IE | CICR_TRANS_ERR_IE |
+		CICR_SUPERVISOR_ERR_IE | CICR_MISALIGNED_ERR_IE;
+	chan.csdp = CSDP_DATA_TYPE_32BIT;
+	chan.ccr = CCR_SYNCHRO(req) | CCR_FS;
+	if (read) {
+		chan.ccr |= CCR_SEL_SRC_DST_SYNC | CCR_SRC_AMODE_CONSTANT |
+			CCR_DST_AMODE_POST_INC;
+		chan.cssa = (u32)&mmc_base->data;
+		chan.cdsa = (u32)buf;
+	} else {
+		chan.ccr |= CCR_SRC_AMODE_POST_INC | CCR_DST_AMODE_CONSTANT;
+		chan.cssa = (u32)buf;
+		chan.cdsa = (u32)&mmc_base->data;
+	}
+	chan.cen = data->blocksize / 4;
+	chan.cfn = data->blocks;
+
+	dma_map_range(buf, data->blocksize * data->blocks, mmc_dma_dir(data));
+	omap3_dma_conf_chan(CONFIG_OMAP_HSMMC_DMA_CHAN, &chan);
+	if (omap3_dma_start_transfer(CONFIG_OMAP_HSMMC_DMA_CHAN))
+		return -1;
+	return 0;
+}
+
+/*
+ * Wait for the end of the transfer.  The timeout restarts with every
+ * frame the DMA moves, as it does for every block with PIO.
+ */
+static int mmc_dma_wait(struct hsmmc *mmc_base, struct mmc_data *data)
+{
+	struct dma4_chan chan;
+	unsigned int mmc_stat, frames = 0;
+	ulong start = get_timer(0);
+	int ret = 0;
+
+	do {
+		mmc_stat = readl(&mmc_base->stat);
+		if ((mmc_stat & ERRI_MASK) != 0) {
+			ret = 1;
+			break;
+		}
+		omap3_dma_get_conf_chan(CONFIG_OMAP_HSMMC_DMA_CHAN, &chan);
+		if (chan.ccfn != frames) {
+			frames = chan.ccfn;
+			start = get_timer(0);
+		} else if (get_timer(0) - start > MAX_RETRY_MS) {
+			printf("%s: timedout waiting for status!\n", __func__);
+			ret = TIMEOUT;
+			break;
+		}
+	} while (!(mmc_stat & TC_MASK));
+
+	if (!ret) {
+		writel(TC_MASK, &mmc_base->stat);
+		if (omap3_dma_wait_for_transfer(CONFIG_OMAP_HSMMC_DMA_CHAN))
+			ret = 1;
+	} else
+		omap3_dma_stop_transfer(CONFIG_OMAP_HSMMC_DMA_CHAN);
+
+	dma_unmap_range(mmc_dma_buf(data), data->blocksize * data->blocks,
+			mmc_dma_dir(data));
+	return ret;
+}
+#endif
+
 #if defined(CONFIG_OMAP44XX) && defined(CONFIG_TWL6030_POWER)
 static void omap4_vmmc_pbias_config(struct mmc *mmc)
 {
@@ -195,6 +316,9 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 {
 	struct hsmmc *mmc_base = (struct hsmmc *)mmc->priv;
 	unsigned int flags, mmc_stat;
+#ifdef CONFIG_OMAP_HSMMC_DMA
+	int dma = 0;
+#endif
 	ulong start;
 
 	start = get_timer(0);
@@ -262,6 +386,12 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			flags |= (DP_DATA | DDIR_READ);
 		else
 			flags |= (DP_DATA | DDIR_WRITE);
+#ifdef CONFIG_OMAP_HSMMC_DMA
+		if (!mmc_dma_setup(mmc_base, data)) {
+			flags |= DE_ENABLE;
+			dma = 1;
+		}
+#endif
 	}
 
 	writel(cmd->cmdarg, &mmc_base->arg);
@@ -276,10 +406,17 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	} while (!mmc_stat);
 
-	if ((mmc_stat & IE_CTO) != 0)
-		return TIMEOUT;
-	else if ((mmc_stat & ERRI_MASK) != 0)
-		return -1;
+	if ((mmc_stat & (IE_CTO | ERRI_MASK)) != 0) {
+#ifdef CONFIG_OMAP_HSMMC_DMA
+		if (dma) {
+			omap3_dma_stop_transfer(CONFIG_OMAP_HSMMC_DMA_CHAN);
+			dma_unmap_range(mmc_dma_buf(data),
+					data->blocksize * data->blocks,
+					mmc_dma_dir(data));
+		}
+#endif
+		return (mmc_stat & IE_CTO) ? TIMEOUT : -1;
+	}
 
 	if (mmc_stat & CC_MASK) {
 		writel(CC_MASK, &mmc_base->stat);
@@ -296,6 +433,10 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
+#ifdef CONFIG_OMAP_HSMMC_DMA
+	if (dma)
+		return mmc_dma_wait(mmc_base, data);
+#endif
 	if (data && (data->flags & MMC_DATA_READ)) {
 		mmc_read_data(mmc_base,	data->dest,
 				data->blocksize * data->blocks);
@@ -28,23 +28,59 @@
 #include <malloc.h>
 #include <mmc.h>
 #include <sdhci.h>
+#include <wait_bit.h>
+#include <dma_map.h>
 
 void *aligned_buffer;
 
+#ifdef CONFIG_MMC_ADMA
+static struct sdhci_adma_desc adma_desc[CONFIG_SDHCI_ADMA_DESCS]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
+
+/*
+ * Describe the whole buffer of a request in one descriptor chain, so the
+ * controller moves it without stopping at any DMA boundary.
+ */
+static unsigned int sdhci_adma_setup(unsigned int addr, unsigned int len)
+{
+	struct sdhci_adma_desc *desc = adma_desc;
+	unsigned int n;
+
+	while (len) {
+		n = min(len, (unsigned int)SDHCI_ADMA_MAX_LEN);
+		desc->attr = cpu_to_le16(SDHCI_ADMA_VALID |
+					 SDHCI_ADMA_ACT_TRAN);
+		desc->len = cpu_to_le16(n & 0xffff);
+		desc->addr = cpu_to_le32(addr);
+		addr += n;
+		len -= n;
+		desc++;
+	}
+	desc[-1].attr |= cpu_to_le16(SDHCI_ADMA_END);
+
+	dma_map_range(adma_desc, sizeof(adma_desc), DMA_MAP_TO_DEVICE);
+	return (unsigned int)adma_desc;
+}
+#endif
+
+static inline unsigned int sdhci_dma_dir(struct mmc_data *data)
+{
+	return data && data->flags == MMC_DATA_READ ? DMA_MAP_FROM_DEVICE :
+						      DMA_MAP_TO_DEVICE;
+}
+
 static void sdhci_reset(struct sdhci_host *host, u8 mask)
 {
-	unsigned long timeout;
+	struct wait_backoff wb;
 
 	/* Wait max 100 ms */
-	timeout = 100;
+	wait_backoff_start(&wb, 100);
 	sdhci_writeb(host, mask, SDHCI_SOFTWARE_RESET);
 	while (sdhci_readb(host, SDHCI_SOFTWARE_RESET) & mask) {
-		if (timeout == 0) {
+		if (wait_backoff(&wb)) {
 			printf("Reset 0x%x never completed.\n", (int)mask);
 			return;
 		}
-		timeout--;
-		udelay(1000);
 	}
 }
 
@@ -81,9 +117,14 @@ static void sdhci_transfer_pio(struct sdhci_host *host, struct mmc_data *data)
 static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 				unsigned int start_addr)
 {
-	unsigned int stat, rdy, mask, timeout, block = 0;
-
-	timeout = 10000;
+	unsigned int stat, rdy, mask, block = 0;
+	struct wait_backoff wb;
+
+	/*
+	 * 100 ms, plus 1 ms for each KiB of a large DMA transfer, so that a
+	 * class 2 card (2 MB/s) writing b_max blocks has time to spare
+	 */
+	wait_backoff_start(&wb, 100 + (data->blocks * data->blocksize >> 10));
 	rdy = SDHCI_INT_SPACE_AVAIL | SDHCI_INT_DATA_AVAIL;
 	mask = SDHCI_DATA_AVAILABLE | SDHCI_SPACE_AVAILABLE;
 	do {
@@ -100,6 +141,7 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 			data->dest += data->blocksize;
 			if (++block >= data->blocks)
 				break;
+			wait_backoff_restart(&wb);
 		}
 #ifdef CONFIG_MMC_SDMA
 		if (stat & SDHCI_INT_DMA_END) {
@@ -109,9 +151,7 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 			sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
 		}
 #endif
-		if (timeout-- > 0)
-			udelay(10);
-		else {
+		if (wait_backoff(&wb)) {
 			printf("Transfer data timeout\n");
 			return -1;
 		}
@@ -127,10 +167,11 @@ int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	int ret = 0;
 	int trans_bytes = 0, is_aligned = 1;
 	u32 mask, flags, mode;
-	unsigned int timeout, start_addr = 0;
+	unsigned int start_addr = 0;
+	struct wait_backoff wb;
 
 	/* Wait max 10 ms */
-	timeout = 10;
+	wait_backoff_start(&wb, 10);
 
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	mask = SDHCI_CMD_INHIBIT | SDHCI_DATA_INHIBIT;
@@ -141,12 +182,10 @@ int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 		mask &= ~SDHCI_DATA_INHIBIT;
 
 	while (sdhci_readl(host, SDHCI_PRESENT_STATE) & mask) {
-		if (timeout == 0) {
+		if (wait_backoff(&wb)) {
 			printf("Controller never released inhibit bit(s).\n");
 			return COMM_ERR;
 		}
-		timeout--;
-		udelay(1000);
 	}
 
 	mask = SDHCI_INT_RESPONSE;
@@ -193,6 +232,23 @@ int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 
 		sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
 		mode |= SDHCI_TRNS_DMA;
+#endif
+#ifdef CONFIG_MMC_ADMA
+		if (data->flags == MMC_DATA_READ)
+			start_addr = (unsigned int)data->dest;
+		else
+			start_addr = (unsigned int)data->src;
+		/* ADMA2 needs word aligned buffers, move others by PIO */
+		if (!(start_addr & 0x3)) {
+			u8 ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+
+			ctrl &= ~SDHCI_CTRL_DMA_MASK;
+			sdhci_writeb(host, ctrl | SDHCI_CTRL_ADMA32,
+				     SDHCI_HOST_CONTROL);
+			sdhci_writel(host, sdhci_adma_setup(start_addr,
+					trans_bytes), SDHCI_ADMA_ADDRESS);
+			mode |= SDHCI_TRNS_DMA;
+		}
 #endif
 		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
 				data->blocksize),
@@ -203,7 +259,12 @@ int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	sdhci_writel(host, cmd->cmdarg, SDHCI_ARGUMENT);
 #ifdef CONFIG_MMC_SDMA
-	flush_cache(start_addr, trans_bytes);
+	dma_map_range((void *)start_addr, trans_bytes, sdhci_dma_dir(data));
+#endif
+#ifdef CONFIG_MMC_ADMA
+	if (data && (mode & SDHCI_TRNS_DMA))
+		dma_map_range((void *)start_addr, trans_bytes,
+			      sdhci_dma_dir(data));
 #endif
 	sdhci_writew(host, SDHCI_MAKE_CMD(cmd->cmdidx, flags), SDHCI_COMMAND);
 	do {
@@ -220,6 +281,14 @@ int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	if (!ret && data)
 		ret = sdhci_transfer_data(host, data, start_addr);
+#ifdef CONFIG_MMC_SDMA
+	dma_unmap_range((void *)start_addr, trans_bytes, sdhci_dma_dir(data));
+#endif
+#ifdef CONFIG_MMC_ADMA
+	if (data && (mode & SDHCI_TRNS_DMA))
+		dma_unmap_range((void *)start_addr, trans_bytes,
+				sdhci_dma_dir(data));
+#endif
 
 	stat = sdhci_readl(host, SDHCI_INT_STATUS);
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
@@ -241,7 +310,8 @@ int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 static int sdhci_set_clock(struct mmc *mmc, unsigned int clock)
 {
 	struct sdhci_host *host = (struct sdhci_host *)mmc->priv;
-	unsigned int div, clk, timeout;
+	unsigned int div, clk;
+	struct wait_backoff wb;
 
 	sdhci_writew(host, 0, SDHCI_CLOCK_CONTROL);
 
@@ -274,15 +344,13 @@ static int sdhci_set_clock(struct mmc *mmc, unsigned int clock)
 	sdhci_writew(host, clk, SDHCI_CLOCK_CONTROL);
 
 	/* Wait max 20 ms */
-	timeout = 20;
+	wait_backoff_start(&wb, 20);
 	while (!((clk = sdhci_readw(host, SDHCI_CLOCK_CONTROL))
 		& SDHCI_CLOCK_INT_STABLE)) {
-		if (timeout == 0) {
+		if (wait_backoff(&wb)) {
 			printf("Internal clock never stabilised.\n");
 			return -1;
 		}
-		timeout--;
-		udelay(1000);
 	}
 
 	clk |= SDHCI_CLOCK_CARD_EN;
@@ -349,6 +417,130 @@ void sdhci_set_ios(struct mmc *mmc)
 		ctrl &= ~SDHCI_CTRL_HISPD;
 
 	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+
+	if (host->version < SDHCI_SPEC_300)
+		return;
+
+	/* HS200 runs with SDR104 timing, DDR52 with DDR50 timing */
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	ctrl &= ~SDHCI_CTRL_UHS_MASK;
+	switch (mmc->timing) {
+	case MMC_TIMING_MMC_HS200:
+	case MMC_TIMING_UHS_SDR104:
+		ctrl |= SDHCI_CTRL_UHS_SDR104;
+		break;
+	case MMC_TIMING_UHS_SDR50:
+		ctrl |= SDHCI_CTRL_UHS_SDR50;
+		break;
+	case MMC_TIMING_MMC_DDR52:
+	case MMC_TIMING_UHS_DDR50:
+		ctrl |= SDHCI_CTRL_UHS_DDR50;
+		break;
+	default:
+		if (mmc->clock > 26000000)
+			ctrl |= SDHCI_CTRL_UHS_SDR25;
+		break;
+	}
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+}
+
+/*
+ * Signal voltage switch sequence of the SD Host Controller Simplified
+ * Specification 3.00; CMD11 has already been sent by the caller.
+ */
+static int sdhci_set_signal_voltage(struct mmc *mmc, uint voltage)
+{
+	struct sdhci_host *host = (struct sdhci_host *)mmc->priv;
+	u16 ctrl, clk;
+
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	if (voltage == MMC_SIGNAL_VOLTAGE_330) {
+		ctrl &= ~SDHCI_CTRL_VDD_180;
+		sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+		return 0;
+	}
+
+	/* stop the card clock while the lines change level */
+	clk = sdhci_readw(host, SDHCI_CLOCK_CONTROL);
+	sdhci_writew(host, clk & ~SDHCI_CLOCK_CARD_EN, SDHCI_CLOCK_CONTROL);
+
+	ctrl |= SDHCI_CTRL_VDD_180;
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+	udelay(5000);
+
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	if (!(ctrl & SDHCI_CTRL_VDD_180))
+		return -1;
+
+	sdhci_writew(host, clk | SDHCI_CLOCK_CARD_EN, SDHCI_CLOCK_CONTROL);
+	udelay(1000);
+
+	/* the card drives DAT[3:0] high once it has switched */
+	if ((sdhci_readl(host, SDHCI_PRESENT_STATE) & SDHCI_DATA_LVL_MASK) !=
+			SDHCI_DATA_LVL_MASK)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Tuning as described in the SD Host Controller Simplified Specification
+ * 3.00: with Execute Tuning set, send the tuning command until the
+ * controller clears the bit again, then check the sampling clock has
+ * been selected.
+ */
+static int sdhci_execute_tuning(struct mmc *mmc, uint opcode)
+{
+	struct sdhci_host *host = (struct sdhci_host *)mmc->priv;
+	unsigned int blksz = mmc->bus_width == 8 ? 128 : 64;
+	struct wait_backoff wb;
+	unsigned int stat;
+	u32 flags = SDHCI_CMD_RESP_SHORT | SDHCI_CMD_CRC | SDHCI_CMD_INDEX |
+		SDHCI_CMD_DATA;
+	u16 ctrl;
+	int loop;
+
+	if (mmc->timing == MMC_TIMING_UHS_SDR50 &&
+	    !(sdhci_readl(host, SDHCI_CAPABILITIES_1) & SDHCI_USE_SDR50_TUNING))
+		return 0;
+
+	ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+	ctrl |= SDHCI_CTRL_EXEC_TUNING;
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+
+	/* the controller gives up by itself after 40 tuning commands */
+	for (loop = 0; loop < 40; loop++) {
+		sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
+				blksz), SDHCI_BLOCK_SIZE);
+		sdhci_writew(host, 1, SDHCI_BLOCK_COUNT);
+		sdhci_writew(host, SDHCI_TRNS_READ, SDHCI_TRANSFER_MODE);
+		sdhci_writel(host, 0, SDHCI_ARGUMENT);
+		sdhci_writew(host, SDHCI_MAKE_CMD(opcode, flags), SDHCI_COMMAND);
+
+		/* Wait max 150 ms for the tuning block */
+		wait_backoff_start(&wb, 150);
+		do {
+			stat = sdhci_readl(host, SDHCI_INT_STATUS);
+			if (stat & SDHCI_INT_DATA_AVAIL)
+				break;
+		} while (!wait_backoff(&wb));
+		sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+
+		ctrl = sdhci_readw(host, SDHCI_HOST_CONTROL2);
+		if (!(ctrl & SDHCI_CTRL_EXEC_TUNING))
+			break;
+	}
+
+	if ((ctrl & (SDHCI_CTRL_EXEC_TUNING | SDHCI_CTRL_TUNED_CLK)) ==
+			SDHCI_CTRL_TUNED_CLK)
+		return 0;
+
+	ctrl &= ~(SDHCI_CTRL_EXEC_TUNING | SDHCI_CTRL_TUNED_CLK);
+	sdhci_writew(host, ctrl, SDHCI_HOST_CONTROL2);
+	sdhci_reset(host, SDHCI_RESET_CMD);
+	sdhci_reset(host, SDHCI_RESET_DATA);
+	return -1;
 }
 
 int sdhci_init(struct mmc *mmc)
@@ -375,7 +567,7 @@ int sdhci_init(struct mmc *mmc)
 int add_sdhci(struct sdhci_host *host, u32 max_clk, u32 min_clk)
 {
 	struct mmc *mmc;
-	unsigned int caps;
+	unsigned int caps, caps1 = 0;
 
 	mmc = malloc(sizeof(struct mmc));
 	if (!mmc) {
@@ -390,14 +582,28 @@ int add_sdhci(struct sdhci_host *host, u32 max_clk, u32 min_clk)
 	mmc->send_cmd = sdhci_send_command;
 	mmc->set_ios = sdhci_set_ios;
 	mmc->init = sdhci_init;
+	mmc->execute_tuning = sdhci_execute_tuning;
+	mmc->set_signal_voltage = sdhci_set_signal_voltage;
 
 	caps = sdhci_readl(host, SDHCI_CAPABILITIES);
+	if (host->version >= SDHCI_SPEC_300)
+		caps1 = sdhci_readl(host, SDHCI_CAPABILITIES_1);
 #ifdef CONFIG_MMC_SDMA
 	if (!(caps & SDHCI_CAN_DO_SDMA)) {
 		printf("Your controller don't support sdma!!\n");
 		return -1;
 	}
 #endif
+#ifdef CONFIG_MMC_ADMA
+	if (!(caps & SDHCI_CAN_DO_ADMA2)) {
+		printf("Your controller don't support adma2!!\n");
+		return -1;
+	}
+	/* one descriptor chain covers a whole request */
+	mmc->b_max = CONFIG_SDHCI_ADMA_DESCS * (SDHCI_ADMA_MAX_LEN / 512);
+#else
+	mmc->b_max = 0;
+#endif
 
 	if (max_clk)
 		mmc->f_max = max_clk;
@@ -433,6 +639,15 @@ int add_sdhci(struct sdhci_host *host, u32 max_clk, u32 min_clk)
 	mmc->host_caps = MMC_MODE_HS | MMC_MODE_HS_52MHz | MMC_MODE_4BIT;
 	if (caps & SDHCI_CAN_DO_8BIT)
 		mmc->host_caps |= MMC_MODE_8BIT;
+	/* the board has to say whether its eMMC wiring can do these */
+	if (caps1 & SDHCI_SUPPORT_DDR50)
+		mmc->host_caps |= host->host_caps &
+			(MMC_MODE_DDR_52MHz | MMC_MODE_UHS_DDR50);
+	if (caps1 & SDHCI_SUPPORT_SDR104)
+		mmc->host_caps |= host->host_caps &
+			(MMC_MODE_HS200 | MMC_MODE_UHS_SDR104);
+	if (caps1 & SDHCI_SUPPORT_SDR50)
+		mmc->host_caps |= host->host_caps & MMC_MODE_UHS_SDR50;
 
 	sdhci_reset(host, SDHCI_RESET_ALL);
 	mmc_register(mmc);
@@ -40,6 +40,7 @@
 #include <asm/byteorder.h>
 #include <environment.h>
 #include <mtd/cfi_flash.h>
+#include <wait_bit.h>
 
 /*
  * This file implements a Common Flash Interface (CFI) driver for
@@ -219,6 +220,50 @@ static inline void flash_unmap(flash_info_t *info, flash_sect_t sect,
 {
 }
 
+#ifdef CONFIG_SYS_FLASH_CACHED_READ
+/*
+ * The board maps the flash cacheable (and, with a chip configured for
+ * it, burst read) while it is in read array mode.  The first command
+ * to a bank has the board map it cache-inhibited, so that status and
+ * query reads see the chip; once the operation is complete the range
+ * it changed is invalidated and the bank mapped cacheable again.
+ */
+static uchar flash_cmd_mode[CFI_MAX_FLASH_BANKS];
+
+void __cfi_flash_cached_read(flash_info_t *info, int cached)
+{
+}
+void cfi_flash_cached_read(flash_info_t *info, int cached)
+	__attribute__((weak, alias("__cfi_flash_cached_read")));
+
+static void flash_read_uncached(flash_info_t *info)
+{
+	if (!flash_cmd_mode[info - flash_info]) {
+		cfi_flash_cached_read(info, 0);
+		flash_cmd_mode[info - flash_info] = 1;
+	}
+}
+
+/* Back to cacheable reads, after addr..addr+len-1 was changed */
+static void flash_read_cached(flash_info_t *info, ulong addr, ulong len)
+{
+	if (len)
+		invalidate_dcache_range(addr, addr + len);
+	if (flash_cmd_mode[info - flash_info]) {
+		flash_cmd_mode[info - flash_info] = 0;
+		cfi_flash_cached_read(info, 1);
+	}
+}
+#else
+static inline void flash_read_uncached(flash_info_t *info)
+{
+}
+
+static inline void flash_read_cached(flash_info_t *info, ulong addr, ulong len)
+{
+}
+#endif /* CONFIG_SYS_FLASH_CACHED_READ */
+
 /*-----------------------------------------------------------------------
  * make a proper sized command based on the port and chip widths
  */
@@ -363,6 +408,7 @@ void flash_write_cmd (flash_info_t * info, flash_sect_t sect,
 	void *addr;
 	cfiword_t cword;
 
+	flash_read_uncached(info);
 	addr = flash_map (info, sect, offset);
 	flash_make_cmd (info, cmd, &cword);
 	switch (info->portwidth) {
@@ -563,7 +609,7 @@ static int flash_is_busy (flash_info_t * info, flash_sect_t sect)
 static int flash_status_check (flash_info_t * info, flash_sect_t sector,
 			       ulong tout, char *prompt)
 {
-	ulong start;
+	struct wait_backoff wb;
 
 #if CONFIG_SYS_HZ != 1000
 	if ((ulong)CONFIG_SYS_HZ > 100000)
@@ -576,9 +622,10 @@ static int flash_status_check (flash_info_t * info, flash_sect_t sector,
 #ifdef CONFIG_SYS_LOW_RES_TIMER
 	reset_timer();
 #endif
-	start = get_timer (0);
+	/* word programs take microseconds, erases a second */
+	wait_backoff_start(&wb, tout);
 	while (flash_is_busy (info, sector)) {
-		if (get_timer (start) > tout) {
+		if (wait_backoff(&wb)) {
 			printf ("Flash %s timeout at address %lx data %lx\n",
 				prompt, info->start[sector],
 				flash_read_long (info, sector, 0));
@@ -586,7 +633,6 @@ static int flash_status_check (flash_info_t * info, flash_sect_t sector,
 			udelay(1);
 			return ERR_TIMOUT;
 		}
-		udelay (1);		/* also triggers watchdog */
 	}
 	return ERR_OK;
 }
@@ -861,34 +907,41 @@ static int flash_write_cfiword (flash_info_t * info, ulong dest,
 
 #ifdef CONFIG_SYS_FLASH_USE_BUFFER_WRITE
 
-static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
-				  int len)
+static int flash_port_shift(flash_info_t *info)
+{
+	switch (info->portwidth) {
+	case FLASH_CFI_8BIT:
+		return 0;
+	case FLASH_CFI_16BIT:
+		return 1;
+	case FLASH_CFI_32BIT:
+		return 2;
+	case FLASH_CFI_64BIT:
+		return 3;
+	}
+	return -1;
+}
+
+/*
+ * Load one write buffer and confirm it, without waiting for the
+ * program operation to finish; see flash_write_cfibuffer_wait().
+ */
+static int flash_write_cfibuffer_start(flash_info_t *info, ulong dest,
+				       uchar *cp, int len)
 {
 	flash_sect_t sector;
 	int cnt;
-	int retcode;
+	int retcode = ERR_OK;
 	void *src = cp;
 	void *dst = (void *)dest;
 	void *dst2 = dst;
 	int flag = 0;
 	uint offset = 0;
-	unsigned int shift;
+	int shift;
 	uchar write_cmd;
 
-	switch (info->portwidth) {
-	case FLASH_CFI_8BIT:
-		shift = 0;
-		break;
-	case FLASH_CFI_16BIT:
-		shift = 1;
-		break;
-	case FLASH_CFI_32BIT:
-		shift = 2;
-		break;
-	case FLASH_CFI_64BIT:
-		shift = 3;
-		break;
-	default:
+	shift = flash_port_shift(info);
+	if (shift < 0) {
 		retcode = ERR_INVAL;
 		goto out_unmap;
 	}
@@ -969,9 +1022,6 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 			}
 			flash_write_cmd (info, sector, 0,
 					 FLASH_CMD_WRITE_BUFFER_CONFIRM);
-			retcode = flash_full_status_check (
-				info, sector, info->buffer_write_tout,
-				"buffer write");
 		}
 
 		break;
@@ -1018,15 +1068,6 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 		}
 
 		flash_write_cmd (info, sector, 0, AMD_CMD_WRITE_BUFFER_CONFIRM);
-		if (use_flash_status_poll(info))
-			retcode = flash_status_poll(info, src - (1 << shift),
-						    dst - (1 << shift),
-						    info->buffer_write_tout,
-						    "buffer write");
-		else
-			retcode = flash_full_status_check(info, sector,
-							  info->buffer_write_tout,
-							  "buffer write");
 		break;
 
 	default:
@@ -1038,9 +1079,96 @@ static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
 out_unmap:
 	return retcode;
 }
+
+/*
+ * Wait for a buffer loaded by flash_write_cfibuffer_start() to be
+ * programmed.  Data polling looks at the last word of the buffer.
+ */
+static int flash_write_cfibuffer_wait(flash_info_t *info, ulong dest,
+				      uchar *cp, int len)
+{
+	int last = ((len >> flash_port_shift(info)) - 1) * info->portwidth;
+
+	if (use_flash_status_poll(info))
+		return flash_status_poll(info, cp + last, (void *)(dest + last),
+					 info->buffer_write_tout,
+					 "buffer write");
+
+	return flash_full_status_check(info, find_sector(info, dest),
+				       info->buffer_write_tout,
+				       "buffer write");
+}
+
+static int flash_write_cfibuffer (flash_info_t * info, ulong dest, uchar * cp,
+				  int len)
+{
+	int retcode;
+
+	retcode = flash_write_cfibuffer_start(info, dest, cp, len);
+	if (retcode != ERR_OK)
+		return retcode;
+
+	return flash_write_cfibuffer_wait(info, dest, cp, len);
+}
 #endif /* CONFIG_SYS_FLASH_USE_BUFFER_WRITE */
 
 
+/*-----------------------------------------------------------------------
+ * Issue the erase of one sector without waiting for it to finish.
+ */
+static void flash_erase_start(flash_info_t *info, flash_sect_t sect)
+{
+	switch (info->vendor) {
+	case CFI_CMDSET_INTEL_PROG_REGIONS:
+	case CFI_CMDSET_INTEL_STANDARD:
+	case CFI_CMDSET_INTEL_EXTENDED:
+		flash_write_cmd (info, sect, 0, FLASH_CMD_CLEAR_STATUS);
+		flash_write_cmd (info, sect, 0, FLASH_CMD_BLOCK_ERASE);
+		flash_write_cmd (info, sect, 0, FLASH_CMD_ERASE_CONFIRM);
+		break;
+	case CFI_CMDSET_AMD_STANDARD:
+	case CFI_CMDSET_AMD_EXTENDED:
+		flash_unlock_seq (info, sect);
+		flash_write_cmd (info, sect, info->addr_unlock1,
+				 AMD_CMD_ERASE_START);
+		flash_unlock_seq (info, sect);
+		flash_write_cmd (info, sect, 0, AMD_CMD_ERASE_SECTOR);
+		break;
+#ifdef CONFIG_FLASH_CFI_LEGACY
+	case CFI_CMDSET_AMD_LEGACY:
+		flash_unlock_seq (info, 0);
+		flash_write_cmd (info, 0, info->addr_unlock1,
+				 AMD_CMD_ERASE_START);
+		flash_unlock_seq (info, 0);
+		flash_write_cmd (info, sect, 0, AMD_CMD_ERASE_SECTOR);
+		break;
+#endif
+	default:
+		debug ("Unkown flash vendor %d\n", info->vendor);
+		break;
+	}
+}
+
+/*
+ * Wait for an erase issued by flash_erase_start() to finish.
+ */
+static int flash_erase_wait(flash_info_t *info, flash_sect_t sect)
+{
+	int st;
+
+	if (use_flash_status_poll(info)) {
+		cfiword_t cword = (cfiword_t)0xffffffffffffffffULL;
+		void *dest;
+		dest = flash_map(info, sect, 0);
+		st = flash_status_poll(info, &cword, dest,
+				       info->erase_blk_tout, "erase");
+		flash_unmap(info, sect, 0, dest);
+	} else
+		st = flash_full_status_check(info, sect,
+					     info->erase_blk_tout, "erase");
+	return st;
+}
+
 /*-----------------------------------------------------------------------
  */
 int flash_erase (flash_info_t * info, int s_first, int s_last)
@@ -1075,54 +1203,8 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 
 	for (sect = s_first; sect <= s_last; sect++) {
 		if (info->protect[sect] == 0) { /* not protected */
-			switch (info->vendor) {
-			case CFI_CMDSET_INTEL_PROG_REGIONS:
-			case CFI_CMDSET_INTEL_STANDARD:
-			case CFI_CMDSET_INTEL_EXTENDED:
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_CLEAR_STATUS);
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_BLOCK_ERASE);
-				flash_write_cmd (info, sect, 0,
-						 FLASH_CMD_ERASE_CONFIRM);
-				break;
-			case CFI_CMDSET_AMD_STANDARD:
-			case CFI_CMDSET_AMD_EXTENDED:
-				flash_unlock_seq (info, sect);
-				flash_write_cmd (info, sect,
-						info->addr_unlock1,
-						AMD_CMD_ERASE_START);
-				flash_unlock_seq (info, sect);
-				flash_write_cmd (info, sect, 0,
-						 AMD_CMD_ERASE_SECTOR);
-				break;
-#ifdef CONFIG_FLASH_CFI_LEGACY
-			case CFI_CMDSET_AMD_LEGACY:
-				flash_unlock_seq (info, 0);
-				flash_write_cmd (info, 0, info->addr_unlock1,
-						AMD_CMD_ERASE_START);
-				flash_unlock_seq (info, 0);
-				flash_write_cmd (info, sect, 0,
-						AMD_CMD_ERASE_SECTOR);
-				break;
-#endif
-			default:
-				debug ("Unkown flash vendor %d\n",
-				       info->vendor);
-				break;
-			}
-
-			if (use_flash_status_poll(info)) {
-				cfiword_t cword = (cfiword_t)0xffffffffffffffffULL;
-				void *dest;
-				dest = flash_map(info, sect, 0);
-				st = flash_status_poll(info, &cword, dest,
-						       info->erase_blk_tout, "erase");
-				flash_unmap(info, sect, 0, dest);
-			} else
-				st = flash_full_status_check(info, sect,
-							     info->erase_blk_tout,
-							     "erase");
+			flash_erase_start(info, sect);
+			st = flash_erase_wait(info, sect);
 			if (st)
 				rcode = 1;
 			else if (flash_verbose)
@@ -1133,6 +1215,10 @@ int flash_erase (flash_info_t * info, int s_first, int s_last)
 	if (flash_verbose)
 		puts (" done\n");
 
+	flash_read_cached(info, info->start[s_first],
+			  info->start[s_last] - info->start[s_first] +
+			  flash_sector_size(info, s_last));
+
 	return rcode;
 }
 
@@ -1273,7 +1359,8 @@ void flash_print_info (flash_info_t * info)
  * 1 - write timeout
  * 2 - Flash not erased
  */
-int write_buff (flash_info_t * info, uchar * src, ulong addr, ulong cnt)
+static int flash_write_buff(flash_info_t *info, uchar *src, ulong addr,
+			    ulong cnt, int progress)
 {
 	ulong wp;
 	uchar *p;
@@ -1291,7 +1378,7 @@ int write_buff (flash_info_t * info, uchar * src, ulong addr, ulong cnt)
 	/*
 	 * Suppress if there are fewer than CONFIG_FLASH_SHOW_PROGRESS writes.
 	 */
-	if (cnt >= CONFIG_FLASH_SHOW_PROGRESS) {
+	if (progress && cnt >= CONFIG_FLASH_SHOW_PROGRESS) {
 		scale = (int)((cnt + CONFIG_FLASH_SHOW_PROGRESS - 1) /
 			CONFIG_FLASH_SHOW_PROGRESS);
 	}
@@ -1384,6 +1471,235 @@ int write_buff (flash_info_t * info, uchar * src, ulong addr, ulong cnt)
 	return flash_write_cfiword (info, wp, cword);
 }
 
+int write_buff (flash_info_t * info, uchar * src, ulong addr, ulong cnt)
+{
+	int rc;
+
+	rc = flash_write_buff(info, src, addr, cnt, 1);
+	flash_read_cached(info, addr, cnt);
+
+	return rc;
+}
+
+#if defined(CONFIG_SYS_FLASH_USE_BUFFER_WRITE) && \
+	defined(CONFIG_SYS_FLASH_PARALLEL_BANKS)
+/*-----------------------------------------------------------------------
+ * Copy memory to a range spanning the banks first..last.  The whole
+ * buffers of every bank are programmed round-robin, with one buffer in
+ * flight on each bank, so that the chips program concurrently; the
+ * partial buffers at either end of a bank go through write_buff().
+ * Returns the same codes as write_buff().
+ */
+struct flash_bank_run {
+	flash_info_t *info;
+	uchar *src;
+	ulong wp;
+	ulong cnt;		/* bytes left in whole buffers */
+	ulong size;		/* bytes per buffer program */
+	ulong tail;		/* bytes after the last whole buffer */
+	int busy;
+};
+
+int write_buff_banks(flash_info_t *first, flash_info_t *last,
+		     uchar *src, ulong addr, ulong cnt)
+{
+	struct flash_bank_run run[CFI_MAX_FLASH_BANKS];
+	flash_info_t *info;
+	ulong start = addr, total = cnt;
+	int n = 0, i, rc = ERR_OK, ret, more;
+
+	for (info = first; info <= last && cnt > 0; ++info, ++n) {
+		struct flash_bank_run *r = &run[n];
+		ulong len, head;
+
+		len = info->start[0] + info->size - addr;
+		if (len > cnt)
+			len = cnt;
+
+		r->info = info;
+		r->size = (info->portwidth / info->chipwidth) *
+			info->buffer_size;
+		if (info->buffer_size > 1) {
+			head = (r->size - (addr % r->size)) % r->size;
+			if (head > len)
+				head = len;
+		} else {
+			head = len;
+		}
+		r->cnt = (len - head) - ((len - head) % r->size);
+		r->tail = len - head - r->cnt;
+		r->wp = addr + head;
+		r->src = src + head;
+
+		if (head) {
+			rc = write_buff(info, src, addr, head);
+			if (rc != ERR_OK)
+				return rc;
+		}
+
+		cnt  -= len;
+		addr += len;
+		src  += len;
+	}
+
+	do {
+		for (i = 0; i < n; i++) {
+			run[i].busy = 0;
+			if (!run[i].cnt || rc != ERR_OK)
+				continue;
+			rc = flash_write_cfibuffer_start(run[i].info, run[i].wp,
+							 run[i].src,
+							 run[i].size);
+			run[i].busy = (rc == ERR_OK);
+		}
+
+		/* Every started bank is waited for, even after an error */
+		more = 0;
+		for (i = 0; i < n; i++) {
+			if (!run[i].busy)
+				continue;
+			ret = flash_write_cfibuffer_wait(run[i].info, run[i].wp,
+							 run[i].src,
+							 run[i].size);
+			if (rc == ERR_OK)
+				rc = ret;
+			run[i].wp  += run[i].size;
+			run[i].src += run[i].size;
+			run[i].cnt -= run[i].size;
+			if (run[i].cnt)
+				more = 1;
+		}
+	} while (rc == ERR_OK && more);
+
+	for (i = 0; i < n && rc == ERR_OK; i++)
+		if (run[i].tail)
+			rc = write_buff(run[i].info, run[i].src, run[i].wp,
+					run[i].tail);
+
+	for (i = 0; i < n; i++)
+		flash_read_cached(run[i].info, start, i ? 0 : total);
+
+	return rc;
+}
+#endif
+
+#ifdef CONFIG_SYS_FLASH_ERASE_PIPELINE
+/*-----------------------------------------------------------------------
+ * Erase the sectors covering addr..addr+cnt-1 and copy src into them.
+ * While the sectors of one bank are being programmed, the sectors of
+ * the following banks are erased in the background, so the erase time
+ * of all but the first bank is hidden behind programming.  A bank never
+ * programs and erases at the same time.  Returns the same codes as
+ * flash_write().
+ */
+struct flash_erase_run {
+	flash_info_t *info;
+	int first;		/* first sector of the range */
+	int last;		/* last sector of the range */
+	int next;		/* next sector to erase */
+	int busy;		/* sector being erased, or -1 */
+};
+
+/*
+ * Finish the erase in flight on a bank, if it is done or wait is set,
+ * and start the next one if more is set.
+ */
+static int flash_erase_step(struct flash_erase_run *r, int wait, int more)
+{
+	int st = ERR_OK;
+
+	if (r->busy >= 0) {
+		if (!wait && flash_is_busy(r->info, r->busy))
+			return ERR_OK;
+		st = flash_erase_wait(r->info, r->busy);
+		r->busy = -1;
+	}
+	if (more && st == ERR_OK && r->next <= r->last) {
+		flash_erase_start(r->info, r->next);
+		r->busy = r->next++;
+	}
+	return st;
+}
+
+int flash_erase_write(uchar *src, ulong addr, ulong cnt)
+{
+	struct flash_erase_run run[CFI_MAX_FLASH_BANKS];
+	flash_info_t *info_first = addr2info(addr);
+	flash_info_t *info_last = addr2info(addr + cnt - 1);
+	flash_info_t *info;
+	ulong end = addr + cnt;
+	int n, b, o, i, rc = ERR_OK, st;
+
+	if (cnt == 0)
+		return ERR_OK;
+	if (!info_first || !info_last)
+		return ERR_INVAL;
+
+	for (n = 0, info = info_first; info <= info_last; ++info, ++n) {
+		struct flash_erase_run *r = &run[n];
+
+		r->info = info;
+		r->first = (addr > info->start[0]) ? find_sector(info, addr) : 0;
+		r->last = (end < info->start[0] + info->size) ?
+			find_sector(info, end - 1) : info->sector_count - 1;
+		r->next = r->first;
+		r->busy = -1;
+		for (i = r->first; i <= r->last; i++)
+			if (info->protect[i])
+				return ERR_PROTECTED;
+	}
+
+	/* Get the later banks going before the first one is programmed */
+	for (b = 1; b < n; b++)
+		flash_erase_step(&run[b], 0, 1);
+
+	for (b = 0; b < n && rc == ERR_OK; b++) {
+		struct flash_erase_run *r = &run[b];
+
+		info = r->info;
+		for (i = r->first; i <= r->last && rc == ERR_OK; i++) {
+			ulong s_start = info->start[i];
+			ulong s_end = s_start + flash_sector_size(info, i);
+			ulong len;
+
+			/* This bank erases sector i, and nothing after it */
+			if (r->busy < 0 && r->next <= i) {
+				flash_erase_start(info, i);
+				r->busy = i;
+				r->next = i + 1;
+			}
+			rc = flash_erase_step(r, 1, 0);
+
+			/* Keep the banks still to come erasing meanwhile */
+			for (o = b + 1; o < n && rc == ERR_OK; o++)
+				rc = flash_erase_step(&run[o], 0, 1);
+			if (rc != ERR_OK)
+				break;
+
+			if (s_start < addr)
+				s_start = addr;
+			if (s_end > end)
+				s_end = end;
+			len = s_end - s_start;
+			rc = flash_write_buff(info, src, s_start, len, 0);
+			src += len;
+			if (flash_verbose)
+				putc('.');
+		}
+	}
+
+	/* Leave no erase running behind our back */
+	for (b = 0; b < n; b++) {
+		st = flash_erase_step(&run[b], 1, 0);
+		if (rc == ERR_OK)
+			rc = st;
+		flash_read_cached(run[b].info, addr, b ? 0 : cnt);
+	}
+
+	return rc;
+}
+#endif /* CONFIG_SYS_FLASH_ERASE_PIPELINE */
+
 /*-----------------------------------------------------------------------
  */
 #ifdef CONFIG_SYS_FLASH_PROTECTION
@@ -1480,6 +1796,7 @@ int flash_real_protect (flash_info_t * info, long sector, int prot)
 			}
 		}
 	}
+	flash_read_cached(info, 0, 0);
 	return retcode;
 }
 
@@ -1499,6 +1816,7 @@ void flash_read_user_serial (flash_info_t * info, void *buffer, int offset,
 	flash_write_cmd (info, 0, 0, info->cmd_reset);
 	udelay(1);
 	flash_unmap(info, 0, FLASH_OFFSET_USER_PROTECTION, src);
+	flash_read_cached(info, 0, 0);
 }
 
 /*
@@ -1515,6 +1833,7 @@ void flash_read_factory_serial (flash_info_t * info, void *buffer, int offset,
 	flash_write_cmd (info, 0, 0, info->cmd_reset);
 	udelay(1);
 	flash_unmap(info, 0, FLASH_OFFSET_INTEL_PROTECTION, src);
+	flash_read_cached(info, 0, 0);
 }
 
 #endif /* CONFIG_SYS_FLASH_PROTECTION */
@@ -2173,6 +2492,10 @@ unsigned long flash_init (void)
 	/* Init: no FLASHes known */
 	for (i = 0; i < CONFIG_SYS_MAX_FLASH_BANKS; ++i) {
 		flash_info[i].flash_id = FLASH_UNKNOWN;
+#ifdef CONFIG_SYS_FLASH_CACHED_READ
+		/* the board maps it cache-inhibited until it is found */
+		flash_cmd_mode[i] = 1;
+#endif
 
 		/* Optionally write flash configuration register */
 		cfi_flash_set_config_reg(cfi_flash_bank_addr(i),
@@ -2237,6 +2560,10 @@ unsigned long flash_init (void)
 			}
 		}
 #endif /* CONFIG_SYS_FLASH_PROTECTION */
+
+		/* Detection left the bank uncached */
+		if (flash_info[i].flash_id != FLASH_UNKNOWN)
+			flash_read_cached(&flash_info[i], 0, 0);
 	}
 
 	flash_protect_default();
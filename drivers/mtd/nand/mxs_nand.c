@@ -55,6 +55,14 @@ struct mxs_nand_info {
 	uint8_t		*data_buf;
 	uint8_t		*oob_buf;
 
+	/* Second page buffer, filled while the page in the first is checked */
+	uint8_t		*data_buf2;
+	uint8_t		*oob_buf2;
+
+	/* Buffers holding the page of the last completed read */
+	uint8_t		*read_data;
+	uint8_t		*read_oob;
+
 	uint8_t		marking_block_bad;
 	uint8_t		raw_oob_mode;
 
@@ -503,17 +511,25 @@ static uint8_t mxs_nand_read_byte(struct mtd_info *mtd)
 }
 
 /*
- * Read a page from NAND.
+ * Start reading a page from NAND into the free one of the two page buffers.
+ * The BCH block decodes the page while it is transferred.
  */
-static int mxs_nand_ecc_read_page(struct mtd_info *mtd, struct nand_chip *nand,
+static int mxs_nand_ecc_read_page_start(struct mtd_info *mtd,
+					struct nand_chip *nand,
 					uint8_t *buf, int page)
 {
 	struct mxs_nand_info *nand_info = nand->priv;
 	struct mxs_dma_desc *d;
 	uint32_t channel = MXS_DMA_CHANNEL_AHB_APBH_GPMI0 + nand_info->cur_chip;
-	uint32_t corrected = 0, failed = 0;
-	uint8_t	*status;
-	int i, ret;
+	uint8_t *tmp;
+
+	/* The other buffer may still hold the page being checked */
+	tmp = nand_info->data_buf;
+	nand_info->data_buf = nand_info->data_buf2;
+	nand_info->data_buf2 = tmp;
+	tmp = nand_info->oob_buf;
+	nand_info->oob_buf = nand_info->oob_buf2;
+	nand_info->oob_buf2 = tmp;
 
 	/* Compile the DMA descriptor - wait for ready. */
 	d = mxs_nand_get_dma_desc(nand_info);
@@ -587,24 +603,61 @@ static int mxs_nand_ecc_read_page(struct mtd_info *mtd, struct nand_chip *nand,
 
 	mxs_dma_desc_append(channel, d);
 
-	/* Execute the DMA chain. */
-	ret = mxs_dma_go(channel);
+	/* Start the DMA chain. */
+	mxs_dma_start(channel);
+
+	return 0;
+}
+
+/*
+ * Wait for the read started by mxs_nand_ecc_read_page_start().
+ */
+static int mxs_nand_ecc_read_page_wait(struct mtd_info *mtd,
+					struct nand_chip *nand)
+{
+	struct mxs_nand_info *nand_info = nand->priv;
+	uint32_t channel = MXS_DMA_CHANNEL_AHB_APBH_GPMI0 + nand_info->cur_chip;
+	int ret;
+
+	nand_info->read_data = nand_info->data_buf;
+	nand_info->read_oob = nand_info->oob_buf;
+
+	ret = mxs_dma_wait(channel);
 	if (ret) {
 		printf("MXS NAND: DMA read error\n");
 		goto rtn;
 	}
 
 	ret = mxs_nand_wait_for_bch_complete();
-	if (ret) {
+	if (ret)
 		printf("MXS NAND: BCH read timeout\n");
-		goto rtn;
-	}
+
+rtn:
+	mxs_nand_return_dma_descs(nand_info);
+
+	return ret;
+}
+
+/*
+ * Deliver the page read by mxs_nand_ecc_read_page_wait() and account for
+ * the bit errors the BCH block has corrected.
+ */
+static int mxs_nand_ecc_read_page_correct(struct mtd_info *mtd,
+					struct nand_chip *nand,
+					uint8_t *buf, int page)
+{
+	struct mxs_nand_info *nand_info = nand->priv;
+	uint8_t *data_buf = nand_info->read_data;
+	uint8_t *oob_buf = nand_info->read_oob;
+	uint32_t corrected = 0, failed = 0;
+	uint8_t	*status;
+	int i;
 
 	/* Read DMA completed, now do the mark swapping. */
-	mxs_nand_swap_block_mark(mtd, nand_info->data_buf, nand_info->oob_buf);
+	mxs_nand_swap_block_mark(mtd, data_buf, oob_buf);
 
 	/* Loop over status bytes, accumulating ECC status. */
-	status = nand_info->oob_buf + mxs_nand_aux_status_offset();
+	status = oob_buf + mxs_nand_aux_status_offset();
 	for (i = 0; i < mxs_nand_ecc_chunk_cnt(mtd->writesize); i++) {
 		if (status[i] == 0x00)
 			continue;
@@ -635,14 +688,30 @@ static int mxs_nand_ecc_read_page(struct mtd_info *mtd, struct nand_chip *nand,
 	 */
 	memset(nand->oob_poi, 0xff, mtd->oobsize);
 
-	nand->oob_poi[0] = nand_info->oob_buf[0];
+	nand->oob_poi[0] = oob_buf[0];
 
-	memcpy(buf, nand_info->data_buf, mtd->writesize);
+	memcpy(buf, data_buf, mtd->writesize);
 
-rtn:
-	mxs_nand_return_dma_descs(nand_info);
+	return 0;
+}
 
-	return ret;
+/*
+ * Read a page from NAND.
+ */
+static int mxs_nand_ecc_read_page(struct mtd_info *mtd, struct nand_chip *nand,
+					uint8_t *buf, int page)
+{
+	int ret;
+
+	ret = mxs_nand_ecc_read_page_start(mtd, nand, buf, page);
+	if (ret)
+		return ret;
+
+	ret = mxs_nand_ecc_read_page_wait(mtd, nand);
+	if (ret)
+		return ret;
+
+	return mxs_nand_ecc_read_page_correct(mtd, nand, buf, page);
 }
 
 /*
@@ -976,19 +1045,22 @@ static int mxs_nand_scan_bbt(struct mtd_info *mtd)
 int mxs_nand_alloc_buffers(struct mxs_nand_info *nand_info)
 {
 	uint8_t *buf;
-	const int size = NAND_MAX_PAGESIZE + NAND_MAX_OOBSIZE;
+	const int size = ALIGN(NAND_MAX_PAGESIZE + NAND_MAX_OOBSIZE,
+				MXS_DMA_ALIGNMENT);
 
-	/* DMA buffers */
-	buf = memalign(MXS_DMA_ALIGNMENT, size);
+	/* DMA buffers, two pages so reads can overlap */
+	buf = memalign(MXS_DMA_ALIGNMENT, 2 * size);
 	if (!buf) {
 		printf("MXS NAND: Error allocating DMA buffers\n");
 		return -ENOMEM;
 	}
 
-	memset(buf, 0, size);
+	memset(buf, 0, 2 * size);
 
 	nand_info->data_buf = buf;
 	nand_info->oob_buf = buf + NAND_MAX_PAGESIZE;
+	nand_info->data_buf2 = buf + size;
+	nand_info->oob_buf2 = buf + size + NAND_MAX_PAGESIZE;
 
 	/* Command buffers */
 	nand_info->cmd_buf = memalign(MXS_DMA_ALIGNMENT,
@@ -1098,6 +1170,9 @@ int board_nand_init(struct nand_chip *nand)
 	nand->write_buf		= mxs_nand_write_buf;
 
 	nand->ecc.read_page	= mxs_nand_ecc_read_page;
+	nand->ecc.read_page_start	= mxs_nand_ecc_read_page_start;
+	nand->ecc.read_page_wait	= mxs_nand_ecc_read_page_wait;
+	nand->ecc.read_page_correct	= mxs_nand_ecc_read_page_correct;
 	nand->ecc.write_page	= mxs_nand_ecc_write_page;
 	nand->ecc.read_oob	= mxs_nand_ecc_read_oob;
 	nand->ecc.write_oob	= mxs_nand_ecc_write_oob;
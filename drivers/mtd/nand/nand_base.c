@@ -38,11 +38,14 @@
 
 #include <malloc.h>
 #include <watchdog.h>
+#include <blkstats.h>
+#include <wait_bit.h>
 #include <linux/err.h>
 #include <linux/mtd/compat.h>
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
 #include <linux/mtd/nand_ecc.h>
+#include <linux/mtd/nand_bch.h>
 
 #ifdef CONFIG_MTD_PARTITIONS
 #include <linux/mtd/partitions.h>
@@ -404,6 +407,42 @@ static int nand_check_wp(struct mtd_info *mtd)
 	return (chip->read_byte(mtd) & NAND_STATUS_WP) ? 0 : 1;
 }
 
+/**
+ * nand_block_bad_cached - [GENERIC] Check the marker of a block only once
+ * @mtd:	MTD device structure
+ * @ofs:	offset from device start
+ * @getchip:	0, if the chip is already selected
+ *
+ * Used when there is no bad block table in memory, e.g. with
+ * NAND_SKIP_BBTSCAN.  Every block's marker is read from the OOB the first
+ * time it is asked for; later checks, such as those of the skip-bad
+ * read and write loops, are answered from bbt_cache.
+ */
+static int nand_block_bad_cached(struct mtd_info *mtd, loff_t ofs, int getchip)
+{
+	struct nand_chip *chip = mtd->priv;
+	int block = (int)(ofs >> chip->bbt_erase_shift);
+	int shift = (block & 0x03) << 1;
+	int res;
+
+	if (!chip->bbt_cache) {
+		chip->bbt_cache = kzalloc((mtd->size >>
+					   (chip->bbt_erase_shift + 2)) + 1,
+					  GFP_KERNEL);
+		if (!chip->bbt_cache)
+			return chip->block_bad(mtd, ofs, getchip);
+	}
+
+	res = (chip->bbt_cache[block >> 2] >> shift) & 0x03;
+	if (res)
+		return res == 0x02;
+
+	res = chip->block_bad(mtd, ofs, getchip);
+	if (res >= 0)
+		chip->bbt_cache[block >> 2] |= (res ? 0x02 : 0x01) << shift;
+	return res;
+}
+
 /**
  * nand_block_checkbad - [GENERIC] Check if a block is marked bad
  * @mtd:	MTD device structure
@@ -425,7 +464,7 @@ static int nand_block_checkbad(struct mtd_info *mtd, loff_t ofs, int getchip,
 	}
 
 	if (!chip->bbt)
-		return chip->block_bad(mtd, ofs, getchip);
+		return nand_block_bad_cached(mtd, ofs, getchip);
 
 	/* Return info from the table */
 	return nand_isbad_bbt(mtd, ofs, allowbbt);
@@ -438,17 +477,16 @@ static int nand_block_checkbad(struct mtd_info *mtd, loff_t ofs, int getchip,
 void nand_wait_ready(struct mtd_info *mtd)
 {
 	struct nand_chip *chip = mtd->priv;
-	u32 timeo = (CONFIG_SYS_HZ * 20) / 1000;
-	u32 time_start;
+	struct wait_backoff wb;
 
-	time_start = get_timer(0);
+	wait_backoff_start(&wb, (CONFIG_SYS_HZ * 20) / 1000);
 
 	/* wait until command is processed or timeout occures */
-	while (get_timer(time_start) < timeo) {
+	do {
 		if (chip->dev_ready)
 			if (chip->dev_ready(mtd))
 				break;
-	}
+	} while (!wait_backoff(&wb));
 }
 
 /**
@@ -616,6 +654,7 @@ static void nand_command_lp(struct mtd_info *mtd, unsigned int command,
 	case NAND_CMD_PAGEPROG:
 	case NAND_CMD_ERASE1:
 	case NAND_CMD_ERASE2:
+	case NAND_CMD_ERASE2_MULTI:
 	case NAND_CMD_SEQIN:
 	case NAND_CMD_RNDIN:
 	case NAND_CMD_STATUS:
@@ -705,7 +744,10 @@ static int nand_wait(struct mtd_info *mtd, struct nand_chip *this)
 {
 	unsigned long	timeo;
 	int state = this->state;
+	struct wait_backoff wb;
+#ifdef PPCHAMELON_NAND_TIMER_HACK
 	u32 time_start;
+#endif
 
 	if (state == FL_ERASING)
 		timeo = (CONFIG_SYS_HZ * 400) / 1000;
@@ -717,14 +759,9 @@ static int nand_wait(struct mtd_info *mtd, struct nand_chip *this)
 	else
 		this->cmdfunc(mtd, NAND_CMD_STATUS, -1, -1);
 
-	time_start = get_timer(0);
+	wait_backoff_start(&wb, timeo);
 
 	while (1) {
-		if (get_timer(time_start) > timeo) {
-			printf("Timeout!");
-			return 0x01;
-		}
-
 		if (this->dev_ready) {
 			if (this->dev_ready(mtd))
 				break;
@@ -732,6 +769,11 @@ static int nand_wait(struct mtd_info *mtd, struct nand_chip *this)
 			if (this->read_byte(mtd) & NAND_STATUS_READY)
 				break;
 		}
+
+		if (wait_backoff(&wb)) {
+			printf("Timeout!");
+			return 0x01;
+		}
 	}
 #ifdef PPCHAMELON_NAND_TIMER_HACK
 	time_start = get_timer(0);
@@ -1120,6 +1162,120 @@ static uint8_t *nand_transfer_oob(struct nand_chip *chip, uint8_t *oob,
 	return NULL;
 }
 
+/**
+ * nand_read_pages_overlap - [Internal] Read whole pages, checking the ECC
+ *			     of one page while the next one is transferred
+ * @mtd:	MTD device structure
+ * @realpage:	first page to read, advanced past every page delivered
+ * @chipnr:	currently selected chip, updated on a chip boundary
+ * @buf:	buffer to store the pages
+ * @pages:	number of pages to read
+ *
+ * Only used when the driver provides ecc.read_page_start, _wait and
+ * _correct, i.e. when it can move a page into memory in the background.
+ */
+static int nand_read_pages_overlap(struct mtd_info *mtd, int *realpage,
+				   int *chipnr, uint8_t *buf, int pages)
+{
+	struct nand_chip *chip = mtd->priv;
+	int page = *realpage & chip->pagemask;
+	int next = 0, started, ret;
+
+	chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+	ret = chip->ecc.read_page_start(mtd, chip, buf, page);
+	if (ret < 0)
+		return ret;
+
+	while (pages--) {
+		WATCHDOG_RESET();
+
+		ret = chip->ecc.read_page_wait(mtd, chip);
+		if (ret < 0)
+			return ret;
+
+		/* Get the next page moving before looking at this one */
+		started = 0;
+		if (pages) {
+			next = (*realpage + 1) & chip->pagemask;
+			if (!next) {
+				(*chipnr)++;
+				chip->select_chip(mtd, -1);
+				chip->select_chip(mtd, *chipnr);
+			}
+			chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, next);
+			started = chip->ecc.read_page_start(mtd, chip,
+					buf + mtd->writesize, next) == 0;
+		}
+
+		ret = chip->ecc.read_page_correct(mtd, chip, buf, page);
+		if (ret >= 0)
+			(*realpage)++;
+		if (ret < 0 || (pages && !started)) {
+			if (started)
+				chip->ecc.read_page_wait(mtd, chip);
+			return ret < 0 ? ret : -EIO;
+		}
+
+		buf += mtd->writesize;
+		page = next;
+	}
+	return 0;
+}
+
+/**
+ * nand_read_pages_cache - [Internal] Read whole pages in cache read mode
+ * @mtd:	MTD device structure
+ * @realpage:	first page to read, advanced past every page delivered
+ * @chipnr:	currently selected chip, updated on a chip boundary
+ * @buf:	buffer to store the pages
+ * @pages:	number of pages to read
+ *
+ * READ CACHE SEQUENTIAL lets the chip load the next page of a block from
+ * the array while the current one is transferred, hiding tR on all but
+ * the first page of every block.
+ */
+static int nand_read_pages_cache(struct mtd_info *mtd, int *realpage,
+				 int *chipnr, uint8_t *buf, int pages)
+{
+	struct nand_chip *chip = mtd->priv;
+	int ppb = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int page, run, i, ret;
+
+	while (pages) {
+		page = *realpage & chip->pagemask;
+		run = min(pages, ppb - (page & (ppb - 1)));
+
+		chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
+		for (i = 0; i < run; i++) {
+			WATCHDOG_RESET();
+
+			if (run > 1)
+				chip->cmdfunc(mtd, i < run - 1 ?
+					      NAND_CMD_READCACHESEQ :
+					      NAND_CMD_READCACHEEND, -1, -1);
+			ret = chip->ecc.read_page(mtd, chip, buf, page + i);
+			if (ret < 0) {
+				/* Leave cache mode, the chip may be busy */
+				if (i < run - 1)
+					chip->cmdfunc(mtd, NAND_CMD_RESET,
+						      -1, -1);
+				return ret;
+			}
+			buf += mtd->writesize;
+			(*realpage)++;
+		}
+		pages -= run;
+
+		/* Check, if we cross a chip boundary */
+		if (pages && !(*realpage & chip->pagemask)) {
+			(*chipnr)++;
+			chip->select_chip(mtd, -1);
+			chip->select_chip(mtd, *chipnr);
+		}
+	}
+	return 0;
+}
+
 /**
  * nand_do_read_ops - [Internal] Read data with ECC
  *
@@ -1155,6 +1311,35 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	buf = ops->datbuf;
 	oob = ops->oobbuf;
 
+	/*
+	 * Runs of whole pages are read with the driver overlapping the
+	 * transfers, or with the chip's cache read.
+	 */
+	if ((chip->ecc.read_page_start || (chip->options & NAND_CACHEREAD)) &&
+	    !oob && !col && ops->mode != MTD_OOB_RAW &&
+	    readlen >= 2 * mtd->writesize) {
+		int first = realpage;
+
+		if (chip->ecc.read_page_start)
+			ret = nand_read_pages_overlap(mtd, &realpage, &chipnr,
+					buf, readlen >> chip->page_shift);
+		else
+			ret = nand_read_pages_cache(mtd, &realpage, &chipnr,
+					buf, readlen >> chip->page_shift);
+		readlen -= (realpage - first) << chip->page_shift;
+		buf += (realpage - first) << chip->page_shift;
+		if (ret < 0 || !readlen)
+			goto out;
+
+		/* The tail is read below, maybe from the next chip */
+		page = realpage & chip->pagemask;
+		if (!page) {
+			chipnr++;
+			chip->select_chip(mtd, -1);
+			chip->select_chip(mtd, chipnr);
+		}
+	}
+
 	while(1) {
 		WATCHDOG_RESET();
 
@@ -1249,6 +1434,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 			sndcmd = 1;
 	}
 
+out:
 	ops->retlen = ops->len - (size_t) readlen;
 	if (oob)
 		ops->oobretlen = ops->ooblen - oobreadlen;
@@ -1276,6 +1462,7 @@ static int nand_read(struct mtd_info *mtd, loff_t from, size_t len,
 		     size_t *retlen, uint8_t *buf)
 {
 	struct nand_chip *chip = mtd->priv;
+	unsigned long long t;
 	int ret;
 
 	/* Do not allow reads past end of device */
@@ -1290,7 +1477,9 @@ static int nand_read(struct mtd_info *mtd, loff_t from, size_t len,
 	chip->ops.datbuf = buf;
 	chip->ops.oobbuf = NULL;
 
+	t = blkstats_start();
 	ret = nand_do_read_ops(mtd, from, &chip->ops);
+	blkstats_mtd_end(mtd->name, BLKSTATS_READ, chip->ops.retlen, t);
 
 	*retlen = chip->ops.retlen;
 
@@ -1751,10 +1940,15 @@ static int nand_write_page(struct mtd_info *mtd, struct nand_chip *chip,
 		chip->ecc.write_page(mtd, chip, buf);
 
 	/*
-	 * Cached progamming disabled for now, Not sure if its worth the
-	 * trouble. The speed gain is not very impressive. (2.3->2.6Mib/s)
+	 * Cached programming is only used for chips announcing it in their
+	 * ONFI parameter page.  For the others it is not worth the trouble,
+	 * the speed gain is not very impressive. (2.3->2.6Mib/s)
 	 */
+#ifdef CONFIG_MTD_NAND_VERIFY_WRITE
 	cached = 0;
+#endif
+	if (!(chip->options & NAND_CACHEPRG_ONFI))
+		cached = 0;
 
 	if (!cached || !(chip->options & NAND_CACHEPRG)) {
 
@@ -1773,6 +1967,9 @@ static int nand_write_page(struct mtd_info *mtd, struct nand_chip *chip,
 	} else {
 		chip->cmdfunc(mtd, NAND_CMD_CACHEDPROG, -1, -1);
 		status = chip->waitfunc(mtd, chip);
+		/* Only the result of the previous page is known by now */
+		if (status & NAND_STATUS_FAIL_N1)
+			return -EIO;
 	}
 
 #ifdef CONFIG_MTD_NAND_VERIFY_WRITE
@@ -1948,6 +2145,7 @@ static int nand_write(struct mtd_info *mtd, loff_t to, size_t len,
 			  size_t *retlen, const uint8_t *buf)
 {
 	struct nand_chip *chip = mtd->priv;
+	unsigned long long t;
 	int ret;
 
 	/* Do not allow writes past end of device */
@@ -1962,7 +2160,9 @@ static int nand_write(struct mtd_info *mtd, loff_t to, size_t len,
 	chip->ops.datbuf = (uint8_t *)buf;
 	chip->ops.oobbuf = NULL;
 
+	t = blkstats_start();
 	ret = nand_do_write_ops(mtd, to, &chip->ops);
+	blkstats_mtd_end(mtd->name, BLKSTATS_WRITE, chip->ops.retlen, t);
 
 	*retlen = chip->ops.retlen;
 
@@ -2141,6 +2341,70 @@ static int nand_erase(struct mtd_info *mtd, struct erase_info *instr)
 }
 
 #define BBT_PAGE_MASK	0xffffff3f
+
+/*
+ * Erases in progress, one per chip.  With CONFIG_SYS_NAND_ERASE_INTERLEAVE
+ * an erase is started on every chip of the range before waiting for the
+ * first one, so the busy times of the chips overlap.
+ */
+#ifdef CONFIG_SYS_NAND_ERASE_INTERLEAVE
+#define NAND_ERASE_LANES	CONFIG_SYS_NAND_MAX_CHIPS
+#else
+#define NAND_ERASE_LANES	1
+#endif
+
+struct nand_erase_lane {
+	int chipnr;
+	int page;		/* next page to erase */
+	int end;		/* page after the last one on this chip */
+	int blocks;		/* blocks of the erase in progress */
+};
+
+/**
+ * nand_erase_group - [Internal] number of blocks to erase with one command
+ * @chip:	NAND chip structure
+ * @page:	first page of the block
+ * @end:	page after the last one to erase on this chip
+ *
+ * A block on each plane is erased at once when the chip has multi-plane
+ * erase and the range covers the whole group.
+ */
+static int nand_erase_group(struct nand_chip *chip, int page, int end)
+{
+	int pages_per_block = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int n = 1 << chip->plane_shift;
+
+	if (!(chip->options & NAND_MULTIPLANE_ERASE))
+		return 1;
+	if (((page / pages_per_block) & (n - 1)) ||
+	    end - page < n * pages_per_block)
+		return 1;
+	return n;
+}
+
+/**
+ * nand_erase_start - [Internal] start the erase of one or more blocks
+ * @mtd:	MTD device structure
+ * @page:	first page of the first block
+ * @blocks:	number of blocks, one per plane
+ *
+ * The chip must already be selected.  The caller waits for the erase.
+ */
+static void nand_erase_start(struct mtd_info *mtd, int page, int blocks)
+{
+	struct nand_chip *chip = mtd->priv;
+	int pages_per_block = 1 << (chip->phys_erase_shift - chip->page_shift);
+
+	while (--blocks) {
+		chip->cmdfunc(mtd, NAND_CMD_ERASE1, -1, page & chip->pagemask);
+		chip->cmdfunc(mtd, NAND_CMD_ERASE2_MULTI, -1, -1);
+		/* tDBSY, before the next plane can be addressed */
+		chip->waitfunc(mtd, chip);
+		page += pages_per_block;
+	}
+	chip->erase_cmd(mtd, page & chip->pagemask);
+}
+
 /**
  * nand_erase_nand - [Internal] erase block(s)
  * @mtd:	MTD device structure
@@ -2155,8 +2419,11 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 	int page, status, pages_per_block, ret, chipnr;
 	struct nand_chip *chip = mtd->priv;
 	loff_t rewrite_bbt[CONFIG_SYS_NAND_MAX_CHIPS] = {0};
+	struct nand_erase_lane lane[CONFIG_SYS_NAND_MAX_CHIPS];
+	struct nand_erase_lane *l;
 	unsigned int bbt_masked_page = 0xffffffff;
-	loff_t len;
+	unsigned int masked_page;
+	int i, b, busy, next, nlanes, failed, cur;
 
 	MTDDEBUG(MTD_DEBUG_LEVEL3, "nand_erase: start = 0x%012llx, "
 		 "len = %llu\n", (unsigned long long) instr->addr,
@@ -2196,6 +2463,7 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 
 	/* Select the NAND device */
 	chip->select_chip(mtd, chipnr);
+	cur = chipnr;
 
 	/* Check, if it is write protected */
 	if (nand_check_wp(mtd)) {
@@ -2214,81 +2482,136 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 	if (chip->options & BBT_AUTO_REFRESH && !allowbbt)
 		bbt_masked_page = chip->bbt_td->pages[chipnr] & BBT_PAGE_MASK;
 
-	/* Loop through the pages */
-	len = instr->len;
+	/* Split the range at the chip boundaries */
+	nlanes = (int)((instr->addr + instr->len - 1) >> chip->chip_shift) -
+		chipnr + 1;
+	for (i = 0; i < nlanes; i++) {
+		l = &lane[i];
+		l->chipnr = chipnr + i;
+		l->page = i ? (l->chipnr << (chip->chip_shift - chip->page_shift))
+			: page;
+		l->end = (l->page | chip->pagemask) + 1;
+		if (i == nlanes - 1)
+			l->end = (int)((instr->addr + instr->len) >>
+				       chip->page_shift);
+		l->blocks = 0;
+	}
 
 	instr->state = MTD_ERASING;
+	failed = 0;
+	next = 0;
 
-	while (len) {
+	while (next < nlanes) {
 		WATCHDOG_RESET();
-		/*
-		 * heck if we have a bad block, we do not erase bad blocks !
-		 */
-		if (!instr->scrub && nand_block_checkbad(mtd, ((loff_t) page) <<
-					chip->page_shift, 0, allowbbt)) {
-			printk(KERN_WARNING "nand_erase: attempt to erase a "
-			       "bad block at page 0x%08x\n", page);
-			instr->state = MTD_ERASE_FAILED;
-			goto erase_exit;
-		}
 
-		/*
-		 * Invalidate the page cache, if we erase the block which
-		 * contains the current cached page
-		 */
-		if (page <= chip->pagebuf && chip->pagebuf <
-		    (page + pages_per_block))
-			chip->pagebuf = -1;
+		/* Start an erase on each chip that is taking part */
+		for (i = next, busy = 0; i < nlanes && busy < NAND_ERASE_LANES;
+		     i++) {
+			l = &lane[i];
+			if (l->page == l->end)
+				continue;
+
+			if (cur != l->chipnr) {
+				chip->select_chip(mtd, -1);
+				chip->select_chip(mtd, l->chipnr);
+				cur = l->chipnr;
+			}
 
-		chip->erase_cmd(mtd, page & chip->pagemask);
+			/*
+			 * heck if we have a bad block, we do not erase bad
+			 * blocks !
+			 */
+			if (!instr->scrub && nand_block_checkbad(mtd,
+					((loff_t) l->page) << chip->page_shift,
+					0, allowbbt)) {
+				printk(KERN_WARNING "nand_erase: attempt to "
+				       "erase a bad block at page 0x%08x\n",
+				       l->page);
+				failed = 1;
+				break;
+			}
 
-		status = chip->waitfunc(mtd, chip);
+			/* The other planes must not hold a bad block either */
+			l->blocks = nand_erase_group(chip, l->page, l->end);
+			for (b = 1; b < l->blocks && !instr->scrub; b++)
+				if (nand_block_checkbad(mtd, ((loff_t) l->page +
+						b * pages_per_block) <<
+						chip->page_shift, 0, allowbbt))
+					l->blocks = 1;
 
-		/*
-		 * See if operation failed and additional status checks are
-		 * available
-		 */
-		if ((status & NAND_STATUS_FAIL) && (chip->errstat))
-			status = chip->errstat(mtd, chip, FL_ERASING,
-					       status, page);
+			/*
+			 * Invalidate the page cache, if we erase the block
+			 * which contains the current cached page
+			 */
+			if (l->page <= chip->pagebuf && chip->pagebuf <
+			    (l->page + l->blocks * pages_per_block))
+				chip->pagebuf = -1;
 
-		/* See if block erase succeeded */
-		if (status & NAND_STATUS_FAIL) {
-			MTDDEBUG (MTD_DEBUG_LEVEL0, "nand_erase: "
-				  "Failed erase, page 0x%08x\n", page);
-			instr->state = MTD_ERASE_FAILED;
-			instr->fail_addr = ((loff_t)page << chip->page_shift);
-			goto erase_exit;
+			nand_erase_start(mtd, l->page, l->blocks);
+			busy++;
 		}
 
-		/*
-		 * If BBT requires refresh, set the BBT rewrite flag to the
-		 * page being erased
-		 */
-		if (bbt_masked_page != 0xffffffff &&
-		    (page & BBT_PAGE_MASK) == bbt_masked_page)
-			rewrite_bbt[chipnr] =
-				((loff_t)page << chip->page_shift);
+		/* Wait for them in the same order */
+		for (i = next; i < nlanes; i++) {
+			l = &lane[i];
+			if (!l->blocks)
+				continue;
 
-		/* Increment page address and decrement length */
-		len -= (1 << chip->phys_erase_shift);
-		page += pages_per_block;
+			if (cur != l->chipnr) {
+				chip->select_chip(mtd, -1);
+				chip->select_chip(mtd, l->chipnr);
+				cur = l->chipnr;
+			}
 
-		/* Check, if we cross a chip boundary */
-		if (len && !(page & chip->pagemask)) {
-			chipnr++;
-			chip->select_chip(mtd, -1);
-			chip->select_chip(mtd, chipnr);
+			status = chip->waitfunc(mtd, chip);
+
+			/*
+			 * See if operation failed and additional status checks
+			 * are available
+			 */
+			if ((status & NAND_STATUS_FAIL) && (chip->errstat))
+				status = chip->errstat(mtd, chip, FL_ERASING,
+						       status, l->page);
+
+			/* See if block erase succeeded */
+			if (status & NAND_STATUS_FAIL) {
+				MTDDEBUG (MTD_DEBUG_LEVEL0, "nand_erase: "
+					  "Failed erase, page 0x%08x\n",
+					  l->page);
+				if (!failed)
+					instr->fail_addr = ((loff_t)l->page <<
+							    chip->page_shift);
+				failed = 1;
+				l->blocks = 0;
+				continue;
+			}
 
 			/*
-			 * If BBT requires refresh and BBT-PERCHIP, set the BBT
-			 * page mask to see if this BBT should be rewritten
+			 * If BBT requires refresh, set the BBT rewrite flag to
+			 * the page being erased.  With BBT-PERCHIP each chip
+			 * has its own table.
 			 */
-			if (bbt_masked_page != 0xffffffff &&
+			masked_page = bbt_masked_page;
+			if (masked_page != 0xffffffff &&
 			    (chip->bbt_td->options & NAND_BBT_PERCHIP))
-				bbt_masked_page = chip->bbt_td->pages[chipnr] &
+				masked_page = chip->bbt_td->pages[l->chipnr] &
 					BBT_PAGE_MASK;
+
+			for (b = 0; b < l->blocks; b++, l->page += pages_per_block)
+				if (masked_page != 0xffffffff &&
+				    (l->page & BBT_PAGE_MASK) == masked_page)
+					rewrite_bbt[l->chipnr] =
+						((loff_t)l->page << chip->page_shift);
+			l->blocks = 0;
+		}
+
+		if (failed) {
+			instr->state = MTD_ERASE_FAILED;
+			goto erase_exit;
 		}
+
+		while (next < nlanes && lane[next].page == lane[next].end)
+			next++;
 	}
 	instr->state = MTD_ERASE_DONE;
 
@@ -2373,7 +2696,14 @@ static int nand_block_markbad(struct mtd_info *mtd, loff_t ofs)
 		return ret;
 	}
 
-	return chip->block_markbad(mtd, ofs);
+	ret = chip->block_markbad(mtd, ofs);
+	if (!ret && chip->bbt_cache) {
+		int block = (int)(ofs >> chip->bbt_erase_shift);
+
+		chip->bbt_cache[block >> 2] &= ~(0x03 << ((block & 0x03) << 1));
+		chip->bbt_cache[block >> 2] |= 0x02 << ((block & 0x03) << 1);
+	}
+	return ret;
 }
 
 /*
@@ -2673,6 +3003,25 @@ static const struct nand_flash_dev *nand_get_flash_type(struct mtd_info *mtd,
 	if (mtd->writesize > 512 && chip->cmdfunc == nand_command)
 		chip->cmdfunc = nand_command_lp;
 
+#ifdef CONFIG_SYS_NAND_ONFI_DETECTION
+	/* The cache commands are only known to nand_command_lp() */
+	if (chip->onfi_version && chip->cmdfunc == nand_command_lp) {
+		int opt = le16_to_cpu(chip->onfi_params.opt_cmd);
+
+		if (opt & ONFI_OPT_CMD_READ_CACHE)
+			chip->options |= NAND_CACHEREAD;
+		if (opt & ONFI_OPT_CMD_PROG_CACHE)
+			chip->options |= NAND_CACHEPRG | NAND_CACHEPRG_ONFI;
+
+		/* Blocks in different planes are erased with 60h-D1h */
+		chip->plane_shift = chip->onfi_params.interleaved_bits & 0x0f;
+		if (chip->plane_shift && chip->erase_cmd == single_erase_cmd &&
+		    (le16_to_cpu(chip->onfi_params.features) &
+		     ONFI_FEATURE_INTERLEAVED))
+			chip->options |= NAND_MULTIPLANE_ERASE;
+	}
+#endif
+
 	MTDDEBUG (MTD_DEBUG_LEVEL0, "NAND device: Manufacturer ID:"
 		  " 0x%02x, Chip ID: 0x%02x (%s %s)\n", *maf_id, *dev_id,
 		  nand_manuf_ids[maf_idx].name, type->name);
@@ -2763,7 +3112,7 @@ int nand_scan_tail(struct mtd_info *mtd)
 	/*
 	 * If no default placement scheme is given, select an appropriate one
 	 */
-	if (!chip->ecc.layout) {
+	if (!chip->ecc.layout && (chip->ecc.mode != NAND_ECC_SOFT_BCH)) {
 		switch (mtd->oobsize) {
 		case 8:
 			chip->ecc.layout = &nand_oob_8;
@@ -2864,6 +3213,40 @@ int nand_scan_tail(struct mtd_info *mtd)
 		chip->ecc.bytes = 3;
 		break;
 
+	case NAND_ECC_SOFT_BCH:
+		if (!mtd_nand_has_bch()) {
+			printk(KERN_WARNING "CONFIG_NAND_ECC_BCH not enabled\n");
+			BUG();
+		}
+		chip->ecc.calculate = nand_bch_calculate_ecc;
+		chip->ecc.correct = nand_bch_correct_data;
+		chip->ecc.read_page = nand_read_page_swecc;
+		chip->ecc.read_subpage = nand_read_subpage;
+		chip->ecc.write_page = nand_write_page_swecc;
+		chip->ecc.read_page_raw = nand_read_page_raw;
+		chip->ecc.write_page_raw = nand_write_page_raw;
+		chip->ecc.read_oob = nand_read_oob_std;
+		chip->ecc.write_oob = nand_write_oob_std;
+		/*
+		 * Board driver should supply ecc.size and ecc.bytes values to
+		 * select how many bits are correctable; see nand_bch_init()
+		 * for details.  Otherwise, default to 4 bits for large page
+		 * devices.
+		 */
+		if (!chip->ecc.size && (mtd->oobsize >= 64)) {
+			chip->ecc.size = 512;
+			chip->ecc.bytes = 7;
+		}
+		chip->ecc.priv = nand_bch_init(mtd,
+					       chip->ecc.size,
+					       chip->ecc.bytes,
+					       &chip->ecc.layout);
+		if (!chip->ecc.priv) {
+			printk(KERN_WARNING "BCH ECC initialization failed!\n");
+			BUG();
+		}
+		break;
+
 	case NAND_ECC_NONE:
 		printk(KERN_WARNING "NAND_ECC_NONE selected by board driver. "
 		       "This is not recommended !!\n");
@@ -2924,6 +3307,15 @@ int nand_scan_tail(struct mtd_info *mtd)
 	}
 	chip->subpagesize = mtd->writesize >> mtd->subpage_sft;
 
+	/*
+	 * Cache read keeps the chip in a command sequence across pages; a
+	 * driver's own read_page may send commands that would break it.
+	 */
+	if (chip->ecc.read_page != nand_read_page_hwecc &&
+	    chip->ecc.read_page != nand_read_page_swecc &&
+	    chip->ecc.read_page != nand_read_page_syndrome)
+		chip->options &= ~NAND_CACHEREAD;
+
 	/* Initialize state */
 	chip->state = FL_READY;
 
@@ -2996,6 +3388,7 @@ void nand_release(struct mtd_info *mtd)
 
 	/* Free bad block table memory */
 	kfree(chip->bbt);
+	kfree(chip->bbt_cache);
 	if (!(chip->options & NAND_OWN_BUFFERS))
 		kfree(chip->buffers);
 }
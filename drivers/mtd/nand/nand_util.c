@@ -12,7 +12,8 @@
  *			       and Thomas Gleixner (tglx@linutronix.de)
  *
  * Copyright (C) 2008 Nokia Corporation: drop_ffs() function by
- * Artem Bityutskiy <dedekind1@gmail.com> from mtd-utils
+ * Artem Bityutskiy <dedekind1@gmail.com> from mtd-utils, since
+ * reworked into drop_ffs_write()
  *
  * See file CREDITS for list of people who contributed to this
  * project.
@@ -48,6 +49,7 @@
 #include <asm/errno.h>
 #include <linux/mtd/mtd.h>
 #include <nand.h>
+#include <load_hash.h>
 #include <jffs2/jffs2.h>
 
 typedef struct erase_info erase_info_t;
@@ -57,6 +59,9 @@ typedef struct mtd_info	  mtd_info_t;
 #define cpu_to_je16(x) (x)
 #define cpu_to_je32(x) (x)
 
+/* Most blocks nand_erase_opts() hands to the driver in one call */
+#define NAND_ERASE_RUN	64
+
 /**
  * nand_erase_opts: - erase NAND flash with support for various options
  *		      (jffs2 formating)
@@ -73,6 +78,9 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 	struct jffs2_unknown_node cleanmarker;
 	erase_info_t erase;
 	unsigned long erase_length, erased_length; /* in blocks */
+	unsigned long run_blocks, i;
+	loff_t run_addr;
+	int run_failed;
 	int bbtest = 1;
 	int result;
 	int percent_complete = -1;
@@ -112,11 +120,12 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 			kfree(chip->bbt);
 		}
 		chip->bbt = NULL;
+		kfree(chip->bbt_cache);
+		chip->bbt_cache = NULL;
 	}
 
-	for (erased_length = 0;
-	     erased_length < erase_length;
-	     erase.addr += meminfo->erasesize) {
+	erased_length = 0;
+	while (erased_length < erase_length) {
 
 		WATCHDOG_RESET ();
 
@@ -132,6 +141,7 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 				if (!opts->spread)
 					erased_length++;
 
+				erase.addr += meminfo->erasesize;
 				continue;
 
 			} else if (ret < 0) {
@@ -142,53 +152,85 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 			}
 		}
 
-		erased_length++;
-
-		result = meminfo->erase(meminfo, &erase);
-		if (result != 0) {
-			printf("\n%s: MTD Erase failure: %d\n",
-			       mtd_device, result);
-			continue;
+		/*
+		 * Hand the following good blocks to the driver in one go, so
+		 * that it can keep several chips or planes busy at once.
+		 */
+		run_addr = erase.addr;
+		run_blocks = 1;
+		while (run_blocks < NAND_ERASE_RUN &&
+		       erased_length + run_blocks < erase_length &&
+		       run_addr + (run_blocks + 1) * meminfo->erasesize <=
+		       meminfo->size) {
+			if (!opts->scrub && bbtest &&
+			    meminfo->block_isbad(meminfo, run_addr +
+					run_blocks * meminfo->erasesize))
+				break;
+			run_blocks++;
 		}
 
-		/* format for JFFS2 ? */
-		if (opts->jffs2 && chip->ecc.layout->oobavail >= 8) {
-			chip->ops.ooblen = 8;
-			chip->ops.datbuf = NULL;
-			chip->ops.oobbuf = (uint8_t *)&cleanmarker;
-			chip->ops.ooboffs = 0;
-			chip->ops.mode = MTD_OOB_AUTO;
-
-			result = meminfo->write_oob(meminfo,
-			                            erase.addr,
-			                            &chip->ops);
-			if (result != 0) {
-				printf("\n%s: MTD writeoob failure: %d\n",
-				       mtd_device, result);
-				continue;
+		erase.len = run_blocks * meminfo->erasesize;
+		run_failed = meminfo->erase(meminfo, &erase);
+		erase.len = meminfo->erasesize;
+
+		for (i = 0; i < run_blocks; i++,
+		     erase.addr += meminfo->erasesize) {
+			erased_length++;
+
+			/* Redo a failed run block by block to find the culprit */
+			if (run_failed) {
+				result = run_blocks > 1 ?
+					meminfo->erase(meminfo, &erase) :
+					run_failed;
+				if (result != 0) {
+					printf("\n%s: MTD Erase failure: %d\n",
+					       mtd_device, result);
+					continue;
+				}
+			}
+			result = 0;
+
+			/* format for JFFS2 ? */
+			if (opts->jffs2 && chip->ecc.layout->oobavail >= 8) {
+				chip->ops.ooblen = 8;
+				chip->ops.datbuf = NULL;
+				chip->ops.oobbuf = (uint8_t *)&cleanmarker;
+				chip->ops.ooboffs = 0;
+				chip->ops.mode = MTD_OOB_AUTO;
+
+				result = meminfo->write_oob(meminfo,
+							    erase.addr,
+							    &chip->ops);
+				if (result != 0) {
+					printf("\n%s: MTD writeoob failure: "
+					       "%d\n", mtd_device, result);
+					continue;
+				}
 			}
-		}
-
-		if (!opts->quiet) {
-			unsigned long long n = erased_length * 100ULL;
-			int percent;
-
-			do_div(n, erase_length);
-			percent = (int)n;
-
-			/* output progress message only at whole percent
-			 * steps to reduce the number of messages printed
-			 * on (slow) serial consoles
-			 */
-			if (percent != percent_complete) {
-				percent_complete = percent;
-
-				printf("\rErasing at 0x%llx -- %3d%% complete.",
-				       erase.addr, percent);
 
-				if (opts->jffs2 && result == 0)
-					printf(" Cleanmarker written at 0x%llx.",
-					       erase.addr);
+			if (!opts->quiet) {
+				unsigned long long n = erased_length * 100ULL;
+				int percent;
+
+				do_div(n, erase_length);
+				percent = (int)n;
+
+				/* output progress message only at whole
+				 * percent steps to reduce the number of
+				 * messages printed on (slow) serial consoles
+				 */
+				if (percent != percent_complete) {
+					percent_complete = percent;
+
+					printf("\rErasing at 0x%llx -- %3d%% "
+					       "complete.", erase.addr,
+					       percent);
+
+					if (opts->jffs2 && result == 0)
+						printf(" Cleanmarker written "
+						       "at 0x%llx.",
+						       erase.addr);
+				}
 			}
 		}
 	}
@@ -427,25 +469,60 @@ static int check_skip_len(nand_info_t *nand, loff_t offset, size_t length)
 }
 
 #ifdef CONFIG_CMD_NAND_TRIMFFS
-static size_t drop_ffs(const nand_info_t *nand, const u_char *buf,
-			const size_t *len)
+/* Whether the len bytes at buf are all 0xff, compared a word at a time */
+static int is_all_ffs(const u_char *buf, size_t len)
 {
-	size_t i, l = *len;
+	const ulong *p;
 
-	for (i = l - 1; i >= 0; i--)
-		if (buf[i] != 0xFF)
-			break;
+	for (; len && ((ulong)buf & (sizeof(ulong) - 1)); len--)
+		if (*buf++ != 0xff)
+			return 0;
 
-	/* The resulting length must be aligned to the minimum flash I/O size */
-	l = i + 1;
-	l = (l + nand->writesize - 1) / nand->writesize;
-	l *=  nand->writesize;
+	for (p = (const ulong *)buf; len >= sizeof(ulong); len -= sizeof(ulong))
+		if (*p++ != ~0UL)
+			return 0;
 
-	/*
-	 * since the input length may be unaligned, prevent access past the end
-	 * of the buffer
-	 */
-	return min(l, *len);
+	for (buf = (const u_char *)p; len; len--)
+		if (*buf++ != 0xff)
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Writes len bytes from buf at the page aligned offset within one
+ * eraseblock, leaving out the pages that contain only 0xff: they stay
+ * erased, which is what UBI expects of its free space.  The pages in
+ * between are written in as few nand_write() calls as possible.
+ */
+static int drop_ffs_write(nand_info_t *nand, loff_t offset, size_t len,
+			  u_char *buf)
+{
+	size_t page = nand->writesize;
+	size_t n, run;
+	int rval;
+
+	while (len) {
+		for (run = 0; run < len; run += n) {
+			n = min(len - run, page);
+			if (is_all_ffs(buf + run, n))
+				break;
+		}
+
+		if (run) {
+			rval = nand_write(nand, offset, &run, buf);
+			if (rval)
+				return rval;
+		} else {
+			run = n;
+		}
+
+		offset += run;
+		buf += run;
+		len -= run;
+	}
+
+	return 0;
 }
 #endif
 
@@ -574,15 +651,18 @@ int nand_write_skip_bad(nand_info_t *nand, loff_t offset, size_t *length,
 		else
 #endif
 		{
-			truncated_write_size = write_size;
 #ifdef CONFIG_CMD_NAND_TRIMFFS
 			if (flags & WITH_DROP_FFS)
-				truncated_write_size = drop_ffs(nand, p_buffer,
-						&write_size);
+				rval = drop_ffs_write(nand, offset, write_size,
+						      p_buffer);
+			else
 #endif
-
-			rval = nand_write(nand, offset, &truncated_write_size,
-					p_buffer);
+			{
+				truncated_write_size = write_size;
+				rval = nand_write(nand, offset,
+						  &truncated_write_size,
+						  p_buffer);
+			}
 			offset += write_size;
 			p_buffer += write_size;
 		}
@@ -635,6 +715,11 @@ int nand_read_skip_bad(nand_info_t *nand, loff_t offset, size_t *length,
 		return -EINVAL;
 	}
 
+#ifndef CONFIG_LOAD_HASH
+	/*
+	 * With CONFIG_LOAD_HASH read block by block below instead, so that
+	 * each piece is checksummed while it is still in the cache.
+	 */
 	if (!need_skip) {
 		rval = nand_read (nand, offset, length, buffer);
 		if (!rval || rval == -EUCLEAN)
@@ -645,6 +730,7 @@ int nand_read_skip_bad(nand_info_t *nand, loff_t offset, size_t *length,
 			offset, rval);
 		return rval;
 	}
+#endif
 
 	while (left_to_read > 0) {
 		size_t block_offset = offset & (nand->erasesize - 1);
@@ -664,6 +750,18 @@ int nand_read_skip_bad(nand_info_t *nand, loff_t offset, size_t *length,
 		else
 			read_length = nand->erasesize - block_offset;
 
+#ifndef CONFIG_LOAD_HASH
+		/* Read the following good blocks in the same request */
+		while (read_length < left_to_read &&
+		       offset + read_length < nand->size &&
+		       !nand_block_isbad(nand, offset + read_length)) {
+			if (left_to_read - read_length < nand->erasesize)
+				read_length = left_to_read;
+			else
+				read_length += nand->erasesize;
+		}
+#endif
+
 		rval = nand_read (nand, offset, &read_length, p_buffer);
 		if (rval && rval != -EUCLEAN) {
 			printf ("NAND read from offset %llx failed %d\n",
@@ -671,6 +769,7 @@ int nand_read_skip_bad(nand_info_t *nand, loff_t offset, size_t *length,
 			*length -= left_to_read;
 			return rval;
 		}
+		load_hash_update((ulong)p_buffer, p_buffer, read_length);
 
 		left_to_read -= read_length;
 		offset       += read_length;
@@ -27,6 +27,7 @@
 #include <asm/io.h>
 #include <asm/errno.h>
 #include <malloc.h>
+#include <blkstats.h>
 
 /* It should access 16-bit instead of 8-bit */
 static void *memcpy_16(void *dst, const void *src, unsigned int len)
@@ -41,6 +42,40 @@ static void *memcpy_16(void *dst, const void *src, unsigned int len)
 	return ret;
 }
 
+/*
+ * BufferRAM copies go a 32-bit word at a time, four words per loop, when
+ * both buffers and the length allow: the bus controller splits words
+ * for the 16-bit device and, in Sync. Burst mode, bursts them, where
+ * halfword accesses each pay the full access time.
+ */
+static void *memcpy_bufferram(void *dst, const void *src, unsigned int len)
+{
+	u32 *d = dst;
+	const u32 *s = src;
+
+	if (((ulong)dst | (ulong)src | len) & 3)
+		return memcpy_16(dst, src, len);
+
+	for (len >>= 2; len >= 4; len -= 4) {
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		d[3] = s[3];
+		d += 4;
+		s += 4;
+	}
+	while (len--)
+		*d++ = *s++;
+	return dst;
+}
+
+/*
+ * Set while a read operation keeps the device in Sync. Burst mode from
+ * its first BufferRAM read to its last, so that the pages in between do
+ * not switch it on and off again.
+ */
+static int onenand_sync_held;
+
 /**
  *  onenand_oob_128 - oob info for Flex-Onenand with 4KB page
  *  For now, we expose only 64 out of 80 ecc bytes
@@ -535,7 +570,7 @@ static int onenand_read_bufferram(struct mtd_info *mtd, loff_t addr, int area,
 	bufferram = this->base + area;
 	bufferram += onenand_bufferram_offset(mtd, area);
 
-	memcpy_16(buffer, bufferram + offset, count);
+	memcpy_bufferram(buffer, bufferram + offset, count);
 
 	return 0;
 }
@@ -560,11 +595,13 @@ static int onenand_sync_read_bufferram(struct mtd_info *mtd, loff_t addr, int ar
 	bufferram = this->base + area;
 	bufferram += onenand_bufferram_offset(mtd, area);
 
-	this->mmcontrol(mtd, ONENAND_SYS_CFG1_SYNC_READ);
+	if (!onenand_sync_held)
+		this->mmcontrol(mtd, ONENAND_SYS_CFG1_SYNC_READ);
 
-	memcpy_16(buffer, bufferram + offset, count);
+	memcpy_bufferram(buffer, bufferram + offset, count);
 
-	this->mmcontrol(mtd, 0);
+	if (!onenand_sync_held)
+		this->mmcontrol(mtd, 0);
 
 	return 0;
 }
@@ -589,7 +626,7 @@ static int onenand_write_bufferram(struct mtd_info *mtd, loff_t addr, int area,
 	bufferram = this->base + area;
 	bufferram += onenand_bufferram_offset(mtd, area);
 
-	memcpy_16(bufferram + offset, buffer, count);
+	memcpy_bufferram(bufferram + offset, buffer, count);
 
 	return 0;
 }
@@ -868,6 +905,15 @@ static int onenand_read_ops_nolock(struct mtd_info *mtd, loff_t from,
 
 	stats = mtd->ecc_stats;
 
+	/*
+	 * Stay in Sync. Burst mode for the whole read: the loads and the
+	 * status reads in between work in either mode.
+	 */
+	if (this->read_bufferram == onenand_sync_read_bufferram) {
+		this->mmcontrol(mtd, ONENAND_SYS_CFG1_SYNC_READ);
+		onenand_sync_held = 1;
+	}
+
 	/* Read-while-load method */
 	/* Note: We can't use this feature in MLC */
 
@@ -959,6 +1005,11 @@ static int onenand_read_ops_nolock(struct mtd_info *mtd, loff_t from,
 		}
 	}
 
+	if (onenand_sync_held) {
+		onenand_sync_held = 0;
+		this->mmcontrol(mtd, 0);
+	}
+
 	/*
 	 * Return success, if no ECC failures, else -EBADMSG
 	 * fs driver will take care of that, because
@@ -1094,10 +1145,13 @@ int onenand_read(struct mtd_info *mtd, loff_t from, size_t len,
 		.datbuf = buf,
 		.oobbuf = NULL,
 	};
+	unsigned long long t;
 	int ret;
 
 	onenand_get_device(mtd, FL_READING);
+	t = blkstats_start();
 	ret = onenand_read_ops_nolock(mtd, from, &ops);
+	blkstats_mtd_end(mtd->name, BLKSTATS_READ, ops.retlen, t);
 	onenand_release_device(mtd);
 
 	*retlen = ops.retlen;
@@ -1637,10 +1691,13 @@ int onenand_write(struct mtd_info *mtd, loff_t to, size_t len,
 		.datbuf = (u_char *) buf,
 		.oobbuf = NULL,
 	};
+	unsigned long long t;
 	int ret;
 
 	onenand_get_device(mtd, FL_WRITING);
+	t = blkstats_start();
 	ret = onenand_write_ops_nolock(mtd, to, &ops);
+	blkstats_mtd_end(mtd->name, BLKSTATS_WRITE, ops.retlen, t);
 	onenand_release_device(mtd);
 
 	*retlen = ops.retlen;
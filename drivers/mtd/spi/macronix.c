@@ -49,12 +49,15 @@
 #define CMD_MX25XX_DP		0xb9	/* Deep Power-down */
 #define CMD_MX25XX_RES		0xab	/* Release from DP, and Read Signature */
 
+#define MX25XX_SR_QE		0x40	/* Quad Enable */
+
 struct macronix_spi_flash_params {
 	u16 idcode;
 	u16 page_size;
 	u16 pages_per_sector;
 	u16 sectors_per_block;
 	u16 nr_blocks;
+	u8 read_modes;
 	const char *name;
 };
 
@@ -113,8 +116,18 @@ static const struct macronix_spi_flash_params macronix_spi_flash_table[] = {
 		.pages_per_sector = 16,
 		.sectors_per_block = 16,
 		.nr_blocks = 256,
+		.read_modes = SF_DUAL_IO | SF_QUAD_IO,
 		.name = "MX25L12855E",
 	},
+	{
+		.idcode = 0x2019,
+		.page_size = 256,
+		.pages_per_sector = 16,
+		.sectors_per_block = 16,
+		.nr_blocks = 512,
+		.read_modes = SF_DUAL_IO | SF_QUAD_IO,
+		.name = "MX25L25635E",
+	},
 };
 
 static int macronix_write_status(struct spi_flash *flash, u8 sr)
@@ -147,15 +160,34 @@ static int macronix_write_status(struct spi_flash *flash, u8 sr)
 static int macronix_unlock(struct spi_flash *flash)
 {
 	int ret;
+	u8 sr;
+
+	ret = spi_flash_cmd(flash->spi, CMD_MX25XX_RDSR, &sr, 1);
+	if (ret)
+		return ret;
 
-	/* Enable status register writing and clear BP# bits */
-	ret = macronix_write_status(flash, 0);
+	/* Enable status register writing and clear BP# bits, keep QE */
+	ret = macronix_write_status(flash, sr & MX25XX_SR_QE);
 	if (ret)
 		debug("SF: fail to disable write protection\n");
 
 	return ret;
 }
 
+static int macronix_quad_enable(struct spi_flash *flash)
+{
+	int ret;
+	u8 sr;
+
+	ret = spi_flash_cmd(flash->spi, CMD_MX25XX_RDSR, &sr, 1);
+	if (ret)
+		return ret;
+	if (sr & MX25XX_SR_QE)
+		return 0;
+
+	return macronix_write_status(flash, sr | MX25XX_SR_QE);
+}
+
 static int macronix_erase(struct spi_flash *flash, u32 offset, size_t len)
 {
 	return spi_flash_cmd_erase(flash, CMD_MX25XX_BE, offset, len);
@@ -179,7 +211,7 @@ struct spi_flash *spi_flash_probe_macronix(struct spi_slave *spi, u8 *idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -191,6 +223,9 @@ struct spi_flash *spi_flash_probe_macronix(struct spi_slave *spi, u8 *idcode)
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = macronix_erase;
 	flash->read = spi_flash_cmd_read_fast;
+	flash->read_modes = params->read_modes;
+	flash->quad_enable = macronix_quad_enable;
+	flash->set_4byte = spi_flash_cmd_4byte;
 	flash->page_size = params->page_size;
 	flash->sector_size = params->page_size * params->pages_per_sector
 		* params->sectors_per_block;
@@ -44,16 +44,27 @@
 #define CMD_S25FLXX_BE		0xc7	/* Bulk Erase */
 #define CMD_S25FLXX_DP		0xb9	/* Deep Power-down */
 #define CMD_S25FLXX_RES		0xab	/* Release from DP, and Read Signature */
+#define CMD_S25FLXX_RCR		0x35	/* Read Configuration Register */
+#define CMD_S25FLXX_BRWR	0x17	/* Bank Register Write */
+
+#define S25FLXX_CR_QUAD		0x02	/* Quad mode */
+#define S25FLXX_BAR_EXTADD	0x80	/* 4-byte addresses */
 
 #define SPSN_ID_S25FL008A	0x0213
 #define SPSN_ID_S25FL016A	0x0214
 #define SPSN_ID_S25FL032A	0x0215
 #define SPSN_ID_S25FL064A	0x0216
 #define SPSN_ID_S25FL128P	0x2018
+#define SPSN_ID_S25FL256S	0x0219
 #define SPSN_EXT_ID_S25FL128P_256KB	0x0300
 #define SPSN_EXT_ID_S25FL128P_64KB	0x0301
 #define SPSN_EXT_ID_S25FL032P		0x4d00
 #define SPSN_EXT_ID_S25FL129P		0x4d01
+#define SPSN_EXT_ID_S25FL256S_256KB	0x4d00
+#define SPSN_EXT_ID_S25FL256S_64KB	0x4d01
+
+/* Dual and quad reads of the FL-P and FL-S families */
+#define SPSN_READ_MODES	(SF_DUAL_OUT | SF_DUAL_IO | SF_QUAD_OUT | SF_QUAD_IO)
 
 struct spansion_spi_flash_params {
 	u16 idcode1;
@@ -61,6 +72,7 @@ struct spansion_spi_flash_params {
 	u16 page_size;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u8 read_modes;
 	const char *name;
 };
 
@@ -119,6 +131,7 @@ static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 		.page_size = 256,
 		.pages_per_sector = 256,
 		.nr_sectors = 64,
+		.read_modes = SPSN_READ_MODES,
 		.name = "S25FL032P",
 	},
 	{
@@ -127,8 +140,27 @@ static const struct spansion_spi_flash_params spansion_spi_flash_table[] = {
 		.page_size = 256,
 		.pages_per_sector = 256,
 		.nr_sectors = 256,
+		.read_modes = SPSN_READ_MODES,
 		.name = "S25FL129P_64K",
 	},
+	{
+		.idcode1 = SPSN_ID_S25FL256S,
+		.idcode2 = SPSN_EXT_ID_S25FL256S_64KB,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 512,
+		.read_modes = SPSN_READ_MODES,
+		.name = "S25FL256S_64K",
+	},
+	{
+		.idcode1 = SPSN_ID_S25FL256S,
+		.idcode2 = SPSN_EXT_ID_S25FL256S_256KB,
+		.page_size = 256,
+		.pages_per_sector = 1024,
+		.nr_sectors = 128,
+		.read_modes = SPSN_READ_MODES,
+		.name = "S25FL256S_256K",
+	},
 };
 
 static int spansion_erase(struct spi_flash *flash, u32 offset, size_t len)
@@ -136,6 +168,39 @@ static int spansion_erase(struct spi_flash *flash, u32 offset, size_t len)
 	return spi_flash_cmd_erase(flash, CMD_S25FLXX_SE, offset, len);
 }
 
+static int spansion_quad_enable(struct spi_flash *flash)
+{
+	u8 cmd = CMD_S25FLXX_WRSR;
+	u8 reg[2];
+	int ret;
+
+	ret = spi_flash_cmd(flash->spi, CMD_S25FLXX_RDSR, &reg[0], 1);
+	if (!ret)
+		ret = spi_flash_cmd(flash->spi, CMD_S25FLXX_RCR, &reg[1], 1);
+	if (ret)
+		return ret;
+	if (reg[1] & S25FLXX_CR_QUAD)
+		return 0;
+
+	/* The configuration register is written after the status */
+	reg[1] |= S25FLXX_CR_QUAD;
+	ret = spi_flash_cmd_write_enable(flash);
+	if (!ret)
+		ret = spi_flash_cmd_write(flash->spi, &cmd, 1, reg, 2);
+	if (!ret)
+		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+	return ret;
+}
+
+/* The S25FL-S has no B7h, bit 7 of the bank register does the same */
+static int spansion_set_4byte(struct spi_flash *flash, int enable)
+{
+	u8 cmd = CMD_S25FLXX_BRWR;
+	u8 bar = enable ? S25FLXX_BAR_EXTADD : 0;
+
+	return spi_flash_cmd_write(flash->spi, &cmd, 1, &bar, 1);
+}
+
 struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 {
 	const struct spansion_spi_flash_params *params;
@@ -159,7 +224,7 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -171,6 +236,9 @@ struct spi_flash *spi_flash_probe_spansion(struct spi_slave *spi, u8 *idcode)
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = spansion_erase;
 	flash->read = spi_flash_cmd_read_fast;
+	flash->read_modes = params->read_modes;
+	flash->quad_enable = spansion_quad_enable;
+	flash->set_4byte = spansion_set_4byte;
 	flash->page_size = params->page_size;
 	flash->sector_size = params->page_size * params->pages_per_sector;
 	flash->size = flash->sector_size * params->nr_sectors;
@@ -15,12 +15,79 @@
 
 #include "spi_flash_internal.h"
 
-static void spi_flash_addr(u32 addr, u8 *cmd)
+/* Longest command: opcode, 4 address bytes and 3 dummy bytes */
+#define SPI_FLASH_CMD_MAX	8
+
+/*
+ * Read commands, in order of speed.  The dummy bytes, mode bits included,
+ * go out on as many lines as the address: 8 clocks after a one line
+ * address, 4 after a two line and 6 after a four line one.  These are
+ * the power-on defaults of the chips that list the commands.
+ */
+static const struct {
+	u8 mode;
+	u8 cmd;
+	u8 dummy;
+	u8 addr_xfer;
+	u8 data_xfer;
+	u8 caps;
+} spi_flash_read_ops[] = {
+	{ 0, CMD_READ_ARRAY_FAST, 1, 0, 0, 0 },
+	{ SF_DUAL_OUT, CMD_READ_DUAL_OUTPUT_FAST, 1, 0, SPI_XFER_DUAL,
+	  SPI_RX_DUAL },
+	{ SF_DUAL_IO, CMD_READ_DUAL_IO_FAST, 1, SPI_XFER_DUAL, SPI_XFER_DUAL,
+	  SPI_RX_DUAL | SPI_TX_DUAL },
+	{ SF_QUAD_OUT, CMD_READ_QUAD_OUTPUT_FAST, 1, 0, SPI_XFER_QUAD,
+	  SPI_RX_QUAD },
+	{ SF_QUAD_IO, CMD_READ_QUAD_IO_FAST, 3, SPI_XFER_QUAD, SPI_XFER_QUAD,
+	  SPI_RX_QUAD | SPI_TX_QUAD },
+};
+
+/* Fill in the address after cmd[0], return the length of the command */
+static int spi_flash_addr(struct spi_flash *flash, u32 addr, u8 *cmd)
+{
+	int n = 1;
+
+	if (flash->addr_width == 4)
+		cmd[n++] = addr >> 24;
+	cmd[n++] = addr >> 16;
+	cmd[n++] = addr >> 8;
+	cmd[n++] = addr >> 0;
+
+	return n;
+}
+
+/*
+ * Claim the bus, and put the chip into 4-byte address mode if it needs
+ * it.  It leaves the mode again on release, so that a reset finds the
+ * chip in the 3-byte mode the boot ROM expects.
+ */
+static int spi_flash_claim(struct spi_flash *flash)
+{
+	int ret;
+
+	ret = spi_claim_bus(flash->spi);
+	if (ret) {
+		debug("SF: unable to claim SPI bus\n");
+		return ret;
+	}
+
+	if (flash->addr_width == 4) {
+		ret = flash->set_4byte(flash, 1);
+		if (ret) {
+			debug("SF: enabling 4-byte addresses failed\n");
+			spi_release_bus(flash->spi);
+		}
+	}
+
+	return ret;
+}
+
+static void spi_flash_release(struct spi_flash *flash)
 {
-	/* cmd[0] is actual command */
-	cmd[1] = addr >> 16;
-	cmd[2] = addr >> 8;
-	cmd[3] = addr >> 0;
+	if (flash->addr_width == 4)
+		flash->set_4byte(flash, 0);
+	spi_release_bus(flash->spi);
 }
 
 static int spi_flash_read_write(struct spi_slave *spi,
@@ -70,29 +137,27 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 {
 	unsigned long page_addr, byte_addr, page_size;
 	size_t chunk_len, actual;
-	int ret;
-	u8 cmd[4];
+	int ret, cmd_len;
+	u8 cmd[SPI_FLASH_CMD_MAX];
 
 	page_size = flash->page_size;
 	page_addr = offset / page_size;
 	byte_addr = offset % page_size;
 
-	ret = spi_claim_bus(flash->spi);
-	if (ret) {
-		debug("SF: unable to claim SPI bus\n");
+	ret = spi_flash_claim(flash);
+	if (ret)
 		return ret;
-	}
 
 	cmd[0] = CMD_PAGE_PROGRAM;
 	for (actual = 0; actual < len; actual += chunk_len) {
 		chunk_len = min(len - actual, page_size - byte_addr);
 
-		cmd[1] = page_addr >> 8;
-		cmd[2] = page_addr;
-		cmd[3] = byte_addr;
+		cmd_len = spi_flash_addr(flash,
+					 page_addr * page_size + byte_addr, cmd);
 
-		debug("PP: 0x%p => cmd = { 0x%02x 0x%02x%02x%02x } chunk_len = %zu\n",
-		      buf + actual, cmd[0], cmd[1], cmd[2], cmd[3], chunk_len);
+		debug("PP: 0x%p => cmd = { 0x%02x 0x%08lx } chunk_len = %zu\n",
+		      buf + actual, cmd[0], page_addr * page_size + byte_addr,
+		      chunk_len);
 
 		ret = spi_flash_cmd_write_enable(flash);
 		if (ret < 0) {
@@ -100,7 +165,7 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 			break;
 		}
 
-		ret = spi_flash_cmd_write(flash->spi, cmd, 4,
+		ret = spi_flash_cmd_write(flash->spi, cmd, cmd_len,
 					  buf + actual, chunk_len);
 		if (ret < 0) {
 			debug("SF: write failed\n");
@@ -118,7 +183,7 @@ int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
 	debug("SF: program %s %zu bytes @ %#x\n",
 	      ret ? "failure" : "success", len, offset);
 
-	spi_release_bus(flash->spi);
+	spi_flash_release(flash);
 	return ret;
 }
 
@@ -128,9 +193,11 @@ int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 	struct spi_slave *spi = flash->spi;
 	int ret;
 
-	spi_claim_bus(spi);
+	ret = spi_flash_claim(flash);
+	if (ret)
+		return ret;
 	ret = spi_flash_cmd_read(spi, cmd, cmd_len, data, data_len);
-	spi_release_bus(spi);
+	spi_flash_release(flash);
 
 	return ret;
 }
@@ -138,13 +205,47 @@ int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
 		size_t len, void *data)
 {
-	u8 cmd[5];
+	struct spi_slave *spi = flash->spi;
+	u8 cmd[SPI_FLASH_CMD_MAX];
+	int cmd_len, ret;
+	unsigned int i;
+
+	i = flash->read_mode;
+	cmd[0] = spi_flash_read_ops[i].cmd;
+	cmd_len = spi_flash_addr(flash, offset, cmd);
+	memset(cmd + cmd_len, 0, spi_flash_read_ops[i].dummy);
+	cmd_len += spi_flash_read_ops[i].dummy;
+
+	if (!i)
+		return spi_flash_read_common(flash, cmd, cmd_len, data, len);
+	if (!len)
+		return 0;
 
-	cmd[0] = CMD_READ_ARRAY_FAST;
-	spi_flash_addr(offset, cmd);
-	cmd[4] = 0x00;
+	/* The opcode always goes out on one line */
+	ret = spi_flash_claim(flash);
+	if (ret)
+		return ret;
+	ret = spi_xfer(spi, 8, cmd, NULL, SPI_XFER_BEGIN);
+	if (!ret)
+		ret = spi_xfer(spi, (cmd_len - 1) * 8, cmd + 1, NULL,
+			       spi_flash_read_ops[i].addr_xfer);
+	if (!ret)
+		ret = spi_xfer(spi, len * 8, NULL, data,
+			       spi_flash_read_ops[i].data_xfer | SPI_XFER_END);
+	else
+		spi_xfer(spi, 0, NULL, NULL, SPI_XFER_END);
+	if (ret)
+		debug("SF: Failed to read %zu bytes: %d\n", len, ret);
+	spi_flash_release(flash);
+
+	return ret;
+}
 
-	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
+int spi_flash_cmd_4byte(struct spi_flash *flash, int enable)
+{
+	return spi_flash_cmd(flash->spi,
+			     enable ? CMD_ENTER_4B_ADDR : CMD_EXIT_4B_ADDR,
+			     NULL, 0);
 }
 
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
@@ -194,8 +295,8 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u8 erase_cmd,
 			u32 offset, size_t len)
 {
 	u32 start, end, erase_size;
-	int ret;
-	u8 cmd[4];
+	int ret, cmd_len;
+	u8 cmd[SPI_FLASH_CMD_MAX];
 
 	erase_size = flash->sector_size;
 	if (offset % erase_size || len % erase_size) {
@@ -203,28 +304,25 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u8 erase_cmd,
 		return -1;
 	}
 
-	ret = spi_claim_bus(flash->spi);
-	if (ret) {
-		debug("SF: Unable to claim SPI bus\n");
+	ret = spi_flash_claim(flash);
+	if (ret)
 		return ret;
-	}
 
 	cmd[0] = erase_cmd;
 	start = offset;
 	end = start + len;
 
 	while (offset < end) {
-		spi_flash_addr(offset, cmd);
-		offset += erase_size;
+		cmd_len = spi_flash_addr(flash, offset, cmd);
 
-		debug("SF: erase %2x %2x %2x %2x (%x)\n", cmd[0], cmd[1],
-		      cmd[2], cmd[3], offset);
+		debug("SF: erase %2x %08x\n", cmd[0], offset);
+		offset += erase_size;
 
 		ret = spi_flash_cmd_write_enable(flash);
 		if (ret)
 			goto out;
 
-		ret = spi_flash_cmd_write(flash->spi, cmd, sizeof(cmd), NULL, 0);
+		ret = spi_flash_cmd_write(flash->spi, cmd, cmd_len, NULL, 0);
 		if (ret)
 			goto out;
 
@@ -236,10 +334,48 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u8 erase_cmd,
 	debug("SF: Successfully erased %zu bytes @ %#x\n", len, start);
 
  out:
-	spi_release_bus(flash->spi);
+	spi_flash_release(flash);
 	return ret;
 }
 
+/*
+ * Pick the address width and the fastest read that both the chip and
+ * the controller can do.  Called with the bus claimed.
+ */
+static void spi_flash_setup(struct spi_flash *flash)
+{
+	unsigned int caps = flash->spi->caps;
+	int i;
+
+	flash->addr_width = 3;
+	if (flash->size > (1 << 24)) {
+		if (flash->set_4byte) {
+			flash->addr_width = 4;
+		} else {
+			printf("SF: Only the first 16 MiB can be addressed\n");
+			flash->size = 1 << 24;
+		}
+	}
+
+	for (i = ARRAY_SIZE(spi_flash_read_ops) - 1; i > 0; i--) {
+		if (!(flash->read_modes & spi_flash_read_ops[i].mode))
+			continue;
+		if ((caps & spi_flash_read_ops[i].caps) !=
+		    spi_flash_read_ops[i].caps)
+			continue;
+		if ((spi_flash_read_ops[i].mode & (SF_QUAD_OUT | SF_QUAD_IO)) &&
+		    flash->quad_enable && flash->quad_enable(flash)) {
+			debug("SF: Failed to enable quad mode\n");
+			continue;
+		}
+		break;
+	}
+	flash->read_mode = i;
+
+	debug("SF: %d address bytes, read command %02x\n",
+	      flash->addr_width, spi_flash_read_ops[i].cmd);
+}
+
 /*
  * The following table holds all device probe functions
  *
@@ -356,6 +492,8 @@ struct spi_flash *spi_flash_probe(unsigned int bus, unsigned int cs,
 		goto err_manufacturer_probe;
 	}
 
+	spi_flash_setup(flash);
+
 	printf("SF: Detected %s with page size ", flash->name);
 	print_size(flash->sector_size, ", total ");
 	print_size(flash->size, "\n");
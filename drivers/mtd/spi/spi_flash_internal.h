@@ -18,11 +18,19 @@
 #define CMD_READ_ARRAY_SLOW		0x03
 #define CMD_READ_ARRAY_FAST		0x0b
 #define CMD_READ_ARRAY_LEGACY		0xe8
+#define CMD_READ_DUAL_OUTPUT_FAST	0x3b
+#define CMD_READ_DUAL_IO_FAST		0xbb
+#define CMD_READ_QUAD_OUTPUT_FAST	0x6b
+#define CMD_READ_QUAD_IO_FAST		0xeb
 
 #define CMD_PAGE_PROGRAM		0x02
 #define CMD_WRITE_DISABLE		0x04
 #define CMD_READ_STATUS			0x05
 #define CMD_WRITE_ENABLE		0x06
+#define CMD_WRITE_STATUS		0x01
+
+#define CMD_ENTER_4B_ADDR		0xb7
+#define CMD_EXIT_4B_ADDR		0xe9
 
 /* Common status */
 #define STATUS_WIP			0x01
@@ -77,6 +85,12 @@ static inline int spi_flash_cmd_write_disable(struct spi_flash *flash)
 int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 		size_t cmd_len, void *data, size_t data_len);
 
+/*
+ * Enter or leave 4-byte address mode with B7h/E9h, for the chips that
+ * have them.  Usable as the ->set_4byte() hook.
+ */
+int spi_flash_cmd_4byte(struct spi_flash *flash, int enable);
+
 /* Send a command to the device and wait for some bit to clear itself. */
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
 			   u8 cmd, u8 poll_bit);
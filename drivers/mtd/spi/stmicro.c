@@ -46,11 +46,16 @@
 #define CMD_M25PXX_DP		0xb9	/* Deep Power-down */
 #define CMD_M25PXX_RES		0xab	/* Release from DP, and Read Signature */
 
+/* Memory type of the N25Q, the M25P entries match all other types */
+#define STM_MEMTYPE_N25Q	0xba
+
 struct stmicro_spi_flash_params {
+	u8 memtype;
 	u8 idcode1;
 	u16 page_size;
 	u16 pages_per_sector;
 	u16 nr_sectors;
+	u8 read_modes;
 	const char *name;
 };
 
@@ -111,6 +116,24 @@ static const struct stmicro_spi_flash_params stmicro_spi_flash_table[] = {
 		.nr_sectors = 64,
 		.name = "M25P128",
 	},
+	{
+		.memtype = STM_MEMTYPE_N25Q,
+		.idcode1 = 0x18,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 256,
+		.read_modes = SF_DUAL_OUT | SF_QUAD_OUT,
+		.name = "N25Q128",
+	},
+	{
+		.memtype = STM_MEMTYPE_N25Q,
+		.idcode1 = 0x19,
+		.page_size = 256,
+		.pages_per_sector = 256,
+		.nr_sectors = 512,
+		.read_modes = SF_DUAL_OUT | SF_QUAD_OUT,
+		.name = "N25Q256",
+	},
 };
 
 static int stmicro_erase(struct spi_flash *flash, u32 offset, size_t len)
@@ -118,6 +141,17 @@ static int stmicro_erase(struct spi_flash *flash, u32 offset, size_t len)
 	return spi_flash_cmd_erase(flash, CMD_M25PXX_SE, offset, len);
 }
 
+/* The N25Q wants a write enable before changing the address mode */
+static int stmicro_set_4byte(struct spi_flash *flash, int enable)
+{
+	int ret;
+
+	ret = spi_flash_cmd_write_enable(flash);
+	if (ret)
+		return ret;
+	return spi_flash_cmd_4byte(flash, enable);
+}
+
 struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 {
 	const struct stmicro_spi_flash_params *params;
@@ -139,7 +173,9 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 
 	for (i = 0; i < ARRAY_SIZE(stmicro_spi_flash_table); i++) {
 		params = &stmicro_spi_flash_table[i];
-		if (params->idcode1 == idcode[2]) {
+		if (params->idcode1 == idcode[2] &&
+		    (params->memtype ? params->memtype == idcode[1] :
+		     idcode[1] != STM_MEMTYPE_N25Q)) {
 			break;
 		}
 	}
@@ -149,7 +185,7 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -161,6 +197,8 @@ struct spi_flash *spi_flash_probe_stmicro(struct spi_slave *spi, u8 * idcode)
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = stmicro_erase;
 	flash->read = spi_flash_cmd_read_fast;
+	flash->read_modes = params->read_modes;
+	flash->set_4byte = stmicro_set_4byte;
 	flash->page_size = params->page_size;
 	flash->sector_size = params->page_size * params->pages_per_sector;
 	flash->size = flash->sector_size * params->nr_sectors;
@@ -23,6 +23,9 @@
 #define CMD_W25_CE		0xc7	/* Chip Erase */
 #define CMD_W25_DP		0xb9	/* Deep Power-down */
 #define CMD_W25_RES		0xab	/* Release from DP, and Read Signature */
+#define CMD_W25_RDSR2		0x35	/* Read Status Register 2 */
+
+#define W25_SR2_QE		0x02	/* Quad Enable */
 
 struct winbond_spi_flash_params {
 	uint16_t	id;
@@ -31,6 +34,7 @@ struct winbond_spi_flash_params {
 	uint16_t	pages_per_sector;
 	uint16_t	sectors_per_block;
 	uint16_t	nr_blocks;
+	uint8_t		read_modes;
 	const char	*name;
 };
 
@@ -41,6 +45,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 8,
+		.read_modes		= SF_DUAL_OUT,
 		.name			= "W25X40",
 	},
 	{
@@ -49,6 +54,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 32,
+		.read_modes		= SF_DUAL_OUT,
 		.name			= "W25X16",
 	},
 	{
@@ -57,6 +63,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 64,
+		.read_modes		= SF_DUAL_OUT,
 		.name			= "W25X32",
 	},
 	{
@@ -65,6 +72,7 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 128,
+		.read_modes		= SF_DUAL_OUT,
 		.name			= "W25X64",
 	},
 	{
@@ -73,6 +81,8 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 32,
+		.read_modes		= SF_DUAL_OUT | SF_DUAL_IO |
+					  SF_QUAD_OUT | SF_QUAD_IO,
 		.name			= "W25Q16",
 	},
 	{
@@ -81,6 +91,8 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 64,
+		.read_modes		= SF_DUAL_OUT | SF_DUAL_IO |
+					  SF_QUAD_OUT | SF_QUAD_IO,
 		.name			= "W25Q32",
 	},
 	{
@@ -89,6 +101,8 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 128,
+		.read_modes		= SF_DUAL_OUT | SF_DUAL_IO |
+					  SF_QUAD_OUT | SF_QUAD_IO,
 		.name			= "W25Q64",
 	},
 	{
@@ -97,8 +111,20 @@ static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 		.pages_per_sector	= 16,
 		.sectors_per_block	= 16,
 		.nr_blocks		= 256,
+		.read_modes		= SF_DUAL_OUT | SF_DUAL_IO |
+					  SF_QUAD_OUT | SF_QUAD_IO,
 		.name			= "W25Q128",
 	},
+	{
+		.id			= 0x4019,
+		.l2_page_size		= 8,
+		.pages_per_sector	= 16,
+		.sectors_per_block	= 16,
+		.nr_blocks		= 512,
+		.read_modes		= SF_DUAL_OUT | SF_DUAL_IO |
+					  SF_QUAD_OUT | SF_QUAD_IO,
+		.name			= "W25Q256",
+	},
 };
 
 static int winbond_erase(struct spi_flash *flash, u32 offset, size_t len)
@@ -106,6 +132,30 @@ static int winbond_erase(struct spi_flash *flash, u32 offset, size_t len)
 	return spi_flash_cmd_erase(flash, CMD_W25_SE, offset, len);
 }
 
+static int winbond_quad_enable(struct spi_flash *flash)
+{
+	u8 cmd = CMD_W25_WRSR;
+	u8 sr[2];
+	int ret;
+
+	ret = spi_flash_cmd(flash->spi, CMD_W25_RDSR, &sr[0], 1);
+	if (!ret)
+		ret = spi_flash_cmd(flash->spi, CMD_W25_RDSR2, &sr[1], 1);
+	if (ret)
+		return ret;
+	if (sr[1] & W25_SR2_QE)
+		return 0;
+
+	/* Both registers are written together */
+	sr[1] |= W25_SR2_QE;
+	ret = spi_flash_cmd_write_enable(flash);
+	if (!ret)
+		ret = spi_flash_cmd_write(flash->spi, &cmd, 1, sr, 2);
+	if (!ret)
+		ret = spi_flash_cmd_wait_ready(flash, SPI_FLASH_PROG_TIMEOUT);
+	return ret;
+}
+
 struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 {
 	const struct winbond_spi_flash_params *params;
@@ -125,7 +175,7 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 		return NULL;
 	}
 
-	flash = malloc(sizeof(*flash));
+	flash = calloc(1, sizeof(*flash));
 	if (!flash) {
 		debug("SF: Failed to allocate memory\n");
 		return NULL;
@@ -140,6 +190,10 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 	flash->write = spi_flash_cmd_write_multi;
 	flash->erase = winbond_erase;
 	flash->read = spi_flash_cmd_read_fast;
+	flash->read_modes = params->read_modes;
+	if (params->read_modes & SF_QUAD_OUT)
+		flash->quad_enable = winbond_quad_enable;
+	flash->set_4byte = spi_flash_cmd_4byte;
 	flash->page_size = page_size;
 	flash->sector_size = page_size * params->pages_per_sector;
 	flash->size = page_size * params->pages_per_sector
@@ -453,17 +453,22 @@ static void uif_close(struct ubi_device *ubi)
  * This function returns zero in case of success and a negative error code in
  * case of failure.
  *
- * Note, currently this is the only method to attach UBI devices. Hopefully in
- * the future we'll have more scalable attaching methods and avoid full media
- * scanning. But even in this case scanning will be needed as a fall-back
- * attaching method if there are some on-flash table corruptions.
+ * With CONFIG_MTD_UBI_FASTMAP, a fastmap written by Linux is used instead of
+ * scanning the whole media when there is a valid one. Scanning remains the
+ * fall-back if there is none or it is corrupted.
  */
 static int attach_by_scanning(struct ubi_device *ubi)
 {
 	int err;
 	struct ubi_scan_info *si;
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	si = ubi_scan_fastmap(ubi);
+	if (!si)
+		si = ubi_scan(ubi);
+#else
 	si = ubi_scan(ubi);
+#endif
 	if (IS_ERR(si))
 		return PTR_ERR(si);
 
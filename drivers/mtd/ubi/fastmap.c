@@ -0,0 +1,676 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * UBI fastmap attaching.
+ *
+ * Linux (3.7 and later) may store a fastmap: a snapshot of the EBA table and
+ * of the erase counters of all PEBs. This unit reads it and builds the same
+ * &struct ubi_scan_info a full scan would, reading only the first
+ * %UBI_FM_MAX_START VID headers, the fastmap itself and the PEBs of the
+ * fastmap pools, which may have been written after the fastmap was taken.
+ *
+ * The fastmap is never written here. As soon as anything is written to or
+ * erased on the device, the fastmap super block is erased, so that Linux falls
+ * back to scanning and finds the changes.
+ */
+
+#include <ubi_uboot.h>
+#include "ubi.h"
+
+/* The fastmap can not be used, fall back to scanning */
+#define FM_BAD 1
+
+/* The scanning state of a PEB listed by the fastmap */
+struct fm_peb {
+	struct ubi_scan_leb *seb;
+	struct ubi_scan_volume *sv;	/* if @seb is mapped to a LEB */
+	struct list_head *list;		/* otherwise, the list @seb is on */
+};
+
+static void fm_count_ec(struct ubi_scan_info *si, int ec)
+{
+	si->ec_sum += ec;
+	si->ec_count += 1;
+	if (ec > si->max_ec)
+		si->max_ec = ec;
+	if (ec < si->min_ec)
+		si->min_ec = ec;
+}
+
+/**
+ * fm_add_to_list - add a PEB listed by the fastmap to a list.
+ *
+ * Returns zero in case of success, %FM_BAD if the PEB is out of range or
+ * listed twice, and a negative error code in case of failure.
+ */
+static int fm_add_to_list(struct ubi_device *ubi, struct ubi_scan_info *si,
+			  struct fm_peb *map, struct list_head *list,
+			  int pnum, int ec, int scrub)
+{
+	struct ubi_scan_leb *seb;
+
+	if (pnum < 0 || pnum >= ubi->peb_count || map[pnum].seb) {
+		ubi_err("bad PEB %d in fastmap", pnum);
+		return FM_BAD;
+	}
+
+	seb = kmalloc(sizeof(struct ubi_scan_leb), GFP_KERNEL);
+	if (!seb)
+		return -ENOMEM;
+
+	seb->pnum = pnum;
+	seb->ec = ec;
+	seb->lnum = -1;
+	seb->scrub = scrub;
+	seb->sqnum = 0;
+	seb->leb_ver = 0;
+	list_add_tail(&seb->u.list, list);
+
+	map[pnum].seb = seb;
+	map[pnum].sv = NULL;
+	map[pnum].list = list;
+	fm_count_ec(si, ec);
+	return 0;
+}
+
+/* Read @count &struct ubi_fm_ec entries at @pos into @list */
+static int fm_read_ec_list(struct ubi_device *ubi, struct ubi_scan_info *si,
+			   struct fm_peb *map, void *buf, size_t *pos,
+			   size_t size, int count, struct list_head *list,
+			   int scrub)
+{
+	int i, err;
+
+	for (i = 0; i < count; i++) {
+		struct ubi_fm_ec *fmec = buf + *pos;
+
+		*pos += sizeof(struct ubi_fm_ec);
+		if (*pos >= size)
+			return FM_BAD;
+
+		err = fm_add_to_list(ubi, si, map, list,
+				     be32_to_cpu(fmec->pnum),
+				     be32_to_cpu(fmec->ec), scrub);
+		if (err)
+			return err;
+	}
+
+	return 0;
+}
+
+static struct ubi_scan_volume *fm_add_volume(struct ubi_scan_info *si,
+					     const struct ubi_fm_volhdr *fmvhdr)
+{
+	int vol_id = be32_to_cpu(fmvhdr->vol_id);
+	struct ubi_scan_volume *sv;
+	struct rb_node **p = &si->volumes.rb_node, *parent = NULL;
+
+	/* Same ordering as add_volume() in scan.c */
+	while (*p) {
+		parent = *p;
+		sv = rb_entry(parent, struct ubi_scan_volume, rb);
+
+		if (vol_id == sv->vol_id) {
+			ubi_err("volume %d twice in fastmap", vol_id);
+			return NULL;
+		}
+
+		if (vol_id > sv->vol_id)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+
+	sv = kmalloc(sizeof(struct ubi_scan_volume), GFP_KERNEL);
+	if (!sv)
+		return ERR_PTR(-ENOMEM);
+
+	sv->highest_lnum = sv->leb_count = 0;
+	sv->vol_id = vol_id;
+	sv->root = RB_ROOT;
+	sv->used_ebs = be32_to_cpu(fmvhdr->used_ebs);
+	sv->data_pad = be32_to_cpu(fmvhdr->data_pad);
+	sv->last_data_size = be32_to_cpu(fmvhdr->last_eb_bytes);
+	sv->compat = 0;
+	/* Linux stores %UBI_DYNAMIC_VOLUME or %UBI_STATIC_VOLUME here */
+	sv->vol_type = fmvhdr->vol_type;
+	if (vol_id > si->highest_vol_id)
+		si->highest_vol_id = vol_id;
+
+	rb_link_node(&sv->rb, parent, p);
+	rb_insert_color(&sv->rb, &si->volumes);
+	si->vols_found += 1;
+	return sv;
+}
+
+/* Move a PEB from the used list to LEB @lnum of @sv */
+static void fm_assign_seb(struct ubi_scan_volume *sv, struct fm_peb *map,
+			  struct ubi_scan_leb *seb, int lnum)
+{
+	struct rb_node **p = &sv->root.rb_node, *parent = NULL;
+	struct ubi_scan_leb *tmp;
+
+	/* Same ordering as ubi_scan_add_used() */
+	while (*p) {
+		parent = *p;
+		tmp = rb_entry(parent, struct ubi_scan_leb, u.rb);
+		if (lnum < tmp->lnum)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+
+	list_del(&seb->u.list);
+	seb->lnum = lnum;
+	if (sv->highest_lnum <= lnum)
+		sv->highest_lnum = lnum;
+	sv->leb_count += 1;
+	rb_link_node(&seb->u.rb, parent, p);
+	rb_insert_color(&seb->u.rb, &sv->root);
+	map[seb->pnum].sv = sv;
+	map[seb->pnum].list = NULL;
+}
+
+/* Forget what the fastmap said about a PEB of a pool */
+static void fm_drop_peb(struct fm_peb *map, int pnum)
+{
+	struct ubi_scan_leb *seb = map[pnum].seb;
+	struct ubi_scan_volume *sv = map[pnum].sv;
+
+	if (!seb)
+		return;
+
+	if (sv) {
+		rb_erase(&seb->u.rb, &sv->root);
+		sv->leb_count -= 1;
+	} else {
+		list_del(&seb->u.list);
+	}
+	kfree(seb);
+	map[pnum].seb = NULL;
+	map[pnum].sv = NULL;
+	map[pnum].list = NULL;
+}
+
+/**
+ * fm_scan_pool - scan the PEBs of a fastmap pool.
+ *
+ * Returns zero in case of success, %FM_BAD if the pool is not in the expected
+ * state, and a negative error code in case of failure.
+ */
+static int fm_scan_pool(struct ubi_device *ubi, struct ubi_scan_info *si,
+			struct fm_peb *map, const struct ubi_fm_scan_pool *pool,
+			struct ubi_ec_hdr *ech, struct ubi_vid_hdr *vidh)
+{
+	int i, err, size = be16_to_cpu(pool->size);
+
+	for (i = 0; i < size; i++) {
+		int pnum = be32_to_cpu(pool->pebs[i]);
+		int bitflips = 0, ec;
+
+		if (pnum < 0 || pnum >= ubi->peb_count) {
+			ubi_err("bad PEB %d in fastmap pool", pnum);
+			return FM_BAD;
+		}
+
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			return err;
+		if (err) {
+			ubi_err("bad PEB %d in fastmap pool", pnum);
+			return FM_BAD;
+		}
+
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+		if (err < 0)
+			return err;
+		if (err == UBI_IO_BITFLIPS)
+			bitflips = 1;
+		else if (err) {
+			ubi_err("bad EC header in pool PEB %d", pnum);
+			return FM_BAD;
+		}
+		ec = be64_to_cpu(ech->ec);
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+		if (err < 0)
+			return err;
+		if (err == UBI_IO_BITFLIPS) {
+			bitflips = 1;
+		} else if (err == UBI_IO_PEB_FREE) {
+			/* Still free */
+			fm_drop_peb(map, pnum);
+			err = fm_add_to_list(ubi, si, map, &si->free, pnum, ec,
+					     bitflips);
+			if (err)
+				return err;
+			continue;
+		} else if (err) {
+			ubi_err("bad VID header in pool PEB %d", pnum);
+			return FM_BAD;
+		}
+
+		if (map[pnum].sv &&
+		    map[pnum].sv->vol_id == be32_to_cpu(vidh->vol_id) &&
+		    map[pnum].seb->lnum == be32_to_cpu(vidh->lnum))
+			/* Already mapped there by the fastmap */
+			continue;
+
+		/* Written after the fastmap was taken */
+		fm_drop_peb(map, pnum);
+		err = ubi_scan_add_used(ubi, si, pnum, ec, vidh, bitflips);
+		if (err)
+			return err;
+		fm_count_ec(si, ec);
+	}
+
+	return 0;
+}
+
+/**
+ * fm_find_anchor - find the newest fastmap super block.
+ *
+ * Returns the PEB holding it, %-1 if there is none, or a negative error code
+ * other than %-1 in case of failure.
+ */
+static int fm_find_anchor(struct ubi_device *ubi, struct ubi_ec_hdr *ech,
+			  struct ubi_vid_hdr *vidh)
+{
+	int pnum, err, anchor = -1;
+	unsigned long long sqnum = 0;
+
+	for (pnum = 0; pnum < UBI_FM_MAX_START && pnum < ubi->peb_count;
+	     pnum++) {
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			return err;
+		if (err)
+			continue;
+
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+		if (err < 0)
+			return err;
+		if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+		if (err < 0)
+			return err;
+		if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		if (be32_to_cpu(vidh->vol_id) == UBI_FM_SB_VOLUME_ID &&
+		    (anchor < 0 || be64_to_cpu(vidh->sqnum) > sqnum)) {
+			anchor = pnum;
+			sqnum = be64_to_cpu(vidh->sqnum);
+		}
+	}
+
+	return anchor;
+}
+
+/**
+ * fm_read - read and check all blocks of the fastmap.
+ *
+ * Returns zero in case of success, %FM_BAD if the fastmap is not valid, and a
+ * negative error code in case of failure. The super block is in @buf, and its
+ * block count in @used_blocks.
+ */
+static int fm_read(struct ubi_device *ubi, struct ubi_scan_info *si,
+		   int anchor, void **buf, int *used_blocks,
+		   struct ubi_ec_hdr *ech, struct ubi_vid_hdr *vidh)
+{
+	struct ubi_fm_sb *fmsb;
+	uint32_t crc;
+	int i, err, used;
+
+	/* Only the super block first, to learn the size */
+	fmsb = kmalloc(sizeof(struct ubi_fm_sb), GFP_KERNEL);
+	if (!fmsb)
+		return -ENOMEM;
+
+	err = ubi_io_read_data(ubi, fmsb, anchor, 0, sizeof(*fmsb));
+	if (err && err != UBI_IO_BITFLIPS)
+		goto out_bad;
+
+	used = be32_to_cpu(fmsb->used_blocks);
+	if (be32_to_cpu(fmsb->magic) != UBI_FM_SB_MAGIC ||
+	    fmsb->version != UBI_FM_FMT_VERSION ||
+	    used < 1 || used > UBI_FM_MAX_BLOCKS ||
+	    be32_to_cpu(fmsb->block_loc[0]) != anchor) {
+		ubi_err("bad fastmap super block in PEB %d", anchor);
+		err = FM_BAD;
+		goto out;
+	}
+
+	*buf = vmalloc(used * ubi->leb_size);
+	if (!*buf) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	si->max_sqnum = be64_to_cpu(fmsb->sqnum);
+	for (i = 0; i < used; i++) {
+		int pnum = be32_to_cpu(fmsb->block_loc[i]);
+		int vol_id = i ? UBI_FM_DATA_VOLUME_ID : UBI_FM_SB_VOLUME_ID;
+
+		if (pnum < 0 || pnum >= ubi->peb_count)
+			goto out_bad;
+
+		err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out_bad;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vidh, 0);
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out_bad;
+		if (be32_to_cpu(vidh->vol_id) != vol_id)
+			goto out_bad;
+		if (si->max_sqnum < be64_to_cpu(vidh->sqnum))
+			si->max_sqnum = be64_to_cpu(vidh->sqnum);
+
+		err = ubi_io_read_data(ubi, *buf + i * ubi->leb_size, pnum, 0,
+				       ubi->leb_size);
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out_bad;
+	}
+	kfree(fmsb);
+
+	fmsb = *buf;
+	crc = be32_to_cpu(fmsb->data_crc);
+	fmsb->data_crc = 0;
+	if (crc32(UBI_CRC32_INIT, *buf, used * ubi->leb_size) != crc) {
+		ubi_err("fastmap data CRC is invalid");
+		vfree(*buf);
+		*buf = NULL;
+		return FM_BAD;
+	}
+
+	*used_blocks = used;
+	return 0;
+
+out_bad:
+	/* An uncorrectable ECC error just means no fastmap */
+	if (err >= 0 || err == -EBADMSG) {
+		ubi_err("bad fastmap block");
+		err = FM_BAD;
+	}
+	if (*buf) {
+		vfree(*buf);
+		*buf = NULL;
+	}
+out:
+	kfree(fmsb);
+	return err;
+}
+
+/**
+ * fm_attach - build scanning information from the fastmap data.
+ *
+ * Returns zero in case of success, %FM_BAD if the fastmap is not consistent,
+ * and a negative error code in case of failure.
+ */
+static int fm_attach(struct ubi_device *ubi, struct ubi_scan_info *si,
+		     void *buf, int used_blocks, struct fm_peb *map,
+		     struct ubi_ec_hdr *ech, struct ubi_vid_hdr *vidh)
+{
+	struct ubi_fm_sb *fmsb = buf;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_scan_pool *pool1, *pool2;
+	struct ubi_scan_leb *seb, *seb_tmp;
+	struct ubi_scan_volume *sv;
+	struct rb_node *rb;
+	LIST_HEAD(used);
+	size_t pos, size = used_blocks * ubi->leb_size;
+	int i, j, n, err, count;
+
+	pos = sizeof(struct ubi_fm_sb);
+	fmhdr = buf + pos;
+	pos += sizeof(struct ubi_fm_hdr);
+	pool1 = buf + pos;
+	pos += sizeof(struct ubi_fm_scan_pool);
+	pool2 = buf + pos;
+	pos += sizeof(struct ubi_fm_scan_pool);
+	if (pos >= size ||
+	    be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC ||
+	    be32_to_cpu(pool1->magic) != UBI_FM_POOL_MAGIC ||
+	    be32_to_cpu(pool2->magic) != UBI_FM_POOL_MAGIC ||
+	    be16_to_cpu(pool1->size) > UBI_FM_MAX_POOL_SIZE ||
+	    be16_to_cpu(pool2->size) > UBI_FM_MAX_POOL_SIZE)
+		return FM_BAD;
+
+	/* The fastmap blocks themselves are left alone */
+	for (i = 0; i < used_blocks; i++) {
+		err = fm_add_to_list(ubi, si, map, &si->alien,
+				     be32_to_cpu(fmsb->block_loc[i]),
+				     be32_to_cpu(fmsb->block_ec[i]), 0);
+		if (err)
+			return err;
+		si->alien_peb_count += 1;
+	}
+
+	err = fm_read_ec_list(ubi, si, map, buf, &pos, size,
+			      be32_to_cpu(fmhdr->free_peb_count),
+			      &si->free, 0);
+	if (err)
+		return err;
+	err = fm_read_ec_list(ubi, si, map, buf, &pos, size,
+			      be32_to_cpu(fmhdr->used_peb_count), &used, 0);
+	if (err)
+		return err;
+	err = fm_read_ec_list(ubi, si, map, buf, &pos, size,
+			      be32_to_cpu(fmhdr->scrub_peb_count), &used, 1);
+	if (err)
+		return err;
+	err = fm_read_ec_list(ubi, si, map, buf, &pos, size,
+			      be32_to_cpu(fmhdr->erase_peb_count),
+			      &si->erase, 1);
+	if (err)
+		return err;
+	si->bad_peb_count = be32_to_cpu(fmhdr->bad_peb_count);
+
+	/* Volumes and their EBA tables */
+	n = be32_to_cpu(fmhdr->vol_count);
+	for (i = 0; i < n; i++) {
+		struct ubi_fm_volhdr *fmvhdr = buf + pos;
+		struct ubi_fm_eba *fm_eba;
+
+		pos += sizeof(struct ubi_fm_volhdr);
+		if (pos >= size ||
+		    be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC)
+			return FM_BAD;
+
+		sv = fm_add_volume(si, fmvhdr);
+		if (!sv)
+			return FM_BAD;
+		if (IS_ERR(sv))
+			return PTR_ERR(sv);
+
+		fm_eba = buf + pos;
+		pos += sizeof(struct ubi_fm_eba);
+		if (pos >= size)
+			return FM_BAD;
+		pos += sizeof(__be32) * be32_to_cpu(fm_eba->reserved_pebs);
+		if (pos >= size || be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC)
+			return FM_BAD;
+
+		for (j = 0; j < be32_to_cpu(fm_eba->reserved_pebs); j++) {
+			int pnum = be32_to_cpu(fm_eba->pnum[j]);
+
+			if (pnum < 0)
+				continue;
+
+			if (pnum >= ubi->peb_count ||
+			    map[pnum].list != &used) {
+				ubi_err("PEB %d in EBA but not in used list",
+					pnum);
+				return FM_BAD;
+			}
+			fm_assign_seb(sv, map, map[pnum].seb, j);
+		}
+	}
+
+	/* Used but not mapped, e.g. the target of a move */
+	list_for_each_entry_safe(seb, seb_tmp, &used, u.list) {
+		list_move_tail(&seb->u.list, &si->erase);
+		map[seb->pnum].list = &si->erase;
+	}
+
+	err = fm_scan_pool(ubi, si, map, pool1, ech, vidh);
+	if (err)
+		return err;
+	err = fm_scan_pool(ubi, si, map, pool2, ech, vidh);
+	if (err)
+		return err;
+
+	/* Every good PEB must be accounted for */
+	count = 0;
+	list_for_each_entry(seb, &si->free, u.list)
+		count++;
+	list_for_each_entry(seb, &si->erase, u.list)
+		count++;
+	list_for_each_entry(seb, &si->alien, u.list)
+		count++;
+	ubi_rb_for_each_entry(rb, sv, &si->volumes, rb)
+		count += sv->leb_count;
+	if (count != ubi->peb_count - si->bad_peb_count) {
+		ubi_err("fastmap knows %d PEBs, expected %d", count,
+			ubi->peb_count - si->bad_peb_count);
+		return FM_BAD;
+	}
+
+	return 0;
+}
+
+/**
+ * ubi_scan_fastmap - attach by reading the fastmap.
+ * @ubi: UBI device description object
+ *
+ * This function returns the scanning information, %NULL if there is no usable
+ * fastmap and the device has to be scanned, or an error pointer in case of
+ * failure.
+ */
+struct ubi_scan_info *ubi_scan_fastmap(struct ubi_device *ubi)
+{
+	struct ubi_scan_info *si = NULL;
+	struct ubi_ec_hdr *ech;
+	struct ubi_vid_hdr *vidh;
+	struct fm_peb *map = NULL;
+	void *buf = NULL;
+	int err, anchor, used_blocks;
+
+	ubi->fm_anchor = -1;
+
+	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	if (!ech)
+		return ERR_PTR(-ENOMEM);
+
+	err = -ENOMEM;
+	vidh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vidh)
+		goto out_ech;
+
+	err = anchor = fm_find_anchor(ubi, ech, vidh);
+	if (anchor < 0)
+		goto out_vidh;
+
+	err = -ENOMEM;
+	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	if (!si)
+		goto out_vidh;
+
+	INIT_LIST_HEAD(&si->corr);
+	INIT_LIST_HEAD(&si->free);
+	INIT_LIST_HEAD(&si->erase);
+	INIT_LIST_HEAD(&si->alien);
+	si->volumes = RB_ROOT;
+	si->min_ec = UBI_MAX_ERASECOUNTER;
+
+	map = vmalloc(ubi->peb_count * sizeof(struct fm_peb));
+	if (!map)
+		goto out_si;
+	memset(map, 0, ubi->peb_count * sizeof(struct fm_peb));
+
+	err = fm_read(ubi, si, anchor, &buf, &used_blocks, ech, vidh);
+	if (err)
+		goto out_si;
+
+	err = fm_attach(ubi, si, buf, used_blocks, map, ech, vidh);
+	if (err)
+		goto out_si;
+
+	if (si->ec_count) {
+		do_div(si->ec_sum, si->ec_count);
+		si->mean_ec = si->ec_sum;
+	}
+
+	ubi->fm_anchor = anchor;
+	ubi->fm_anchor_ec = be32_to_cpu(((struct ubi_fm_sb *)buf)->block_ec[0]);
+	ubi_msg("attached by fastmap in PEB %d (%d blocks)", anchor,
+		used_blocks);
+	goto out_map;
+
+out_si:
+	ubi_scan_destroy_si(si);
+	si = err < 0 ? ERR_PTR(err) : NULL;
+out_map:
+	vfree(buf);
+	vfree(map);
+	ubi_free_vid_hdr(ubi, vidh);
+	kfree(ech);
+	return si;
+
+out_vidh:
+	ubi_free_vid_hdr(ubi, vidh);
+out_ech:
+	kfree(ech);
+	return err == -1 ? NULL : ERR_PTR(err);
+}
+
+/**
+ * ubi_fastmap_invalidate - erase the fastmap before the device is modified.
+ * @ubi: UBI device description object
+ *
+ * This function is called before anything is written to or erased on the
+ * device. It returns zero in case of success and a negative error code in
+ * case of failure.
+ */
+int ubi_fastmap_invalidate(struct ubi_device *ubi)
+{
+	struct ubi_ec_hdr *ec_hdr;
+	int err, pnum = ubi->fm_anchor;
+
+	if (pnum < 0)
+		return 0;
+	ubi->fm_anchor = -1;
+
+	ubi_msg("invalidating fastmap in PEB %d", pnum);
+
+	ec_hdr = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
+	if (!ec_hdr)
+		return -ENOMEM;
+
+	err = ubi_io_sync_erase(ubi, pnum, 0);
+	if (err < 0)
+		goto out;
+
+	ec_hdr->ec = cpu_to_be64(ubi->fm_anchor_ec + err);
+	err = ubi_io_write_ec_hdr(ubi, pnum, ec_hdr);
+out:
+	kfree(ec_hdr);
+	return err;
+}
@@ -236,6 +236,13 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		return -EROFS;
 	}
 
+	err = ubi_fastmap_invalidate(ubi);
+	if (err)
+		return err;
+
+	if (ubi->hdr_buf_pnum == pnum)
+		ubi->hdr_buf_pnum = -1;
+
 	/* The below has to be compiled out if paranoid checks are disabled */
 
 	err = paranoid_check_not_bad(ubi, pnum);
@@ -308,6 +315,9 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 
 	dbg_io("erase PEB %d", pnum);
 
+	if (ubi->hdr_buf_pnum == pnum)
+		ubi->hdr_buf_pnum = -1;
+
 retry:
 	init_waitqueue_head(&wq);
 	memset(&ei, 0, sizeof(struct erase_info));
@@ -486,6 +496,10 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 		return -EROFS;
 	}
 
+	err = ubi_fastmap_invalidate(ubi);
+	if (err)
+		return err;
+
 	if (torture) {
 		ret = torture_peb(ubi, pnum);
 		if (ret < 0)
@@ -608,6 +622,34 @@ bad:
 	return 1;
 }
 
+/**
+ * read_hdrs - read both headers of a physical eraseblock at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to read from
+ *
+ * While scanning, @ubi->hdr_buf is set and the EC and VID headers are read
+ * with a single I/O, which lets the flash driver stream the pages instead of
+ * starting two reads. Returns what ubi_io_read() did; on a negative value
+ * nothing is buffered and the headers have to be read one by one.
+ */
+static int read_hdrs(struct ubi_device *ubi, int pnum)
+{
+	int err;
+
+	if (ubi->hdr_buf_pnum == pnum)
+		return ubi->hdr_buf_err;
+
+	ubi->hdr_buf_pnum = -1;
+	err = ubi_io_read(ubi, ubi->hdr_buf, pnum, 0, ubi->hdr_buf_len);
+	/* On an ECC error, read the headers separately to tell which one */
+	if (err && err != UBI_IO_BITFLIPS)
+		return err < 0 ? err : -EIO;
+
+	ubi->hdr_buf_pnum = pnum;
+	ubi->hdr_buf_err = err;
+	return err;
+}
+
 /**
  * ubi_io_read_ec_hdr - read and check an erase counter header.
  * @ubi: UBI device description object
@@ -639,7 +681,11 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 	if (UBI_IO_DEBUG)
 		verbose = 1;
 
-	err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
+	if (ubi->hdr_buf && read_hdrs(ubi, pnum) >= 0) {
+		memcpy(ec_hdr, ubi->hdr_buf, UBI_EC_HDR_SIZE);
+		err = ubi->hdr_buf_err;
+	} else
+		err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
 	if (err) {
 		if (err != UBI_IO_BITFLIPS && err != -EBADMSG)
 			return err;
@@ -915,8 +961,13 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 		verbose = 1;
 
 	p = (char *)vid_hdr - ubi->vid_hdr_shift;
-	err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
-			  ubi->vid_hdr_alsize);
+	if (ubi->hdr_buf && ubi->hdr_buf_pnum == pnum) {
+		memcpy(p, ubi->hdr_buf + ubi->vid_hdr_aloffset,
+		       ubi->vid_hdr_alsize);
+		err = ubi->hdr_buf_err;
+	} else
+		err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
+				  ubi->vid_hdr_alsize);
 	if (err) {
 		if (err != UBI_IO_BITFLIPS && err != -EBADMSG)
 			return err;
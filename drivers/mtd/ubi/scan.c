@@ -850,10 +850,10 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		case UBI_COMPAT_DELETE:
 			ubi_msg("\"delete\" compatible internal volume %d:%d"
 				" found, remove it", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->corr);
+			err = add_to_list(si, pnum, ec, &si->erase);
 			if (err)
 				return err;
-			break;
+			goto adjust_mean_ec;
 
 		case UBI_COMPAT_RO:
 			ubi_msg("read-only compatible internal volume %d:%d"
@@ -931,6 +931,11 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	if (!vidh)
 		goto out_ech;
 
+	/* Read both headers of each PEB at once; optional */
+	ubi->hdr_buf_len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	ubi->hdr_buf_pnum = -1;
+	ubi->hdr_buf = vmalloc(ubi->hdr_buf_len);
+
 	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
@@ -942,6 +947,10 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 
 	dbg_msg("scanning is finished");
 
+	vfree(ubi->hdr_buf);
+	ubi->hdr_buf = NULL;
+	ubi->hdr_buf_pnum = -1;
+
 	/* Calculate mean erase counter */
 	if (si->ec_count) {
 		do_div(si->ec_sum, si->ec_count);
@@ -987,6 +996,9 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	return si;
 
 out_vidh:
+	vfree(ubi->hdr_buf);
+	ubi->hdr_buf = NULL;
+	ubi->hdr_buf_pnum = -1;
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
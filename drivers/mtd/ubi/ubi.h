@@ -342,6 +342,15 @@ struct ubi_wl_entry;
  * @buf_mutex: proptects @peb_buf1 and @peb_buf2
  * @dbg_peb_buf: buffer of PEB size used for debugging
  * @dbg_buf_mutex: proptects @dbg_peb_buf
+ *
+ * @hdr_buf: buffer for both headers of a PEB, only allocated while scanning
+ * @hdr_buf_len: size of @hdr_buf (up to the end of the VID header)
+ * @hdr_buf_pnum: PEB whose headers are in @hdr_buf, %-1 if none
+ * @hdr_buf_err: what reading @hdr_buf returned (%0 or %UBI_IO_BITFLIPS)
+ *
+ * @fm_anchor: PEB of the fastmap super block the device was attached with,
+ *             %-1 if it was scanned or the fastmap has been invalidated
+ * @fm_anchor_ec: erase counter of @fm_anchor
  */
 struct ubi_device {
 	struct cdev cdev;
@@ -420,10 +429,18 @@ struct ubi_device {
 	void *peb_buf2;
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
+	void *hdr_buf;
+	int hdr_buf_len;
+	int hdr_buf_pnum;
+	int hdr_buf_err;
 #ifdef CONFIG_MTD_UBI_DEBUG
 	void *dbg_peb_buf;
 	struct mutex dbg_buf_mutex;
 #endif
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	int fm_anchor;
+	int fm_anchor_ec;
+#endif
 };
 
 extern struct kmem_cache *ubi_wl_entry_slab;
@@ -519,6 +536,17 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
 
+/* fastmap.c */
+#ifdef CONFIG_MTD_UBI_FASTMAP
+struct ubi_scan_info *ubi_scan_fastmap(struct ubi_device *ubi);
+int ubi_fastmap_invalidate(struct ubi_device *ubi);
+#else
+static inline int ubi_fastmap_invalidate(struct ubi_device *ubi)
+{
+	return 0;
+}
+#endif
+
 /* build.c */
 int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num, int vid_hdr_offset);
 int ubi_detach_mtd_dev(int ubi_num, int anyway);
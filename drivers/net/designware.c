@@ -29,6 +29,7 @@
 #include <miiphy.h>
 #include <malloc.h>
 #include <linux/err.h>
+#include <dma_map.h>
 #include <asm/io.h>
 #include "designware.h"
 
@@ -64,6 +65,8 @@ static void tx_descs_init(struct eth_device *dev)
 	/* Correcting the last pointer of the chain */
 	desc_p->dmamac_next = &desc_table_p[0];
 
+	dma_map_range(desc_table_p, sizeof(priv->tx_mac_descrtable),
+		      DMA_MAP_TO_DEVICE);
 	writel((ulong)&desc_table_p[0], &dma_p->txdesclistaddr);
 }
 
@@ -91,6 +94,10 @@ static void rx_descs_init(struct eth_device *dev)
 	/* Correcting the last pointer of the chain */
 	desc_p->dmamac_next = &desc_table_p[0];
 
+	/* All the buffers are posted, none may be written back over them */
+	dma_map_range(rxbuffs, RX_TOTAL_BUFSIZE, DMA_MAP_FROM_DEVICE);
+	dma_map_range(desc_table_p, sizeof(priv->rx_mac_descrtable),
+		      DMA_MAP_TO_DEVICE);
 	writel((ulong)&desc_table_p[0], &dma_p->rxdesclistaddr);
 }
 
@@ -155,6 +162,9 @@ static int dw_eth_init(struct eth_device *dev, bd_t *bis)
 	writel(STOREFORWARD | TXSECONDFRAME, &dma_p->opmode);
 
 	conf = FRAMEBURSTENABLE | DISABLERXOWN;
+#ifdef DW_JUMBO
+	conf |= JUMBOENABLE;
+#endif
 
 	if (priv->speed != SPEED_1000M)
 		conf |= MII_PORTSELECT;
@@ -187,12 +197,14 @@ static int dw_eth_send(struct eth_device *dev, volatile void *packet,
 	struct dmamacdescr *desc_p = &priv->tx_mac_descrtable[desc_num];
 
 	/* Check if the descriptor is owned by CPU */
+	dma_unmap_range(desc_p, sizeof(*desc_p), DMA_MAP_FROM_DEVICE);
 	if (desc_p->txrx_status & DESC_TXSTS_OWNBYDMA) {
 		printf("CPU not owner of tx frame\n");
 		return -1;
 	}
 
 	memcpy((void *)desc_p->dmamac_addr, (void *)packet, length);
+	dma_map_range(desc_p->dmamac_addr, length, DMA_MAP_TO_DEVICE);
 
 #if defined(CONFIG_DW_ALTDESCRIPTOR)
 	desc_p->txrx_status |= DESC_TXSTS_TXFIRST | DESC_TXSTS_TXLAST;
@@ -208,6 +220,7 @@ static int dw_eth_send(struct eth_device *dev, volatile void *packet,
 
 	desc_p->txrx_status = DESC_TXSTS_OWNBYDMA;
 #endif
+	dma_map_range(desc_p, sizeof(*desc_p), DMA_MAP_TO_DEVICE);
 
 	/* Test the wrap-around condition. */
 	if (++desc_num >= CONFIG_TX_DESCR_NUM)
@@ -226,23 +239,31 @@ static int dw_eth_recv(struct eth_device *dev)
 	struct dw_eth_dev *priv = dev->priv;
 	u32 desc_num = priv->rx_currdescnum;
 	struct dmamacdescr *desc_p = &priv->rx_mac_descrtable[desc_num];
-
-	u32 status = desc_p->txrx_status;
+	u32 status;
 	int length = 0;
 
+	dma_unmap_range(desc_p, sizeof(*desc_p), DMA_MAP_FROM_DEVICE);
+	status = desc_p->txrx_status;
+
 	/* Check  if the owner is the CPU */
 	if (!(status & DESC_RXSTS_OWNBYDMA)) {
 
 		length = (status & DESC_RXSTS_FRMLENMSK) >> \
 			 DESC_RXSTS_FRMLENSHFT;
 
+		dma_unmap_range(desc_p->dmamac_addr, length,
+				DMA_MAP_FROM_DEVICE);
 		NetReceive(desc_p->dmamac_addr, length);
+		/* the network code may have replied in place */
+		dma_map_range(desc_p->dmamac_addr, length,
+			      DMA_MAP_FROM_DEVICE);
 
 		/*
 		 * Make the current descriptor valid again and go to
 		 * the next one
 		 */
 		desc_p->txrx_status |= DESC_RXSTS_OWNBYDMA;
+		dma_map_range(desc_p, sizeof(*desc_p), DMA_MAP_TO_DEVICE);
 
 		/* Test the wrap-around condition. */
 		if (++desc_num >= CONFIG_RX_DESCR_NUM)
@@ -489,9 +510,11 @@ int designware_initialize(u32 id, ulong base_addr, u32 phy_addr)
 
 	/*
 	 * Since the priv structure contains the descriptors which need a strict
-	 * buswidth alignment, memalign is used to allocate memory
+	 * buswidth alignment, and each has a cache line of its own, memalign
+	 * is used to allocate memory
 	 */
-	priv = (struct dw_eth_dev *) memalign(16, sizeof(struct dw_eth_dev));
+	priv = (struct dw_eth_dev *) memalign(ARCH_DMA_MINALIGN,
+					      sizeof(struct dw_eth_dev));
 	if (!priv) {
 		free(dev);
 		return -ENOMEM;
@@ -525,6 +548,9 @@ int designware_initialize(u32 id, ulong base_addr, u32 phy_addr)
 	dev->recv = dw_eth_recv;
 	dev->halt = dw_eth_halt;
 	dev->write_hwaddr = dw_write_hwaddr;
+#ifdef DW_JUMBO
+	dev->max_mtu = MAC_MAX_FRAME_SZ - 18;
+#endif
 
 	eth_register(dev);
 
@@ -26,7 +26,13 @@
 
 #define CONFIG_TX_DESCR_NUM	16
 #define CONFIG_RX_DESCR_NUM	16
+#if defined(CONFIG_NET_JUMBO) && defined(CONFIG_DW_ALTDESCRIPTOR)
+/* an enhanced descriptor takes frames of up to 8K */
+#define DW_JUMBO
+#define CONFIG_ETH_BUFSIZE	8192
+#else
 #define CONFIG_ETH_BUFSIZE	2048
+#endif
 #define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
 #define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
 
@@ -54,6 +60,7 @@ struct eth_mac_regs {
 
 /* MAC configuration register definitions */
 #define FRAMEBURSTENABLE	(1 << 21)
+#define JUMBOENABLE		(1 << 20)
 #define MII_PORTSELECT		(1 << 15)
 #define FES_100			(1 << 14)
 #define DISABLERXOWN		(1 << 13)
@@ -121,14 +128,22 @@ struct eth_dma_regs {
 #define RXSTART			(1 << 1)
 
 /* Descriptior related definitions */
+#ifdef DW_JUMBO
+#define MAC_MAX_FRAME_SZ	(8192 - 16)
+#else
 #define MAC_MAX_FRAME_SZ	(2048)
+#endif
 
+/*
+ * The descriptors are chained, so each can have a cache line of its own
+ * and be invalidated or written back without touching the others.
+ */
 struct dmamacdescr {
 	u32 txrx_status;
 	u32 dmamac_cntl;
 	void *dmamac_addr;
 	struct dmamacdescr *dmamac_next;
-};
+} __attribute__ ((aligned(ARCH_DMA_MINALIGN)));
 
 /*
  * txrx_status definitions
@@ -243,8 +258,10 @@ struct dw_eth_dev {
 	struct dmamacdescr tx_mac_descrtable[CONFIG_TX_DESCR_NUM];
 	struct dmamacdescr rx_mac_descrtable[CONFIG_RX_DESCR_NUM];
 
-	char txbuffs[TX_TOTAL_BUFSIZE];
-	char rxbuffs[RX_TOTAL_BUFSIZE];
+	char txbuffs[TX_TOTAL_BUFSIZE]
+		__attribute__ ((aligned(ARCH_DMA_MINALIGN)));
+	char rxbuffs[RX_TOTAL_BUFSIZE]
+		__attribute__ ((aligned(ARCH_DMA_MINALIGN)));
 
 	struct eth_mac_regs *mac_regs_p;
 	struct eth_dma_regs *dma_regs_p;
@@ -45,6 +45,7 @@ tested on both gig copper and gig fiber boards
  */
 
 #include "e1000.h"
+#include <dma_map.h>
 
 #define TOUT_LOOP   100000
 
@@ -56,15 +57,33 @@ tested on both gig copper and gig fiber boards
 
 /* NIC specific static variables go here */
 
-static char tx_pool[128 + 16];
-static char rx_pool[128 + 16];
-static char packet[2096];
+#ifdef CONFIG_NET_JUMBO
+#define E1000_RX_BUFSIZE	16384
+#else
+#define E1000_RX_BUFSIZE	2048
+#endif
 
-static struct e1000_tx_desc *tx_base;
-static struct e1000_rx_desc *rx_base;
+/*
+ * The descriptors are 16 bytes, so several of them share a cache line.
+ * Receive descriptors go back to the hardware a whole line at a time:
+ * the CPU never writes a line the hardware may write at the same time,
+ * and holds one line so that the ring is never full.  The rings are at
+ * least 128 bytes long, as the hardware wants.
+ */
+#define E1000_DESC_LINE		(ARCH_DMA_MINALIGN > 16 ? \
+				 ARCH_DMA_MINALIGN / 16 : 1)
+#define E1000_RX_DESCS		(E1000_DESC_LINE > 8 ? 2 * E1000_DESC_LINE : 16)
+#define E1000_TX_DESCS		(E1000_DESC_LINE > 8 ? E1000_DESC_LINE : 8)
+
+static struct e1000_tx_desc tx_base[E1000_TX_DESCS]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
+static struct e1000_rx_desc rx_base[E1000_RX_DESCS]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
+static unsigned char rx_buf[E1000_RX_DESCS][E1000_RX_BUFSIZE]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
 
 static int tx_tail;
-static int rx_tail, rx_last;
+static int rx_next;
 
 static struct pci_device_id e1000_supported[] = {
 	{PCI_VENDOR_ID_INTEL, PCI_DEVICE_ID_INTEL_82542},
@@ -4828,17 +4847,17 @@ e1000_sw_init(struct eth_device *nic)
 	return E1000_SUCCESS;
 }
 
-void
-fill_rx(struct e1000_hw *hw)
+/* Post the buffers of the receive descriptors of a cache line again */
+static void
+fill_rx(struct e1000_rx_desc *rd)
 {
-	struct e1000_rx_desc *rd;
-
-	rx_last = rx_tail;
-	rd = rx_base + rx_tail;
-	rx_tail = (rx_tail + 1) % 8;
-	memset(rd, 0, 16);
-	rd->buffer_addr = cpu_to_le64((u32) & packet);
-	E1000_WRITE_REG(hw, RDT, rx_tail);
+	int i;
+
+	for (i = 0; i < E1000_DESC_LINE; i++) {
+		memset(&rd[i], 0, sizeof(rd[i]));
+		rd[i].buffer_addr = cpu_to_le64((u32)rx_buf[rd + i - rx_base]);
+	}
+	dma_map_range(rd, E1000_DESC_LINE * sizeof(*rd), DMA_MAP_TO_DEVICE);
 }
 
 /**
@@ -4851,21 +4870,17 @@ fill_rx(struct e1000_hw *hw)
 static void
 e1000_configure_tx(struct e1000_hw *hw)
 {
-	unsigned long ptr;
 	unsigned long tctl;
 	unsigned long tipg, tarc;
 	uint32_t ipgr1, ipgr2;
 
-	ptr = (u32) tx_pool;
-	if (ptr & 0xf)
-		ptr = (ptr + 0x10) & (~0xf);
-
-	tx_base = (typeof(tx_base)) ptr;
+	memset(tx_base, 0, sizeof(tx_base));
+	dma_map_range(tx_base, sizeof(tx_base), DMA_MAP_TO_DEVICE);
 
 	E1000_WRITE_REG(hw, TDBAL, (u32) tx_base);
 	E1000_WRITE_REG(hw, TDBAH, 0);
 
-	E1000_WRITE_REG(hw, TDLEN, 128);
+	E1000_WRITE_REG(hw, TDLEN, sizeof(tx_base));
 
 	/* Setup the HW Tx Head and Tail descriptor pointers */
 	E1000_WRITE_REG(hw, TDH, 0);
@@ -4937,6 +4952,14 @@ e1000_configure_tx(struct e1000_hw *hw)
  * e1000_setup_rctl - configure the receive control register
  * @adapter: Board private structure
  **/
+#ifdef CONFIG_NET_JUMBO
+/* All but these take long packets */
+static int e1000_jumbo_ok(struct e1000_hw *hw)
+{
+	return hw->mac_type != e1000_82573 && hw->mac_type != e1000_ich8lan;
+}
+#endif
+
 static void
 e1000_setup_rctl(struct e1000_hw *hw)
 {
@@ -4956,8 +4979,16 @@ e1000_setup_rctl(struct e1000_hw *hw)
 		rctl &= ~E1000_RCTL_SBP;
 
 	rctl &= ~(E1000_RCTL_SZ_4096);
+#ifdef CONFIG_NET_JUMBO
+	if (e1000_jumbo_ok(hw)) {
+		rctl |= E1000_RCTL_BSEX | E1000_RCTL_SZ_16384 |
+			E1000_RCTL_LPE;
+	} else
+#endif
+	{
 		rctl |= E1000_RCTL_SZ_2048;
 		rctl &= ~(E1000_RCTL_BSEX | E1000_RCTL_LPE);
+	}
 	E1000_WRITE_REG(hw, RCTL, rctl);
 }
 
@@ -4970,9 +5001,10 @@ e1000_setup_rctl(struct e1000_hw *hw)
 static void
 e1000_configure_rx(struct e1000_hw *hw)
 {
-	unsigned long ptr;
 	unsigned long rctl, ctrl_ext;
-	rx_tail = 0;
+	int i;
+
+	rx_next = 0;
 	/* make sure receives are disabled while setting up the descriptors */
 	rctl = E1000_READ_REG(hw, RCTL);
 	E1000_WRITE_REG(hw, RCTL, rctl & ~E1000_RCTL_EN);
@@ -4991,23 +5023,23 @@ e1000_configure_rx(struct e1000_hw *hw)
 		E1000_WRITE_REG(hw, CTRL_EXT, ctrl_ext);
 		E1000_WRITE_FLUSH(hw);
 	}
+	/* Post all the receive buffers */
+	dma_map_range(rx_buf, sizeof(rx_buf), DMA_MAP_FROM_DEVICE);
+	for (i = 0; i < E1000_RX_DESCS; i += E1000_DESC_LINE)
+		fill_rx(rx_base + i);
+
 	/* Setup the Base and Length of the Rx Descriptor Ring */
-	ptr = (u32) rx_pool;
-	if (ptr & 0xf)
-		ptr = (ptr + 0x10) & (~0xf);
-	rx_base = (typeof(rx_base)) ptr;
 	E1000_WRITE_REG(hw, RDBAL, (u32) rx_base);
 	E1000_WRITE_REG(hw, RDBAH, 0);
 
-	E1000_WRITE_REG(hw, RDLEN, 128);
+	E1000_WRITE_REG(hw, RDLEN, sizeof(rx_base));
 
 	/* Setup the HW Rx Head and Tail Descriptor Pointers */
 	E1000_WRITE_REG(hw, RDH, 0);
-	E1000_WRITE_REG(hw, RDT, 0);
+	E1000_WRITE_REG(hw, RDT, E1000_RX_DESCS - E1000_DESC_LINE);
 	/* Enable Receives */
 
 	E1000_WRITE_REG(hw, RCTL, rctl);
-	fill_rx(hw);
 }
 
 /**************************************************************************
@@ -5017,14 +5049,32 @@ static int
 e1000_poll(struct eth_device *nic)
 {
 	struct e1000_hw *hw = nic->priv;
-	struct e1000_rx_desc *rd;
+	struct e1000_rx_desc *rd, *line;
+	unsigned char *buf;
+	int len;
+
 	/* return true if there's an ethernet packet ready to read */
-	rd = rx_base + rx_last;
-	if (!(le32_to_cpu(rd->status)) & E1000_RXD_STAT_DD)
+	rd = rx_base + rx_next;
+	line = rx_base + (rx_next & ~(E1000_DESC_LINE - 1));
+	dma_unmap_range(line, E1000_DESC_LINE * sizeof(*rd),
+			DMA_MAP_FROM_DEVICE);
+	if (!(rd->status & E1000_RXD_STAT_DD))
 		return 0;
-	/*DEBUGOUT("recv: packet len=%d \n", rd->length); */
-	NetReceive((uchar *)packet, le32_to_cpu(rd->length));
-	fill_rx(hw);
+
+	len = le16_to_cpu(rd->length);
+	buf = rx_buf[rx_next];
+	/*DEBUGOUT("recv: packet len=%d \n", len); */
+	dma_unmap_range(buf, len, DMA_MAP_FROM_DEVICE);
+	NetReceive(buf, len);
+	/* the network code may have replied in place */
+	dma_map_range(buf, len, DMA_MAP_FROM_DEVICE);
+
+	rx_next = (rx_next + 1) % E1000_RX_DESCS;
+	if (!(rx_next % E1000_DESC_LINE)) {
+		/* hand the held line over, hold the one just emptied */
+		fill_rx(line);
+		E1000_WRITE_REG(hw, RDT, line - rx_base);
+	}
 	return 1;
 }
 
@@ -5040,21 +5090,28 @@ e1000_transmit(struct eth_device *nic, volatile void *packet, int length)
 	int i = 0;
 
 	txp = tx_base + tx_tail;
-	tx_tail = (tx_tail + 1) % 8;
+	tx_tail = (tx_tail + 1) % E1000_TX_DESCS;
 
+	/* the other descriptors of the line are done, as this one will be */
+	dma_map_range(nv_packet, length, DMA_MAP_TO_DEVICE);
 	txp->buffer_addr = cpu_to_le64(virt_to_bus(hw->pdev, nv_packet));
 	txp->lower.data = cpu_to_le32(hw->txd_cmd | length);
 	txp->upper.data = 0;
+	dma_map_range(txp, sizeof(*txp), DMA_MAP_BIDIRECTIONAL);
 	E1000_WRITE_REG(hw, TDT, tx_tail);
 
 	E1000_WRITE_FLUSH(hw);
-	while (!(le32_to_cpu(txp->upper.data) & E1000_TXD_STAT_DD)) {
+	for (;;) {
+		dma_unmap_range(txp, sizeof(*txp), DMA_MAP_BIDIRECTIONAL);
+		if (le32_to_cpu(txp->upper.data) & E1000_TXD_STAT_DD)
+			break;
 		if (i++ > TOUT_LOOP) {
 			DEBUGOUT("e1000: tx timeout\n");
 			return 0;
 		}
 		udelay(10);	/* give the nic a chance to write to the register */
 	}
+	dma_unmap_range(nv_packet, length, DMA_MAP_TO_DEVICE);
 	return 1;
 }
 
@@ -5263,6 +5320,10 @@ e1000_initialize(bd_t * bis)
 		nic->recv = e1000_poll;
 		nic->send = e1000_transmit;
 		nic->halt = e1000_disable;
+#ifdef CONFIG_NET_JUMBO
+		if (e1000_jumbo_ok(hw))
+			nic->max_mtu = ETH_MTU_MAX;
+#endif
 		eth_register(nic);
 	}
 
@@ -659,7 +659,6 @@ static int fec_recv(struct eth_device *dev)
 	int frame_length, len = 0;
 	struct nbuf *frame;
 	uint16_t bd_status;
-	uchar buff[FEC_MAX_PKT_SIZE];
 
 	/*
 	 * Check if any critical events have happened
@@ -708,8 +707,13 @@ static int fec_recv(struct eth_device *dev)
 #ifdef	CONFIG_FEC_MXC_SWAP_PACKET
 			swap_packet((uint32_t *)frame->data, frame_length);
 #endif
-			memcpy(buff, frame->data, frame_length);
-			NetReceive(buff, frame_length);
+			/*
+			 * Hand the DMA buffer up directly; the descriptor
+			 * is not recycled before NetReceive() returns, so
+			 * the protocol's copy to the load address is the
+			 * only one.
+			 */
+			NetReceive(frame->data, frame_length);
 			len = frame_length;
 		} else {
 			if (bd_status & FEC_RBD_ERR)
@@ -730,6 +734,22 @@ static int fec_recv(struct eth_device *dev)
 	return len;
 }
 
+/**
+ * Pull all frames the card has ready, up to a limit
+ * @param[in] dev Our ethernet device to handle
+ * @param[in] budget Maximum number of frames to pass up
+ * @return Number of frames read
+ */
+static int fec_recv_batch(struct eth_device *dev, int budget)
+{
+	int count = 0;
+
+	while (count < budget && fec_recv(dev) > 0)
+		count++;
+
+	return count;
+}
+
 static int fec_probe(bd_t *bd, int dev_id, int phy_id, uint32_t base_addr)
 {
 	struct eth_device *edev;
@@ -760,6 +780,7 @@ static int fec_probe(bd_t *bd, int dev_id, int phy_id, uint32_t base_addr)
 	edev->init = fec_init;
 	edev->send = fec_send;
 	edev->recv = fec_recv;
+	edev->recv_batch = fec_recv_batch;
 	edev->halt = fec_halt;
 	edev->write_hwaddr = fec_set_hwaddr;
 
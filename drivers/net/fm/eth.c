@@ -250,6 +250,7 @@ static int fm_eth_tx_port_parameter_init(struct fm_eth *fm_eth)
 	struct fm_port_global_pram *pram;
 	u32 pram_page_offset;
 	void *tx_bd_ring_base;
+	void *tx_buf_pool;
 	struct fm_port_bd *txbd;
 	struct fm_port_qd *txqd;
 	struct fm_bmi_tx_port *bmi_tx_port = fm_eth->tx_port;
@@ -276,9 +277,16 @@ static int fm_eth_tx_port_parameter_init(struct fm_eth *fm_eth)
 		return 0;
 	memset(tx_bd_ring_base, 0, sizeof(struct fm_port_bd)
 			* TX_BD_RING_SIZE);
+
+	/* alloc Tx buffers, so that a frame can go out while the next is built */
+	tx_buf_pool = malloc(PKTSIZE_ALIGN * TX_BD_RING_SIZE);
+	if (!tx_buf_pool)
+		return 0;
+
 	/* save it to fm_eth */
 	fm_eth->tx_bd_ring = tx_bd_ring_base;
 	fm_eth->cur_txbd = tx_bd_ring_base;
+	fm_eth->tx_buf = tx_buf_pool;
 
 	/* init Tx BDs ring */
 	txbd = (struct fm_port_bd *)tx_bd_ring_base;
@@ -286,7 +294,8 @@ static int fm_eth_tx_port_parameter_init(struct fm_eth *fm_eth)
 		txbd->status = TxBD_LAST;
 		txbd->len = 0;
 		txbd->buf_ptr_hi = 0;
-		txbd->buf_ptr_lo = 0;
+		txbd->buf_ptr_lo = (u32)tx_buf_pool + i * PKTSIZE_ALIGN;
+		txbd++;
 	}
 
 	/* set the Tx queue decriptor */
@@ -404,10 +413,18 @@ static void fm_eth_halt(struct eth_device *dev)
 {
 	struct fm_eth *fm_eth;
 	struct fsl_enet_mac *mac;
+	struct fm_port_bd *txbd;
+	int i, timeout = 0x1000;
 
 	fm_eth = (struct fm_eth *)dev->priv;
 	mac = fm_eth->mac;
 
+	/* let the frames still queued go out first */
+	txbd = (struct fm_port_bd *)fm_eth->tx_bd_ring;
+	for (i = 0; i < TX_BD_RING_SIZE; i++, txbd++)
+		while ((txbd->status & TxBD_READY) && timeout-- > 0)
+			udelay(100);
+
 	/* graceful stop the transmission of frames */
 	fmc_tx_port_graceful_stop_enable(fm_eth);
 	/* disable bmi Tx port */
@@ -440,9 +457,15 @@ static int fm_eth_send(struct eth_device *dev, volatile void *buf, int len)
 			return 0;
 		}
 	}
-	/* setup TxBD */
-	txbd->buf_ptr_hi = 0;
-	txbd->buf_ptr_lo = (u32)buf;
+	if (len > PKTSIZE_ALIGN)
+		return 0;
+
+	/*
+	 * Copy the frame into the BD's own buffer, the caller builds the
+	 * next one in buf while this one goes out; the ring only has to
+	 * be waited for once it is full.
+	 */
+	memcpy((void *)txbd->buf_ptr_lo, (void *)buf, len);
 	txbd->len = len;
 	sync();
 	txbd->status = TxBD_READY | TxBD_LAST;
@@ -456,15 +479,6 @@ static int fm_eth_send(struct eth_device *dev, volatile void *buf, int len)
 	muram_writew(&pram->txqd.offset_in, offset_in);
 	sync();
 
-	/* wait for buffer to be transmitted */
-	for (i = 0; txbd->status & TxBD_READY; i++) {
-		udelay(100);
-		if (i > 0x10000) {
-			printf("%s: Tx error\n", dev->name);
-			return 0;
-		}
-	}
-
 	/* advance the TxBD */
 	txbd++;
 	txbd_base = (struct fm_port_bd *)fm_eth->tx_bd_ring;
@@ -476,7 +490,7 @@ static int fm_eth_send(struct eth_device *dev, volatile void *buf, int len)
 	return 1;
 }
 
-static int fm_eth_recv(struct eth_device *dev)
+static int fm_eth_recv_batch(struct eth_device *dev, int budget)
 {
 	struct fm_eth *fm_eth;
 	struct fm_port_global_pram *pram;
@@ -484,21 +498,23 @@ static int fm_eth_recv(struct eth_device *dev)
 	u16 status, len;
 	u8 *data;
 	u16 offset_out;
+	int count = 0;
 
 	fm_eth = (struct fm_eth *)dev->priv;
 	pram = fm_eth->rx_pram;
 	rxbd = fm_eth->cur_rxbd;
 	status = rxbd->status;
 
-	while (!(status & RxBD_EMPTY)) {
+	while (count < budget && !(status & RxBD_EMPTY)) {
 		if (!(status & RxBD_ERROR)) {
 			data = (u8 *)rxbd->buf_ptr_lo;
 			len = rxbd->len;
 			NetReceive(data, len);
 		} else {
+			/* drop the frame but give the BD back */
 			printf("%s: Rx error\n", dev->name);
-			return 0;
 		}
+		count++;
 
 		/* clear the RxBDs */
 		rxbd->status = RxBD_EMPTY;
@@ -523,7 +539,12 @@ static int fm_eth_recv(struct eth_device *dev)
 	}
 	fm_eth->cur_rxbd = (void *)rxbd;
 
-	return 1;
+	return count;
+}
+
+static int fm_eth_recv(struct eth_device *dev)
+{
+	return fm_eth_recv_batch(dev, RX_BD_RING_SIZE);
 }
 
 static int fm_eth_init_mac(struct fm_eth *fm_eth, struct ccsr_fman *reg)
@@ -553,9 +574,9 @@ static int fm_eth_init_mac(struct fm_eth *fm_eth, struct ccsr_fman *reg)
 	fm_eth->mac = mac;
 
 	if (fm_eth->type == FM_ETH_1G_E)
-		init_dtsec(mac, base, phyregs, MAX_RXBUF_LEN);
+		init_dtsec(mac, base, phyregs, MAX_RX_FRAME_LEN);
 	else
-		init_tgec(mac, base, phyregs, MAX_RXBUF_LEN);
+		init_tgec(mac, base, phyregs, MAX_RX_FRAME_LEN);
 
 	return 1;
 }
@@ -631,7 +652,7 @@ int fm_eth_initialize(struct ccsr_fman *reg, struct fm_eth_info *info)
 	fm_eth->tx_port = (void *)&reg->port[info->tx_port_id - 1].fm_bmi;
 
 	/* set the ethernet max receive length */
-	fm_eth->max_rx_len = MAX_RXBUF_LEN;
+	fm_eth->max_rx_len = MAX_RX_FRAME_LEN;
 
 	/* init global mac structure */
 	if (!fm_eth_init_mac(fm_eth, reg))
@@ -650,6 +671,8 @@ int fm_eth_initialize(struct ccsr_fman *reg, struct fm_eth_info *info)
 	dev->halt = fm_eth_halt;
 	dev->send = fm_eth_send;
 	dev->recv = fm_eth_recv;
+	dev->recv_batch = fm_eth_recv_batch;
+	dev->max_mtu = ETH_MTU_MAX;
 	fm_eth->dev = dev;
 	fm_eth->bus = info->bus;
 	fm_eth->phyaddr = info->phy_addr;
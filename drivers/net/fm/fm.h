@@ -145,11 +145,30 @@ struct fm_eth {
 	void *rx_buf;			/* Rx buffer base */
 	void *tx_bd_ring;		/* Tx BD ring base */
 	void *cur_txbd;			/* current Tx BD */
+	void *tx_buf;			/* Tx buffer base */
 };
 
-#define RX_BD_RING_SIZE		8
+/*
+ * A 10G port fills eight buffers in well under the time it takes to
+ * hand a TFTP block to the loader, so keep more of them by default.
+ */
+#ifdef CONFIG_SYS_FM_RX_BD_RING_SIZE
+#define RX_BD_RING_SIZE		CONFIG_SYS_FM_RX_BD_RING_SIZE
+#else
+#define RX_BD_RING_SIZE		32
+#endif
+#ifdef CONFIG_SYS_FM_TX_BD_RING_SIZE
+#define TX_BD_RING_SIZE		CONFIG_SYS_FM_TX_BD_RING_SIZE
+#else
 #define TX_BD_RING_SIZE		8
+#endif
+#ifdef CONFIG_NET_JUMBO
+#define MAX_RXBUF_LOG2		14
+#define MAX_RX_FRAME_LEN	PKTSIZE
+#else
 #define MAX_RXBUF_LOG2		11
+#define MAX_RX_FRAME_LEN	MAX_RXBUF_LEN
+#endif
 #define MAX_RXBUF_LEN		(1 << MAX_RXBUF_LOG2)
 
 #endif /* __FM_H__ */
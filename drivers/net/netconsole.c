@@ -28,6 +28,19 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/*
+ * Output is collected into packets of up to CONFIG_NETCONSOLE_BUFFER_SIZE
+ * bytes.  They go out when full, at the first newline after they have
+ * been waited on CONFIG_NETCONSOLE_FLUSH_MS, and whenever the console
+ * waits for input or the network is used otherwise.
+ */
+#ifndef CONFIG_NETCONSOLE_BUFFER_SIZE
+#define CONFIG_NETCONSOLE_BUFFER_SIZE	1472	/* UDP data in an ethernet MTU */
+#endif
+#ifndef CONFIG_NETCONSOLE_FLUSH_MS
+#define CONFIG_NETCONSOLE_FLUSH_MS	50
+#endif
+
 static char input_buffer[512];
 static int input_size = 0;		/* char count in input buffer */
 static int input_offset = 0;		/* offset to valid chars in input buffer */
@@ -39,6 +52,10 @@ static IPaddr_t nc_ip;			/* server ip */
 static short nc_port;			/* source/target port */
 static const char *output_packet;	/* used by first send udp */
 static int output_packet_len = 0;
+static char output_buffer[CONFIG_NETCONSOLE_BUFFER_SIZE];
+static int output_size;			/* char count in output buffer */
+static ulong output_start;		/* get_timer() of its first char */
+static int output_sync;			/* unbuffered, see nc_sync() */
 
 static void nc_wait_arp_handler(uchar *pkt, unsigned dest,
 				 IPaddr_t sip, unsigned src,
@@ -170,32 +187,71 @@ static int nc_start(void)
 	return 0;
 }
 
+void nc_flush(void)
+{
+	if (output_recursion || !output_size)
+		return;
+	output_recursion = 1;
+
+	nc_send_packet(output_buffer, output_size);
+	output_size = 0;
+
+	output_recursion = 0;
+}
+
+void nc_sync(void)
+{
+	nc_flush();
+	output_sync = 1;
+}
+
+static void nc_write(const char *s, int len)
+{
+	int chunk, newline = 0;
+
+	while (len) {
+		if (!output_size)
+			output_start = get_timer(0);
+
+		chunk = min(len, (int)sizeof(output_buffer) - output_size);
+		memcpy(output_buffer + output_size, s, chunk);
+		output_size += chunk;
+		if (memchr(s, '\n', chunk))
+			newline = 1;
+		len -= chunk;
+		s += chunk;
+
+		if (output_size == sizeof(output_buffer) || output_sync) {
+			nc_send_packet(output_buffer, output_size);
+			output_size = 0;
+		}
+	}
+
+	if (newline && output_size &&
+	    get_timer(output_start) >= CONFIG_NETCONSOLE_FLUSH_MS) {
+		nc_send_packet(output_buffer, output_size);
+		output_size = 0;
+	}
+}
+
 static void nc_putc(char c)
 {
 	if (output_recursion)
 		return;
 	output_recursion = 1;
 
-	nc_send_packet (&c, 1);
+	nc_write(&c, 1);
 
 	output_recursion = 0;
 }
 
 static void nc_puts(const char *s)
 {
-	int len;
-
 	if (output_recursion)
 		return;
 	output_recursion = 1;
 
-	len = strlen(s);
-	while (len) {
-		int send_len = min(len, 512);
-		nc_send_packet(s, send_len);
-		len -= send_len;
-		s += send_len;
-	}
+	nc_write(s, strlen(s));
 
 	output_recursion = 0;
 }
@@ -204,6 +260,8 @@ static int nc_getc(void)
 {
 	uchar c;
 
+	nc_flush();
+
 	input_recursion = 1;
 
 	net_timeout = 0;	/* no timeout */
@@ -235,6 +293,8 @@ static int nc_tstc(void)
 	if (eth && eth->state == ETH_STATE_ACTIVE)
 		return 0;	/* inside net loop */
 
+	nc_flush();
+
 	input_recursion = 1;
 
 	net_timeout = 1;
@@ -709,8 +709,13 @@ struct phy_device *phy_connect(struct mii_dev *bus, int addr,
 		return NULL;
 	}
 
-	/* Soft Reset the PHY */
-	phy_reset(phydev);
+	/* Soft Reset the PHY, unless that stops phy_early_aneg() */
+#ifdef CONFIG_PHYLIB_EARLY_ANEG
+	if (bus->aneg_early & (1 << addr))
+		bus->aneg_early &= ~(1 << addr);
+	else
+#endif
+		phy_reset(phydev);
 
 	if (phydev->dev)
 		printf("%s:%d is connected to %s.  Reconnecting to %s\n",
@@ -723,6 +728,89 @@ struct phy_device *phy_connect(struct mii_dev *bus, int addr,
 	return phydev;
 }
 
+#ifdef CONFIG_PHYLIB_EARLY_ANEG
+static void phy_early_aneg_bus(struct mii_dev *bus)
+{
+	u32 phy_id;
+	int addr, ctl;
+
+	for (addr = 0; addr < PHY_MAX_ADDR; addr++) {
+		/* the driver has it set up already */
+		if (bus->phymap[addr])
+			continue;
+
+		if (get_phy_id(bus, addr, MDIO_DEVAD_NONE, &phy_id) ||
+		    !phy_id || (phy_id & 0x1fffffff) == 0x1fffffff)
+			continue;
+
+		ctl = bus->read(bus, addr, MDIO_DEVAD_NONE, MII_BMCR);
+		if (ctl < 0)
+			continue;
+
+		/* most PHYs come out of reset negotiating */
+		if (!(ctl & BMCR_ANENABLE) ||
+		    (ctl & (BMCR_ISOLATE | BMCR_PDOWN))) {
+			ctl &= ~(BMCR_ISOLATE | BMCR_PDOWN);
+			ctl |= BMCR_ANENABLE | BMCR_ANRESTART;
+			if (bus->write(bus, addr, MDIO_DEVAD_NONE,
+				       MII_BMCR, ctl) < 0)
+				continue;
+		}
+
+		debug("%s:%d negotiating\n", bus->name, addr);
+		bus->aneg_early |= 1 << addr;
+	}
+}
+
+/*
+ * Get autonegotiation going on the PHYs of all the MDIO buses, without
+ * waiting for it, from eth_initialize().  The link is then mostly up by
+ * the time the first network command waits for it in phy_startup(), as
+ * phy_connect() does not reset these PHYs again.
+ */
+void phy_early_aneg(void)
+{
+	struct mii_dev *bus;
+
+	for (bus = mdio_next_dev(NULL); bus; bus = mdio_next_dev(bus))
+		phy_early_aneg_bus(bus);
+}
+#endif
+
+/*
+ * The link as it is right now, without waiting for autonegotiation as
+ * phy_startup() does, so that a device can be picked by it first.
+ */
+int phy_link_state(struct eth_device *dev)
+{
+	struct phy_device *phydev;
+	struct mii_dev *bus;
+	int addr, reg;
+
+	for (bus = mdio_next_dev(NULL); bus; bus = mdio_next_dev(bus)) {
+		for (addr = 0; addr < PHY_MAX_ADDR; addr++) {
+			phydev = bus->phymap[addr];
+			if (!phydev || phydev->dev != dev)
+				continue;
+
+#ifdef CONFIG_PHYLIB_10G
+			if (is_10g_interface(phydev->interface))
+				return -1;
+#endif
+
+			/* the link bit latches low: the second read is now */
+			phy_read(phydev, MDIO_DEVAD_NONE, MII_BMSR);
+			reg = phy_read(phydev, MDIO_DEVAD_NONE, MII_BMSR);
+			if (reg < 0)
+				return -1;
+
+			return (reg & BMSR_LSTATUS) ? 1 : 0;
+		}
+	}
+
+	return -1;
+}
+
 int phy_startup(struct phy_device *phydev)
 {
 	if (phydev->drv->startup)
@@ -0,0 +1,109 @@
+/*
+ * Sandbox Ethernet on a tap interface of the host
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Frames go to and come from the tap interface named by the "tap"
+ * variable (default tap0), which has to exist and be up on the host:
+ *
+ *	ip tuntap add dev tap0 mode tap user $USER
+ *	ip addr add 192.168.0.1/24 dev tap0
+ *	ip link set tap0 up
+ *
+ * so that a TFTP server on the workstation can be used to measure the
+ * network stack without a board.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <net.h>
+#include <netdev.h>
+#include <os.h>
+
+struct sandbox_eth_priv {
+	int fd;
+};
+
+static int sb_eth_init(struct eth_device *dev, bd_t *bis)
+{
+	struct sandbox_eth_priv *priv = dev->priv;
+	char *ifname = getenv("tap");
+
+	priv->fd = os_tap_open(ifname ? ifname : "tap0");
+	if (priv->fd < 0) {
+		printf("%s: cannot open tap %s\n", dev->name,
+		       ifname ? ifname : "tap0");
+		return -1;
+	}
+	return 0;
+}
+
+static int sb_eth_send(struct eth_device *dev, volatile void *packet,
+		       int length)
+{
+	struct sandbox_eth_priv *priv = dev->priv;
+
+	if (os_write(priv->fd, (void *)packet, length) != length)
+		return -1;
+	return 0;
+}
+
+static int sb_eth_recv(struct eth_device *dev)
+{
+	struct sandbox_eth_priv *priv = dev->priv;
+	ssize_t len;
+
+	len = os_read(priv->fd, (void *)NetRxPackets[0], PKTSIZE_ALIGN);
+	if (len <= 0)
+		return 0;
+	NetReceive(NetRxPackets[0], len);
+	return len;
+}
+
+static int sb_eth_recv_batch(struct eth_device *dev, int budget)
+{
+	int count = 0;
+
+	while (count < budget && sb_eth_recv(dev) > 0)
+		count++;
+
+	return count;
+}
+
+static void sb_eth_halt(struct eth_device *dev)
+{
+	struct sandbox_eth_priv *priv = dev->priv;
+
+	if (priv->fd >= 0)
+		os_close(priv->fd);
+	priv->fd = -1;
+}
+
+int sandbox_eth_initialize(bd_t *bis)
+{
+	struct eth_device *dev;
+	struct sandbox_eth_priv *priv;
+
+	dev = malloc(sizeof(*dev));
+	priv = malloc(sizeof(*priv));
+	if (!dev || !priv) {
+		free(dev);
+		free(priv);
+		return -1;
+	}
+	memset(dev, 0, sizeof(*dev));
+	priv->fd = -1;
+
+	sprintf(dev->name, "tap");
+	dev->priv = priv;
+	dev->init = sb_eth_init;
+	dev->send = sb_eth_send;
+	dev->recv = sb_eth_recv;
+	dev->recv_batch = sb_eth_recv_batch;
+	dev->halt = sb_eth_halt;
+
+	return eth_register(dev);
+}
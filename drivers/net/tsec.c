@@ -182,6 +182,9 @@ static void init_registers(tsec_t *regs)
 	out_be32(&regs->rmon.cam2, 0xffffffff);
 
 	out_be32(&regs->mrblr, MRBLR_INIT_SETTINGS);
+#ifdef CONFIG_NET_JUMBO
+	out_be32(&regs->maxfrm, PKTSIZE);
+#endif
 
 	out_be32(&regs->minflr, MINFLR_INIT_SETTINGS);
 
@@ -414,13 +417,13 @@ static int tsec_send(struct eth_device *dev, volatile void *packet, int length)
 	return result;
 }
 
-static int tsec_recv(struct eth_device *dev)
+static int tsec_recv_batch(struct eth_device *dev, int budget)
 {
-	int length;
+	int length, count = 0;
 	struct tsec_private *priv = (struct tsec_private *)dev->priv;
 	tsec_t *regs = priv->regs;
 
-	while (!(rtx.rxbd[rxIdx].status & RXBD_EMPTY)) {
+	while (count < budget && !(rtx.rxbd[rxIdx].status & RXBD_EMPTY)) {
 
 		length = rtx.rxbd[rxIdx].length;
 
@@ -439,6 +442,7 @@ static int tsec_recv(struct eth_device *dev)
 		    RXBD_EMPTY | (((rxIdx + 1) == PKTBUFSRX) ? RXBD_WRAP : 0);
 
 		rxIdx = (rxIdx + 1) % PKTBUFSRX;
+		count++;
 	}
 
 	if (in_be32(&regs->ievent) & IEVENT_BSY) {
@@ -446,6 +450,13 @@ static int tsec_recv(struct eth_device *dev)
 		out_be32(&regs->rstat, RSTAT_CLEAR_RHALT);
 	}
 
+	return count;
+}
+
+static int tsec_recv(struct eth_device *dev)
+{
+	tsec_recv_batch(dev, PKTBUFSRX);
+
 	return -1;
 
 }
@@ -637,9 +648,11 @@ static int tsec_initialize(bd_t *bis, struct tsec_info_struct *tsec_info)
 	dev->halt = tsec_halt;
 	dev->send = tsec_send;
 	dev->recv = tsec_recv;
+	dev->recv_batch = tsec_recv_batch;
 #ifdef CONFIG_MCAST_TFTP
 	dev->mcast = tsec_mcast_addr;
 #endif
+	dev->max_mtu = ETH_MTU_MAX;
 
 	/* Tell u-boot to get the addr from the env */
 	for (i = 0; i < 6; i++)
@@ -65,6 +65,43 @@ void pciauto_config_init(struct pci_controller *hose);
 #define CONFIG_SYS_PCI64_MEMORY_BUS (64ull*1024*1024*1024)
 #endif
 
+#ifdef CONFIG_FSL_PCIE_RESET
+/*
+ * PCIe controllers whose link came up in the error state are reset by
+ * fsl_pcie_init_board() before any of them is configured, so that their
+ * links train at the same time; fsl_pci_init() then only waits for what
+ * is left of the 100 ms a link is given.
+ */
+static struct fsl_pcie_reset {
+	unsigned long regs;
+	ulong start;
+} fsl_pcie_resets[4];
+
+static void fsl_pcie_reset_link(volatile ccsr_fsl_pci_t *pci)
+{
+	/* assert PCIe reset */
+	setbits_be32(&pci->pdb_stat, 0x08000000);
+	(void) in_be32(&pci->pdb_stat);
+	udelay(100);
+	debug("  Asserting PCIe reset @%p = %x\n",
+	      &pci->pdb_stat, in_be32(&pci->pdb_stat));
+	/* clear PCIe reset */
+	clrbits_be32(&pci->pdb_stat, 0x08000000);
+	asm("sync;isync");
+}
+
+/* When the link of the controller at regs was reset early, or NULL */
+static struct fsl_pcie_reset *fsl_pcie_find_reset(unsigned long regs)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fsl_pcie_resets); i++)
+		if (fsl_pcie_resets[i].regs == regs)
+			return &fsl_pcie_resets[i];
+	return NULL;
+}
+#endif
+
 /* Setup one inbound ATMU window.
  *
  * We let the caller decide what the window size should be
@@ -227,6 +264,9 @@ void fsl_pci_init(struct pci_controller *hose, struct fsl_pci_info *pci_info)
 	int enabled, r, inbound = 0;
 	u16 ltssm;
 	u8 temp8, pcie_cap;
+#ifdef CONFIG_FSL_PCIE_RESET
+	struct fsl_pcie_reset *reset;
+#endif
 	volatile ccsr_fsl_pci_t *pci = (ccsr_fsl_pci_t *)cfg_addr;
 	struct pci_region *reg = hose->regions + hose->region_count;
 	pci_dev_t dev = PCI_BDF(hose->first_busno, 0, 0);
@@ -337,19 +377,21 @@ void fsl_pci_init(struct pci_controller *hose, struct fsl_pci_info *pci_info)
 		enabled = ltssm >= PCI_LTSSM_L0;
 
 #ifdef CONFIG_FSL_PCIE_RESET
-		if (ltssm == 1) {
-			int i;
+		reset = fsl_pcie_find_reset(pci_info->regs);
+		if (reset)
+			reset->regs = 0;	/* once */
+		if (ltssm == 1 || (reset && ltssm < PCI_LTSSM_L0)) {
+			ulong start;
+
 			debug("....PCIe link error. " "LTSSM=0x%02x.", ltssm);
-			/* assert PCIe reset */
-			setbits_be32(&pci->pdb_stat, 0x08000000);
-			(void) in_be32(&pci->pdb_stat);
-			udelay(100);
-			debug("  Asserting PCIe reset @%p = %x\n",
-			      &pci->pdb_stat, in_be32(&pci->pdb_stat));
-			/* clear PCIe reset */
-			clrbits_be32(&pci->pdb_stat, 0x08000000);
-			asm("sync;isync");
-			for (i=0; i<100 && ltssm < PCI_LTSSM_L0; i++) {
+			if (reset) {
+				/* still training since fsl_pcie_init_board() */
+				start = reset->start;
+			} else {
+				fsl_pcie_reset_link(pci);
+				start = get_timer(0);
+			}
+			while (ltssm < PCI_LTSSM_L0 && get_timer(start) < 100) {
 				pci_hose_read_config_word(hose, dev, PCI_LTSSM,
 							&ltssm);
 				udelay(1000);
@@ -609,6 +651,38 @@ static u32 devdisr_mask[] = {
 	_DEVDISR_PCIE4,
 };
 
+#ifdef CONFIG_FSL_PCIE_RESET
+/* Reset the link of a controller that came up without one */
+static void fsl_pcie_start_link(u32 devdisr, enum srds_prtcl dev,
+				unsigned long regs)
+{
+	volatile ccsr_fsl_pci_t *pci = (ccsr_fsl_pci_t *)regs;
+	struct pci_controller hose;
+	pci_dev_t bdf = PCI_BDF(0, 0, 0);
+	int num = dev - PCIE1;
+	u8 pcie_cap;
+	u16 ltssm;
+
+	if (!is_serdes_configured(dev) || (devdisr & devdisr_mask[num]))
+		return;
+
+	memset(&hose, 0, sizeof(hose));
+	pci_setup_indirect(&hose, (u32)&pci->cfg_addr, (u32)&pci->cfg_data);
+
+	pci_hose_read_config_byte(&hose, bdf, FSL_PCIE_CAP_ID, &pcie_cap);
+	if (pcie_cap != PCI_CAP_ID_EXP)
+		return;
+
+	pci_hose_read_config_word(&hose, bdf, PCI_LTSSM, &ltssm);
+	if (ltssm != 1)
+		return;
+
+	fsl_pcie_reset_link(pci);
+	fsl_pcie_resets[num].regs = regs;
+	fsl_pcie_resets[num].start = get_timer(0);
+}
+#endif
+
 int fsl_pcie_init_ctrl(int busno, u32 devdisr, enum srds_prtcl dev,
 			struct fsl_pci_info *pci_info)
 {
@@ -635,6 +709,21 @@ int fsl_pcie_init_board(int busno)
 	ccsr_gur_t *gur = (void *)CONFIG_SYS_MPC8xxx_GUTS_ADDR;
 	u32 devdisr = in_be32(&gur->devdisr);
 
+#ifdef CONFIG_FSL_PCIE_RESET
+#ifdef CONFIG_PCIE1
+	fsl_pcie_start_link(devdisr, PCIE1, CONFIG_SYS_PCIE1_ADDR);
+#endif
+#ifdef CONFIG_PCIE2
+	fsl_pcie_start_link(devdisr, PCIE2, CONFIG_SYS_PCIE2_ADDR);
+#endif
+#ifdef CONFIG_PCIE3
+	fsl_pcie_start_link(devdisr, PCIE3, CONFIG_SYS_PCIE3_ADDR);
+#endif
+#ifdef CONFIG_PCIE4
+	fsl_pcie_start_link(devdisr, PCIE4, CONFIG_SYS_PCIE4_ADDR);
+#endif
+#endif
+
 #ifdef CONFIG_PCIE1
 	SET_STD_PCIE_INFO(pci_info, 1);
 	busno = fsl_pcie_init_ctrl(busno, devdisr, PCIE1, &pci_info);
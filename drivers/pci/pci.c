@@ -139,6 +139,48 @@ void *pci_map_bar(pci_dev_t pdev, int bar, int flags)
 
 static struct pci_controller* hose_head;
 
+#ifdef CONFIG_PCI_FIND_CACHE
+#ifndef CONFIG_SYS_PCI_FIND_CACHE_DEVICES
+#define CONFIG_SYS_PCI_FIND_CACHE_DEVICES	64
+#endif
+
+/*
+ * What pci_find_devices() saw on the last walk of the buses: drivers
+ * look their devices up one index after the other, each lookup used to
+ * read the configuration space of all buses again.
+ */
+static struct pci_found {
+	pci_dev_t bdf;
+	u16 vendor;
+	u16 device;
+} pci_found[CONFIG_SYS_PCI_FIND_CACHE_DEVICES];
+static int pci_found_count = -1;	/* -1: to be filled, -2: overflow */
+
+static void pci_find_cache_flush(void)
+{
+	pci_found_count = -1;
+}
+
+static int pci_find_cache_add(pci_dev_t bdf, u16 vendor, u16 device,
+			      void *priv)
+{
+	if (pci_found_count >= CONFIG_SYS_PCI_FIND_CACHE_DEVICES) {
+		pci_found_count = -2;
+		return 1;
+	}
+	pci_found[pci_found_count].bdf = bdf;
+	pci_found[pci_found_count].vendor = vendor;
+	pci_found[pci_found_count].device = device;
+	pci_found_count++;
+
+	return 0;
+}
+#else
+static inline void pci_find_cache_flush(void)
+{
+}
+#endif
+
 void pci_register_hose(struct pci_controller* hose)
 {
 	struct pci_controller **phose = &hose_head;
@@ -149,6 +191,7 @@ void pci_register_hose(struct pci_controller* hose)
 	hose->next = NULL;
 
 	*phose = hose;
+	pci_find_cache_flush();
 }
 
 struct pci_controller *pci_bus_to_hose (int bus)
@@ -188,13 +231,19 @@ int pci_last_busno(void)
 	return hose->last_busno;
 }
 
-pci_dev_t pci_find_devices(struct pci_device_id *ids, int index)
+/*
+ * Call fn() for every function present on the buses of all hoses, in the
+ * order pci_find_devices() returns them, until it returns non-zero.
+ */
+static pci_dev_t pci_walk_devices(int (*fn)(pci_dev_t bdf, u16 vendor,
+					    u16 device, void *priv),
+				  void *priv)
 {
 	struct pci_controller * hose;
 	u16 vendor, device;
 	u8 header_type;
 	pci_dev_t bdf;
-	int i, bus, found_multi = 0;
+	int bus, found_multi = 0;
 
 	for (hose = hose_head; hose; hose = hose->next)
 	{
@@ -211,39 +260,88 @@ pci_dev_t pci_find_devices(struct pci_device_id *ids, int index)
 #endif
 			     bdf += PCI_BDF(0,0,1))
 			{
+				if (PCI_FUNC(bdf) && !found_multi)
+					continue;
+
+				pci_read_config_word(bdf,
+						     PCI_VENDOR_ID,
+						     &vendor);
+
+				/* without function 0 there is no device */
+				if (vendor == 0xffff || vendor == 0x0000) {
+					if (!PCI_FUNC(bdf))
+						found_multi = 0;
+					continue;
+				}
+
 				if (!PCI_FUNC(bdf)) {
 					pci_read_config_byte(bdf,
 							     PCI_HEADER_TYPE,
 							     &header_type);
 
 					found_multi = header_type & 0x80;
-				} else {
-					if (!found_multi)
-						continue;
 				}
 
-				pci_read_config_word(bdf,
-						     PCI_VENDOR_ID,
-						     &vendor);
 				pci_read_config_word(bdf,
 						     PCI_DEVICE_ID,
 						     &device);
 
-				for (i=0; ids[i].vendor != 0; i++)
-					if (vendor == ids[i].vendor &&
-					    device == ids[i].device)
-					{
-						if (index <= 0)
-							return bdf;
-
-						index--;
-					}
+				if (fn(bdf, vendor, device, priv))
+					return bdf;
 			}
 	}
 
 	return (-1);
 }
 
+struct pci_find_ids {
+	struct pci_device_id *ids;
+	int index;
+};
+
+static int pci_find_ids(pci_dev_t bdf, u16 vendor, u16 device, void *priv)
+{
+	struct pci_find_ids *find = priv;
+	int i;
+
+	for (i=0; find->ids[i].vendor != 0; i++)
+		if (vendor == find->ids[i].vendor &&
+		    device == find->ids[i].device)
+		{
+			if (find->index <= 0)
+				return 1;
+
+			find->index--;
+		}
+
+	return 0;
+}
+
+pci_dev_t pci_find_devices(struct pci_device_id *ids, int index)
+{
+	struct pci_find_ids find = { ids, index };
+
+#ifdef CONFIG_PCI_FIND_CACHE
+	int i;
+
+	if (pci_found_count == -1) {
+		pci_found_count = 0;
+		pci_walk_devices(pci_find_cache_add, NULL);
+	}
+
+	/* Too many devices for the cache: walk the buses every time */
+	if (pci_found_count >= 0) {
+		for (i = 0; i < pci_found_count; i++)
+			if (pci_find_ids(pci_found[i].bdf, pci_found[i].vendor,
+					 pci_found[i].device, &find))
+				return pci_found[i].bdf;
+		return (-1);
+	}
+#endif
+
+	return pci_walk_devices(pci_find_ids, &find);
+}
+
 pci_dev_t pci_find_device(unsigned int vendor, unsigned int device, int index)
 {
 	static struct pci_device_id ids[2] = {{}, {0, 0}};
@@ -629,6 +727,7 @@ int pci_hose_scan_bus(struct pci_controller *hose, int bus)
 #endif
 
 	sub_bus = bus;
+	pci_find_cache_flush();
 
 	for (dev =  PCI_BDF(bus,0,0);
 	     dev <  PCI_BDF(bus,PCI_MAX_PCI_DEVICES-1,PCI_MAX_PCI_FUNCTIONS-1);
@@ -640,15 +739,20 @@ int pci_hose_scan_bus(struct pci_controller *hose, int bus)
 		if (PCI_FUNC(dev) && !found_multi)
 			continue;
 
-		pci_hose_read_config_byte(hose, dev, PCI_HEADER_TYPE, &header_type);
-
 		pci_hose_read_config_word(hose, dev, PCI_VENDOR_ID, &vendor);
 
-		if (vendor == 0xffff || vendor == 0x0000)
+		/* without function 0 there is no device */
+		if (vendor == 0xffff || vendor == 0x0000) {
+			if (!PCI_FUNC(dev))
+				found_multi = 0;
 			continue;
+		}
 
-		if (!PCI_FUNC(dev))
+		if (!PCI_FUNC(dev)) {
+			pci_hose_read_config_byte(hose, dev, PCI_HEADER_TYPE,
+						  &header_type);
 			found_multi = header_type & 0x80;
+		}
 
 		debug ("PCI Scan: Found Bus %d, Device %d, Function %d\n",
 			PCI_BUS(dev), PCI_DEV(dev), PCI_FUNC(dev) );
@@ -727,6 +831,7 @@ int pci_hose_scan(struct pci_controller *hose)
 void pci_init(void)
 {
 	hose_head = NULL;
+	pci_find_cache_flush();
 
 	/* now call board specific pci_init()... */
 	pci_init_board();
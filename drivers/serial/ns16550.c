@@ -4,7 +4,7 @@
  * modified to use CONFIG_SYS_ISA_MEM and new defines
  */
 
-#include <config.h>
+#include <common.h>
 #include <ns16550.h>
 #include <watchdog.h>
 #include <linux/types.h>
@@ -34,6 +34,125 @@
 #define CONFIG_SYS_NS16550_IER  0x00
 #endif /* CONFIG_SYS_NS16550_IER */
 
+#if defined(CONFIG_NS16550_TX_BUFFER) && !defined(CONFIG_NS16550_MIN_FUNCTIONS)
+/*
+ * Once relocated, characters go to a ring buffer for the port, which
+ * is written out a FIFO full at a time whenever the transmitter is
+ * empty: on every putc, while waiting for input and on NS16550_flush().
+ * The size must be a power of 2.
+ */
+#ifndef CONFIG_SYS_NS16550_TX_BUFSZ
+#define CONFIG_SYS_NS16550_TX_BUFSZ	1024
+#endif
+#ifndef CONFIG_SYS_NS16550_TX_FIFO
+#define CONFIG_SYS_NS16550_TX_FIFO	16
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+struct ns16550_tx {
+	NS16550_t	port;
+	unsigned int	head;		/* free running, masked on use */
+	unsigned int	tail;
+	char		buf[CONFIG_SYS_NS16550_TX_BUFSZ];
+};
+
+static struct ns16550_tx ns16550_tx[4];
+
+/* The buffer of com_port, a new one if add is set; NULL for none */
+static struct ns16550_tx *ns16550_tx_get(NS16550_t com_port, int add)
+{
+	struct ns16550_tx *tx, *unused = NULL;
+
+	/* no bss yet */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+
+	for (tx = ns16550_tx; tx < ns16550_tx + ARRAY_SIZE(ns16550_tx); tx++) {
+		if (tx->port == com_port)
+			return tx;
+		if (!tx->port && !unused)
+			unused = tx;
+	}
+	if (!add || !unused)
+		return NULL;
+
+	unused->port = com_port;
+	return unused;
+}
+
+static void ns16550_tx_drain(struct ns16550_tx *tx)
+{
+	int n;
+
+	if (tx->head == tx->tail ||
+	    (serial_in(&tx->port->lsr) & UART_LSR_THRE) == 0)
+		return;
+
+	/* with the FIFOs on, THRE means the whole transmit FIFO is empty */
+	for (n = 0; n < CONFIG_SYS_NS16550_TX_FIFO && tx->tail != tx->head; n++)
+		serial_out(tx->buf[tx->tail++ & (CONFIG_SYS_NS16550_TX_BUFSZ - 1)],
+			   &tx->port->thr);
+}
+
+static void ns16550_tx_put(struct ns16550_tx *tx, char c)
+{
+	while (tx->head - tx->tail >= CONFIG_SYS_NS16550_TX_BUFSZ)
+		ns16550_tx_drain(tx);
+
+	tx->buf[tx->head++ & (CONFIG_SYS_NS16550_TX_BUFSZ - 1)] = c;
+	ns16550_tx_drain(tx);
+}
+
+void NS16550_tx_poll(NS16550_t com_port)
+{
+	struct ns16550_tx *tx = ns16550_tx_get(com_port, 0);
+
+	if (tx)
+		ns16550_tx_drain(tx);
+}
+
+void NS16550_flush(NS16550_t com_port)
+{
+	struct ns16550_tx *tx = ns16550_tx_get(com_port, 0);
+
+	if (!tx)
+		return;
+
+	while (tx->head != tx->tail)
+		ns16550_tx_drain(tx);
+	while ((serial_in(&com_port->lsr) & UART_LSR_TEMT) == 0)
+		;
+}
+
+/*
+ * The same for every port that has a buffer, whichever serial code
+ * drives it: for the console loop, and before a reset, hang() or the
+ * OS takes over the UART.
+ */
+void serial_tx_poll(void)
+{
+	struct ns16550_tx *tx;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+	for (tx = ns16550_tx; tx < ns16550_tx + ARRAY_SIZE(ns16550_tx); tx++)
+		if (tx->port)
+			ns16550_tx_drain(tx);
+}
+
+void serial_flush(void)
+{
+	struct ns16550_tx *tx;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+	for (tx = ns16550_tx; tx < ns16550_tx + ARRAY_SIZE(ns16550_tx); tx++)
+		if (tx->port)
+			NS16550_flush(tx->port);
+}
+#endif /* CONFIG_NS16550_TX_BUFFER */
+
 void NS16550_init(NS16550_t com_port, int baud_divisor)
 {
 	serial_out(CONFIG_SYS_NS16550_IER, &com_port->ier);
@@ -67,6 +186,8 @@ void NS16550_init(NS16550_t com_port, int baud_divisor)
 #ifndef CONFIG_NS16550_MIN_FUNCTIONS
 void NS16550_reinit(NS16550_t com_port, int baud_divisor)
 {
+	/* what was printed at the old rate goes out at that rate */
+	NS16550_flush(com_port);
 	serial_out(CONFIG_SYS_NS16550_IER, &com_port->ier);
 	serial_out(UART_LCR_BKSE | UART_LCRVAL, &com_port->lcr);
 	serial_out(0, &com_port->dll);
@@ -83,9 +204,18 @@ void NS16550_reinit(NS16550_t com_port, int baud_divisor)
 
 void NS16550_putc(NS16550_t com_port, char c)
 {
-	while ((serial_in(&com_port->lsr) & UART_LSR_THRE) == 0)
-		;
-	serial_out(c, &com_port->thr);
+#if defined(CONFIG_NS16550_TX_BUFFER) && !defined(CONFIG_NS16550_MIN_FUNCTIONS)
+	struct ns16550_tx *tx = ns16550_tx_get(com_port, 1);
+
+	if (tx) {
+		ns16550_tx_put(tx, c);
+	} else
+#endif
+	{
+		while ((serial_in(&com_port->lsr) & UART_LSR_THRE) == 0)
+			;
+		serial_out(c, &com_port->thr);
+	}
 
 	/*
 	 * Call watchdog_reset() upon newline. This is done here in putc
@@ -101,6 +231,7 @@ void NS16550_putc(NS16550_t com_port, char c)
 char NS16550_getc(NS16550_t com_port)
 {
 	while ((serial_in(&com_port->lsr) & UART_LSR_DR) == 0) {
+		NS16550_tx_poll(com_port);
 #ifdef CONFIG_USB_TTY
 		extern void usbtty_poll(void);
 		usbtty_poll();
@@ -112,6 +243,7 @@ char NS16550_getc(NS16550_t com_port)
 
 int NS16550_tstc(NS16550_t com_port)
 {
+	NS16550_tx_poll(com_port);
 	return (serial_in(&com_port->lsr) & UART_LSR_DR) != 0;
 }
 
@@ -89,6 +89,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	altspi->slave.bus = bus;
 	altspi->slave.cs = cs;
+	altspi->slave.caps = 0;
 	altspi->base = altera_spi_base_list[bus];
 	debug("%s: bus:%i cs:%i base:%lx\n", __func__,
 		bus, cs, altspi->base);
@@ -126,6 +126,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	pss->slave.bus = bus;
 	pss->slave.cs = cs;
+	pss->slave.caps = 0;
 	pss->spi_reg = (struct ssp_reg *)SSP_REG_BASE(CONFIG_SYS_SSP_PORT);
 
 	pss->cr0 = SSCR0_MOTO | SSCR0_DATASIZE(DEFAULT_WORD_LEN) | SSCR0_SSE;
@@ -90,6 +90,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	as->slave.bus = bus;
 	as->slave.cs = cs;
+	as->slave.caps = 0;
 	as->regs = regs;
 	as->mr = ATMEL_SPI_MR_MSTR | ATMEL_SPI_MR_MODFDIS
 			| ATMEL_SPI_MR_PCS(~(1 << cs) & 0xf);
@@ -188,6 +188,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	bss->slave.bus = bus;
 	bss->slave.cs = cs;
+	bss->slave.caps = 0;
 	bss->mmr_base = (void *)mmr_base;
 	bss->ctl = SPE | MSTR | TDBR_CORE;
 	if (mode & SPI_CPHA) bss->ctl |= CPHA;
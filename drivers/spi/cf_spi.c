@@ -336,6 +336,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	cfslave->slave.bus = bus;
 	cfslave->slave.cs = cs;
+	cfslave->slave.caps = 0;
 	cfslave->baudrate = max_hz;
 
 	/* specific setup */
@@ -85,6 +85,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	fsl->slave.bus = bus;
 	fsl->slave.cs = cs;
+	fsl->slave.caps = 0;
 	fsl->mode = mode;
 	fsl->max_transfer_length = ESPI_MAX_DATA_TRANSFER_LEN;
 
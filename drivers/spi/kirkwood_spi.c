@@ -54,6 +54,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	slave->bus = bus;
 	slave->cs = cs;
+	slave->caps = 0;
 
 	writel(~KWSPI_CSN_ACT | KWSPI_SMEMRDY, &spireg->ctrl);
 
@@ -121,11 +122,39 @@ void spi_cs_deactivate(struct spi_slave *slave)
 	writel(readl(&spireg->ctrl) & KWSPI_IRQMASK, &spireg->ctrl);
 }
 
+/*
+ * Shift one 8 or 16 bit word out and in, 16 bit words MSB first.
+ * Returns the word read, or -1 on a time out.
+ */
+static int kw_spi_xfer_word(unsigned int xferlen, unsigned int tmpdout)
+{
+	int tm;
+
+	writel(((readl(&spireg->cfg) & ~KWSPI_XFERLEN_MASK) | xferlen),
+	       &spireg->cfg);
+
+	writel(~KWSPI_SMEMRDIRQ, &spireg->irq_cause);
+	writel(tmpdout, &spireg->dout);	/* Write the data out */
+
+	/*
+	 * Wait for SPI transmit to get out
+	 * or time out (1 second = 1000 ms)
+	 * The NE event must be read and cleared first
+	 */
+	for (tm = 0; tm < KWSPI_TIMEOUT; ++tm)
+		if (readl(&spireg->irq_cause) & KWSPI_SMEMRDIRQ)
+			return readl(&spireg->din) &
+				(xferlen == KWSPI_XFERLEN_2BYTE ? 0xffff : 0xff);
+
+	return -1;
+}
+
 int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 	     void *din, unsigned long flags)
 {
-	unsigned int tmpdout, tmpdin;
-	int tm, isread = 0;
+	const u8 *txp = dout;
+	u8 *rxp = din;
+	int tmpdin;
 
 	debug("spi_xfer: slave %u:%u dout %p din %p bitlen %u\n",
 	      slave->bus, slave->cs, dout, din, bitlen);
@@ -134,53 +163,37 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		spi_cs_activate(slave);
 
 	/*
-	 * handle data in 8-bit chunks
-	 * TBD: 2byte xfer mode to be enabled
+	 * Move the bulk of the data in 2-byte mode, which halves the
+	 * number of handshakes per byte; an odd byte goes on its own.
 	 */
-	writel(((readl(&spireg->cfg) & ~KWSPI_XFERLEN_MASK) |
-		KWSPI_XFERLEN_1BYTE), &spireg->cfg);
+	while (bitlen >= 16) {
+		tmpdin = kw_spi_xfer_word(KWSPI_XFERLEN_2BYTE,
+					  txp ? (txp[0] << 8) | txp[1] : 0);
+		if (tmpdin < 0) {
+			printf("*** spi_xfer: Time out during SPI transfer\n");
+			break;
+		}
+		if (rxp) {
+			*rxp++ = tmpdin >> 8;
+			*rxp++ = tmpdin;
+		}
+		if (txp)
+			txp += 2;
+		bitlen -= 16;
+	}
 
 	while (bitlen > 4) {
-		debug("loopstart bitlen %d\n", bitlen);
-		tmpdout = 0;
-
-		/* Shift data so it's msb-justified */
-		if (dout)
-			tmpdout = *(u32 *) dout & 0x0ff;
-
-		writel(~KWSPI_SMEMRDIRQ, &spireg->irq_cause);
-		writel(tmpdout, &spireg->dout);	/* Write the data out */
-		debug("*** spi_xfer: ... %08x written, bitlen %d\n",
-		      tmpdout, bitlen);
-
-		/*
-		 * Wait for SPI transmit to get out
-		 * or time out (1 second = 1000 ms)
-		 * The NE event must be read and cleared first
-		 */
-		for (tm = 0, isread = 0; tm < KWSPI_TIMEOUT; ++tm) {
-			if (readl(&spireg->irq_cause) & KWSPI_SMEMRDIRQ) {
-				isread = 1;
-				tmpdin = readl(&spireg->din);
-				debug
-					("spi_xfer: din %p..%08x read\n",
-					din, tmpdin);
-
-				if (din) {
-					*((u8 *) din) = (u8) tmpdin;
-					din += 1;
-				}
-				if (dout)
-					dout += 1;
-				bitlen -= 8;
-			}
-			if (isread)
-				break;
-		}
-		if (tm >= KWSPI_TIMEOUT)
+		tmpdin = kw_spi_xfer_word(KWSPI_XFERLEN_1BYTE,
+					  txp ? *txp : 0);
+		if (tmpdin < 0) {
 			printf("*** spi_xfer: Time out during SPI transfer\n");
-
-		debug("loopend bitlen %d\n", bitlen);
+			break;
+		}
+		if (rxp)
+			*rxp++ = tmpdin;
+		if (txp)
+			txp++;
+		bitlen -= 8;
 	}
 
 	if (flags & SPI_XFER_END)
@@ -54,6 +54,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	slave->bus = bus;
 	slave->cs = cs;
+	slave->caps = 0;
 
 	return slave;
 }
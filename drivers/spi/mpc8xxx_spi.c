@@ -51,6 +51,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	slave->bus = bus;
 	slave->cs = cs;
+	slave->caps = 0;
 
 	/*
 	 * TODO: Some of the code in spi_init() should probably move
@@ -505,6 +505,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	mxcs->slave.bus = bus;
 	mxcs->slave.cs = cs;
+	mxcs->slave.caps = 0;
 	mxcs->base = spi_bases[bus];
 	mxcs->ss_pol = (mode & SPI_CS_HIGH) ? 1 : 0;
 
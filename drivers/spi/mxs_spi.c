@@ -70,6 +70,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	mxs_slave->slave.bus = bus;
 	mxs_slave->slave.cs = cs;
+	mxs_slave->slave.caps = 0;
 	mxs_slave->max_khz = max_hz / 1000;
 	mxs_slave->mode = mode;
 	mxs_slave->regs = (struct mx28_ssp_regs *)addr;
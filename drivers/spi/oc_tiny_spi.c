@@ -97,6 +97,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	tiny_spi->slave.bus = bus;
 	tiny_spi->slave.cs = cs;
+	tiny_spi->slave.caps = 0;
 	tiny_spi->host = &tiny_spi_host_list[bus];
 	tiny_spi->mode = mode & (SPI_CPOL | SPI_CPHA);
 	tiny_spi->flg = mode & SPI_CS_HIGH ? 1 : 0;
@@ -40,6 +40,9 @@
 #define WORD_LEN	8
 #define SPI_WAIT_TIMEOUT 3000000;
 
+/* Reads at least this long go through the FIFO */
+#define OMAP3_SPI_FIFO_MIN	16
+
 static void spi_reset(struct omap3_spi_slave *ds)
 {
 	unsigned int tmp;
@@ -111,6 +114,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 		return NULL;
 	}
 	ds->slave.cs = cs;
+	ds->slave.caps = 0;
 
 	if (max_hz > OMAP3_MCSPI_MAX_FREQ) {
 		printf("SPI error: unsupported frequency %i Hz. \
@@ -297,6 +301,67 @@ int omap3_spi_read(struct spi_slave *slave, unsigned int len, u8 *rxp,
 	return 0;
 }
 
+/*
+ * Long reads, such as those of sf read, let the controller clock a
+ * counted run of words into its 64 byte FIFO on its own, instead of
+ * waiting for every byte to be read before clocking the next one.
+ */
+static int omap3_spi_read_fifo(struct spi_slave *slave, unsigned int len,
+			       u8 *rxp, unsigned long flags)
+{
+	struct omap3_spi_slave *ds = to_omap3_spi(slave);
+	struct mcspi_channel *chan = &ds->regs->channel[ds->slave.cs];
+	int chconf = readl(&chan->chconf);
+	unsigned int i, n;
+	int timeout;
+	int ret = 0;
+
+	chconf &= ~OMAP3_MCSPI_CHCONF_TRM_MASK;
+	chconf |= OMAP3_MCSPI_CHCONF_TRM_RX_ONLY | OMAP3_MCSPI_CHCONF_FORCE |
+		OMAP3_MCSPI_CHCONF_FFER;
+
+	while (len && !ret) {
+		n = min(len, OMAP3_MCSPI_XFERLEVEL_WCNT_MAX);
+
+		/* The FIFO and word count are only set up while disabled */
+		writel(0, &chan->chctrl);
+		writel(chconf, &chan->chconf);
+		writel(n << OMAP3_MCSPI_XFERLEVEL_WCNT_SHIFT,
+		       &ds->regs->xferlevel);
+		writel(OMAP3_MCSPI_CHCTRL_EN, &chan->chctrl);
+		writel(0, &chan->tx);
+
+		for (i = 0; i < n; i++) {
+			timeout = SPI_WAIT_TIMEOUT;
+			while (readl(&chan->chstat) & OMAP3_MCSPI_CHSTAT_RXFFE) {
+				if (--timeout <= 0) {
+					printf("SPI RXFFE timed out, "
+					       "status=0x%08x\n",
+					       readl(&chan->chstat));
+					ret = -1;
+					break;
+				}
+			}
+			if (ret)
+				break;
+			*rxp++ = readl(&chan->rx);
+		}
+		len -= n;
+	}
+
+	/* Hand the FIFO back, the other transfers do not use it */
+	writel(0, &chan->chctrl);
+	writel(0, &ds->regs->xferlevel);
+	chconf &= ~OMAP3_MCSPI_CHCONF_FFER;
+	if (flags & SPI_XFER_END)
+		chconf &= ~OMAP3_MCSPI_CHCONF_FORCE;
+	writel(chconf, &chan->chconf);
+	if (!(flags & SPI_XFER_END))
+		writel(OMAP3_MCSPI_CHCTRL_EN, &chan->chctrl);
+
+	return ret;
+}
+
 int spi_xfer(struct spi_slave *slave, unsigned int bitlen,
 	     const void *dout, void *din, unsigned long flags)
 {
@@ -332,7 +397,9 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen,
 		if (dout != NULL)
 			ret = omap3_spi_write(slave, len, txp, flags);
 
-		if (din != NULL)
+		if (din != NULL && dout == NULL && len >= OMAP3_SPI_FIFO_MIN)
+			ret = omap3_spi_read_fifo(slave, len, rxp, flags);
+		else if (din != NULL)
 			ret = omap3_spi_read(slave, len, rxp, flags);
 	}
 	return ret;
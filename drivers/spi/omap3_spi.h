@@ -59,6 +59,7 @@ struct mcspi {
 					/* channel1: 0x40 - 0x50, bus 0 & 1 */
 					/* channel2: 0x54 - 0x64, bus 0 & 1 */
 					/* channel3: 0x68 - 0x78, bus 0 */
+	unsigned int xferlevel;		/* 0x7C */
 };
 
 /* per-register bitmasks */
@@ -88,10 +89,16 @@ struct mcspi {
 #define OMAP3_MCSPI_CHCONF_IS		(1 << 18)
 #define OMAP3_MCSPI_CHCONF_TURBO	(1 << 19)
 #define OMAP3_MCSPI_CHCONF_FORCE	(1 << 20)
+#define OMAP3_MCSPI_CHCONF_FFEW		(1 << 27)
+#define OMAP3_MCSPI_CHCONF_FFER		(1 << 28)
 
 #define OMAP3_MCSPI_CHSTAT_RXS		(1 << 0)
 #define OMAP3_MCSPI_CHSTAT_TXS		(1 << 1)
 #define OMAP3_MCSPI_CHSTAT_EOT		(1 << 2)
+#define OMAP3_MCSPI_CHSTAT_RXFFE	(1 << 5)
+
+#define OMAP3_MCSPI_XFERLEVEL_WCNT_SHIFT	16
+#define OMAP3_MCSPI_XFERLEVEL_WCNT_MAX		0xffff
 
 #define OMAP3_MCSPI_CHCTRL_EN		(1 << 0)
 
@@ -96,6 +96,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	ss->slave.bus = bus;
 	ss->slave.cs = cs;
+	ss->slave.caps = 0;
 	ss->regs = (struct sh_spi_regs *)CONFIG_SH_SPI_BASE;
 
 	/* SPI sycle stop */
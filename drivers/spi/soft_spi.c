@@ -79,6 +79,7 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 
 	ss->slave.bus = bus;
 	ss->slave.cs = cs;
+	ss->slave.caps = 0;
 	ss->mode = mode;
 
 	/* TODO: Use max_hz to limit the SCK rate */
@@ -76,11 +76,35 @@
 	 AX_MEDIUM_AC | AX_MEDIUM_RE)
 
 /* AX88772 & AX88178 RX_CTL values */
+#define AX_RX_CTL_MFB_2048		0x0000
+#define AX_RX_CTL_MFB_4096		0x0100
+#define AX_RX_CTL_MFB_8192		0x0200
+#define AX_RX_CTL_MFB_16384		0x0300
 #define AX_RX_CTL_SO			0x0080
 #define AX_RX_CTL_AB			0x0008
 
+/*
+ * Frames are packed back to back into bursts of up to AX_RX_URB_SIZE
+ * bytes; one bulk-in transfer of that size picks up a whole burst.
+ */
+#ifndef CONFIG_SYS_USB_ASIX_RX_BURST
+#define CONFIG_SYS_USB_ASIX_RX_BURST	2048
+#endif
+
+#if CONFIG_SYS_USB_ASIX_RX_BURST == 16384
+#define AX_RX_CTL_MFB		AX_RX_CTL_MFB_16384
+#elif CONFIG_SYS_USB_ASIX_RX_BURST == 8192
+#define AX_RX_CTL_MFB		AX_RX_CTL_MFB_8192
+#elif CONFIG_SYS_USB_ASIX_RX_BURST == 4096
+#define AX_RX_CTL_MFB		AX_RX_CTL_MFB_4096
+#elif CONFIG_SYS_USB_ASIX_RX_BURST == 2048
+#define AX_RX_CTL_MFB		AX_RX_CTL_MFB_2048
+#else
+#error CONFIG_SYS_USB_ASIX_RX_BURST must be 2048, 4096, 8192 or 16384
+#endif
+
 #define AX_DEFAULT_RX_CTL	\
-	(AX_RX_CTL_SO | AX_RX_CTL_AB)
+	(AX_RX_CTL_SO | AX_RX_CTL_AB | AX_RX_CTL_MFB)
 
 /* GPIO 2 toggles */
 #define AX_GPIO_GPO2EN		0x10	/* GPIO2 Output enable */
@@ -94,12 +118,20 @@
 #define USB_BULK_SEND_TIMEOUT 5000
 #define USB_BULK_RECV_TIMEOUT 5000
 
-#define AX_RX_URB_SIZE 2048
+#define AX_RX_URB_SIZE CONFIG_SYS_USB_ASIX_RX_BURST
 #define PHY_CONNECT_TIMEOUT 5000
 
 /* local vars */
 static int curr_eth_dev; /* index for name of next device detected */
 
+/*
+ * The last burst received, and what is left of it to be handed up:
+ * frames beyond the budget of one call wait here for the next.
+ */
+static unsigned char recv_buf[AX_RX_URB_SIZE];
+static unsigned char *recv_ptr;
+static int recv_len, recv_left;
+
 /*
  * Asix infrastructure commands
  */
@@ -322,6 +354,8 @@ static int asix_init(struct eth_device *eth, bd_t *bd)
 
 	debug("** %s()\n", __func__);
 
+	recv_left = 0;
+
 	if (asix_write_gpio(dev,
 			AX_GPIO_RSE | AX_GPIO_GPO_2 | AX_GPIO_GPO2EN, 5) < 0)
 		goto out_err;
@@ -449,16 +483,10 @@ static int asix_send(struct eth_device *eth, volatile void *packet, int length)
 	return err;
 }
 
-static int asix_recv(struct eth_device *eth)
+static int asix_recv_burst(struct ueth_data *dev)
 {
-	struct ueth_data *dev = (struct ueth_data *)eth->priv;
-	static unsigned char  recv_buf[AX_RX_URB_SIZE];
-	unsigned char *buf_ptr;
 	int err;
 	int actual_len;
-	u32 packet_len;
-
-	debug("** %s()\n", __func__);
 
 	err = usb_bulk_msg(dev->pusb_dev,
 				usb_rcvbulkpipe(dev->pusb_dev, dev->ep_in),
@@ -477,41 +505,82 @@ static int asix_recv(struct eth_device *eth)
 		return -1;
 	}
 
-	buf_ptr = recv_buf;
-	while (actual_len > 0) {
-		/*
-		 * 1st 4 bytes contain the length of the actual data as two
-		 * complementary 16-bit words. Extract the length of the data.
-		 */
-		if (actual_len < sizeof(packet_len)) {
-			debug("Rx: incomplete packet length\n");
-			return -1;
-		}
-		memcpy(&packet_len, buf_ptr, sizeof(packet_len));
-		le32_to_cpus(&packet_len);
-		if (((packet_len >> 16) ^ 0xffff) != (packet_len & 0xffff)) {
-			debug("Rx: malformed packet length: %#x (%#x:%#x)\n",
-			      packet_len, (packet_len >> 16) ^ 0xffff,
-			      packet_len & 0xffff);
-			return -1;
-		}
-		packet_len = packet_len & 0xffff;
-		if (packet_len > actual_len - sizeof(packet_len)) {
-			debug("Rx: too large packet: %d\n", packet_len);
-			return -1;
-		}
+	recv_ptr = recv_buf;
+	recv_len = recv_left = actual_len;
+	return actual_len;
+}
+
+/* Hand up the next frame of the burst, -1 if it is malformed */
+static int asix_recv_frame(void)
+{
+	u32 packet_len;
+
+	/*
+	 * 1st 4 bytes contain the length of the actual data as two
+	 * complementary 16-bit words. Extract the length of the data.
+	 */
+	if (recv_left < sizeof(packet_len)) {
+		debug("Rx: incomplete packet length\n");
+		return -1;
+	}
+	memcpy(&packet_len, recv_ptr, sizeof(packet_len));
+	le32_to_cpus(&packet_len);
+	if (((packet_len >> 16) ^ 0xffff) != (packet_len & 0xffff)) {
+		debug("Rx: malformed packet length: %#x (%#x:%#x)\n",
+		      packet_len, (packet_len >> 16) ^ 0xffff,
+		      packet_len & 0xffff);
+		return -1;
+	}
+	packet_len = packet_len & 0xffff;
+	if (packet_len > recv_left - sizeof(packet_len)) {
+		debug("Rx: too large packet: %d\n", packet_len);
+		return -1;
+	}
+
+	/* Notify net stack */
+	NetReceive(recv_ptr + sizeof(packet_len), packet_len);
+
+	/* Adjust for next iteration. Packets are padded to 16-bits */
+	if (packet_len & 1)
+		packet_len++;
+	recv_left -= sizeof(packet_len) + packet_len;
+	recv_ptr += sizeof(packet_len) + packet_len;
+	return 0;
+}
+
+static int asix_recv_batch(struct eth_device *eth, int budget)
+{
+	struct ueth_data *dev = (struct ueth_data *)eth->priv;
+	int count = 0;
+	int len;
 
-		/* Notify net stack */
-		NetReceive(buf_ptr + sizeof(packet_len), packet_len);
+	debug("** %s()\n", __func__);
 
-		/* Adjust for next iteration. Packets are padded to 16-bits */
-		if (packet_len & 1)
-			packet_len++;
-		actual_len -= sizeof(packet_len) + packet_len;
-		buf_ptr += sizeof(packet_len) + packet_len;
+	while (count < budget) {
+		if (recv_left <= 0) {
+			/*
+			 * Only go back for more while the bursts come in
+			 * full, a short one means the chip had no more.
+			 */
+			if (count && recv_len < AX_RX_URB_SIZE)
+				break;
+			len = asix_recv_burst(dev);
+			if (len <= 0)
+				return count ? count : len;
+		}
+		if (asix_recv_frame() < 0) {
+			recv_left = 0;
+			return count ? count : -1;
+		}
+		count++;
 	}
 
-	return err;
+	return count;
+}
+
+static int asix_recv(struct eth_device *eth)
+{
+	return asix_recv_batch(eth, PKTBUFSRX) < 0 ? -1 : 0;
 }
 
 static void asix_halt(struct eth_device *eth)
@@ -628,6 +697,7 @@ int asix_eth_get_info(struct usb_device *dev, struct ueth_data *ss,
 	eth->init = asix_init;
 	eth->send = asix_send;
 	eth->recv = asix_recv;
+	eth->recv_batch = asix_recv_batch;
 	eth->halt = asix_halt;
 	eth->priv = ss;
 
@@ -116,3 +116,10 @@ int usb_gadget_config_buf(
 	cp->bmAttributes |= USB_CONFIG_ATT_ONE;
 	return len;
 }
+
+static int __board_usb_gadget_init(void)
+{
+	return 0;
+}
+int board_usb_gadget_init(void)
+	__attribute__((weak, alias("__board_usb_gadget_init")));
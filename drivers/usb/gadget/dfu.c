@@ -0,0 +1,641 @@
+/*
+ * dfu.c -- USB Device Firmware Upgrade gadget
+ *
+ * Every area of "dfu_alt_info" is an alternate setting of the one DFU
+ * interface.  The blocks of a download come in on ep0 and go straight
+ * into one of two buffers; once that is full, the writer takes it and
+ * writes it out a piece at a time from the poll loop, while the host
+ * goes on filling the other.  The host is only told to wait (dfuDNBUSY)
+ * when both are full, so USB reception overlaps with programming the
+ * flash.  FAT files are written whole, and may use all of the buffer.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <asm/errno.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/gadget.h>
+#include <usb/dfu.h>
+#include <dl_part.h>
+
+#ifndef CONFIG_USB_DFU_VENDOR_ID
+#define CONFIG_USB_DFU_VENDOR_ID	0x0525
+#endif
+#ifndef CONFIG_USB_DFU_PRODUCT_ID
+#define CONFIG_USB_DFU_PRODUCT_ID	0xa4a5
+#endif
+
+/* wTransferSize; the controller receives this much on ep0 at a time */
+#ifndef CONFIG_SYS_DFU_TRANSFER_SIZE
+#define CONFIG_SYS_DFU_TRANSFER_SIZE	4096
+#endif
+/* Each of the two buffers */
+#ifndef CONFIG_SYS_DFU_CHUNK_SIZE
+#define CONFIG_SYS_DFU_CHUNK_SIZE	(1 << 20)
+#endif
+#ifndef CONFIG_SYS_DFU_MAX_ALT
+#define CONFIG_SYS_DFU_MAX_ALT		8
+#endif
+
+/* Written between two polls of the controller */
+#define DFU_WRITE_PIECE		(64 << 10)
+
+#ifdef CONFIG_USB_GADGET_DUALSPEED
+#define DEVSPEED	USB_SPEED_HIGH
+#else
+#define DEVSPEED	USB_SPEED_FULL
+#endif
+
+#define USB_BUFSIZ		256
+
+#define STRING_MANUFACTURER	1
+#define STRING_PRODUCT		2
+#define STRING_SERIALNUMBER	3
+#define STRING_ALT		4	/* and on, one per area */
+
+#define DFU_CONFIG_VALUE	1
+
+#define USB_DT_DFU		0x21
+
+struct dfu_function_descriptor {
+	__u8	bLength;
+	__u8	bDescriptorType;
+	__u8	bmAttributes;
+	__le16	wDetachTimeOut;
+	__le16	wTransferSize;
+	__le16	bcdDFUVersion;
+} __attribute__ ((packed));
+
+#define DFU_CAN_DOWNLOAD	(1 << 0)
+#define DFU_MANIFEST_TOLERANT	(1 << 2)
+
+struct dfu_dev {
+	struct usb_gadget	*gadget;
+	struct usb_request	*req;		/* ep0 */
+	int			config;
+	int			alt;
+	int			n_alt;
+	int			detach;
+
+	enum dfu_state		state;
+	u8			status;
+
+	struct dl_part		part;		/* of the download */
+	int			opened;
+
+	u8			*bufs[2];
+	ulong			buf_size;	/* of both together */
+	ulong			chunk;		/* size of each buffer */
+	u8			*fill;		/* taking blocks from the host */
+	ulong			fill_len;
+	int			full;		/* fill waits for the writer */
+	u8			*write;		/* being written */
+	ulong			write_len, write_done;
+	int			finish;		/* host sent the last block */
+	int			done;		/* all written */
+	ulong			total;
+};
+
+static struct dfu_dev dfu_dev;
+static struct dl_part dfu_parts[CONFIG_SYS_DFU_MAX_ALT];
+
+static u8 control_req[USB_BUFSIZ] __attribute__((aligned(ARCH_DMA_MINALIGN)));
+
+static char serial_number[33] = "0";
+
+/*-------------------------------------------------------------------------*/
+
+static struct usb_device_descriptor device_desc = {
+	.bLength =		sizeof device_desc,
+	.bDescriptorType =	USB_DT_DEVICE,
+
+	.bcdUSB =		__constant_cpu_to_le16(0x0200),
+	.bDeviceClass =		0,	/* per interface */
+	.idVendor =	__constant_cpu_to_le16(CONFIG_USB_DFU_VENDOR_ID),
+	.idProduct =	__constant_cpu_to_le16(CONFIG_USB_DFU_PRODUCT_ID),
+	.bcdDevice =		__constant_cpu_to_le16(0x0100),
+	.iManufacturer =	STRING_MANUFACTURER,
+	.iProduct =		STRING_PRODUCT,
+	.iSerialNumber =	STRING_SERIALNUMBER,
+	.bNumConfigurations =	1,
+};
+
+static struct usb_qualifier_descriptor dev_qualifier = {
+	.bLength =		sizeof dev_qualifier,
+	.bDescriptorType =	USB_DT_DEVICE_QUALIFIER,
+
+	.bcdUSB =		__constant_cpu_to_le16(0x0200),
+	.bDeviceClass =		0,
+
+	.bNumConfigurations =	1,
+};
+
+static struct usb_config_descriptor dfu_config = {
+	.bLength =		sizeof dfu_config,
+	.bDescriptorType =	USB_DT_CONFIG,
+
+	/* compute wTotalLength on the fly */
+	.bNumInterfaces =	1,
+	.bConfigurationValue =	DFU_CONFIG_VALUE,
+	.iConfiguration =	0,
+	.bmAttributes =		USB_CONFIG_ATT_ONE | USB_CONFIG_ATT_SELFPOWER,
+	.bMaxPower =		1,
+};
+
+static struct dfu_function_descriptor dfu_func = {
+	.bLength =		sizeof dfu_func,
+	.bDescriptorType =	USB_DT_DFU,
+
+	.bmAttributes =		DFU_CAN_DOWNLOAD | DFU_MANIFEST_TOLERANT,
+	.wDetachTimeOut =	__constant_cpu_to_le16(0xff00),
+	.wTransferSize =	__constant_cpu_to_le16(CONFIG_SYS_DFU_TRANSFER_SIZE),
+	.bcdDFUVersion =	__constant_cpu_to_le16(0x0110),
+};
+
+/* one interface descriptor per alternate setting, then the DFU one */
+static struct usb_interface_descriptor dfu_intf[CONFIG_SYS_DFU_MAX_ALT];
+static const struct usb_descriptor_header *dfu_function[
+	CONFIG_SYS_DFU_MAX_ALT + 2];
+
+static struct usb_string strings[CONFIG_SYS_DFU_MAX_ALT + 4] = {
+	{ STRING_MANUFACTURER,	"U-Boot", },
+	{ STRING_PRODUCT,	"USB download gadget", },
+	{ STRING_SERIALNUMBER,	serial_number, },
+};
+
+static struct usb_gadget_strings stringtab = {
+	.language	= 0x0409,	/* en-us */
+	.strings	= strings,
+};
+
+/* Describe the areas of dfu_alt_info; the number of them */
+static int dfu_build_alts(void)
+{
+	char *list = getenv("dfu_alt_info");
+	int n;
+
+	for (n = 0; n < CONFIG_SYS_DFU_MAX_ALT; n++) {
+		struct usb_interface_descriptor *intf = &dfu_intf[n];
+
+		if (dl_part_get(list, n, &dfu_parts[n]))
+			break;
+
+		intf->bLength = sizeof(*intf);
+		intf->bDescriptorType = USB_DT_INTERFACE;
+		intf->bInterfaceNumber = 0;
+		intf->bAlternateSetting = n;
+		intf->bNumEndpoints = 0;
+		intf->bInterfaceClass = 0xfe;		/* application */
+		intf->bInterfaceSubClass = 0x01;	/* DFU */
+		intf->bInterfaceProtocol = 0x02;	/* DFU mode */
+		intf->iInterface = STRING_ALT + n;
+		dfu_function[n] = (struct usb_descriptor_header *) intf;
+
+		strings[STRING_ALT - 1 + n].id = STRING_ALT + n;
+		strings[STRING_ALT - 1 + n].s = dfu_parts[n].name;
+	}
+	dfu_function[n] = (struct usb_descriptor_header *) &dfu_func;
+	dfu_function[n + 1] = NULL;
+	strings[STRING_ALT - 1 + n].id = 0;
+	strings[STRING_ALT - 1 + n].s = NULL;
+
+	return n;
+}
+
+static int config_buf(struct usb_gadget *g, u8 *buf, u8 type, unsigned index)
+{
+	int len;
+
+	if (index > 0)
+		return -EINVAL;
+
+	len = usb_gadget_config_buf(&dfu_config, buf, USB_BUFSIZ,
+				    dfu_function);
+	if (len < 0)
+		return len;
+	((struct usb_config_descriptor *) buf)->bDescriptorType = type;
+	return len;
+}
+
+/*-------------------------------------------------------------------------*/
+
+/* Drop the download in progress, if any */
+static void dfu_abort(struct dfu_dev *dev)
+{
+	if (dev->opened)
+		dl_part_close(&dev->part);
+	dev->opened = 0;
+
+	dev->fill = dev->bufs[0];
+	dev->fill_len = 0;
+	dev->full = 0;
+	dev->write = NULL;
+	dev->write_len = 0;
+	dev->write_done = 0;
+	dev->finish = 0;
+	dev->done = 0;
+	dev->total = 0;
+}
+
+static void dfu_error(struct dfu_dev *dev, u8 status)
+{
+	dev->state = DFU_STATE_dfuERROR;
+	dev->status = status;
+}
+
+static void dfu_dnload_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	struct dfu_dev *dev = &dfu_dev;
+
+	if (req->status)
+		return;
+
+	dev->fill_len += req->actual;
+	dev->total += req->actual;
+
+	/* no room for another block: over to the writer */
+	if (dl_part_streams(&dev->part) &&
+	    dev->fill_len + CONFIG_SYS_DFU_TRANSFER_SIZE > dev->chunk)
+		dev->full = 1;
+}
+
+static void dfu_setup_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	if (req->status || req->actual != req->length)
+		debug("setup complete --> %d, %d/%d\n",
+		      req->status, req->actual, req->length);
+}
+
+/* The next state for GETSTATUS, and how long the host is to wait */
+static int dfu_poll_state(struct dfu_dev *dev)
+{
+	switch (dev->state) {
+	case DFU_STATE_dfuDNLOAD_SYNC:
+	case DFU_STATE_dfuDNBUSY:
+		if (!dev->full) {
+			dev->state = DFU_STATE_dfuDNLOAD_IDLE;
+			return 0;
+		}
+		dev->state = DFU_STATE_dfuDNBUSY;
+		return 5;
+	case DFU_STATE_dfuMANIFEST_SYNC:
+	case DFU_STATE_dfuMANIFEST:
+		if (dev->done) {
+			dev->state = DFU_STATE_dfuIDLE;
+			return 0;
+		}
+		dev->state = DFU_STATE_dfuMANIFEST;
+		return 20;
+	default:
+		return 0;
+	}
+}
+
+static int dfu_class_setup(struct dfu_dev *dev,
+			   const struct usb_ctrlrequest *ctrl)
+{
+	struct usb_request *req = dev->req;
+	u16 wLength = le16_to_cpu(ctrl->wLength);
+	u8 *buf = req->buf;
+	int poll;
+
+	switch (ctrl->bRequest) {
+	case DFU_DNLOAD:
+		if (dev->state == DFU_STATE_dfuIDLE && wLength) {
+			dfu_abort(dev);
+			dev->part = dfu_parts[dev->alt];
+			/* a FAT file has to fit into the whole buffer */
+			dev->chunk = dl_part_streams(&dev->part) ?
+				CONFIG_SYS_DFU_CHUNK_SIZE : dev->buf_size;
+		} else if (dev->state != DFU_STATE_dfuDNLOAD_IDLE) {
+			dfu_error(dev, DFU_STATUS_errSTALLEDPKT);
+			return -EINVAL;
+		}
+
+		if (!wLength) {
+			/* that was all of it */
+			dev->finish = 1;
+			dev->state = DFU_STATE_dfuMANIFEST_SYNC;
+			return 0;
+		}
+		if (wLength > CONFIG_SYS_DFU_TRANSFER_SIZE || dev->full ||
+		    dev->fill_len + wLength > dev->chunk) {
+			dfu_error(dev, DFU_STATUS_errADDRESS);
+			return -EINVAL;
+		}
+
+		/* the block goes straight into the buffer */
+		req->buf = dev->fill + dev->fill_len;
+		req->complete = dfu_dnload_complete;
+		dev->state = DFU_STATE_dfuDNLOAD_SYNC;
+		return wLength;
+
+	case DFU_GETSTATUS:
+		poll = dfu_poll_state(dev);
+		buf[0] = dev->status;
+		buf[1] = poll & 0xff;
+		buf[2] = (poll >> 8) & 0xff;
+		buf[3] = (poll >> 16) & 0xff;
+		buf[4] = dev->state;
+		buf[5] = 0;
+		return min(wLength, (u16) 6);
+
+	case DFU_GETSTATE:
+		buf[0] = dev->state;
+		return min(wLength, (u16) 1);
+
+	case DFU_CLRSTATUS:
+		if (dev->state != DFU_STATE_dfuERROR)
+			return -EINVAL;
+		/* FALLTHROUGH */
+	case DFU_ABORT:
+		dfu_abort(dev);
+		dev->state = DFU_STATE_dfuIDLE;
+		dev->status = DFU_STATUS_OK;
+		return 0;
+
+	case DFU_DETACH:
+		dev->detach = 1;
+		return 0;
+	}
+
+	/* no UPLOAD */
+	return -EOPNOTSUPP;
+}
+
+static int
+dfu_setup(struct usb_gadget *gadget, const struct usb_ctrlrequest *ctrl)
+{
+	struct dfu_dev		*dev = get_gadget_data(gadget);
+	struct usb_request	*req = dev->req;
+	int			value = -EOPNOTSUPP;
+	u16			wValue = le16_to_cpu(ctrl->wValue);
+	u16			wLength = le16_to_cpu(ctrl->wLength);
+
+	req->buf = control_req;
+	req->complete = dfu_setup_complete;
+
+	if ((ctrl->bRequestType & USB_TYPE_MASK) == USB_TYPE_CLASS) {
+		if (dev->config)
+			value = dfu_class_setup(dev, ctrl);
+		goto done;
+	}
+
+	switch (ctrl->bRequest) {
+
+	case USB_REQ_GET_DESCRIPTOR:
+		if (ctrl->bRequestType != USB_DIR_IN)
+			break;
+		switch (wValue >> 8) {
+
+		case USB_DT_DEVICE:
+			value = min(wLength, (u16) sizeof device_desc);
+			memcpy(req->buf, &device_desc, value);
+			break;
+		case USB_DT_DEVICE_QUALIFIER:
+			if (!gadget_is_dualspeed(gadget))
+				break;
+			value = min(wLength, (u16) sizeof dev_qualifier);
+			memcpy(req->buf, &dev_qualifier, value);
+			break;
+
+		case USB_DT_OTHER_SPEED_CONFIG:
+			if (!gadget_is_dualspeed(gadget))
+				break;
+			/* FALLTHROUGH */
+		case USB_DT_CONFIG:
+			value = config_buf(gadget, req->buf, wValue >> 8,
+					   wValue & 0xff);
+			if (value >= 0)
+				value = min(wLength, (u16) value);
+			break;
+
+		case USB_DT_STRING:
+			value = usb_gadget_get_string(&stringtab,
+					wValue & 0xff, req->buf);
+			if (value >= 0)
+				value = min(wLength, (u16) value);
+			break;
+		}
+		break;
+
+	case USB_REQ_SET_CONFIGURATION:
+		if (ctrl->bRequestType != 0)
+			break;
+		if (wValue != 0 && wValue != DFU_CONFIG_VALUE)
+			break;
+		dfu_abort(dev);
+		dev->config = wValue;
+		dev->alt = 0;
+		dev->state = DFU_STATE_dfuIDLE;
+		dev->status = DFU_STATUS_OK;
+		value = 0;
+		break;
+	case USB_REQ_GET_CONFIGURATION:
+		if (ctrl->bRequestType != USB_DIR_IN)
+			break;
+		*(u8 *)req->buf = dev->config;
+		value = min(wLength, (u16) 1);
+		break;
+
+	case USB_REQ_SET_INTERFACE:
+		if (ctrl->bRequestType != USB_RECIP_INTERFACE || !dev->config
+				|| wValue >= dev->n_alt)
+			break;
+		dfu_abort(dev);
+		dev->alt = wValue;
+		dev->state = DFU_STATE_dfuIDLE;
+		dev->status = DFU_STATUS_OK;
+		value = 0;
+		break;
+	case USB_REQ_GET_INTERFACE:
+		if (ctrl->bRequestType != (USB_DIR_IN|USB_RECIP_INTERFACE)
+				|| !dev->config)
+			break;
+		*(u8 *)req->buf = dev->alt;
+		value = min(wLength, (u16) 1);
+		break;
+
+	default:
+		debug("unknown control req%02x.%02x v%04x l%d\n",
+		      ctrl->bRequestType, ctrl->bRequest, wValue, wLength);
+	}
+
+done:
+	/* respond with data transfer before status phase? */
+	if (value >= 0) {
+		req->length = value;
+		req->zero = value < wLength
+				&& (value % gadget->ep0->maxpacket) == 0;
+		value = usb_ep_queue(gadget->ep0, req, 0);
+		if (value < 0) {
+			debug("ep_queue --> %d\n", value);
+			req->status = 0;
+			dfu_setup_complete(gadget->ep0, req);
+		}
+	}
+
+	/* host either stalls (value < 0) or reports success */
+	return value;
+}
+
+static void dfu_disconnect(struct usb_gadget *gadget)
+{
+	struct dfu_dev *dev = get_gadget_data(gadget);
+
+	dfu_abort(dev);
+	dev->config = 0;
+}
+
+static void dfu_unbind(struct usb_gadget *gadget)
+{
+	struct dfu_dev *dev = get_gadget_data(gadget);
+
+	if (dev->req) {
+		usb_ep_free_request(gadget->ep0, dev->req);
+		dev->req = NULL;
+	}
+	set_gadget_data(gadget, NULL);
+}
+
+static int dfu_bind(struct usb_gadget *gadget)
+{
+	struct dfu_dev *dev = &dfu_dev;
+	char *s;
+
+	s = getenv("serial#");
+	if (s)
+		strncpy(serial_number, s, sizeof(serial_number) - 1);
+
+	device_desc.bMaxPacketSize0 = gadget->ep0->maxpacket;
+	dev_qualifier.bMaxPacketSize0 = gadget->ep0->maxpacket;
+
+	dev->req = usb_ep_alloc_request(gadget->ep0, 0);
+	if (!dev->req)
+		return -ENOMEM;
+	dev->req->buf = control_req;
+	dev->req->complete = dfu_setup_complete;
+
+	dev->gadget = gadget;
+	set_gadget_data(gadget, dev);
+	gadget->ep0->driver_data = dev;
+
+	debug("dfu: using %s, %d areas\n", gadget->name, dev->n_alt);
+	return 0;
+}
+
+static struct usb_gadget_driver dfu_driver = {
+	.speed		= DEVSPEED,
+
+	.bind		= dfu_bind,
+	.unbind		= dfu_unbind,
+
+	.setup		= dfu_setup,
+	.disconnect	= dfu_disconnect,
+};
+
+/*-------------------------------------------------------------------------*/
+
+/* Move the writing on by a piece, or hand it the next buffer */
+static void dfu_write_step(struct dfu_dev *dev)
+{
+	ulong n;
+
+	if (dev->state == DFU_STATE_dfuERROR || dev->done)
+		return;
+
+	if (dev->write_done < dev->write_len) {
+		if (!dev->opened) {
+			if (dl_part_open(&dev->part)) {
+				dfu_error(dev, DFU_STATUS_errWRITE);
+				return;
+			}
+			dev->opened = 1;
+		}
+
+		n = dev->write_len - dev->write_done;
+		if (dl_part_streams(&dev->part) && n > DFU_WRITE_PIECE)
+			n = DFU_WRITE_PIECE;
+		if (dl_part_write(&dev->part, dev->write + dev->write_done, n)) {
+			dfu_error(dev, DFU_STATUS_errWRITE);
+			return;
+		}
+		dev->write_done += n;
+		return;
+	}
+
+	/* the writer is idle */
+	if (dev->full || (dev->finish && dev->fill_len)) {
+		dev->write = dev->fill;
+		dev->write_len = dev->fill_len;
+		dev->write_done = 0;
+
+		dev->fill = dev->fill == dev->bufs[0] ? dev->bufs[1]
+						      : dev->bufs[0];
+		dev->fill_len = 0;
+		dev->full = 0;
+		return;
+	}
+
+	if (dev->finish) {
+		if (dev->opened && dl_part_close(&dev->part)) {
+			dev->opened = 0;
+			dfu_error(dev, DFU_STATUS_errWRITE);
+			return;
+		}
+		dev->opened = 0;
+		dev->done = 1;
+		printf("dfu: %lu bytes written to %s\n", dev->total,
+		       dev->part.name);
+	}
+}
+
+int dfu_run(void *buf, ulong size)
+{
+	struct dfu_dev *dev = &dfu_dev;
+
+	memset(dev, 0, sizeof(*dev));
+
+	if (size < 2 * CONFIG_SYS_DFU_CHUNK_SIZE) {
+		printf("dfu: buffer must be at least %d KiB\n",
+		       2 * CONFIG_SYS_DFU_CHUNK_SIZE >> 10);
+		return -1;
+	}
+	dev->bufs[0] = buf;
+	dev->bufs[1] = buf + CONFIG_SYS_DFU_CHUNK_SIZE;
+	dev->buf_size = size;
+
+	dev->n_alt = dfu_build_alts();
+	if (!dev->n_alt) {
+		puts("dfu: no areas in \"dfu_alt_info\"\n");
+		return -1;
+	}
+	dfu_abort(dev);
+	dev->state = DFU_STATE_dfuIDLE;
+
+	if (board_usb_gadget_init())
+		return -1;
+	if (usb_gadget_register_driver(&dfu_driver) < 0)
+		return -1;
+	usb_gadget_connect(dev->gadget);
+
+	while (!dev->detach) {
+		if (ctrlc())
+			break;
+		usb_gadget_handle_interrupts();
+		dfu_write_step(dev);
+	}
+
+	/* a detach in the middle of a download */
+	if (dev->opened)
+		dl_part_close(&dev->part);
+	dev->opened = 0;
+
+	usb_gadget_disconnect(dev->gadget);
+	usb_gadget_unregister_driver(&dfu_driver);
+	return 0;
+}
@@ -0,0 +1,687 @@
+/*
+ * fastboot.c -- USB download gadget speaking the fastboot protocol
+ *
+ * The host sends commands of up to 64 bytes on the bulk OUT endpoint
+ * and gets "OKAY", "FAIL", "INFO" or "DATA" replies on bulk IN.  After
+ * "download:<size>" the image comes in on the OUT endpoint, and the
+ * requests point straight into the download buffer, so the controller
+ * DMAs the data where it has to go without a copy through the ep0 or
+ * bounce buffers.  "flash:<name>" then writes the buffer to one of the
+ * areas listed in "fastboot_partitions".
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <asm/errno.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/gadget.h>
+#include <usb/fastboot.h>
+#include <dl_part.h>
+#include <version.h>
+
+#ifndef CONFIG_USB_FASTBOOT_VENDOR_ID
+#define CONFIG_USB_FASTBOOT_VENDOR_ID	0x18d1
+#endif
+#ifndef CONFIG_USB_FASTBOOT_PRODUCT_ID
+#define CONFIG_USB_FASTBOOT_PRODUCT_ID	0x0d02
+#endif
+
+/* Data is received this much at a time, a multiple of 512 */
+#ifndef CONFIG_USB_FASTBOOT_REQ_SIZE
+#define CONFIG_USB_FASTBOOT_REQ_SIZE	(16 << 10)
+#endif
+
+#ifdef CONFIG_USB_GADGET_DUALSPEED
+#define DEVSPEED	USB_SPEED_HIGH
+#else
+#define DEVSPEED	USB_SPEED_FULL
+#endif
+
+#define FASTBOOT_CMD_LEN	64
+#define FASTBOOT_EP_BUFSIZ	512
+#define USB_BUFSIZ		256
+
+#define STRING_MANUFACTURER	1
+#define STRING_PRODUCT		2
+#define STRING_SERIALNUMBER	3
+#define STRING_INTERFACE	4
+
+#define FASTBOOT_CONFIG_VALUE	1
+
+struct fastboot_dev {
+	struct usb_gadget	*gadget;
+	struct usb_request	*req;		/* ep0 */
+	struct usb_ep		*in_ep, *out_ep;
+	struct usb_request	*in_req, *out_req;
+	int			config;
+
+	int			rx_busy;	/* out_req is queued */
+	int			rx_done;	/* out_req came back */
+	int			tx_busy;
+
+	u8			*buf;		/* download buffer */
+	ulong			buf_size;
+	ulong			dl_size;	/* size of the download */
+	ulong			dl_done;	/* bytes of it received */
+	int			downloading;
+	ulong			last_size;	/* of the last complete one */
+
+	enum fastboot_action	action;
+};
+
+static struct fastboot_dev fb_dev;
+static struct usb_gadget_driver fastboot_driver;
+
+static u8 control_req[USB_BUFSIZ] __attribute__((aligned(ARCH_DMA_MINALIGN)));
+static char cmd_buf[FASTBOOT_EP_BUFSIZ]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
+static char resp_buf[FASTBOOT_EP_BUFSIZ]
+	__attribute__((aligned(ARCH_DMA_MINALIGN)));
+
+static char serial_number[33] = "0";
+
+/*-------------------------------------------------------------------------*/
+
+static struct usb_device_descriptor device_desc = {
+	.bLength =		sizeof device_desc,
+	.bDescriptorType =	USB_DT_DEVICE,
+
+	.bcdUSB =		__constant_cpu_to_le16(0x0200),
+	.bDeviceClass =		0,	/* per interface */
+	.idVendor =	__constant_cpu_to_le16(CONFIG_USB_FASTBOOT_VENDOR_ID),
+	.idProduct =	__constant_cpu_to_le16(CONFIG_USB_FASTBOOT_PRODUCT_ID),
+	.bcdDevice =		__constant_cpu_to_le16(0x0100),
+	.iManufacturer =	STRING_MANUFACTURER,
+	.iProduct =		STRING_PRODUCT,
+	.iSerialNumber =	STRING_SERIALNUMBER,
+	.bNumConfigurations =	1,
+};
+
+static struct usb_qualifier_descriptor dev_qualifier = {
+	.bLength =		sizeof dev_qualifier,
+	.bDescriptorType =	USB_DT_DEVICE_QUALIFIER,
+
+	.bcdUSB =		__constant_cpu_to_le16(0x0200),
+	.bDeviceClass =		0,
+
+	.bNumConfigurations =	1,
+};
+
+static struct usb_config_descriptor fastboot_config = {
+	.bLength =		sizeof fastboot_config,
+	.bDescriptorType =	USB_DT_CONFIG,
+
+	/* compute wTotalLength on the fly */
+	.bNumInterfaces =	1,
+	.bConfigurationValue =	FASTBOOT_CONFIG_VALUE,
+	.iConfiguration =	0,
+	.bmAttributes =		USB_CONFIG_ATT_ONE | USB_CONFIG_ATT_SELFPOWER,
+	.bMaxPower =		1,
+};
+
+/* what the fastboot host tool looks for */
+static struct usb_interface_descriptor fastboot_intf = {
+	.bLength =		sizeof fastboot_intf,
+	.bDescriptorType =	USB_DT_INTERFACE,
+
+	.bInterfaceNumber =	0,
+	.bNumEndpoints =	2,
+	.bInterfaceClass =	USB_CLASS_VENDOR_SPEC,
+	.bInterfaceSubClass =	0x42,
+	.bInterfaceProtocol =	0x03,
+	.iInterface =		STRING_INTERFACE,
+};
+
+static struct usb_endpoint_descriptor fs_source_desc = {
+	.bLength =		USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType =	USB_DT_ENDPOINT,
+
+	.bEndpointAddress =	USB_DIR_IN,
+	.bmAttributes =		USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize =	__constant_cpu_to_le16(64),
+};
+
+static struct usb_endpoint_descriptor fs_sink_desc = {
+	.bLength =		USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType =	USB_DT_ENDPOINT,
+
+	.bEndpointAddress =	USB_DIR_OUT,
+	.bmAttributes =		USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize =	__constant_cpu_to_le16(64),
+};
+
+static struct usb_endpoint_descriptor hs_source_desc = {
+	.bLength =		USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType =	USB_DT_ENDPOINT,
+
+	.bmAttributes =		USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize =	__constant_cpu_to_le16(512),
+};
+
+static struct usb_endpoint_descriptor hs_sink_desc = {
+	.bLength =		USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType =	USB_DT_ENDPOINT,
+
+	.bmAttributes =		USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize =	__constant_cpu_to_le16(512),
+};
+
+static const struct usb_descriptor_header *fs_fastboot_function[] = {
+	(struct usb_descriptor_header *) &fastboot_intf,
+	(struct usb_descriptor_header *) &fs_source_desc,
+	(struct usb_descriptor_header *) &fs_sink_desc,
+	NULL,
+};
+
+static const struct usb_descriptor_header *hs_fastboot_function[] = {
+	(struct usb_descriptor_header *) &fastboot_intf,
+	(struct usb_descriptor_header *) &hs_source_desc,
+	(struct usb_descriptor_header *) &hs_sink_desc,
+	NULL,
+};
+
+static struct usb_string strings[] = {
+	{ STRING_MANUFACTURER,	"U-Boot", },
+	{ STRING_PRODUCT,	"USB download gadget", },
+	{ STRING_SERIALNUMBER,	serial_number, },
+	{ STRING_INTERFACE,	"fastboot", },
+	{  }		/* end of list */
+};
+
+static struct usb_gadget_strings stringtab = {
+	.language	= 0x0409,	/* en-us */
+	.strings	= strings,
+};
+
+static int config_buf(struct usb_gadget *g, u8 *buf, u8 type, unsigned index)
+{
+	const struct usb_descriptor_header **function = fs_fastboot_function;
+	int len;
+
+	if (index > 0)
+		return -EINVAL;
+
+	if (gadget_is_dualspeed(g)) {
+		int hs = (g->speed == USB_SPEED_HIGH);
+
+		if (type == USB_DT_OTHER_SPEED_CONFIG)
+			hs = !hs;
+		if (hs)
+			function = hs_fastboot_function;
+	}
+
+	len = usb_gadget_config_buf(&fastboot_config, buf, USB_BUFSIZ,
+				    function);
+	if (len < 0)
+		return len;
+	((struct usb_config_descriptor *) buf)->bDescriptorType = type;
+	return len;
+}
+
+/*-------------------------------------------------------------------------*/
+
+static void fastboot_rx_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	struct fastboot_dev *dev = &fb_dev;
+
+	dev->rx_busy = 0;
+	if (req->status == 0)
+		dev->rx_done = 1;
+}
+
+static void fastboot_tx_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	fb_dev.tx_busy = 0;
+}
+
+static void fastboot_reset_config(struct fastboot_dev *dev)
+{
+	if (!dev->config)
+		return;
+
+	usb_ep_disable(dev->in_ep);
+	usb_ep_disable(dev->out_ep);
+	if (dev->in_req) {
+		usb_ep_free_request(dev->in_ep, dev->in_req);
+		dev->in_req = NULL;
+	}
+	if (dev->out_req) {
+		usb_ep_free_request(dev->out_ep, dev->out_req);
+		dev->out_req = NULL;
+	}
+
+	dev->rx_busy = 0;
+	dev->rx_done = 0;
+	dev->tx_busy = 0;
+	dev->downloading = 0;
+	dev->config = 0;
+}
+
+static int fastboot_set_config(struct fastboot_dev *dev, unsigned number)
+{
+	struct usb_gadget *gadget = dev->gadget;
+	int hs = gadget_is_dualspeed(gadget) && gadget->speed == USB_SPEED_HIGH;
+	int result;
+
+	fastboot_reset_config(dev);
+	if (number == 0)
+		return 0;
+	if (number != FASTBOOT_CONFIG_VALUE)
+		return -EINVAL;
+
+	result = usb_ep_enable(dev->in_ep, hs ? &hs_source_desc
+					      : &fs_source_desc);
+	if (result)
+		return result;
+	result = usb_ep_enable(dev->out_ep, hs ? &hs_sink_desc
+					       : &fs_sink_desc);
+	if (result) {
+		usb_ep_disable(dev->in_ep);
+		return result;
+	}
+
+	dev->in_req = usb_ep_alloc_request(dev->in_ep, 0);
+	dev->out_req = usb_ep_alloc_request(dev->out_ep, 0);
+	if (!dev->in_req || !dev->out_req) {
+		dev->config = number;
+		fastboot_reset_config(dev);
+		return -ENOMEM;
+	}
+	dev->in_req->buf = resp_buf;
+	dev->in_req->complete = fastboot_tx_complete;
+	dev->out_req->complete = fastboot_rx_complete;
+
+	dev->config = number;
+	debug("fastboot: %s speed config #%d\n", hs ? "high" : "full", number);
+	return 0;
+}
+
+static void fastboot_setup_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	if (req->status || req->actual != req->length)
+		debug("setup complete --> %d, %d/%d\n",
+		      req->status, req->actual, req->length);
+}
+
+static int
+fastboot_setup(struct usb_gadget *gadget, const struct usb_ctrlrequest *ctrl)
+{
+	struct fastboot_dev	*dev = get_gadget_data(gadget);
+	struct usb_request	*req = dev->req;
+	int			value = -EOPNOTSUPP;
+	u16			wValue = le16_to_cpu(ctrl->wValue);
+	u16			wLength = le16_to_cpu(ctrl->wLength);
+
+	req->complete = fastboot_setup_complete;
+	switch (ctrl->bRequest) {
+
+	case USB_REQ_GET_DESCRIPTOR:
+		if (ctrl->bRequestType != USB_DIR_IN)
+			break;
+		switch (wValue >> 8) {
+
+		case USB_DT_DEVICE:
+			value = min(wLength, (u16) sizeof device_desc);
+			memcpy(req->buf, &device_desc, value);
+			break;
+		case USB_DT_DEVICE_QUALIFIER:
+			if (!gadget_is_dualspeed(gadget))
+				break;
+			value = min(wLength, (u16) sizeof dev_qualifier);
+			memcpy(req->buf, &dev_qualifier, value);
+			break;
+
+		case USB_DT_OTHER_SPEED_CONFIG:
+			if (!gadget_is_dualspeed(gadget))
+				break;
+			/* FALLTHROUGH */
+		case USB_DT_CONFIG:
+			value = config_buf(gadget, req->buf, wValue >> 8,
+					   wValue & 0xff);
+			if (value >= 0)
+				value = min(wLength, (u16) value);
+			break;
+
+		case USB_DT_STRING:
+			value = usb_gadget_get_string(&stringtab,
+					wValue & 0xff, req->buf);
+			if (value >= 0)
+				value = min(wLength, (u16) value);
+			break;
+		}
+		break;
+
+	case USB_REQ_SET_CONFIGURATION:
+		if (ctrl->bRequestType != 0)
+			break;
+		value = fastboot_set_config(dev, wValue);
+		break;
+	case USB_REQ_GET_CONFIGURATION:
+		if (ctrl->bRequestType != USB_DIR_IN)
+			break;
+		*(u8 *)req->buf = dev->config;
+		value = min(wLength, (u16) 1);
+		break;
+
+	case USB_REQ_SET_INTERFACE:
+		if (ctrl->bRequestType != USB_RECIP_INTERFACE || !dev->config)
+			break;
+		value = 0;
+		break;
+	case USB_REQ_GET_INTERFACE:
+		if (ctrl->bRequestType != (USB_DIR_IN|USB_RECIP_INTERFACE)
+				|| !dev->config)
+			break;
+		*(u8 *)req->buf = 0;
+		value = min(wLength, (u16) 1);
+		break;
+
+	default:
+		debug("unknown control req%02x.%02x v%04x l%d\n",
+		      ctrl->bRequestType, ctrl->bRequest, wValue, wLength);
+	}
+
+	/* respond with data transfer before status phase? */
+	if (value >= 0) {
+		req->length = value;
+		req->zero = value < wLength
+				&& (value % gadget->ep0->maxpacket) == 0;
+		value = usb_ep_queue(gadget->ep0, req, 0);
+		if (value < 0) {
+			debug("ep_queue --> %d\n", value);
+			req->status = 0;
+			fastboot_setup_complete(gadget->ep0, req);
+		}
+	}
+
+	/* host either stalls (value < 0) or reports success */
+	return value;
+}
+
+static void fastboot_disconnect(struct usb_gadget *gadget)
+{
+	fastboot_reset_config(get_gadget_data(gadget));
+}
+
+static void fastboot_unbind(struct usb_gadget *gadget)
+{
+	struct fastboot_dev *dev = get_gadget_data(gadget);
+
+	if (dev->req) {
+		usb_ep_free_request(gadget->ep0, dev->req);
+		dev->req = NULL;
+	}
+	set_gadget_data(gadget, NULL);
+}
+
+static int fastboot_bind(struct usb_gadget *gadget)
+{
+	struct fastboot_dev *dev = &fb_dev;
+	char *s;
+
+	s = getenv("serial#");
+	if (s)
+		strncpy(serial_number, s, sizeof(serial_number) - 1);
+
+	usb_ep_autoconfig_reset(gadget);
+	dev->in_ep = usb_ep_autoconfig(gadget, &fs_source_desc);
+	if (!dev->in_ep)
+		goto autoconf_fail;
+	dev->in_ep->driver_data = dev;	/* claim */
+
+	dev->out_ep = usb_ep_autoconfig(gadget, &fs_sink_desc);
+	if (!dev->out_ep)
+		goto autoconf_fail;
+	dev->out_ep->driver_data = dev;	/* claim */
+
+	hs_source_desc.bEndpointAddress = fs_source_desc.bEndpointAddress;
+	hs_sink_desc.bEndpointAddress = fs_sink_desc.bEndpointAddress;
+
+	device_desc.bMaxPacketSize0 = gadget->ep0->maxpacket;
+	dev_qualifier.bMaxPacketSize0 = gadget->ep0->maxpacket;
+
+	dev->req = usb_ep_alloc_request(gadget->ep0, 0);
+	if (!dev->req)
+		return -ENOMEM;
+	dev->req->buf = control_req;
+	dev->req->complete = fastboot_setup_complete;
+
+	dev->gadget = gadget;
+	set_gadget_data(gadget, dev);
+	gadget->ep0->driver_data = dev;
+
+	debug("fastboot: using %s, OUT %s IN %s\n", gadget->name,
+	      dev->out_ep->name, dev->in_ep->name);
+	return 0;
+
+autoconf_fail:
+	error("can't autoconfigure on %s\n", gadget->name);
+	return -ENODEV;
+}
+
+static struct usb_gadget_driver fastboot_driver = {
+	.speed		= DEVSPEED,
+
+	.bind		= fastboot_bind,
+	.unbind		= fastboot_unbind,
+
+	.setup		= fastboot_setup,
+	.disconnect	= fastboot_disconnect,
+};
+
+/*-------------------------------------------------------------------------*/
+
+static int fastboot_tx_wait(struct fastboot_dev *dev)
+{
+	while (dev->tx_busy) {
+		if (ctrlc() || !dev->config)
+			return -1;
+		usb_gadget_handle_interrupts();
+	}
+	return 0;
+}
+
+static void fastboot_tx(struct fastboot_dev *dev, const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	if (fastboot_tx_wait(dev))
+		return;
+
+	/* the replies are short, resp_buf holds a whole packet */
+	va_start(args, fmt);
+	len = vsprintf(resp_buf, fmt, args);
+	va_end(args);
+
+	dev->in_req->length = min(len, FASTBOOT_CMD_LEN);
+	dev->tx_busy = 1;
+	if (usb_ep_queue(dev->in_ep, dev->in_req, 0))
+		dev->tx_busy = 0;
+}
+
+/* Hand the OUT request to the controller, for a command or for data */
+static void fastboot_rx_submit(struct fastboot_dev *dev)
+{
+	struct usb_request *req = dev->out_req;
+	unsigned maxpacket = dev->out_ep->maxpacket;
+	ulong left;
+
+	if (dev->downloading) {
+		/* whole packets; buf_size leaves room to round the last up */
+		left = dev->dl_size - dev->dl_done;
+		left = (left + maxpacket - 1) / maxpacket * maxpacket;
+		req->buf = dev->buf + dev->dl_done;
+		req->length = min(left, (ulong)CONFIG_USB_FASTBOOT_REQ_SIZE);
+	} else {
+		req->buf = cmd_buf;
+		req->length = maxpacket;
+	}
+	req->actual = 0;
+
+	dev->rx_busy = 1;
+	if (usb_ep_queue(dev->out_ep, req, 0))
+		dev->rx_busy = 0;
+}
+
+/*-------------------------------------------------------------------------*/
+
+static void fastboot_getvar(struct fastboot_dev *dev, const char *var)
+{
+	if (!strcmp(var, "version"))
+		fastboot_tx(dev, "OKAY0.4");
+	else if (!strcmp(var, "version-bootloader"))
+		fastboot_tx(dev, "OKAY%s", U_BOOT_VERSION);
+	else if (!strcmp(var, "serialno"))
+		fastboot_tx(dev, "OKAY%s", serial_number);
+	else if (!strcmp(var, "max-download-size"))
+		fastboot_tx(dev, "OKAY0x%08lx", dev->buf_size);
+	else if (!strcmp(var, "downloadsize"))
+		fastboot_tx(dev, "OKAY0x%08lx", dev->last_size);
+	else
+		fastboot_tx(dev, "FAILunknown variable");
+}
+
+static void fastboot_command(struct fastboot_dev *dev, char *cmd)
+{
+	struct dl_part part;
+	char *list = getenv("fastboot_partitions");
+	ulong size;
+	int err;
+
+	debug("fastboot: %s\n", cmd);
+
+	if (!strncmp(cmd, "getvar:", 7)) {
+		fastboot_getvar(dev, cmd + 7);
+	} else if (!strncmp(cmd, "download:", 9)) {
+		size = simple_strtoul(cmd + 9, NULL, 16);
+		if (!size || size > dev->buf_size) {
+			fastboot_tx(dev, "FAILdata too large");
+			return;
+		}
+		dev->dl_size = size;
+		dev->dl_done = 0;
+		dev->downloading = 1;
+		fastboot_tx(dev, "DATA%08lx", size);
+	} else if (!strncmp(cmd, "flash:", 6)) {
+		if (dl_part_find(list, cmd + 6, &part)) {
+			fastboot_tx(dev, "FAILunknown partition");
+			return;
+		}
+		if (!dev->last_size) {
+			fastboot_tx(dev, "FAILno image downloaded");
+			return;
+		}
+		printf("fastboot: writing %lu bytes to %s\n",
+		       dev->last_size, part.name);
+		part.image_len = dev->last_size;
+		err = dl_part_open(&part);
+		if (!err) {
+			err = dl_part_write(&part, dev->buf, dev->last_size);
+			if (dl_part_close(&part))
+				err = -1;
+		}
+		if (err)
+			fastboot_tx(dev, "FAILwrite failed");
+		else
+			fastboot_tx(dev, "OKAY");
+	} else if (!strncmp(cmd, "erase:", 6)) {
+		if (dl_part_find(list, cmd + 6, &part)) {
+			fastboot_tx(dev, "FAILunknown partition");
+			return;
+		}
+		if (dl_part_erase(&part))
+			fastboot_tx(dev, "FAILerase failed");
+		else
+			fastboot_tx(dev, "OKAY");
+	} else if (!strcmp(cmd, "boot")) {
+		fastboot_tx(dev, "OKAY");
+		dev->action = FASTBOOT_BOOT;
+	} else if (!strcmp(cmd, "continue")) {
+		fastboot_tx(dev, "OKAY");
+		dev->action = FASTBOOT_CONTINUE;
+	} else if (!strncmp(cmd, "reboot", 6)) {
+		fastboot_tx(dev, "OKAY");
+		dev->action = FASTBOOT_REBOOT;
+	} else {
+		fastboot_tx(dev, "FAILunknown command");
+	}
+}
+
+/* The OUT request has come back: a command, or a piece of the download */
+static void fastboot_rx(struct fastboot_dev *dev)
+{
+	struct usb_request *req = dev->out_req;
+	int len = req->actual;
+
+	dev->rx_done = 0;
+
+	if (dev->downloading) {
+		dev->dl_done += len;
+		if (dev->dl_done >= dev->dl_size ||
+		    len < req->length) {
+			dev->downloading = 0;
+			if (dev->dl_done < dev->dl_size) {
+				fastboot_tx(dev, "FAILshort download");
+				return;
+			}
+			dev->last_size = dev->dl_size;
+			printf("fastboot: downloaded %lu bytes\n",
+			       dev->last_size);
+			fastboot_tx(dev, "OKAY");
+		}
+		return;
+	}
+
+	if (len > FASTBOOT_CMD_LEN)
+		len = FASTBOOT_CMD_LEN;
+	cmd_buf[len] = '\0';
+	fastboot_command(dev, cmd_buf);
+}
+
+int fastboot_run(void *buf, ulong size, ulong *len)
+{
+	struct fastboot_dev *dev = &fb_dev;
+
+	memset(dev, 0, sizeof(*dev));
+	dev->buf = buf;
+	/* the last request is rounded up to whole packets */
+	dev->buf_size = size & ~(FASTBOOT_EP_BUFSIZ - 1);
+	dev->action = FASTBOOT_NONE;
+
+	if (board_usb_gadget_init())
+		return -1;
+	if (usb_gadget_register_driver(&fastboot_driver) < 0)
+		return -1;
+	usb_gadget_connect(dev->gadget);
+
+	while (dev->action == FASTBOOT_NONE) {
+		if (ctrlc()) {
+			dev->action = FASTBOOT_CONTINUE;
+			break;
+		}
+		usb_gadget_handle_interrupts();
+		if (!dev->config)
+			continue;
+
+		if (dev->rx_done)
+			fastboot_rx(dev);
+		if (!dev->rx_busy && !dev->rx_done && dev->config)
+			fastboot_rx_submit(dev);
+	}
+
+	/* let the host see the last reply */
+	fastboot_tx_wait(dev);
+
+	usb_gadget_disconnect(dev->gadget);
+	fastboot_reset_config(dev);
+	usb_gadget_unregister_driver(&fastboot_driver);
+
+	if (len)
+		*len = dev->last_size;
+	return dev->action;
+}
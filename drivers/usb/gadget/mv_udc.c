@@ -168,8 +168,12 @@ static int mv_ep_queue(struct usb_ep *ep,
 
 	item->next = TERMINATE;
 	item->info = INFO_BYTES(len) | INFO_IOC | INFO_ACTIVE;
+	/* a dTD covers five pages, at least 16K wherever buf starts */
 	item->page0 = phys;
 	item->page1 = (phys & 0xfffff000) + 0x1000;
+	item->page2 = (phys & 0xfffff000) + 0x2000;
+	item->page3 = (phys & 0xfffff000) + 0x3000;
+	item->page4 = (phys & 0xfffff000) + 0x4000;
 
 	head->next = (unsigned) item;
 	head->info = 0;
@@ -205,6 +209,7 @@ static void handle_ep_complete(struct mv_ep *ep)
 
 	len = (item->info >> 16) & 0x7fff;
 	ep->req.length -= len;
+	ep->req.actual = ep->req.length;
 	DBG("ept%d %s complete %x\n",
 			num, in ? "in" : "out", len);
 	ep->req.complete(&ep->ep, &ep->req);
@@ -114,33 +114,54 @@ static inline void s3c_ep0_complete_out(void)
 }
 
 
+/*
+ * Bulk OUT data of whole packets goes straight into a cache aligned
+ * request buffer, as many packets at a time as the transfer size
+ * register holds; the rest is bounced a packet at a time.
+ */
+static int rx_direct(struct s3c_ep *ep)
+{
+	return ep_index(ep) != EP0_CON &&
+		ep->len >= ep->ep.maxpacket &&
+		!((unsigned long) ep->dma_buf & (ARCH_DMA_MINALIGN - 1));
+}
+
 static int setdma_rx(struct s3c_ep *ep, struct s3c_request *req)
 {
 	u32 *buf, ctrl;
 	u32 length, pktcnt;
 	u32 ep_num = ep_index(ep);
+	u32 maxpacket = ep->ep.maxpacket;
+	dma_addr_t dma;
 
 	buf = req->req.buf + req->req.actual;
+	length = req->req.length - req->req.actual;
 
-	length = min(req->req.length - req->req.actual, (int)ep->ep.maxpacket);
-
-	ep->len = length;
+	ep->len = min(length, maxpacket);
 	ep->dma_buf = buf;
 
-	invalidate_dcache_range((unsigned long) ep->dev->dma_buf[ep_num],
-				(unsigned long) ep->dev->dma_buf[ep_num]
-				+ DMA_BUFFER_SIZE);
+	if (rx_direct(ep)) {
+		length = min(length, (u32)DOEPT_SIZ_XFER_SIZE_MAX_EP);
+		length -= length % maxpacket;
+		ep->len = length;
+		pktcnt = length / maxpacket;
+		dma = (dma_addr_t) buf;
 
-	if (length == 0)
+		invalidate_dcache_range((unsigned long) buf,
+					(unsigned long) buf + length);
+	} else {
+		length = ep->len;
 		pktcnt = 1;
-	else
-		pktcnt = (length - 1)/(ep->ep.maxpacket) + 1;
+		dma = the_controller->dma_addr[ep_index(ep)+1];
+
+		invalidate_dcache_range((unsigned long) ep->dev->dma_buf[ep_num],
+					(unsigned long) ep->dev->dma_buf[ep_num]
+					+ DMA_BUFFER_SIZE);
+	}
 
-	pktcnt = 1;
 	ctrl =  readl(&reg->out_endp[ep_num].doepctl);
 
-	writel(the_controller->dma_addr[ep_index(ep)+1],
-	       &reg->out_endp[ep_num].doepdma);
+	writel(dma, &reg->out_endp[ep_num].doepdma);
 	writel(DOEPT_SIZ_PKT_CNT(pktcnt) | DOEPT_SIZ_XFER_SIZE(length),
 	       &reg->out_endp[ep_num].doeptsiz);
 	writel(DEPCTL_EPENA|DEPCTL_CNAK|ctrl, &reg->out_endp[ep_num].doepctl);
@@ -241,13 +262,19 @@ static void complete_rx(struct s3c_udc *dev, u8 ep_num)
 
 	xfer_size = ep->len - xfer_size;
 
-	invalidate_dcache_range((unsigned long) p,
-				(unsigned long) p + DMA_BUFFER_SIZE);
+	if (rx_direct(ep)) {
+		invalidate_dcache_range((unsigned long) ep->dma_buf,
+					(unsigned long) ep->dma_buf + ep->len);
+		is_short = (xfer_size < ep->len);
+	} else {
+		invalidate_dcache_range((unsigned long) p,
+					(unsigned long) p + DMA_BUFFER_SIZE);
 
-	memcpy(ep->dma_buf, p, ep->len);
+		memcpy(ep->dma_buf, p, ep->len);
+		is_short = (xfer_size < ep->ep.maxpacket);
+	}
 
 	req->req.actual += min(xfer_size, req->req.length - req->req.actual);
-	is_short = (xfer_size < ep->ep.maxpacket);
 
 	DEBUG_OUT_EP("%s: RX DMA done : ep = %d, rx bytes = %d/%d, "
 		     "is_short = %d, DOEPTSIZ = 0x%x, remained bytes = %d\n",
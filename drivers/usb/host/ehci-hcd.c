@@ -26,6 +26,8 @@
 #include <asm/io.h>
 #include <malloc.h>
 #include <watchdog.h>
+#include <wait_bit.h>
+#include <dma_map.h>
 #ifdef CONFIG_USB_KEYBOARD
 #include <stdio_dev.h>
 extern unsigned char new[];
@@ -112,98 +114,19 @@ static struct descriptor {
 #define ehci_is_TDI()	(0)
 #endif
 
-#if defined(CONFIG_EHCI_DCACHE)
 /*
- * Routines to handle (flush/invalidate) the dcache for the QH and qTD
- * structures and data buffers. This is needed on platforms using this
- * EHCI support with dcache enabled.
+ * The QH and qTD structures all live in the static pool below, each set
+ * aligned to a cache line; data buffers go through dma_bounce_start().
  */
-static void flush_invalidate(u32 addr, int size, int flush)
-{
-	if (flush)
-		flush_dcache_range(addr, addr + size);
-	else
-		invalidate_dcache_range(addr, addr + size);
-}
-
-static void cache_qtd(struct qTD *qtd, int flush)
-{
-	u32 *ptr = (u32 *)qtd->qt_buffer[0];
-	int len = (qtd->qt_token & 0x7fff0000) >> 16;
-
-	flush_invalidate((u32)qtd, sizeof(struct qTD), flush);
-	if (ptr && len)
-		flush_invalidate((u32)ptr, len, flush);
-}
-
-
-static inline struct QH *qh_addr(struct QH *qh)
-{
-	return (struct QH *)((u32)qh & 0xffffffe0);
-}
-
-static void cache_qh(struct QH *qh, int flush)
-{
-	struct qTD *qtd;
-	struct qTD *next;
-	static struct qTD *first_qtd;
-
-	/*
-	 * Walk the QH list and flush/invalidate all entries
-	 */
-	while (1) {
-		flush_invalidate((u32)qh_addr(qh), sizeof(struct QH), flush);
-		if ((u32)qh & QH_LINK_TYPE_QH)
-			break;
-		qh = qh_addr(qh);
-		qh = (struct QH *)qh->qh_link;
-	}
-	qh = qh_addr(qh);
-
-	/*
-	 * Save first qTD pointer, needed for invalidating pass on this QH
-	 */
-	if (flush)
-		first_qtd = qtd = (struct qTD *)(*(u32 *)&qh->qh_overlay &
-						 0xffffffe0);
-	else
-		qtd = first_qtd;
-
-	/*
-	 * Walk the qTD list and flush/invalidate all entries
-	 */
-	while (1) {
-		if (qtd == NULL)
-			break;
-		cache_qtd(qtd, flush);
-		next = (struct qTD *)((u32)qtd->qt_next & 0xffffffe0);
-		if (next == qtd)
-			break;
-		qtd = next;
-	}
-}
-
-static inline void ehci_flush_dcache(struct QH *qh)
-{
-	cache_qh(qh, 1);
-}
-
-static inline void ehci_invalidate_dcache(struct QH *qh)
-{
-	cache_qh(qh, 0);
-}
-#else /* CONFIG_EHCI_DCACHE */
-/*
- *
- */
-static inline void ehci_flush_dcache(struct QH *qh)
+static inline void ehci_flush_dcache(const void *p, size_t size)
 {
+	dma_map_range(p, size, DMA_MAP_BIDIRECTIONAL);
 }
 
-static inline void ehci_invalidate_dcache(struct QH *qh)
+static inline void ehci_invalidate_dcache(const void *p, size_t size)
 {
+	dma_unmap_range(p, size, DMA_MAP_FROM_DEVICE);
 }
-#endif /* CONFIG_EHCI_DCACHE */
 
 void __ehci_powerup_fixup(uint32_t *status_reg, uint32_t *reg)
 {
@@ -215,25 +138,21 @@ void ehci_powerup_fixup(uint32_t *status_reg, uint32_t *reg)
 
 static int handshake(uint32_t *ptr, uint32_t mask, uint32_t done, int usec)
 {
+	struct wait_backoff wb;
 	uint32_t result;
+
+	wait_backoff_start(&wb, DIV_ROUND_UP(usec, 1000));
 	do {
 		result = ehci_readl(ptr);
-		udelay(5);
 		if (result == ~(uint32_t)0)
 			return -1;
 		result &= mask;
 		if (result == done)
 			return 0;
-		usec--;
-	} while (usec > 0);
+	} while (!wait_backoff(&wb));
 	return -1;
 }
 
-static void ehci_free(void *p, size_t sz)
-{
-
-}
-
 static int ehci_reset(void)
 {
 	uint32_t cmd;
@@ -263,34 +182,55 @@ out:
 	return ret;
 }
 
-static void *ehci_alloc(size_t sz, size_t align)
-{
-	static struct QH qh __attribute__((aligned(32)));
-	static struct qTD td[3] __attribute__((aligned (32)));
-	static int ntds;
-	void *p;
-
-	switch (sz) {
-	case sizeof(struct QH):
-		p = &qh;
-		ntds = 0;
-		break;
-	case sizeof(struct qTD):
-		if (ntds == 3) {
-			debug("out of TDs\n");
-			return NULL;
-		}
-		p = &td[ntds];
-		ntds++;
-		break;
-	default:
-		debug("unknown allocation size\n");
-		return NULL;
-	}
+/*
+ * Descriptors of a transfer: a setup qTD, up to CONFIG_EHCI_QTD_COUNT
+ * data qTDs and a status qTD.  There are two sets, so one transfer can be
+ * queued with submit_bulk_queue() while another one is done.
+ */
+#ifndef CONFIG_EHCI_QTD_COUNT
+#define CONFIG_EHCI_QTD_COUNT	64
+#endif
+#define EHCI_QTD_POOL		(CONFIG_EHCI_QTD_COUNT + 2)
+#define EHCI_XFERS		2
 
-	memset(p, 0, sz);
-	return p;
-}
+/*
+ * A data qTD always holds 16 KiB: it has five buffer pointers of one page
+ * each, the first may start anywhere in its page and the length has to be
+ * a multiple of the packet size unless it is the last one.
+ */
+#define EHCI_QTD_MIN_XFER	(4 * 4096)
+
+static struct ehci_desc {
+	struct QH qh;
+	struct qTD td[EHCI_QTD_POOL];
+} __attribute__((aligned(ARCH_DMA_MINALIGN))) ehci_desc[EHCI_XFERS];
+
+/* What the CPU keeps about a transfer, apart from the descriptors */
+static struct ehci_xfer {
+	struct ehci_desc *desc;
+	struct usb_device *dev;
+	unsigned long pipe;
+	void *buffer;
+	int length;
+	struct dma_bounce bounce;	/* what the qTDs point to */
+	struct qTD *last;	/* the qTD to watch for completion */
+	int first;		/* index of the first data qTD */
+	int ndata;		/* number of data qTDs */
+	int ntds;
+	int linked;		/* QH is in the async schedule */
+	int status;
+	int act_len;
+} ehci_xfer[EHCI_XFERS];
+
+/*
+ * The async schedule is started by the first transfer and runs until
+ * usb_lowlevel_stop(); QHs are linked in and out while it runs.  A QH
+ * that was unlinked may still be cached by the controller until the
+ * async advance doorbell has been answered.
+ */
+static int ehci_async_running;
+static struct ehci_xfer *ehci_advance;	/* waiting for the doorbell */
+static struct ehci_xfer *ehci_queued;	/* from submit_bulk_queue() */
 
 static int ehci_td_buffer(struct qTD *td, void *buf, size_t sz)
 {
@@ -319,41 +259,66 @@ static int ehci_td_buffer(struct qTD *td, void *buf, size_t sz)
 	return 0;
 }
 
-static int
-ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
-		   int length, struct devrequest *req)
+int usb_max_xfer_len(struct usb_device *dev)
+{
+	return CONFIG_EHCI_QTD_COUNT * EHCI_QTD_MIN_XFER;
+}
+
+static int ehci_wait_doorbell(void)
 {
-	struct QH *qh;
+	int ret;
+
+	if (ehci_advance == NULL)
+		return 0;
+
+	ret = handshake((uint32_t *)&hcor->or_usbsts, STS_IAA, STS_IAA,
+			100 * 1000);
+	if (ret < 0)
+		printf("EHCI fail timeout STS_IAA set\n");
+	ehci_writel(&hcor->or_usbsts, STS_IAA);
+	ehci_advance = NULL;
+	return ret;
+}
+
+static struct ehci_xfer *ehci_get_xfer(void)
+{
+	int i;
+
+	/* Prefer descriptors the controller is known to be done with */
+	for (i = 0; i < EHCI_XFERS; i++)
+		if (!ehci_xfer[i].linked && &ehci_xfer[i] != ehci_advance)
+			return &ehci_xfer[i];
+
+	for (i = 0; i < EHCI_XFERS; i++) {
+		if (!ehci_xfer[i].linked) {
+			ehci_wait_doorbell();
+			return &ehci_xfer[i];
+		}
+	}
+
+	debug("no free QH\n");
+	return NULL;
+}
+
+static int ehci_build(struct ehci_xfer *x, struct usb_device *dev,
+		      unsigned long pipe, void *buffer, int length,
+		      struct devrequest *req)
+{
+	struct QH *qh = &x->desc->qh;
 	struct qTD *td;
-	volatile struct qTD *vtd;
-	unsigned long ts;
 	uint32_t *tdp;
-	uint32_t endpt, token, usbsts;
+	uint32_t endpt, token;
 	uint32_t c, toggle;
-	uint32_t cmd;
-	int timeout;
-	int ret = 0;
+	int i, ntds, left, xfer, maxp;
+	char *buf;
 
-	debug("dev=%p, pipe=%lx, buffer=%p, length=%d, req=%p\n", dev, pipe,
-	      buffer, length, req);
-	if (req != NULL)
-		debug("req=%u (%#x), type=%u (%#x), value=%u (%#x), index=%u\n",
-		      req->request, req->request,
-		      req->requesttype, req->requesttype,
-		      le16_to_cpu(req->value), le16_to_cpu(req->value),
-		      le16_to_cpu(req->index));
-
-	qh = ehci_alloc(sizeof(struct QH), 32);
-	if (qh == NULL) {
-		debug("unable to allocate QH\n");
-		return -1;
-	}
-	qh->qh_link = cpu_to_hc32((uint32_t)&qh_list | QH_LINK_TYPE_QH);
+	maxp = usb_maxpacket(dev, pipe);
+	memset(qh, 0, sizeof(*qh));
 	c = (usb_pipespeed(pipe) != USB_SPEED_HIGH &&
 	     usb_pipeendpoint(pipe) == 0) ? 1 : 0;
 	endpt = (8 << 28) |
 	    (c << 27) |
-	    (usb_maxpacket(dev, pipe) << 16) |
+	    (maxp << 16) |
 	    (0 << 15) |
 	    (1 << 14) |
 	    (usb_pipespeed(pipe) << 12) |
@@ -368,16 +333,14 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 
 	td = NULL;
 	tdp = &qh->qh_overlay.qt_next;
+	ntds = 0;
 
 	toggle =
 	    usb_gettoggle(dev, usb_pipeendpoint(pipe), usb_pipeout(pipe));
 
 	if (req != NULL) {
-		td = ehci_alloc(sizeof(struct qTD), 32);
-		if (td == NULL) {
-			debug("unable to allocate SETUP td\n");
-			goto fail;
-		}
+		td = &x->desc->td[ntds++];
+		memset(td, 0, sizeof(*td));
 		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
 		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
 		token = (0 << 31) |
@@ -386,47 +349,70 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		td->qt_token = cpu_to_hc32(token);
 		if (ehci_td_buffer(td, req, sizeof(*req)) != 0) {
 			debug("unable construct SETUP td\n");
-			ehci_free(td, sizeof(*td));
-			goto fail;
+			return -1;
 		}
 		*tdp = cpu_to_hc32((uint32_t) td);
 		tdp = &td->qt_next;
 		toggle = 1;
 	}
 
+	/*
+	 * Split the data stage into a chain of qTDs.  Every qTD but the
+	 * last one ends on a packet boundary, so the toggle of the next one
+	 * follows from the number of packets.
+	 */
+	x->first = ntds;
+	if (dma_bounce_start(&x->bounce, buffer, length,
+			     usb_pipein(pipe) ? DMA_MAP_FROM_DEVICE :
+						DMA_MAP_TO_DEVICE))
+		return -1;
 	if (length > 0 || req == NULL) {
-		td = ehci_alloc(sizeof(struct qTD), 32);
-		if (td == NULL) {
-			debug("unable to allocate DATA td\n");
-			goto fail;
-		}
-		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
-		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
-		token = (toggle << 31) |
-		    (length << 16) |
-		    ((req == NULL ? 1 : 0) << 15) |
-		    (0 << 12) |
-		    (3 << 10) |
-		    ((usb_pipein(pipe) ? 1 : 0) << 8) | (0x80 << 0);
-		td->qt_token = cpu_to_hc32(token);
-		if (ehci_td_buffer(td, buffer, length) != 0) {
-			debug("unable construct DATA td\n");
-			ehci_free(td, sizeof(*td));
-			goto fail;
-		}
-		*tdp = cpu_to_hc32((uint32_t) td);
-		tdp = &td->qt_next;
+		buf = x->bounce.buf;
+		left = length;
+		do {
+			if (ntds == EHCI_QTD_POOL - 1) {
+				debug("transfer of %d bytes too large\n",
+				      length);
+				goto fail;
+			}
+			xfer = 5 * 4096 - ((uint32_t)buf & 4095);
+			if (xfer < left)
+				xfer -= xfer % maxp;
+			else
+				xfer = left;
+
+			td = &x->desc->td[ntds++];
+			memset(td, 0, sizeof(*td));
+			td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+			td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+			token = (toggle << 31) |
+			    (xfer << 16) |
+			    ((req == NULL && xfer == left ? 1 : 0) << 15) |
+			    (0 << 12) |
+			    (3 << 10) |
+			    ((usb_pipein(pipe) ? 1 : 0) << 8) | (0x80 << 0);
+			td->qt_token = cpu_to_hc32(token);
+			if (ehci_td_buffer(td, buf, xfer) != 0) {
+				debug("unable construct DATA td\n");
+				goto fail;
+			}
+			*tdp = cpu_to_hc32((uint32_t) td);
+			tdp = &td->qt_next;
+
+			if (xfer == 0 || ((xfer + maxp - 1) / maxp) & 1)
+				toggle ^= 1;
+			buf += xfer;
+			left -= xfer;
+		} while (left > 0);
 	}
+	x->ndata = ntds - x->first;
 
 	if (req != NULL) {
-		td = ehci_alloc(sizeof(struct qTD), 32);
-		if (td == NULL) {
-			debug("unable to allocate ACK td\n");
-			goto fail;
-		}
+		td = &x->desc->td[ntds++];
+		memset(td, 0, sizeof(*td));
 		td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
 		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
-		token = (toggle << 31) |
+		token = (1 << 31) |
 		    (0 << 16) |
 		    (1 << 15) |
 		    (0 << 12) |
@@ -436,11 +422,60 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		*tdp = cpu_to_hc32((uint32_t) td);
 		tdp = &td->qt_next;
 	}
+	x->last = td;
 
-	qh_list.qh_link = cpu_to_hc32((uint32_t) qh | QH_LINK_TYPE_QH);
+	/*
+	 * A short IN packet ends the data stage: the alternate next pointer
+	 * of every data qTD leads to the status stage or, for a bulk
+	 * transfer, to an inactive qTD at which the QH stops.
+	 */
+	if (usb_pipein(pipe) && x->ndata > 0) {
+		if (req == NULL) {
+			td = &x->desc->td[ntds++];
+			memset(td, 0, sizeof(*td));
+			td->qt_next = cpu_to_hc32(QT_NEXT_TERMINATE);
+			td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+		}
+		for (i = x->first; i < x->first + x->ndata; i++)
+			x->desc->td[i].qt_altnext = cpu_to_hc32((uint32_t) td);
+	}
+
+	x->dev = dev;
+	x->pipe = pipe;
+	x->buffer = buffer;
+	x->length = length;
+	x->ntds = ntds;
+	x->status = USB_ST_NOT_PROC;
+	x->act_len = 0;
 
 	/* Flush dcache */
-	ehci_flush_dcache(&qh_list);
+	ehci_flush_dcache(qh, sizeof(*qh));
+	ehci_flush_dcache(x->desc->td, ntds * sizeof(struct qTD));
+	if (req != NULL)
+		ehci_flush_dcache(req, sizeof(*req));
+
+	return 0;
+
+fail:
+	dma_bounce_stop(&x->bounce);
+	return -1;
+}
+
+/* Put the QH of a transfer at the front of the running async schedule */
+static int ehci_start(struct ehci_xfer *x)
+{
+	struct QH *qh = &x->desc->qh;
+	uint32_t cmd, usbsts;
+	int ret;
+
+	qh->qh_link = qh_list.qh_link;
+	ehci_flush_dcache(qh, sizeof(*qh));
+	qh_list.qh_link = cpu_to_hc32((uint32_t) qh | QH_LINK_TYPE_QH);
+	ehci_flush_dcache(&qh_list, sizeof(qh_list));
+	x->linked = 1;
+
+	if (ehci_async_running)
+		return 0;
 
 	usbsts = ehci_readl(&hcor->or_usbsts);
 	ehci_writel(&hcor->or_usbsts, (usbsts & 0x3f));
@@ -454,40 +489,93 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 			100 * 1000);
 	if (ret < 0) {
 		printf("EHCI fail timeout STD_ASS set\n");
-		goto fail;
+		return -1;
 	}
+	ehci_async_running = 1;
+	return 0;
+}
+
+/*
+ * Take the QH of a transfer out of the schedule.  Transfers are always
+ * linked at the front and completed newest first, so this only touches
+ * qh_list in practice and never a QH the controller is working on.
+ */
+static void ehci_unlink(struct ehci_xfer *x)
+{
+	struct QH *qh = &x->desc->qh;
+	struct QH *prev = &qh_list;
+	uint32_t link = cpu_to_hc32((uint32_t) qh | QH_LINK_TYPE_QH);
+	uint32_t cmd;
 
-	/* Wait for TDs to be processed. */
+	while (prev->qh_link != link)
+		prev = (struct QH *)(hc32_to_cpu(prev->qh_link) & ~0x1f);
+	prev->qh_link = qh->qh_link;
+	ehci_flush_dcache(prev, sizeof(*prev));
+	x->linked = 0;
+
+	/* Only one doorbell can be outstanding */
+	ehci_wait_doorbell();
+	cmd = ehci_readl(&hcor->or_usbcmd);
+	cmd |= CMD_IAAD;
+	ehci_writel(&hcor->or_usbcmd, cmd);
+	ehci_advance = x;
+}
+
+/*
+ * Whether the QH stopped before the last qTD: it halted on an error, or a
+ * bulk IN transfer ended on a short packet and the QH sits on the data
+ * qTD that got it.  The caller has invalidated the QH.
+ */
+static int ehci_stopped(struct ehci_xfer *x)
+{
+	struct QH *qh = &x->desc->qh;
+	uint32_t token = hc32_to_cpu(qh->qh_overlay.qt_token);
+
+	if (token & 0x40)
+		return 1;
+	return !usb_pipecontrol(x->pipe) && qh->qh_curtd != 0 &&
+	       !(token & 0x80) && ((token >> 16) & 0x7fff) != 0;
+}
+
+/* Wait for a transfer, record its result and unlink it */
+static void ehci_finish(struct ehci_xfer *x, int timeout)
+{
+	struct usb_device *dev = x->dev;
+	struct QH *qh = &x->desc->qh;
+	struct qTD *td;
+	volatile struct qTD *vtd;
+	unsigned long ts;
+	uint32_t token, toggle;
+
+	/*
+	 * Wait for TDs to be processed, the last one is enough to watch
+	 * unless the QH stops on an earlier one: then the last one never
+	 * retires, and the result is in the overlay.
+	 */
 	ts = get_timer(0);
-	vtd = td;
-	timeout = USB_TIMEOUT_MS(pipe);
+	vtd = x->last;
 	do {
 		/* Invalidate dcache */
-		ehci_invalidate_dcache(&qh_list);
+		ehci_invalidate_dcache(x->last, sizeof(struct qTD));
 		token = hc32_to_cpu(vtd->qt_token);
 		if (!(token & 0x80))
 			break;
+		ehci_invalidate_dcache(qh, sizeof(*qh));
+		if (ehci_stopped(x))
+			break;
 		WATCHDOG_RESET();
 	} while (get_timer(ts) < timeout);
 
 	/* Check that the TD processing happened */
-	if (token & 0x80) {
+	if ((token & 0x80) && !ehci_stopped(x)) {
 		printf("EHCI timed out on TD - token=%#x\n", token);
 	}
 
-	/* Disable async schedule. */
-	cmd = ehci_readl(&hcor->or_usbcmd);
-	cmd &= ~CMD_ASE;
-	ehci_writel(&hcor->or_usbcmd, cmd);
+	ehci_unlink(x);
 
-	ret = handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, 0,
-			100 * 1000);
-	if (ret < 0) {
-		printf("EHCI fail timeout STD_ASS reset\n");
-		goto fail;
-	}
-
-	qh_list.qh_link = cpu_to_hc32((uint32_t)&qh_list | QH_LINK_TYPE_QH);
+	ehci_invalidate_dcache(qh, sizeof(*qh));
+	ehci_invalidate_dcache(x->desc->td, x->ntds * sizeof(struct qTD));
+	dma_bounce_stop(&x->bounce);
 
 	token = hc32_to_cpu(qh->qh_overlay.qt_token);
 	if (!(token & 0x80)) {
@@ -495,47 +583,114 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		switch (token & 0xfc) {
 		case 0:
 			toggle = token >> 31;
-			usb_settoggle(dev, usb_pipeendpoint(pipe),
-				       usb_pipeout(pipe), toggle);
-			dev->status = 0;
+			usb_settoggle(dev, usb_pipeendpoint(x->pipe),
+				       usb_pipeout(x->pipe), toggle);
+			x->status = 0;
 			break;
 		case 0x40:
-			dev->status = USB_ST_STALLED;
+			x->status = USB_ST_STALLED;
 			break;
 		case 0xa0:
 		case 0x20:
-			dev->status = USB_ST_BUF_ERR;
+			x->status = USB_ST_BUF_ERR;
 			break;
 		case 0x50:
 		case 0x10:
-			dev->status = USB_ST_BABBLE_DET;
+			x->status = USB_ST_BABBLE_DET;
 			break;
 		default:
-			dev->status = USB_ST_CRC_ERR;
+			x->status = USB_ST_CRC_ERR;
 			if ((token & 0x40) == 0x40)
-				dev->status |= USB_ST_STALLED;
+				x->status |= USB_ST_STALLED;
 			break;
 		}
-		dev->act_len = length - ((token >> 16) & 0x7fff);
+		/* Sum up what the data qTDs have left untransferred */
+		x->act_len = x->length;
+		for (td = &x->desc->td[x->first];
+		     td < &x->desc->td[x->first + x->ndata]; td++)
+			x->act_len -= (hc32_to_cpu(td->qt_token) >> 16) &
+				      0x7fff;
 	} else {
-		dev->act_len = 0;
+		x->act_len = 0;
 		debug("dev=%u, usbsts=%#x, p[1]=%#x, p[2]=%#x\n",
 		      dev->devnum, ehci_readl(&hcor->or_usbsts),
 		      ehci_readl(&hcor->or_portsc[0]),
 		      ehci_readl(&hcor->or_portsc[1]));
 	}
+}
 
+static int
+ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
+		   int length, struct devrequest *req)
+{
+	struct ehci_xfer *x;
+
+	debug("dev=%p, pipe=%lx, buffer=%p, length=%d, req=%p\n", dev, pipe,
+	      buffer, length, req);
+	if (req != NULL)
+		debug("req=%u (%#x), type=%u (%#x), value=%u (%#x), index=%u\n",
+		      req->request, req->request,
+		      req->requesttype, req->requesttype,
+		      le16_to_cpu(req->value), le16_to_cpu(req->value),
+		      le16_to_cpu(req->index));
+
+	x = ehci_get_xfer();
+	if (x == NULL)
+		return -1;
+	if (ehci_build(x, dev, pipe, buffer, length, req) != 0)
+		return -1;
+	if (ehci_start(x) != 0) {
+		ehci_unlink(x);
+		dma_bounce_stop(&x->bounce);
+		return -1;
+	}
+	ehci_finish(x, USB_TIMEOUT_MS(pipe));
+
+	if (x->status != USB_ST_NOT_PROC)
+		dev->status = x->status;
+	dev->act_len = x->act_len;
 	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
+}
 
-fail:
-	td = (void *)hc32_to_cpu(qh->qh_overlay.qt_next);
-	while (td != (void *)QT_NEXT_TERMINATE) {
-		qh->qh_overlay.qt_next = td->qt_next;
-		ehci_free(td, sizeof(*td));
-		td = (void *)hc32_to_cpu(qh->qh_overlay.qt_next);
+int submit_bulk_queue(struct usb_device *dev, unsigned long pipe,
+		      void *buffer, int length)
+{
+	struct ehci_xfer *x;
+
+	if (usb_pipetype(pipe) != PIPE_BULK) {
+		debug("non-bulk pipe (type=%lu)", usb_pipetype(pipe));
+		return -1;
 	}
-	ehci_free(qh, sizeof(*qh));
-	return -1;
+	if (ehci_queued != NULL) {
+		debug("a bulk transfer is already queued\n");
+		return -1;
+	}
+
+	x = ehci_get_xfer();
+	if (x == NULL)
+		return -1;
+	if (ehci_build(x, dev, pipe, buffer, length, NULL) != 0)
+		return -1;
+	if (ehci_start(x) != 0) {
+		ehci_unlink(x);
+		dma_bounce_stop(&x->bounce);
+		return -1;
+	}
+	ehci_queued = x;
+	return 0;
+}
+
+int submit_bulk_wait(struct usb_device *dev, int *actual_length, int timeout)
+{
+	struct ehci_xfer *x = ehci_queued;
+
+	if (x == NULL)
+		return -1;
+	ehci_queued = NULL;
+
+	ehci_finish(x, timeout);
+	*actual_length = x->act_len;
+	return (x->status == 0) ? 0 : -1;
 }
 
 static inline int min3(int a, int b, int c)
@@ -801,8 +956,245 @@ unknown:
 	return -1;
 }
 
+#ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
+/*
+ * Interrupt transfers in the periodic schedule.  Every frame of the list
+ * points to the chain of interrupt QHs, which the controller polls once a
+ * frame, whatever the bInterval, with a qTD per element of the queue.  So
+ * whether a report has come in is a look at memory, not a transfer.
+ */
+#define EHCI_PERIODIC_FRAMES	1024
+#define EHCI_INT_QUEUE_MAX	8
+
+struct int_queue {
+	struct QH qh;		/* first: what the frames point to */
+	struct qTD td[EHCI_INT_QUEUE_MAX];
+	struct int_queue *next;
+	void *buf;		/* what the qTDs point to */
+	void *dest;		/* the elements are copied here */
+	int size;
+	int elsize;
+	int pos;		/* the next qTD to complete */
+};
+
+static uint32_t *ehci_periodic;
+static struct int_queue *ehci_int_queues;
+static int ehci_periodic_running;
+
+static void ehci_int_link_head(struct int_queue *q)
+{
+	uint32_t link = q ? (uint32_t)&q->qh | QH_LINK_TYPE_QH :
+			    QH_LINK_TERMINATE;
+	int i;
+
+	for (i = 0; i < EHCI_PERIODIC_FRAMES; i++)
+		ehci_periodic[i] = cpu_to_hc32(link);
+	ehci_flush_dcache(ehci_periodic, EHCI_PERIODIC_FRAMES * 4);
+}
+
+/* Point the qTDs at the elements again, and the QH at the first qTD */
+static void ehci_int_arm(struct int_queue *q)
+{
+	struct qTD *td;
+	uint32_t toggle;
+	int i;
+
+	for (i = 0; i < q->size; i++) {
+		td = &q->td[i];
+		memset(td, 0, sizeof(*td));
+		td->qt_next = cpu_to_hc32(i + 1 < q->size ?
+					  (uint32_t)(td + 1) :
+					  QT_NEXT_TERMINATE);
+		td->qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+		td->qt_token = cpu_to_hc32((q->elsize << 16) | (3 << 10) |
+					   (1 << 8) | 0x80);
+		ehci_td_buffer(td, q->buf + i * q->elsize, q->elsize);
+	}
+	dma_map_range(q->buf, q->size * q->elsize, DMA_MAP_FROM_DEVICE);
+	ehci_flush_dcache(q->td, q->size * sizeof(struct qTD));
+
+	/* the overlay is idle now; only its data toggle is kept */
+	ehci_invalidate_dcache(&q->qh, sizeof(q->qh));
+	toggle = hc32_to_cpu(q->qh.qh_overlay.qt_token) & (1 << 31);
+	q->qh.qh_overlay.qt_token = cpu_to_hc32(toggle);
+	q->qh.qh_overlay.qt_altnext = cpu_to_hc32(QT_NEXT_TERMINATE);
+	q->qh.qh_overlay.qt_next = cpu_to_hc32((uint32_t)&q->td[0]);
+	ehci_flush_dcache(&q->qh, sizeof(q->qh));
+	q->pos = 0;
+}
+
+struct int_queue *create_int_queue(struct usb_device *dev,
+				   unsigned long pipe, int queuesize,
+				   int elementsize, void *buffer)
+{
+	struct int_queue *q;
+	uint32_t endpt, cmd, cmask;
+
+	if (queuesize < 1 || queuesize > EHCI_INT_QUEUE_MAX ||
+	    elementsize > 4096) {
+		debug("interrupt queue of %d x %d bytes\n", queuesize,
+		      elementsize);
+		return NULL;
+	}
+
+	if (!ehci_periodic) {
+		ehci_periodic = memalign(4096, EHCI_PERIODIC_FRAMES * 4);
+		if (!ehci_periodic)
+			return NULL;
+	}
+
+	/* one page: no descriptor may cross a 4 KiB boundary */
+	q = memalign(4096, sizeof(*q));
+	if (!q)
+		return NULL;
+	memset(q, 0, sizeof(*q));
+	q->buf = memalign(ARCH_DMA_MINALIGN,
+			  ALIGN(queuesize * elementsize, ARCH_DMA_MINALIGN));
+	if (!q->buf) {
+		free(q);
+		return NULL;
+	}
+	q->dest = buffer;
+	q->size = queuesize;
+	q->elsize = elementsize;
+
+	/* the data toggle stays in the QH: DTC is clear */
+	endpt = (usb_maxpacket(dev, pipe) << 16) |
+	    (usb_pipespeed(pipe) << 12) |
+	    (usb_pipeendpoint(pipe) << 8) | (usb_pipedevice(pipe) << 0);
+	q->qh.qh_endpt1 = cpu_to_hc32(endpt);
+	/* start split in microframe 0, complete splits in 2 to 4 */
+	cmask = usb_pipespeed(pipe) != USB_SPEED_HIGH ? 0x1c : 0;
+	endpt = (1 << 30) |
+	    (dev->portnr << 23) |
+	    (dev->parent->devnum << 16) | (cmask << 8) | (0x01 << 0);
+	q->qh.qh_endpt2 = cpu_to_hc32(endpt);
+	q->qh.qh_curtd = cpu_to_hc32(QT_NEXT_TERMINATE);
+	q->qh.qh_overlay.qt_token = cpu_to_hc32(usb_gettoggle(dev,
+			usb_pipeendpoint(pipe), usb_pipeout(pipe)) << 31);
+	q->qh.qh_link = cpu_to_hc32(ehci_int_queues ?
+				    (uint32_t)&ehci_int_queues->qh |
+				    QH_LINK_TYPE_QH : QH_LINK_TERMINATE);
+	ehci_flush_dcache(&q->qh, sizeof(q->qh));
+	ehci_int_arm(q);
+
+	if (!ehci_periodic_running) {
+		ehci_int_link_head(NULL);
+		ehci_writel(&hcor->or_periodiclistbase, (uint32_t)ehci_periodic);
+		cmd = ehci_readl(&hcor->or_usbcmd);
+		ehci_writel(&hcor->or_usbcmd, cmd | CMD_PSE);
+		if (handshake((uint32_t *)&hcor->or_usbsts, STS_PSS, STS_PSS,
+			      100 * 1000) < 0) {
+			printf("EHCI fail timeout STS_PSS set\n");
+			free(q->buf);
+			free(q);
+			return NULL;
+		}
+		ehci_periodic_running = 1;
+	}
+
+	q->next = ehci_int_queues;
+	ehci_int_queues = q;
+	ehci_int_link_head(q);
+
+	return q;
+}
+
+/* The next element that came in, copied to the buffer, or NULL */
+void *poll_int_queue(struct usb_device *dev, struct int_queue *q)
+{
+	struct qTD *td = &q->td[q->pos];
+	uint32_t token;
+	void *dest;
+
+	ehci_invalidate_dcache(td, sizeof(*td));
+	token = hc32_to_cpu(td->qt_token);
+	if (token & 0x80)
+		return NULL;
+
+	dest = q->dest + q->pos * q->elsize;
+	if (token & 0x7c) {
+		/* halted, the rest of the queue with it */
+		debug("interrupt qTD token=%#x\n", token);
+		dev->irq_status = USB_ST_CRC_ERR;
+		dev->irq_act_len = 0;
+		ehci_int_arm(q);
+		return NULL;
+	}
+
+	dma_unmap_range(q->buf + q->pos * q->elsize, q->elsize,
+			DMA_MAP_FROM_DEVICE);
+	memcpy(dest, q->buf + q->pos * q->elsize, q->elsize);
+	dev->irq_status = 0;
+	dev->irq_act_len = q->elsize - ((token >> 16) & 0x7fff);
+
+	if (++q->pos == q->size)
+		ehci_int_arm(q);
+
+	return dest;
+}
+
+int destroy_int_queue(struct usb_device *dev, struct int_queue *q)
+{
+	struct int_queue *prev;
+
+	if (ehci_int_queues == q) {
+		ehci_int_queues = q->next;
+		ehci_int_link_head(q->next);
+	} else {
+		for (prev = ehci_int_queues; prev && prev->next != q;
+		     prev = prev->next)
+			;
+		if (!prev)
+			return -1;
+		prev->next = q->next;
+		prev->qh.qh_link = q->qh.qh_link;
+		ehci_flush_dcache(&prev->qh, sizeof(prev->qh));
+	}
+
+	/* the controller reads the schedule anew each frame */
+	wait_ms(2);
+
+	free(q->buf);
+	free(q);
+	return 0;
+}
+#endif /* CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE */
+
 int usb_lowlevel_stop(void)
 {
+	uint32_t cmd;
+
+	if (ehci_async_running) {
+		/* Disable async schedule. */
+		cmd = ehci_readl(&hcor->or_usbcmd);
+		cmd &= ~CMD_ASE;
+		ehci_writel(&hcor->or_usbcmd, cmd);
+		if (handshake((uint32_t *)&hcor->or_usbsts, STD_ASS, 0,
+			      100 * 1000) < 0)
+			printf("EHCI fail timeout STD_ASS reset\n");
+		ehci_async_running = 0;
+	}
+
+#ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
+	if (ehci_periodic_running) {
+		cmd = ehci_readl(&hcor->or_usbcmd);
+		ehci_writel(&hcor->or_usbcmd, cmd & ~CMD_PSE);
+		if (handshake((uint32_t *)&hcor->or_usbsts, STS_PSS, 0,
+			      100 * 1000) < 0)
+			printf("EHCI fail timeout STS_PSS reset\n");
+		ehci_periodic_running = 0;
+	}
+	/* the devices are gone, and their queues with them */
+	while (ehci_int_queues) {
+		struct int_queue *q = ehci_int_queues;
+
+		ehci_int_queues = q->next;
+		free(q->buf);
+		free(q);
+	}
+#endif
+
 	return ehci_hcd_stop();
 }
 
@@ -810,6 +1202,7 @@ int usb_lowlevel_init(void)
 {
 	uint32_t reg;
 	uint32_t cmd;
+	int i;
 
 	if (ehci_hcd_init() != 0)
 		return -1;
@@ -823,6 +1216,17 @@ int usb_lowlevel_init(void)
 		return -1;
 #endif
 
+	for (i = 0; i < EHCI_XFERS; i++) {
+		memset(&ehci_xfer[i], 0, sizeof(ehci_xfer[i]));
+		ehci_xfer[i].desc = &ehci_desc[i];
+	}
+	ehci_async_running = 0;
+	ehci_advance = NULL;
+	ehci_queued = NULL;
+#ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
+	ehci_periodic_running = 0;
+#endif
+
 	/* Set head of reclaim list */
 	memset(&qh_list, 0, sizeof(qh_list));
 	qh_list.qh_link = cpu_to_hc32((uint32_t)&qh_list | QH_LINK_TYPE_QH);
@@ -63,13 +63,15 @@ struct ehci_hcor {
 #define CMD_PARK_CNT(c)	(((c) >> 8) & 3)	/* how many transfers to park */
 #define CMD_ASE		(1 << 5)		/* async schedule enable */
 #define CMD_LRESET	(1 << 7)		/* partial reset */
-#define CMD_IAAD	(1 << 5)		/* "doorbell" interrupt */
+#define CMD_IAAD	(1 << 6)		/* "doorbell" interrupt */
 #define CMD_PSE		(1 << 4)		/* periodic schedule enable */
 #define CMD_RESET	(1 << 1)		/* reset HC not bus */
 #define CMD_RUN		(1 << 0)		/* start/stop HC */
 	uint32_t or_usbsts;
 #define	STD_ASS		(1 << 15)
+#define STS_PSS		(1 << 14)		/* periodic schedule status */
 #define STS_HALT	(1 << 12)
+#define STS_IAA		(1 << 5)		/* async advance */
 	uint32_t or_usbintr;
 #define INTR_UE         (1 << 0)                /* USB interrupt enable */
 #define INTR_UEE        (1 << 1)                /* USB error interrupt enable */
@@ -160,8 +162,8 @@ struct usb_linux_config_descriptor {
  * IMPORTANT: Software must ensure that no interface data structure
  * reachable by the EHCI host controller spans a 4K page boundary!
  *
- * Periodic transfers (i.e. isochronous and interrupt transfers) are
- * not supported.
+ * Isochronous transfers are not supported, interrupt transfers are in
+ * the periodic schedule only with CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE.
  */
 
 /* Queue Element Transfer Descriptor (qTD). */
@@ -412,6 +412,35 @@ static void ohci_dump(ohci_t *controller, int verbose)
 
 /* get a transfer request */
 
+/*
+ * Bytes of a bulk buffer one TD can take: a TD may cross one page
+ * boundary, so it reaches up to the end of the next page.
+ */
+static int ohci_td_len(const void *data, int len)
+{
+	int max = 8192 - ((unsigned long)data & 4095);
+
+	return len < max ? len : max;
+}
+
+/* TDs a bulk transfer of len bytes at data is split into */
+static int ohci_bulk_td_count(const void *data, int len)
+{
+	int n, cnt = 1;
+
+	while (len > (n = ohci_td_len(data, len))) {
+		data += n;
+		len -= n;
+		cnt++;
+	}
+	return cnt;
+}
+
+int usb_max_xfer_len(struct usb_device *dev)
+{
+	return CONFIG_OHCI_TD_COUNT * OHCI_TD_MIN_XFER;
+}
+
 int sohci_submit_job(urb_priv_t *urb, struct devrequest *setup)
 {
 	ohci_t *ohci;
@@ -446,8 +475,8 @@ int sohci_submit_job(urb_priv_t *urb, struct devrequest *setup)
 
 	/* for the private part of the URB we need the number of TDs (size) */
 	switch (usb_pipetype(pipe)) {
-	case PIPE_BULK: /* one TD for every 4096 Byte */
-		size = (transfer_len - 1) / 4096 + 1;
+	case PIPE_BULK: /* one TD for every page or two */
+		size = ohci_bulk_td_count(buffer, transfer_len);
 		break;
 	case PIPE_CONTROL:/* 1 TD for setup, 1 for ACK and 1 for every 4096 B */
 		size = (transfer_len == 0)? 2:
@@ -880,7 +909,7 @@ static void td_submit_job(struct usb_device *dev, unsigned long pipe,
 	ohci_t *ohci = &gohci;
 	int data_len = transfer_len;
 	void *data;
-	int cnt = 0;
+	int cnt = 0, n;
 	__u32 info = 0;
 	unsigned int toggle = 0;
 
@@ -903,10 +932,10 @@ static void td_submit_job(struct usb_device *dev, unsigned long pipe,
 	case PIPE_BULK:
 		info = usb_pipeout(pipe)?
 			TD_CC | TD_DP_OUT : TD_CC | TD_DP_IN ;
-		while (data_len > 4096) {
+		while (data_len > (n = ohci_td_len(data, data_len))) {
 			td_fill(ohci, info | (cnt? TD_T_TOGGLE:toggle),
-				data, 4096, dev, cnt, urb);
-			data += 4096; data_len -= 4096; cnt++;
+				data, n, dev, cnt, urb);
+			data += n; data_len -= n; cnt++;
 		}
 		info = usb_pipeout(pipe)?
 			TD_CC | TD_DP_OUT : TD_CC | TD_R | TD_DP_IN ;
@@ -1493,7 +1522,7 @@ int submit_common_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 {
 	int stat = 0;
 	int maxsize = usb_maxpacket(dev, pipe);
-	int timeout;
+	ulong start, timeout;
 	urb_priv_t *urb;
 
 	urb = malloc(sizeof(urb_priv_t));
@@ -1515,8 +1544,6 @@ int submit_common_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 	urb->actual_length = 0;
 	pkt_print(urb, dev, pipe, buffer, transfer_len,
 		  setup, "SUB", usb_pipein(pipe));
-#else
-	wait_ms(1);
 #endif
 	if (!maxsize) {
 		err("submit_common_message: pipesize for pipe %lx is zero",
@@ -1534,9 +1561,10 @@ int submit_common_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 	/* ohci_dump_status(&gohci); */
 #endif
 
+	start = get_timer(0);
 	timeout = USB_TIMEOUT_MS(pipe);
 
-	/* wait for it to complete */
+	/* wait for it to complete, polling the done queue */
 	for (;;) {
 		/* check whether the controller is done */
 		stat = hc_interrupt();
@@ -1559,8 +1587,7 @@ int submit_common_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			break;
 		}
 
-		if (--timeout) {
-			wait_ms(1);
+		if (get_timer(start) < timeout) {
 			if (!urb->finished)
 				dbg("*");
 
@@ -1579,8 +1606,6 @@ int submit_common_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 #ifdef DEBUG
 	pkt_print(urb, dev, pipe, buffer, transfer_len,
 		  setup, "RET(ctlr)", usb_pipein(pipe));
-#else
-	wait_ms(1);
 #endif
 
 	/* free TDs in urb_priv */
@@ -1830,7 +1855,6 @@ static int hc_interrupt(void)
 	}
 
 	if (ints & OHCI_INTR_WDH) {
-		wait_ms(1);
 		ohci_writel(OHCI_INTR_WDH, &regs->intrdisable);
 		(void)ohci_readl(&regs->intrdisable); /* flush */
 		stat = dl_done_list(&gohci);
@@ -1916,6 +1940,7 @@ int usb_lowlevel_init(void)
 		return -1;
 	}
 	ptd = gtd;
+	td_next = 0;
 	gohci.hcca = phcca;
 	memset(phcca, 0, sizeof(struct ohci_hcca));
 
@@ -392,8 +392,17 @@ struct virt_root_hub {
 #define RH_A_NOCP	(1 << 12)		/* no over current protection */
 #define RH_A_POTPGT	(0xff << 24)		/* power on to power good time */
 
-/* urb */
-#define N_URB_TD 48
+/* data TDs one bulk transfer may use; each takes 4 KiB at least */
+#ifndef CONFIG_OHCI_TD_COUNT
+#define CONFIG_OHCI_TD_COUNT	128
+#endif
+#if CONFIG_OHCI_TD_COUNT > 250
+#error CONFIG_OHCI_TD_COUNT must fit td->index
+#endif
+#define OHCI_TD_MIN_XFER	4096
+
+/* urb: the data TDs, a setup and a status TD */
+#define N_URB_TD (CONFIG_OHCI_TD_COUNT + 3)
 typedef struct
 {
 	ed_t *ed;
@@ -458,28 +467,32 @@ static ed_t * ep_add_ed(struct usb_device * usb_dev, unsigned long pipe,
 
 /*-------------------------------------------------------------------------*/
 
-/* we need more TDs than EDs */
-#define NUM_TD 64
+/* one transfer, plus a dummy TD per ED and the interrupt transfers */
+#define NUM_TD (N_URB_TD + 16)
 
 /* +1 so we can align the storage */
 td_t gtd[NUM_TD+1];
 /* pointers to aligned storage */
 td_t *ptd;
+/* where td_alloc() looks first: after the TD it handed out last */
+static int td_next;
 
 /* TDs ... */
 static inline struct td *
 td_alloc (struct usb_device *usb_dev)
 {
-	int i;
+	int i, n;
 	struct td	*td;
 
 	td = NULL;
 	for (i = 0; i < NUM_TD; i++)
 	{
-		if (ptd[i].usb_dev == NULL)
+		n = (td_next + i) % NUM_TD;
+		if (ptd[n].usb_dev == NULL)
 		{
-			td = &ptd[i];
+			td = &ptd[n];
 			td->usb_dev = usb_dev;
+			td_next = n + 1;
 			break;
 		}
 	}
@@ -136,6 +136,12 @@ void write_fifo(u8 ep, u32 length, void *fifo_data)
 	/* select the endpoint index */
 	writeb(ep, &musbr->index);
 
+	/* a word at a time where the buffer allows it, the rest bytewise */
+	if (!((ulong)data & 3)) {
+		for (; length >= 4; length -= 4, data += 4)
+			writel(*(u32 *)data, &musbr->fifox[ep]);
+	}
+
 	/* write the data to the fifo */
 	while (length--)
 		writeb(*data++, &musbr->fifox[ep]);
@@ -161,6 +167,11 @@ void read_fifo(u8 ep, u32 length, void *fifo_data)
 	/* select the endpoint index */
 	writeb(ep, &musbr->index);
 
+	if (!((ulong)data & 3)) {
+		for (; length >= 4; length -= 4, data += 4)
+			*(u32 *)data = readl(&musbr->fifox[ep]);
+	}
+
 	/* read the data to the fifo */
 	while (length--)
 		*data++ = readb(&musbr->fifox[ep]);
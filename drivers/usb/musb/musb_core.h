@@ -339,6 +339,23 @@ struct musb_epinfo {
 	u16	epsize;	/* endpoint FIFO size	*/
 };
 
+/*
+ * Inventra HSDMA controller, behind the core registers.  A channel is
+ * run in mode 0: one packet per transfer.
+ */
+#define MUSB_HSDMA_BASE			0x200
+#define MUSB_HSDMA_INTR			(MUSB_HSDMA_BASE + 0)
+#define MUSB_HSDMA_CONTROL(ch)		(MUSB_HSDMA_BASE + 4 + ((ch) << 4))
+#define MUSB_HSDMA_ADDRESS(ch)		(MUSB_HSDMA_BASE + 8 + ((ch) << 4))
+#define MUSB_HSDMA_COUNT(ch)		(MUSB_HSDMA_BASE + 0xc + ((ch) << 4))
+
+#define MUSB_HSDMA_ENABLE		0x0001
+#define MUSB_HSDMA_TRANSMIT		0x0002
+#define MUSB_HSDMA_IRQENABLE		0x0008
+#define MUSB_HSDMA_ENDPOINT_SHIFT	4
+#define MUSB_HSDMA_BUSERROR		0x0100
+#define MUSB_HSDMA_BURST_INCR16		0x0600
+
 /*
  * Platform specific MUSB configuration. Any platform using the musb
  * functionality should create one instance of this structure in the
@@ -23,6 +23,9 @@
 
 #include <common.h>
 #include "musb_hcd.h"
+#ifdef CONFIG_USB_INVENTRA_DMA
+#include <dma_map.h>
+#endif
 
 /* MSC control transfers */
 #define USB_MSC_BBB_RESET 	0xFF
@@ -340,6 +343,67 @@ static u8 wait_until_rxep_ready(struct usb_device *dev, u8 ep)
 	return 1;
 }
 
+#ifdef CONFIG_USB_INVENTRA_DMA
+/* Packets shorter than this are cheaper to move through the FIFO */
+#ifndef CONFIG_USB_INVENTRA_DMA_MIN
+# define CONFIG_USB_INVENTRA_DMA_MIN 64
+#endif
+#define MUSB_DMA_CHANNEL 0
+
+/*
+ * Whether a bulk packet can go by DMA: an IN buffer must not share
+ * cache lines with anything else, the channel needs word alignment.
+ */
+static int musb_dma_usable(const void *buf, u32 len, int dir_out)
+{
+	if (len < CONFIG_USB_INVENTRA_DMA_MIN)
+		return 0;
+	if (dir_out)
+		return !((ulong)buf & 3);
+	return !((ulong)buf & (ARCH_DMA_MINALIGN - 1)) &&
+	       !(len & (ARCH_DMA_MINALIGN - 1));
+}
+
+/*
+ * Moves one packet between buf and the FIFO of ep with the HSDMA
+ * controller; returns 0, or -1 on a bus error or timeout.
+ */
+static int musb_dma_packet(u8 ep, void *buf, u32 len, int dir_out)
+{
+	u8 *base = (u8 *)musbr;
+	int timeout = CONFIG_MUSB_TIMEOUT;
+	u16 control;
+	int ret = 0;
+
+	dma_map_range(buf, len, dir_out ? DMA_MAP_TO_DEVICE :
+					  DMA_MAP_FROM_DEVICE);
+
+	/* a completion left over is cleared by reading the interrupts */
+	readb(base + MUSB_HSDMA_INTR);
+	writel((ulong)buf, base + MUSB_HSDMA_ADDRESS(MUSB_DMA_CHANNEL));
+	writel(len, base + MUSB_HSDMA_COUNT(MUSB_DMA_CHANNEL));
+	control = MUSB_HSDMA_ENABLE | MUSB_HSDMA_IRQENABLE |
+		  MUSB_HSDMA_BURST_INCR16 | (ep << MUSB_HSDMA_ENDPOINT_SHIFT);
+	if (dir_out)
+		control |= MUSB_HSDMA_TRANSMIT;
+	writew(control, base + MUSB_HSDMA_CONTROL(MUSB_DMA_CHANNEL));
+
+	while (!(readb(base + MUSB_HSDMA_INTR) & (1 << MUSB_DMA_CHANNEL))) {
+		control = readw(base + MUSB_HSDMA_CONTROL(MUSB_DMA_CHANNEL));
+		if ((control & MUSB_HSDMA_BUSERROR) || !--timeout) {
+			ret = -1;
+			break;
+		}
+		udelay(1);
+	}
+	writew(0, base + MUSB_HSDMA_CONTROL(MUSB_DMA_CHANNEL));
+
+	if (!dir_out)
+		dma_unmap_range(buf, len, DMA_MAP_FROM_DEVICE);
+	return ret;
+}
+#endif
+
 /*
  * This function performs the setup phase of the control transfer
  */
@@ -1012,6 +1076,22 @@ int submit_bulk_msg(struct usb_device *dev, unsigned long pipe,
 			writew(nextlen, &musbr->txcount);
 #endif
 
+#ifdef CONFIG_USB_INVENTRA_DMA
+			if (musb_dma_usable((u8 *)buffer + txlen, nextlen, 1)) {
+				csr = readw(&musbr->txcsr);
+				csr &= ~(MUSB_TXCSR_AUTOSET | MUSB_TXCSR_DMAMODE);
+				writew(csr | MUSB_TXCSR_DMAENAB, &musbr->txcsr);
+				if (musb_dma_packet(MUSB_BULK_EP,
+						(u8 *)buffer + txlen,
+						nextlen, 1)) {
+					writew(csr, &musbr->txcsr);
+					dev->status = USB_ST_BUF_ERR;
+					dev->act_len = txlen;
+					return 0;
+				}
+				writew(csr, &musbr->txcsr);
+			} else
+#endif
 			/* Write the data to the FIFO */
 			write_fifo(MUSB_BULK_EP, nextlen,
 					(void *)(((u8 *)buffer) + txlen));
@@ -1066,6 +1146,25 @@ int submit_bulk_msg(struct usb_device *dev, unsigned long pipe,
 				return 0;
 			}
 
+#ifdef CONFIG_USB_INVENTRA_DMA
+			/* a short packet is left to the FIFO reads */
+			if (readw(&musbr->rxcount) == nextlen &&
+			    musb_dma_usable((u8 *)buffer + txlen, nextlen, 0)) {
+				csr = readw(&musbr->rxcsr);
+				csr &= ~(MUSB_RXCSR_AUTOCLEAR | MUSB_RXCSR_DMAMODE);
+				writew(csr | MUSB_RXCSR_DMAENAB, &musbr->rxcsr);
+				if (musb_dma_packet(MUSB_BULK_EP,
+						(u8 *)buffer + txlen,
+						nextlen, 0)) {
+					csr &= ~MUSB_RXCSR_RXPKTRDY;
+					writew(csr, &musbr->rxcsr);
+					dev->status = USB_ST_BUF_ERR;
+					dev->act_len = txlen;
+					return 0;
+				}
+				writew(csr, &musbr->rxcsr);
+			} else
+#endif
 			/* Read the data from the FIFO */
 			read_fifo(MUSB_BULK_EP, nextlen,
 					(void *)(((u8 *)buffer) + txlen));
@@ -96,6 +96,17 @@
  *				the hardware register of the graphic
  *				chip. Otherwise a blinking field is
  *				displayed.
+ *
+ * CONFIG_VIDEO_HW_PAN:	      - Scroll by moving the start of the
+ *				picture through video_hw_pan() of the
+ *				graphic driver, as long as the frame
+ *				buffer memory lasts, instead of copying
+ *				the console up.  Needs pGD->memSize and
+ *				no logo above the console.
+ *
+ * CONFIG_VIDEO_DIRTY_ROWS:   - Without VIDEO_HW_BITBLT, copy and clear
+ *				only the part of each console row that
+ *				has been drawn on when scrolling.
  */
 
 #include <common.h>
@@ -213,10 +224,6 @@
 #include <watchdog.h>
 #include <bmp_layout.h>
 
-#ifdef CONFIG_SPLASH_SCREEN_ALIGN
-#define BMP_ALIGN_CENTER	0x7FFF
-#endif
-
 #endif
 
 /*
@@ -366,6 +373,17 @@ static GraphicDevice *pGD;	/* Pointer to Graphic array */
 static void *video_fb_address;	/* frame buffer address */
 static void *video_console_address;	/* console buffer start address */
 
+#ifdef CONFIG_VIDEO_HW_PAN
+static void *video_pan_base;	/* frame buffer memory to pan over */
+static int video_pan_lines;	/* lines of it, 0 when not panning */
+static int video_pan_y;		/* first line shown */
+#endif
+
+#if defined(CONFIG_VIDEO_DIRTY_ROWS) && !defined(VIDEO_HW_BITBLT)
+#define VIDEO_DIRTY
+static ushort *console_used;	/* columns drawn on, per console row */
+#endif
+
 static int video_logo_height = VIDEO_LOGO_HEIGHT;
 
 static int __maybe_unused cursor_state;
@@ -430,11 +448,63 @@ static const int video_font_draw_table32[16][4] = {
 	{0x00ffffff, 0x00ffffff, 0x00ffffff, 0x00ffffff}
 };
 
+#ifdef VIDEO_DIRTY
+/* Note that the console rows under width pixels from xx, yy are in use */
+static void console_dirty(int xx, int yy, int width)
+{
+	int row, last, cols;
+
+	if (!console_used)
+		return;
+
+	yy -= video_logo_height;
+	if (yy + VIDEO_FONT_HEIGHT <= 0)
+		return;
+	row = max(yy, 0) / VIDEO_FONT_HEIGHT;
+	last = min((yy + VIDEO_FONT_HEIGHT - 1) / VIDEO_FONT_HEIGHT,
+		   CONSOLE_ROWS - 1);
+	cols = min((xx + width + VIDEO_FONT_WIDTH - 1) / VIDEO_FONT_WIDTH,
+		   CONSOLE_COLS);
+
+	for (; row <= last; row++)
+		if (console_used[row] < cols)
+			console_used[row] = cols;
+}
+
+/* For pictures drawn by other means */
+static void console_dirty_all(void)
+{
+	int row;
+
+	if (console_used)
+		for (row = 0; row < CONSOLE_ROWS; row++)
+			console_used[row] = CONSOLE_COLS;
+}
+
+/* Bytes of a line of the frame buffer that cols columns take up */
+static int console_used_len(int cols)
+{
+	if (cols >= CONSOLE_COLS)
+		return VIDEO_LINE_LEN;
+	return cols * VIDEO_FONT_WIDTH * VIDEO_PIXEL_SIZE;
+}
+#else
+static inline void console_dirty(int xx, int yy, int width)
+{
+}
+
+static inline void console_dirty_all(void)
+{
+}
+#endif
+
 static void video_drawchars(int xx, int yy, unsigned char *s, int count)
 {
 	u8 *cdat, *dest, *dest0;
 	int rows, offset, c;
 
+	console_dirty(xx, yy, count * VIDEO_FONT_WIDTH);
+
 	offset = yy * VIDEO_LINE_LEN + xx * VIDEO_PIXEL_SIZE;
 	dest0 = video_fb_address + offset;
 
@@ -617,6 +687,8 @@ static void video_invertchar(int xx, int yy)
 	int firsty = yy * VIDEO_LINE_LEN;
 	int lasty = (yy + VIDEO_FONT_HEIGHT) * VIDEO_LINE_LEN;
 	int x, y;
+
+	console_dirty(xx, yy, VIDEO_FONT_WIDTH);
 	for (y = firsty; y < lasty; y += VIDEO_LINE_LEN) {
 		for (x = firstx; x < lastx; x++) {
 			u8 *dest = (u8 *)(video_fb_address) + x + y;
@@ -667,7 +739,7 @@ void console_cursor(int state)
 }
 #endif
 
-#ifndef VIDEO_HW_RECTFILL
+#if !defined(VIDEO_HW_RECTFILL) || defined(CONFIG_VIDEO_HW_PAN)
 static void memsetl(int *p, int c, int v)
 {
 	while (c--)
@@ -675,7 +747,7 @@ static void memsetl(int *p, int c, int v)
 }
 #endif
 
-#ifndef VIDEO_HW_BITBLT
+#if !defined(VIDEO_HW_BITBLT) || defined(CONFIG_VIDEO_HW_PAN)
 static void memcpyl(int *d, int *s, int c)
 {
 	while (c--)
@@ -683,8 +755,93 @@ static void memcpyl(int *d, int *s, int c)
 }
 #endif
 
+#ifdef CONFIG_VIDEO_HW_PAN
+int __video_hw_pan(unsigned int y)
+{
+	return -1;
+}
+int video_hw_pan(unsigned int y)
+	__attribute__ ((weak, alias("__video_hw_pan")));
+
+static void video_pan_init(void)
+{
+	int lines = pGD->memSize / VIDEO_LINE_LEN;
+
+	video_pan_lines = 0;
+	if (video_logo_height || lines < VIDEO_ROWS + VIDEO_FONT_HEIGHT)
+		return;
+	if (video_hw_pan(0))
+		return;
+
+	video_pan_base = video_fb_address;
+	video_pan_lines = lines;
+	video_pan_y = 0;
+}
+
+/* Show the next console row instead of copying the others up */
+static void console_pan(void)
+{
+	if (video_pan_y + VIDEO_ROWS + VIDEO_FONT_HEIGHT > video_pan_lines) {
+		/* at the end of the memory, back to the start once */
+		memcpyl(video_pan_base, CONSOLE_ROW_SECOND,
+			CONSOLE_SCROLL_SIZE >> 2);
+		video_pan_y = 0;
+	} else {
+		video_pan_y += VIDEO_FONT_HEIGHT;
+	}
+
+	video_fb_address = video_pan_base + video_pan_y * VIDEO_LINE_LEN;
+	video_console_address = video_fb_address;
+
+	/* the new row and what is below the console */
+	memsetl(CONSOLE_ROW_LAST, (VIDEO_SIZE - CONSOLE_SCROLL_SIZE) >> 2,
+		CONSOLE_BG_COL);
+	video_hw_pan(video_pan_y);
+}
+#endif /* CONFIG_VIDEO_HW_PAN */
+
+#ifdef VIDEO_DIRTY
+/* Copy up only as much of each row as the two rows have drawn on */
+static void console_copy_dirty(void)
+{
+	uchar *dst = CONSOLE_ROW_FIRST;
+	int row, line, len;
+
+	for (row = 0; row < CONSOLE_ROWS - 1; row++) {
+		len = console_used_len(max(console_used[row],
+					   console_used[row + 1]));
+		for (line = 0; len && line < VIDEO_FONT_HEIGHT; line++)
+			memcpyl((int *)(dst + line * VIDEO_LINE_LEN),
+				(int *)(dst + CONSOLE_ROW_SIZE +
+					line * VIDEO_LINE_LEN), len >> 2);
+		console_used[row] = console_used[row + 1];
+		dst += CONSOLE_ROW_SIZE;
+	}
+}
+
+#ifndef VIDEO_HW_RECTFILL
+static void console_clear_dirty(void)
+{
+	uchar *dst = CONSOLE_ROW_LAST;
+	int line, len;
+
+	len = console_used_len(console_used[CONSOLE_ROWS - 1]);
+	for (line = 0; len && line < VIDEO_FONT_HEIGHT; line++)
+		memsetl((int *)(dst + line * VIDEO_LINE_LEN), len >> 2,
+			CONSOLE_BG_COL);
+}
+#endif
+#endif /* VIDEO_DIRTY */
+
 static void console_scrollup(void)
 {
+#ifdef CONFIG_VIDEO_HW_PAN
+	if (video_pan_lines) {
+		console_pan();
+		return;
+	}
+#endif
+
 	/* copy up rows ignoring the first one */
 
 #ifdef VIDEO_HW_BITBLT
@@ -700,8 +857,13 @@ static void console_scrollup(void)
 			- VIDEO_FONT_HEIGHT	/* frame height */
 		);
 #else
-	memcpyl(CONSOLE_ROW_FIRST, CONSOLE_ROW_SECOND,
-		CONSOLE_SCROLL_SIZE >> 2);
+#ifdef VIDEO_DIRTY
+	if (console_used)
+		console_copy_dirty();
+	else
+#endif
+		memcpyl(CONSOLE_ROW_FIRST, CONSOLE_ROW_SECOND,
+			CONSOLE_SCROLL_SIZE >> 2);
 #endif
 
 	/* clear the last one */
@@ -715,7 +877,17 @@ static void console_scrollup(void)
 			  CONSOLE_BG_COL	/* fill color */
 		);
 #else
-	memsetl(CONSOLE_ROW_LAST, CONSOLE_ROW_SIZE >> 2, CONSOLE_BG_COL);
+#ifdef VIDEO_DIRTY
+	if (console_used)
+		console_clear_dirty();
+	else
+#endif
+		memsetl(CONSOLE_ROW_LAST, CONSOLE_ROW_SIZE >> 2,
+			CONSOLE_BG_COL);
+#endif
+#ifdef VIDEO_DIRTY
+	if (console_used)
+		console_used[CONSOLE_ROWS - 1] = 0;
 #endif
 }
 
@@ -878,11 +1050,6 @@ static inline void fill_555rgb_pswap(uchar *fb, int x, u8 r, u8 g, u8 b)
 }
 #endif
 
-/*
- * RLE8 bitmap support
- */
-
-#ifdef CONFIG_VIDEO_BMP_RLE8
 /* Pre-calculated color table entry */
 struct palette {
 	union {
@@ -891,6 +1058,82 @@ struct palette {
 	} ce;				/* color entry */
 };
 
+/*
+ * Turn the color table of a bitmap into frame buffer pixels, for the
+ * 15, 16 and 32 bit formats; -1 for the others.
+ */
+static int video_bmp_palette(bmp_image_t *img, int ncolors, struct palette *p)
+{
+	bmp_color_table_entry_t cte;
+	int green_shift, red_off;
+	int i;
+
+	switch (VIDEO_DATA_FORMAT) {
+	case GDF_15BIT_555RGB:
+	case GDF_16BIT_565RGB:
+		if (VIDEO_DATA_FORMAT == GDF_15BIT_555RGB) {
+			green_shift = 3;
+			red_off = 10;
+		} else {
+			green_shift = 2;
+			red_off = 11;
+		}
+		for (i = 0; i < ncolors; i++) {
+			cte = img->color_table[i];
+			p[i].ce.w = SWAP16((unsigned short)
+					   (((cte.red >> 3) << red_off) |
+					    ((cte.green >> green_shift) << 5) |
+					    cte.blue >> 3));
+		}
+		return 0;
+	case GDF_32BIT_X888RGB:
+		for (i = 0; i < ncolors; i++) {
+			cte = img->color_table[i];
+			p[i].ce.dw = SWAP32((cte.red << 16) |
+					    (cte.green << 8) |
+					     cte.blue);
+		}
+		return 0;
+	}
+	return -1;
+}
+
+#if !defined(VIDEO_FB_16BPP_PIXEL_SWAP)
+/*
+ * 8 bit bitmap, bottom row at fb: one table lookup per pixel for the
+ * formats video_bmp_palette() knows, -1 for the others.
+ */
+static int video_display_bitmap8(bmp_image_t *img, uchar *fb, uchar *bmap,
+				 int pitch, int width, int height)
+{
+	struct palette p[256];
+	int x, y;
+
+	if (video_bmp_palette(img, 256, p))
+		return -1;
+
+	for (y = 0; y < height; y++) {
+		uchar *src = bmap + y * pitch;
+		uchar *dst = fb - y * VIDEO_LINE_LEN;
+
+		WATCHDOG_RESET();
+		if (VIDEO_PIXEL_SIZE == 2)
+			for (x = 0; x < width; x++)
+				((ushort *)dst)[x] = p[src[x]].ce.w;
+		else
+			for (x = 0; x < width; x++)
+				((u32 *)dst)[x] = p[src[x]].ce.dw;
+	}
+	return 0;
+}
+#endif
+
+/*
+ * RLE8 bitmap support
+ */
+
+#ifdef CONFIG_VIDEO_BMP_RLE8
+
 /*
  * Helper to draw encoded/unencoded run.
  */
@@ -910,8 +1153,11 @@ static void draw_bitmap(uchar **fb, uchar *bm, struct palette *p,
 
 	switch (VIDEO_DATA_FORMAT) {
 	case GDF__8BIT_INDEX:
-		for (i = 0; i < cnt; i++)
-			*(unsigned char *) addr++ = bm[*off];
+		if (enc)
+			memset((void *) addr, bm[1], cnt);
+		else
+			memcpy((void *) addr, bm, cnt);
+		addr += cnt;
 		break;
 	case GDF_15BIT_555RGB:
 	case GDF_16BIT_565RGB:
@@ -941,7 +1187,6 @@ static int display_rle8_bitmap(bmp_image_t *img, int xoff, int yoff,
 	int x, y, bpp, i, ncolors;
 	struct palette p[256];
 	bmp_color_table_entry_t cte;
-	int green_shift, red_off;
 	int limit = VIDEO_COLS * VIDEO_ROWS;
 	int pixels = 0;
 
@@ -955,39 +1200,12 @@ static int display_rle8_bitmap(bmp_image_t *img, int xoff, int yoff,
 	bm = (uchar *) img + __le32_to_cpu(img->header.data_offset);
 
 	/* pre-calculate and setup palette */
-	switch (VIDEO_DATA_FORMAT) {
-	case GDF__8BIT_INDEX:
+	if (VIDEO_DATA_FORMAT == GDF__8BIT_INDEX) {
 		for (i = 0; i < ncolors; i++) {
 			cte = img->color_table[i];
 			video_set_lut(i, cte.red, cte.green, cte.blue);
 		}
-		break;
-	case GDF_15BIT_555RGB:
-	case GDF_16BIT_565RGB:
-		if (VIDEO_DATA_FORMAT == GDF_15BIT_555RGB) {
-			green_shift = 3;
-			red_off = 10;
-		} else {
-			green_shift = 2;
-			red_off = 11;
-		}
-		for (i = 0; i < ncolors; i++) {
-			cte = img->color_table[i];
-			p[i].ce.w = SWAP16((unsigned short)
-					   (((cte.red >> 3) << red_off) |
-					    ((cte.green >> green_shift) << 5) |
-					    cte.blue >> 3));
-		}
-		break;
-	case GDF_32BIT_X888RGB:
-		for (i = 0; i < ncolors; i++) {
-			cte = img->color_table[i];
-			p[i].ce.dw = SWAP32((cte.red << 16) |
-					    (cte.green << 8) |
-					     cte.blue);
-		}
-		break;
-	default:
+	} else if (video_bmp_palette(img, ncolors, p)) {
 		printf("RLE Bitmap unsupported in video mode 0x%x\n",
 		       VIDEO_DATA_FORMAT);
 		return -1;
@@ -1094,6 +1312,7 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 #ifdef CONFIG_VIDEO_BMP_GZIP
 	unsigned char *dst = NULL;
 	ulong len;
+	int ret;
 #endif
 
 	WATCHDOG_RESET();
@@ -1103,8 +1322,14 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 
 #ifdef CONFIG_VIDEO_BMP_GZIP
 		/*
-		 * Could be a gzipped bmp image, try to decrompress...
+		 * Could be a gzipped bmp image, show it as it is unpacked
 		 */
+		ret = bmp_display_gz(bmp_image, x, y, VIDEO_VISIBLE_COLS,
+				     VIDEO_VISIBLE_ROWS, video_display_bitmap);
+		if (ret >= 0)
+			return ret;
+
+		/* RLE8, unpack all of it */
 		len = CONFIG_SYS_VIDEO_LOGO_MAX_SIZE;
 		dst = malloc(CONFIG_SYS_VIDEO_LOGO_MAX_SIZE);
 		if (dst == NULL) {
@@ -1184,6 +1409,8 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 	if ((y + height) > VIDEO_VISIBLE_ROWS)
 		height = VIDEO_VISIBLE_ROWS - y;
 
+	console_dirty_all();
+
 	bmap = (uchar *) bmp + le32_to_cpu(bmp->header.data_offset);
 	fb = (uchar *) (video_fb_address +
 			((y + height - 1) * VIDEO_COLS * VIDEO_PIXEL_SIZE) +
@@ -1234,7 +1461,6 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 		break;
 
 	case 8:
-		padded_line -= width;
 		if (VIDEO_DATA_FORMAT == GDF__8BIT_INDEX) {
 			/* Copy colormap */
 			for (xcount = 0; xcount < colors; ++xcount) {
@@ -1242,21 +1468,19 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 				video_set_lut(xcount, cte.red, cte.green,
 					      cte.blue);
 			}
+			/* same format: whole rows, bottom up */
+			bmp_blit(fb, -VIDEO_LINE_LEN, bmap, padded_line,
+				 width, height);
+			break;
 		}
+#if !defined(VIDEO_FB_16BPP_PIXEL_SWAP)
+		if (video_display_bitmap8(bmp, fb, bmap, padded_line,
+					  width, height) == 0)
+			break;
+#endif
+		padded_line -= width;
 		ycount = height;
 		switch (VIDEO_DATA_FORMAT) {
-		case GDF__8BIT_INDEX:
-			while (ycount--) {
-				WATCHDOG_RESET();
-				xcount = width;
-				while (xcount--) {
-					*fb++ = *bmap++;
-				}
-				bmap += padded_line;
-				fb -= (VIDEO_VISIBLE_COLS + width) *
-							VIDEO_PIXEL_SIZE;
-			}
-			break;
 		case GDF__8BIT_332RGB:
 			while (ycount--) {
 				WATCHDOG_RESET();
@@ -1340,6 +1564,14 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 		}
 		break;
 	case 24:
+#ifdef VIDEO_FB_LITTLE_ENDIAN
+		if (VIDEO_DATA_FORMAT == GDF_24BIT_888RGB) {
+			/* same byte order as the bitmap */
+			bmp_blit(fb, -VIDEO_LINE_LEN, bmap, padded_line,
+				 3 * width, height);
+			break;
+		}
+#endif
 		padded_line -= 3 * width;
 		ycount = height;
 		switch (VIDEO_DATA_FORMAT) {
@@ -1743,6 +1975,20 @@ static int video_init(void)
 	video_console_address = video_fb_address;
 #endif
 
+#ifdef CONFIG_VIDEO_HW_PAN
+	video_pan_init();
+#endif
+#ifdef VIDEO_DIRTY
+	/* whatever is on the screen may be drawn on everywhere */
+	free(console_used);
+	console_used = NULL;
+#ifdef CONFIG_VIDEO_HW_PAN
+	if (!video_pan_lines)
+#endif
+		console_used = malloc(CONSOLE_ROWS * sizeof(*console_used));
+	console_dirty_all();
+#endif
+
 	/* Initialize the console */
 	console_col = 0;
 	console_row = 0;
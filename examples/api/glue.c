@@ -307,6 +307,60 @@ int ub_dev_read(int handle, void *buf, lbasize_t len, lbastart_t start,
 	return err;
 }
 
+int ub_dev_readv(int handle, struct stor_vec *vec, int n, lbasize_t *rlen)
+{
+	struct device_info *di;
+	lbasize_t act_len;
+	int err = 0;
+
+	if (!dev_stor_valid(handle))
+		return API_ENODEV;
+
+	di = &devices[handle];
+	if (!syscall(API_DEV_READV, &err, di, vec, n, &act_len))
+		return API_ESYSC;
+
+	if (!err && rlen)
+		*rlen = act_len;
+
+	return err;
+}
+
+int ub_dev_read_submit(int handle, struct stor_vec *vec, int n)
+{
+	struct device_info *di;
+	int err = 0;
+
+	if (!dev_stor_valid(handle))
+		return API_ENODEV;
+
+	di = &devices[handle];
+	if (!syscall(API_DEV_READ_SUBMIT, &err, di, vec, n))
+		return API_ESYSC;
+
+	return err;
+}
+
+/* Returns 0 with *done clear while the submitted read is in progress */
+int ub_dev_read_poll(int handle, int *done, lbasize_t *rlen)
+{
+	struct device_info *di;
+	lbasize_t act_len = 0;
+	int err = 0;
+
+	if (!dev_stor_valid(handle))
+		return API_ENODEV;
+
+	di = &devices[handle];
+	if (!syscall(API_DEV_READ_POLL, &err, di, done, &act_len))
+		return API_ESYSC;
+
+	if (*done && rlen)
+		*rlen = act_len;
+
+	return err;
+}
+
 static int dev_net_valid(int handle)
 {
 	if (!dev_valid(handle))
@@ -73,6 +73,12 @@ int			ub_dev_open(int handle);
 int			ub_dev_close(int handle);
 int			ub_dev_read(int handle, void *buf, lbasize_t len,
 				lbastart_t start, lbasize_t *rlen);
+int			ub_dev_readv(int handle, struct stor_vec *vec, int n,
+				lbasize_t *rlen);
+int			ub_dev_read_submit(int handle, struct stor_vec *vec,
+				int n);
+int			ub_dev_read_poll(int handle, int *done,
+				lbasize_t *rlen);
 int			ub_dev_send(int handle, void *buf, int len);
 int			ub_dev_recv(int handle, void *buf, int len, int *rlen);
 struct device_info *	ub_dev_get(int);
@@ -48,6 +48,49 @@ extern flash_info_t flash_info[];
 #define PART_OFFSET(x)	(x->offset)
 #endif
 
+/*
+ * Paths resolved lately, and the blocks of single-block files (symbolic
+ * links, scripts) decompressed lately.  Larger files are not kept, that
+ * would cost a copy of every block for data that is read only once.
+ * Both are dropped when another image, or a changed superblock, is seen.
+ */
+#define CRAMFS_LOOKUP_CACHE	8
+#define CRAMFS_LOOKUP_PATH	64
+#define CRAMFS_BLOCK_CACHE	4
+#define CRAMFS_BLOCK_SIZE	4096
+
+static struct cramfs_lookup {
+	unsigned long offset;		/* of the inode, 0 if unused */
+	int raw;
+	char path[CRAMFS_LOOKUP_PATH];
+} lookup_cache[CRAMFS_LOOKUP_CACHE];
+static int lookup_next;
+
+static struct cramfs_block {
+	unsigned long src;		/* of the compressed block, 0 if unused */
+	int size;
+	char data[CRAMFS_BLOCK_SIZE];
+} block_cache[CRAMFS_BLOCK_CACHE];
+static int block_next;
+
+static unsigned long cache_begin;
+static struct cramfs_super cache_super;
+
+/* Compressed blocks are copied out of flash in one go before inflating */
+static char zbuf[CRAMFS_BLOCK_SIZE + CRAMFS_BLOCK_SIZE / 8];
+
+static void cramfs_cache_check (unsigned long begin)
+{
+	if (begin == cache_begin &&
+	    !memcmp (&super, &cache_super, sizeof (super)))
+		return;
+
+	memset (lookup_cache, 0, sizeof (lookup_cache));
+	memset (block_cache, 0, sizeof (block_cache));
+	cache_begin = begin;
+	cache_super = super;
+}
+
 static int cramfs_read_super (struct part_info *info)
 {
 	unsigned long root_offset;
@@ -75,6 +118,8 @@ static int cramfs_read_super (struct part_info *info)
 		return -1;
 	}
 
+	cramfs_cache_check (PART_OFFSET(info));
+
 	/* Check that the root inode is in a sane state */
 	if (!S_ISDIR (CRAMFS_16 (super.root.mode))) {
 		printf ("cramfs: root is not a directory\n");
@@ -156,6 +201,68 @@ static unsigned long cramfs_resolve (unsigned long begin, unsigned long offset,
 	return 0;
 }
 
+/* cramfs_resolve() from the root, through the cache */
+static unsigned long cramfs_lookup (unsigned long begin, char *path, int raw)
+{
+	struct cramfs_lookup *l;
+	unsigned long offset;
+	char key[CRAMFS_LOOKUP_PATH];
+	int keep = strlen (path) < CRAMFS_LOOKUP_PATH;
+	int i;
+
+	if (keep) {
+		for (i = 0; i < CRAMFS_LOOKUP_CACHE; i++) {
+			l = &lookup_cache[i];
+			if (l->offset && l->raw == raw && !strcmp (l->path, path))
+				return l->offset;
+		}
+		strcpy (key, path);
+	}
+
+	offset = cramfs_resolve (begin, CRAMFS_GET_OFFSET (&(super.root)) << 2,
+				 CRAMFS_24 (super.root.size), raw,
+				 strtok (path, "/"));
+
+	if (keep && offset && offset != (unsigned long)-1) {
+		l = &lookup_cache[lookup_next];
+		lookup_next = (lookup_next + 1) % CRAMFS_LOOKUP_CACHE;
+		l->offset = offset;
+		l->raw = raw;
+		strcpy (l->path, key);
+	}
+	return offset;
+}
+
+static int cramfs_uncompress_cached (void *dst, unsigned long src, int srclen,
+				     int keep)
+{
+	struct cramfs_block *b;
+	int size, i;
+
+	for (i = 0; keep && i < CRAMFS_BLOCK_CACHE; i++) {
+		b = &block_cache[i];
+		if (b->src == src) {
+			memcpy (dst, b->data, b->size);
+			return b->size;
+		}
+	}
+
+	if (srclen <= sizeof (zbuf)) {
+		memcpy (zbuf, (void *) src, srclen);
+		size = cramfs_uncompress_block (dst, zbuf, srclen);
+	} else
+		size = cramfs_uncompress_block (dst, (void *) src, srclen);
+
+	if (keep && size >= 0 && size <= CRAMFS_BLOCK_SIZE) {
+		b = &block_cache[block_next];
+		block_next = (block_next + 1) % CRAMFS_BLOCK_CACHE;
+		b->src = src;
+		b->size = size;
+		memcpy (b->data, dst, size);
+	}
+	return size;
+}
+
 static int cramfs_uncompress (unsigned long begin, unsigned long offset,
 			      unsigned long loadoffset)
 {
@@ -165,16 +272,18 @@ static int cramfs_uncompress (unsigned long begin, unsigned long offset,
 	unsigned long curr_block = (CRAMFS_GET_OFFSET (inode) +
 				    (((CRAMFS_24 (inode->size)) +
 				      4095) >> 12)) << 2;
+	int blocks = (CRAMFS_24 (inode->size) + 4095) >> 12;
 	int size, total_size = 0;
 	int i;
 
-	cramfs_uncompress_init ();
+	if (cramfs_uncompress_init ())
+		return -1;
 
-	for (i = 0; i < ((CRAMFS_24 (inode->size) + 4095) >> 12); i++) {
-		size = cramfs_uncompress_block ((void *) loadoffset,
-						(void *) (begin + curr_block),
-						(CRAMFS_32 (block_ptrs[i]) -
-						 curr_block));
+	for (i = 0; i < blocks; i++) {
+		size = cramfs_uncompress_cached ((void *) loadoffset,
+						 begin + curr_block,
+						 (CRAMFS_32 (block_ptrs[i]) -
+						  curr_block), blocks == 1);
 		if (size < 0)
 			return size;
 		loadoffset += size;
@@ -182,7 +291,6 @@ static int cramfs_uncompress (unsigned long begin, unsigned long offset,
 		curr_block = CRAMFS_32 (block_ptrs[i]);
 	}
 
-	cramfs_uncompress_exit ();
 	return total_size;
 }
 
@@ -193,10 +301,7 @@ int cramfs_load (char *loadoffset, struct part_info *info, char *filename)
 	if (cramfs_read_super (info))
 		return -1;
 
-	offset = cramfs_resolve (PART_OFFSET(info),
-				 CRAMFS_GET_OFFSET (&(super.root)) << 2,
-				 CRAMFS_24 (super.root.size), 0,
-				 strtok (filename, "/"));
+	offset = cramfs_lookup (PART_OFFSET(info), filename, 0);
 
 	if (offset <= 0)
 		return offset;
@@ -268,10 +373,7 @@ int cramfs_ls (struct part_info *info, char *filename)
 		size = CRAMFS_24 (super.root.size);
 	} else {
 		/* Resolve the path */
-		offset = cramfs_resolve (PART_OFFSET(info),
-					 CRAMFS_GET_OFFSET (&(super.root)) <<
-					 2, CRAMFS_24 (super.root.size), 1,
-					 strtok (filename, "/"));
+		offset = cramfs_lookup (PART_OFFSET(info), filename, 1);
 
 		if (offset <= 0)
 			return offset;
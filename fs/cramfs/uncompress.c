@@ -25,7 +25,12 @@
 #include <watchdog.h>
 #include <u-boot/zlib.h>
 
+/*
+ * The inflate state, with its 32 KiB window, is set up on first use and
+ * kept; every block only resets it.
+ */
 static z_stream stream;
+static int stream_ready;
 
 void *zalloc(void *, unsigned, unsigned);
 void zfree(void *, void *, unsigned);
@@ -59,6 +64,9 @@ int cramfs_uncompress_init (void)
 {
 	int err;
 
+	if (stream_ready)
+		return 0;
+
 	stream.zalloc = zalloc;
 	stream.zfree = zfree;
 	stream.next_in = 0;
@@ -76,11 +84,14 @@ int cramfs_uncompress_init (void)
 		return -1;
 	}
 
+	stream_ready = 1;
 	return 0;
 }
 
 int cramfs_uncompress_exit (void)
 {
-	inflateEnd (&stream);
+	if (stream_ready)
+		inflateEnd (&stream);
+	stream_ready = 0;
 	return 0;
 }
@@ -26,6 +26,7 @@
 #include <common.h>
 #include <ext2fs.h>
 #include <malloc.h>
+#include <mem_pool.h>
 #include <asm/byteorder.h>
 
 extern int ext2fs_devread (int sector, int byte_offset, int byte_len,
@@ -64,6 +65,15 @@ extern int ext2fs_devread (int sector, int byte_offset, int byte_len,
 /* The size of an ext2 block in bytes.  */
 #define EXT2_BLOCK_SIZE(data)	   (1 << LOG2_BLOCK_SIZE(data))
 
+/* Group descriptors are bigger than ext2_block_group with this feature.  */
+#define EXT4_FEATURE_INCOMPAT_64BIT	0x0080
+
+/* Inode flag: the block array holds the root of an extent tree.  */
+#define EXT4_EXTENTS_FL		0x00080000
+#define EXT4_EXT_MAGIC		0xF30A
+/* Extents longer than this are allocated but not yet written.  */
+#define EXT4_EXT_INIT_MAX_LEN	32768
+
 /* The ext2 superblock.  */
 struct ext2_sblock {
 	uint32_t total_inodes;
@@ -101,6 +111,27 @@ struct ext2_sblock {
 	char volume_name[16];
 	char last_mounted_on[64];
 	uint32_t compression_info;
+	uint8_t prealloc_blocks;
+	uint8_t prealloc_dir_blocks;
+	uint16_t reserved_gdt_blocks;
+	uint8_t journal_uuid[16];
+	uint32_t journal_inode;
+	uint32_t journal_dev;
+	uint32_t last_orphan;
+	uint32_t hash_seed[4];
+	uint8_t default_hash_version;
+	uint8_t journal_backup_type;
+	uint16_t descriptor_size;
+	uint32_t default_mount_opts;
+	uint32_t first_meta_bg;
+	uint32_t mkfs_time;
+	uint32_t journal_blocks[17];
+	uint32_t blocks_count_hi;
+	uint32_t reserved_blocks_hi;
+	uint32_t free_blocks_hi;
+	uint16_t min_extra_isize;
+	uint16_t want_extra_isize;
+	uint32_t flags;
 };
 
 /* The ext2 blockgroup.  */
@@ -144,6 +175,61 @@ struct ext2_inode {
 	uint32_t osd2[3];
 };
 
+/* The ext4 extent tree, rooted in the block array of the inode.  */
+struct ext4_extent_header {
+	uint16_t magic;
+	uint16_t entries;
+	uint16_t max;
+	uint16_t depth;		/* 0 if the entries are extents */
+	uint32_t generation;
+};
+
+struct ext4_extent_idx {
+	uint32_t block;		/* first file block covered */
+	uint32_t leaf_lo;	/* tree block of the next level */
+	uint16_t leaf_hi;
+	uint16_t unused;
+};
+
+struct ext4_extent {
+	uint32_t block;		/* first file block */
+	uint16_t len;
+	uint16_t start_hi;
+	uint32_t start_lo;	/* first disk block */
+};
+
+#ifdef CONFIG_EXT2_DIR_INDEX
+/* Directories with EXT2_INDEX_FL hash their entries into a b-tree.  */
+#define EXT2_FEATURE_COMPAT_DIR_INDEX	0x0020
+#define EXT2_INDEX_FL			0x00001000
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
+#define DX_HASH_LEGACY		0
+#define DX_HASH_HALF_MD4	1
+#define DX_HASH_TEA		2
+#define DX_HASH_UNSIGNED	3	/* added to the above */
+
+/* Follows the "." and ".." entries in the first directory block.  */
+struct dx_root_info {
+	uint32_t reserved_zero;
+	uint8_t hash_version;
+	uint8_t info_length;	/* 8 */
+	uint8_t indirect_levels;
+	uint8_t unused_flags;
+};
+
+/* The first entry has no hash and holds the limit and count instead.  */
+struct dx_entry {
+	uint32_t hash;
+	uint32_t block;
+};
+
+struct dx_countlimit {
+	uint16_t limit;
+	uint16_t count;
+};
+#endif
+
 /* The header of an ext2 directory entry.  */
 struct ext2_dirent {
 	uint32_t inode;
@@ -157,6 +243,10 @@ struct ext2fs_node {
 	struct ext2_inode inode;
 	int ino;
 	int inode_read;
+	/* Last extent found in the extent tree, unused if ext_len is 0 */
+	uint32_t ext_block;
+	uint32_t ext_len;
+	uint32_t ext_start;
 };
 
 /* Information about a "mounted" ext2 filesystem.  */
@@ -171,6 +261,16 @@ typedef struct ext2fs_node *ext2fs_node_t;
 
 struct ext2_data *ext2fs_root = NULL;
 ext2fs_node_t ext2fs_file = NULL;
+
+/*
+ * A path lookup allocates and frees a node for every component, and an
+ * ls for every entry; only a handful are alive at any time.
+ */
+#ifndef CONFIG_SYS_EXT2_NODE_POOL
+#define CONFIG_SYS_EXT2_NODE_POOL	16
+#endif
+struct mem_pool ext2fs_node_pool = MEM_POOL_INIT(sizeof(struct ext2fs_node),
+		CONFIG_SYS_EXT2_NODE_POOL, sizeof(long));
 int symlinknest = 0;
 uint32_t *indir1_block = NULL;
 int indir1_size = 0;
@@ -178,7 +278,11 @@ int indir1_blkno = -1;
 uint32_t *indir2_block = NULL;
 int indir2_size = 0;
 int indir2_blkno = -1;
+uint32_t *ext4_tree_block = NULL;
+int ext4_tree_size = 0;
+int ext4_tree_blkno = -1;
 static unsigned int inode_size;
+static unsigned int desc_size;
 
 
 static int ext2fs_blockgroup
@@ -187,11 +291,11 @@ static int ext2fs_blockgroup
 	unsigned int blkoff;
 	unsigned int desc_per_blk;
 
-	desc_per_blk = EXT2_BLOCK_SIZE(data) / sizeof(struct ext2_block_group);
+	desc_per_blk = EXT2_BLOCK_SIZE(data) / desc_size;
 
 	blkno = __le32_to_cpu(data->sblock.first_data_block) + 1 +
 	group / desc_per_blk;
-	blkoff = (group % desc_per_blk) * sizeof(struct ext2_block_group);
+	blkoff = (group % desc_per_blk) * desc_size;
 #ifdef DEBUG
 	printf ("ext2fs read %d group descriptor (blkno %d blkoff %d)\n",
 		group, blkno, blkoff);
@@ -245,8 +349,110 @@ static int ext2fs_read_inode
 
 void ext2fs_free_node (ext2fs_node_t node, ext2fs_node_t currroot) {
 	if ((node != &ext2fs_root->diropen) && (node != currroot)) {
-		free (node);
+		mem_pool_free (&ext2fs_node_pool, node);
+	}
+}
+
+
+/*
+ * Look a file block up in the extent tree of an ext4 inode.  The extent
+ * found is kept in the node, so a sequential read only walks the tree
+ * once per extent.
+ */
+static int ext4fs_read_block (ext2fs_node_t node, uint32_t fileblock) {
+	struct ext2_data *data = node->data;
+	struct ext4_extent_header *eh;
+	struct ext4_extent *ext;
+	int blksz = EXT2_BLOCK_SIZE (data);
+	int log2_blksz = LOG2_EXT2_BLOCK_SIZE (data);
+	int entries, i;
+
+	if (node->ext_len && fileblock - node->ext_block < node->ext_len) {
+		return (node->ext_start + (fileblock - node->ext_block));
+	}
+
+	eh = (struct ext4_extent_header *) node->inode.b.blocks.dir_blocks;
+	while (1) {
+		struct ext4_extent_idx *idx;
+		int leaf;
+
+		if (__le16_to_cpu (eh->magic) != EXT4_EXT_MAGIC) {
+			printf ("** ext4fs bad extent header. **\n");
+			return (-1);
+		}
+		entries = __le16_to_cpu (eh->entries);
+		if (eh->depth == 0) {
+			break;
+		}
+		if (entries == 0) {
+			return (0);
+		}
+
+		/* Last index that starts at or before the block.  */
+		idx = (struct ext4_extent_idx *) (eh + 1);
+		for (i = 1; i < entries; i++) {
+			if (__le32_to_cpu (idx[i].block) > fileblock) {
+				break;
+			}
+		}
+		i--;
+		if (idx[i].leaf_hi) {
+			printf ("** ext4fs doesn't support 48 bit blocks. **\n");
+			return (-1);
+		}
+		leaf = __le32_to_cpu (idx[i].leaf_lo) << log2_blksz;
+
+		if (ext4_tree_block == NULL || blksz != ext4_tree_size) {
+			free (ext4_tree_block);
+			ext4_tree_blkno = -1;
+			ext4_tree_block = (uint32_t *) malloc (blksz);
+			if (ext4_tree_block == NULL) {
+				printf ("** ext4fs read block (tree) malloc failed. **\n");
+				ext4_tree_size = 0;
+				return (-1);
+			}
+			ext4_tree_size = blksz;
+		}
+		if (leaf != ext4_tree_blkno) {
+			if (ext2fs_devread (leaf, 0, blksz,
+					    (char *) ext4_tree_block) == 0) {
+				printf ("** ext4fs read block (tree) failed. **\n");
+				ext4_tree_blkno = -1;
+				return (-1);
+			}
+			ext4_tree_blkno = leaf;
+		}
+		eh = (struct ext4_extent_header *) ext4_tree_block;
+	}
+
+	ext = (struct ext4_extent *) (eh + 1);
+	for (i = 0; i < entries; i++) {
+		uint32_t start = __le32_to_cpu (ext[i].block);
+		uint32_t len = __le16_to_cpu (ext[i].len);
+		int uninit = 0;
+
+		if (len > EXT4_EXT_INIT_MAX_LEN) {
+			len -= EXT4_EXT_INIT_MAX_LEN;
+			uninit = 1;
+		}
+		if (fileblock < start || fileblock - start >= len) {
+			continue;
+		}
+		if (ext[i].start_hi) {
+			printf ("** ext4fs doesn't support 48 bit blocks. **\n");
+			return (-1);
+		}
+		/* Not written yet, reads as zeroes like a hole.  */
+		if (uninit) {
+			return (0);
+		}
+		node->ext_block = start;
+		node->ext_len = len;
+		node->ext_start = __le32_to_cpu (ext[i].start_lo);
+		return (node->ext_start + (fileblock - start));
 	}
+	/* A hole.  */
+	return (0);
 }
 
 
@@ -258,6 +464,10 @@ static int ext2fs_read_block (ext2fs_node_t node, int fileblock) {
 	int log2_blksz = LOG2_EXT2_BLOCK_SIZE (data);
 	int status;
 
+	if (__le32_to_cpu (inode->flags) & EXT4_EXTENTS_FL) {
+		return (ext4fs_read_block (node, fileblock));
+	}
+
 	/* Direct blocks.  */
 	if (fileblock < INDIRECT_BLOCKS) {
 		blknr = __le32_to_cpu (inode->b.blocks.dir_blocks[fileblock]);
@@ -389,6 +599,21 @@ static int ext2fs_read_block (ext2fs_node_t node, int fileblock) {
 }
 
 
+/*
+ * Read a run of whole blocks collected by ext2fs_read_file().  The run is
+ * emptied on return.
+ */
+static int ext2fs_read_run (int *run_sect, int *run_len, char **run_buf) {
+	int status = 1;
+
+	if (*run_len) {
+		status = ext2fs_devread (*run_sect, 0, *run_len, *run_buf);
+		*run_len = 0;
+	}
+	return (status);
+}
+
+
 int ext2fs_read_file
 	(ext2fs_node_t node, int pos, unsigned int len, char *buf) {
 	int i;
@@ -396,6 +621,9 @@ int ext2fs_read_file
 	int log2blocksize = LOG2_EXT2_BLOCK_SIZE (node->data);
 	int blocksize = 1 << (log2blocksize + DISK_SECTOR_BITS);
 	unsigned int filesize = __le32_to_cpu(node->inode.size);
+	int run_sect = 0;
+	int run_len = 0;
+	char *run_buf = NULL;
 
 	/* Adjust len so it we can't read past the end of the file.  */
 	if (len > filesize) {
@@ -432,6 +660,28 @@ int ext2fs_read_file
 			blockend -= skipfirst;
 		}
 
+		/* Whole blocks that follow each other on disk are read with
+		   a single device read, straight into the buffer.  */
+		if (blknr && blockend == blocksize) {
+			if (run_len && blknr != run_sect +
+			    (run_len >> DISK_SECTOR_BITS)) {
+				if (!ext2fs_read_run (&run_sect, &run_len,
+						      &run_buf)) {
+					return (-1);
+				}
+			}
+			if (!run_len) {
+				run_sect = blknr;
+				run_buf = buf;
+			}
+			run_len += blocksize;
+			buf += blocksize;
+			continue;
+		}
+		if (!ext2fs_read_run (&run_sect, &run_len, &run_buf)) {
+			return (-1);
+		}
+
 		/* If the block number is 0 this block is not stored on disk but
 		   is zero filled instead.  */
 		if (blknr) {
@@ -442,14 +692,373 @@ int ext2fs_read_file
 				return (-1);
 			}
 		} else {
-			memset (buf, 0, blocksize - skipfirst);
+			memset (buf, 0, blockend);
 		}
-		buf += blocksize - skipfirst;
+		buf += blockend;
+	}
+	if (!ext2fs_read_run (&run_sect, &run_len, &run_buf)) {
+		return (-1);
 	}
 	return (len);
 }
 
 
+/* Make a node for the inode a directory entry points to.  */
+static ext2fs_node_t ext2fs_dirent_node
+	(ext2fs_node_t diro, struct ext2_dirent *dirent, int *ftype) {
+	ext2fs_node_t fdiro;
+	int type = FILETYPE_UNKNOWN;
+	int status;
+
+	fdiro = mem_pool_alloc (&ext2fs_node_pool);
+	if (!fdiro) {
+		return (NULL);
+	}
+
+	fdiro->data = diro->data;
+	fdiro->ino = __le32_to_cpu (dirent->inode);
+	fdiro->ext_len = 0;
+
+	if (dirent->filetype != FILETYPE_UNKNOWN) {
+		fdiro->inode_read = 0;
+
+		if (dirent->filetype == FILETYPE_DIRECTORY) {
+			type = FILETYPE_DIRECTORY;
+		} else if (dirent->filetype == FILETYPE_SYMLINK) {
+			type = FILETYPE_SYMLINK;
+		} else if (dirent->filetype == FILETYPE_REG) {
+			type = FILETYPE_REG;
+		}
+	} else {
+		/* The filetype can not be read from the dirent, get it from inode */
+
+		status = ext2fs_read_inode (diro->data,
+					    __le32_to_cpu (dirent->inode),
+					    &fdiro->inode);
+		if (status == 0) {
+			mem_pool_free (&ext2fs_node_pool, fdiro);
+			return (NULL);
+		}
+		fdiro->inode_read = 1;
+
+		if ((__le16_to_cpu (fdiro->inode.mode) &
+		     FILETYPE_INO_MASK) == FILETYPE_INO_DIRECTORY) {
+			type = FILETYPE_DIRECTORY;
+		} else if ((__le16_to_cpu (fdiro->inode.mode) &
+			    FILETYPE_INO_MASK) == FILETYPE_INO_SYMLINK) {
+			type = FILETYPE_SYMLINK;
+		} else if ((__le16_to_cpu (fdiro->inode.mode) &
+			    FILETYPE_INO_MASK) == FILETYPE_INO_REG) {
+			type = FILETYPE_REG;
+		}
+	}
+	*ftype = type;
+	return (fdiro);
+}
+
+#ifdef CONFIG_EXT2_DIR_INDEX
+/*
+ * The directory hashes, as in fs/ext4/hash.c of Linux
+ */
+#define DX_DELTA 0x9E3779B9
+
+static void dx_tea_transform (uint32_t buf[4], uint32_t const in[]) {
+	uint32_t sum = 0;
+	uint32_t b0 = buf[0], b1 = buf[1];
+	uint32_t a = in[0], b = in[1], c = in[2], d = in[3];
+	int n = 16;
+
+	do {
+		sum += DX_DELTA;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	} while (--n);
+
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+/* F, G and H are basic MD4 functions: selection, majority, parity */
+#define DX_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define DX_G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define DX_H(x, y, z) ((x) ^ (y) ^ (z))
+
+#define DX_ROUND(f, a, b, c, d, x, s) \
+	(a += f(b, c, d) + x, a = (a << s) | (a >> (32 - s)))
+#define DX_K1 0
+#define DX_K2 013240474631UL
+#define DX_K3 015666365641UL
+
+static void dx_half_md4_transform (uint32_t buf[4], uint32_t const in[8]) {
+	uint32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	/* Round 1 */
+	DX_ROUND(DX_F, a, b, c, d, in[0] + DX_K1,  3);
+	DX_ROUND(DX_F, d, a, b, c, in[1] + DX_K1,  7);
+	DX_ROUND(DX_F, c, d, a, b, in[2] + DX_K1, 11);
+	DX_ROUND(DX_F, b, c, d, a, in[3] + DX_K1, 19);
+	DX_ROUND(DX_F, a, b, c, d, in[4] + DX_K1,  3);
+	DX_ROUND(DX_F, d, a, b, c, in[5] + DX_K1,  7);
+	DX_ROUND(DX_F, c, d, a, b, in[6] + DX_K1, 11);
+	DX_ROUND(DX_F, b, c, d, a, in[7] + DX_K1, 19);
+
+	/* Round 2 */
+	DX_ROUND(DX_G, a, b, c, d, in[1] + DX_K2,  3);
+	DX_ROUND(DX_G, d, a, b, c, in[3] + DX_K2,  5);
+	DX_ROUND(DX_G, c, d, a, b, in[5] + DX_K2,  9);
+	DX_ROUND(DX_G, b, c, d, a, in[7] + DX_K2, 13);
+	DX_ROUND(DX_G, a, b, c, d, in[0] + DX_K2,  3);
+	DX_ROUND(DX_G, d, a, b, c, in[2] + DX_K2,  5);
+	DX_ROUND(DX_G, c, d, a, b, in[4] + DX_K2,  9);
+	DX_ROUND(DX_G, b, c, d, a, in[6] + DX_K2, 13);
+
+	/* Round 3 */
+	DX_ROUND(DX_H, a, b, c, d, in[3] + DX_K3,  3);
+	DX_ROUND(DX_H, d, a, b, c, in[7] + DX_K3,  9);
+	DX_ROUND(DX_H, c, d, a, b, in[2] + DX_K3, 11);
+	DX_ROUND(DX_H, b, c, d, a, in[6] + DX_K3, 15);
+	DX_ROUND(DX_H, a, b, c, d, in[1] + DX_K3,  3);
+	DX_ROUND(DX_H, d, a, b, c, in[5] + DX_K3,  9);
+	DX_ROUND(DX_H, c, d, a, b, in[0] + DX_K3, 11);
+	DX_ROUND(DX_H, b, c, d, a, in[4] + DX_K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+static uint32_t dx_hack_hash (const char *name, int len, int unsignedchar) {
+	uint32_t hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+	int c;
+
+	while (len--) {
+		if (unsignedchar) {
+			c = (int) *(const unsigned char *) name++;
+		} else {
+			c = (int) *(const signed char *) name++;
+		}
+		hash = hash1 + (hash0 ^ (c * 7152373));
+
+		if (hash & 0x80000000) {
+			hash -= 0x7fffffff;
+		}
+		hash1 = hash0;
+		hash0 = hash;
+	}
+	return (hash0 << 1);
+}
+
+static void dx_str2hashbuf (const char *msg, int len, uint32_t *buf, int num,
+			    int unsignedchar) {
+	uint32_t pad, val;
+	int i, c;
+
+	pad = (uint32_t) len | ((uint32_t) len << 8);
+	pad |= pad << 16;
+
+	val = pad;
+	if (len > num * 4) {
+		len = num * 4;
+	}
+	for (i = 0; i < len; i++) {
+		if (unsignedchar) {
+			c = (int) ((const unsigned char *) msg)[i];
+		} else {
+			c = (int) ((const signed char *) msg)[i];
+		}
+		val = c + (val << 8);
+		if ((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if (--num >= 0) {
+		*buf++ = val;
+	}
+	while (--num >= 0) {
+		*buf++ = pad;
+	}
+}
+
+static uint32_t ext2fs_dirhash (struct ext2_data *data, int version,
+				const char *name, int len) {
+	uint32_t buf[4], in[8];
+	uint32_t hash = 0;
+	int unsignedchar = 0;
+	int i;
+
+	if (version >= DX_HASH_UNSIGNED) {
+		version -= DX_HASH_UNSIGNED;
+		unsignedchar = 1;
+	}
+
+	/* The default seed, unless the superblock has one */
+	buf[0] = 0x67452301;
+	buf[1] = 0xefcdab89;
+	buf[2] = 0x98badcfe;
+	buf[3] = 0x10325476;
+	for (i = 0; i < 4; i++) {
+		if (data->sblock.hash_seed[i]) {
+			for (i = 0; i < 4; i++) {
+				buf[i] = __le32_to_cpu (data->sblock.hash_seed[i]);
+			}
+			break;
+		}
+	}
+
+	switch (version) {
+	case DX_HASH_LEGACY:
+		hash = dx_hack_hash (name, len, unsignedchar);
+		break;
+	case DX_HASH_HALF_MD4:
+		while (len > 0) {
+			dx_str2hashbuf (name, len, in, 8, unsignedchar);
+			dx_half_md4_transform (buf, in);
+			len -= 32;
+			name += 32;
+		}
+		hash = buf[1];
+		break;
+	case DX_HASH_TEA:
+		while (len > 0) {
+			dx_str2hashbuf (name, len, in, 4, unsignedchar);
+			dx_tea_transform (buf, in);
+			len -= 16;
+			name += 16;
+		}
+		hash = buf[0];
+		break;
+	}
+	hash &= ~1;
+	if (hash == 0xfffffffe) {
+		hash = 0xfffffffc;
+	}
+	return (hash);
+}
+
+/*
+ * Look name up through the hash tree of an indexed directory.  Returns
+ * 1 if found, 0 if not, and -1 if the tree can not be used, in which
+ * case the caller falls back to a linear scan.
+ */
+static int ext2fs_dx_lookup (ext2fs_node_t diro, char *name,
+			     ext2fs_node_t * fnode, int *ftype) {
+	struct ext2_data *data = diro->data;
+	int blksz = EXT2_BLOCK_SIZE (data);
+	int namelen = strlen (name);
+	struct dx_root_info *info;
+	struct dx_countlimit *cl;
+	struct dx_entry *entries;
+	char *idxbuf, *leafbuf;
+	uint32_t hash;
+	int version, levels, count, at, lo, hi;
+	int ret = -1;
+
+	idxbuf = malloc (2 * blksz);
+	if (idxbuf == NULL) {
+		return (-1);
+	}
+	leafbuf = idxbuf + blksz;
+
+	if (ext2fs_read_file (diro, 0, blksz, idxbuf) != blksz) {
+		goto out;
+	}
+	info = (struct dx_root_info *) (idxbuf + 24);
+	version = info->hash_version;
+	levels = info->indirect_levels;
+	if (info->reserved_zero || info->info_length != 8 ||
+	    version > DX_HASH_TEA || levels > 1) {
+		goto out;
+	}
+	if (__le32_to_cpu (data->sblock.flags) & EXT2_FLAGS_UNSIGNED_HASH) {
+		version += DX_HASH_UNSIGNED;
+	}
+	hash = ext2fs_dirhash (data, version, name, namelen);
+	entries = (struct dx_entry *) ((char *) info + info->info_length);
+
+	while (1) {
+		cl = (struct dx_countlimit *) entries;
+		count = __le16_to_cpu (cl->count);
+		if (count == 0 || count > __le16_to_cpu (cl->limit)) {
+			goto out;
+		}
+
+		/* Last entry whose hash is not above ours */
+		lo = 1;
+		hi = count - 1;
+		while (lo <= hi) {
+			int mid = (lo + hi) / 2;
+
+			if (__le32_to_cpu (entries[mid].hash) > hash) {
+				hi = mid - 1;
+			} else {
+				lo = mid + 1;
+			}
+		}
+		at = lo - 1;
+
+		if (levels-- == 0) {
+			break;
+		}
+		if (ext2fs_read_file (diro,
+				      (__le32_to_cpu (entries[at].block) &
+				       0x0fffffff) * blksz,
+				      blksz, idxbuf) != blksz) {
+			goto out;
+		}
+		/* Index blocks start with an empty fake entry */
+		entries = (struct dx_entry *) (idxbuf + 8);
+	}
+
+	/* Entries with the same hash may continue in the next leaf */
+	while (1) {
+		int off = 0;
+
+		if (ext2fs_read_file (diro,
+				      (__le32_to_cpu (entries[at].block) &
+				       0x0fffffff) * blksz,
+				      blksz, leafbuf) != blksz) {
+			goto out;
+		}
+		while (off < blksz - (int) sizeof (struct ext2_dirent)) {
+			struct ext2_dirent *dirent =
+				(struct ext2_dirent *) (leafbuf + off);
+			int direntlen = __le16_to_cpu (dirent->direntlen);
+
+			if (direntlen < sizeof (struct ext2_dirent) ||
+			    off + direntlen > blksz) {
+				goto out;
+			}
+			if (dirent->inode && dirent->namelen == namelen &&
+			    !memcmp (dirent + 1, name, namelen)) {
+				*fnode = ext2fs_dirent_node (diro, dirent,
+							     ftype);
+				ret = *fnode ? 1 : -1;
+				goto out;
+			}
+			off += direntlen;
+		}
+
+		if (++at == count) {
+			/* A run of collisions past this index block is rare
+			   enough to leave to the linear scan.  */
+			ret = info->indirect_levels ? -1 : 0;
+			break;
+		}
+		if ((__le32_to_cpu (entries[at].hash) & ~1) != hash) {
+			ret = 0;
+			break;
+		}
+	}
+out:
+	free (idxbuf);
+	return (ret);
+}
+#endif
+
+
 static int ext2fs_iterate_dir (ext2fs_node_t dir, char *name, ext2fs_node_t * fnode, int *ftype)
 {
 	unsigned int fpos = 0;
@@ -467,6 +1076,17 @@ static int ext2fs_iterate_dir (ext2fs_node_t dir, char *name, ext2fs_node_t * fn
 			return (0);
 		}
 	}
+#ifdef CONFIG_EXT2_DIR_INDEX
+	if ((name != NULL) && (fnode != NULL) && (ftype != NULL) &&
+	    (__le32_to_cpu (diro->inode.flags) & EXT2_INDEX_FL) &&
+	    (__le32_to_cpu (diro->data->sblock.feature_compatibility) &
+	     EXT2_FEATURE_COMPAT_DIR_INDEX)) {
+		status = ext2fs_dx_lookup (diro, name, fnode, ftype);
+		if (status >= 0) {
+			return (status);
+		}
+	}
+#endif
 	/* Search the file.  */
 	while (fpos < __le32_to_cpu (diro->inode.size)) {
 		struct ext2_dirent dirent;
@@ -480,7 +1100,7 @@ static int ext2fs_iterate_dir (ext2fs_node_t dir, char *name, ext2fs_node_t * fn
 		if (dirent.namelen != 0) {
 			char filename[dirent.namelen + 1];
 			ext2fs_node_t fdiro;
-			int type = FILETYPE_UNKNOWN;
+			int type;
 
 			status = ext2fs_read_file (diro,
 						   fpos + sizeof (struct ext2_dirent),
@@ -488,53 +1108,12 @@ static int ext2fs_iterate_dir (ext2fs_node_t dir, char *name, ext2fs_node_t * fn
 			if (status < 1) {
 				return (0);
 			}
-			fdiro = malloc (sizeof (struct ext2fs_node));
+			fdiro = ext2fs_dirent_node (diro, &dirent, &type);
 			if (!fdiro) {
 				return (0);
 			}
 
-			fdiro->data = diro->data;
-			fdiro->ino = __le32_to_cpu (dirent.inode);
-
 			filename[dirent.namelen] = '\0';
-
-			if (dirent.filetype != FILETYPE_UNKNOWN) {
-				fdiro->inode_read = 0;
-
-				if (dirent.filetype == FILETYPE_DIRECTORY) {
-					type = FILETYPE_DIRECTORY;
-				} else if (dirent.filetype ==
-					   FILETYPE_SYMLINK) {
-					type = FILETYPE_SYMLINK;
-				} else if (dirent.filetype == FILETYPE_REG) {
-					type = FILETYPE_REG;
-				}
-			} else {
-				/* The filetype can not be read from the dirent, get it from inode */
-
-				status = ext2fs_read_inode (diro->data,
-							    __le32_to_cpu(dirent.inode),
-							    &fdiro->inode);
-				if (status == 0) {
-					free (fdiro);
-					return (0);
-				}
-				fdiro->inode_read = 1;
-
-				if ((__le16_to_cpu (fdiro->inode.mode) &
-				     FILETYPE_INO_MASK) ==
-				    FILETYPE_INO_DIRECTORY) {
-					type = FILETYPE_DIRECTORY;
-				} else if ((__le16_to_cpu (fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_SYMLINK) {
-					type = FILETYPE_SYMLINK;
-				} else if ((__le16_to_cpu (fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_REG) {
-					type = FILETYPE_REG;
-				}
-			}
 #ifdef DEBUG
 			printf ("iterate >%s<\n", filename);
 #endif /* of DEBUG */
@@ -551,7 +1130,7 @@ static int ext2fs_iterate_dir (ext2fs_node_t dir, char *name, ext2fs_node_t * fn
 							    __le32_to_cpu (dirent.inode),
 							    &fdiro->inode);
 					if (status == 0) {
-						free (fdiro);
+						mem_pool_free (&ext2fs_node_pool, fdiro);
 						return (0);
 					}
 					fdiro->inode_read = 1;
@@ -574,7 +1153,7 @@ static int ext2fs_iterate_dir (ext2fs_node_t dir, char *name, ext2fs_node_t * fn
 					__le32_to_cpu (fdiro->inode.size),
 					filename);
 			}
-			free (fdiro);
+			mem_pool_free (&ext2fs_node_pool, fdiro);
 		}
 		fpos += __le16_to_cpu (dirent.direntlen);
 	}
@@ -822,6 +1401,12 @@ int ext2fs_close (void
 		indir2_size = 0;
 		indir2_blkno = -1;
 	}
+	if (ext4_tree_block != NULL) {
+		free (ext4_tree_block);
+		ext4_tree_block = NULL;
+		ext4_tree_size = 0;
+		ext4_tree_blkno = -1;
+	}
 	return (0);
 }
 
@@ -865,13 +1450,22 @@ int ext2fs_mount (unsigned part_length) {
 	} else {
 		inode_size = __le16_to_cpu(data->sblock.inode_size);
 	}
+	if ((__le32_to_cpu(data->sblock.feature_incompat) &
+	     EXT4_FEATURE_INCOMPAT_64BIT) &&
+	    __le16_to_cpu(data->sblock.descriptor_size)) {
+		desc_size = __le16_to_cpu(data->sblock.descriptor_size);
+	} else {
+		desc_size = sizeof(struct ext2_block_group);
+	}
 #ifdef DEBUG
-	printf("EXT2 rev %d, inode_size %d\n",
-			__le32_to_cpu(data->sblock.revision_level), inode_size);
+	printf("EXT2 rev %d, inode_size %d, desc_size %d\n",
+			__le32_to_cpu(data->sblock.revision_level), inode_size,
+			desc_size);
 #endif
 	data->diropen.data = data;
 	data->diropen.ino = 2;
 	data->diropen.inode_read = 1;
+	data->diropen.ext_len = 0;
 	data->inode = &data->diropen.inode;
 
 	status = ext2fs_read_inode (data, 2, data->inode);
@@ -49,11 +49,132 @@ static unsigned long part_offset = 0;
 
 static int cur_part = 1;
 
+static unsigned long part_size;
+
 #define DOS_PART_TBL_OFFSET	0x1be
 #define DOS_PART_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
 
+#ifdef CONFIG_FAT_DIRCACHE
+/*
+ * Directory entries found by name, so that loading several files from
+ * the same directory does not rescan it and rebuild the long names each
+ * time.  The cache belongs to the mounted volume and is flushed when
+ * that is unmounted or written.
+ */
+struct fat_dircache {
+	__u32		dir;		/* Start cluster of directory, 0 = root */
+	__u32		hash;		/* Hash of name, 0 = unused */
+	char		name[VFAT_MAXLEN_BYTES];
+	dir_entry	dent;
+};
+
+static struct fat_dircache dircache[CONFIG_FAT_DIRCACHE];
+static int dircache_next;
+
+static void fat_dircache_flush (void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_FAT_DIRCACHE; i++)
+		dircache[i].hash = 0;
+	dircache_next = 0;
+}
+
+static __u32 fat_dircache_hash (const char *name)
+{
+	__u32 hash = 0;
+
+	while (*name)
+		hash = hash * 31 + (__u8)*name++;
+	return hash ? hash : 1;
+}
+
+static struct fat_dircache *fat_dircache_find (__u32 dir, const char *name)
+{
+	__u32 hash = fat_dircache_hash(name);
+	int i;
+
+	for (i = 0; i < CONFIG_FAT_DIRCACHE; i++) {
+		if (dircache[i].hash == hash && dircache[i].dir == dir &&
+		    !strcmp(dircache[i].name, name))
+			return &dircache[i];
+	}
+	return NULL;
+}
+
+static int fat_dircache_get (__u32 dir, const char *name, dir_entry *dent)
+{
+	struct fat_dircache *dc = fat_dircache_find(dir, name);
+
+	if (dc == NULL)
+		return -1;
+	debug("dircache hit: %u/%s\n", dir, name);
+	memcpy(dent, &dc->dent, sizeof(dir_entry));
+	return 0;
+}
+
+static void fat_dircache_add (__u32 dir, const char *name,
+			      const dir_entry *dent)
+{
+	struct fat_dircache *dc;
+
+	if (strlen(name) >= VFAT_MAXLEN_BYTES)
+		return;
+
+	dc = fat_dircache_find(dir, name);
+	if (dc == NULL) {
+		dc = &dircache[dircache_next];
+		dircache_next = (dircache_next + 1) % CONFIG_FAT_DIRCACHE;
+	}
+	dc->dir = dir;
+	dc->hash = fat_dircache_hash(name);
+	strcpy(dc->name, name);
+	memcpy(&dc->dent, dent, sizeof(dir_entry));
+}
+#else
+static inline void fat_dircache_flush (void) {}
+static inline int fat_dircache_get (__u32 dir, const char *name,
+				    dir_entry *dent)
+{
+	return -1;
+}
+static inline void fat_dircache_add (__u32 dir, const char *name,
+				     const dir_entry *dent) {}
+#endif /* CONFIG_FAT_DIRCACHE */
+
+/*
+ * The mounted volume.  Its geometry and FAT window are kept from one
+ * command to the next, for as long as fat_register_device() finds the
+ * same device, partition and first sector, fat_mount() the same boot
+ * sector, and nothing else has written to the device or rescanned it.
+ */
+static fsdata fat_mnt;
+static int fat_mnt_valid;
+static block_dev_desc_t *fat_mnt_dev;
+static unsigned long fat_mnt_offset;
+static __u8 fat_mnt_sect0[512];
+static __u8 fat_mnt_pbr[512];
+static int fat_mnt_writing;	/* the writes are our own */
+
+static void fat_umount (void)
+{
+	fat_mnt_valid = 0;
+	fat_dircache_flush();
+}
+
+/* Called through dev_invalidate() when a device changes under us */
+void fat_invalidate (int iftype, int dev)
+{
+	if (fat_mnt_writing || fat_mnt_dev == NULL)
+		return;
+	if (fat_mnt_dev->if_type == iftype && fat_mnt_dev->dev == dev) {
+		fat_umount();
+		fat_mnt_dev = NULL;
+	}
+}
+
 static int disk_read (__u32 startblock, __u32 getsize, __u8 * bufptr)
 {
 	if (cur_dev == NULL)
@@ -71,6 +192,7 @@ static int disk_read (__u32 startblock, __u32 getsize, __u8 * bufptr)
 int fat_register_device (block_dev_desc_t * dev_desc, int part_no)
 {
 	unsigned char buffer[dev_desc->blksz];
+	unsigned long sect0len = sizeof(fat_mnt_sect0);
 
 	if (!dev_desc->block_read)
 		return -1;
@@ -93,6 +215,8 @@ int fat_register_device (block_dev_desc_t * dev_desc, int part_no)
      defined(CONFIG_CMD_SCSI) || \
      defined(CONFIG_CMD_USB) || \
      defined(CONFIG_MMC) || \
+     defined(CONFIG_SANDBOX_BLOCK) || \
+     defined(CONFIG_CMD_AOE) || \
      defined(CONFIG_SYSTEMACE) )
 	{
 		disk_partition_t info;
@@ -100,6 +224,7 @@ int fat_register_device (block_dev_desc_t * dev_desc, int part_no)
 		/* First we assume there is a MBR */
 		if (!get_partition_info(dev_desc, part_no, &info)) {
 			part_offset = info.start;
+			part_size = info.size;
 			cur_part = part_no;
 		} else if ((strncmp((char *)&buffer[DOS_FS_TYPE_OFFSET],
 				    "FAT", 3) == 0) ||
@@ -108,6 +233,7 @@ int fat_register_device (block_dev_desc_t * dev_desc, int part_no)
 			/* ok, we assume we are on a PBR only */
 			cur_part = 1;
 			part_offset = 0;
+			part_size = dev_desc->lba;
 		} else {
 			printf("** Partition %d not valid on device %d **\n",
 				part_no, dev_desc->dev);
@@ -120,6 +246,7 @@ int fat_register_device (block_dev_desc_t * dev_desc, int part_no)
 		/* ok, we assume we are on a PBR only */
 		cur_part = 1;
 		part_offset = 0;
+		part_size = dev_desc->lba;
 	} else {
 		/* FIXME we need to determine the start block of the
 		 * partition where the DOS FS resides. This can be done
@@ -127,9 +254,19 @@ int fat_register_device (block_dev_desc_t * dev_desc, int part_no)
 		 * purpose the libpart must be included.
 		 */
 		part_offset = 32;
+		part_size = dev_desc->lba - part_offset;
 		cur_part = 1;
 	}
 #endif
+
+	/* Keep the mounted volume only if nothing has changed */
+	if (sect0len > dev_desc->blksz)
+		sect0len = dev_desc->blksz;
+	if (dev_desc != fat_mnt_dev || part_offset != fat_mnt_offset ||
+	    memcmp(fat_mnt_sect0, buffer, sect0len)) {
+		fat_umount();
+		memcpy(fat_mnt_sect0, buffer, sect0len);
+	}
 	return 0;
 }
 
@@ -217,10 +354,10 @@ static __u32 get_fatent (fsdata *mydata, __u32 entry)
 		__u32 fatlength = mydata->fatlength;
 		__u32 startblock = bufnum * FATBUFBLOCKS;
 
-		if (getsize > fatlength)
-			getsize = fatlength;
+		/* Do not read past the end of the FAT */
+		if (startblock + getsize > fatlength)
+			getsize = fatlength - startblock;
 
-		fatlength *= mydata->sect_size;	/* We want it in bytes now */
 		startblock += mydata->fat_sect;	/* Offset from start of disk */
 
 		if (disk_read(startblock, getsize, bufptr) < 0) {
@@ -317,83 +454,150 @@ get_cluster (fsdata *mydata, __u32 clustnum, __u8 *buffer,
 }
 
 /*
- * Read at most 'maxsize' bytes from the file associated with 'dentptr'
- * into 'buffer'.
+ * Runs of consecutive clusters of a file, collected by get_extents()
+ */
+#define FAT_EXTENTS	64
+
+typedef struct {
+	__u32	start;		/* First cluster of the run */
+	__u32	count;		/* Number of clusters */
+} fat_extent;
+
+static fat_extent extents[FAT_EXTENTS];
+
+/*
+ * Follow the cluster chain from 'clust' for at most 'nclust' clusters
+ * and merge it into runs of consecutive clusters in extents[], stopping
+ * when FAT_EXTENTS runs are found.  '*next' is set to the cluster after
+ * the last run, or to 0 if the chain ends or is invalid.
+ * Return the number of runs found.
+ */
+static int
+get_extents (fsdata *mydata, __u32 clust, __u32 nclust, __u32 *next)
+{
+	int n = 0;
+
+	extents[0].start = clust;
+	extents[0].count = 1;
+	*next = 0;
+
+	while (--nclust > 0) {
+		__u32 newclust = get_fatent(mydata, clust);
+
+		if (CHECK_CLUST(newclust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", newclust);
+			printf("Invalid FAT entry\n");
+			break;
+		}
+		if (newclust == clust + 1) {
+			extents[n].count++;
+		} else {
+			if (++n == FAT_EXTENTS) {
+				*next = newclust;
+				break;
+			}
+			extents[n].start = newclust;
+			extents[n].count = 1;
+		}
+		clust = newclust;
+	}
+	return n < FAT_EXTENTS ? n + 1 : n;
+}
+
+__attribute__ ((__aligned__ (__alignof__ (dir_entry))))
+__u8 do_fat_read_block[MAX_CLUSTSIZE];
+
+/*
+ * Read at most 'maxsize' bytes from the file associated with 'dentptr',
+ * starting 'pos' bytes into it, into 'buffer'.  The clusters before
+ * 'pos' are only looked up in the FAT; a cluster that 'pos' falls into
+ * is read into do_fat_read_block and the rest of it copied.  The cluster
+ * chain is then mapped to runs of consecutive clusters, each of which
+ * is read with a single disk_read().
  * Return the number of bytes read or -1 on fatal errors.
  */
 static long
-get_contents (fsdata *mydata, dir_entry *dentptr, __u8 *buffer,
-	      unsigned long maxsize)
+get_contents (fsdata *mydata, dir_entry *dentptr, unsigned long pos,
+	      __u8 *buffer, unsigned long maxsize)
 {
 	unsigned long filesize = FAT2CPU32(dentptr->size), gotsize = 0;
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
-	unsigned long actsize;
 
 	debug("Filesize: %ld bytes\n", filesize);
 
+	if (pos >= filesize)
+		return 0;
+	filesize -= pos;
+
 	if (maxsize > 0 && filesize > maxsize)
 		filesize = maxsize;
 
-	debug("%ld bytes\n", filesize);
-
-	actsize = bytesperclust;
-	endclust = curclust;
+	debug("%ld bytes at %ld\n", filesize, pos);
 
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return gotsize;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
-		}
-
-		/* actsize >= file size */
-		actsize -= bytesperclust;
-
-		/* get remaining clusters */
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
+	for (; pos >= bytesperclust; pos -= bytesperclust) {
+		curclust = get_fatent(mydata, curclust);
+		if (CHECK_CLUST(curclust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", curclust);
+			printf("Invalid FAT entry\n");
 			return -1;
 		}
+	}
 
-		/* get remaining bytes */
-		gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
-		actsize = filesize;
-		if (get_cluster(mydata, endclust, buffer, (int)actsize) != 0) {
+	if (pos) {
+		unsigned long actsize = min(bytesperclust - pos, filesize);
+
+		if (get_cluster(mydata, curclust, do_fat_read_block,
+				bytesperclust) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
+		memcpy(buffer, do_fat_read_block + pos, actsize);
 		gotsize += actsize;
-		return gotsize;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		gotsize += (int)actsize;
 		filesize -= actsize;
 		buffer += actsize;
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return gotsize;
+		if (filesize) {
+			curclust = get_fatent(mydata, curclust);
+			if (CHECK_CLUST(curclust, mydata->fatsize)) {
+				debug("curclust: 0x%x\n", curclust);
+				printf("Invalid FAT entry\n");
+				return -1;
+			}
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
+
+	while (filesize > 0) {
+		__u32 nclust = (filesize + bytesperclust - 1) / bytesperclust;
+		int i, n;
+
+		n = get_extents(mydata, curclust, nclust, &curclust);
+
+		for (i = 0; i < n; i++) {
+			unsigned long actsize = extents[i].count * bytesperclust;
+
+			if (actsize > filesize)
+				actsize = filesize;
+
+			debug("extent: cluster %u, %u clusters\n",
+			      extents[i].start, extents[i].count);
+
+			if (get_cluster(mydata, extents[i].start, buffer,
+					actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
+			}
+			gotsize += actsize;
+			filesize -= actsize;
+			buffer += actsize;
+		}
+
+		/* the chain ended early */
+		if (!curclust)
+			break;
+	}
+
+	return gotsize;
 }
 
 #ifdef CONFIG_SUPPORT_VFAT
@@ -548,10 +752,14 @@ static dir_entry *get_dentfromdir (fsdata *mydata, int startsect,
 {
 	__u16 prevcksum = 0xffff;
 	__u32 curclust = START(retdent);
+	__u32 dirclust = curclust;
 	int files = 0, dirs = 0;
 
 	debug("get_dentfromdir: %s\n", filename);
 
+	if (!dols && !fat_dircache_get(dirclust, filename, retdent))
+		return retdent;
+
 	while (1) {
 		dir_entry *dentptr;
 
@@ -678,6 +886,7 @@ static dir_entry *get_dentfromdir (fsdata *mydata, int startsect,
 			}
 
 			memcpy(retdent, dentptr, sizeof(dir_entry));
+			fat_dircache_add(dirclust, filename, retdent);
 
 			debug("DentName: %s", s_name);
 			debug(", start: 0x%x", START(dentptr));
@@ -770,68 +979,102 @@ exit:
 	return ret;
 }
 
-__attribute__ ((__aligned__ (__alignof__ (dir_entry))))
-__u8 do_fat_read_block[MAX_CLUSTSIZE];
-
-long
-do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
-	     int dols)
+/*
+ * Mount the volume on the current device unless it already is.
+ * Return its filesystem data, or NULL on failure.
+ */
+static fsdata *fat_mount (void)
 {
-	char fnamecopy[2048];
+	fsdata *mydata = &fat_mnt;
 	boot_sector bs;
 	volume_info volinfo;
-	fsdata datablock;
-	fsdata *mydata = &datablock;
-	dir_entry *dentptr;
-	__u16 prevcksum = 0xffff;
-	char *subname = "";
-	__u32 cursect;
-	int idx, isdir = 0;
-	int files = 0, dirs = 0;
-	long ret = -1;
-	int firsttime;
-	__u32 root_cluster = 0;
-	int rootdir_size = 0;
-	int j;
+	unsigned long pbrlen = sizeof(fat_mnt_pbr);
+	__u8 *pbr;
+
+	if (cur_dev == NULL) {
+		debug("Error: no device selected\n");
+		return NULL;
+	}
+
+	/*
+	 * The boot sector is read every time: a new image written to the
+	 * partition, or another card, gives another BPB or volume ID
+	 */
+	pbr = malloc(cur_dev->blksz);
+	if (pbr == NULL) {
+		debug("Error: allocating block\n");
+		fat_umount();
+		return NULL;
+	}
+	if (disk_read(0, 1, pbr) != 1) {
+		debug("Error: reading boot sector\n");
+		free(pbr);
+		fat_umount();
+		return NULL;
+	}
+	if (pbrlen > cur_dev->blksz)
+		pbrlen = cur_dev->blksz;
+	if (fat_mnt_valid && fat_mnt_dev == cur_dev &&
+	    fat_mnt_offset == part_offset &&
+	    !memcmp(fat_mnt_pbr, pbr, pbrlen)) {
+		free(pbr);
+		return mydata;
+	}
+	memcpy(fat_mnt_pbr, pbr, pbrlen);
+	free(pbr);
+
+	fat_umount();
 
 	if (read_bootsectandvi(&bs, &volinfo, &mydata->fatsize)) {
 		debug("Error: reading boot sector\n");
-		return -1;
+		return NULL;
 	}
 
 	if (mydata->fatsize == 32) {
-		root_cluster = bs.root_cluster;
+		mydata->root_cluster = bs.root_cluster;
 		mydata->fatlength = bs.fat32_length;
 	} else {
+		mydata->root_cluster = 0;
 		mydata->fatlength = bs.fat_length;
 	}
 
 	mydata->fat_sect = bs.reserved;
+	mydata->fats = bs.fats;
 
-	cursect = mydata->rootdir_sect
-		= mydata->fat_sect + mydata->fatlength * bs.fats;
+	mydata->rootdir_sect = mydata->fat_sect + mydata->fatlength * bs.fats;
 
 	mydata->sect_size = (bs.sector_size[1] << 8) + bs.sector_size[0];
 	mydata->clust_size = bs.cluster_size;
 
 	if (mydata->fatsize == 32) {
+		mydata->rootdir_size = 0;
 		mydata->data_begin = mydata->rootdir_sect -
 					(mydata->clust_size * 2);
 	} else {
-		rootdir_size = ((bs.dir_entries[1]  * (int)256 +
-				 bs.dir_entries[0]) *
-				 sizeof(dir_entry)) /
-				 mydata->sect_size;
+		mydata->rootdir_size = ((bs.dir_entries[1]  * (int)256 +
+					 bs.dir_entries[0]) *
+					 sizeof(dir_entry)) /
+					 mydata->sect_size;
 		mydata->data_begin = mydata->rootdir_sect +
-					rootdir_size -
+					mydata->rootdir_size -
 					(mydata->clust_size * 2);
 	}
 
+	mydata->total_sect = (bs.sectors[1] << 8) + bs.sectors[0];
+	if (mydata->total_sect == 0)
+		mydata->total_sect = bs.total_sect;
+	if (mydata->total_sect == 0)
+		mydata->total_sect = part_size;
+
+	mydata->free_clust = 3;
+
+	free(mydata->fatbuf);
 	mydata->fatbufnum = -1;
+	mydata->fatbuf_dirty = 0;
 	mydata->fatbuf = malloc(FATBUFSIZE);
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
-		return -1;
+		return NULL;
 	}
 
 #ifdef CONFIG_SUPPORT_VFAT
@@ -841,12 +1084,46 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 	       mydata->fatsize, mydata->fat_sect, mydata->fatlength);
 	debug("Rootdir begins at cluster: %d, sector: %d, offset: %x\n"
 	       "Data begins at: %d\n",
-	       root_cluster,
+	       mydata->root_cluster,
 	       mydata->rootdir_sect,
 	       mydata->rootdir_sect * mydata->sect_size, mydata->data_begin);
 	debug("Sector size: %d, cluster size: %d\n", mydata->sect_size,
 	      mydata->clust_size);
 
+	fat_mnt_dev = cur_dev;
+	fat_mnt_offset = part_offset;
+	fat_mnt_valid = 1;
+	return mydata;
+}
+
+static long
+do_fat_read_at (const char *filename, unsigned long pos, void *buffer,
+		unsigned long maxsize, int dols)
+{
+	char fnamecopy[2048];
+	fsdata *mydata;
+	dir_entry *dentptr;
+	dir_entry rootdent;
+	dir_entry dent;		/* outlives the loop through dentptr */
+	__u16 prevcksum = 0xffff;
+	char *subname = "";
+	__u32 cursect;
+	int idx, isdir = 0;
+	int files = 0, dirs = 0;
+	long ret = -1;
+	int firsttime;
+	__u32 root_cluster = 0;
+	int rootdir_size = 0;
+	int j;
+
+	mydata = fat_mount();
+	if (mydata == NULL)
+		return -1;
+
+	cursect = mydata->rootdir_sect;
+	root_cluster = mydata->root_cluster;
+	rootdir_size = mydata->rootdir_size;
+
 	/* "cwd" is always the root... */
 	while (ISDIRDELIM(*filename))
 		filename++;
@@ -872,12 +1149,19 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 		isdir = 1;
 	}
 
+	if (dols != LS_ROOT && !fat_dircache_get(0, fnamecopy, &rootdent)) {
+		dentptr = &rootdent;
+		if (isdir && !(dentptr->attr & ATTR_DIR))
+			goto exit;
+		goto rootdir_done;
+	}
+
 	j = 0;
 	while (1) {
 		int i;
 
 		debug("FAT read sect=%d, clust_size=%d, DIRENTSPERBLOCK=%d\n",
-			cursect, mydata->clust_size, DIRENTSPERBLOCK);
+			cursect, mydata->clust_size, (int)DIRENTSPERBLOCK);
 
 		if (disk_read(cursect,
 				(mydata->fatsize == 32) ?
@@ -1012,6 +1296,8 @@ do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
 			if (isdir && !(dentptr->attr & ATTR_DIR))
 				goto exit;
 
+			fat_dircache_add(0, fnamecopy, dentptr);
+
 			debug("RootName: %s", s_name);
 			debug(", start: 0x%x", START(dentptr));
 			debug(", size:  0x%x %s\n",
@@ -1066,7 +1352,6 @@ rootdir_done:
 	while (isdir) {
 		int startsect = mydata->data_begin
 			+ START(dentptr) * mydata->clust_size;
-		dir_entry dent;
 		char *nextname = NULL;
 
 		dent = *dentptr;
@@ -1104,14 +1389,20 @@ rootdir_done:
 		}
 	}
 
-	ret = get_contents(mydata, dentptr, buffer, maxsize);
+	ret = get_contents(mydata, dentptr, pos, buffer, maxsize);
 	debug("Size: %d, got: %ld\n", FAT2CPU32(dentptr->size), ret);
 
 exit:
-	free(mydata->fatbuf);
 	return ret;
 }
 
+long
+do_fat_read (const char *filename, void *buffer, unsigned long maxsize,
+	     int dols)
+{
+	return do_fat_read_at(filename, 0, buffer, maxsize, dols);
+}
+
 int file_fat_detectfs (void)
 {
 	boot_sector bs;
@@ -1181,8 +1472,14 @@ int file_fat_ls (const char *dir)
 	return do_fat_read(dir, NULL, 0, LS_YES);
 }
 
-long file_fat_read (const char *filename, void *buffer, unsigned long maxsize)
+long file_fat_read_at (const char *filename, unsigned long pos, void *buffer,
+		       unsigned long maxsize)
 {
 	printf("reading %s\n", filename);
-	return do_fat_read(filename, buffer, maxsize, LS_NO);
+	return do_fat_read_at(filename, pos, buffer, maxsize, LS_NO);
+}
+
+long file_fat_read (const char *filename, void *buffer, unsigned long maxsize)
+{
+	return file_fat_read_at(filename, 0, buffer, maxsize);
 }
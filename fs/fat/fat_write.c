@@ -53,9 +53,15 @@ static int disk_write(__u32 startblock, __u32 getsize, __u8 *bufptr)
 
 	startblock += part_offset;
 
-	if (cur_dev->block_read) {
-		return cur_dev->block_write(cur_dev->dev, startblock, getsize,
+	if (cur_dev->block_write) {
+		int ret;
+
+		/* keep the mount, which is updated along with the volume */
+		fat_mnt_writing = 1;
+		ret = cur_dev->block_write(cur_dev->dev, startblock, getsize,
 					   (unsigned long *) bufptr);
+		fat_mnt_writing = 0;
+		return ret;
 	}
 	return -1;
 }
@@ -113,7 +119,8 @@ static void set_name(dir_entry *dirent, const char *filename)
 }
 
 /*
- * Write fat buffer into block device
+ * Write fat buffer into block device, into every copy of the FAT, if
+ * it has been changed since it was read or last written
  */
 static int flush_fat_buffer(fsdata *mydata)
 {
@@ -121,18 +128,25 @@ static int flush_fat_buffer(fsdata *mydata)
 	__u32 fatlength = mydata->fatlength;
 	__u8 *bufptr = mydata->fatbuf;
 	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
+	int i;
 
-	fatlength *= mydata->sect_size;
-	startblock += mydata->fat_sect;
+	if (!mydata->fatbuf_dirty)
+		return 0;
 
-	if (getsize > fatlength)
-		getsize = fatlength;
+	/* Do not write past the end of the FAT */
+	if (startblock + getsize > fatlength)
+		getsize = fatlength - startblock;
+
+	startblock += mydata->fat_sect;
 
 	/* Write FAT buf */
-	if (disk_write(startblock, getsize, bufptr) < 0) {
-		debug("error: writing FAT blocks\n");
-		return -1;
+	for (i = 0; i < mydata->fats; i++, startblock += fatlength) {
+		if (disk_write(startblock, getsize, bufptr) < 0) {
+			debug("error: writing FAT blocks\n");
+			return -1;
+		}
 	}
+	mydata->fatbuf_dirty = 0;
 
 	return 0;
 }
@@ -178,10 +192,10 @@ static __u32 get_fatent_value(fsdata *mydata, __u32 entry)
 		__u32 fatlength = mydata->fatlength;
 		__u32 startblock = bufnum * FATBUFBLOCKS;
 
-		if (getsize > fatlength)
-			getsize = fatlength;
+		/* Do not read past the end of the FAT */
+		if (startblock + getsize > fatlength)
+			getsize = fatlength - startblock;
 
-		fatlength *= mydata->sect_size;	/* We want it in bytes now */
 		startblock += mydata->fat_sect;	/* Offset from start of disk */
 
 		/* Write back the fatbuf to the disk */
@@ -492,11 +506,11 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		__u32 fatlength = mydata->fatlength;
 		__u32 startblock = bufnum * FATBUFBLOCKS;
 
-		fatlength *= mydata->sect_size;
-		startblock += mydata->fat_sect;
+		/* Do not read past the end of the FAT */
+		if (startblock + getsize > fatlength)
+			getsize = fatlength - startblock;
 
-		if (getsize > fatlength)
-			getsize = fatlength;
+		startblock += mydata->fat_sect;
 
 		if (mydata->fatbufnum != -1) {
 			if (flush_fat_buffer(mydata) < 0)
@@ -521,6 +535,7 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	default:
 		return -1;
 	}
+	mydata->fatbuf_dirty = 1;
 
 	return 0;
 }
@@ -540,6 +555,11 @@ static __u32 determine_fatent(fsdata *mydata, __u32 entry)
 		}
 		next_entry++;
 	}
+
+	/* Nothing below the new cluster is free if the hint pointed at it */
+	if (next_entry == mydata->free_clust)
+		mydata->free_clust = next_entry + 1;
+
 	debug("FAT%d: entry: %08x, entry_value: %04x\n",
 	       mydata->fatsize, entry, next_entry);
 
@@ -589,11 +609,12 @@ set_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer,
 }
 
 /*
- * Find the first empty cluster
+ * Find the first empty cluster, starting where the previous search of
+ * this mount ended
  */
 static int find_empty_cluster(fsdata *mydata)
 {
-	__u32 fat_val, entry = 3;
+	__u32 fat_val, entry = mydata->free_clust;
 
 	while (1) {
 		fat_val = get_fatent_value(mydata, entry);
@@ -602,6 +623,7 @@ static int find_empty_cluster(fsdata *mydata)
 		entry++;
 	}
 
+	mydata->free_clust = entry;
 	return entry;
 }
 
@@ -627,9 +649,6 @@ static void flush_dir_table(fsdata *mydata, dir_entry **dentptr)
 
 	dir_curclust = dir_newclust;
 
-	if (flush_fat_buffer(mydata) < 0)
-		return;
-
 	memset(get_dentfromdir_block, 0x00,
 		mydata->clust_size * mydata->sect_size);
 
@@ -650,16 +669,15 @@ static int clear_fatent(fsdata *mydata, __u32 entry)
 		else
 			break;
 
+		if (entry < mydata->free_clust && entry >= 3)
+			mydata->free_clust = entry;
+
 		if (fat_val == 0xfffffff || fat_val == 0xffff)
 			break;
 
 		entry = fat_val;
 	}
 
-	/* Flush fat buffer */
-	if (flush_fat_buffer(mydata) < 0)
-		return -1;
-
 	return 0;
 }
 
@@ -919,63 +937,26 @@ static int do_fat_write(const char *filename, void *buffer,
 	dir_slot *slotptr;
 	__u32 startsect;
 	__u32 start_cluster;
-	boot_sector bs;
-	volume_info volinfo;
-	fsdata datablock;
-	fsdata *mydata = &datablock;
+	fsdata *mydata;
 	int cursect;
-	int root_cluster, ret = -1, name_len;
+	int ret = -1, name_len;
 	char l_filename[VFAT_MAXLEN_BYTES];
 	int write_size = size;
 
 	dir_curclust = 0;
 
-	if (read_bootsectandvi(&bs, &volinfo, &mydata->fatsize)) {
-		debug("error: reading boot sector\n");
-		return -1;
-	}
-
-	total_sector = bs.total_sect;
-	if (total_sector == 0)
-		total_sector = part_size;
-
-	root_cluster = bs.root_cluster;
-
-	if (mydata->fatsize == 32)
-		mydata->fatlength = bs.fat32_length;
-	else
-		mydata->fatlength = bs.fat_length;
-
-	mydata->fat_sect = bs.reserved;
-
-	cursect = mydata->rootdir_sect
-		= mydata->fat_sect + mydata->fatlength * bs.fats;
-
-	mydata->sect_size = (bs.sector_size[1] << 8) + bs.sector_size[0];
-	mydata->clust_size = bs.cluster_size;
+	/* Entries about to change may be cached */
+	fat_dircache_flush();
 
-	if (mydata->fatsize == 32) {
-		mydata->data_begin = mydata->rootdir_sect -
-					(mydata->clust_size * 2);
-	} else {
-		int rootdir_size;
-
-		rootdir_size = ((bs.dir_entries[1]  * (int)256 +
-				 bs.dir_entries[0]) *
-				 sizeof(dir_entry)) /
-				 mydata->sect_size;
-		mydata->data_begin = mydata->rootdir_sect +
-					rootdir_size -
-					(mydata->clust_size * 2);
-	}
-
-	mydata->fatbufnum = -1;
-	mydata->fatbuf = malloc(FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
-		debug("Error: allocating memory\n");
+	mydata = fat_mount();
+	if (mydata == NULL) {
+		debug("error: mounting volume\n");
 		return -1;
 	}
 
+	total_sector = mydata->total_sect;
+	cursect = mydata->rootdir_sect;
+
 	if (disk_read(cursect,
 		(mydata->fatsize == 32) ?
 		(mydata->clust_size) :
@@ -1088,7 +1069,12 @@ static int do_fat_write(const char *filename, void *buffer,
 	}
 
 exit:
-	free(mydata->fatbuf);
+	/*
+	 * FAT updates are written back once, above; after a failure the
+	 * window may hold some that never made it to the disk
+	 */
+	if (ret < 0)
+		fat_umount();
 	return ret < 0 ? ret : write_size;
 }
 
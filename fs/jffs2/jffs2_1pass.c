@@ -167,45 +167,93 @@ static struct part_info *current_part;
 #endif
 #define NAND_CACHE_SIZE (NAND_CACHE_PAGES*NAND_PAGE_SIZE)
 
-static u8* nand_cache = NULL;
-static u32 nand_cache_off = (u32)-1;
+/*
+ * Number of NAND_CACHE_SIZE windows kept at once.  Scanning, dirent
+ * lookups and file data reads hop between a few places on the flash,
+ * so more than one window avoids re-reading the same pages over and
+ * over.  The least recently used window is replaced on a miss.
+ */
+#ifndef NAND_CACHE_SLOTS
+#define NAND_CACHE_SLOTS 4
+#endif
 
-static int read_nand_cached(u32 off, u32 size, u_char *buf)
+struct nand_cache_slot {
+	u8 *buf;
+	u32 off;
+	u32 used;
+};
+
+static struct nand_cache_slot nand_cache[NAND_CACHE_SLOTS];
+static u32 nand_cache_tick;
+
+static void nand_cache_invalidate(void)
+{
+	int i;
+
+	for (i = 0; i < NAND_CACHE_SLOTS; i++)
+		nand_cache[i].off = (u32)-1;
+}
+
+/* Return the window holding off, reading it from flash if needed */
+static struct nand_cache_slot *nand_cache_get(u32 off)
 {
 	struct mtdids *id = current_part->dev->id;
-	u32 bytes_read = 0;
+	struct nand_cache_slot *slot = &nand_cache[0];
 	size_t retlen;
-	int cpy_bytes;
+	int i;
 
-	while (bytes_read < size) {
-		if ((off + bytes_read < nand_cache_off) ||
-		    (off + bytes_read >= nand_cache_off+NAND_CACHE_SIZE)) {
-			nand_cache_off = (off + bytes_read) & NAND_PAGE_MASK;
-			if (!nand_cache) {
-				/* This memory never gets freed but 'cause
-				   it's a bootloader, nobody cares */
-				nand_cache = malloc(NAND_CACHE_SIZE);
-				if (!nand_cache) {
-					printf("read_nand_cached: can't alloc cache size %d bytes\n",
-					       NAND_CACHE_SIZE);
-					return -1;
-				}
-			}
+	for (i = 0; i < NAND_CACHE_SLOTS; i++) {
+		if (nand_cache[i].buf && nand_cache[i].off != (u32)-1 &&
+		    off >= nand_cache[i].off &&
+		    off < nand_cache[i].off + NAND_CACHE_SIZE) {
+			slot = &nand_cache[i];
+			goto found;
+		}
+		if (nand_cache[i].used < slot->used)
+			slot = &nand_cache[i];
+	}
 
-			retlen = NAND_CACHE_SIZE;
-			if (nand_read(&nand_info[id->num], nand_cache_off,
-						&retlen, nand_cache) != 0 ||
-					retlen != NAND_CACHE_SIZE) {
-				printf("read_nand_cached: error reading nand off %#x size %d bytes\n",
-						nand_cache_off, NAND_CACHE_SIZE);
-				return -1;
-			}
+	if (!slot->buf) {
+		/* This memory never gets freed but 'cause
+		   it's a bootloader, nobody cares */
+		slot->buf = malloc(NAND_CACHE_SIZE);
+		if (!slot->buf) {
+			printf("read_nand_cached: can't alloc cache size %d bytes\n",
+			       NAND_CACHE_SIZE);
+			return NULL;
 		}
-		cpy_bytes = nand_cache_off + NAND_CACHE_SIZE - (off + bytes_read);
+	}
+
+	slot->off = off & NAND_PAGE_MASK;
+	retlen = NAND_CACHE_SIZE;
+	if (nand_read(&nand_info[id->num], slot->off,
+				&retlen, slot->buf) != 0 ||
+			retlen != NAND_CACHE_SIZE) {
+		printf("read_nand_cached: error reading nand off %#x size %d bytes\n",
+				slot->off, NAND_CACHE_SIZE);
+		slot->off = (u32)-1;
+		return NULL;
+	}
+found:
+	slot->used = ++nand_cache_tick;
+	return slot;
+}
+
+static int read_nand_cached(u32 off, u32 size, u_char *buf)
+{
+	struct nand_cache_slot *slot;
+	u32 bytes_read = 0;
+	int cpy_bytes;
+
+	while (bytes_read < size) {
+		slot = nand_cache_get(off + bytes_read);
+		if (!slot)
+			return -1;
+		cpy_bytes = slot->off + NAND_CACHE_SIZE - (off + bytes_read);
 		if (cpy_bytes > size - bytes_read)
 			cpy_bytes = size - bytes_read;
 		memcpy(buf + bytes_read,
-		       nand_cache + off + bytes_read - nand_cache_off,
+		       slot->buf + off + bytes_read - slot->off,
 		       cpy_bytes);
 		bytes_read += cpy_bytes;
 	}
@@ -1179,7 +1227,7 @@ jffs2_1pass_rescan_needed(struct part_info *part)
 	}
 
 	/* if we have no list, we need to rescan */
-	if (pL->frag.listCount == 0) {
+	if (pL->frag.listCount == 0 && pL->dir.listCount == 0) {
 		DEBUGF ("rescan: fraglist zero\n");
 		return 1;
 	}
@@ -1768,6 +1816,18 @@ jffs2_get_list(struct part_info * part, const char *who)
 	/* copy requested part_info struct pointer to global location */
 	current_part = part;
 
+	/*
+	 * The lists are kept from one command to the next, but the flash
+	 * may have been written in between: drop the cached windows so
+	 * that the rescan check below looks at what is there now.
+	 */
+#if defined(CONFIG_JFFS2_NAND) && defined(CONFIG_CMD_NAND)
+	nand_cache_invalidate();
+#endif
+#if defined(CONFIG_CMD_ONENAND)
+	onenand_cache_off = (u32)-1;
+#endif
+
 	if (jffs2_1pass_rescan_needed(part)) {
 		if (!jffs2_1pass_build_lists(part)) {
 			printf("%s: Failed to scan JFFSv2 file structure\n", who);
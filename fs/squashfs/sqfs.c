@@ -0,0 +1,856 @@
+/*
+ * Read-only squashfs 4.0 on block devices
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Inodes and directories live in 8K metadata blocks, compressed one by
+ * one; the tail ends of files are packed together into fragment blocks.
+ * Walking a path reads the same few metadata blocks over and over, and
+ * the files of a directory tend to share a fragment block, so both are
+ * kept in small caches, dropping the least recently used block.  Whole
+ * data blocks are decompressed straight to where the file is loaded.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <part.h>
+#include <squashfs.h>
+#include <asm/byteorder.h>
+#include <asm/unaligned.h>
+#include "sqfs_filesystem.h"
+#include "sqfs_decompressor.h"
+
+#ifndef CONFIG_SYS_SQFS_META_CACHE
+#define CONFIG_SYS_SQFS_META_CACHE	8
+#endif
+#ifndef CONFIG_SYS_SQFS_FRAG_CACHE
+#define CONFIG_SYS_SQFS_FRAG_CACHE	2
+#endif
+
+/* Symbolic links followed in one path, and directories deep */
+#define SQFS_MAX_LINKS		8
+#define SQFS_MAX_DEPTH		32
+#define SQFS_PATH_MAX		1024
+
+/* read past the end of the input by the LZMA decoder */
+#define SQFS_CBUF_SLACK		16
+
+#define SQFS_NO_POS		(~0ULL)
+
+struct sqfs_cache_entry {
+	u64	pos;		/* on the disk, or SQFS_NO_POS */
+	u64	next;		/* the metadata block after this one */
+	ulong	len;		/* decompressed */
+	ulong	used;		/* when last looked up */
+	u8	*data;
+};
+
+struct sqfs_cache {
+	int	count;
+	ulong	tick;
+	struct sqfs_cache_entry *e;
+};
+
+/* A place in the metadata: the block on the disk, the offset in it */
+struct sqfs_meta_pos {
+	u64	block;
+	ulong	offset;
+};
+
+/* What we need of an inode, in CPU order */
+struct sqfs_inode {
+	int	type;		/* the basic type, extended ones mapped */
+	u64	size;		/* of the file, the listing (+3) or the link */
+	u64	start;		/* first data block, or listing block */
+	ulong	offset;		/* of the listing in its block */
+	u32	frag;
+	u32	frag_offset;
+	u32	i_count;	/* directory index entries */
+	struct sqfs_meta_pos tail; /* block sizes, link or index */
+};
+
+static struct {
+	int	mounted;
+	block_dev_desc_t *dev;
+	disk_partition_t part;
+	int	blk_shift;
+	u8	*sector;
+	int	comp;
+	ulong	block_size;
+	int	block_log;
+	u32	fragments;
+	u64	bytes_used;
+	u64	root_inode;
+	u64	inode_table;
+	u64	dir_table;
+	u64	frag_table;
+	u8	*cbuf;		/* a compressed block */
+	ulong	cbuf_size;
+	u8	*block;		/* a data block */
+	struct sqfs_cache meta;
+	struct sqfs_cache frag;
+} sqfs;
+
+/*-------------------------------------------------------------------------*/
+
+static int sqfs_disk_read(u64 off, ulong len, void *buf)
+{
+	ulong blksz = sqfs.part.blksz;
+	lbaint_t sect = off >> sqfs.blk_shift;
+	ulong skip = off & (blksz - 1);
+	u8 *p = buf;
+	ulong n;
+
+	if (off + len > sqfs.bytes_used ||
+	    ((off + len + blksz - 1) >> sqfs.blk_shift) > sqfs.part.size) {
+		printf("squashfs: read beyond the end of the file system\n");
+		return -1;
+	}
+
+	while (len) {
+		if (skip || len < blksz) {
+			n = min(blksz - skip, len);
+			if (sqfs.dev->block_read(sqfs.dev->dev,
+						 sqfs.part.start + sect, 1,
+						 sqfs.sector) != 1)
+				goto err;
+			memcpy(p, sqfs.sector + skip, n);
+			sect++;
+			skip = 0;
+		} else {
+			lbaint_t cnt = len >> sqfs.blk_shift;
+
+			if (sqfs.dev->block_read(sqfs.dev->dev,
+						 sqfs.part.start + sect, cnt,
+						 p) != cnt)
+				goto err;
+			n = cnt << sqfs.blk_shift;
+			sect += cnt;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+
+err:
+	printf("squashfs: read error at sector %lu\n",
+	       (ulong)(sqfs.part.start + sect));
+	return -1;
+}
+
+/*-------------------------------------------------------------------------*/
+
+static int sqfs_cache_init(struct sqfs_cache *c, int count, ulong size)
+{
+	int i;
+
+	c->count = count;
+	c->tick = 0;
+	c->e = calloc(count, sizeof(*c->e));
+	if (!c->e)
+		return -1;
+	for (i = 0; i < count; i++) {
+		c->e[i].pos = SQFS_NO_POS;
+		c->e[i].data = malloc(size);
+		if (!c->e[i].data)
+			return -1;
+	}
+	return 0;
+}
+
+static void sqfs_cache_free(struct sqfs_cache *c)
+{
+	int i;
+
+	if (c->e)
+		for (i = 0; i < c->count; i++)
+			free(c->e[i].data);
+	free(c->e);
+	c->e = NULL;
+	c->count = 0;
+}
+
+/* The entry for pos, or else the one to fill, emptied */
+static struct sqfs_cache_entry *sqfs_cache_get(struct sqfs_cache *c,
+					       u64 pos, int *hit)
+{
+	struct sqfs_cache_entry *e, *victim = &c->e[0];
+	int i;
+
+	for (i = 0; i < c->count; i++) {
+		e = &c->e[i];
+		if (e->pos == pos) {
+			e->used = ++c->tick;
+			*hit = 1;
+			return e;
+		}
+		if (e->used < victim->used)
+			victim = e;
+	}
+
+	victim->pos = SQFS_NO_POS;
+	victim->used = ++c->tick;
+	*hit = 0;
+	return victim;
+}
+
+/*
+ * Read a block of len bytes at pos to dst, decompressing it unless
+ * uncompressed; *dstlen is the room at dst and then the size of the data
+ */
+static int sqfs_read_block(u64 pos, ulong len, int uncompressed,
+			   void *dst, ulong *dstlen)
+{
+	if (uncompressed) {
+		if (len > *dstlen)
+			return -1;
+		*dstlen = len;
+		return sqfs_disk_read(pos, len, dst);
+	}
+
+	if (len > sqfs.cbuf_size || sqfs_disk_read(pos, len, sqfs.cbuf))
+		return -1;
+	if (sqfs_decompress(sqfs.comp, dst, dstlen, sqfs.cbuf, len)) {
+		printf("squashfs: %s data at %llx corrupt\n",
+		       sqfs_comp_name(sqfs.comp), pos);
+		return -1;
+	}
+	return 0;
+}
+
+static struct sqfs_cache_entry *sqfs_meta_block(u64 pos)
+{
+	struct sqfs_cache_entry *e;
+	u8 hdr[2];
+	ulong len;
+	int hit;
+	u16 h;
+
+	e = sqfs_cache_get(&sqfs.meta, pos, &hit);
+	if (hit)
+		return e;
+
+	if (sqfs_disk_read(pos, sizeof(hdr), hdr))
+		return NULL;
+	h = get_unaligned_le16(hdr);
+	len = SQFS_META_LEN(h);
+	if (!len || len > SQFS_METADATA_SIZE) {
+		printf("squashfs: bad metadata block at %llx\n", pos);
+		return NULL;
+	}
+
+	e->len = SQFS_METADATA_SIZE;
+	if (sqfs_read_block(pos + sizeof(hdr), len,
+			    h & SQFS_META_UNCOMPRESSED, e->data, &e->len) ||
+	    !e->len)
+		return NULL;
+
+	e->pos = pos;
+	e->next = pos + sizeof(hdr) + len;
+	return e;
+}
+
+static int sqfs_read_meta(struct sqfs_meta_pos *mp, void *dst, ulong len)
+{
+	struct sqfs_cache_entry *e;
+	u8 *p = dst;
+	ulong n;
+
+	while (len) {
+		e = sqfs_meta_block(mp->block);
+		if (!e)
+			return -1;
+		if (mp->offset >= e->len) {
+			mp->offset -= e->len;
+			mp->block = e->next;
+			continue;
+		}
+		n = min(len, e->len - mp->offset);
+		memcpy(p, e->data + mp->offset, n);
+		mp->offset += n;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/*-------------------------------------------------------------------------*/
+
+static int sqfs_read_inode(u64 ref, struct sqfs_inode *ino)
+{
+	union {
+		struct sqfs_base_inode base;
+		struct sqfs_reg_inode reg;
+		struct sqfs_lreg_inode lreg;
+		struct sqfs_symlink_inode symlink;
+		struct sqfs_dir_inode dir;
+		struct sqfs_ldir_inode ldir;
+	} raw;
+	struct sqfs_meta_pos mp;
+	ulong size;
+
+	mp.block = sqfs.inode_table + SQFS_REF_BLOCK(ref);
+	mp.offset = SQFS_REF_OFFSET(ref);
+	if (sqfs_read_meta(&mp, &raw.base, sizeof(raw.base)))
+		return -1;
+
+	memset(ino, 0, sizeof(*ino));
+	ino->type = le16_to_cpu(raw.base.inode_type);
+	switch (ino->type) {
+	case SQFS_DIR_TYPE:
+		size = sizeof(raw.dir);
+		break;
+	case SQFS_LDIR_TYPE:
+		size = sizeof(raw.ldir);
+		break;
+	case SQFS_REG_TYPE:
+		size = sizeof(raw.reg);
+		break;
+	case SQFS_LREG_TYPE:
+		size = sizeof(raw.lreg);
+		break;
+	case SQFS_SYMLINK_TYPE:
+	case SQFS_LSYMLINK_TYPE:
+		size = sizeof(raw.symlink);
+		break;
+	default:
+		/* devices, fifos and sockets: nothing to read */
+		return 0;
+	}
+	if (sqfs_read_meta(&mp, (u8 *)&raw + sizeof(raw.base),
+			   size - sizeof(raw.base)))
+		return -1;
+	ino->tail = mp;
+
+	switch (ino->type) {
+	case SQFS_DIR_TYPE:
+		ino->size = le16_to_cpu(raw.dir.file_size);
+		ino->start = le32_to_cpu(raw.dir.start_block);
+		ino->offset = le16_to_cpu(raw.dir.offset);
+		break;
+	case SQFS_LDIR_TYPE:
+		ino->type = SQFS_DIR_TYPE;
+		ino->size = le32_to_cpu(raw.ldir.file_size);
+		ino->start = le32_to_cpu(raw.ldir.start_block);
+		ino->offset = le16_to_cpu(raw.ldir.offset);
+		ino->i_count = le16_to_cpu(raw.ldir.i_count);
+		break;
+	case SQFS_REG_TYPE:
+		ino->size = le32_to_cpu(raw.reg.file_size);
+		ino->start = le32_to_cpu(raw.reg.start_block);
+		ino->frag = le32_to_cpu(raw.reg.fragment);
+		ino->frag_offset = le32_to_cpu(raw.reg.offset);
+		break;
+	case SQFS_LREG_TYPE:
+		ino->type = SQFS_REG_TYPE;
+		ino->size = le64_to_cpu(raw.lreg.file_size);
+		ino->start = le64_to_cpu(raw.lreg.start_block);
+		ino->frag = le32_to_cpu(raw.lreg.fragment);
+		ino->frag_offset = le32_to_cpu(raw.lreg.offset);
+		break;
+	default:
+		ino->type = SQFS_SYMLINK_TYPE;
+		ino->size = le32_to_cpu(raw.symlink.symlink_size);
+		break;
+	}
+	return 0;
+}
+
+/* The target of a symbolic link, terminated */
+static int sqfs_read_link(struct sqfs_inode *ino, char *buf, ulong size)
+{
+	struct sqfs_meta_pos mp = ino->tail;
+
+	if (ino->size >= size) {
+		printf("squashfs: symbolic link too long\n");
+		return -1;
+	}
+	if (sqfs_read_meta(&mp, buf, ino->size))
+		return -1;
+	buf[ino->size] = '\0';
+	return 0;
+}
+
+/*-------------------------------------------------------------------------*/
+
+/*
+ * Skip ahead in the listing of a large directory to the metadata block
+ * where name would be, with its index; returns how much of the listing
+ * that skips, counting the 3 bytes the size is too large by.
+ */
+static ulong sqfs_dir_index(struct sqfs_inode *dir, const char *name,
+			    struct sqfs_meta_pos *mp)
+{
+	struct sqfs_meta_pos ip = dir->tail;
+	struct sqfs_dir_index index;
+	char iname[SQFS_NAME_LEN + 1];
+	u64 block = mp->block;
+	ulong length = 0;
+	ulong size;
+	int i;
+
+	for (i = 0; i < dir->i_count; i++) {
+		if (sqfs_read_meta(&ip, &index, sizeof(index)))
+			break;
+		size = le32_to_cpu(index.size) + 1;
+		if (size > SQFS_NAME_LEN || sqfs_read_meta(&ip, iname, size))
+			break;
+		iname[size] = '\0';
+		if (strcmp(iname, name) > 0)
+			break;
+		length = le32_to_cpu(index.index);
+		block = sqfs.dir_table + le32_to_cpu(index.start_block);
+	}
+
+	mp->block = block;
+	mp->offset = (length + mp->offset) % SQFS_METADATA_SIZE;
+	return length + 3;
+}
+
+/*
+ * Call fn for the entries of a directory, in order, until it returns
+ * non-zero; with name, start at the right place for looking that up.
+ * Returns -1 on errors, 1 if fn stopped, 0 at the end.
+ */
+static int sqfs_dir_iterate(struct sqfs_inode *dir, const char *name,
+			    int (*fn)(void *priv, const char *name, u64 ref,
+				      int type),
+			    void *priv)
+{
+	struct sqfs_meta_pos mp;
+	struct sqfs_dir_header hdr;
+	struct sqfs_dir_entry ent;
+	char ename[SQFS_NAME_LEN + 1];
+	ulong done = 3, count, size;
+	u64 ref;
+
+	mp.block = sqfs.dir_table + dir->start;
+	mp.offset = dir->offset;
+	if (name && dir->i_count)
+		done = sqfs_dir_index(dir, name, &mp);
+
+	while (done < dir->size) {
+		if (sqfs_read_meta(&mp, &hdr, sizeof(hdr)))
+			return -1;
+		done += sizeof(hdr);
+		count = le32_to_cpu(hdr.count) + 1;
+		if (count > SQFS_DIR_COUNT)
+			goto bad;
+
+		while (count--) {
+			if (sqfs_read_meta(&mp, &ent, sizeof(ent)))
+				return -1;
+			size = le16_to_cpu(ent.size) + 1;
+			if (size > SQFS_NAME_LEN)
+				goto bad;
+			if (sqfs_read_meta(&mp, ename, size))
+				return -1;
+			ename[size] = '\0';
+			done += sizeof(ent) + size;
+
+			ref = ((u64)le32_to_cpu(hdr.start_block) << 16) |
+				le16_to_cpu(ent.offset);
+			if (fn(priv, ename, ref, le16_to_cpu(ent.type)))
+				return 1;
+		}
+	}
+	return 0;
+
+bad:
+	printf("squashfs: bad directory listing\n");
+	return -1;
+}
+
+struct sqfs_lookup {
+	const char *name;
+	u64 ref;
+	int found;
+};
+
+static int sqfs_lookup_fn(void *priv, const char *name, u64 ref, int type)
+{
+	struct sqfs_lookup *l = priv;
+	int cmp = strcmp(name, l->name);
+
+	if (!cmp) {
+		l->ref = ref;
+		l->found = 1;
+	}
+	/* the entries are sorted */
+	return cmp >= 0;
+}
+
+/*
+ * Find the inode of path, following symbolic links on the way and, if
+ * follow, at the end
+ */
+static int sqfs_lookup_path(const char *path, struct sqfs_inode *ino,
+			    int follow)
+{
+	static char work[SQFS_PATH_MAX], link[SQFS_PATH_MAX];
+	u64 stack[SQFS_MAX_DEPTH];
+	struct sqfs_lookup l;
+	char *p, *rest;
+	int depth = 0, links = 0;
+
+	if (strlen(path) >= sizeof(work)) {
+		printf("squashfs: path too long\n");
+		return -1;
+	}
+	strcpy(work, path);
+	p = work;
+	stack[0] = sqfs.root_inode;
+
+	for (;;) {
+		while (*p == '/')
+			p++;
+		if (!*p)
+			return sqfs_read_inode(stack[depth], ino);
+
+		rest = strchr(p, '/');
+		if (rest)
+			*rest++ = '\0';
+		else
+			rest = p + strlen(p);
+
+		if (!strcmp(p, ".")) {
+			p = rest;
+			continue;
+		}
+		if (!strcmp(p, "..")) {
+			if (depth)
+				depth--;
+			p = rest;
+			continue;
+		}
+
+		if (sqfs_read_inode(stack[depth], ino))
+			return -1;
+		if (ino->type != SQFS_DIR_TYPE) {
+			printf("squashfs: not a directory\n");
+			return -1;
+		}
+
+		l.name = p;
+		l.found = 0;
+		if (sqfs_dir_iterate(ino, p, sqfs_lookup_fn, &l) < 0)
+			return -1;
+		if (!l.found)
+			return -1;
+
+		if (sqfs_read_inode(l.ref, ino))
+			return -1;
+		if (ino->type == SQFS_SYMLINK_TYPE && (*rest || follow)) {
+			if (++links > SQFS_MAX_LINKS) {
+				printf("squashfs: too many symbolic links\n");
+				return -1;
+			}
+			if (sqfs_read_link(ino, link, sizeof(link)))
+				return -1;
+			if (strlen(link) + 1 + strlen(rest) >= sizeof(link)) {
+				printf("squashfs: path too long\n");
+				return -1;
+			}
+			strcat(link, "/");
+			strcat(link, rest);
+			strcpy(work, link);
+			p = work;
+			if (*p == '/')
+				depth = 0;
+			continue;
+		}
+
+		if (++depth == SQFS_MAX_DEPTH) {
+			printf("squashfs: path too deep\n");
+			return -1;
+		}
+		stack[depth] = l.ref;
+		p = rest;
+	}
+}
+
+/*-------------------------------------------------------------------------*/
+
+static struct sqfs_cache_entry *sqfs_fragment(u32 frag)
+{
+	struct sqfs_fragment_entry fe;
+	struct sqfs_cache_entry *e;
+	struct sqfs_meta_pos mp;
+	u8 index[8];
+	u32 size;
+	u64 start;
+	int hit;
+
+	if (frag >= sqfs.fragments) {
+		printf("squashfs: bad fragment %u\n", frag);
+		return NULL;
+	}
+
+	if (sqfs_disk_read(sqfs.frag_table +
+			   sizeof(index) * (frag / SQFS_FRAGS_PER_BLOCK),
+			   sizeof(index), index))
+		return NULL;
+	mp.block = get_unaligned_le64(index);
+	mp.offset = (frag % SQFS_FRAGS_PER_BLOCK) * sizeof(fe);
+	if (sqfs_read_meta(&mp, &fe, sizeof(fe)))
+		return NULL;
+
+	start = le64_to_cpu(fe.start_block);
+	size = le32_to_cpu(fe.size);
+
+	e = sqfs_cache_get(&sqfs.frag, start, &hit);
+	if (hit)
+		return e;
+
+	e->len = sqfs.block_size;
+	if (sqfs_read_block(start, SQFS_DATA_LEN(size),
+			    size & SQFS_DATA_UNCOMPRESSED, e->data, &e->len))
+		return NULL;
+	e->pos = start;
+	return e;
+}
+
+static long sqfs_read_file(struct sqfs_inode *ino, u8 *dst, u64 len)
+{
+	struct sqfs_cache_entry *e;
+	struct sqfs_meta_pos mp = ino->tail;
+	u64 pos = ino->start, done = 0;
+	ulong bs = sqfs.block_size, want, n, got;
+	ulong nblocks;
+	u32 bsize, size;
+
+	nblocks = ino->size >> sqfs.block_log;
+	if (ino->frag == SQFS_INVALID_FRAG && (ino->size & (bs - 1)))
+		nblocks++;
+
+	for (; nblocks && done < len; nblocks--) {
+		if (sqfs_read_meta(&mp, &bsize, sizeof(bsize)))
+			return -1;
+		size = SQFS_DATA_LEN(le32_to_cpu(bsize));
+
+		/* the block holds want bytes of the file, we take n */
+		want = min((u64)bs, ino->size - done);
+		n = min((u64)want, len - done);
+
+		if (!size) {
+			/* a hole */
+			memset(dst, 0, n);
+		} else if (size > bs) {
+			printf("squashfs: bad block size\n");
+			return -1;
+		} else if (n == want) {
+			got = n;
+			if (sqfs_read_block(pos, size,
+					    le32_to_cpu(bsize) &
+					    SQFS_DATA_UNCOMPRESSED, dst, &got))
+				return -1;
+			if (got != n)
+				goto short_block;
+		} else {
+			got = bs;
+			if (sqfs_read_block(pos, size,
+					    le32_to_cpu(bsize) &
+					    SQFS_DATA_UNCOMPRESSED,
+					    sqfs.block, &got))
+				return -1;
+			if (got < n)
+				goto short_block;
+			memcpy(dst, sqfs.block, n);
+		}
+
+		pos += size;
+		dst += n;
+		done += n;
+	}
+
+	if (done < len) {
+		n = len - done;
+		if (ino->frag == SQFS_INVALID_FRAG)
+			goto short_block;
+		e = sqfs_fragment(ino->frag);
+		if (!e)
+			return -1;
+		if (ino->frag_offset > e->len || n > e->len - ino->frag_offset)
+			goto short_block;
+		memcpy(dst, e->data + ino->frag_offset, n);
+		done += n;
+	}
+	return done;
+
+short_block:
+	printf("squashfs: file data shorter than the file\n");
+	return -1;
+}
+
+/*-------------------------------------------------------------------------*/
+
+static int sqfs_ls_fn(void *priv, const char *name, u64 ref, int type)
+{
+	struct sqfs_inode ino;
+	char link[SQFS_PATH_MAX];
+
+	if (sqfs_read_inode(ref, &ino)) {
+		printf("%s: unreadable inode\n", name);
+		return 0;
+	}
+
+	switch (ino.type) {
+	case SQFS_DIR_TYPE:
+		printf("<DIR> %10u %s\n", 0, name);
+		break;
+	case SQFS_SYMLINK_TYPE:
+		if (sqfs_read_link(&ino, link, sizeof(link)))
+			link[0] = '\0';
+		printf("<SYM> %10u %s -> %s\n", 0, name, link);
+		break;
+	case SQFS_REG_TYPE:
+		printf("      %10llu %s\n", ino.size, name);
+		break;
+	default:
+		printf("<DEV> %10u %s\n", 0, name);
+		break;
+	}
+	return 0;
+}
+
+int sqfs_ls(const char *dirname)
+{
+	struct sqfs_inode ino;
+
+	if (!sqfs.mounted)
+		return -1;
+	if (sqfs_lookup_path(dirname, &ino, 1)) {
+		printf("** %s not found **\n", dirname);
+		return -1;
+	}
+	if (ino.type != SQFS_DIR_TYPE) {
+		printf("** %s is not a directory **\n", dirname);
+		return -1;
+	}
+	return sqfs_dir_iterate(&ino, NULL, sqfs_ls_fn, NULL) < 0 ? -1 : 0;
+}
+
+long sqfs_read(const char *filename, void *buf, unsigned long maxsize)
+{
+	struct sqfs_inode ino;
+	u64 len;
+
+	if (!sqfs.mounted)
+		return -1;
+	if (sqfs_lookup_path(filename, &ino, 1)) {
+		printf("** %s not found **\n", filename);
+		return -1;
+	}
+	if (ino.type != SQFS_REG_TYPE) {
+		printf("** %s is not a regular file **\n", filename);
+		return -1;
+	}
+
+	len = ino.size;
+	if (maxsize && maxsize < len)
+		len = maxsize;
+	if (len > (~0UL >> 1)) {
+		printf("** %s is too large **\n", filename);
+		return -1;
+	}
+	return sqfs_read_file(&ino, buf, len);
+}
+
+/*-------------------------------------------------------------------------*/
+
+int sqfs_mount(block_dev_desc_t *dev_desc, int part)
+{
+	struct sqfs_super_block sb;
+	sqfs_close();
+
+	sqfs.dev = dev_desc;
+	if (part == 0) {
+		/* the whole disk */
+		sqfs.part.start = 0;
+		sqfs.part.size = dev_desc->lba;
+		sqfs.part.blksz = dev_desc->blksz;
+	} else if (get_partition_info(dev_desc, part, &sqfs.part)) {
+		return -1;
+	}
+	if (!sqfs.part.blksz || sqfs.part.blksz & (sqfs.part.blksz - 1))
+		return -1;
+	for (sqfs.blk_shift = 0; (1UL << sqfs.blk_shift) < sqfs.part.blksz;
+	     sqfs.blk_shift++)
+		;
+
+	sqfs.sector = malloc(sqfs.part.blksz);
+	if (!sqfs.sector)
+		goto nomem;
+
+	sqfs.bytes_used = sizeof(sb);
+	if (sqfs_disk_read(0, sizeof(sb), &sb))
+		goto fail;
+	if (le32_to_cpu(sb.s_magic) != SQFS_MAGIC)
+		goto fail;
+	if (le16_to_cpu(sb.s_major) != SQFS_MAJOR) {
+		printf("squashfs: version %u.%u not supported\n",
+		       le16_to_cpu(sb.s_major), le16_to_cpu(sb.s_minor));
+		goto fail;
+	}
+
+	sqfs.comp = le16_to_cpu(sb.compression);
+	if (!sqfs_comp_supported(sqfs.comp)) {
+		printf("squashfs: %s compression not built in\n",
+		       sqfs_comp_name(sqfs.comp));
+		goto fail;
+	}
+
+	sqfs.block_size = le32_to_cpu(sb.block_size);
+	sqfs.block_log = le16_to_cpu(sb.block_log);
+	if (sqfs.block_log > 20 ||
+	    sqfs.block_size != 1UL << sqfs.block_log ||
+	    sqfs.block_size < 4096) {
+		printf("squashfs: bad block size\n");
+		goto fail;
+	}
+
+	sqfs.fragments = le32_to_cpu(sb.fragments);
+	sqfs.bytes_used = le64_to_cpu(sb.bytes_used);
+	sqfs.root_inode = le64_to_cpu(sb.root_inode);
+	sqfs.inode_table = le64_to_cpu(sb.inode_table_start);
+	sqfs.dir_table = le64_to_cpu(sb.directory_table_start);
+	sqfs.frag_table = le64_to_cpu(sb.fragment_table_start);
+
+	sqfs.cbuf_size = max(sqfs.block_size, (ulong)SQFS_METADATA_SIZE);
+	sqfs.cbuf = malloc(sqfs.cbuf_size + SQFS_CBUF_SLACK);
+	sqfs.block = malloc(sqfs.block_size);
+	if (!sqfs.cbuf || !sqfs.block)
+		goto nomem;
+	memset(sqfs.cbuf + sqfs.cbuf_size, 0, SQFS_CBUF_SLACK);
+
+	if (sqfs_cache_init(&sqfs.meta, CONFIG_SYS_SQFS_META_CACHE,
+			    SQFS_METADATA_SIZE) ||
+	    sqfs_cache_init(&sqfs.frag, CONFIG_SYS_SQFS_FRAG_CACHE,
+			    sqfs.block_size))
+		goto nomem;
+
+	sqfs.mounted = 1;
+	return 0;
+
+nomem:
+	printf("squashfs: out of memory\n");
+fail:
+	sqfs_close();
+	return -1;
+}
+
+void sqfs_close(void)
+{
+	sqfs_cache_free(&sqfs.meta);
+	sqfs_cache_free(&sqfs.frag);
+	free(sqfs.cbuf);
+	free(sqfs.block);
+	free(sqfs.sector);
+	sqfs.cbuf = NULL;
+	sqfs.block = NULL;
+	sqfs.sector = NULL;
+	sqfs.mounted = 0;
+}
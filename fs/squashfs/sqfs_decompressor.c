@@ -0,0 +1,149 @@
+/*
+ * Block decompression for squashfs, with the decompressors in lib/
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Every block is compressed on its own: a zlib stream for gzip, raw
+ * LZO1X and LZ4 blocks, and for lzma the "lzma alone" format of an
+ * LZMA properties header and the uncompressed size.
+ */
+
+#include <common.h>
+#include <asm/unaligned.h>
+#ifdef CONFIG_ZLIB
+#include <u-boot/zlib.h>
+#endif
+#ifdef CONFIG_LZO
+#include <linux/lzo.h>
+#endif
+#ifdef CONFIG_LZ4
+#include <lz4.h>
+#endif
+#ifdef CONFIG_LZMA
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+#include <lzma/LzmaTools.h>
+#endif
+#include "sqfs_filesystem.h"
+#include "sqfs_decompressor.h"
+
+const char *sqfs_comp_name(int comp)
+{
+	switch (comp) {
+	case SQFS_COMP_ZLIB:
+		return "gzip";
+	case SQFS_COMP_LZMA:
+		return "lzma";
+	case SQFS_COMP_LZO:
+		return "lzo";
+	case SQFS_COMP_XZ:
+		return "xz";
+	case SQFS_COMP_LZ4:
+		return "lz4";
+	default:
+		return "unknown";
+	}
+}
+
+int sqfs_comp_supported(int comp)
+{
+	switch (comp) {
+#ifdef CONFIG_ZLIB
+	case SQFS_COMP_ZLIB:
+#endif
+#ifdef CONFIG_LZMA
+	case SQFS_COMP_LZMA:
+#endif
+#ifdef CONFIG_LZO
+	case SQFS_COMP_LZO:
+#endif
+#ifdef CONFIG_LZ4
+	case SQFS_COMP_LZ4:
+#endif
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+#ifdef CONFIG_ZLIB
+static int sqfs_inflate(void *dst, unsigned long *dstlen,
+			void *src, unsigned long srclen)
+{
+	z_stream s;
+	int r;
+
+	memset(&s, 0, sizeof(s));
+	if (inflateInit(&s) != Z_OK)
+		return -1;
+
+	s.next_in = src;
+	s.avail_in = srclen;
+	s.next_out = dst;
+	s.avail_out = *dstlen;
+	r = inflate(&s, Z_FINISH);
+	*dstlen = s.total_out;
+	inflateEnd(&s);
+
+	return r == Z_STREAM_END ? 0 : -1;
+}
+#endif
+
+#ifdef CONFIG_LZMA
+/* 5 bytes of properties, the 64 bit uncompressed size, the data */
+#define SQFS_LZMA_HEADER	(LZMA_PROPS_SIZE + 8)
+
+static int sqfs_unlzma(void *dst, unsigned long *dstlen,
+		       void *src, unsigned long srclen)
+{
+	SizeT len;
+
+	if (srclen < SQFS_LZMA_HEADER ||
+	    get_unaligned_le64((u8 *)src + LZMA_PROPS_SIZE) > *dstlen)
+		return -1;
+
+	len = *dstlen;
+	if (lzmaBuffToBuffDecompress(dst, &len, src, srclen) != SZ_OK)
+		return -1;
+	*dstlen = len;
+	return 0;
+}
+#endif
+
+int sqfs_decompress(int comp, void *dst, unsigned long *dstlen,
+		    void *src, unsigned long srclen)
+{
+	size_t len = *dstlen;
+	int ret = -1;
+
+	switch (comp) {
+#ifdef CONFIG_ZLIB
+	case SQFS_COMP_ZLIB:
+		return sqfs_inflate(dst, dstlen, src, srclen);
+#endif
+#ifdef CONFIG_LZMA
+	case SQFS_COMP_LZMA:
+		return sqfs_unlzma(dst, dstlen, src, srclen);
+#endif
+#ifdef CONFIG_LZO
+	case SQFS_COMP_LZO:
+		ret = lzo1x_decompress_safe(src, srclen, dst, &len) == LZO_E_OK ?
+			0 : -1;
+		break;
+#endif
+#ifdef CONFIG_LZ4
+	case SQFS_COMP_LZ4:
+		ret = lz4_decompress_block(src, srclen, dst, &len) == LZ4_E_OK ?
+			0 : -1;
+		break;
+#endif
+	default:
+		break;
+	}
+
+	*dstlen = len;
+	return ret;
+}
@@ -0,0 +1,25 @@
+/*
+ * Block decompression for squashfs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __SQFS_DECOMPRESSOR_H
+#define __SQFS_DECOMPRESSOR_H
+
+/* The name of a compressor, and whether its decompressor is built in */
+const char *sqfs_comp_name(int comp);
+int sqfs_comp_supported(int comp);
+
+/*
+ * Decompress a block of srclen bytes to dst, which has room for
+ * *dstlen bytes; *dstlen is set to the decompressed size.  0 on
+ * success, -1 if the data are corrupt or do not fit.
+ */
+int sqfs_decompress(int comp, void *dst, unsigned long *dstlen,
+		    void *src, unsigned long srclen);
+
+#endif /* __SQFS_DECOMPRESSOR_H */
@@ -0,0 +1,171 @@
+/*
+ * The on-disk format of squashfs 4.0, as Linux and squashfs-tools 4.x
+ * read and write it; all fields are little endian.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __SQFS_FILESYSTEM_H
+#define __SQFS_FILESYSTEM_H
+
+#define SQFS_MAGIC		0x73717368	/* "hsqs" */
+#define SQFS_MAJOR		4
+
+/* Compressors */
+#define SQFS_COMP_ZLIB		1
+#define SQFS_COMP_LZMA		2
+#define SQFS_COMP_LZO		3
+#define SQFS_COMP_XZ		4
+#define SQFS_COMP_LZ4		5
+
+/* Metadata blocks hold 8K, behind a 16 bit length */
+#define SQFS_METADATA_SIZE	8192
+#define SQFS_META_UNCOMPRESSED	0x8000
+#define SQFS_META_LEN(h)	((h) & ~SQFS_META_UNCOMPRESSED)
+
+/* Data and fragment block sizes */
+#define SQFS_DATA_UNCOMPRESSED	(1 << 24)
+#define SQFS_DATA_LEN(s)	((s) & ~SQFS_DATA_UNCOMPRESSED)
+#define SQFS_MAX_BLOCK_SIZE	(1 << 20)
+
+#define SQFS_INVALID_FRAG	0xffffffff
+#define SQFS_FRAGS_PER_BLOCK	(SQFS_METADATA_SIZE / sizeof(struct sqfs_fragment_entry))
+
+/*
+ * A reference to an inode: the place of its metadata block from the
+ * start of the inode table, and its offset in the block
+ */
+#define SQFS_REF_BLOCK(r)	((r) >> 16)
+#define SQFS_REF_OFFSET(r)	((r) & 0xffff)
+
+struct sqfs_super_block {
+	u32	s_magic;
+	u32	inodes;
+	u32	mkfs_time;
+	u32	block_size;
+	u32	fragments;
+	u16	compression;
+	u16	block_log;
+	u16	flags;
+	u16	no_ids;
+	u16	s_major;
+	u16	s_minor;
+	u64	root_inode;
+	u64	bytes_used;
+	u64	id_table_start;
+	u64	xattr_id_table_start;
+	u64	inode_table_start;
+	u64	directory_table_start;
+	u64	fragment_table_start;
+	u64	lookup_table_start;
+} __attribute__ ((packed));
+
+/* Inode types */
+#define SQFS_DIR_TYPE		1
+#define SQFS_REG_TYPE		2
+#define SQFS_SYMLINK_TYPE	3
+#define SQFS_BLKDEV_TYPE	4
+#define SQFS_CHRDEV_TYPE	5
+#define SQFS_FIFO_TYPE		6
+#define SQFS_SOCKET_TYPE	7
+#define SQFS_LDIR_TYPE		8
+#define SQFS_LREG_TYPE		9
+#define SQFS_LSYMLINK_TYPE	10
+
+struct sqfs_base_inode {
+	u16	inode_type;
+	u16	mode;
+	u16	uid;
+	u16	guid;
+	u32	mtime;
+	u32	inode_number;
+} __attribute__ ((packed));
+
+struct sqfs_reg_inode {
+	struct sqfs_base_inode base;
+	u32	start_block;
+	u32	fragment;
+	u32	offset;
+	u32	file_size;
+	/* followed by the sizes of the blocks, u32 each */
+} __attribute__ ((packed));
+
+struct sqfs_lreg_inode {
+	struct sqfs_base_inode base;
+	u64	start_block;
+	u64	file_size;
+	u64	sparse;
+	u32	nlink;
+	u32	fragment;
+	u32	offset;
+	u32	xattr;
+	/* followed by the sizes of the blocks, u32 each */
+} __attribute__ ((packed));
+
+struct sqfs_symlink_inode {
+	struct sqfs_base_inode base;
+	u32	nlink;
+	u32	symlink_size;
+	/* followed by the target, not terminated */
+} __attribute__ ((packed));
+
+struct sqfs_dir_inode {
+	struct sqfs_base_inode base;
+	u32	start_block;
+	u32	nlink;
+	u16	file_size;
+	u16	offset;
+	u32	parent_inode;
+} __attribute__ ((packed));
+
+struct sqfs_ldir_inode {
+	struct sqfs_base_inode base;
+	u32	nlink;
+	u32	file_size;
+	u32	start_block;
+	u32	parent_inode;
+	u16	i_count;
+	u16	offset;
+	u32	xattr;
+	/* followed by i_count struct sqfs_dir_index */
+} __attribute__ ((packed));
+
+/*
+ * Where the listing of a large directory goes on to a new metadata
+ * block, and the first name there; the names are in strcmp() order.
+ */
+struct sqfs_dir_index {
+	u32	index;		/* from the start of the listing */
+	u32	start_block;	/* from the start of the directory table */
+	u32	size;		/* of the name, less one */
+	/* followed by the name */
+} __attribute__ ((packed));
+
+/* A directory listing is runs of entries, each after a header */
+struct sqfs_dir_header {
+	u32	count;		/* entries, less one */
+	u32	start_block;	/* of their inodes */
+	u32	inode_number;
+} __attribute__ ((packed));
+
+struct sqfs_dir_entry {
+	u16	offset;		/* of the inode in its block */
+	s16	inode_number;	/* from that of the header */
+	u16	type;
+	u16	size;		/* of the name, less one */
+	/* followed by the name */
+} __attribute__ ((packed));
+
+#define SQFS_DIR_COUNT		256
+#define SQFS_NAME_LEN		256
+
+struct sqfs_fragment_entry {
+	u64	start_block;
+	u32	size;
+	u32	unused;
+} __attribute__ ((packed));
+
+#endif /* __SQFS_FILESYSTEM_H */
@@ -518,23 +518,13 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+static int unpack_block(struct ubifs_info *c, struct inode *inode,
+			void *addr, unsigned int block,
+			struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -565,6 +555,72 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	int err;
+	union ubifs_key key;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return unpack_block(c, inode, addr, block, dn);
+}
+
+/*
+ * Read the data nodes starting at block that follow each other in one
+ * LEB with a single ubi_read(), as the bulk_read mount option does in
+ * Linux, and unpack up to max_blocks of them to addr.  Returns the number
+ * of blocks filled, which may be 0 if bulk-read does not help here, or a
+ * negative error code.
+ */
+static int read_bulk(struct ubifs_info *c, struct inode *inode,
+		     struct bu_info *bu, void *addr, unsigned int block,
+		     unsigned int max_blocks)
+{
+	void *buf;
+	unsigned int done = 0;
+	int err, n;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+	if (bu->cnt < 2)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err == -EAGAIN ? 0 : err;
+
+	buf = bu->buf;
+	for (n = 0; n < bu->cnt; n++) {
+		unsigned int b = key_block(c, &bu->zbranch[n].key) - block;
+
+		if (b >= max_blocks)
+			break;
+		/* Holes read as zeroes */
+		memset(addr + done * UBIFS_BLOCK_SIZE, 0,
+		       (b - done) * UBIFS_BLOCK_SIZE);
+		err = unpack_block(c, inode, addr + b * UBIFS_BLOCK_SIZE,
+				   block + b, buf);
+		if (err)
+			return err;
+		done = b + 1;
+		buf += ALIGN(bu->zbranch[n].len, 8);
+	}
+
+	/* Only hand back whole pages */
+	return done & ~(UBIFS_BLOCKS_PER_PAGE - 1);
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -687,6 +743,7 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	int count;
 	int last_block_size = 0;
 	char buf [10];
+	struct bu_info *bu;
 
 	c->ubi = ubi_open_volume(c->vi.ubi_num, c->vi.vol_id, UBI_READONLY);
 	/* ubifs_findfile will resolve symlinks, so we know that we get
@@ -718,10 +775,46 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	printf("Loading file '%s' to addr 0x%08x with size %d (0x%08x)...\n",
 	       filename, addr, size, size);
 
+	/* Without memory for bulk-read, read one data node at a time */
+	bu = malloc(sizeof(struct bu_info));
+	if (bu) {
+		bu->buf_len = UBIFS_MAX_BULK_READ * UBIFS_MAX_DATA_NODE_SZ;
+		if (bu->buf_len > c->leb_size)
+			bu->buf_len = c->leb_size;
+		bu->buf = malloc(bu->buf_len);
+		if (!bu->buf) {
+			free(bu);
+			bu = NULL;
+		}
+	}
+
 	page.addr = (void *)addr;
 	page.index = 0;
 	page.inode = inode;
 	for (i = 0; i < count; i++) {
+		/*
+		 * The last page goes through do_readpage(), which takes
+		 * care of a partial last block.
+		 */
+		if (bu && (i + 1) < count) {
+			int pages;
+
+			pages = read_bulk(c, inode, bu, page.addr,
+					  page.index << UBIFS_BLOCKS_PER_PAGE_SHIFT,
+					  (count - 1 - i) * UBIFS_BLOCKS_PER_PAGE);
+			if (pages < 0) {
+				err = pages;
+				break;
+			}
+			pages /= UBIFS_BLOCKS_PER_PAGE;
+			if (pages) {
+				i += pages - 1;
+				page.addr += pages * PAGE_SIZE;
+				page.index += pages;
+				continue;
+			}
+		}
+
 		/*
 		 * Make sure to not read beyond the requested size
 		 */
@@ -744,6 +837,10 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 		printf("Done\n");
 	}
 
+	if (bu) {
+		free(bu->buf);
+		free(bu);
+	}
 	ubifs_iput(inode);
 
 out:
@@ -4414,7 +4414,7 @@ int yaffs_CheckpointSave(yaffs_Device *dev)
 		yaffs_WriteCheckpointData(dev);
 	}
 
-	T(YAFFS_TRACE_ALWAYS,(TSTR("save exit: isCheckpointed %d"TENDSTR),dev->isCheckpointed));
+	T(YAFFS_TRACE_CHECKPOINT,(TSTR("save exit: isCheckpointed %d"TENDSTR),dev->isCheckpointed));
 
 	return dev->isCheckpointed;
 }
@@ -117,8 +117,13 @@ int yaffs_StartUp(void)
 	struct mtd_info *mtd = &nand_info[0];
 	int yaffsVersion = 2;
 	int nBlocks;
+	yaffs_Device *flashDev;
 
-	yaffs_Device *flashDev = calloc(1, sizeof(yaffs_Device));
+	/* once: the device keeps its tree from one mount to the next */
+	if (yaffsfs_config[0].dev)
+		return 0;
+
+	flashDev = calloc(1, sizeof(yaffs_Device));
 	yaffsfs_config[0].dev = flashDev;
 
 	/* store the mtd device for later use */
@@ -265,13 +270,34 @@ void read_a_file(char *fn)
 	yaffs_close(h);
 }
 
+/*
+ * The mount is kept until yumount, with its object and tnode tree, so
+ * that the commands after the first need not mount again.  Mounting
+ * restores the tree from the checkpoint when that is valid, which the
+ * commands that change the file system write again when they are done.
+ */
 void cmd_yaffs_mount(char *mp)
 {
+	yaffs_Device *dev;
+	ulong start;
+	int retval;
+
+	if (isMounted) {
+		printf("%s is already mounted\n", mp);
+		return;
+	}
+
 	yaffs_StartUp();
-	int retval = yaffs_mount(mp);
-	if( retval != -1)
+	dev = yaffsfs_config[0].dev;
+
+	start = get_timer(0);
+	retval = yaffs_mount(mp);
+	if( retval != -1) {
 		isMounted = 1;
-	else
+		printf("Mounted %s in %lu ms, %s\n", mp, get_timer(start),
+		       dev->isCheckpointed ? "from the checkpoint" :
+		       "scanning the flash");
+	} else
 		printf("Error mounting %s, return value: %d\n", mp, yaffsfs_GetError());
 }
 
@@ -288,12 +314,23 @@ void cmd_yaffs_umount(char *mp)
 	checkMount();
 	if( yaffs_unmount(mp) == -1)
 		printf("Error umounting %s, return value: %d\n", mp, yaffsfs_GetError());
+	else
+		isMounted = 0;
+}
+
+/* After a change, so that the next mount need not scan */
+static void checkpoint(void)
+{
+	if (yaffs_sync(MOUNT_POINT) == -1)
+		printf("Error syncing %s, return value: %d\n", MOUNT_POINT,
+		       yaffsfs_GetError());
 }
 
 void cmd_yaffs_write_file(char *yaffsName,char bval,int sizeOfFile)
 {
 	checkMount();
 	make_a_file(yaffsName,bval,sizeOfFile);
+	checkpoint();
 }
 
 
@@ -342,6 +379,7 @@ void cmd_yaffs_mwrite_file(char *fn, char *addr, int size)
 	yaffs_write(outh,addr,size);
 
 	yaffs_close(outh);
+	checkpoint();
 }
 
 
@@ -387,6 +425,7 @@ void cmd_yaffs_mkdir(const char *dir)
 
 	if ( retval < 0)
 		printf("yaffs_mkdir returning error: %d\n", retval);
+	checkpoint();
 }
 
 void cmd_yaffs_rmdir(const char *dir)
@@ -397,6 +436,7 @@ void cmd_yaffs_rmdir(const char *dir)
 
 	if ( retval < 0)
 		printf("yaffs_rmdir returning error: %d\n", retval);
+	checkpoint();
 }
 
 void cmd_yaffs_rm(const char *path)
@@ -407,6 +447,7 @@ void cmd_yaffs_rm(const char *path)
 
 	if ( retval < 0)
 		printf("yaffs_unlink returning error: %d\n", retval);
+	checkpoint();
 }
 
 void cmd_yaffs_mv(const char *oldPath, const char *newPath)
@@ -417,4 +458,5 @@ void cmd_yaffs_mv(const char *oldPath, const char *newPath)
 
 	if ( retval < 0)
 		printf("yaffs_unlink returning error: %d\n", retval);
+	checkpoint();
 }
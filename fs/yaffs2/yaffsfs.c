@@ -1068,6 +1068,38 @@ int yaffs_mount(const char *path)
 
 }
 
+int yaffs_sync(const char *path)
+{
+	int retVal=-1;
+	yaffs_Device *dev=NULL;
+	char *dummy;
+
+	yaffsfs_Lock();
+	dev = yaffsfs_FindDevice(path,&dummy);
+	if(dev)
+	{
+		if(dev->isMounted)
+		{
+			// write what is cached, and a checkpoint for the next mount
+			yaffs_FlushEntireDeviceCache(dev);
+			yaffs_CheckpointSave(dev);
+			retVal = 0;
+		}
+		else
+		{
+			//todo error - not mounted.
+			yaffsfs_SetError(-EINVAL);
+		}
+	}
+	else
+	{
+		// todo error - no device
+		yaffsfs_SetError(-ENODEV);
+	}
+	yaffsfs_Unlock();
+	return retVal;
+}
+
 int yaffs_unmount(const char *path)
 {
 	int retVal=-1;
@@ -215,6 +215,7 @@ int yaffs_closedir(yaffs_DIR *dirp) ;
 
 int yaffs_mount(const char *path) ;
 int yaffs_unmount(const char *path) ;
+int yaffs_sync(const char *path) ;
 
 int yaffs_symlink(const char *oldpath, const char *newpath);
 int yaffs_readlink(const char *path, char *buf, int bufsiz);
@@ -48,6 +48,7 @@ typedef struct {
 	Altera_data_fn		data;
 	Altera_abort_fn		abort;
 	Altera_post_fn		post;
+	Altera_write_fn		write;	/* block write function, or NULL */
 } Altera_ACEX1K_Passive_Serial_fns;
 
 /* Slave Serial Implementation function table */
@@ -27,15 +27,22 @@
 
 #include <pci.h>
 
+/* Command slots used for native command queueing, one table each */
+#ifndef CONFIG_AHCI_NCQ_SLOTS
+#define CONFIG_AHCI_NCQ_SLOTS	8
+#endif
+
 #define AHCI_PCI_BAR		0x24
 #define AHCI_MAX_SG		56 /* hardware max is 64K */
+#define AHCI_MAX_CMDS		32
 #define AHCI_CMD_SLOT_SZ	32
+#define AHCI_CMD_LIST_SZ	(AHCI_MAX_CMDS * AHCI_CMD_SLOT_SZ)
 #define AHCI_RX_FIS_SZ		256
 #define AHCI_CMD_TBL_HDR	0x80
 #define AHCI_CMD_TBL_CDB	0x40
-#define AHCI_CMD_TBL_SZ		AHCI_CMD_TBL_HDR + (AHCI_MAX_SG * 16)
-#define AHCI_PORT_PRIV_DMA_SZ	AHCI_CMD_SLOT_SZ + AHCI_CMD_TBL_SZ	\
-				+ AHCI_RX_FIS_SZ
+#define AHCI_CMD_TBL_SZ		(AHCI_CMD_TBL_HDR + (AHCI_MAX_SG * 16))
+#define AHCI_PORT_PRIV_DMA_SZ	(AHCI_CMD_LIST_SZ + AHCI_RX_FIS_SZ	\
+				 + CONFIG_AHCI_NCQ_SLOTS * AHCI_CMD_TBL_SZ)
 #define AHCI_CMD_ATAPI		(1 << 5)
 #define AHCI_CMD_WRITE		(1 << 6)
 #define AHCI_CMD_PREFETCH	(1 << 7)
@@ -56,6 +63,10 @@
 #define HOST_IRQ_EN		(1 << 1)  /* global IRQ enable */
 #define HOST_AHCI_EN		(1 << 31) /* AHCI enabled */
 
+/* HOST_CAP bits */
+#define HOST_CAP_NCQ		(1 << 30) /* native command queueing */
+#define HOST_CAP_NCS(cap)	((((cap) >> 8) & 0x1f) + 1) /* slots */
+
 /* Registers for each SATA port */
 #define PORT_LST_ADDR		0x00 /* command list DMA addr */
 #define PORT_LST_ADDR_HI	0x04 /* command list DMA addr hi */
@@ -169,8 +180,9 @@ struct ahci_ioports {
 	u32	port_mmio;
 	struct ahci_cmd_hdr	*cmd_slot;
 	struct ahci_sg		*cmd_tbl_sg;
-	u32	cmd_tbl;
+	u32	cmd_tbl;	/* command table of slot 0, the others follow */
 	u32	rx_fis;
+	u32	ncq_slots;	/* slots used with NCQ, 0 if not supported */
 };
 
 struct ahci_probe_ent {
@@ -92,6 +92,9 @@ typedef int(*Altera_write_fn)(const void *buf, size_t len, int flush, int cookie
 typedef int (*Altera_abort_fn)( int cookie );
 typedef int (*Altera_post_fn)( int cookie );
 
+/* The block write function of the device's interface, or NULL */
+extern Altera_write_fn altera_get_write(Altera_desc *desc);
+
 typedef struct {
 	Altera_pre_fn pre;
 	Altera_config_fn config;
@@ -93,6 +93,9 @@ enum {
 	API_DISPLAY_GET_INFO,
 	API_DISPLAY_DRAW_BITMAP,
 	API_DISPLAY_CLEAR,
+	API_DEV_READV,
+	API_DEV_READ_SUBMIT,
+	API_DEV_READ_POLL,
 	API_MAXCALL
 };
 
@@ -122,6 +125,13 @@ typedef unsigned long lbasize_t;
 #endif
 typedef unsigned long lbastart_t;
 
+/* One range of a vectored storage read: len blocks from start to buf */
+struct stor_vec {
+	lbastart_t	start;
+	lbasize_t	len;
+	void		*buf;
+};
+
 #define DEV_TYP_NONE	0x0000
 #define DEV_TYP_NET	0x0001
 
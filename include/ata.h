@@ -111,6 +111,11 @@
 #define ATA_CMD_READ_EXT 0x24	/* Read Sectors (with retries)	with 48bit addressing */
 #define ATA_CMD_WRITE_EXT	0x34	/* Write Sectores (with retries) with 48bit addressing */
 #define ATA_CMD_VRFY_EXT	0x42	/* Read Verify	(with retries)	with 48bit addressing */
+#define ATA_CMD_RD_DMA_EXT	0x25	/* Read DMA	with 48bit addressing */
+#define ATA_CMD_WR_DMA_EXT	0x35	/* Write DMA	with 48bit addressing */
+#define ATA_CMD_RD_LOG_EXT	0x2F	/* Read Log	with 48bit addressing */
+#define ATA_CMD_RD_FPDMA	0x60	/* Read FPDMA Queued (NCQ)	*/
+#define ATA_CMD_WR_FPDMA	0x61	/* Write FPDMA Queued (NCQ)	*/
 
 /*
  * ATAPI Commands
@@ -0,0 +1,63 @@
+/*
+ * Bus master IDE DMA (SFF-8038i) helpers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __ATA_BMDMA_H
+#define __ATA_BMDMA_H
+
+/* Bus master registers, relative to the base of the channel */
+#define BMDMA_CMD		0x00
+#define BMDMA_STATUS		0x02
+#define BMDMA_PRD		0x04
+
+#define BMDMA_CMD_START		0x01
+#define BMDMA_CMD_TO_MEM	0x08	/* device to memory (disk read) */
+
+#define BMDMA_STAT_ACTIVE	0x01
+#define BMDMA_STAT_ERR		0x02
+#define BMDMA_STAT_INTR		0x04
+
+#define BMDMA_PRD_EOT		0x80000000
+
+/* Number of entries in the PRD table; each covers up to 64 KiB */
+#define BMDMA_PRD_ENTRIES	32
+
+/*
+ * Longest transfer of one command.  A buffer that is not 64 KiB
+ * aligned needs one PRD entry more than its size suggests.
+ */
+#define BMDMA_MAX_XFER		(1024 * 1024)
+
+/* Bus address of a buffer, for boards where PCI does not map 1:1 */
+#ifndef CONFIG_SYS_ATA_BMDMA_BUS
+#define CONFIG_SYS_ATA_BMDMA_BUS(addr)	((ulong)(addr))
+#endif
+
+#ifdef CONFIG_ATA_BMDMA
+/*
+ * Highest UDMA mode both the drive (IDENTIFY words 88 and 93) and the
+ * caller (max_mode, -1 for none) support, or -1 if the drive has none.
+ */
+int ata_bmdma_udma_mode(const hd_driveid_t *id, int max_mode, int cable80);
+
+/*
+ * Prepare the bus master engine at base for a read of len bytes into
+ * buf.  The ATA command must be issued between this and
+ * ata_bmdma_start().  Returns 0, or -1 if buf can not be used for DMA.
+ */
+int ata_bmdma_setup(ulong base, void *buf, ulong len);
+void ata_bmdma_start(ulong base);
+
+/*
+ * Wait up to timeout ms for the transfer to finish and stop the engine.
+ * Returns 0 on success, -1 on a timeout or bus error.
+ */
+int ata_bmdma_wait(ulong base, ulong timeout);
+#endif
+
+#endif /* __ATA_BMDMA_H */
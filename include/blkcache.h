@@ -0,0 +1,72 @@
+/*
+ * Block device read cache
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __BLKCACHE_H
+#define __BLKCACHE_H
+
+#ifdef CONFIG_BLOCK_CACHE
+/*
+ * The block_read functions of the interfaces call blkcache_read() first
+ * and return at once if it finds the whole request, and blkcache_fill()
+ * after they have read something from the device.  Writes, erases and
+ * rescans must call dev_invalidate() for the device, which drops its
+ * entries here and whatever else is cached about its contents.
+ */
+int blkcache_read(int iftype, int dev, lbaint_t start, lbaint_t blkcnt,
+		  unsigned long blksz, void *buffer);
+void blkcache_fill(int iftype, int dev, lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, const void *buffer);
+void blkcache_invalidate(int iftype, int dev);
+
+/*
+ * Called after blkcache_read() has missed.  If the request continues the
+ * previous one on the device, read a whole window through block_read and
+ * copy the request from it.  Returns 1 if the request has been served,
+ * 0 if the caller has to read it.
+ */
+#ifdef CONFIG_BLOCK_READAHEAD
+int blkcache_readahead(block_dev_desc_t *desc, lbaint_t start,
+		       lbaint_t blkcnt, void *buffer);
+#else
+static inline int blkcache_readahead(block_dev_desc_t *desc, lbaint_t start,
+				     lbaint_t blkcnt, void *buffer)
+{
+	return 0;
+}
+#endif
+
+struct block_cache_stats {
+	unsigned hits;
+	unsigned misses;
+	unsigned entries;		/* entries in use */
+	unsigned max_blocks_per_entry;
+	unsigned max_entries;
+};
+
+void blkcache_configure(unsigned blocks, unsigned entries);
+void blkcache_stats(struct block_cache_stats *stats);
+#else
+static inline int blkcache_read(int iftype, int dev, lbaint_t start,
+				lbaint_t blkcnt, unsigned long blksz,
+				void *buffer)
+{
+	return 0;
+}
+static inline void blkcache_fill(int iftype, int dev, lbaint_t start,
+				 lbaint_t blkcnt, unsigned long blksz,
+				 const void *buffer) {}
+static inline void blkcache_invalidate(int iftype, int dev) {}
+static inline int blkcache_readahead(block_dev_desc_t *desc, lbaint_t start,
+				     lbaint_t blkcnt, void *buffer)
+{
+	return 0;
+}
+#endif
+
+#endif /* __BLKCACHE_H */
@@ -0,0 +1,45 @@
+/*
+ * Block and MTD device I/O statistics
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __BLKSTATS_H
+#define __BLKSTATS_H
+
+#define BLKSTATS_READ	0
+#define BLKSTATS_WRITE	1
+
+#ifdef CONFIG_CMD_BLKSTATS
+/*
+ * Bracket each command sent to a device: the block devices by
+ * interface type and number, MTD devices by name.  bytes is what was
+ * transferred, 0 for a command that failed.
+ */
+unsigned long long blkstats_start(void);
+void blkstats_end(int iftype, int dev, int dir, unsigned long bytes,
+		  unsigned long long start);
+void blkstats_mtd_end(const char *name, int dir, unsigned long bytes,
+		      unsigned long long start);
+#else
+static inline unsigned long long blkstats_start(void)
+{
+	return 0;
+}
+
+static inline void blkstats_end(int iftype, int dev, int dir,
+				unsigned long bytes, unsigned long long start)
+{
+}
+
+static inline void blkstats_mtd_end(const char *name, int dir,
+				    unsigned long bytes,
+				    unsigned long long start)
+{
+}
+#endif
+
+#endif /* __BLKSTATS_H */
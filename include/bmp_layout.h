@@ -74,4 +74,23 @@ typedef struct bmp_image {
 #define BMP_BI_RLE8	1
 #define BMP_BI_RLE4	2
 
+/* x or y of "m" in the splashpos variable */
+#define BMP_ALIGN_CENTER	0x7FFF
+
+/*
+ * Copy rows of len bytes, from src on in steps of src_pitch to dst on
+ * in steps of dst_pitch; the pitches may be negative.  Boards with a
+ * blitter may provide their own.
+ */
+void bmp_blit(void *dst, long dst_pitch, const void *src, long src_pitch,
+	      ulong len, uint rows);
+
+/*
+ * Show a gzipped BMP at x, y on a cols x rows screen through display(),
+ * a few rows at a time.  Returns -1 if it is not a gzipped uncompressed
+ * BMP; the caller has to gunzip all of it then.
+ */
+int bmp_display_gz(ulong addr, int x, int y, int cols, int rows,
+		   int (*display)(ulong addr, int x, int y));
+
 #endif							/* _BMP_H_ */
@@ -0,0 +1,61 @@
+/*
+ * Boot stage timing
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __BOOTSTAGE_H
+#define __BOOTSTAGE_H
+
+/* Number of stages that can be recorded, later ones are dropped */
+#ifndef CONFIG_BOOTSTAGE_RECORDS
+#define CONFIG_BOOTSTAGE_RECORDS	64
+#endif
+
+/*
+ * Microseconds since the board came out of reset, or as near as the
+ * board can tell.  The default counts from the first call and has the
+ * resolution of get_timer(); boards with a free running counter may
+ * provide a better one.
+ */
+ulong timer_get_boot_us(void);
+
+#ifdef CONFIG_BOOTSTAGE
+/*
+ * Record the time at which boot stage id was reached, under the given
+ * name, and pass id on to show_boot_progress().  Negative ids are the
+ * error codes of show_boot_progress().  Returns the time recorded.
+ */
+ulong bootstage_mark_name(int id, const char *name);
+
+/* Print all stages recorded so far, with the time between them */
+void bootstage_report(void);
+
+/*
+ * Add the stages recorded so far to a /bootstage node of the device
+ * tree at blob, for the kernel to pick up.  Returns 0, or a libfdt
+ * error code.
+ */
+int bootstage_fdt_add_report(void *blob);
+#else
+static inline ulong bootstage_mark_name(int id, const char *name)
+{
+	show_boot_progress(id);
+	return 0;
+}
+
+static inline void bootstage_report(void) {}
+
+static inline int bootstage_fdt_add_report(void *blob)
+{
+	return 0;
+}
+#endif /* CONFIG_BOOTSTAGE */
+
+/* Stages are named after the function that reaches them */
+#define bootstage_mark(id)	bootstage_mark_name(id, __func__)
+
+#endif /* __BOOTSTAGE_H */
@@ -266,6 +266,14 @@ BZ_EXTERN int BZ_API(BZ2_bzBuffToBuffDecompress) (
       int           verbosity
    );
 
+/*
+ * U-Boot: BZ2_bzBuffToBuffDecompress() picking the memory mode, with
+ * the blocks decoded side by side on the secondary cores if there are
+ * (CONFIG_MP_JOBS)
+ */
+int bunzip2(char *dest, unsigned int *destLen, char *source,
+	    unsigned int sourceLen);
+
 
 /*--
    Code contributed by Yoshioka Tsuneo
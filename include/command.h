@@ -123,6 +123,13 @@ extern int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 #define Struct_Section  __attribute__((unused, section(".u_boot_cmd"), \
 		aligned(4)))
 
+/*
+ * Each command has a section of its own, which the linker scripts
+ * sort by name: find_cmd() can then search the table by halves.
+ */
+#define Struct_Section_Cmd(name) __attribute__((unused, \
+		section(".u_boot_cmd." #name), aligned(4)))
+
 #ifdef CONFIG_AUTO_COMPLETE
 # define _CMD_COMPLETE(x) x,
 #else
@@ -141,7 +148,7 @@ extern int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 	U_BOOT_CMD_MKENT_COMPLETE(name,maxargs,rep,cmd,usage,help,NULL)
 
 #define U_BOOT_CMD_COMPLETE(name,maxargs,rep,cmd,usage,help,comp) \
-	cmd_tbl_t __u_boot_cmd_##name Struct_Section = \
+	cmd_tbl_t __u_boot_cmd_##name Struct_Section_Cmd(name) = \
 		U_BOOT_CMD_MKENT_COMPLETE(name,maxargs,rep,cmd,usage,help,comp)
 
 #define U_BOOT_CMD(name,maxargs,rep,cmd,usage,help) \
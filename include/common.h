@@ -344,6 +344,26 @@ int env_complete(char *var, int maxv, char *cmdv[], int maxsz, char *buf);
 #endif
 int get_env_id (void);
 
+/*
+ * Subscription to an environment variable: changed() is called with
+ * the new value whenever the variable is set, and with NULL when it
+ * is deleted, so that a subsystem can keep it in parsed form instead
+ * of looking it up again each time it needs it.  The variable and
+ * priv are up to the subscriber.
+ */
+struct env_notifier {
+	const char *name;
+	void (*changed)(struct env_notifier *n, const char *value);
+	void *priv;
+	struct env_notifier *next;
+};
+
+/* Subscribe n; changed() is called right away with the current value */
+void env_notifier_register(struct env_notifier *n);
+
+/* Tell every subscriber about a new environment (env import, default) */
+void env_notify_all(void);
+
 void	pci_init      (void);
 void	pci_init_board(void);
 void	pciinfo	      (int, int);
@@ -568,6 +588,19 @@ void	_serial_puts   (const char *, const int);
 int	_serial_getc   (const int);
 int	_serial_tstc   (const int);
 
+/*
+ * Buffered output: write out what can be sent without waiting / all of
+ * it, and wait until it has been sent.  Call serial_flush() before the
+ * UART changes hands.
+ */
+#if defined(CONFIG_NS16550_TX_BUFFER) && !defined(CONFIG_NS16550_MIN_FUNCTIONS)
+void	serial_tx_poll(void);
+void	serial_flush(void);
+#else
+static inline void serial_tx_poll(void) {}
+static inline void serial_flush(void) {}
+#endif
+
 /* $(CPU)/speed.c */
 int	get_clocks (void);
 int	get_clocks_866 (void);
@@ -711,6 +744,19 @@ int	init_timebase (void);
 int gunzip(void *, int, unsigned char *, unsigned long *);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset);
+#ifdef CONFIG_LOAD_UNZIP
+/* returns 0 when more input is needed, 1 at the end, -1 on error */
+int gunzip_stream_start(void *dst, unsigned long dstlen);
+int gunzip_stream_feed(const void *src, unsigned long len,
+		       unsigned long *lenp);
+void gunzip_stream_end(void);
+#endif
+#if defined(CONFIG_VIDEO_BMP_GZIP) || defined(CONFIG_FPGA_GZIP)
+/* gunzip_read() returns less than len at the end, -1 on error */
+int gunzip_read_start(const void *src, unsigned long srclen);
+long gunzip_read(void *dst, unsigned long len);
+void gunzip_read_end(void);
+#endif
 
 /* lib/net_utils.c */
 #include <net.h>
@@ -758,6 +804,11 @@ int	ctrlc (void);
 int	had_ctrlc (void);	/* have we had a Control-C since last clear? */
 void	clear_ctrlc (void);	/* clear the Control-C condition */
 int	disable_ctrlc (int);	/* 1 to disable, 0 to enable Control-C detect */
+#ifdef CONFIG_CONSOLE_QUIET_BOOT
+void	console_quiet_flush(void);	/* print what "quiet" held back */
+#else
+static inline void console_quiet_flush(void) {}
+#endif
 
 /*
  * STDIO based functions (can always be used)
@@ -813,6 +864,8 @@ int	pcmcia_init (void);
  */
 void show_boot_progress(int val);
 
+#include <bootstage.h>
+
 /* Multicore arch functions */
 #ifdef CONFIG_MP
 int cpu_status(int nr);
@@ -282,6 +282,7 @@
 
 /* Defines for SPL */
 #define CONFIG_SPL
+#define CONFIG_SPL_FRAMEWORK
 #define CONFIG_SPL_TEXT_BASE		0x40200800
 #define CONFIG_SPL_MAX_SIZE		(45 * 1024)	/* 45 KB */
 #define CONFIG_SPL_STACK		LOW_LEVEL_SRAM_STACK
@@ -235,7 +235,10 @@
 					 CONFIG_SYS_INIT_RAM_SIZE - \
 					 GENERATED_GBL_DATA_SIZE)
 
-#ifndef CONFIG_SYS_L2CACHE_OFF
+#ifdef CONFIG_SYS_L2CACHE_OFF
+#define CONFIG_SYS_L2CACHE_BOOTM	/* still on while loading the OS */
+#endif
+#if !defined(CONFIG_SYS_L2CACHE_OFF) || defined(CONFIG_SYS_L2CACHE_BOOTM)
 #define CONFIG_SYS_L2_PL310		1
 #define CONFIG_SYS_PL310_BASE	0x48242000
 #endif
@@ -251,6 +254,7 @@
 
 /* Defines for SPL */
 #define CONFIG_SPL
+#define CONFIG_SPL_FRAMEWORK
 #define CONFIG_SPL_TEXT_BASE		0x40304350
 #define CONFIG_SPL_MAX_SIZE		(38 * 1024)
 #define CONFIG_SPL_STACK		LOW_LEVEL_SRAM_STACK
@@ -60,6 +60,7 @@
 #define CONFIG_PHYS_64BIT
 
 /* Size of our emulated memory */
+#define CONFIG_SYS_SDRAM_BASE		0x10000000
 #define CONFIG_SYS_SDRAM_SIZE		(128 << 20)
 
 #define CONFIG_BAUDRATE			115200
@@ -72,10 +73,40 @@
 /* include default commands */
 #include <config_cmd_default.h>
 
-/* We don't have networking support yet */
-#undef CONFIG_CMD_NET
 #undef CONFIG_CMD_NFS
 
+/* disk images and a tap interface of the host */
+#define CONFIG_SANDBOX_BLOCK
+#define CONFIG_SANDBOX_ETH
+#define CONFIG_DOS_PARTITION
+#define CONFIG_EFI_PARTITION
+#define CONFIG_EFI_PARTITION_CACHE
+#define CONFIG_CMD_FAT
+#define CONFIG_CMD_EXT2
+#define CONFIG_CMD_PING
+#define CONFIG_CMD_TIME
+#define CONFIG_CMD_TIME_ACCT
+#define CONFIG_PROBE_DEFER
+#define CONFIG_CMD_PROF
+#define CONFIG_KALLSYMS
+#define CONFIG_BLOCK_CACHE
+#define CONFIG_TFTP_WINDOWSIZE		16
+#define CONFIG_IPADDR			192.168.0.2
+#define CONFIG_SERVERIP			192.168.0.1
+#define CONFIG_NETMASK			255.255.255.0
+#define CONFIG_ETHADDR			02:00:00:00:00:01
+
+/* time the core algorithms with "bench" */
+#define CONFIG_CMD_BENCH
+#define CONFIG_CMD_HASH
+#define CONFIG_SHA1
+#define CONFIG_SHA256
+#define CONFIG_MD5
+#define CONFIG_BZIP2
+#define CONFIG_LZMA
+#define CONFIG_LZO
+#define CONFIG_FIT
+
 #define CONFIG_BOOTARGS ""
 
 #define CONFIG_EXTRA_ENV_SETTINGS	"stdin=serial\0" \
@@ -291,7 +291,7 @@
 #define CONFIG_EHCI_MMIO_BIG_ENDIAN
 #define CONFIG_EHCI_DESC_BIG_ENDIAN
 #ifdef CONFIG_4xx_DCACHE
-#define CONFIG_EHCI_DCACHE
+#define CONFIG_DMA_MAP
 #endif
 #else /* CONFIG_USB_EHCI */
 #define CONFIG_USB_OHCI_NEW
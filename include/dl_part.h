@@ -0,0 +1,75 @@
+/*
+ * Storage areas the download commands write images to
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __DL_PART_H
+#define __DL_PART_H
+
+struct dl_sparse;
+
+enum dl_part_type {
+	DL_PART_MMC,		/* raw blocks */
+	DL_PART_NAND,		/* raw, skipping bad blocks */
+	DL_PART_FAT,		/* a file named like the area */
+	DL_PART_UBI,		/* a volume named like the area */
+};
+
+/*
+ * An area is listed in an environment variable as
+ *
+ *	<name> mmc <dev> <start block> <blocks>
+ *	<name> nand <offset> <size>
+ *	<name> fat <dev> <partition>
+ *	<name> ubi
+ *
+ * with the numbers in hex and the areas separated by ';'.  UBI volumes
+ * are on the device "ubi part" selected.
+ */
+struct dl_part {
+	char		name[32];
+	enum dl_part_type type;
+	int		dev;
+	int		part;		/* FAT partition */
+	ulong		start;
+	ulong		size;		/* blocks for MMC, bytes for NAND */
+	ulong		image_len;	/* if known, else 0 */
+
+	/* while open */
+	u64		pos;		/* bytes written */
+	u64		nand_off;	/* where the next page goes */
+	u8		*tail;		/* a block or page not yet written */
+	ulong		tail_len;
+	ulong		unit;		/* size of that block or page */
+	struct dl_sparse *sparse;	/* a sparse image being unpacked */
+};
+
+/* Look an area up by name, or by its place in the list; 0 if found */
+int dl_part_find(const char *list, const char *name, struct dl_part *part);
+int dl_part_get(const char *list, int index, struct dl_part *part);
+
+/*
+ * Write an image in pieces of any size, one after the other; what
+ * does not fill a block is kept until the next piece or the close.
+ * An area that does not stream takes the whole image in one piece.
+ * A UBI volume update must know the size of the image up front, so
+ * image_len has to be set for those before the first piece.
+ * With CONFIG_SPARSE_IMAGE, an image starting with the sparse magic
+ * (include/sparse_format.h) is unpacked on the way.
+ */
+int dl_part_open(struct dl_part *part);
+int dl_part_write(struct dl_part *part, void *buf, ulong len);
+int dl_part_close(struct dl_part *part);
+
+int dl_part_erase(struct dl_part *part);
+
+static inline int dl_part_streams(const struct dl_part *part)
+{
+	return part->type != DL_PART_FAT;
+}
+
+#endif /* __DL_PART_H */
@@ -0,0 +1,72 @@
+/*
+ * Memory to memory copies through a DMA engine
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __DMA_H
+#define __DMA_H
+
+/*
+ * A driver for a DMA controller that can copy memory registers one of
+ * these.  Only one copy is in flight at a time.  Caches are written
+ * back and dropped around the copy unless the engine snoops them.
+ */
+struct dma_engine {
+	const char	*name;
+	ulong		min_len;	/* shorter copies are left to the CPU */
+	int		coherent;	/* engine snoops the data caches */
+	/* Start the copy: 0 when it is running, -1 if it can't be done */
+	int		(*start)(struct dma_engine *dma, ulong dst,
+				 ulong src, ulong len);
+	/* 0 while the copy is running, 1 once it is done, -1 on error */
+	int		(*poll)(struct dma_engine *dma);
+	void		*priv;
+	struct dma_engine *next;
+};
+
+/* Copies engines are worth setting up for, unless a driver knows better */
+#ifndef CONFIG_SYS_DMA_MEMCPY_MIN
+#define CONFIG_SYS_DMA_MEMCPY_MIN	(64 << 10)
+#endif
+
+#ifdef CONFIG_DMA_MEMCPY
+/* Called from cpu_dma_init() and board_dma_init() */
+int dma_engine_register(struct dma_engine *dma);
+int cpu_dma_init(void);
+int board_dma_init(void);
+
+/*
+ * Start copying len bytes from src to dst, which must not overlap.
+ * Returns 0 if an engine has taken the copy, then dst must not be
+ * read nor src written until dma_memcpy_wait(); -1 if the caller has
+ * to copy by itself.
+ */
+int dma_memcpy_start(void *dst, const void *src, size_t len);
+
+/* Wait for dma_memcpy_start(); 0 if the data has been copied */
+int dma_memcpy_wait(void);
+
+/* Both of the above: 0 if the data has been copied, -1 if not */
+int dma_memcpy(void *dst, const void *src, size_t len);
+#else
+static inline int dma_memcpy_start(void *dst, const void *src, size_t len)
+{
+	return -1;
+}
+
+static inline int dma_memcpy_wait(void)
+{
+	return 0;
+}
+
+static inline int dma_memcpy(void *dst, const void *src, size_t len)
+{
+	return -1;
+}
+#endif
+
+#endif /* __DMA_H */
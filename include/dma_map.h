@@ -0,0 +1,75 @@
+/*
+ * Data cache maintenance around DMA transfers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * A driver maps a buffer before it gives it to a bus master and unmaps
+ * it once the device is done.  Mapping writes back the cache lines of
+ * the buffer; unmapping a buffer the device wrote drops them, so the
+ * CPU reads what is in memory.  Only the lines the buffer touches are
+ * cleaned, whatever is around it stays in the cache.
+ *
+ * A line the buffer shares with other data can't be dropped without
+ * losing that data; it is written back, which overwrites the end of
+ * what the device wrote if the CPU wrote the other data meanwhile.  For
+ * buffers the device writes that do not start and end on
+ * ARCH_DMA_MINALIGN, dma_bounce_start() hands out an aligned one, and
+ * dma_bounce_stop() copies the data back.
+ *
+ * Without CONFIG_DMA_MAP mapping only calls flush_cache(), like drivers
+ * did before; nothing is dropped from the cache and nothing is bounced.
+ * Boards running with the data cache on define it.
+ */
+
+#ifndef __DMA_MAP_H
+#define __DMA_MAP_H
+
+#define DMA_MAP_TO_DEVICE	(1 << 0)	/* the device reads the buffer */
+#define DMA_MAP_FROM_DEVICE	(1 << 1)	/* the device writes it */
+#define DMA_MAP_BIDIRECTIONAL	(DMA_MAP_TO_DEVICE | DMA_MAP_FROM_DEVICE)
+
+struct dma_bounce {
+	void *user;		/* the buffer of the caller */
+	void *buf;		/* the buffer to give to the device */
+	size_t len;
+	unsigned int dir;
+};
+
+#ifdef CONFIG_DMA_MAP
+void dma_map_range(const void *p, size_t len, unsigned int dir);
+void dma_unmap_range(const void *p, size_t len, unsigned int dir);
+
+/* 0 and b->buf set up and mapped, or -1 if out of memory */
+int dma_bounce_start(struct dma_bounce *b, void *data, size_t len,
+		     unsigned int dir);
+void dma_bounce_stop(struct dma_bounce *b);
+#else
+static inline void dma_map_range(const void *p, size_t len, unsigned int dir)
+{
+	flush_cache((ulong)p, len);
+}
+
+static inline void dma_unmap_range(const void *p, size_t len,
+				   unsigned int dir)
+{
+}
+
+static inline int dma_bounce_start(struct dma_bounce *b, void *data,
+				   size_t len, unsigned int dir)
+{
+	b->user = b->buf = data;
+	b->len = len;
+	b->dir = dir;
+	dma_map_range(data, len, dir);
+	return 0;
+}
+
+static inline void dma_bounce_stop(struct dma_bounce *b)
+{
+}
+#endif
+
+#endif /* __DMA_MAP_H */
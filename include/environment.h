@@ -149,6 +149,12 @@ extern char *env_name_spec;
 
 #define ENV_SIZE (CONFIG_ENV_SIZE - ENV_HEADER_SIZE)
 
+#if defined(CONFIG_ENV_JOURNAL) && \
+	(defined(CONFIG_SYS_REDUNDAND_ENVIRONMENT) || \
+	 defined(ENV_IS_EMBEDDED) || defined(CONFIG_NAND_ENV_DST))
+#error "CONFIG_ENV_JOURNAL does not support redundant or embedded environments"
+#endif
+
 typedef struct environment_s {
 	uint32_t	crc;		/* CRC32 over data bytes	*/
 #ifdef CONFIG_SYS_REDUNDAND_ENVIRONMENT
@@ -193,6 +199,20 @@ void set_default_env(const char *s);
 /* Import from binary representation into hash table */
 int env_import(const char *buf, int check);
 
+#ifdef CONFIG_ENV_JOURNAL
+/* common/env_journal.c */
+int env_journal_import(const char *buf);
+/*
+ * Gets the area image for saveenv: the *len bytes at *off are to be
+ * written with align'ed offset and length.  Returns 0 when they are
+ * appended to erased space (or *len is 0: nothing changed), 1 when the
+ * area is to be erased first, -1 on error.  env_journal_done() is told
+ * whether the write failed.
+ */
+int env_journal_prepare(size_t align, env_t **img, size_t *off, size_t *len);
+void env_journal_done(int err);
+#endif
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENVIRONMENT_H_ */
@@ -79,3 +79,7 @@ extern int ext2fs_open (const char *filename);
 extern int ext2fs_read (char *buf, unsigned len);
 extern int ext2fs_mount (unsigned part_length);
 extern int ext2fs_close(void);
+
+/* Directory nodes come from a pool of CONFIG_SYS_EXT2_NODE_POOL entries */
+struct mem_pool;
+extern struct mem_pool ext2fs_node_pool;
@@ -40,7 +40,15 @@
 #define DIRENTSPERCLUST	((mydata->clust_size * mydata->sect_size) / \
 			 sizeof(dir_entry))
 
-#define FATBUFBLOCKS	6
+/*
+ * Sectors of the FAT read at a time.  Must be a multiple of 3, so that
+ * FAT12 entries never straddle two buffers.
+ */
+#ifdef CONFIG_FAT_BUFBLOCKS
+#define FATBUFBLOCKS	CONFIG_FAT_BUFBLOCKS
+#else
+#define FATBUFBLOCKS	48
+#endif
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
@@ -185,6 +193,12 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	short	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	int	fatbuf_dirty;	/* fatbuf holds updates not yet on the disk */
+	__u8	fats;		/* Number of copies of the FAT */
+	__u32	root_cluster;	/* First cluster of the root directory (FAT32) */
+	int	rootdir_size;	/* Sectors of the root directory (FAT12/16) */
+	__u32	total_sect;	/* Number of sectors of the volume */
+	__u32	free_clust;	/* Where to start looking for a free cluster */
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
@@ -209,8 +223,12 @@ int file_cd(const char *path);
 int file_fat_detectfs(void);
 int file_fat_ls(const char *dir);
 long file_fat_read(const char *filename, void *buffer, unsigned long maxsize);
+/* The same, starting pos bytes into the file */
+long file_fat_read_at(const char *filename, unsigned long pos, void *buffer,
+		      unsigned long maxsize);
 const char *file_getfsname(int idx);
 int fat_register_device(block_dev_desc_t *dev_desc, int part_no);
+void fat_invalidate(int iftype, int dev);
 
 int file_fat_write(const char *filename, void *buffer, unsigned long maxsize);
 #endif /* _FAT_H_ */
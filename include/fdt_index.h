@@ -0,0 +1,54 @@
+/*
+ * Index of the nodes of a device tree, for fast lookups
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __FDT_INDEX_H
+#define __FDT_INDEX_H
+
+#include <libfdt.h>
+
+/*
+ * These behave like the libfdt functions of the same name without
+ * "_index".  With CONFIG_OF_INDEX they use an index of the nodes of
+ * the blob, which is built on the first lookup and kept in step with
+ * the edits made through libfdt, instead of walking the tree.
+ */
+#ifdef CONFIG_OF_INDEX
+int fdt_index_path_offset(const void *fdt, const char *path);
+int fdt_index_node_offset_by_compatible(const void *fdt, int startoffset,
+					const char *compatible);
+int fdt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+#else
+static inline int fdt_index_path_offset(const void *fdt, const char *path)
+{
+	return fdt_path_offset(fdt, path);
+}
+
+static inline int fdt_index_node_offset_by_compatible(const void *fdt,
+		int startoffset, const char *compatible)
+{
+	return fdt_node_offset_by_compatible(fdt, startoffset, compatible);
+}
+
+static inline int fdt_index_node_offset_by_phandle(const void *fdt,
+						   uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+#endif
+
+/*
+ * Called by libfdt: struct block bytes [offset, offset + oldlen) have
+ * been replaced by newlen bytes, or the nodes have changed.  Whoever
+ * changes a blob by other means must call fdt_index_invalidate();
+ * NULL stands for any blob.
+ */
+void fdt_index_splice(const void *fdt, int offset, int oldlen, int newlen);
+void fdt_index_invalidate(const void *fdt);
+
+#endif /* __FDT_INDEX_H */
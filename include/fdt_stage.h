@@ -0,0 +1,60 @@
+/*
+ * Batched property edits of a device tree
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __FDT_STAGE_H
+#define __FDT_STAGE_H
+
+#include <libfdt.h>
+
+/*
+ * Every fdt_setprop() moves the rest of the blob along, so the fixups
+ * done before booting copy the tree over and over.  With CONFIG_OF_STAGE,
+ * between fdt_stage_begin() and fdt_stage_commit() the property changes
+ * made through fdt_stage_setprop() and fdt_stage_delprop() are only
+ * recorded, and the commit writes them all in one rebuild of the blob.
+ *
+ * While a stage is open, reading the blob still returns the values from
+ * before the stage.  Nodes are still added and removed at once, and the
+ * recorded changes follow them.  Without an open stage for this blob,
+ * and without CONFIG_OF_STAGE, the changes are made at once.
+ */
+#ifdef CONFIG_OF_STAGE
+int fdt_stage_begin(void *fdt);
+int fdt_stage_setprop(void *fdt, int nodeoffset, const char *name,
+		      const void *val, int len);
+int fdt_stage_delprop(void *fdt, int nodeoffset, const char *name);
+int fdt_stage_commit(void *fdt);
+#else
+static inline int fdt_stage_begin(void *fdt)
+{
+	return 0;
+}
+
+static inline int fdt_stage_setprop(void *fdt, int nodeoffset,
+		const char *name, const void *val, int len)
+{
+	return fdt_setprop(fdt, nodeoffset, name, val, len);
+}
+
+static inline int fdt_stage_delprop(void *fdt, int nodeoffset,
+				    const char *name)
+{
+	return fdt_delprop(fdt, nodeoffset, name);
+}
+
+static inline int fdt_stage_commit(void *fdt)
+{
+	return 0;
+}
+#endif
+
+/* Called by libfdt, like fdt_index_splice() */
+void fdt_stage_splice(const void *fdt, int offset, int oldlen, int newlen);
+
+#endif /* __FDT_STAGE_H */
@@ -106,6 +106,10 @@ extern void flash_protect (int flag, ulong from, ulong to, flash_info_t *info);
 extern int flash_write (char *, ulong, ulong);
 extern flash_info_t *addr2info (ulong);
 extern int write_buff (flash_info_t *info, uchar *src, ulong addr, ulong cnt);
+#ifdef CONFIG_SYS_FLASH_PARALLEL_BANKS
+extern int write_buff_banks(flash_info_t *first, flash_info_t *last,
+			    uchar *src, ulong addr, ulong cnt);
+#endif
 
 /* drivers/mtd/cfi_mtd.c */
 #ifdef CONFIG_FLASH_CFI_MTD
@@ -129,6 +133,10 @@ extern int jedec_flash_match(flash_info_t *info, ulong base);
 extern flash_info_t *flash_get_info(ulong base);
 #endif
 
+#ifdef CONFIG_SYS_FLASH_ERASE_PIPELINE
+extern int flash_erase_write(uchar *src, ulong addr, ulong cnt);
+#endif
+
 /*-----------------------------------------------------------------------
  * return codes from flash_write():
  */
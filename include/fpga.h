@@ -79,4 +79,19 @@ extern int fpga_load(int devnum, const void *buf, size_t bsize);
 extern int fpga_dump(int devnum, const void *buf, size_t bsize);
 extern int fpga_info(int devnum);
 
+/*
+ * Block write functions, as the interface tables of the device drivers
+ * have them: the device loaders hand them their data through
+ * fpga_block_write(), which feeds a compressed bitstream to them piece
+ * by piece as it is unpacked.
+ */
+typedef int (*fpga_bwr_fn)(const void *buf, size_t len, int flush, int cookie);
+extern int fpga_block_write(fpga_bwr_fn bwr, const void *buf, size_t bsize,
+			    int cookie);
+#ifdef CONFIG_FPGA_GZIP
+/* Load the bitstream that starts skip bytes into a gzip file */
+extern int fpga_load_gz(int devnum, const void *buf, size_t bsize,
+			size_t skip, size_t len);
+#endif
+
 #endif	/* _FPGA_H_ */
@@ -99,6 +99,8 @@
 #define PROCTL_INIT		0x00000020
 #define PROCTL_DTW_4		0x00000002
 #define PROCTL_DTW_8		0x00000004
+#define PROCTL_DMAS_MASK	0x00000300
+#define PROCTL_DMAS_ADMA2	0x00000200
 
 #define CMDARG			0x0002e008
 
@@ -162,6 +164,7 @@
 #define ESDHC_HOSTCAPBLT_SRS	0x00800000
 #define ESDHC_HOSTCAPBLT_DMAS	0x00400000
 #define ESDHC_HOSTCAPBLT_HSS	0x00200000
+#define ESDHC_HOSTCAPBLT_ADMAS	0x00100000
 
 struct fsl_esdhc_cfg {
 	u32	esdhc_base;
@@ -0,0 +1,33 @@
+/*
+ * Hash algorithms by name
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __HASH_H
+#define __HASH_H
+
+#define HASH_MAX_DIGEST_SIZE	32
+
+struct hash_algo {
+	const char *name;	/* as given to the hash command */
+	int digest_size;	/* in bytes */
+	/*
+	 * Hashes ilen bytes of input to output, serving the watchdog
+	 * every chunk_sz bytes; a hash engine gets the whole buffer.
+	 */
+	void (*hash_func_ws)(const unsigned char *input, unsigned int ilen,
+			     unsigned char *output, unsigned int chunk_sz);
+	unsigned int chunk_size;
+};
+
+/* The algorithm called name, or NULL if it isn't built in */
+struct hash_algo *hash_lookup_algo(const char *name);
+
+/* Prints the names of the algorithms built in, separated by spaces */
+void hash_show_algos(void);
+
+#endif /* __HASH_H */
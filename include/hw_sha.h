@@ -0,0 +1,36 @@
+/*
+ * Interface to SHA hash engines (crypto accelerators or CPU-specific
+ * implementations) used instead of the portable code in lib/sha1.c and
+ * lib/sha256.c when CONFIG_SHA_HW_ACCEL is set.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __HW_SHA_H
+#define __HW_SHA_H
+
+/**
+ * hw_sha256 - compute the SHA-256 digest of a buffer
+ *
+ * @in_addr:	input buffer
+ * @buflen:	length of the input in bytes
+ * @out_addr:	32 byte output buffer for the digest
+ * @chunk_size:	the watchdog must be served at least this often (in bytes
+ *		of input processed); engines that run in the background may
+ *		ignore it
+ */
+void hw_sha256(const unsigned char *in_addr, unsigned int buflen,
+	       unsigned char *out_addr, unsigned int chunk_size);
+
+/**
+ * hw_sha1 - compute the SHA-1 digest of a buffer
+ *
+ * Same as hw_sha256(), with a 20 byte digest.
+ */
+void hw_sha1(const unsigned char *in_addr, unsigned int buflen,
+	     unsigned char *out_addr, unsigned int chunk_size);
+
+#endif /* __HW_SHA_H */
@@ -56,6 +56,7 @@
 #include <fdt_support.h>
 #define CONFIG_MD5		/* FIT images need MD5 support */
 #define CONFIG_SHA1		/* and SHA1 */
+#define CONFIG_SHA256		/* and SHA256 */
 #endif
 
 /*
@@ -172,6 +173,7 @@
 #define IH_COMP_BZIP2		2	/* bzip2 Compression Used	*/
 #define IH_COMP_LZMA		3	/* lzma  Compression Used	*/
 #define IH_COMP_LZO		4	/* lzo   Compression Used	*/
+#define IH_COMP_LZ4		5	/* lz4   Compression Used	*/
 
 #define IH_MAGIC	0x27051956	/* Image Magic Number		*/
 #define IH_NMLEN		32	/* Image Name Length		*/
@@ -288,6 +290,10 @@ typedef struct bootm_headers {
 #define CHUNKSZ_SHA1 (64 * 1024)
 #endif
 
+#ifndef CHUNKSZ_SHA256
+#define CHUNKSZ_SHA256 (64 * 1024)
+#endif
+
 #define uimage_to_cpu(x)		be32_to_cpu(x)
 #define cpu_to_uimage(x)		cpu_to_be32(x)
 
@@ -510,6 +516,9 @@ static inline int image_check_target_arch(const image_header_t *hdr)
 
 /* image node */
 #define FIT_DATA_PROP		"data"
+#define FIT_DATA_PAD_PROP	"data-pad"
+#define FIT_DATA_OFFSET_PROP	"data-offset"
+#define FIT_DATA_SIZE_PROP	"data-size"
 #define FIT_TIMESTAMP_PROP	"timestamp"
 #define FIT_DESC_PROP		"description"
 #define FIT_ARCH_PROP		"arch"
@@ -525,7 +534,7 @@ static inline int image_check_target_arch(const image_header_t *hdr)
 #define FIT_FDT_PROP		"fdt"
 #define FIT_DEFAULT_PROP	"default"
 
-#define FIT_MAX_HASH_LEN	20	/* max(crc32_len(4), sha1_len(20)) */
+#define FIT_MAX_HASH_LEN	32	/* max(crc32(4), sha1(20), sha256(32)) */
 
 /* cmdline argument format parsing */
 inline int fit_parse_conf(const char *spec, ulong addr_curr,
@@ -549,16 +558,21 @@ static inline ulong fit_get_size(const void *fit)
 	return fdt_totalsize(fit);
 }
 
+/* Where the external data of the images starts, see mkimage -E */
+#define FIT_EXTERNAL_DATA(fit)	((fdt_totalsize(fit) + 3) & ~3)
+
+ulong fit_get_total_size(const void *fit);
+
 /**
  * fit_get_end - get FIT image end
  * @fit: pointer to the FIT format image header
  *
  * returns:
- *     end address of the FIT image (blob) in memory
+ *     end address of the FIT image in memory, external data included
  */
 static inline ulong fit_get_end(const void *fit)
 {
-	return (ulong)fit + fdt_totalsize(fit);
+	return (ulong)fit + fit_get_total_size(fit);
 }
 
 /**
@@ -587,11 +601,15 @@ int fit_image_get_load(const void *fit, int noffset, ulong *load);
 int fit_image_get_entry(const void *fit, int noffset, ulong *entry);
 int fit_image_get_data(const void *fit, int noffset,
 				const void **data, size_t *size);
+int fit_image_get_data_position(const void *fit, int noffset,
+				ulong *offset, size_t *size);
 
 int fit_image_hash_get_algo(const void *fit, int noffset, char **algo);
 int fit_image_hash_get_value(const void *fit, int noffset, uint8_t **value,
 				int *value_len);
 
+int calculate_hash(const void *data, int data_len, const char *algo,
+			uint8_t *value, int *value_len);
 int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
 int fit_set_hashes(void *fit);
 int fit_image_set_hashes(void *fit, int image_noffset);
@@ -599,6 +617,19 @@ int fit_image_hash_set_value(void *fit, int noffset, uint8_t *value,
 				int value_len);
 
 int fit_image_check_hashes(const void *fit, int noffset);
+#if defined(CONFIG_TPM_MEASURE) && !defined(USE_HOSTCC)
+/*
+ * For booted images: fit_image_check_hashes() that also queues the
+ * image for measurement, with the SHA-1 hash it verified if it has
+ * one; and the measurement only, for when the hashes are not checked.
+ */
+int fit_image_check_measure(const void *fit, int noffset);
+void fit_image_measure(const void *fit, int noffset);
+#else
+#define fit_image_check_measure(fit, noffset) \
+	fit_image_check_hashes(fit, noffset)
+static inline void fit_image_measure(const void *fit, int noffset) {}
+#endif
 int fit_all_image_check_hashes(const void *fit);
 int fit_image_check_os(const void *fit, int noffset, uint8_t os);
 int fit_image_check_arch(const void *fit, int noffset, uint8_t arch);
@@ -635,4 +666,12 @@ static inline int fit_image_check_target_arch(const void *fdt, int node)
 #endif /* CONFIG_FIT_VERBOSE */
 #endif /* CONFIG_FIT */
 
+#if defined(CONFIG_FIT) && defined(CONFIG_MP_JOBS) && !defined(USE_HOSTCC)
+void fit_hash_prefetch(const void *fit, int cfg_noffset);
+void fit_hash_release(void);
+#else
+static inline void fit_hash_prefetch(const void *fit, int cfg_noffset) {}
+static inline void fit_hash_release(void) {}
+#endif
+
 #endif	/* __IMAGE_H__ */
@@ -88,12 +88,15 @@ extern void nand_wait_ready(struct mtd_info *mtd);
 #define NAND_CMD_READID		0x90
 #define NAND_CMD_PARAM		0xec
 #define NAND_CMD_ERASE2		0xd0
+#define NAND_CMD_ERASE2_MULTI	0xd1
 #define NAND_CMD_RESET		0xff
 
 /* Extended commands for large page devices */
 #define NAND_CMD_READSTART	0x30
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
 
 /* Extended commands for AG-AND device */
 /*
@@ -132,6 +135,7 @@ typedef enum {
 	NAND_ECC_HW,
 	NAND_ECC_HW_SYNDROME,
 	NAND_ECC_HW_OOB_FIRST,
+	NAND_ECC_SOFT_BCH,
 } nand_ecc_modes_t;
 
 /*
@@ -177,6 +181,12 @@ typedef enum {
 #define NAND_NO_READRDY		0x00000100
 /* Chip does not allow subpage writes */
 #define NAND_NO_SUBPAGE_WRITE	0x00000200
+/* Chip has sequential cache read (31h/3Fh), from the ONFI parameters */
+#define NAND_CACHEREAD		0x00000400
+/* Cache program is known to work, from the ONFI parameters */
+#define NAND_CACHEPRG_ONFI	0x00000800
+/* Chip erases a block in each plane at once, from the ONFI parameters */
+#define NAND_MULTIPLANE_ERASE	0x00001000
 
 
 /* Options valid for Samsung large page devices */
@@ -281,6 +291,13 @@ struct nand_onfi_params {
 
 #define ONFI_CRC_BASE	0x4F4E
 
+/* ONFI optional commands (opt_cmd) */
+#define ONFI_OPT_CMD_PROG_CACHE	(1 << 0)
+#define ONFI_OPT_CMD_READ_CACHE	(1 << 1)
+
+/* ONFI features */
+#define ONFI_FEATURE_INTERLEAVED	(1 << 3)
+
 
 /**
  * struct nand_hw_control - Control structure for hardware controller (e.g ECC generator) shared among independent devices
@@ -308,6 +325,7 @@ struct nand_hw_control {
  * @prepad:	padding information for syndrome based ecc generators
  * @postpad:	padding information for syndrome based ecc generators
  * @layout:	ECC layout control struct pointer
+ * @priv:	pointer to private ECC control data
  * @hwctl:	function to control hardware ecc generator. Must only
  *		be provided if an hardware ECC is available
  * @calculate:	function for ecc calculation or readback from ecc hardware
@@ -315,6 +333,13 @@ struct nand_hw_control {
  * @read_page_raw:	function to read a raw page without ECC
  * @write_page_raw:	function to write a raw page without ECC
  * @read_page:	function to read a page according to the ecc generator requirements
+ * @read_page_start:	optional, start transferring the page the chip has just
+ *		loaded into buf (e.g. by DMA) and return without waiting
+ * @read_page_wait:	wait for the transfer started by read_page_start; the
+ *		chip may be sent the next command once this returns
+ * @read_page_correct:	check and correct the page read by the last
+ *		read_page_wait; returns like read_page.  Called after the
+ *		next page has been started, so the two overlap
  * @write_page:	function to write a page according to the ecc generator requirements
  * @read_oob:	function to read chip OOB data
  * @write_oob:	function to write chip OOB data
@@ -328,6 +353,7 @@ struct nand_ecc_ctrl {
 	int			prepad;
 	int			postpad;
 	struct nand_ecclayout	*layout;
+	void			*priv;
 	void			(*hwctl)(struct mtd_info *mtd, int mode);
 	int			(*calculate)(struct mtd_info *mtd,
 					     const uint8_t *dat,
@@ -344,6 +370,14 @@ struct nand_ecc_ctrl {
 	int			(*read_page)(struct mtd_info *mtd,
 					     struct nand_chip *chip,
 					     uint8_t *buf, int page);
+	int			(*read_page_start)(struct mtd_info *mtd,
+						   struct nand_chip *chip,
+						   uint8_t *buf, int page);
+	int			(*read_page_wait)(struct mtd_info *mtd,
+						  struct nand_chip *chip);
+	int			(*read_page_correct)(struct mtd_info *mtd,
+						     struct nand_chip *chip,
+						     uint8_t *buf, int page);
 	int			(*read_subpage)(struct mtd_info *mtd,
 					     struct nand_chip *chip,
 					     uint32_t offs, uint32_t len,
@@ -419,10 +453,13 @@ struct nand_buffers {
  * @numchips:		[INTERN] number of physical chips
  * @chipsize:		[INTERN] the size of one chip for multichip arrays
  * @pagemask:		[INTERN] page number mask = number of (pages / chip) - 1
+ * @plane_shift:	[INTERN] number of plane address bits, for multi-plane erase
  * @pagebuf:		[INTERN] holds the pagenumber which is currently in data_buf
  * @subpagesize:	[INTERN] holds the subpagesize
  * @ecclayout:		[REPLACEABLE] the default ecc placement scheme
  * @bbt:		[INTERN] bad block table pointer
+ * @bbt_cache:		[INTERN] blocks checked without a bad block table, two
+ *			bits per block: 0 unknown, 1 good, 2 bad
  * @bbt_td:		[REPLACEABLE] bad block table descriptor for flash lookup
  * @bbt_md:		[REPLACEABLE] bad block table mirror descriptor
  * @badblock_pattern:	[REPLACEABLE] bad block scan pattern used for initial bad block scan
@@ -467,6 +504,7 @@ struct nand_chip {
 	int		numchips;
 	uint64_t	chipsize;
 	int		pagemask;
+	int		plane_shift;
 	int		pagebuf;
 	int		subpagesize;
 	uint8_t		cellinfo;
@@ -490,6 +528,7 @@ struct nand_chip {
 	struct mtd_oob_ops ops;
 
 	uint8_t		*bbt;
+	uint8_t		*bbt_cache;
 	struct nand_bbt_descr	*bbt_td;
 	struct nand_bbt_descr	*bbt_md;
 
@@ -854,4 +854,7 @@ extern void usb_ep_autoconfig_reset(struct usb_gadget *);
 
 extern int usb_gadget_handle_interrupts(void);
 
+/* board hook: set up the device controller before a gadget registers */
+extern int board_usb_gadget_init(void);
+
 #endif	/* __LINUX_USB_GADGET_H */
@@ -14,6 +14,10 @@
  * 2 of the License, or (at your option) any later version.
  */
 
+/*
+ * Regions kept in the structure itself; after relocation the tables
+ * are moved to the heap when they fill up.
+ */
 #define MAX_LMB_REGIONS 8
 
 struct lmb_property {
@@ -24,12 +28,24 @@ struct lmb_property {
 struct lmb_region {
 	unsigned long cnt;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	unsigned long max;		/* room in region[], less one */
+	struct lmb_property *region;
+	struct lmb_property initial[MAX_LMB_REGIONS+1];
 };
 
+/* Where lmb_alloc() looks first for a free block */
+#define LMB_POLICY_TOP_DOWN	0	/* highest block that fits */
+#define LMB_POLICY_BEST_FIT	1	/* smallest hole that fits */
+
 struct lmb {
 	struct lmb_region memory;
 	struct lmb_region reserved;
+	int policy;
+	/* tried first when prefer_size is not 0, e.g. the fastest bank */
+	phys_addr_t prefer_base;
+	phys_size_t prefer_size;
+	/* alignment for blocks of at least this size, e.g. huge pages */
+	ulong align;
 };
 
 extern struct lmb lmb;
@@ -43,6 +59,7 @@ extern phys_addr_t lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align
 extern phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align,
 			      phys_addr_t max_addr);
 extern int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr);
+extern int lmb_is_free(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 extern long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size);
 
 extern void lmb_dump_all(struct lmb *lmb);
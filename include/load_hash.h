@@ -0,0 +1,92 @@
+/*
+ * Checksum images while they are being loaded
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __LOAD_HASH_H
+#define __LOAD_HASH_H
+
+struct cmd_tbl_s;
+
+#ifdef CONFIG_LOAD_HASH
+/*
+ * A load command (tftp, nfs, wget, mmc read, nand read, ...) calls
+ * load_hash_start() with its destination address, the low level code
+ * calls load_hash_update() for every piece of data it has just written
+ * to memory, and the command calls load_hash_finish() once the load has
+ * succeeded.  Data is only accounted for while it arrives in order; any
+ * gap, and anything that writes memory afterwards, drops the result.
+ */
+void load_hash_start(ulong addr);
+void load_hash_update(ulong addr, const void *data, ulong len);
+void load_hash_finish(void);
+void load_hash_invalidate(void);
+
+/*
+ * Called by the command loop before it runs cmdtp; drops the result
+ * unless the command is one that does not write memory.
+ */
+void load_hash_command(struct cmd_tbl_s *cmdtp);
+
+/*
+ * Return 0 and the CRC-32 of [addr, addr + len) if the last load covered
+ * exactly that range after an image header, -1 otherwise.
+ */
+int load_hash_get_dcrc(ulong addr, ulong len, uint32_t *crc);
+
+/*
+ * The same for the SHA-1 of the range, if its CRC matches dcrc, the one
+ * in the image header (CONFIG_TPM_MEASURE only).
+ */
+int load_hash_get_sha1(ulong addr, ulong len, uint32_t dcrc,
+		       uint8_t *digest);
+#else
+static inline void load_hash_start(ulong addr) {}
+static inline void load_hash_update(ulong addr, const void *data, ulong len) {}
+static inline void load_hash_finish(void) {}
+static inline void load_hash_invalidate(void) {}
+static inline void load_hash_command(struct cmd_tbl_s *cmdtp) {}
+static inline int load_hash_get_dcrc(ulong addr, ulong len, uint32_t *crc)
+{
+	return -1;
+}
+static inline int load_hash_get_sha1(ulong addr, ulong len, uint32_t dcrc,
+				     uint8_t *digest)
+{
+	return -1;
+}
+#endif
+
+#ifdef CONFIG_LOAD_UNZIP
+/*
+ * Called by the load_hash_*() functions above; a gzip'ed legacy kernel is
+ * inflated to its load address while it arrives.
+ */
+void load_unzip_start(ulong addr);
+void load_unzip_update(ulong addr, const void *data, ulong len);
+void load_unzip_finish(void);
+void load_unzip_invalidate(void);
+
+/*
+ * Return 0 and the uncompressed length if the image data at [data,
+ * data + len) has already been uncompressed to load, -1 otherwise.
+ */
+int load_unzip_get(ulong data, ulong len, ulong load, ulong *unc_len);
+#else
+static inline void load_unzip_start(ulong addr) {}
+static inline void load_unzip_update(ulong addr, const void *data,
+				     ulong len) {}
+static inline void load_unzip_finish(void) {}
+static inline void load_unzip_invalidate(void) {}
+static inline int load_unzip_get(ulong data, ulong len, ulong load,
+				 ulong *unc_len)
+{
+	return -1;
+}
+#endif
+
+#endif /* __LOAD_HASH_H */
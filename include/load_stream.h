@@ -0,0 +1,56 @@
+/*
+ * Program images to storage while they are being loaded
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __LOAD_STREAM_H
+#define __LOAD_STREAM_H
+
+#include <dl_part.h>
+
+#ifdef CONFIG_CMD_TFTPFLASH
+/*
+ * A command opens the area with load_stream_start(), giving it a ring
+ * buffer of size bytes.  While the stream is active the loader hands
+ * every piece of data to load_stream_store() instead of writing it to
+ * memory, calls load_stream_reset() when the transfer starts over, and
+ * load_stream_commit() when data stored out of order has become
+ * contiguous up to end, and load_stream_size() when it learns the
+ * length of the image early.  load_stream_poll() programs what has come in
+ * order, a piece at a time, from the loader's idle loop.  The command
+ * calls load_stream_finish() with the length of the image once the
+ * load has succeeded, and load_stream_abort() if it has not.
+ */
+int load_stream_start(const struct dl_part *part, void *buf, ulong size);
+int load_stream_active(void);
+int load_stream_store(ulong offset, const void *data, ulong len);
+void load_stream_commit(ulong end);
+void load_stream_size(ulong len);
+void load_stream_reset(void);
+int load_stream_poll(void);
+int load_stream_finish(ulong len);
+void load_stream_abort(void);
+#else
+static inline int load_stream_active(void)
+{
+	return 0;
+}
+static inline int load_stream_store(ulong offset, const void *data,
+				    ulong len)
+{
+	return -1;
+}
+static inline void load_stream_commit(ulong end) {}
+static inline void load_stream_size(ulong len) {}
+static inline void load_stream_reset(void) {}
+static inline int load_stream_poll(void)
+{
+	return 0;
+}
+#endif
+
+#endif /* __LOAD_STREAM_H */
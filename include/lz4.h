@@ -0,0 +1,39 @@
+/*
+ * LZ4 decompression
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __LZ4_H
+#define __LZ4_H
+
+/*
+ * Decompress one raw LZ4 block of src_len bytes into dst.  *dst_len
+ * is the room at dst on entry and the decompressed size on return.
+ */
+int lz4_decompress_block(const unsigned char *src, size_t src_len,
+			 unsigned char *dst, size_t *dst_len);
+
+/*
+ * Decompress the output of the lz4 tool: either the frame format
+ * ("lz4" files) or the legacy format that Linux uses with
+ * CONFIG_KERNEL_LZ4 ("lz4 -l").
+ */
+int lz4_decompress(const unsigned char *src, size_t src_len,
+		   unsigned char *dst, size_t *dst_len);
+
+/*
+ * Return values (< 0 = Error)
+ */
+#define LZ4_E_OK			0
+#define LZ4_E_ERROR			(-1)
+#define LZ4_E_INPUT_OVERRUN		(-4)
+#define LZ4_E_OUTPUT_OVERRUN		(-5)
+#define LZ4_E_LOOKBEHIND_OVERRUN	(-6)
+#define LZ4_E_BAD_HEADER		(-7)
+#define LZ4_E_NOT_YET_IMPLEMENTED	(-9)
+
+#endif /* __LZ4_H */
@@ -0,0 +1,59 @@
+/*
+ * Pools of equally sized objects, for buffers that are allocated and
+ * freed again on every transfer
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __MEM_POOL_H
+#define __MEM_POOL_H
+
+#include <malloc.h>
+
+/*
+ * The objects are carved out of a single memalign()ed block the first
+ * time the pool is used, and come back to a free list instead of going
+ * through free().  When the pool is empty, mem_pool_alloc() falls back
+ * to memalign(), so a pool sized too small is slower but still works.
+ */
+struct mem_pool {
+	ulong	size;		/* object size, a multiple of align	*/
+	ulong	count;		/* objects in the pool			*/
+	ulong	align;		/* alignment of every object		*/
+	char	*base;		/* NULL until first used		*/
+	void	*free_list;
+	ulong	used;		/* objects handed out right now		*/
+	ulong	max_used;
+	ulong	misses;		/* allocations that fell back to malloc	*/
+};
+
+#define MEM_POOL_INIT(_size, _count, _align) {				\
+	.size	= ((_size) + (_align) - 1) & ~((_align) - 1),		\
+	.count	= (_count),						\
+	.align	= (_align),						\
+}
+
+#ifdef CONFIG_MEM_POOL
+void *mem_pool_alloc(struct mem_pool *pool);
+void mem_pool_free(struct mem_pool *pool, void *obj);
+void mem_pool_stats(const char *name, struct mem_pool *pool);
+#else
+static inline void *mem_pool_alloc(struct mem_pool *pool)
+{
+	return memalign(pool->align, pool->size);
+}
+
+static inline void mem_pool_free(struct mem_pool *pool, void *obj)
+{
+	free(obj);
+}
+
+static inline void mem_pool_stats(const char *name, struct mem_pool *pool)
+{
+}
+#endif
+
+#endif /* __MEM_POOL_H */
@@ -80,6 +80,7 @@ void miiphy_listdev(void);
 struct mii_dev *mdio_alloc(void);
 int mdio_register(struct mii_dev *bus);
 void mdio_list_devices(void);
+struct mii_dev *mdio_next_dev(struct mii_dev *bus);
 
 #ifdef CONFIG_BITBANGMII
 
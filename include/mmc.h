@@ -42,12 +42,21 @@
 
 #define MMC_MODE_HS		0x001
 #define MMC_MODE_HS_52MHz	0x010
+#define MMC_MODE_DDR_52MHz	0x020
+#define MMC_MODE_HS200		0x040
 #define MMC_MODE_4BIT		0x100
 #define MMC_MODE_8BIT		0x200
 #define MMC_MODE_SPI		0x400
 #define MMC_MODE_HC		0x800
+#define MMC_MODE_UHS_SDR50	0x1000
+#define MMC_MODE_UHS_SDR104	0x2000
+#define MMC_MODE_UHS_DDR50	0x4000
+#define MMC_MODE_UHS		(MMC_MODE_UHS_SDR50 | MMC_MODE_UHS_SDR104 | \
+				 MMC_MODE_UHS_DDR50)
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_CMD23_SUPPORT	0x00000002	/* in scr[0] */
+#define SD_DATA_STAT_AFTER_ERASE 0x00800000	/* in scr[0]: erased reads 1s */
 
 #define IS_SD(x) (x->version & SD_VERSION_SD)
 
@@ -74,6 +83,8 @@
 #define MMC_CMD_SET_BLOCKLEN		16
 #define MMC_CMD_READ_SINGLE_BLOCK	17
 #define MMC_CMD_READ_MULTIPLE_BLOCK	18
+#define MMC_CMD_SEND_TUNING_BLOCK_HS200	21
+#define MMC_CMD_SET_BLOCK_COUNT		23
 #define MMC_CMD_WRITE_SINGLE_BLOCK	24
 #define MMC_CMD_WRITE_MULTIPLE_BLOCK	25
 #define MMC_CMD_ERASE_GROUP_START	35
@@ -86,6 +97,8 @@
 #define SD_CMD_SEND_RELATIVE_ADDR	3
 #define SD_CMD_SWITCH_FUNC		6
 #define SD_CMD_SEND_IF_COND		8
+#define SD_CMD_SWITCH_UHS18V		11
+#define SD_CMD_SEND_TUNING_BLOCK	19
 
 #define SD_CMD_APP_SET_BUS_WIDTH	6
 #define SD_CMD_ERASE_WR_BLK_START	32
@@ -96,17 +109,35 @@
 /* SCR definitions in different words */
 #define SD_HIGHSPEED_BUSY	0x00020000
 #define SD_HIGHSPEED_SUPPORTED	0x00020000
+#define SD_UHS_SDR50_SUPPORTED	0x00040000
+#define SD_UHS_SDR104_SUPPORTED	0x00080000
+#define SD_UHS_DDR50_SUPPORTED	0x00100000
+
+/* Access modes, function group 1 of CMD6 */
+#define SD_ACCESS_MODE_SDR25	1
+#define SD_ACCESS_MODE_SDR50	2
+#define SD_ACCESS_MODE_SDR104	3
+#define SD_ACCESS_MODE_DDR50	4
 
 #define MMC_HS_TIMING		0x00000100
 #define MMC_HS_52MHZ		0x2
 
 #define OCR_BUSY		0x80000000
 #define OCR_HCS			0x40000000
+#define OCR_S18R		0x01000000
 #define OCR_VOLTAGE_MASK	0x007FFF80
 #define OCR_ACCESS_MODE		0x60000000
 
 #define SECURE_ERASE		0x80000000
 
+/* CMD38 arguments */
+#define MMC_ERASE_ARG		0x00000000
+#define MMC_SECURE_ERASE_ARG	SECURE_ERASE
+#define MMC_TRIM_ARG		0x00000001
+#define MMC_DISCARD_ARG		0x00000003
+#define MMC_SECURE_TRIM1_ARG	0x80000001
+#define MMC_SECURE_TRIM2_ARG	0x80008000
+
 #define MMC_STATUS_MASK		(~0x0206BF7F)
 #define MMC_STATUS_RDY_FOR_DATA (1 << 8)
 #define MMC_STATUS_CURR_STATE	(0xf << 9)
@@ -146,29 +177,62 @@
  * EXT_CSD fields
  */
 #define EXT_CSD_PARTITIONING_SUPPORT	160	/* RO */
+#define EXT_CSD_WR_REL_PARAM		166	/* RO */
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
 #define EXT_CSD_REV			192	/* RO */
 #define EXT_CSD_CARD_TYPE		196	/* RO */
 #define EXT_CSD_SEC_CNT			212	/* RO, 4 bytes */
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
+#define EXT_CSD_SEC_FEATURE_SUPPORT	231	/* RO */
 
 /*
  * EXT_CSD field definitions
  */
 
+#define EXT_CSD_WR_REL_PARAM_EN		(1 << 2)	/* any block count */
+
+#define EXT_CSD_SEC_ER_EN		(1 << 0)	/* secure erase */
+#define EXT_CSD_SEC_GB_CL_EN		(1 << 4)	/* trim */
+
+#define MMC_SET_BLOCK_COUNT_RELIABLE	(1U << 31)
+
 #define EXT_CSD_CMD_SET_NORMAL		(1 << 0)
 #define EXT_CSD_CMD_SET_SECURE		(1 << 1)
 #define EXT_CSD_CMD_SET_CPSECURE	(1 << 2)
 
 #define EXT_CSD_CARD_TYPE_26	(1 << 0)	/* Card can run at 26MHz */
 #define EXT_CSD_CARD_TYPE_52	(1 << 1)	/* Card can run at 52MHz */
+#define EXT_CSD_CARD_TYPE_DDR_1_8V	(1 << 2) /* DDR at 52MHz, 1.8V or 3V I/O */
+#define EXT_CSD_CARD_TYPE_DDR_1_2V	(1 << 3) /* DDR at 52MHz, 1.2V I/O */
+#define EXT_CSD_CARD_TYPE_HS200_1_8V	(1 << 4) /* SDR at 200MHz, 1.8V I/O */
+#define EXT_CSD_CARD_TYPE_HS200_1_2V	(1 << 5) /* SDR at 200MHz, 1.2V I/O */
 
 #define EXT_CSD_BUS_WIDTH_1	0	/* Card is in 1 bit mode */
 #define EXT_CSD_BUS_WIDTH_4	1	/* Card is in 4 bit mode */
 #define EXT_CSD_BUS_WIDTH_8	2	/* Card is in 8 bit mode */
+#define EXT_CSD_BUS_WIDTH_4_DDR	5	/* Card is in 4 bit DDR mode */
+#define EXT_CSD_BUS_WIDTH_8_DDR	6	/* Card is in 8 bit DDR mode */
+
+#define EXT_CSD_TIMING_LEGACY	0	/* Backwards compatible timing */
+#define EXT_CSD_TIMING_HS	1	/* High speed */
+#define EXT_CSD_TIMING_HS200	2	/* HS200 */
+
+/* Bus timing the host has to use, see mmc->timing */
+#define MMC_TIMING_LEGACY	0
+#define MMC_TIMING_MMC_HS	1
+#define MMC_TIMING_SD_HS	2
+#define MMC_TIMING_MMC_DDR52	3
+#define MMC_TIMING_MMC_HS200	4
+#define MMC_TIMING_UHS_SDR50	5
+#define MMC_TIMING_UHS_SDR104	6
+#define MMC_TIMING_UHS_DDR50	7
+
+#define MMC_SIGNAL_VOLTAGE_330	0
+#define MMC_SIGNAL_VOLTAGE_180	1
 
 #define R1_ILLEGAL_COMMAND		(1 << 22)
 #define R1_APP_CMD			(1 << 5)
@@ -278,6 +342,8 @@ struct mmc {
 	uint voltages;
 	uint version;
 	uint has_init;
+	uint init_in_progress;	/* power-up started, see CONFIG_MMC_EARLY_INIT */
+	uint op_cond_sd;	/* ... with ACMD41, else with CMD1 */
 	uint f_min;
 	uint f_max;
 	int high_capacity;
@@ -302,9 +368,31 @@ struct mmc {
 			struct mmc_cmd *cmd, struct mmc_data *data);
 	void (*set_ios)(struct mmc *mmc);
 	int (*init)(struct mmc *mmc);
+	/*
+	 * Run the tuning procedure with the given command.  Only used,
+	 * and must then be set, if host_caps contains MMC_MODE_HS200 or
+	 * any of MMC_MODE_UHS; may be NULL if the host does not need
+	 * tuning.
+	 */
+	int (*execute_tuning)(struct mmc *mmc, uint opcode);
+	/*
+	 * Switch the I/O lines to MMC_SIGNAL_VOLTAGE_180 or back to _330
+	 * and, for 1.8V, check the card drives DAT[3:0] high again.
+	 * Must be set if host_caps contains any of MMC_MODE_UHS.
+	 */
+	int (*set_signal_voltage)(struct mmc *mmc, uint voltage);
+	uint timing;
 	uint b_max;
+	uint cmd23;		/* multi-block transfers preceded by CMD23 */
+	uint rel_wr;		/* ... and writes made reliable with it */
+	uint erase_caps;	/* MMC_ERASE_CAP_* besides a plain erase */
 };
 
+#define MMC_ERASE_CAP_TRIM	(1 << 0)
+#define MMC_ERASE_CAP_DISCARD	(1 << 1)
+#define MMC_ERASE_CAP_SECURE	(1 << 2)
+#define MMC_ERASE_CAP_ZERO	(1 << 3)	/* erased blocks read as 0 */
+
 int mmc_register(struct mmc *mmc);
 int mmc_initialize(bd_t *bis);
 int mmc_init(struct mmc *mmc);
@@ -316,6 +404,11 @@ void print_mmc_devices(char separator);
 int get_mmc_num(void);
 int board_mmc_getcd(u8 *cd, struct mmc *mmc);
 int mmc_switch_part(int dev_num, unsigned int part_num);
+/*
+ * Erase blkcnt blocks from start with one of the CMD38 arguments;
+ * returns the number of blocks erased.
+ */
+ulong mmc_erase_blocks(int dev_num, ulong start, lbaint_t blkcnt, uint arg);
 
 #ifdef CONFIG_GENERIC_MMC
 int atmel_mci_init(void *regs);
@@ -0,0 +1,84 @@
+/*
+ * Run work items on the secondary cores
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __MP_JOB_H
+#define __MP_JOB_H
+
+struct mp_job;
+typedef void (*mp_job_fn)(struct mp_job *job);
+
+/*
+ * A job is a function and its arguments.  It runs on a core that has
+ * neither a console nor global data, and at the same time as the boot
+ * core: it may only touch the memory it is given, and must not print,
+ * allocate, or reset the watchdog.
+ */
+struct mp_job {
+	mp_job_fn	func;
+	ulong		arg[4];		/* meaning is up to func	*/
+	long		result;		/* set by func			*/
+	volatile int	state;
+};
+
+enum {
+	MP_JOB_IDLE,		/* never started		*/
+	MP_JOB_BUSY,		/* handed to a core		*/
+	MP_JOB_DONE,		/* result is valid		*/
+};
+
+#ifdef CONFIG_MP_JOBS
+/*
+ * Hand job to an idle secondary core.  Returns 0 if the job has been
+ * started, -1 if no core is free; the job has not run then.
+ */
+int mp_job_start(struct mp_job *job);
+
+/* Start job on a free core, or run it here if there is none */
+void mp_job_run(struct mp_job *job);
+
+/* Wait for a started job to finish and return its result */
+long mp_job_wait(struct mp_job *job);
+
+/*
+ * Jobs for the usual bulk work:
+ *   mp_job_memcpy	arg[0] dest, arg[1] src, arg[2] length
+ *   mp_job_crc32	arg[0] address, arg[1] length; result is the CRC-32
+ *   mp_job_memtest	arg[0] address, arg[1] length; writes and checks an
+ *			address pattern, result is the number of bad words
+ */
+void mp_job_memcpy(struct mp_job *job);
+void mp_job_crc32(struct mp_job *job);
+void mp_job_memtest(struct mp_job *job);
+
+/*
+ * Provided by the CPU code: start core nr (1 and up, 0 is the boot
+ * core) at entry(arg), with its stack pointer at sp and memory mapped
+ * and cached as on the boot core.  Returns 0 on success, -1 if there
+ * is no such core or it can not be started.
+ */
+int cpu_job_release(int nr, void (*entry)(void *), void *arg, ulong sp);
+#else
+static inline int mp_job_start(struct mp_job *job)
+{
+	return -1;
+}
+
+static inline void mp_job_run(struct mp_job *job)
+{
+	job->func(job);
+	job->state = MP_JOB_DONE;
+}
+
+static inline long mp_job_wait(struct mp_job *job)
+{
+	return job->result;
+}
+#endif
+
+#endif /* __MP_JOB_H */
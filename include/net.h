@@ -84,15 +84,23 @@ struct eth_device {
 	int  (*init) (struct eth_device*, bd_t*);
 	int  (*send) (struct eth_device*, volatile void* packet, int length);
 	int  (*recv) (struct eth_device*);
+	/* optional: pass up to 'budget' ready frames, return how many */
+	int  (*recv_batch) (struct eth_device*, int budget);
 	void (*halt) (struct eth_device*);
 #ifdef CONFIG_MCAST_TFTP
 	int (*mcast) (struct eth_device*, u32 ip, u8 set);
 #endif
 	int  (*write_hwaddr) (struct eth_device*);
+	int csum_offload;	/* ETH_CSUM_* done by the hardware */
+	int max_mtu;		/* largest IP packet sent or received, 0: 1500 */
 	struct eth_device *next;
 	void *priv;
 };
 
+/* Checksum offloads of an eth_device */
+#define ETH_CSUM_RX	0x01	/* frames with a bad IP, UDP or TCP sum dropped */
+#define ETH_CSUM_TX	0x02	/* IP header and UDP sums filled in on send */
+
 extern int eth_initialize(bd_t *bis);	/* Initialize network subsystem */
 extern int eth_register(struct eth_device* dev);/* Register network device */
 extern void eth_try_another(int first_restart);	/* Change the device */
@@ -126,7 +134,30 @@ extern int eth_receive(volatile void *packet, int length); /* Receive a packet*/
 #endif
 extern int eth_rx(void);			/* Check for received packets */
 extern void eth_halt(void);			/* stop SCC */
+
+/*
+ * The protocols are done with the device, for now: eth_park() halts it,
+ * unless CONFIG_NET_KEEP_LINK keeps it up for the next network command
+ * until eth_halt_all() is called before an image is started.
+ */
+#ifdef CONFIG_NET_KEEP_LINK
+static inline void eth_park(void)
+{
+}
+
+extern void eth_halt_all(void);
+#else
+static inline void eth_park(void)
+{
+	eth_halt();
+}
+
+static inline void eth_halt_all(void)
+{
+}
+#endif
 extern char *eth_get_name(void);		/* get name of current device */
+extern int eth_get_mtu(void);		/* largest IP packet of the device */
 
 /*
  * Set the hardware address for an ethernet interface based on 'eth%daddr'
@@ -187,8 +218,10 @@ typedef struct {
 #define PROT_ARP	0x0806		/* IP ARP protocol		*/
 #define PROT_RARP	0x8035		/* IP ARP protocol		*/
 #define PROT_VLAN	0x8100		/* IEEE 802.1q protocol		*/
+#define PROT_AOE	0x88a2		/* ATA over Ethernet		*/
 
 #define IPPROTO_ICMP	 1	/* Internet Control Message Protocol	*/
+#define IPPROTO_TCP	 6	/* Transmission Control Protocol	*/
 #define IPPROTO_UDP	17	/* User Datagram Protocol		*/
 
 /*
@@ -300,10 +333,19 @@ typedef struct icmphdr {
  * maximum packet size =  1518
  * maximum packet size and multiple of 32 bytes =  1536
  */
+#ifdef CONFIG_NET_JUMBO
+/* jumbo frames: 9000 bytes of IP packet, the ethernet header and CRC */
+#define PKTSIZE			9018
+#define PKTSIZE_ALIGN		9024
+#else
 #define PKTSIZE			1518
 #define PKTSIZE_ALIGN		1536
+#endif
 /*#define PKTSIZE		608*/
 
+/* Largest IP packet that fits into the packet buffers */
+#define ETH_MTU_MAX		(PKTSIZE - 18)
+
 /*
  * Maximum receive ring size; that is, the number of packets
  * we can buffer before overflow happens. Basically, this just
@@ -368,7 +410,7 @@ extern int		NetRestartWrap;		/* Tried all network devices	*/
 
 enum proto_t {
 	BOOTP, RARP, ARP, TFTPGET, DHCP, PING, DNS, NFS, CDP, NETCONS, SNTP,
-	TFTPSRV, TFTPPUT
+	TFTPSRV, TFTPPUT, WGET, TFTPMULTI, AOE
 };
 
 /* from net/net.c */
@@ -394,9 +436,41 @@ extern IPaddr_t	NetNtpServerIP;			/* the ip address to NTP	*/
 extern int NetTimeOffset;			/* offset time from UTC		*/
 #endif
 
+#if defined(CONFIG_CMD_AOE)
+/* Find the AoE targets shelf.slot, 0xffff and 0xff matching any */
+extern int aoe_discover(int major, int minor);
+extern void aoe_print_devs(void);
+#endif
+
 /* Initialize the network adapter */
 extern int NetLoop(enum proto_t);
 
+#ifdef CONFIG_CMD_TFTP_MULTI
+/* The files for NetLoop(TFTPMULTI); TftpMultiAdd() is -1 when full */
+extern void TftpMultiClear(void);
+extern int TftpMultiAdd(ulong addr, const char *filename);
+/* Missing files allowed; TftpMultiSize() is -1 for those afterwards */
+extern void TftpMultiProbe(ulong max_size);
+extern long TftpMultiSize(int i);
+#endif
+
+/*
+ * Sends what the network console holds back; nc_sync() also has it send
+ * all output right away from then on, for when U-Boot is leaving.
+ */
+#ifdef CONFIG_NETCONSOLE
+extern void nc_flush(void);
+extern void nc_sync(void);
+#else
+static inline void nc_flush(void)
+{
+}
+
+static inline void nc_sync(void)
+{
+}
+#endif
+
 /* Shutdown adapters and cleanup */
 extern void	NetStop(void);
 
@@ -411,10 +485,17 @@ extern int	NetSetEther(volatile uchar *, uchar *, uint);
 
 /* Set IP header */
 extern void	NetSetIP(volatile uchar *, IPaddr_t, int, int, int);
+/* Set IP header only, for protocols other than UDP */
+extern void	net_set_ip_header(volatile uchar *, IPaddr_t, int, int);
 
 /* Checksum */
 extern int	NetCksumOk(uchar *, int);	/* Return true if cksum OK	*/
 extern uint	NetCksum(uchar *, int);		/* Calculate the checksum	*/
+/* Sum of a UDP or TCP segment and its pseudo header; 0xffff if it is OK */
+extern uint	net_pseudo_cksum(IPaddr_t src, IPaddr_t dst, int proto,
+				 uchar *seg, unsigned len);
+/* Nonzero if the current device does all of the ETH_CSUM_* flags */
+extern int	net_csum_offload(int flags);
 
 /* Set callbacks */
 extern void	NetSetHandler(rxhand_f *);	/* Set RX packet handler	*/
@@ -427,9 +508,23 @@ extern void	NetSendPacket(volatile uchar *, int);
 /* Transmit UDP packet, performing ARP request if needed */
 extern int	NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len);
 
+/*
+ * Transmit an IP packet of the given protocol whose payload has been
+ * built at NetTxPacket + NetEthHdrSize() + IP_HDR_SIZE_NO_UDP, performing
+ * ARP request if needed
+ */
+extern int	net_send_ip_packet(uchar *ether, IPaddr_t dest, int proto, int len);
+
 /* Processes a received packet */
 extern void	NetReceive(volatile uchar *, int);
 
+/*
+ * Copy received payload to its final place in memory.  This is the one
+ * copy a file transfer protocol (TFTP, NFS) does on data handed in by
+ * the driver; boards may override it, e.g. to use a DMA engine.
+ */
+extern void	net_store_payload(ulong dst, const void *src, unsigned len);
+
 /*
  * Check if autoload is enabled. If so, use either NFS or TFTP to download
  * the boot file.
@@ -167,3 +167,12 @@ void NS16550_putc(NS16550_t com_port, char c);
 char NS16550_getc(NS16550_t com_port);
 int NS16550_tstc(NS16550_t com_port);
 void NS16550_reinit(NS16550_t com_port, int baud_divisor);
+
+#if defined(CONFIG_NS16550_TX_BUFFER) && !defined(CONFIG_NS16550_MIN_FUNCTIONS)
+/* Write out some of what is buffered / all of it, and wait until sent */
+void NS16550_tx_poll(NS16550_t com_port);
+void NS16550_flush(NS16550_t com_port);
+#else
+static inline void NS16550_tx_poll(NS16550_t com_port) {}
+static inline void NS16550_flush(NS16550_t com_port) {}
+#endif
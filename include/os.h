@@ -45,15 +45,37 @@ ssize_t os_read(int fd, void *buf, size_t count);
  */
 ssize_t os_write(int fd, const void *buf, size_t count);
 
+/**
+ * Access to the OS lseek() system call
+ *
+ * \param fd	File descriptor as returned by os_open()
+ * \param offset	File offset (based on whence)
+ * \param whence	Position offset is relative to (see below)
+ * \return new file offset, or -1 on error
+ */
+off_t os_lseek(int fd, off_t offset, int whence);
+
+/* Defines for "whence" in os_lseek() */
+#define OS_SEEK_SET	0
+#define OS_SEEK_CUR	1
+#define OS_SEEK_END	2
+
 /**
  * Access to the OS open() system call
  *
  * \param pathname	Pathname of file to open
- * \param flags		Flags, like O_RDONLY, O_RDWR
+ * \param flags		Flags, like OS_O_RDONLY, OS_O_RDWR
  * \return file descriptor, or -1 on error
  */
 int os_open(const char *pathname, int flags);
 
+/* The host's O_ values are not known here; os_open() translates these */
+#define OS_O_RDONLY	0
+#define OS_O_WRONLY	1
+#define OS_O_RDWR	2
+#define OS_O_MASK	3	/* Mask for read/write flags */
+#define OS_O_CREAT	0100
+
 /**
  * Access to the OS close() system call
  *
@@ -85,6 +107,16 @@ void os_tty_raw(int fd);
  */
 void *os_malloc(size_t length);
 
+/**
+ * Acquires memory at a fixed address, so that addresses given to U-Boot
+ * commands are valid pointers in the process as well.
+ *
+ * \param addr		Where the memory must start
+ * \param length	Number of bytes to be allocated
+ * \return Pointer to length bytes at addr, or NULL if that is taken
+ */
+void *os_malloc_at(unsigned long addr, size_t length);
+
 /**
  * Access to the usleep function of the os
  *
@@ -98,3 +130,25 @@ void os_usleep(unsigned long usec);
  * \return A monotonic increasing time scaled in nano seconds
  */
 u64 os_get_nsec(void);
+
+/**
+ * Opens a host TAP network interface for raw Ethernet frames
+ *
+ * The interface must exist and be usable by the user running U-Boot,
+ * e.g. created with "ip tuntap add dev tap0 mode tap user $USER".
+ * Reads do not block; each returns one frame, or -1 if none is there.
+ *
+ * \param ifname	Name of the interface
+ * \return file descriptor, or -1 on error
+ */
+int os_tap_open(const char *ifname);
+
+/**
+ * Call a function with the interrupted program counter at a fixed rate
+ * of the process's CPU time (SIGPROF), for the sampling profiler.
+ *
+ * \param hz		Samples per second, 0 to stop
+ * \param handler	Function to call from the signal handler
+ * \return 0 if OK, -1 on error
+ */
+int os_prof_timer(unsigned int hz, void (*handler)(unsigned long pc));
@@ -65,6 +65,8 @@ typedef struct block_dev_desc {
 #define IF_TYPE_MMC		6
 #define IF_TYPE_SD		7
 #define IF_TYPE_SATA		8
+#define IF_TYPE_HOST		9
+#define IF_TYPE_AOE		10
 
 /* Part types */
 #define PART_TYPE_UNKNOWN	0x00
@@ -105,6 +107,10 @@ block_dev_desc_t* usb_stor_get_dev(int dev);
 block_dev_desc_t* mmc_get_dev(int dev);
 block_dev_desc_t* systemace_get_dev(int dev);
 block_dev_desc_t* mg_disk_get_dev(int dev);
+block_dev_desc_t *host_get_dev(int dev);
+int host_dev_bind(int dev, const char *filename);
+block_dev_desc_t *aoe_get_dev(int dev);
+void dev_invalidate(int iftype, int dev);
 
 /* disk/part.c */
 int get_partition_info (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
@@ -120,6 +126,9 @@ static inline block_dev_desc_t* usb_stor_get_dev(int dev) { return NULL; }
 static inline block_dev_desc_t* mmc_get_dev(int dev) { return NULL; }
 static inline block_dev_desc_t* systemace_get_dev(int dev) { return NULL; }
 static inline block_dev_desc_t* mg_disk_get_dev(int dev) { return NULL; }
+static inline block_dev_desc_t *host_get_dev(int dev) { return NULL; }
+static inline block_dev_desc_t *aoe_get_dev(int dev) { return NULL; }
+static inline void dev_invalidate(int iftype, int dev) {}
 
 static inline int get_partition_info (block_dev_desc_t * dev_desc, int part,
 	disk_partition_t *info) { return -1; }
@@ -159,6 +168,10 @@ int   test_part_amiga (block_dev_desc_t *dev_desc);
 #ifdef CONFIG_EFI_PARTITION
 /* disk/part_efi.c */
 int get_partition_info_efi (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
+int get_partition_info_efi_by_name(block_dev_desc_t *dev_desc,
+				   const char *name, disk_partition_t *info);
+int get_partition_info_efi_by_guid(block_dev_desc_t *dev_desc,
+				   const char *guid, disk_partition_t *info);
 void print_part_efi (block_dev_desc_t *dev_desc);
 int   test_part_efi (block_dev_desc_t *dev_desc);
 #endif
@@ -102,6 +102,9 @@ struct mii_dev {
 	int (*reset)(struct mii_dev *bus);
 	struct phy_device *phymap[PHY_MAX_ADDR];
 	u32 phy_mask;
+#ifdef CONFIG_PHYLIB_EARLY_ANEG
+	u32 aneg_early;		/* PHYs negotiating since phy_early_aneg() */
+#endif
 };
 
 /* struct phy_driver: a structure which defines PHY behavior
@@ -205,6 +208,11 @@ struct phy_device *phy_connect(struct mii_dev *bus, int addr,
 int phy_startup(struct phy_device *phydev);
 int phy_config(struct phy_device *phydev);
 int phy_shutdown(struct phy_device *phydev);
+#ifdef CONFIG_PHYLIB_EARLY_ANEG
+void phy_early_aneg(void);
+#endif
+/* 1 if the PHY of dev has link, 0 if not, -1 if dev has no PHY we know */
+int phy_link_state(struct eth_device *dev);
 int phy_register(struct phy_driver *drv);
 int genphy_config_aneg(struct phy_device *phydev);
 int genphy_update_link(struct phy_device *phydev);
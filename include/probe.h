@@ -0,0 +1,59 @@
+/*
+ * Deferred device probing
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * A driver whose probe mostly waits for the hardware (reset recovery,
+ * card power-up, link training) starts the operation from its init
+ * function in board_init_r and queues the rest with probe_defer().  The
+ * waits of all queued probes then run in parallel with each other and
+ * with the rest of the boot; each probe is finished the first time its
+ * devices are used, through probe_finish(), and all of them before an
+ * operating system is started.
+ *
+ * Without CONFIG_PROBE_DEFER, probe_defer() finishes the probe at once.
+ */
+
+#ifndef __PROBE_H
+#define __PROBE_H
+
+struct probe_defer {
+	const char *name;		/* printed when finished late */
+	int (*finish)(void);		/* the waiting half of the probe */
+	int pending;
+	int ret;			/* what finish() returned */
+	struct probe_defer *next;
+};
+
+#define PROBE_DEFER_INIT(_name, _finish)	\
+	{ .name = _name, .finish = _finish }
+
+#ifdef CONFIG_PROBE_DEFER
+void probe_defer(struct probe_defer *p);
+int probe_finish(struct probe_defer *p);
+void probe_finish_all(void);
+#else
+static inline void probe_defer(struct probe_defer *p)
+{
+	p->ret = p->finish();
+}
+
+static inline int probe_finish(struct probe_defer *p)
+{
+	return p->ret;
+}
+
+static inline void probe_finish_all(void)
+{
+}
+#endif
+
+static inline int probe_pending(struct probe_defer *p)
+{
+	return p->pending;
+}
+
+#endif /* __PROBE_H */
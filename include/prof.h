@@ -0,0 +1,30 @@
+/*
+ * Sampling profiler fed by a periodic timer interrupt
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __PROF_H
+#define __PROF_H
+
+#ifdef CONFIG_CMD_PROF
+/* Record the interrupted pc; called from the timer interrupt */
+void prof_sample(ulong pc);
+
+/* The end of the boot, where CONFIG_PROF_BOOT stops sampling */
+void prof_boot_done(void);
+
+/*
+ * Start and stop the tick source, for architectures where it does not
+ * run anyway (sandbox).  The default does nothing.
+ */
+void prof_timer_enable(int on);
+#else
+static inline void prof_sample(ulong pc) {}
+static inline void prof_boot_done(void) {}
+#endif
+
+#endif /* __PROF_H */
@@ -77,6 +77,7 @@
 #define  SDHCI_DATA_AVAILABLE	0x00000800
 #define  SDHCI_CARD_PRESENT	0x00010000
 #define  SDHCI_WRITE_PROTECT	0x00080000
+#define  SDHCI_DATA_LVL_MASK	0x00F00000
 
 #define SDHCI_HOST_CONTROL	0x28
 #define  SDHCI_CTRL_LED		0x01
@@ -155,7 +156,16 @@
 
 #define SDHCI_ACMD12_ERR	0x3C
 
-/* 3E-3F reserved */
+#define SDHCI_HOST_CONTROL2	0x3E
+#define  SDHCI_CTRL_UHS_MASK	0x0007
+#define   SDHCI_CTRL_UHS_SDR12	0x0000
+#define   SDHCI_CTRL_UHS_SDR25	0x0001
+#define   SDHCI_CTRL_UHS_SDR50	0x0002
+#define   SDHCI_CTRL_UHS_SDR104	0x0003
+#define   SDHCI_CTRL_UHS_DDR50	0x0004
+#define  SDHCI_CTRL_VDD_180	0x0008
+#define  SDHCI_CTRL_EXEC_TUNING	0x0040
+#define  SDHCI_CTRL_TUNED_CLK	0x0080
 
 #define SDHCI_CAPABILITIES	0x40
 #define  SDHCI_TIMEOUT_CLK_MASK	0x0000003F
@@ -177,6 +187,10 @@
 #define  SDHCI_CAN_64BIT	0x10000000
 
 #define SDHCI_CAPABILITIES_1	0x44
+#define  SDHCI_SUPPORT_SDR50	0x00000001
+#define  SDHCI_SUPPORT_SDR104	0x00000002
+#define  SDHCI_SUPPORT_DDR50	0x00000004
+#define  SDHCI_USE_SDR50_TUNING	0x00002000
 
 #define SDHCI_MAX_CURRENT	0x48
 
@@ -225,6 +239,26 @@ struct sdhci_host;
  */
 #define SDHCI_DEFAULT_BOUNDARY_SIZE	(512 * 1024)
 #define SDHCI_DEFAULT_BOUNDARY_ARG	(7)
+
+/*
+ * ADMA2 descriptor table (CONFIG_MMC_ADMA).  Each descriptor moves up to
+ * 64 KiB, so the table size limits how much one command can transfer.
+ */
+#ifndef CONFIG_SDHCI_ADMA_DESCS
+#define CONFIG_SDHCI_ADMA_DESCS	128
+#endif
+#define SDHCI_ADMA_MAX_LEN	65536
+
+struct sdhci_adma_desc {
+	u16	attr;
+	u16	len;		/* 0 means 64 KiB */
+	u32	addr;
+};
+
+#define  SDHCI_ADMA_VALID	0x0001
+#define  SDHCI_ADMA_END		0x0002
+#define  SDHCI_ADMA_INT		0x0004
+#define  SDHCI_ADMA_ACT_TRAN	0x0020
 struct sdhci_ops {
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
 	u32             (*read_l)(struct sdhci_host *host, int reg);
@@ -242,6 +276,8 @@ struct sdhci_host {
 	unsigned int quirks;
 	unsigned int version;
 	unsigned int clock;
+	unsigned int host_caps;	/* MMC_MODE_DDR_52MHz, MMC_MODE_HS200 and
+				   MMC_MODE_UHS_* the board supports */
 	struct mmc *mmc;
 	const struct sdhci_ops *ops;
 };
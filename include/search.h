@@ -57,6 +57,7 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	ENTRY **sorted;		/* the filled entries, by ascending key */
 };
 
 /* Create a new hashing table which will at most contain NEL elements.  */
@@ -98,6 +99,9 @@ extern int himport_r(struct hsearch_data *__htab,
 		     const char *__env, size_t __size, const char __sep,
 		     int __flag);
 
+extern int himport_table(struct hsearch_data *__htab,
+			 const ENTRY *__vars, int __n);
+
 /* Flags for himport_r() */
 #define	H_NOCLEAR	1	/* do not clear hash table before importing */
 
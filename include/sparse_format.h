@@ -0,0 +1,45 @@
+/*
+ * The Android sparse image format, as made by img2simg and make_ext4fs
+ * and sent by "fastboot flash" for large images
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * A file header is followed by total_chunks chunks, each a chunk
+ * header and its data.  Chunks cover chunk_sz blocks of blk_sz bytes
+ * of the image, one after the other; all fields are little endian.
+ */
+
+#ifndef __SPARSE_FORMAT_H
+#define __SPARSE_FORMAT_H
+
+#define SPARSE_HEADER_MAGIC	0xed26ff3a
+#define SPARSE_HEADER_MAJOR_VER	1
+
+typedef struct sparse_header {
+	u32	magic;
+	u16	major_version;
+	u16	minor_version;
+	u16	file_hdr_sz;	/* 28 in version 1.0 */
+	u16	chunk_hdr_sz;	/* 12 in version 1.0 */
+	u32	blk_sz;		/* a multiple of 4 */
+	u32	total_blks;	/* in the image */
+	u32	total_chunks;	/* in the file */
+	u32	image_checksum;	/* CRC32 of the image, 0 if none */
+} sparse_header_t;
+
+#define CHUNK_TYPE_RAW		0xCAC1	/* the blocks follow */
+#define CHUNK_TYPE_FILL		0xCAC2	/* a 32 bit value to fill them with */
+#define CHUNK_TYPE_DONT_CARE	0xCAC3	/* no data, contents do not matter */
+#define CHUNK_TYPE_CRC32	0xCAC4	/* CRC32 of the image up to here */
+
+typedef struct chunk_header {
+	u16	chunk_type;
+	u16	reserved1;
+	u32	chunk_sz;	/* in blocks of the image */
+	u32	total_sz;	/* in bytes of the file, header included */
+} chunk_header_t;
+
+#endif /* __SPARSE_FORMAT_H */
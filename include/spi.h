@@ -41,6 +41,14 @@
 /* SPI transfer flags */
 #define SPI_XFER_BEGIN	0x01			/* Assert CS before transfer */
 #define SPI_XFER_END	0x02			/* Deassert CS after transfer */
+#define SPI_XFER_DUAL	0x04			/* Use two data lines */
+#define SPI_XFER_QUAD	0x08			/* Use four data lines */
+
+/* SPI controller capabilities, for spi_slave.caps */
+#define SPI_RX_DUAL	0x01			/* SPI_XFER_DUAL for din */
+#define SPI_RX_QUAD	0x02			/* SPI_XFER_QUAD for din */
+#define SPI_TX_DUAL	0x04			/* SPI_XFER_DUAL for dout */
+#define SPI_TX_QUAD	0x08			/* SPI_XFER_QUAD for dout */
 
 /*-----------------------------------------------------------------------
  * Representation of a SPI slave, i.e. what we're communicating with.
@@ -49,10 +57,14 @@
  *
  *   bus:	ID of the bus that the slave is attached to.
  *   cs:	ID of the chip select connected to the slave.
+ *   caps:	SPI_RX_* and SPI_TX_* flags, the wider transfers that
+ *		the controller and the board wiring allow.  Drivers
+ *		that only have a single data line leave it 0.
  */
 struct spi_slave {
 	unsigned int	bus;
 	unsigned int	cs;
+	unsigned int	caps;
 };
 
 /*-----------------------------------------------------------------------
@@ -133,7 +145,9 @@ void spi_release_bus(struct spi_slave *slave);
  *   dout:	Pointer to a string of bits to send out.  The bits are
  *		held in a byte array and are sent MSB first.
  *   din:	Pointer to a string of bits that will be filled in.
- *   flags:	A bitwise combination of SPI_XFER_* flags.
+ *   flags:	A bitwise combination of SPI_XFER_* flags.  SPI_XFER_DUAL
+ *		and SPI_XFER_QUAD are only passed if slave->caps has the
+ *		matching flag; such a transfer either sends or receives.
  *
  *   Returns: 0 on success, not 0 on failure
  */
@@ -26,6 +26,12 @@
 #include <spi.h>
 #include <linux/types.h>
 
+/* Read modes besides the plain fast read, for spi_flash.read_modes */
+#define SF_DUAL_OUT	0x01	/* 3Bh, data on two lines */
+#define SF_DUAL_IO	0x02	/* BBh, address and data on two lines */
+#define SF_QUAD_OUT	0x04	/* 6Bh, data on four lines */
+#define SF_QUAD_IO	0x08	/* EBh, address and data on four lines */
+
 struct spi_flash {
 	struct spi_slave *spi;
 
@@ -38,6 +44,17 @@ struct spi_flash {
 	/* Erase (sector) size */
 	u32		sector_size;
 
+	/* SF_* read modes of the chip, and the one picked by the probe */
+	u8		read_modes;
+	u8		read_mode;
+	/* Address bytes in a command, 4 for chips beyond 16 MiB */
+	u8		addr_width;
+
+	/* Set the bit that turns WP# and HOLD# into data lines */
+	int		(*quad_enable)(struct spi_flash *flash);
+	/* Switch 4-byte addressing on or off, around each operation */
+	int		(*set_4byte)(struct spi_flash *flash, int enable);
+
 	int		(*read)(struct spi_flash *flash, u32 offset,
 				size_t len, void *buf);
 	int		(*write)(struct spi_flash *flash, u32 offset,
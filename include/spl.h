@@ -0,0 +1,64 @@
+/*
+ * Generic SPL framework: a first stage that loads U-Boot (or, with
+ * CONFIG_SPL_OS_BOOT, a kernel) from MMC, NAND or SPI flash using the
+ * regular drivers.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef	_SPL_H_
+#define	_SPL_H_
+
+#include <image.h>
+
+/* Where the next stage comes from, as returned by spl_boot_device() */
+#define SPL_BOOT_DEVICE_NONE	0
+#define SPL_BOOT_DEVICE_MMC1	1
+#define SPL_BOOT_DEVICE_MMC2	2
+#define SPL_BOOT_DEVICE_NAND	3
+#define SPL_BOOT_DEVICE_SPI	4
+
+/* How an MMC holds it, as returned by spl_mmc_boot_mode() */
+#define SPL_MMC_MODE_RAW	1
+#define SPL_MMC_MODE_FAT	2
+
+struct spl_image_info {
+	const char *name;
+	u8 os;
+	u32 load_addr;
+	u32 entry_point;
+	u32 size;
+	u8 comp;
+	u32 comp_dest;		/* where a compressed image is unpacked */
+};
+
+extern struct spl_image_info spl_image;
+
+/*
+ * Provided by the SoC or board: the device to load from, and the setup
+ * the generic loaders need before they start.
+ */
+u32 spl_boot_device(void);
+u32 spl_mmc_boot_mode(void);
+void spl_nand_setup(void);
+void *spl_uboot_args(void);
+void preloader_console_init(void);
+
+#ifdef CONFIG_SPL_BOARD_INIT
+void spl_board_init(void);
+#endif
+#ifdef CONFIG_SPL_OS_BOOT
+int spl_start_uboot(void);
+#endif
+
+void spl_parse_image_header(const struct image_header *header);
+
+/* Loaders, each leaves the image described in spl_image */
+void spl_nand_load_image(void);
+void spl_mmc_load_image(void);
+void spl_spi_load_image(void);
+
+#endif /* _SPL_H_ */
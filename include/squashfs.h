@@ -0,0 +1,32 @@
+/*
+ * Read-only squashfs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __SQUASHFS_H
+#define __SQUASHFS_H
+
+#include <part.h>
+
+/*
+ * Mount the squashfs on partition part of a block device (0: the
+ * whole device); 0 if it is one we can read.  The metadata and
+ * fragment caches stay with the mount until sqfs_close().
+ */
+int sqfs_mount(block_dev_desc_t *dev_desc, int part);
+void sqfs_close(void);
+
+/* List a directory; 0 if it was found */
+int sqfs_ls(const char *dirname);
+
+/*
+ * Read at most maxsize bytes of a file (all of it if 0) to buf;
+ * returns the number of bytes read or -1
+ */
+long sqfs_read(const char *filename, void *buf, unsigned long maxsize);
+
+#endif /* __SQUASHFS_H */
@@ -60,6 +60,11 @@ struct stdio_dev {
 
 	void *priv;			/* Private extensions			*/
 	struct list_head list;
+
+#ifdef CONFIG_CONSOLE_STATS
+	ulong	out_bytes;		/* Written as a console			*/
+	unsigned long long out_ticks;	/* get_ticks() spent writing them	*/
+#endif
 };
 
 /*
@@ -0,0 +1,47 @@
+/*
+ * Where the time of a command goes, for the "time" command
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __TIME_ACCT_H
+#define __TIME_ACCT_H
+
+/*
+ * The clock "time" measures with; get_ticks() and get_tbclk() unless the
+ * architecture has a finer cycle counter (CONFIG_ARMV7_PMU_CYCLES).
+ */
+unsigned long long time_cycles(void);
+ulong time_cycles_hz(void);
+
+enum time_acct_kind {
+	TIME_ACCT_BLOCK,	/* block device reads and writes */
+	TIME_ACCT_NET,		/* Ethernet send and receive */
+	TIME_ACCT_KINDS
+};
+
+#ifdef CONFIG_CMD_TIME_ACCT
+extern unsigned long long time_acct[TIME_ACCT_KINDS];
+
+/*
+ * Bracket a call into a driver.  Only the outermost bracket counts, so
+ * that flash written from a network handler is not counted twice.
+ */
+unsigned long long time_acct_start(void);
+void time_acct_end(enum time_acct_kind kind, unsigned long long start);
+#else
+static inline unsigned long long time_acct_start(void)
+{
+	return 0;
+}
+
+static inline void time_acct_end(enum time_acct_kind kind,
+				 unsigned long long start)
+{
+}
+#endif
+
+#endif /* __TIME_ACCT_H */
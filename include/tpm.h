@@ -68,4 +68,39 @@ int tis_close(void);
 int tis_sendrecv(const uint8_t *sendbuf, size_t send_size, uint8_t *recvbuf,
 			size_t *recv_len);
 
+#define TPM_DIGEST_SIZE		20	/* SHA-1, the TPM 1.2 PCR size */
+
+#ifndef CONFIG_TPM_MEASURE_PCR
+#define CONFIG_TPM_MEASURE_PCR	8
+#endif
+
+#ifdef CONFIG_TPM_MEASURE
+/*
+ * Queue the extend of a PCR with a SHA-1 digest, or with the SHA-1 of
+ * len bytes at data.  0 on success, -1 if the queue was full and could
+ * not be flushed.
+ */
+int tpm_measure_digest(u32 pcr, const u8 *digest);
+int tpm_measure(u32 pcr, const void *data, ulong len);
+
+/*
+ * Send the queued extends to the TPM, in one session.  Called before
+ * the OS is started; returns 0 on success or -1 on failure.
+ */
+int tpm_measure_flush(void);
+#else
+static inline int tpm_measure_digest(u32 pcr, const u8 *digest)
+{
+	return 0;
+}
+static inline int tpm_measure(u32 pcr, const void *data, ulong len)
+{
+	return 0;
+}
+static inline int tpm_measure_flush(void)
+{
+	return 0;
+}
+#endif
+
 #endif /* _INCLUDE_TPM_H_ */
@@ -30,4 +30,12 @@ uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
 
+#ifdef CONFIG_ARCH_CRC32
+/*
+ * Provided by the architecture when CONFIG_ARCH_CRC32 is set: same
+ * contract as crc32_no_comp() (no ones complement on entry or exit).
+ */
+uint32_t arch_crc32_no_comp(uint32_t, const unsigned char *, uint);
+#endif
+
 #endif /* _UBOOT_CRC_H */
@@ -631,6 +631,14 @@ ZEXTERN int ZEXPORT inflateEnd OF((z_streamp strm));
 
 ZEXTERN int ZEXPORT inflateReset OF((z_streamp strm));
 
+/*
+     U-Boot: inflateWatchdog(strm, 0) keeps inflate() from resetting the
+   watchdog, so that it can run on a secondary core (include/mp_job.h);
+   inflateWatchdog(strm, 1) undoes that.  Returns Z_STREAM_ERROR if the
+   stream state is inconsistent, Z_OK otherwise.
+*/
+ZEXTERN int ZEXPORT inflateWatchdog OF((z_streamp strm, int on));
+
                         /* utility functions */
 
 /*
@@ -217,4 +217,9 @@ extern void ubi_exit(void);
 
 extern struct ubi_device *ubi_devices[];
 
+/* volume updates in pieces, on the device "ubi part" selected */
+extern int ubi_volume_begin_write(char *volume, void *buf, size_t size,
+				  size_t full_size);
+extern int ubi_volume_continue_write(char *volume, void *buf, size_t size);
+
 #endif
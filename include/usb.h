@@ -150,6 +150,33 @@ int submit_control_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 int submit_int_msg(struct usb_device *dev, unsigned long pipe, void *buffer,
 			int transfer_len, int interval);
 void usb_event_poll(void);
+#ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
+/*
+ * Interrupt transfers the host controller keeps doing on its own, into a
+ * queue of queuesize elements; poll_int_queue() returns where in buffer
+ * the next one that came in is, or NULL if there is none yet.
+ */
+struct int_queue;
+struct int_queue *create_int_queue(struct usb_device *dev, unsigned long pipe,
+				   int queuesize, int elementsize,
+				   void *buffer);
+void *poll_int_queue(struct usb_device *dev, struct int_queue *queue);
+int destroy_int_queue(struct usb_device *dev, struct int_queue *queue);
+#endif
+/*
+ * Largest bulk transfer the host controller driver takes in one
+ * submit_bulk_msg() call.  The default is what every driver has been
+ * able to handle so far, drivers that can do more override it.
+ */
+int usb_max_xfer_len(struct usb_device *dev);
+/*
+ * Start a bulk transfer without waiting for it, and collect its result.
+ * Drivers that cannot queue transfers get a default which completes the
+ * transfer in submit_bulk_queue() and returns 1.
+ */
+int submit_bulk_queue(struct usb_device *dev, unsigned long pipe,
+			void *buffer, int transfer_len);
+int submit_bulk_wait(struct usb_device *dev, int *actual_length, int timeout);
 
 /* Defines */
 #define USB_UHCI_VEND_ID	0x8086
@@ -196,6 +223,10 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, unsigned short size, int timeout);
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout);
+int usb_bulk_msg_queue(struct usb_device *dev, unsigned int pipe,
+			void *data, int len);
+int usb_bulk_msg_wait(struct usb_device *dev, int *actual_length,
+			int timeout);
 int usb_submit_int_msg(struct usb_device *dev, unsigned long pipe,
 			void *buffer, int transfer_len, int interval);
 int usb_disable_asynch(int disable);
@@ -0,0 +1,53 @@
+/*
+ * USB Device Firmware Upgrade gadget
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __USB_DFU_H
+#define __USB_DFU_H
+
+/* DFU 1.1 class requests */
+#define DFU_DETACH		0
+#define DFU_DNLOAD		1
+#define DFU_UPLOAD		2
+#define DFU_GETSTATUS		3
+#define DFU_CLRSTATUS		4
+#define DFU_GETSTATE		5
+#define DFU_ABORT		6
+
+/* bState */
+enum dfu_state {
+	DFU_STATE_appIDLE,
+	DFU_STATE_appDETACH,
+	DFU_STATE_dfuIDLE,
+	DFU_STATE_dfuDNLOAD_SYNC,
+	DFU_STATE_dfuDNBUSY,
+	DFU_STATE_dfuDNLOAD_IDLE,
+	DFU_STATE_dfuMANIFEST_SYNC,
+	DFU_STATE_dfuMANIFEST,
+	DFU_STATE_dfuMANIFEST_WAIT_RST,
+	DFU_STATE_dfuUPLOAD_IDLE,
+	DFU_STATE_dfuERROR,
+};
+
+/* bStatus */
+#define DFU_STATUS_OK		0x00
+#define DFU_STATUS_errWRITE	0x03
+#define DFU_STATUS_errADDRESS	0x08
+#define DFU_STATUS_errNOTDONE	0x09
+#define DFU_STATUS_errUNKNOWN	0x0e
+#define DFU_STATUS_errSTALLEDPKT 0x0f
+
+/*
+ * Serve a DFU host until it detaches or ctrl-c is pressed, writing to
+ * the areas of "dfu_alt_info", one per alternate setting.  The size
+ * bytes at buf hold the data while it is written; -1 if the gadget
+ * could not be started.
+ */
+int dfu_run(void *buf, ulong size);
+
+#endif /* __USB_DFU_H */
@@ -0,0 +1,28 @@
+/*
+ * USB download gadget speaking the fastboot protocol
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __USB_FASTBOOT_H
+#define __USB_FASTBOOT_H
+
+/* What the host asked for when it ended the session */
+enum fastboot_action {
+	FASTBOOT_NONE,
+	FASTBOOT_CONTINUE,	/* "continue", or interrupted */
+	FASTBOOT_BOOT,		/* "boot" the downloaded image */
+	FASTBOOT_REBOOT,	/* "reboot" */
+};
+
+/*
+ * Serve the host until it ends the session or ctrl-c is pressed.
+ * Images are downloaded to buf, at most size bytes; the length of the
+ * last download is returned in *len.
+ */
+int fastboot_run(void *buf, ulong size, ulong *len);
+
+#endif /* __USB_FASTBOOT_H */
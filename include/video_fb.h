@@ -107,6 +107,14 @@ void video_set_lut (
     unsigned char g,              /* green */
     unsigned char b               /* blue */
     );
+#ifdef CONFIG_VIDEO_HW_PAN
+/*
+ * Show the frame buffer from line y on, 0 if done; the default does
+ * not pan, with -1.
+ */
+int video_hw_pan(unsigned int y);
+#endif
+
 #ifdef CONFIG_VIDEO_HW_CURSOR
 void video_set_hw_cursor(int x, int y); /* x y in pixel */
 void video_init_hw_cursor(int font_width, int font_height);
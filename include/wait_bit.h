@@ -0,0 +1,55 @@
+/*
+ * Polling hardware with a timeout, without oversleeping
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __WAIT_BIT_H
+#define __WAIT_BIT_H
+
+/*
+ * A fixed udelay() between two polls either costs most of a fast
+ * operation (1 ms for a controller that answers in 5 us) or hammers the
+ * bus for a slow one.  The backoff spins for a few polls first and then
+ * sleeps, doubling the delay up to CONFIG_SYS_WAIT_MAX_DELAY us:
+ *
+ *	struct wait_backoff wb;
+ *
+ *	wait_backoff_start(&wb, 100);
+ *	while (!(ehci_readl(reg) & STS_DONE))
+ *		if (wait_backoff(&wb))
+ *			return -ETIMEDOUT;
+ */
+struct wait_backoff {
+	ulong start;		/* get_timer() at the start		*/
+	ulong timeout;		/* in ms				*/
+	unsigned int spins;	/* polls without a delay so far		*/
+	unsigned int delay;	/* next delay in us, 0 while spinning	*/
+};
+
+void wait_backoff_start(struct wait_backoff *wb, ulong timeout_ms);
+
+/* Wait before the next poll; -1 once the timeout has passed */
+int wait_backoff(struct wait_backoff *wb);
+
+/* Something happened: poll quickly again, the timeout stays */
+static inline void wait_backoff_restart(struct wait_backoff *wb)
+{
+	wb->spins = 0;
+	wb->delay = 0;
+}
+
+/*
+ * Wait until all bits of mask are set (or clear) in the 32 bit register
+ * at reg, read with readl().  Prints a message naming prefix on a
+ * timeout unless prefix is NULL.
+ *
+ * @return 0, or -ETIMEDOUT
+ */
+int wait_for_bit(const char *prefix, const volatile void *reg, u32 mask,
+		 int set, ulong timeout_ms);
+
+#endif /* __WAIT_BIT_H */
@@ -66,6 +66,18 @@
 	#endif /* CONFIG_WATCHDOG && !__ASSEMBLY__ */
 #endif /* CONFIG_HW_WATCHDOG */
 
+/*
+ * Kick the watchdog from C at most every CONFIG_WATCHDOG_RATELIMIT ms,
+ * for watchdogs that are slow to reach (I2C, GPIO bit-banging).
+ */
+#if defined(CONFIG_WATCHDOG_RATELIMIT) && !defined(__ASSEMBLY__) && \
+	(defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG))
+	extern void watchdog_reset_ratelimit(void);
+
+	#undef WATCHDOG_RESET
+	#define WATCHDOG_RESET watchdog_reset_ratelimit
+#endif
+
 /*
  * Prototypes from $(CPU)/cpu.c.
  */
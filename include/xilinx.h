@@ -100,6 +100,9 @@ typedef int (*Xilinx_busy_fn)( int cookie );
 typedef int (*Xilinx_abort_fn)( int cookie );
 typedef int (*Xilinx_pre_fn)( int cookie );
 typedef int (*Xilinx_post_fn)( int cookie );
-typedef int (*Xilinx_bwr_fn)( void *buf, size_t len, int flush, int cookie );
+typedef int (*Xilinx_bwr_fn)( const void *buf, size_t len, int flush, int cookie );
+
+/* The block write function of the device's interface, or NULL */
+extern Xilinx_bwr_fn xilinx_get_bwr(Xilinx_desc *desc);
 
 #endif  /* _XILINX_H_ */
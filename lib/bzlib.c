@@ -569,6 +569,7 @@ int BZ_API(BZ2_bzDecompressInit)
    strm->total_out_lo32     = 0;
    strm->total_out_hi32     = 0;
    s->smallDecompress       = (Bool)small;
+   s->noWatchdog            = False;
    s->ll4                   = NULL;
    s->ll16                  = NULL;
    s->tt                    = NULL;
@@ -843,7 +844,8 @@ int BZ_API(BZ2_bzDecompress) ( bz_stream *strm )
 
    while (True) {
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
-	WATCHDOG_RESET();
+	if (!s->noWatchdog)
+		WATCHDOG_RESET();
 #endif
       if (s->state == BZ_X_IDLE) return BZ_SEQUENCE_ERROR;
       if (s->state == BZ_X_OUTPUT) {
@@ -1591,6 +1593,324 @@ const char * BZ_API(BZ2_bzerror) (BZFILE *b, int *errnum)
 }
 #endif
 
+/*---------------------------------------------------*/
+/*
+ * U-Boot: the streams of bootm and imxtract.  With CONFIG_MP_JOBS the
+ * blocks, found by their bit aligned magic, are decoded side by side:
+ * each one is made into a stream of its own, with the block CRC as the
+ * combined CRC, and decoded by a secondary core into a buffer of its
+ * slot, from where it is copied in order.  Anything unexpected, which
+ * includes a block magic that turns out to be part of some data, sends
+ * the stream to the plain decoder.
+ */
+#ifdef CONFIG_MP_JOBS
+#include <mp_job.h>
+#include <malloc.h>
+
+#define BZ_MP_SLOTS		4
+#define BZ_BLOCK_MAGIC		0x314159265359ULL
+#define BZ_EOS_MAGIC		0x177245385090ULL
+#define BZ_MAGIC_MASK		0xffffffffffffULL
+#define BZ_NO_MAGIC		(~0UL)
+
+struct bz_mp_slot {
+	struct mp_job	job;		/* must be first		*/
+	int		used;		/* holds a block		*/
+	int		on_core;	/* ... a secondary core has	*/
+	int		small;
+	char		*arena;		/* the decoder state		*/
+	UInt32		arena_size;
+	UInt32		arena_used;
+	char		*in;		/* the block as a stream	*/
+	UInt32		in_len;
+	char		*out;
+	UInt32		out_size;
+	UInt32		out_len;
+	UInt32		crc;
+};
+
+/* Per byte value, the shifts at which it is the second byte of a magic */
+static UInt16 bz_magic_tab[256];
+
+static void bz_magic_tab_init(void)
+{
+	int s;
+
+	if (bz_magic_tab[(BZ_BLOCK_MAGIC >> 32) & 0xff])
+		return;
+	for (s = 0; s < 8; s++) {
+		bz_magic_tab[(BZ_BLOCK_MAGIC >> (32 + s)) & 0xff] |= 1 << s;
+		bz_magic_tab[(BZ_EOS_MAGIC >> (32 + s)) & 0xff] |= 0x100 << s;
+	}
+}
+
+/* n (up to 57) bits at bit pos, most significant first, 0 past len */
+static unsigned long long bz_get_bits(const UChar *p, ulong len, ulong pos,
+				      int n)
+{
+	unsigned long long w = 0;
+	ulong i;
+
+	for (i = pos / 8; i < pos / 8 + 8; i++)
+		w = (w << 8) | (i < len ? p[i] : 0);
+	return (w >> (64 - pos % 8 - n)) & ((1ULL << n) - 1);
+}
+
+/* Bit position of the next block or end of stream magic from bit from */
+static ulong bz_find_magic(const UChar *p, ulong len, ulong from, int *eos)
+{
+	unsigned long long m;
+	ulong i, pos;
+	int s, mask;
+
+	for (i = from / 8; i + 6 < len; i++) {
+		mask = bz_magic_tab[p[i + 1]];
+		if (!mask)
+			continue;
+		for (s = 0; s < 8; s++) {
+			if (!(mask & (0x101 << s)))
+				continue;
+			pos = i * 8 + s;
+			if (pos < from)
+				continue;
+			m = bz_get_bits(p, len, pos, 48);
+			if (m == BZ_BLOCK_MAGIC || m == BZ_EOS_MAGIC) {
+				*eos = m == BZ_EOS_MAGIC;
+				return pos;
+			}
+		}
+	}
+	return BZ_NO_MAGIC;
+}
+
+static void bz_put_bits(UChar *p, ulong pos, unsigned long long v, int n)
+{
+	while (n--) {
+		if ((v >> n) & 1)
+			p[pos / 8] |= 0x80 >> (pos % 8);
+		pos++;
+	}
+}
+
+static void *bz_arena_alloc(void *opaque, Int32 items, Int32 size)
+{
+	struct bz_mp_slot *sl = opaque;
+	UInt32 n = ((UInt32)items * size + 7) & ~7;
+	void *p;
+
+	if (n > sl->arena_size - sl->arena_used)
+		return NULL;
+	p = sl->arena + sl->arena_used;
+	sl->arena_used += n;
+	return p;
+}
+
+static void bz_arena_free(void *opaque, void *addr)
+{
+}
+
+/* Decodes the stream of a slot, no memory allocated, no watchdog */
+static int bz_slot_decode(struct bz_mp_slot *sl, char *out, UInt32 *out_len)
+{
+	bz_stream strm;
+	int ret;
+
+	sl->arena_used = 0;
+	strm.bzalloc = bz_arena_alloc;
+	strm.bzfree = bz_arena_free;
+	strm.opaque = sl;
+	ret = BZ2_bzDecompressInit(&strm, 0, sl->small);
+	if (ret != BZ_OK)
+		return ret;
+	((DState *)strm.state)->noWatchdog = sl->on_core;
+
+	strm.next_in = sl->in;
+	strm.avail_in = sl->in_len;
+	strm.next_out = out;
+	strm.avail_out = *out_len;
+	ret = BZ2_bzDecompress(&strm);
+	if (ret == BZ_STREAM_END) {
+		*out_len -= strm.avail_out;
+		ret = BZ_OK;
+	} else if (ret == BZ_OK) {
+		ret = strm.avail_out ? BZ_UNEXPECTED_EOF : BZ_OUTBUFF_FULL;
+	}
+	BZ2_bzDecompressEnd(&strm);
+	return ret;
+}
+
+static void bz_mp_job(struct mp_job *job)
+{
+	struct bz_mp_slot *sl = (struct bz_mp_slot *)job;
+
+	sl->out_len = sl->out_size;
+	job->result = bz_slot_decode(sl, sl->out, &sl->out_len);
+}
+
+/* Makes the block from bit start to bit end a stream and starts it */
+static int bz_slot_start(struct bz_mp_slot *sl, const UChar *src, ulong len,
+			 ulong start, ulong end)
+{
+	ulong nbits = end - start, i, j;
+	int r = start % 8;
+
+	sl->in_len = 4 + (nbits + 80 + 7) / 8;
+	sl->in = malloc(sl->in_len);
+	if (!sl->in)
+		return -1;
+
+	/* the header, the block moved to a byte boundary, the trailer */
+	memset(sl->in, 0, sl->in_len);
+	memcpy(sl->in, src, 4);
+	for (i = 0, j = start / 8; i < nbits / 8; i++, j++)
+		sl->in[4 + i] = src[j] << r | (r ? src[j + 1] >> (8 - r) : 0);
+	if (nbits % 8)
+		sl->in[4 + i] = bz_get_bits(src, len, start + 8 * i,
+					    nbits % 8) << (8 - nbits % 8);
+	sl->crc = bz_get_bits(src, len, start + 48, 32);
+	bz_put_bits((UChar *)sl->in, 32 + nbits, BZ_EOS_MAGIC, 48);
+	bz_put_bits((UChar *)sl->in, 32 + nbits + 48, sl->crc, 32);
+
+	sl->used = 1;
+	sl->job.func = bz_mp_job;
+	sl->on_core = 1;
+	if (mp_job_start(&sl->job)) {
+		/* no core free: it is decoded here */
+		sl->on_core = 0;
+		bz_mp_job(&sl->job);
+	}
+	return 0;
+}
+
+static void bz_slot_release(struct bz_mp_slot *sl)
+{
+	if (sl->used && sl->on_core)
+		mp_job_wait(&sl->job);
+	free(sl->in);
+	sl->in = NULL;
+	sl->used = 0;
+}
+
+static int bunzip2_mp(char *dest, unsigned int *destLen, char *source,
+		      unsigned int sourceLen, int small)
+{
+	const UChar *src = (const UChar *)source;
+	struct bz_mp_slot slots[BZ_MP_SLOTS], *sl;
+	ulong blk, next, nstart = 0, nfin = 0, off = 0;
+	UInt32 level, len, crc = 0;
+	int nslots, i, eos = 0, ret = BZ_CONFIG_ERROR;
+
+	if (sourceLen < 14 || src[0] != 'B' || src[1] != 'Z' ||
+	    src[2] != 'h' || src[3] < '1' || src[3] > '9' ||
+	    bz_get_bits(src, sourceLen, 32, 48) != BZ_BLOCK_MAGIC)
+		return BZ_CONFIG_ERROR;
+	level = (src[3] - '0') * 100000;
+	bz_magic_tab_init();
+
+	memset(slots, 0, sizeof(slots));
+	for (nslots = 0; nslots < BZ_MP_SLOTS; nslots++) {
+		sl = &slots[nslots];
+		sl->small = small;
+		sl->arena_size = sizeof(DState) + 64 +
+			(small ? level * 2 + (level + 1) / 2 + 8 : level * 4);
+		sl->arena = malloc(sl->arena_size);
+		sl->out_size = 2 * level;
+		sl->out = malloc(sl->out_size);
+		if (!sl->arena || !sl->out) {
+			free(sl->arena);
+			free(sl->out);
+			break;
+		}
+	}
+	if (nslots < 2)
+		goto out;
+
+	blk = 32;
+	for (;;) {
+		/* hand out the blocks there are slots for */
+		while (!eos && !slots[nstart % nslots].used) {
+			next = bz_find_magic(src, sourceLen, blk + 48, &eos);
+			if (next == BZ_NO_MAGIC ||
+			    bz_slot_start(&slots[nstart % nslots], src,
+					  sourceLen, blk, next))
+				goto out;
+			nstart++;
+			blk = next;
+		}
+		if (nfin == nstart)
+			break;
+
+		/* and collect the oldest */
+		sl = &slots[nfin % nslots];
+		if (sl->on_core)
+			mp_job_wait(&sl->job);
+		len = *destLen - off;
+		if (sl->job.result == BZ_OUTBUFF_FULL) {
+			/* more than the slot holds, redone in place */
+			sl->on_core = 0;
+			if (bz_slot_decode(sl, dest + off, &len) != BZ_OK)
+				goto out;
+		} else if (sl->job.result != BZ_OK || sl->out_len > len) {
+			goto out;
+		} else {
+			len = sl->out_len;
+			memcpy(dest + off, sl->out, len);
+		}
+		crc = ((crc << 1) | (crc >> 31)) ^ sl->crc;
+		off += len;
+		sl->on_core = 0;
+		bz_slot_release(sl);
+		nfin++;
+	}
+
+	if (crc == bz_get_bits(src, sourceLen, blk + 48, 32)) {
+		*destLen = off;
+		ret = BZ_OK;
+	}
+out:
+	for (i = 0; i < nslots; i++)
+		bz_slot_release(&slots[i]);
+	for (i = 0; i < nslots; i++) {
+		free(slots[i].arena);
+		free(slots[i].out);
+	}
+	return ret;
+}
+#endif
+
+/*
+ * Small mode needs about 2.3 MB instead of 3.6 MB, at about half the
+ * speed: set "bzip2small" to choose, otherwise it is taken with less
+ * than 4 MB of malloc() space, or when the normal mode runs out.
+ */
+int bunzip2(char *dest, unsigned int *destLen, char *source,
+	    unsigned int sourceLen)
+{
+	unsigned int len = *destLen;
+	char *s = getenv("bzip2small");
+	int small, ret;
+
+	if (s)
+		small = *s == 'y' || *s == '1';
+	else
+		small = CONFIG_SYS_MALLOC_LEN < (4096 * 1024);
+
+#ifdef CONFIG_MP_JOBS
+	ret = bunzip2_mp(dest, destLen, source, sourceLen, small);
+	if (ret == BZ_OK)
+		return ret;
+#endif
+
+	ret = BZ2_bzBuffToBuffDecompress(dest, destLen, source, sourceLen,
+					 small, 0);
+	if (ret == BZ_MEM_ERROR && !small && !s) {
+		*destLen = len;
+		ret = BZ2_bzBuffToBuffDecompress(dest, destLen, source,
+						 sourceLen, 1, 0);
+	}
+	return ret;
+}
+
 void bz_internal_error(int errcode)
 {
 	printf ("BZIP2 internal error %d\n", errcode);
@@ -418,7 +418,8 @@ Int32 BZ2_decompress ( DState* s )
       while (True) {
 
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
-	WATCHDOG_RESET();
+	if (!s->noWatchdog)
+		WATCHDOG_RESET();
 #endif
 	 if (nextSym == EOB) break;
 
@@ -503,7 +504,8 @@ Int32 BZ2_decompress ( DState* s )
 		     kk = MTFA_SIZE-1;
 		     for (ii = 256 / MTFL_SIZE-1; ii >= 0; ii--) {
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
-			WATCHDOG_RESET();
+			if (!s->noWatchdog)
+				WATCHDOG_RESET();
 #endif
 			for (jj = MTFL_SIZE-1; jj >= 0; jj--) {
 			   s->mtfa[kk] = s->mtfa[s->mtfbase[ii] + jj];
@@ -568,7 +570,8 @@ Int32 BZ2_decompress ( DState* s )
 	    while (i != s->origPtr);
 
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
-	WATCHDOG_RESET();
+	if (!s->noWatchdog)
+		WATCHDOG_RESET();
 #endif
 	 s->tPos = s->origPtr;
 	 s->nblock_used = 0;
@@ -583,7 +586,8 @@ Int32 BZ2_decompress ( DState* s )
       } else {
 
 #if defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG)
-	WATCHDOG_RESET();
+	if (!s->noWatchdog)
+		WATCHDOG_RESET();
 #endif
 	 /*-- compute the T^(-1) vector --*/
 	 for (i = 0; i < nblock; i++) {
@@ -393,6 +393,7 @@ typedef
       /* misc administratium */
       Int32    blockSize100k;
       Bool     smallDecompress;
+      Bool     noWatchdog;	/* decoding on a secondary core */
       Int32    currBlockNo;
       Int32    verbosity;
 
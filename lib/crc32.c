@@ -24,6 +24,14 @@
 
 #define tole(x) cpu_to_le32(x)
 
+/*
+ * Slice-by-8 processes eight bytes per step with eight lookup tables
+ * (8 KiB of tables instead of 1 KiB).  The host tools always use it.
+ */
+#if defined(USE_HOSTCC) || defined(CONFIG_CRC32_SLICE8)
+#define CRC32_SLICE8
+#endif
+
 #ifdef DYNAMIC_CRC_TABLE
 
 local int crc_table_empty = 1;
@@ -149,6 +157,12 @@ tole(0xb40bbe37L), tole(0xc30c8ea1L), tole(0x5a05df1bL), tole(0x2d02ef8dL)
 };
 #endif
 
+#if defined(CRC32_SLICE8) && !defined(DYNAMIC_CRC_TABLE)
+#include "crc32_slice8.h"
+#else
+#undef CRC32_SLICE8
+#endif
+
 #if 0
 /* =========================================================================
  * This function can be used by asm versions of crc32()
@@ -165,8 +179,11 @@ const uint32_t * ZEXPORT get_crc_table()
 /* ========================================================================= */
 # if __BYTE_ORDER == __LITTLE_ENDIAN
 #  define DO_CRC(x) crc = tab[(crc ^ (x)) & 255] ^ (crc >> 8)
+/* byte n (in memory order) of a word loaded from the buffer */
+#  define SLICE(w, n) (((w) >> (8 * (n))) & 255)
 # else
 #  define DO_CRC(x) crc = tab[((crc >> 24) ^ (x)) & 255] ^ (crc << 8)
+#  define SLICE(w, n) (((w) >> (24 - 8 * (n))) & 255)
 # endif
 
 /* ========================================================================= */
@@ -179,6 +196,10 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
+#ifdef CONFIG_ARCH_CRC32
+    /* CRC instructions or an accelerator provided by the architecture */
+    return arch_crc32_no_comp(crc, buf, len);
+#endif
 #ifdef DYNAMIC_CRC_TABLE
     if (crc_table_empty)
       make_crc_table();
@@ -193,6 +214,19 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 	 b = (uint32_t *)p;
     }
 
+#ifdef CRC32_SLICE8
+    for (; len >= 8; len -= 8) {
+	 const uint32_t (*t)[256] = crc_table_slice;
+	 uint32_t lo = *b++ ^ crc;
+	 uint32_t hi = *b++;
+
+	 crc = t[6][SLICE(lo, 0)] ^ t[5][SLICE(lo, 1)] ^
+	       t[4][SLICE(lo, 2)] ^ t[3][SLICE(lo, 3)] ^
+	       t[2][SLICE(hi, 0)] ^ t[1][SLICE(hi, 1)] ^
+	       t[0][SLICE(hi, 2)] ^ tab[SLICE(hi, 3)];
+    }
+#endif
+
     rem_len = len & 3;
     len = len >> 2;
     for (--b; len; --len) {
@@ -215,6 +249,7 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     return le32_to_cpu(crc);
 }
 #undef DO_CRC
+#undef SLICE
 
 uint32_t ZEXPORT crc32 (uint32_t crc, const Bytef *p, uInt len)
 {
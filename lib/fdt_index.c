@@ -0,0 +1,292 @@
+/*
+ * Index of the nodes of a device tree, for fast lookups
+ *
+ * libfdt finds a node by walking the flat tree from the root, over all
+ * the properties on the way.  The board fixups look up the same nodes
+ * over and over, so this keeps, for one blob at a time, the offset of
+ * every node along with its first child, next sibling and phandle.  A
+ * path is then resolved by following the child lists; the names are
+ * still read from the blob.
+ *
+ * libfdt reports every change to the struct block through
+ * fdt_index_splice(), which moves the offsets behind the change along;
+ * adding, removing or NOP-ing nodes drops the index, and it is built
+ * again on the next lookup.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <fdt_index.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define FDT_INDEX_MAX_DEPTH	32
+
+struct fdt_index_node {
+	int		offset;
+	int		first_child;	/* index into idx_nodes, or -1 */
+	int		next_sibling;
+	uint32_t	phandle;
+};
+
+static const void *idx_fdt;
+static int idx_valid;
+static int idx_struct_size;	/* size_dt_struct the offsets are for */
+static struct fdt_index_node *idx_nodes;
+static int idx_count, idx_size;
+static int *idx_by_phandle;	/* node numbers ordered by phandle */
+static int idx_phandles;
+
+static int fdt_index_build(const void *fdt)
+{
+	int last[FDT_INDEX_MAX_DEPTH + 1];
+	int offset, depth, d, count, n, i;
+
+	idx_valid = 0;
+
+	count = 0;
+	for (offset = fdt_next_node(fdt, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL))
+		count++;
+	if (offset != -FDT_ERR_NOTFOUND || !count)
+		return -1;
+
+	if (count > idx_size) {
+		free(idx_nodes);
+		free(idx_by_phandle);
+		idx_size = 0;
+		idx_nodes = malloc(count * sizeof(*idx_nodes));
+		idx_by_phandle = malloc(count * sizeof(*idx_by_phandle));
+		if (!idx_nodes || !idx_by_phandle)
+			return -1;
+		idx_size = count;
+	}
+
+	n = 0;
+	idx_phandles = 0;
+	depth = 0;
+	last[0] = -1;
+	for (offset = fdt_next_node(fdt, -1, &depth); offset >= 0;
+	     offset = fdt_next_node(fdt, offset, &depth)) {
+		struct fdt_index_node *node = &idx_nodes[n];
+
+		/* d is 0 for the root, and last[d] the last node seen at d */
+		d = depth - 1;
+		if (d < 0 || d > FDT_INDEX_MAX_DEPTH)
+			return -1;
+		if (d > 0) {
+			if (last[d] >= 0)
+				idx_nodes[last[d]].next_sibling = n;
+			else
+				idx_nodes[last[d - 1]].first_child = n;
+		}
+		last[d] = n;
+		if (d < FDT_INDEX_MAX_DEPTH)
+			last[d + 1] = -1;
+
+		node->offset = offset;
+		node->first_child = -1;
+		node->next_sibling = -1;
+		node->phandle = fdt_get_phandle(fdt, offset);
+
+		if (node->phandle) {
+			/* dtc hands them out in order, so this rarely moves */
+			for (i = idx_phandles; i > 0 &&
+			     idx_nodes[idx_by_phandle[i - 1]].phandle >
+			     node->phandle; i--)
+				idx_by_phandle[i] = idx_by_phandle[i - 1];
+			idx_by_phandle[i] = n;
+			idx_phandles++;
+		}
+		n++;
+	}
+
+	idx_count = n;
+	idx_fdt = fdt;
+	idx_struct_size = fdt_size_dt_struct(fdt);
+	idx_valid = 1;
+	debug("fdt_index: %d nodes, %d phandles\n", idx_count, idx_phandles);
+	return 0;
+}
+
+/* Make sure the index is for fdt; -1 if the caller has to walk the tree */
+static int fdt_index_get(const void *fdt)
+{
+	/* malloc() is not there yet */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return -1;
+
+	if (idx_valid && fdt == idx_fdt &&
+	    fdt_size_dt_struct(fdt) == idx_struct_size)
+		return 0;
+
+	/* only v17 blobs tell how large the struct block is */
+	if (fdt_check_header(fdt) || fdt_version(fdt) < 17)
+		return -1;
+	return fdt_index_build(fdt);
+}
+
+void fdt_index_splice(const void *fdt, int offset, int oldlen, int newlen)
+{
+	int delta = newlen - oldlen;
+	int n;
+
+	if (!idx_valid || fdt != idx_fdt || !delta)
+		return;
+
+	for (n = 0; n < idx_count; n++)
+		if (idx_nodes[n].offset >= offset + oldlen)
+			idx_nodes[n].offset += delta;
+	idx_struct_size += delta;
+}
+
+void fdt_index_invalidate(const void *fdt)
+{
+	if (!fdt || fdt == idx_fdt)
+		idx_valid = 0;
+}
+
+/* The first node after offset in the blob, or idx_count */
+static int fdt_index_after(int offset)
+{
+	int lo = 0, hi = idx_count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (idx_nodes[mid].offset <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Same rules as libfdt: "name" also matches "name@unit" */
+static int fdt_index_name_eq(const void *fdt, int offset,
+			     const char *s, int len)
+{
+	const char *p = fdt_get_name(fdt, offset, NULL);
+
+	if (!p || memcmp(p, s, len) != 0)
+		return 0;
+
+	if (p[len] == '\0')
+		return 1;
+	else if (!memchr(s, '@', len) && (p[len] == '@'))
+		return 1;
+	else
+		return 0;
+}
+
+int fdt_index_path_offset(const void *fdt, const char *path)
+{
+	const char *end = path + strlen(path);
+	const char *p = path;
+	int n = 0;
+
+	if (fdt_index_get(fdt))
+		return fdt_path_offset(fdt, path);
+
+	/* an alias: start from where it points to */
+	if (*path != '/') {
+		const char *q = strchr(path, '/');
+		const char *alias;
+		int offset;
+
+		if (!q)
+			q = end;
+		offset = fdt_index_path_offset(fdt, "/aliases");
+		if (offset < 0)
+			return -FDT_ERR_BADPATH;
+		alias = fdt_getprop_namelen(fdt, offset, p, q - p, NULL);
+		if (!alias || *alias != '/')
+			return -FDT_ERR_BADPATH;
+
+		offset = fdt_index_path_offset(fdt, alias);
+		if (offset < 0 || !*q)
+			return offset;
+		n = fdt_index_after(offset - 1);
+		if (n == idx_count || idx_nodes[n].offset != offset)
+			return fdt_path_offset(fdt, path);
+		p = q;
+	}
+
+	while (*p) {
+		const char *q;
+
+		while (*p == '/')
+			p++;
+		if (!*p)
+			break;
+		q = strchr(p, '/');
+		if (!q)
+			q = end;
+
+		for (n = idx_nodes[n].first_child; n >= 0;
+		     n = idx_nodes[n].next_sibling)
+			if (fdt_index_name_eq(fdt, idx_nodes[n].offset,
+					      p, q - p))
+				break;
+		if (n < 0)
+			return -FDT_ERR_NOTFOUND;
+
+		p = q;
+	}
+
+	return idx_nodes[n].offset;
+}
+
+int fdt_index_node_offset_by_compatible(const void *fdt, int startoffset,
+					const char *compatible)
+{
+	int n, err;
+
+	if (fdt_index_get(fdt))
+		return fdt_node_offset_by_compatible(fdt, startoffset,
+						     compatible);
+
+	for (n = fdt_index_after(startoffset); n < idx_count; n++) {
+		err = fdt_node_check_compatible(fdt, idx_nodes[n].offset,
+						compatible);
+		if ((err < 0) && (err != -FDT_ERR_NOTFOUND))
+			return err;
+		else if (err == 0)
+			return idx_nodes[n].offset;
+	}
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	int lo, hi;
+
+	if ((phandle == 0) || (phandle == -1) || fdt_index_get(fdt))
+		return fdt_node_offset_by_phandle(fdt, phandle);
+
+	lo = 0;
+	hi = idx_phandles;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		struct fdt_index_node *node = &idx_nodes[idx_by_phandle[mid]];
+
+		if (node->phandle == phandle) {
+			/* phandles can be set without a new node; check */
+			if (fdt_get_phandle(fdt, node->offset) == phandle)
+				return node->offset;
+			break;
+		}
+		if (node->phandle < phandle)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* not indexed, or no longer right: the slow way */
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
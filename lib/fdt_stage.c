@@ -0,0 +1,330 @@
+/*
+ * Batched property edits of a device tree
+ *
+ * Setting a property through libfdt moves everything behind it along
+ * the blob, and the fixups run before booting set a good many of them.
+ * fdt_stage_setprop() and fdt_stage_delprop() instead keep a list of
+ * the changes, newest first, and fdt_stage_commit() writes the tree
+ * out once with the sequential write functions of fdt_sw.c, taking the
+ * last change of each property, and opens the result over the blob.
+ *
+ * Nodes that are added or removed meanwhile move the recorded offsets
+ * through fdt_stage_splice(), which libfdt calls for every splice of
+ * the struct block.  A property that is both staged and set directly
+ * ends up with the staged value.  If the rebuilt tree does not fit,
+ * the changes are made one by one as they would have been.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <fdt_stage.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define FDT_STAGE_MAX_DEPTH	32
+
+enum {
+	FDT_STAGE_SET,
+	FDT_STAGE_DEL,
+};
+
+struct fdt_stage_entry {
+	struct fdt_stage_entry *next;
+	int	node;			/* offset of the node */
+	int	op;
+	int	used;			/* written out, or overridden */
+	int	len;
+	char	*name;
+	char	val[];			/* then the name */
+};
+
+static void *stage_fdt;
+static struct fdt_stage_entry *stage_list;
+
+static void fdt_stage_free(void)
+{
+	struct fdt_stage_entry *e;
+
+	while ((e = stage_list) != NULL) {
+		stage_list = e->next;
+		free(e);
+	}
+}
+
+int fdt_stage_begin(void *fdt)
+{
+	/* malloc() is not there yet */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	if (stage_fdt == fdt)
+		return 0;
+	if (stage_fdt)
+		fdt_stage_commit(stage_fdt);
+
+	/* the edits must be possible in place if the rebuild fails */
+	if (fdt_check_header(fdt) || fdt_version(fdt) < 17)
+		return 0;
+
+	stage_fdt = fdt;
+	return 0;
+}
+
+static int fdt_stage_add(void *fdt, int nodeoffset, const char *name,
+			 const void *val, int len, int op)
+{
+	struct fdt_stage_entry *e;
+	int err;
+
+	if (!fdt_get_name(fdt, nodeoffset, &err))
+		return err;
+
+	e = malloc(sizeof(*e) + len + strlen(name) + 1);
+	if (!e)
+		return -FDT_ERR_NOSPACE;
+
+	e->node = nodeoffset;
+	e->op = op;
+	e->used = 0;
+	e->len = len;
+	memcpy(e->val, val, len);
+	e->name = e->val + len;
+	strcpy(e->name, name);
+
+	e->next = stage_list;
+	stage_list = e;
+	return 0;
+}
+
+int fdt_stage_setprop(void *fdt, int nodeoffset, const char *name,
+		      const void *val, int len)
+{
+	if (fdt != stage_fdt)
+		return fdt_setprop(fdt, nodeoffset, name, val, len);
+
+	return fdt_stage_add(fdt, nodeoffset, name, val, len, FDT_STAGE_SET);
+}
+
+int fdt_stage_delprop(void *fdt, int nodeoffset, const char *name)
+{
+	if (fdt != stage_fdt)
+		return fdt_delprop(fdt, nodeoffset, name);
+
+	return fdt_stage_add(fdt, nodeoffset, name, NULL, 0, FDT_STAGE_DEL);
+}
+
+void fdt_stage_splice(const void *fdt, int offset, int oldlen, int newlen)
+{
+	struct fdt_stage_entry **p = &stage_list;
+	struct fdt_stage_entry *e;
+
+	if (fdt != stage_fdt)
+		return;
+
+	while ((e = *p) != NULL) {
+		if (e->node >= offset + oldlen) {
+			e->node += newlen - oldlen;
+		} else if (e->node >= offset) {
+			/* the node is gone */
+			*p = e->next;
+			free(e);
+			continue;
+		}
+		p = &e->next;
+	}
+}
+
+/* The last change of a property, if any; all of them are done with */
+static struct fdt_stage_entry *fdt_stage_find(int node, const char *name)
+{
+	struct fdt_stage_entry *e, *last = NULL;
+
+	for (e = stage_list; e; e = e->next) {
+		if (e->node != node || strcmp(e->name, name))
+			continue;
+		if (!last)
+			last = e;
+		e->used = 1;
+	}
+	return last;
+}
+
+/* Write out the properties node does not have yet */
+static int fdt_stage_new_props(void *buf, int node)
+{
+	struct fdt_stage_entry *e;
+	int err;
+
+	for (e = stage_list; e; e = e->next) {
+		if (e->node != node || e->used)
+			continue;
+		fdt_stage_find(node, e->name);
+		if (e->op != FDT_STAGE_SET)
+			continue;
+		err = fdt_property(buf, e->name, e->val, e->len);
+		if (err)
+			return err;
+	}
+	return 0;
+}
+
+static int fdt_stage_rebuild(const void *fdt, void *buf, int bufsize)
+{
+	int node[FDT_STAGE_MAX_DEPTH];
+	int props_done[FDT_STAGE_MAX_DEPTH];
+	const struct fdt_property *prop;
+	struct fdt_stage_entry *e;
+	const char *name;
+	uint64_t addr, size;
+	int offset, next, depth, err, n;
+	uint32_t tag;
+
+	err = fdt_create(buf, bufsize);
+	for (n = 0; !err && n < fdt_num_mem_rsv(fdt); n++) {
+		err = fdt_get_mem_rsv(fdt, n, &addr, &size);
+		if (!err)
+			err = fdt_add_reservemap_entry(buf, addr, size);
+	}
+	if (!err)
+		err = fdt_finish_reservemap(buf);
+	if (err)
+		return err;
+
+	depth = -1;
+	offset = 0;
+	do {
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (next < 0)
+			return next;
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (depth >= 0 && !props_done[depth]) {
+				props_done[depth] = 1;
+				err = fdt_stage_new_props(buf, node[depth]);
+				if (err)
+					return err;
+			}
+			if (++depth >= FDT_STAGE_MAX_DEPTH)
+				return -FDT_ERR_BADSTRUCTURE;
+			node[depth] = offset;
+			props_done[depth] = 0;
+
+			name = fdt_get_name(fdt, offset, &err);
+			if (!name)
+				return err;
+			err = fdt_begin_node(buf, name);
+			break;
+
+		case FDT_PROP:
+			if (depth < 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			prop = fdt_get_property_by_offset(fdt, offset, &err);
+			if (!prop)
+				return err;
+			name = fdt_string(fdt, fdt32_to_cpu(prop->nameoff));
+
+			e = fdt_stage_find(node[depth], name);
+			if (!e)
+				err = fdt_property(buf, name, prop->data,
+						   fdt32_to_cpu(prop->len));
+			else if (e->op == FDT_STAGE_SET)
+				err = fdt_property(buf, name, e->val, e->len);
+			break;
+
+		case FDT_END_NODE:
+			if (depth < 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			if (!props_done[depth])
+				err = fdt_stage_new_props(buf, node[depth]);
+			if (!err)
+				err = fdt_end_node(buf);
+			depth--;
+			break;
+
+		case FDT_END:
+			if (depth >= 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			break;
+		}
+		if (err)
+			return err;
+		offset = next;
+	} while (tag != FDT_END);
+
+	err = fdt_finish(buf);
+	if (err)
+		return err;
+	fdt_set_boot_cpuid_phys(buf, fdt_boot_cpuid_phys(fdt));
+	return 0;
+}
+
+/* Make the changes in place, oldest first, as if there was no stage */
+static int fdt_stage_replay(void *fdt)
+{
+	struct fdt_stage_entry *e, *list = NULL;
+	int err, ret = 0;
+
+	while ((e = stage_list) != NULL) {
+		stage_list = e->next;
+		e->next = list;
+		list = e;
+	}
+	stage_list = list;
+
+	/* the stage stays open so that the offsets keep up */
+	while ((e = stage_list) != NULL) {
+		stage_list = e->next;
+		if (e->op == FDT_STAGE_SET) {
+			err = fdt_setprop(fdt, e->node, e->name,
+					  e->val, e->len);
+		} else {
+			err = fdt_delprop(fdt, e->node, e->name);
+			if (err == -FDT_ERR_NOTFOUND)
+				err = 0;
+		}
+		if (err) {
+			printf("WARNING: could not set %s %s.\n",
+			       e->name, fdt_strerror(err));
+			if (!ret)
+				ret = err;
+		}
+		free(e);
+	}
+	return ret;
+}
+
+int fdt_stage_commit(void *fdt)
+{
+	int size = fdt_totalsize(fdt);
+	void *buf;
+	int err;
+
+	if (fdt != stage_fdt)
+		return 0;
+
+	if (!stage_list) {
+		stage_fdt = NULL;
+		return 0;
+	}
+
+	buf = malloc(size);
+	err = buf ? fdt_stage_rebuild(fdt, buf, size) : -FDT_ERR_NOSPACE;
+	if (!err)
+		err = fdt_open_into(buf, fdt, size);
+	free(buf);
+
+	if (err) {
+		debug("fdt_stage: rebuild failed, %s\n", fdt_strerror(err));
+		err = fdt_stage_replay(fdt);
+	}
+
+	fdt_stage_free();
+	stage_fdt = NULL;
+	return err;
+}
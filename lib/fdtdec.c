@@ -23,6 +23,7 @@
 #include <serial.h>
 #include <libfdt.h>
 #include <fdtdec.h>
+#include <fdt_index.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -48,13 +49,13 @@ static int find_alias_node(const void *blob, const char *name)
 	int alias_node;
 
 	debug("find_alias_node: %s\n", name);
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdt_index_path_offset(blob, "/aliases");
 	if (alias_node < 0)
 		return alias_node;
 	path = fdt_getprop(blob, alias_node, name, NULL);
 	if (!path)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, path);
+	return fdt_index_path_offset(blob, path);
 }
 
 fdt_addr_t fdtdec_get_addr(const void *blob, int node,
@@ -109,7 +110,7 @@ enum fdt_compat_id fd_dec_lookup(const void *blob, int node)
 int fdtdec_next_compatible(const void *blob, int node,
 		enum fdt_compat_id id)
 {
-	return fdt_node_offset_by_compatible(blob, node, compat_names[id]);
+	return fdt_index_node_offset_by_compatible(blob, node, compat_names[id]);
 }
 
 int fdtdec_next_alias(const void *blob, const char *name,
@@ -26,7 +26,9 @@
 #include <command.h>
 #include <image.h>
 #include <malloc.h>
+#include <mp_job.h>
 #include <u-boot/zlib.h>
+#include <asm/unaligned.h>
 
 #define	ZALLOC_ALIGNMENT	16
 #define HEAD_CRC		2
@@ -56,33 +58,266 @@ void zfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
-int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+/*
+ * Length of the gzip member header at src, -1 if it is not one, -2 if
+ * it does not end within len bytes
+ */
+static long gzip_header_len(const unsigned char *src, unsigned long len)
 {
-	int i, flags;
+	unsigned long i = 10;
+	int flags;
 
-	/* skip header */
-	i = 10;
 	flags = src[3];
-	if (src[2] != DEFLATED || (flags & RESERVED) != 0) {
-		puts ("Error: Bad gzipped data\n");
-		return (-1);
-	}
+	if (src[2] != DEFLATED || (flags & RESERVED) != 0)
+		return -1;
 	if ((flags & EXTRA_FIELD) != 0)
 		i = 12 + src[10] + (src[11] << 8);
 	if ((flags & ORIG_NAME) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & COMMENT) != 0)
-		while (src[i++] != 0)
+		while (i < len && src[i++] != 0)
 			;
 	if ((flags & HEAD_CRC) != 0)
 		i += 2;
-	if (i >= *lenp) {
+	if (i >= len)
+		return -2;
+	return i;
+}
+
+static int zunzip_end(void *dst, int dstlen, unsigned char *src,
+		      unsigned long *lenp, int stoponerr, int offset,
+		      unsigned long *endp);
+
+#ifdef CONFIG_MP_JOBS
+/*
+ * Files made of several gzip members, as "split" and "cat" make them,
+ * are uncompressed a member per secondary core.  A member can only be
+ * found by its header, so every match of one is taken for a member,
+ * with the size in the trailer just before it telling where its data
+ * goes.  Should one of them be wrong, a member does not end where the
+ * next one was taken to start, and the whole file is uncompressed
+ * again one member after the other.
+ */
+#define GZ_SLOTS	4
+/* the inflate state, a 32 KiB window and some to spare */
+#define GZ_ARENA_SIZE	(48 * 1024)
+
+struct gz_slot {
+	struct mp_job job;		/* arg: src, srclen, dst, dstlen */
+	int last;			/* the member ends the file */
+	z_stream s;
+	unsigned char *arena;
+	unsigned long arena_used;
+};
+
+/* zalloc() for the streams of the jobs, which can not call malloc() */
+static void *gz_arena_alloc(void *x, unsigned items, unsigned size)
+{
+	struct gz_slot *sl = x;
+	void *p;
+
+	size *= items;
+	size = (size + ZALLOC_ALIGNMENT - 1) & ~(ZALLOC_ALIGNMENT - 1);
+	if (size > GZ_ARENA_SIZE - sl->arena_used)
+		return NULL;
+	p = sl->arena + sl->arena_used;
+	sl->arena_used += size;
+	return p;
+}
+
+static void gz_arena_free(void *x, void *addr, unsigned nb)
+{
+}
+
+/*
+ * Result is the length uncompressed, or -1 unless the member took all
+ * of the input and filled the output; the last one only has to end.
+ */
+static void gz_member_job(struct mp_job *job)
+{
+	struct gz_slot *sl = (struct gz_slot *)job;
+	int r;
+
+	sl->s.next_in = (unsigned char *)job->arg[0];
+	sl->s.avail_in = job->arg[1];
+	sl->s.next_out = (unsigned char *)job->arg[2];
+	sl->s.avail_out = job->arg[3];
+
+	r = inflate(&sl->s, Z_FINISH);
+	if (r != Z_STREAM_END ||
+	    (!sl->last && (sl->s.avail_in || sl->s.avail_out)))
+		job->result = -1;
+	else
+		job->result = sl->s.total_out;
+}
+
+/* Where the member after the one with its data at pos may start, or len */
+static unsigned long gz_next_member(const unsigned char *src,
+				    unsigned long len, unsigned long pos,
+				    unsigned long room)
+{
+	const unsigned char *p;
+
+	/* at least two bytes of data and the trailer before it */
+	for (pos += 10; pos + 10 < len; pos = p - src + 1) {
+		p = memchr(src + pos, 0x1f, len - 10 - pos);
+		if (!p)
+			break;
+		if (p[1] == 0x8b && p[2] == DEFLATED && !(p[3] & RESERVED) &&
+		    get_unaligned_le32(p - 4) <= room)
+			return p - src;
+	}
+	return len;
+}
+
+/* Starts the next member in sl, or does it right here without a core */
+static int gz_slot_start(struct gz_slot *sl, unsigned char *src,
+			 unsigned long srclen, unsigned char *dst,
+			 unsigned long dstlen, int last)
+{
+	if (sl->job.state == MP_JOB_BUSY)
+		mp_job_wait(&sl->job);
+	if (sl->job.state == MP_JOB_DONE && sl->job.result < 0)
+		return -1;
+
+	if (!sl->arena) {
+		sl->arena = malloc(GZ_ARENA_SIZE);
+		if (!sl->arena)
+			return -1;
+		sl->s.zalloc = gz_arena_alloc;
+		sl->s.zfree = gz_arena_free;
+		sl->s.opaque = sl;
+		if (inflateInit2(&sl->s, -MAX_WBITS) != Z_OK)
+			return -1;
+	} else if (inflateReset(&sl->s) != Z_OK) {
+		return -1;
+	}
+
+	sl->last = last;
+	sl->job.state = MP_JOB_IDLE;
+	sl->job.func = gz_member_job;
+	sl->job.arg[0] = (ulong)src;
+	sl->job.arg[1] = srclen;
+	sl->job.arg[2] = (ulong)dst;
+	sl->job.arg[3] = dstlen;
+	inflateWatchdog(&sl->s, 0);
+	if (mp_job_start(&sl->job)) {
+		inflateWatchdog(&sl->s, 1);
+		gz_member_job(&sl->job);
+		sl->job.state = MP_JOB_DONE;
+	}
+	return sl->job.result < 0 && sl->job.state == MP_JOB_DONE ? -1 : 0;
+}
+
+/*
+ * Returns 0 with the file uncompressed, -1 to leave it to the plain
+ * path: a single member, or the members not as they were taken for.
+ */
+static int gunzip_mp(void *dst, unsigned long dstlen, unsigned char *src,
+		     unsigned long *lenp, long hdrlen)
+{
+	struct gz_slot slots[GZ_SLOTS];
+	unsigned long len = *lenp, pos = 0, next, off = 0, size;
+	unsigned int n = 0;
+	int i, last, ret = -1;
+
+	/* without the real length there is no telling where to look */
+	if (len == ~0UL)
+		return -1;
+
+	next = gz_next_member(src, len, hdrlen, dstlen);
+	if (next == len)
+		return -1;
+
+	memset(slots, 0, sizeof(slots));
+	for (;;) {
+		last = next == len;
+		if (last) {
+			size = dstlen - off;
+			next = len + 8;
+		} else {
+			size = get_unaligned_le32(src + next - 4);
+		}
+
+		if (gz_slot_start(&slots[n % GZ_SLOTS], src + pos + hdrlen,
+				  next - 8 - pos - hdrlen,
+				  (unsigned char *)dst + off, size, last))
+			goto out;
+		n++;
+		off += size;
+		if (last)
+			break;
+
+		pos = next;
+		hdrlen = gzip_header_len(src + pos, len - pos);
+		if (hdrlen < 0)
+			goto out;
+		next = gz_next_member(src, len, pos + hdrlen, dstlen - off);
+	}
+	ret = 0;
+out:
+	for (i = 0; i < GZ_SLOTS; i++) {
+		if (slots[i].job.state == MP_JOB_BUSY)
+			mp_job_wait(&slots[i].job);
+		if (slots[i].job.state == MP_JOB_DONE &&
+		    slots[i].job.result < 0)
+			ret = -1;
+		if (slots[i].arena) {
+			inflateEnd(&slots[i].s);
+			free(slots[i].arena);
+		}
+	}
+	if (!ret)
+		*lenp = off - size + slots[(n - 1) % GZ_SLOTS].job.result;
+	return ret;
+}
+#endif
+
+/*
+ * Uncompresses one gzip member after the other, as long as the data
+ * following the trailer of one is another
+ */
+int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
+{
+	unsigned long pos = 0, off = 0, len, end;
+	long i;
+
+	i = gzip_header_len(src, *lenp);
+	if (i == -1) {
+		puts ("Error: Bad gzipped data\n");
+		return (-1);
+	}
+	if (i < 0) {
 		puts ("Error: gunzip out of data in header\n");
 		return (-1);
 	}
 
-	return zunzip(dst, dstlen, src, lenp, 1, i);
+#ifdef CONFIG_MP_JOBS
+	if (!gunzip_mp(dst, dstlen, src, lenp, i))
+		return 0;
+#endif
+
+	for (;;) {
+		len = *lenp - pos;
+		if (zunzip_end((unsigned char *)dst + off, dstlen - off,
+			       src + pos, &len, 1, i, &end))
+			return -1;
+		off += len;
+
+		/* end is 0 unless the member ended */
+		if (!end || end + 8 + 10 > *lenp - pos || off >= dstlen)
+			break;
+		pos += end + 8;
+		if (src[pos] != 0x1f || src[pos + 1] != 0x8b)
+			break;
+		i = gzip_header_len(src + pos, *lenp - pos);
+		if (i < 0)
+			break;
+	}
+	*lenp = off;
+
+	return 0;
 }
 
 /*
@@ -90,6 +325,14 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
  */
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 						int stoponerr, int offset)
+{
+	return zunzip_end(dst, dstlen, src, lenp, stoponerr, offset, NULL);
+}
+
+/* As zunzip(), also setting *endp to where the stream ended or to 0 */
+static int zunzip_end(void *dst, int dstlen, unsigned char *src,
+		      unsigned long *lenp, int stoponerr, int offset,
+		      unsigned long *endp)
 {
 	z_stream s;
 	int r;
@@ -117,7 +360,139 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 		s.avail_out = dstlen;
 	} while (r == Z_BUF_ERROR);
 	*lenp = s.next_out - (unsigned char *) dst;
+	if (endp)
+		*endp = r == Z_STREAM_END ? s.next_in - src : 0;
 	inflateEnd(&s);
 
 	return 0;
 }
+
+#ifdef CONFIG_LOAD_UNZIP
+/*
+ * Incremental gunzip: the compressed data is handed over piece by piece
+ * while it is being loaded.  Only one stream can be open at a time.
+ */
+static z_stream gz_stream;
+static int gz_active;
+
+int gunzip_stream_start(void *dst, unsigned long dstlen)
+{
+	int r;
+
+	if (gz_active)
+		gunzip_stream_end();
+
+	memset(&gz_stream, 0, sizeof(gz_stream));
+	gz_stream.zalloc = zalloc;
+	gz_stream.zfree = zfree;
+
+	/* let zlib parse the gzip header and check the trailer */
+	r = inflateInit2(&gz_stream, 16 + MAX_WBITS);
+	if (r != Z_OK) {
+		debug("gunzip stream: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	gz_stream.next_out = dst;
+	gz_stream.avail_out = dstlen;
+	gz_active = 1;
+
+	return 0;
+}
+
+int gunzip_stream_feed(const void *src, unsigned long len,
+		       unsigned long *lenp)
+{
+	int r;
+
+	if (!gz_active)
+		return -1;
+
+	gz_stream.next_in = (unsigned char *)src;
+	gz_stream.avail_in = len;
+	r = inflate(&gz_stream, Z_SYNC_FLUSH);
+	if (r == Z_STREAM_END) {
+		*lenp = gz_stream.total_out;
+		gunzip_stream_end();
+		return 1;
+	}
+	/* input left over with Z_OK means the output buffer is full */
+	if ((r != Z_OK && !(r == Z_BUF_ERROR && len == 0)) ||
+	    gz_stream.avail_in) {
+		debug("gunzip stream: inflate() returned %d\n", r);
+		gunzip_stream_end();
+		return -1;
+	}
+
+	return 0;
+}
+
+void gunzip_stream_end(void)
+{
+	if (gz_active)
+		inflateEnd(&gz_stream);
+	gz_active = 0;
+}
+#endif /* CONFIG_LOAD_UNZIP */
+
+#if defined(CONFIG_VIDEO_BMP_GZIP) || defined(CONFIG_FPGA_GZIP)
+/*
+ * Pulling gunzip: the caller asks for the decompressed data piece by
+ * piece, so that it never has to be all in memory.  Only one reader can
+ * be open at a time.
+ */
+static z_stream gz_read;
+static int gz_read_active;
+
+int gunzip_read_start(const void *src, unsigned long srclen)
+{
+	int r;
+
+	if (gz_read_active)
+		gunzip_read_end();
+
+	memset(&gz_read, 0, sizeof(gz_read));
+	gz_read.zalloc = zalloc;
+	gz_read.zfree = zfree;
+
+	r = inflateInit2(&gz_read, 16 + MAX_WBITS);
+	if (r != Z_OK) {
+		debug("gunzip read: inflateInit2() returned %d\n", r);
+		return -1;
+	}
+	gz_read.next_in = (unsigned char *)src;
+	gz_read.avail_in = srclen;
+	gz_read_active = 1;
+
+	return 0;
+}
+
+long gunzip_read(void *dst, unsigned long len)
+{
+	int r;
+
+	if (!gz_read_active)
+		return -1;
+
+	gz_read.next_out = dst;
+	gz_read.avail_out = len;
+	while (gz_read.avail_out) {
+		WATCHDOG_RESET();
+		r = inflate(&gz_read, Z_SYNC_FLUSH);
+		if (r == Z_STREAM_END)
+			break;
+		if (r != Z_OK) {
+			debug("gunzip read: inflate() returned %d\n", r);
+			return -1;
+		}
+	}
+
+	return len - gz_read.avail_out;
+}
+
+void gunzip_read_end(void)
+{
+	if (gz_read_active)
+		inflateEnd(&gz_read);
+	gz_read_active = 0;
+}
+#endif /* CONFIG_VIDEO_BMP_GZIP || CONFIG_FPGA_GZIP */
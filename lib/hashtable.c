@@ -50,9 +50,9 @@
 #ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
 #define	CONFIG_ENV_MIN_ENTRIES 64
 #endif
-#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum number of entries */
-#define	CONFIG_ENV_MAX_ENTRIES 512
-#endif
+
+/* A table filled further than this (in percent) is made twice as big */
+#define	HTAB_MAX_LOAD	70
 
 #include "search.h"
 
@@ -94,6 +94,15 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* The first prime number not smaller than nel */
+static unsigned int hprime(unsigned int nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -116,11 +125,7 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 		return 0;
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = hprime(nel);
 	htab->filled = 0;
 
 	/* allocate memory and zero out */
@@ -128,6 +133,13 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	if (htab->table == NULL)
 		return 0;
 
+	htab->sorted = malloc(htab->size * sizeof(ENTRY *));
+	if (htab->sorted == NULL) {
+		free(htab->table);
+		htab->table = NULL;
+		return 0;
+	}
+
 	/* everything went alright */
 	return 1;
 }
@@ -162,9 +174,60 @@ void hdestroy_r(struct hsearch_data *htab)
 		}
 	}
 	free(htab->table);
+	free(htab->sorted);
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
+	htab->sorted = NULL;
+}
+
+/*
+ * The sorted index:
+ *
+ * Every entry in the table is also listed in htab->sorted, ordered by
+ * key, so that hexport() does not need to collect and sort the whole
+ * table each time the environment is printed or saved.  An imported
+ * environment is already sorted, so entries are almost always added
+ * at the end.
+ */
+
+/* Position of key in the index, or where it would have to go */
+static unsigned int hsorted_pos(const char *key, struct hsearch_data *htab)
+{
+	unsigned int lo = 0, hi = htab->filled;
+
+	/* Fast path for the ascending keys of an exported environment */
+	if (hi && strcmp(key, htab->sorted[hi - 1]->key) > 0)
+		return hi;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (strcmp(htab->sorted[mid]->key, key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Enter ep into the index; htab->filled does not count it yet */
+static void hsorted_add(ENTRY *ep, struct hsearch_data *htab)
+{
+	unsigned int pos = hsorted_pos(ep->key, htab);
+
+	memmove(&htab->sorted[pos + 1], &htab->sorted[pos],
+		(htab->filled - pos) * sizeof(ENTRY *));
+	htab->sorted[pos] = ep;
+}
+
+/* Remove ep from the index; htab->filled still counts it */
+static void hsorted_del(ENTRY *ep, struct hsearch_data *htab)
+{
+	unsigned int pos = hsorted_pos(ep->key, htab);
+
+	memmove(&htab->sorted[pos], &htab->sorted[pos + 1],
+		(htab->filled - pos - 1) * sizeof(ENTRY *));
 }
 
 /*
@@ -247,30 +310,84 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	return 0;
 }
 
-int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
-	      struct hsearch_data *htab)
+/*
+ * First hash function: the value computed for the key, taken modulo
+ * the table size but never zero
+ */
+static unsigned int hhash(const char *key, unsigned int size)
 {
-	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
-	unsigned int idx;
-	unsigned int first_deleted = 0;
+	unsigned int len = strlen(key);
+	unsigned int hval = len;
+	unsigned int count = len;
 
 	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
 	while (count-- > 0) {
 		hval <<= 4;
-		hval += item.key[count];
+		hval += key[count];
 	}
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
+	hval %= size;
 	if (hval == 0)
 		++hval;
+	return hval;
+}
+
+/*
+ * Move all entries into a new table of at least nel entries.  The keys
+ * and data stay where they are, so does the order of the sorted index;
+ * deleted slots are left behind.  On failure the old table is kept.
+ */
+static int hresize_r(size_t nel, struct hsearch_data *htab)
+{
+	struct hsearch_data new = { NULL };
+	unsigned int i;
+
+	nel = hprime(nel);
+	if (nel < htab->filled + 1 || nel == htab->size)
+		return 0;
+
+	debug("hresize: %u entries, %u -> %zu\n", htab->filled,
+	      htab->size, nel);
+
+	if (hcreate_r(nel, &new) == 0) {
+		__set_errno(ENOMEM);
+		return 0;
+	}
+
+	for (i = 0; i < htab->filled; ++i) {
+		ENTRY *ep = htab->sorted[i];
+		unsigned int hval = hhash(ep->key, new.size);
+		unsigned int hval2 = 1 + hval % (new.size - 2);
+		unsigned int idx = hval;
+
+		/* The keys are known to differ, the first free slot it is */
+		while (new.table[idx].used) {
+			if (idx <= hval2)
+				idx = new.size + idx - hval2;
+			else
+				idx -= hval2;
+		}
+		new.table[idx].used = hval;
+		new.table[idx].entry = *ep;
+		new.sorted[i] = &new.table[idx].entry;
+	}
+	new.filled = htab->filled;
+
+	free(htab->table);
+	free(htab->sorted);
+	*htab = new;
+
+	return 1;
+}
+
+int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
+	      struct hsearch_data *htab)
+{
+	unsigned int hval;
+	unsigned int idx;
+	unsigned int first_deleted = 0;
+
+	hval = hhash(item.key, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -289,7 +406,8 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		if (htab->table[idx].used == hval
 		    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
 			/* Overwrite existing value? */
-			if ((action == ENTER) && (item.data != NULL)) {
+			if ((action == ENTER) && (item.data != NULL) &&
+			    strcmp(item.data, htab->table[idx].entry.data)) {
 				free(htab->table[idx].entry.data);
 				htab->table[idx].entry.data =
 					strdup(item.data);
@@ -331,7 +449,9 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			if ((htab->table[idx].used == hval)
 			    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
 				/* Overwrite existing value? */
-				if ((action == ENTER) && (item.data != NULL)) {
+				if ((action == ENTER) && (item.data != NULL) &&
+				    strcmp(item.data,
+					   htab->table[idx].entry.data)) {
 					free(htab->table[idx].entry.data);
 					htab->table[idx].entry.data =
 						strdup(item.data);
@@ -351,6 +471,15 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 
 	/* An empty bucket has been found. */
 	if (action == ENTER) {
+		/*
+		 * Past the load factor the probe sequences get long; have
+		 * the table grow, and search the bigger one.  Should there
+		 * be no memory for it, go on as long as there is room.
+		 */
+		if ((htab->filled + 1) * 100 > htab->size * HTAB_MAX_LOAD &&
+		    hresize_r(2 * htab->size, htab))
+			return hsearch_r(item, action, retval, htab);
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
@@ -378,6 +507,7 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			return 0;
 		}
 
+		hsorted_add(&htab->table[idx].entry, htab);
 		++htab->filled;
 
 		/* return new entry */
@@ -418,6 +548,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab)
 	/* free used ENTRY */
 	debug("hdelete: DELETING key \"%s\"\n", key);
 
+	hsorted_del(ep, htab);
 	free((void *)ep->key);
 	free(ep->data);
 	htab->table[idx].used = -1;
@@ -469,19 +600,25 @@ int hdelete_r(const char *key, struct hsearch_data *htab)
  *		bytes in the string will be '\0'-padded.
  */
 
-static int cmpkey(const void *p1, const void *p2)
+/* With a list of names, only the variables named are exported */
+static int hexport_wanted(ENTRY *ep, int argc, char * const argv[])
 {
-	ENTRY *e1 = *(ENTRY **) p1;
-	ENTRY *e2 = *(ENTRY **) p2;
+	int arg;
+
+	if (argc <= 0)
+		return 1;
 
-	return (strcmp(e1->key, e2->key));
+	for (arg = 0; arg < argc; ++arg)
+		if (strcmp(argv[arg], ep->key) == 0)
+			return 1;
+	return 0;
 }
 
 ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	ENTRY *list[htab->size];
+	ENTRY **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -496,57 +633,36 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 		"size = %zu\n", htab, htab->size, htab->filled, size);
 	/*
 	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
+	 * select entries from the sorted index,
+	 * compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
+	list = htab->sorted;
+	n = htab->table ? htab->filled : 0;
 
-		if (htab->table[i].used > 0) {
-			ENTRY *ep = &htab->table[i].entry;
-			int arg, found = 0;
+	for (i = 0, totlen = 0; i < n; ++i) {
+		ENTRY *ep = list[i];
 
-			for (arg = 0; arg < argc; ++arg) {
-				if (strcmp(argv[arg], ep->key) == 0) {
-					found = 1;
-					break;
-				}
-			}
-			if ((argc > 0) && (found == 0))
-				continue;
-
-			list[n++] = ep;
+		if (!hexport_wanted(ep, argc, argv))
+			continue;
 
-			totlen += strlen(ep->key) + 2;
+		totlen += strlen(ep->key) + 2;
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(ENTRY *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
@@ -579,6 +695,9 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
 	for (i = 0, p = res; i < n; ++i) {
 		const char *s;
 
+		if (!hexport_wanted(list[i], argc, argv))
+			continue;
+
 		s = list[i]->key;
 		while (*s)
 			*p++ = *s++;
@@ -638,6 +757,34 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep,
  * '\0' and '\n' have really been tested.
  */
 
+/*
+ * Count the "name=value" entries in data, and set *used to the number
+ * of bytes they take up.  An environment block ends at the first empty
+ * entry, a text file at the end of the buffer.
+ */
+static int himport_count(const char *data, size_t size, const char sep,
+			 size_t *used)
+{
+	const char *dp = data, *end = data + size;
+	int n = 0;
+
+	while (dp < end && *dp) {
+		const char *entry = dp;
+
+		while (dp < end && *dp && *dp != sep) {
+			if (*dp == '\\' && sep != '\0' && dp + 1 < end)
+				++dp;
+			++dp;
+		}
+		if (memchr(entry, '=', dp - entry))
+			++n;
+		++dp;		/* skip separator */
+	}
+
+	*used = dp < end ? dp - data : size;
+	return n;
+}
+
 int himport_r(struct hsearch_data *htab,
 	      const char *env, size_t size, const char sep, int flag)
 {
@@ -667,30 +814,21 @@ int himport_r(struct hsearch_data *htab,
 	}
 
 	/*
-	 * Create new hash table (if needed).  The computation of the hash
-	 * table size is based on heuristics: in a sample of some 70+
-	 * existing systems we found an average size of 39+ bytes per entry
-	 * in the environment (for the whole key=value pair). Assuming a
-	 * size of 8 per entry (= safety factor of ~5) should provide enough
-	 * safety margin for any existing environment definitions and still
-	 * allow for more than enough dynamic additions. Note that the
-	 * "size" argument is supposed to give the maximum enviroment size
-	 * (CONFIG_ENV_SIZE).  This heuristics will result in
-	 * unreasonably large numbers (and thus memory footprint) for
-	 * big flash environments (>8,000 entries for 64 KB
-	 * envrionment size), so we clip it to a reasonable value.
-	 * On the other hand we need to add some more entries for free
-	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * Create new hash table (if needed).  The variables already in
+	 * the data get twice as many slots, which keeps the double
+	 * hashing chains short, plus CONFIG_ENV_MIN_ENTRIES for the ones
+	 * set later.  No more room needs to be kept for these: the table
+	 * grows when it gets too full.  So a new import also gives back
+	 * what a table grown by many setenv's took.
 	 */
 
 	if (!htab->table) {
-		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
-
-		if (nent > CONFIG_ENV_MAX_ENTRIES)
-			nent = CONFIG_ENV_MAX_ENTRIES;
+		size_t used;
+		int nvars = himport_count(data, size, sep, &used);
+		int nent = 2 * nvars + CONFIG_ENV_MIN_ENTRIES;
 
-		debug("Create Hash Table: N=%d\n", nent);
+		debug("Create Hash Table: N=%d for %d variables\n",
+		      nent, nvars);
 
 		if (hcreate_r(nent, htab) == 0) {
 			free(data);
@@ -765,3 +903,46 @@ int himport_r(struct hsearch_data *htab,
 	debug("INSERT: done\n");
 	return 1;		/* everything OK */
 }
+
+/*
+ * Import an environment that has been split up already, like the
+ * default environment table made by tools/mkenvdefault: "n" variables
+ * with the escapes resolved, sorted by name.  The hash table is made
+ * new, with as many entries as himport_r() would give the same
+ * environment; sorted keys go to the end of the sorted index without
+ * searching it.
+ */
+int himport_table(struct hsearch_data *htab, const ENTRY *vars, int n)
+{
+	int i;
+
+	if (htab == NULL) {
+		__set_errno(EINVAL);
+		return 0;
+	}
+
+	if (htab->table)
+		hdestroy_r(htab);
+
+	debug("Create Hash Table: N=%d for %d variables\n",
+	      2 * n + CONFIG_ENV_MIN_ENTRIES, n);
+
+	if (hcreate_r(2 * n + CONFIG_ENV_MIN_ENTRIES, htab) == 0)
+		return 0;
+
+	for (i = 0; i < n; i++) {
+		ENTRY e, *rv;
+
+		e.key = vars[i].key;
+		e.data = vars[i].data;
+
+		hsearch_r(e, ENTER, &rv, htab);
+		if (rv == NULL) {
+			printf("himport_table: can't insert \"%s=%s\" into hash table\n",
+				e.key, e.data);
+			return 0;
+		}
+	}
+
+	return 1;
+}
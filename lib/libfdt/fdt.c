@@ -221,6 +221,8 @@ int fdt_move(const void *fdt, void *buf, int bufsize)
 	if (fdt_totalsize(fdt) > bufsize)
 		return -FDT_ERR_NOSPACE;
 
+	if (buf != fdt)
+		fdt_index_invalidate(buf);
 	memmove(buf, fdt, fdt_totalsize(fdt));
 	return 0;
 }
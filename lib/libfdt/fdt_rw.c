@@ -59,6 +59,26 @@
 
 #include "libfdt_internal.h"
 
+#ifndef USE_HOSTCC
+/* Without CONFIG_OF_INDEX there is no index to keep up to date */
+static void __fdt_index_splice(const void *fdt, int offset,
+			       int oldlen, int newlen)
+{
+}
+void fdt_index_splice(const void *fdt, int offset, int oldlen, int newlen)
+	__attribute__((weak, alias("__fdt_index_splice")));
+
+static void __fdt_index_invalidate(const void *fdt)
+{
+}
+void fdt_index_invalidate(const void *fdt)
+	__attribute__((weak, alias("__fdt_index_invalidate")));
+
+/* Nor, without CONFIG_OF_STAGE, any staged edits */
+void fdt_stage_splice(const void *fdt, int offset, int oldlen, int newlen)
+	__attribute__((weak, alias("__fdt_index_splice")));
+#endif
+
 static int _fdt_blocks_misordered(const void *fdt,
 			      int mem_rsv_size, int struct_size)
 {
@@ -135,6 +155,10 @@ static int _fdt_splice_struct(void *fdt, void *p,
 
 	fdt_set_size_dt_struct(fdt, fdt_size_dt_struct(fdt) + delta);
 	fdt_set_off_dt_strings(fdt, fdt_off_dt_strings(fdt) + delta);
+	fdt_index_splice(fdt, (char *)p - (char *)_fdt_offset_ptr(fdt, 0),
+			 oldlen, newlen);
+	fdt_stage_splice(fdt, (char *)p - (char *)_fdt_offset_ptr(fdt, 0),
+			 oldlen, newlen);
 	return 0;
 }
 
@@ -339,6 +363,7 @@ int fdt_add_subnode_namelen(void *fdt, int parentoffset,
 	err = _fdt_splice_struct(fdt, nh, 0, nodelen);
 	if (err)
 		return err;
+	fdt_index_invalidate(fdt);
 
 	nh->tag = cpu_to_fdt32(FDT_BEGIN_NODE);
 	memset(nh->name, 0, FDT_TAGALIGN(namelen+1));
@@ -364,6 +389,7 @@ int fdt_del_node(void *fdt, int nodeoffset)
 	if (endoffset < 0)
 		return endoffset;
 
+	fdt_index_invalidate(fdt);
 	return _fdt_splice_struct(fdt, _fdt_offset_ptr_w(fdt, nodeoffset),
 				  endoffset - nodeoffset, 0);
 }
@@ -401,6 +427,9 @@ int fdt_open_into(const void *fdt, void *buf, int bufsize)
 
 	FDT_CHECK_HEADER(fdt);
 
+	if (buf != fdt)
+		fdt_index_invalidate(buf);
+
 	mem_rsv_size = (fdt_num_mem_rsv(fdt)+1)
 		* sizeof(struct fdt_reserve_entry);
 
@@ -118,5 +118,6 @@ int fdt_nop_node(void *fdt, int nodeoffset)
 
 	_fdt_nop_region(fdt_offset_ptr_w(fdt, nodeoffset, 0),
 			endoffset - nodeoffset);
+	fdt_index_invalidate(fdt);
 	return 0;
 }
@@ -92,4 +92,18 @@ static inline struct fdt_reserve_entry *_fdt_mem_rsv_w(void *fdt, int n)
 
 #define FDT_SW_MAGIC		(~FDT_MAGIC)
 
+/*
+ * Keep the node index (lib/fdt_index.c) and the staged edits
+ * (lib/fdt_stage.c) in step with the edits
+ */
+#ifndef USE_HOSTCC
+void fdt_index_splice(const void *fdt, int offset, int oldlen, int newlen);
+void fdt_index_invalidate(const void *fdt);
+void fdt_stage_splice(const void *fdt, int offset, int oldlen, int newlen);
+#else
+#define fdt_index_splice(fdt, offset, oldlen, newlen)	do { } while (0)
+#define fdt_index_invalidate(fdt)			do { } while (0)
+#define fdt_stage_splice(fdt, offset, oldlen, newlen)	do { } while (0)
+#endif
+
 #endif /* _LIBFDT_INTERNAL_H */
@@ -11,16 +11,28 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <lmb.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 #define LMB_ALLOC_ANYWHERE	0
 
+#ifndef CONFIG_SYS_LMB_POLICY
+#define CONFIG_SYS_LMB_POLICY	LMB_POLICY_TOP_DOWN
+#endif
+
 void lmb_dump_all(struct lmb *lmb)
 {
 #ifdef DEBUG
 	unsigned long i;
 
 	debug("lmb_dump_all:\n");
+	debug("    policy		   = %d\n", lmb->policy);
+	debug("    prefer		   = 0x%llx/0x%llx\n",
+	      (unsigned long long)lmb->prefer_base,
+	      (unsigned long long)lmb->prefer_size);
+	debug("    align		   = 0x%lx\n", lmb->align);
 	debug("    memory.cnt		   = 0x%lx\n", lmb->memory.cnt);
 	debug("    memory.size		   = 0x%llx\n",
 	      (unsigned long long)lmb->memory.size);
@@ -91,8 +103,40 @@ static void lmb_coalesce_regions(struct lmb_region *rgn,
 	lmb_remove_region(rgn, r2);
 }
 
+static void lmb_init_region(struct lmb_region *rgn)
+{
+	/* drop the table of an earlier boot attempt */
+	if (rgn->region && rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = rgn->initial;
+	rgn->max = MAX_LMB_REGIONS;
+}
+
+/* Make room for more regions once malloc() is there */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+	unsigned long max = rgn->max * 2;
+	struct lmb_property *region;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return -1;
+
+	region = malloc((max + 1) * sizeof(*region));
+	if (!region)
+		return -1;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->region != rgn->initial)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max = max;
+	return 0;
+}
+
 void lmb_init(struct lmb *lmb)
 {
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
+
 	/* Create a dummy zero size LMB which will get coalesced away later.
 	 * This simplifies the lmb_add() code below...
 	 */
@@ -106,6 +150,21 @@ void lmb_init(struct lmb *lmb)
 	lmb->reserved.region[0].size = 0;
 	lmb->reserved.cnt = 1;
 	lmb->reserved.size = 0;
+
+	/* board_lmb_reserve() may change these */
+	lmb->policy = CONFIG_SYS_LMB_POLICY;
+#ifdef CONFIG_SYS_LMB_PREFER_SIZE
+	lmb->prefer_base = CONFIG_SYS_LMB_PREFER_BASE;
+	lmb->prefer_size = CONFIG_SYS_LMB_PREFER_SIZE;
+#else
+	lmb->prefer_base = 0;
+	lmb->prefer_size = 0;
+#endif
+#ifdef CONFIG_SYS_LMB_ALIGN
+	lmb->align = CONFIG_SYS_LMB_ALIGN;
+#else
+	lmb->align = 0;
+#endif
 }
 
 /* This routine called with relocation disabled. */
@@ -150,7 +209,7 @@ static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t
 
 	if (coalesced)
 		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
@@ -283,43 +342,102 @@ static phys_addr_t lmb_align_up(phys_addr_t addr, ulong size)
 	return (addr + (size - 1)) & ~(size - 1);
 }
 
-phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phys_addr_t max_addr)
+/*
+ * The free block of [lo, hi) that the policy likes best, 0 if there
+ * is none.  The reserved regions are sorted by their base.
+ */
+static phys_addr_t lmb_find(struct lmb *lmb, phys_size_t size, ulong align,
+			    phys_addr_t lo, phys_addr_t hi)
 {
+	struct lmb_region *res = &lmb->reserved;
+	phys_addr_t best = 0;
+	phys_size_t best_hole = 0;
 	long i, j;
-	phys_addr_t base = 0;
-	phys_addr_t res_base;
 
-	for (i = lmb->memory.cnt-1; i >= 0; i--) {
-		phys_addr_t lmbbase = lmb->memory.region[i].base;
-		phys_size_t lmbsize = lmb->memory.region[i].size;
+	for (i = 0; i < lmb->memory.cnt; i++) {
+		phys_addr_t start = lmb->memory.region[i].base;
+		phys_addr_t end = start + lmb->memory.region[i].size;
+		phys_addr_t pos;
 
-		if (lmbsize < size)
-			continue;
-		if (max_addr == LMB_ALLOC_ANYWHERE)
-			base = lmb_align_down(lmbbase + lmbsize - size, align);
-		else if (lmbbase < max_addr) {
-			base = min(lmbbase + lmbsize, max_addr);
-			base = lmb_align_down(base - size, align);
-		} else
+		if (start < lo)
+			start = lo;
+		if (hi != LMB_ALLOC_ANYWHERE && end > hi)
+			end = hi;
+		if (start >= end || end - start < size)
 			continue;
 
-		while (base && lmbbase <= base) {
-			j = lmb_overlaps_region(&lmb->reserved, base, size);
-			if (j < 0) {
-				/* This area isn't reserved, take it */
-				if (lmb_add_region(&lmb->reserved, base,
-							lmb_align_up(size,
-								align)) < 0)
-					return 0;
-				return base;
+		/* each hole between the reservations in [start, end) */
+		pos = start;
+		for (j = 0; pos < end && j <= res->cnt; j++) {
+			phys_addr_t hole_end = end, next = end;
+			phys_addr_t base;
+
+			if (j < res->cnt) {
+				phys_addr_t rbase = res->region[j].base;
+				phys_addr_t rend = rbase + res->region[j].size;
+
+				if (!res->region[j].size || rend <= pos)
+					continue;
+				if (rbase < end)
+					hole_end = rbase;
+				next = rend;
+			}
+
+			if (hole_end > pos && hole_end - pos >= size) {
+				base = lmb_align_down(hole_end - size, align);
+				if (base && base >= pos) {
+					phys_size_t hole = hole_end - pos;
+
+					if (lmb->policy == LMB_POLICY_BEST_FIT) {
+						if (!best || hole < best_hole ||
+						    (hole == best_hole &&
+						     base > best)) {
+							best = base;
+							best_hole = hole;
+						}
+					} else if (base > best) {
+						best = base;
+					}
+				}
 			}
-			res_base = lmb->reserved.region[j].base;
-			if (res_base < size)
-				break;
-			base = lmb_align_down(res_base - size, align);
+
+			if (next > pos)
+				pos = next;
 		}
 	}
-	return 0;
+	return best;
+}
+
+phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phys_addr_t max_addr)
+{
+	phys_addr_t prefer_end = lmb->prefer_base + lmb->prefer_size;
+	phys_addr_t base = 0;
+	ulong big = 0;
+
+	/* large blocks are placed so they can be mapped with large pages */
+	if (lmb->align > align && size >= lmb->align)
+		big = lmb->align;
+
+	if (lmb->prefer_size) {
+		if (max_addr != LMB_ALLOC_ANYWHERE && max_addr < prefer_end)
+			prefer_end = max_addr;
+		if (big)
+			base = lmb_find(lmb, size, big, lmb->prefer_base,
+					prefer_end);
+		if (!base)
+			base = lmb_find(lmb, size, align, lmb->prefer_base,
+					prefer_end);
+	}
+	if (!base && big)
+		base = lmb_find(lmb, size, big, 0, max_addr);
+	if (!base)
+		base = lmb_find(lmb, size, align, 0, max_addr);
+	if (!base)
+		return 0;
+
+	if (lmb_add_region(&lmb->reserved, base, lmb_align_up(size, align)) < 0)
+		return 0;
+	return base;
 }
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
@@ -335,6 +453,24 @@ int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 	return 0;
 }
 
+/* Is all of [base, base + size) memory that nothing has reserved? */
+int lmb_is_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
+{
+	int i;
+
+	if (lmb_overlaps_region(&lmb->reserved, base, size) >= 0)
+		return 0;
+
+	for (i = 0; i < lmb->memory.cnt; i++) {
+		phys_addr_t rgnbase = lmb->memory.region[i].base;
+		phys_size_t rgnsize = lmb->memory.region[i].size;
+
+		if (base >= rgnbase && base + size <= rgnbase + rgnsize)
+			return 1;
+	}
+	return 0;
+}
+
 void __board_lmb_reserve(struct lmb *lmb)
 {
 	/* please define platform specific board_lmb_reserve() */
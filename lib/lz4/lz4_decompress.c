@@ -0,0 +1,273 @@
+/*
+ * LZ4 decompression
+ *
+ * LZ4 is a byte oriented LZ77 format without entropy coding: every
+ * sequence is a run of literals followed by a copy of earlier output.
+ * It decompresses several times faster than gzip, at a somewhat worse
+ * ratio.  The format is described in lz4_Block_format.md and
+ * lz4_Frame_format.md of the reference implementation, see
+ * http://www.lz4.org/.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <watchdog.h>
+#include <lz4.h>
+#include <asm/unaligned.h>
+
+#define LZ4_FRAME_MAGIC		0x184d2204
+#define LZ4_LEGACY_MAGIC	0x184c2102
+
+/* Frame descriptor flags */
+#define LZ4_FLG_VERSION_MASK	0xc0
+#define LZ4_FLG_VERSION		0x40
+#define LZ4_FLG_BLOCK_CSUM	0x10
+#define LZ4_FLG_CONTENT_SIZE	0x08
+#define LZ4_FLG_CONTENT_CSUM	0x04
+#define LZ4_FLG_DICT_ID		0x01
+
+#define LZ4_BLOCK_UNCOMPRESSED	0x80000000
+
+/* Shortest match, and the slack the word copies may write past a run */
+#define LZ4_MIN_MATCH		4
+#define LZ4_WILD		8
+
+struct lz4_word {
+	u32 v;
+} __attribute__((packed));
+
+/* Copy 8 bytes; the compiler picks the best unaligned access */
+static inline void lz4_copy8(u8 *d, const u8 *s)
+{
+	((struct lz4_word *)d)->v = ((const struct lz4_word *)s)->v;
+	((struct lz4_word *)(d + 4))->v = ((const struct lz4_word *)(s + 4))->v;
+}
+
+/* Sum up a length that did not fit into its 4 bit field */
+static inline int lz4_length(const u8 **ip, const u8 *iend, size_t *len)
+{
+	unsigned int s;
+
+	do {
+		if (*ip >= iend)
+			return LZ4_E_INPUT_OVERRUN;
+		s = *(*ip)++;
+		*len += s;
+	} while (s == 255);
+
+	return LZ4_E_OK;
+}
+
+/*
+ * Decode one block from ip into op.  Matches may reach back as far as
+ * base, so that the blocks of a frame can refer to earlier ones.
+ */
+static int lz4_block(const u8 *ip, size_t in_len, u8 *base, u8 **opp,
+		     u8 *oend)
+{
+	const u8 *iend = ip + in_len;
+	u8 *op = *opp;
+	int r;
+
+	for (;;) {
+		unsigned int token, offset;
+		const u8 *match;
+		size_t len;
+
+		if (ip >= iend)
+			return LZ4_E_INPUT_OVERRUN;
+		token = *ip++;
+
+		/* literals */
+		len = token >> 4;
+		if (len == 15) {
+			r = lz4_length(&ip, iend, &len);
+			if (r != LZ4_E_OK)
+				return r;
+		}
+		if (len > (size_t)(iend - ip))
+			return LZ4_E_INPUT_OVERRUN;
+		if (len > (size_t)(oend - op))
+			return LZ4_E_OUTPUT_OVERRUN;
+
+		if ((size_t)(iend - ip) >= len + LZ4_WILD &&
+		    (size_t)(oend - op) >= len + LZ4_WILD) {
+			u8 *end = op + len;
+
+			while (op < end) {
+				lz4_copy8(op, ip);
+				op += 8;
+				ip += 8;
+			}
+			ip -= op - end;
+			op = end;
+		} else {
+			memcpy(op, ip, len);
+			op += len;
+			ip += len;
+		}
+
+		/* the last sequence has no match */
+		if (ip == iend)
+			break;
+
+		/* match */
+		if (iend - ip < 2)
+			return LZ4_E_INPUT_OVERRUN;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - base))
+			return LZ4_E_LOOKBEHIND_OVERRUN;
+		match = op - offset;
+
+		len = token & 15;
+		if (len == 15) {
+			r = lz4_length(&ip, iend, &len);
+			if (r != LZ4_E_OK)
+				return r;
+		}
+		len += LZ4_MIN_MATCH;
+		if (len > (size_t)(oend - op))
+			return LZ4_E_OUTPUT_OVERRUN;
+
+		/*
+		 * With the source at least 8 bytes back, every word is read
+		 * before the copy overwrites it.  Shorter offsets repeat a
+		 * pattern and are copied a byte at a time.
+		 */
+		if (offset >= 8 && (size_t)(oend - op) >= len + LZ4_WILD) {
+			u8 *end = op + len;
+
+			while (op < end) {
+				lz4_copy8(op, match);
+				op += 8;
+				match += 8;
+			}
+			op = end;
+		} else {
+			while (len--)
+				*op++ = *match++;
+		}
+	}
+
+	*opp = op;
+	return LZ4_E_OK;
+}
+
+int lz4_decompress_block(const unsigned char *src, size_t src_len,
+			 unsigned char *dst, size_t *dst_len)
+{
+	u8 *op = dst;
+	int r;
+
+	r = lz4_block(src, src_len, dst, &op, dst + *dst_len);
+	*dst_len = op - dst;
+	return r;
+}
+
+/* Blocks of the legacy format: a size, then up to 8 MiB of output */
+static int lz4_legacy(const u8 *ip, const u8 *iend, u8 **opp, u8 *oend)
+{
+	int r;
+
+	while (iend - ip >= 4) {
+		u32 size = get_unaligned_le32(ip);
+
+		ip += 4;
+		/* concatenated streams repeat the magic */
+		if (size == LZ4_LEGACY_MAGIC)
+			continue;
+		/* Linux appends the uncompressed size to its images */
+		if (ip == iend)
+			break;
+		if (size > (size_t)(iend - ip))
+			return LZ4_E_INPUT_OVERRUN;
+
+		r = lz4_block(ip, size, *opp, opp, oend);
+		if (r != LZ4_E_OK)
+			return r;
+		ip += size;
+		WATCHDOG_RESET();
+	}
+	return LZ4_E_OK;
+}
+
+static int lz4_frame(const u8 *ip, const u8 *iend, u8 *dst, u8 **opp,
+		     u8 *oend)
+{
+	unsigned int flg;
+	int r;
+
+	/* FLG, BD and the header checksum, which is not verified */
+	if (iend - ip < 3)
+		return LZ4_E_INPUT_OVERRUN;
+	flg = ip[0];
+	if ((flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION)
+		return LZ4_E_BAD_HEADER;
+	if (flg & LZ4_FLG_DICT_ID)
+		return LZ4_E_NOT_YET_IMPLEMENTED;
+	ip += 2;
+	if (flg & LZ4_FLG_CONTENT_SIZE)
+		ip += 8;
+	ip++;
+
+	for (;;) {
+		u32 size;
+
+		if (iend - ip < 4)
+			return LZ4_E_INPUT_OVERRUN;
+		size = get_unaligned_le32(ip);
+		ip += 4;
+		if (size == 0)		/* end mark */
+			break;
+
+		if ((size & ~LZ4_BLOCK_UNCOMPRESSED) > (size_t)(iend - ip))
+			return LZ4_E_INPUT_OVERRUN;
+
+		if (size & LZ4_BLOCK_UNCOMPRESSED) {
+			size &= ~LZ4_BLOCK_UNCOMPRESSED;
+			if (size > (size_t)(oend - *opp))
+				return LZ4_E_OUTPUT_OVERRUN;
+			memcpy(*opp, ip, size);
+			*opp += size;
+		} else {
+			/* linked blocks may refer to all earlier output */
+			r = lz4_block(ip, size, dst, opp, oend);
+			if (r != LZ4_E_OK)
+				return r;
+		}
+		ip += size;
+
+		if (flg & LZ4_FLG_BLOCK_CSUM)
+			ip += 4;
+		WATCHDOG_RESET();
+	}
+	return LZ4_E_OK;
+}
+
+int lz4_decompress(const unsigned char *src, size_t src_len,
+		   unsigned char *dst, size_t *dst_len)
+{
+	const u8 *iend = src + src_len;
+	u8 *op = dst;
+	u32 magic;
+	int r;
+
+	if (src_len < 4)
+		return LZ4_E_INPUT_OVERRUN;
+	magic = get_unaligned_le32(src);
+
+	if (magic == LZ4_FRAME_MAGIC)
+		r = lz4_frame(src + 4, iend, dst, &op, dst + *dst_len);
+	else if (magic == LZ4_LEGACY_MAGIC)
+		r = lz4_legacy(src + 4, iend, &op, dst + *dst_len);
+	else
+		r = LZ4_E_BAD_HEADER;
+
+	*dst_len = op - dst;
+	return r;
+}
@@ -31,7 +31,18 @@
 #define TREE_DECODE(probs, limit, i) \
   { i = 1; do { TREE_GET_BIT(probs, i); } while (i < limit); i -= limit; }
 
-/* #define _LZMA_SIZE_OPT */
+/* _LZMA_SIZE_OPT is set by CONFIG_LZMA_SIZE_OPT, see Makefile */
+
+/*
+ * U-Boot: serve the watchdog once per this many bytes of output rather
+ * than for every symbol; with a hardware watchdog each reset is a
+ * function call and an I/O access.
+ */
+#define LZMA_WATCHDOG_BYTES (1 << 16)
+
+struct lzma_word {
+  UInt32 v;
+} __attribute__((packed));
 
 #ifdef _LZMA_SIZE_OPT
 #define TREE_6_DECODE(probs, i) TREE_DECODE(probs, (1 << 6), i)
@@ -47,6 +58,13 @@
   i -= 0x40; }
 #endif
 
+/* One bit of a literal decoded against the byte at rep0 */
+#define MATCHED_LITER_DEC \
+  matchByte <<= 1; \
+  bit = (matchByte & offs); \
+  probLit = prob + offs + bit + symbol; \
+  GET_BIT2(probLit, symbol, offs &= ~bit, offs &= bit)
+
 #define NORMALIZE_CHECK if (range < kTopValue) { if (buf >= bufLimit) return DUMMY_ERROR; range <<= 8; code = (code << 8) | (*buf++); }
 
 #define IF_BIT_0_CHECK(p) ttt = *(p); NORMALIZE_CHECK; bound = (range >> kNumBitModelTotalBits) * ttt; if (code < bound)
@@ -158,6 +176,7 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
   const Byte *buf = p->buf;
   UInt32 range = p->range;
   UInt32 code = p->code;
+  UInt32 wdPos = processedPos;
 
   WATCHDOG_RESET();
 
@@ -168,6 +187,12 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
     unsigned ttt;
     unsigned posState = processedPos & pbMask;
 
+    if (processedPos - wdPos >= LZMA_WATCHDOG_BYTES)
+    {
+      WATCHDOG_RESET();
+      wdPos = processedPos;
+    }
+
     prob = probs + IsMatch + (state << kNumPosBitsMax) + posState;
     IF_BIT_0(prob)
     {
@@ -181,29 +206,42 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
       if (state < kNumLitStates)
       {
         symbol = 1;
-
-        WATCHDOG_RESET();
-
+#ifdef _LZMA_SIZE_OPT
         do { GET_BIT(prob + symbol, symbol) } while (symbol < 0x100);
+#else
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+#endif
       }
       else
       {
         unsigned matchByte = p->dic[(dicPos - rep0) + ((dicPos < rep0) ? dicBufSize : 0)];
         unsigned offs = 0x100;
+        unsigned bit;
+        CLzmaProb *probLit;
         symbol = 1;
-
-        WATCHDOG_RESET();
-
+#ifdef _LZMA_SIZE_OPT
         do
         {
-          unsigned bit;
-          CLzmaProb *probLit;
-          matchByte <<= 1;
-          bit = (matchByte & offs);
-          probLit = prob + offs + bit + symbol;
-          GET_BIT2(probLit, symbol, offs &= ~bit, offs &= bit)
+          MATCHED_LITER_DEC
         }
         while (symbol < 0x100);
+#else
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+        MATCHED_LITER_DEC
+#endif
       }
       dic[dicPos++] = (Byte)symbol;
       processedPos++;
@@ -328,8 +366,6 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
               UInt32 mask = 1;
               unsigned i = 1;
 
-              WATCHDOG_RESET();
-
               do
               {
                 GET_BIT2(prob + i, i, ; , distance |= mask);
@@ -342,8 +378,6 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           {
             numDirectBits -= kNumAlignBits;
 
-            WATCHDOG_RESET();
-
             do
             {
               NORMALIZE
@@ -417,17 +451,34 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           const Byte *lim = dest + curLen;
           dicPos += curLen;
 
-          WATCHDOG_RESET();
-
-          do
-            *(dest) = (Byte)*(dest + src);
-          while (++dest != lim);
+          /*
+           * U-Boot: a source at least a word back is never overwritten
+           * before it is read, so copy a word at a time
+           */
+          if (src <= -(ptrdiff_t)sizeof(UInt32))
+          {
+            while (lim - dest >= (ptrdiff_t)sizeof(UInt32))
+            {
+              ((struct lzma_word *)dest)->v =
+                ((const struct lzma_word *)(dest + src))->v;
+              dest += sizeof(UInt32);
+            }
+            while (dest != lim)
+            {
+              *dest = *(dest + src);
+              dest++;
+            }
+          }
+          else
+          {
+            do
+              *(dest) = (Byte)*(dest + src);
+            while (++dest != lim);
+          }
         }
         else
         {
 
-          WATCHDOG_RESET();
-
           do
           {
             dic[dicPos++] = dic[pos];
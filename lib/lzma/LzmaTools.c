@@ -50,8 +50,25 @@
 #include <linux/string.h>
 #include <malloc.h>
 
-static void *SzAlloc(void *p, size_t size) { p = p; return malloc(size); }
-static void SzFree(void *p, void *address) { p = p; free(address); }
+/*
+ * The only allocation is the probability table (the output buffer is
+ * the dictionary).  Keep it for the next image instead of going back
+ * to malloc() for every one.
+ */
+static void *lzma_probs;
+static size_t lzma_probs_size;
+
+static void *SzAlloc(void *p, size_t size)
+{
+    if (size > lzma_probs_size) {
+        free(lzma_probs);
+        lzma_probs = malloc(size);
+        lzma_probs_size = lzma_probs ? size : 0;
+    }
+    return lzma_probs;
+}
+
+static void SzFree(void *p, void *address) { }
 
 int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
                   unsigned char *inStream,  SizeT  length)
@@ -107,8 +124,10 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
         }
     }
 
-    debug ("LZMA: Uncompresed size............ 0x%x\n", outSizeFull);
-    debug ("LZMA: Compresed size.............. 0x%x\n", compressedSize);
+    debug ("LZMA: Uncompresed size............ 0x%lx\n",
+            (unsigned long)outSizeFull);
+    debug ("LZMA: Compresed size.............. 0x%lx\n",
+            (unsigned long)compressedSize);
 
     g_Alloc.Alloc = SzAlloc;
     g_Alloc.Free = SzFree;
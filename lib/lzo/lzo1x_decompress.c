@@ -15,6 +15,7 @@
 #include <linux/lzo.h>
 #include <asm/byteorder.h>
 #include <asm/unaligned.h>
+#include <mp_job.h>
 #include "lzodefs.h"
 
 #define HAVE_IP(x, ip_end, ip) ((size_t)(ip_end - ip) < (x))
@@ -23,6 +24,14 @@
 
 #define COPY4(dst, src)	\
 		put_unaligned(get_unaligned((const u32 *)(src)), (u32 *)(dst))
+/* inlined even with -fno-builtin, with the accesses the CPU allows */
+#define COPY8(dst, src)	__builtin_memcpy(dst, src, 8)
+
+/*
+ * Literal runs and matches are copied 16 bytes at a time, past their
+ * end, when there is that much room left in the buffers.
+ */
+#define FAST_HEADROOM	15
 
 static const unsigned char lzop_magic[] = {
 	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
@@ -62,14 +71,95 @@ static inline const unsigned char *parse_header(const unsigned char *src)
 	return src;
 }
 
+/* One lzop block: stored as it is when it did not compress */
+static int lzop_block(const unsigned char *src, u32 slen,
+		      unsigned char *dst, u32 dlen)
+{
+	size_t tmp = dlen;
+	int r;
+
+	if (slen == dlen) {
+		memcpy(dst, src, dlen);
+		return LZO_E_OK;
+	}
+
+	r = lzo1x_decompress_safe(src, slen, dst, &tmp);
+	if (r != LZO_E_OK)
+		return r;
+
+	return dlen == tmp ? LZO_E_OK : LZO_E_ERROR;
+}
+
+#ifdef CONFIG_MP_JOBS
+/*
+ * The blocks are independent and where each one goes follows from
+ * the block headers alone, so they are handed to the secondary cores
+ * as they are found; a block no core is free for is decompressed
+ * here meanwhile.
+ */
+#define LZOP_JOBS	4
+
+static void lzop_block_job(struct mp_job *job)
+{
+	job->result = lzop_block((const unsigned char *)job->arg[0],
+				 job->arg[1], (unsigned char *)job->arg[2],
+				 job->arg[3]);
+}
+
+/* Waits for the jobs not idle and returns the first error */
+static int lzop_jobs_wait(struct mp_job *jobs)
+{
+	int i, r = LZO_E_OK;
+
+	for (i = 0; i < LZOP_JOBS; i++) {
+		if (jobs[i].state == MP_JOB_IDLE)
+			continue;
+		if (mp_job_wait(&jobs[i]) != LZO_E_OK && r == LZO_E_OK)
+			r = jobs[i].result;
+		jobs[i].state = MP_JOB_IDLE;
+	}
+	return r;
+}
+
+/* Starts a block on a free core; returns -1 if there is none */
+static int lzop_block_start(struct mp_job *jobs, const unsigned char *src,
+			    u32 slen, unsigned char *dst, u32 dlen)
+{
+	struct mp_job *job;
+	int i;
+
+	for (i = 0; i < LZOP_JOBS; i++) {
+		job = &jobs[i];
+		if (job->state == MP_JOB_BUSY)
+			continue;
+		if (job->state == MP_JOB_DONE && job->result != LZO_E_OK)
+			return -1;
+
+		job->state = MP_JOB_IDLE;
+		job->func = lzop_block_job;
+		job->arg[0] = (ulong)src;
+		job->arg[1] = slen;
+		job->arg[2] = (ulong)dst;
+		job->arg[3] = dlen;
+		return mp_job_start(job);
+	}
+	return -1;
+}
+#endif
+
 int lzop_decompress(const unsigned char *src, size_t src_len,
 		    unsigned char *dst, size_t *dst_len)
 {
 	unsigned char *start = dst;
 	const unsigned char *send = src + src_len;
 	u32 slen, dlen;
-	size_t tmp;
-	int r;
+	int r = LZO_E_INPUT_OVERRUN;
+#ifdef CONFIG_MP_JOBS
+	struct mp_job jobs[LZOP_JOBS];
+	int jr;
+
+	memset(jobs, 0, sizeof(jobs));
+#endif
 
 	src = parse_header(src);
 	if (!src)
@@ -83,31 +173,40 @@ int lzop_decompress(const unsigned char *src, size_t src_len,
 		/* exit if last block */
 		if (dlen == 0) {
 			*dst_len = dst - start;
-			return LZO_E_OK;
+			r = LZO_E_OK;
+			break;
 		}
 
 		/* read compressed block size, and skip block checksum info */
 		slen = get_unaligned_be32(src);
 		src += 8;
 
-		if (slen <= 0 || slen > dlen)
-			return LZO_E_ERROR;
+		if (slen <= 0 || slen > dlen) {
+			r = LZO_E_ERROR;
+			break;
+		}
 
 		/* decompress */
-		tmp = dlen;
-		r = lzo1x_decompress_safe((u8 *) src, slen, dst, &tmp);
-
-		if (r != LZO_E_OK)
-			return r;
-
-		if (dlen != tmp)
-			return LZO_E_ERROR;
+#ifdef CONFIG_MP_JOBS
+		if (lzop_block_start(jobs, src, slen, dst, dlen))
+#endif
+		{
+			r = lzop_block(src, slen, dst, dlen);
+			if (r != LZO_E_OK)
+				break;
+			r = LZO_E_INPUT_OVERRUN;
+		}
 
 		src += slen;
 		dst += dlen;
 	}
 
-	return LZO_E_INPUT_OVERRUN;
+#ifdef CONFIG_MP_JOBS
+	jr = lzop_jobs_wait(jobs);
+	if (r == LZO_E_OK)
+		r = jr;
+#endif
+	return r;
 }
 
 int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
@@ -150,6 +249,23 @@ int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 			}
 			t += 15 + *ip++;
 		}
+		if (!HAVE_OP(t + 3 + FAST_HEADROOM, op_end, op) &&
+		    !HAVE_IP(t + 3 + FAST_HEADROOM, ip_end, ip)) {
+			const unsigned char *ie = ip + t + 3;
+			unsigned char *oe = op + t + 3;
+
+			do {
+				COPY8(op, ip);
+				op += 8;
+				ip += 8;
+				COPY8(op, ip);
+				op += 8;
+				ip += 8;
+			} while (ip < ie);
+			ip = ie;
+			op = oe;
+			goto first_literal_run;
+		}
 		if (HAVE_OP(t + 3, op_end, op))
 			goto output_overrun;
 		if (HAVE_IP(t + 4, ip_end, ip))
@@ -266,7 +382,21 @@ match:
 			if (HAVE_OP(t + 3 - 1, op_end, op))
 				goto output_overrun;
 
-			if (t >= 2 * 4 - (3 - 1) && (op - m_pos) >= 4) {
+			if ((op - m_pos) >= 8 &&
+			    !HAVE_OP(t + 3 - 1 + FAST_HEADROOM, op_end, op)) {
+				/* no overlap within one COPY8 */
+				unsigned char *oe = op + t + 3 - 1;
+
+				do {
+					COPY8(op, m_pos);
+					op += 8;
+					m_pos += 8;
+					COPY8(op, m_pos);
+					op += 8;
+					m_pos += 8;
+				} while (op < oe);
+				op = oe;
+			} else if (t >= 2 * 4 - (3 - 1) && (op - m_pos) >= 4) {
 				COPY4(op, m_pos);
 				op += 4;
 				m_pos += 4;
@@ -19,9 +19,146 @@
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
+#include <asm/byteorder.h>
+
+/*
+ * Helpers for the mem*() functions below, which work a word at a time.
+ * A source that is not aligned like the destination is read as aligned
+ * words, and each output word is merged from two of them by shifting;
+ * this never reads outside the words that hold the data.
+ */
+typedef unsigned long __attribute__((__may_alias__)) word_t;
+
+#define WSIZE		sizeof(word_t)
+#define WMASK		(WSIZE - 1)
+#define WONES		(~0UL / 0xff)		/* 0x01 in each byte */
+#define WHIGHS		(WONES << 7)		/* 0x80 in each byte */
+
+/* Start fetching this far ahead in bulk loops */
+#define MEM_PREFETCH_DIST	(8 * WSIZE)
+
+/* The word starting off bytes into w0, continuing into w1 */
+#ifdef __BIG_ENDIAN
+#define WMERGE(w0, w1, sh)	(((w0) << (sh)) | ((w1) >> (8 * WSIZE - (sh))))
+#else
+#define WMERGE(w0, w1, sh)	(((w0) >> (sh)) | ((w1) << (8 * WSIZE - (sh))))
+#endif
+
+/* Non-zero if a word holds a zero byte */
+#define WHASZERO(w)		(((w) - WONES) & ~(w) & WHIGHS)
+
+#if !defined(__HAVE_ARCH_MEMCPY) || !defined(__HAVE_ARCH_MEMMOVE)
+/*
+ * Copy count bytes upwards.  Every word is read before the word below it
+ * is written, so this is also safe when dest < src overlap.
+ */
+static void mem_copy_fwd(char *d8, const char *s8, size_t count)
+{
+	word_t *dl;
+	const word_t *sl;
+	word_t w0, w1;
+	unsigned int sh;
+
+	if (count >= 2 * WSIZE) {
+		/* align the destination */
+		while ((ulong)d8 & WMASK) {
+			*d8++ = *s8++;
+			count--;
+		}
+		dl = (word_t *)d8;
+		sh = 8 * ((ulong)s8 & WMASK);
+		sl = (const word_t *)((ulong)s8 & ~WMASK);
+
+		if (!sh) {
+			while (count >= 4 * WSIZE) {
+				__builtin_prefetch((const char *)sl +
+						MEM_PREFETCH_DIST);
+				dl[0] = sl[0];
+				dl[1] = sl[1];
+				dl[2] = sl[2];
+				dl[3] = sl[3];
+				dl += 4;
+				sl += 4;
+				count -= 4 * WSIZE;
+			}
+			while (count >= WSIZE) {
+				*dl++ = *sl++;
+				count -= WSIZE;
+			}
+			s8 = (const char *)sl;
+		} else {
+			s8 += count & ~WMASK;
+			w0 = *sl++;
+			while (count >= WSIZE) {
+				__builtin_prefetch((const char *)sl +
+						MEM_PREFETCH_DIST);
+				w1 = *sl++;
+				*dl++ = WMERGE(w0, w1, sh);
+				w0 = w1;
+				count -= WSIZE;
+			}
+		}
+		d8 = (char *)dl;
+	}
+	while (count--)
+		*d8++ = *s8++;
+}
+#endif
+
+#ifndef __HAVE_ARCH_MEMMOVE
+/* Copy count bytes downwards, from the end; safe when dest > src overlap */
+static void mem_copy_bwd(char *d8, const char *s8, size_t count)
+{
+	word_t *dl;
+	const word_t *sl;
+	word_t w0, w1;
+	unsigned int sh;
+
+	d8 += count;
+	s8 += count;
+	if (count >= 2 * WSIZE) {
+		while ((ulong)d8 & WMASK) {
+			*--d8 = *--s8;
+			count--;
+		}
+		dl = (word_t *)d8;
+		sh = 8 * ((ulong)s8 & WMASK);
+		sl = (const word_t *)((ulong)s8 & ~WMASK);
+
+		if (!sh) {
+			while (count >= 4 * WSIZE) {
+				sl -= 4;
+				dl -= 4;
+				dl[3] = sl[3];
+				dl[2] = sl[2];
+				dl[1] = sl[1];
+				dl[0] = sl[0];
+				count -= 4 * WSIZE;
+			}
+			while (count >= WSIZE) {
+				*--dl = *--sl;
+				count -= WSIZE;
+			}
+			s8 = (const char *)sl;
+		} else {
+			s8 -= count & ~WMASK;
+			w1 = *sl;
+			while (count >= WSIZE) {
+				w0 = *--sl;
+				*--dl = WMERGE(w0, w1, sh);
+				w1 = w0;
+				count -= WSIZE;
+			}
+		}
+		d8 = (char *)dl;
+	}
+	while (count--)
+		*--d8 = *--s8;
+}
+#endif
 
 
-#if 0 /* not used - was: #ifndef __HAVE_ARCH_STRNICMP */
+#ifndef __HAVE_ARCH_STRNICMP
 /**
  * strnicmp - Case insensitive, length-limited string comparison
  * @s1: One string
@@ -403,24 +540,33 @@ char *strswab(const char *s)
  */
 void * memset(void * s,int c,size_t count)
 {
-	unsigned long *sl = (unsigned long *) s;
-	unsigned long cl = 0;
-	char *s8;
-	int i;
+	word_t *sl;
+	word_t cl;
+	char *s8 = s;
 
 	/* do it one word at a time (32 bits or 64 bits) while possible */
-	if ( ((ulong)s & (sizeof(*sl) - 1)) == 0) {
-		for (i = 0; i < sizeof(*sl); i++) {
-			cl <<= 8;
-			cl |= c & 0xff;
+	if (count >= 2 * WSIZE) {
+		while ((ulong)s8 & WMASK) {
+			*s8++ = c;
+			count--;
+		}
+		sl = (word_t *)s8;
+		cl = (c & 0xff) * WONES;
+		while (count >= 4 * WSIZE) {
+			sl[0] = cl;
+			sl[1] = cl;
+			sl[2] = cl;
+			sl[3] = cl;
+			sl += 4;
+			count -= 4 * WSIZE;
 		}
-		while (count >= sizeof(*sl)) {
+		while (count >= WSIZE) {
 			*sl++ = cl;
-			count -= sizeof(*sl);
+			count -= WSIZE;
 		}
+		s8 = (char *)sl;
 	}
 	/* fill 8 bits at a time */
-	s8 = (char *)sl;
 	while (count--)
 		*s8++ = c;
 
@@ -464,24 +610,8 @@ char * bcopy(const char * src, char * dest, int count)
  */
 void * memcpy(void *dest, const void *src, size_t count)
 {
-	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
-	char *d8, *s8;
-
-	if (src == dest)
-		return dest;
-
-	/* while all data is aligned (common case), copy a word at a time */
-	if ( (((ulong)dest | (ulong)src) & (sizeof(*dl) - 1)) == 0) {
-		while (count >= sizeof(*dl)) {
-			*dl++ = *sl++;
-			count -= sizeof(*dl);
-		}
-	}
-	/* copy the reset one byte at a time */
-	d8 = (char *)dl;
-	s8 = (char *)sl;
-	while (count--)
-		*d8++ = *s8++;
+	if (src != dest)
+		mem_copy_fwd(dest, src, count);
 
 	return dest;
 }
@@ -498,23 +628,13 @@ void * memcpy(void *dest, const void *src, size_t count)
  */
 void * memmove(void * dest,const void *src,size_t count)
 {
-	char *tmp, *s;
-
 	if (src == dest)
 		return dest;
 
-	if (dest <= src) {
-		tmp = (char *) dest;
-		s = (char *) src;
-		while (count--)
-			*tmp++ = *s++;
-		}
-	else {
-		tmp = (char *) dest + count;
-		s = (char *) src + count;
-		while (count--)
-			*--tmp = *--s;
-		}
+	if (dest <= src || (char *)dest >= (const char *)src + count)
+		mem_copy_fwd(dest, src, count);
+	else
+		mem_copy_bwd(dest, src, count);
 
 	return dest;
 }
@@ -529,10 +649,48 @@ void * memmove(void * dest,const void *src,size_t count)
  */
 int memcmp(const void * cs,const void * ct,size_t count)
 {
-	const unsigned char *su1, *su2;
+	const unsigned char *su1 = cs, *su2 = ct;
+	const word_t *sl1, *sl2;
+	word_t w0, w1;
+	unsigned int sh;
 	int res = 0;
 
-	for( su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+	/* skip the words that are equal, the bytes tell which is bigger */
+	if (count >= 2 * WSIZE) {
+		while ((ulong)su1 & WMASK) {
+			if ((res = *su1 - *su2) != 0)
+				return res;
+			su1++;
+			su2++;
+			count--;
+		}
+		sl1 = (const word_t *)su1;
+		sh = 8 * ((ulong)su2 & WMASK);
+		sl2 = (const word_t *)((ulong)su2 & ~WMASK);
+
+		if (!sh) {
+			while (count >= WSIZE && *sl1 == *sl2) {
+				sl1++;
+				sl2++;
+				count -= WSIZE;
+			}
+		} else {
+			w0 = *sl2++;
+			while (count >= WSIZE) {
+				w1 = *sl2;
+				if (*sl1 != WMERGE(w0, w1, sh))
+					break;
+				sl1++;
+				sl2++;
+				w0 = w1;
+				count -= WSIZE;
+			}
+		}
+		su2 += (const unsigned char *)sl1 - su1;
+		su1 = (const unsigned char *)sl1;
+	}
+
+	for (; 0 < count; ++su1, ++su2, count--)
 		if ((res = *su1 - *su2) != 0)
 			break;
 	return res;
@@ -600,6 +758,28 @@ char * strstr(const char * s1,const char * s2)
 void *memchr(const void *s, int c, size_t n)
 {
 	const unsigned char *p = s;
+	const word_t *pl;
+	word_t cl, w;
+
+	if (n >= 2 * WSIZE) {
+		while ((ulong)p & WMASK) {
+			if ((unsigned char)c == *p)
+				return (void *)p;
+			p++;
+			n--;
+		}
+		/* skip words without the byte, and find it in the next one */
+		pl = (const word_t *)p;
+		cl = (c & 0xff) * WONES;
+		while (n >= WSIZE) {
+			w = *pl ^ cl;
+			if (WHASZERO(w))
+				break;
+			pl++;
+			n -= WSIZE;
+		}
+		p = (const unsigned char *)pl;
+	}
 	while (n-- != 0) {
 		if ((unsigned char)c == *p++) {
 			return (void *)(p-1);
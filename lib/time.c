@@ -30,6 +30,35 @@
 
 /* ------------------------------------------------------------------------- */
 
+#if defined(CONFIG_WATCHDOG_RATELIMIT) && \
+	(defined(CONFIG_HW_WATCHDOG) || defined(CONFIG_WATCHDOG))
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * Before relocation the timer may not run yet and there is nowhere to
+ * keep the time of the last kick, so every call goes through.
+ */
+void watchdog_reset_ratelimit(void)
+{
+	static ulong last;
+	ulong now;
+
+	if (gd->flags & GD_FLG_RELOC) {
+		now = get_timer(0);
+		if (last && now - last < CONFIG_WATCHDOG_RATELIMIT)
+			return;
+		last = now ? now : 1;
+	}
+#ifdef CONFIG_HW_WATCHDOG
+	hw_watchdog_reset();
+#else
+	watchdog_reset();
+#endif
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 void udelay(unsigned long usec)
 {
 	ulong kv;
@@ -720,9 +720,11 @@ void panic(const char *fmt, ...)
 {
 	va_list	args;
 	va_start(args, fmt);
+	console_quiet_flush();
 	vprintf(fmt, args);
 	putc('\n');
 	va_end(args);
+	serial_flush();
 #if defined (CONFIG_PANIC_HANG)
 	hang();
 #else
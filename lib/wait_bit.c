@@ -0,0 +1,71 @@
+/*
+ * Polling hardware with a timeout, without oversleeping
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <wait_bit.h>
+#include <asm/io.h>
+
+/* polls without a delay before the backoff starts */
+#ifndef CONFIG_SYS_WAIT_SPINS
+#define CONFIG_SYS_WAIT_SPINS		32
+#endif
+/* longest delay between two polls, in us */
+#ifndef CONFIG_SYS_WAIT_MAX_DELAY
+#define CONFIG_SYS_WAIT_MAX_DELAY	128
+#endif
+
+void wait_backoff_start(struct wait_backoff *wb, ulong timeout_ms)
+{
+	wb->start = get_timer(0);
+	wb->timeout = timeout_ms;
+	wb->spins = 0;
+	wb->delay = 0;
+}
+
+int wait_backoff(struct wait_backoff *wb)
+{
+	if (get_timer(wb->start) > wb->timeout)
+		return -1;
+
+	if (wb->spins < CONFIG_SYS_WAIT_SPINS) {
+		wb->spins++;
+		return 0;
+	}
+
+	if (!wb->delay)
+		wb->delay = 1;
+	udelay(wb->delay);		/* also triggers the watchdog */
+	if (wb->delay < CONFIG_SYS_WAIT_MAX_DELAY)
+		wb->delay <<= 1;
+	return 0;
+}
+
+int wait_for_bit(const char *prefix, const volatile void *reg, u32 mask,
+		 int set, ulong timeout_ms)
+{
+	struct wait_backoff wb;
+	u32 val;
+
+	wait_backoff_start(&wb, timeout_ms);
+	for (;;) {
+		val = readl(reg);
+		if (!set)
+			val = ~val;
+		if ((val & mask) == mask)
+			return 0;
+		if (wait_backoff(&wb))
+			break;
+	}
+
+	if (prefix)
+		printf("%s: timeout (reg %p, mask 0x%08x, %s)\n", prefix,
+		       reg, mask, set ? "set" : "clear");
+	return -ETIMEDOUT;
+}
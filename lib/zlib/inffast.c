@@ -31,6 +31,21 @@
 #  define PUP(a) *++(a)
 #endif
 
+/*
+   U-boot: with a 64 bit hold, a single unaligned load tops the bit buffer
+   up to at least 56 bits, which is enough for a whole length/distance pair
+   (48 bits, see below).  Only bytes that fully fit are taken, so hold never
+   has bits set above bits and the byte wise refills still work.
+ */
+#define WIDE_HOLD       (sizeof(unsigned long) >= 8)
+
+/* Matches at least this far back are copied a machine word at a time */
+#define WORD_COPY       sizeof(unsigned long)
+
+struct inflate_word {
+    unsigned long v;
+} __attribute__((packed));
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -128,7 +143,20 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
-        if (bits < 15) {
+        if (WIDE_HOLD && last - in >= 3) {  /* 8 bytes left to load */
+            if (bits < 48) {
+                unsigned n = (63 - bits) >> 3;
+                unsigned long long v;
+
+                v = le64_to_cpu(get_unaligned((unsigned long long *)
+                                              (in + OFF)));
+                v &= ~0ULL >> (64 - 8 * n);
+                hold += (unsigned long)v << bits;
+                in += n;
+                bits += 8 * n;
+            }
+        }
+        else if (bits < 15) {
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
             hold += (unsigned long)(PUP(in)) << bits;
@@ -253,6 +281,25 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                             PUP(out) = PUP(from);
                     }
                 }
+                else if (dist >= WORD_COPY) {
+                    /*
+                     * copy direct from output; each word is read before
+                     * it is overwritten since it lies at least a word back
+                     */
+                    struct inflate_word *wout, *wfrom;
+
+                    from = out - dist;
+                    wout = (struct inflate_word *)(out + OFF);
+                    wfrom = (struct inflate_word *)(from + OFF);
+                    while (len >= WORD_COPY) {
+                        (wout++)->v = (wfrom++)->v;
+                        len -= WORD_COPY;
+                    }
+                    out = (unsigned char *)wout - OFF;
+                    from = (unsigned char *)wfrom - OFF;
+                    while (len--)
+                        PUP(out) = PUP(from);
+                }
                 else {
 		    unsigned short *sout;
 		    unsigned long loops;
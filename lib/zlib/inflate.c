@@ -71,9 +71,22 @@ int stream_size;
     }
     state->wbits = (unsigned)windowBits;
     state->window = Z_NULL;
+    state->nowatchdog = 0;
     return inflateReset(strm);
 }
 
+int ZEXPORT inflateWatchdog(strm, on)
+z_streamp strm;
+int on;
+{
+    struct inflate_state FAR *state;
+
+    if (strm == Z_NULL || strm->state == Z_NULL) return Z_STREAM_ERROR;
+    state = (struct inflate_state FAR *)strm->state;
+    state->nowatchdog = !on;
+    return Z_OK;
+}
+
 int ZEXPORT inflateInit_(strm, version, stream_size)
 z_streamp strm;
 const char *version;
@@ -555,7 +568,8 @@ int flush;
             strm->adler = state->check = adler32(0L, Z_NULL, 0);
             state->mode = TYPE;
         case TYPE:
-	    WATCHDOG_RESET();
+	    if (!state->nowatchdog)
+		WATCHDOG_RESET();
             if (flush == Z_BLOCK) goto inf_leave;
         case TYPEDO:
             if (state->last) {
@@ -713,7 +727,10 @@ int flush;
             /* build code tables */
             state->next = state->codes;
             state->lencode = (code const FAR *)(state->next);
-            state->lenbits = 9;
+            /* U-boot: a 10 bit root table needs at most 1332 entries,
+               which still fits in ENOUGH - MAXD, and spares most codes
+               the second level lookup */
+            state->lenbits = 10;
             ret = inflate_table(LENS, state->lens, state->nlen, &(state->next),
                                 &(state->lenbits), state->work);
             if (ret) {
@@ -733,7 +750,8 @@ int flush;
             Tracev((stderr, "inflate:       codes ok\n"));
             state->mode = LEN;
         case LEN:
-	    WATCHDOG_RESET();
+	    if (!state->nowatchdog)
+		WATCHDOG_RESET();
             if (have >= 6 && left >= 258) {
                 RESTORE();
                 inflate_fast(strm, out);
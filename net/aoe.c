@@ -0,0 +1,489 @@
+/*
+ * ATA over Ethernet client
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * "aoe discover" finds the targets with a broadcast Query Config and
+ * identifies each one, which then is block device "aoe" <n> for the
+ * partition code and the file systems.  A transfer is one NetLoop():
+ * it is split into requests of as many sectors as fit into a frame,
+ * a window of them is kept in flight and the replies are
+ * matched to their requests by tag, in whatever order they come.
+ * Requests not answered in time are sent again.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <net.h>
+#include <part.h>
+#include <libata.h>
+#include <blkcache.h>
+#include <blkstats.h>
+#include "aoe.h"
+
+#ifndef CONFIG_LIBATA
+#error CONFIG_CMD_AOE needs CONFIG_LIBATA for the IDENTIFY data
+#endif
+
+#ifndef CONFIG_SYS_AOE_DEVS
+#define CONFIG_SYS_AOE_DEVS		4
+#endif
+/* Requests kept in flight, if the target and the Rx ring take that many */
+#ifndef CONFIG_AOE_WINDOW
+#define CONFIG_AOE_WINDOW		8
+#endif
+
+#define AOE_DISCOVER_TIMEOUT	1000UL	/* ms to wait for Query Config */
+#define AOE_TIMEOUT		200UL	/* ms without a reply */
+#define AOE_RETRIES		10
+#define AOE_MIN_FRAME		60
+
+struct aoe_target {
+	block_dev_desc_t blk;
+	uchar mac[6];
+	ushort major;
+	uchar minor;
+	int window;		/* requests in flight */
+	int sectors;		/* per request */
+};
+
+static struct aoe_target aoe_targets[CONFIG_SYS_AOE_DEVS];
+static int aoe_ndevs;
+
+struct aoe_req {
+	int busy;
+	uint tag;
+	lbaint_t lba;
+	int count;
+};
+
+enum aoe_op { AOE_OP_DISCOVER, AOE_OP_ATA };
+
+/* What the current NetLoop(AOE) is doing */
+static enum aoe_op aoe_op;
+static int aoe_want_major, aoe_want_minor;
+
+static struct aoe_target *aoe_cur;
+static uchar aoe_cmd, aoe_aflags;
+static lbaint_t aoe_start, aoe_next, aoe_end, aoe_done;
+static uchar *aoe_buf;
+static struct aoe_req aoe_reqs[CONFIG_AOE_WINDOW];
+static uint aoe_tag;
+static int aoe_retries;
+
+static uchar *aoe_set_hdr(uchar *mac, int major, int minor, int cmd,
+			  uint tag)
+{
+	uchar *pkt = (uchar *)NetTxPacket;
+	struct aoe_hdr *hdr;
+
+	pkt += NetSetEther(pkt, mac, PROT_AOE);
+	hdr = (struct aoe_hdr *)pkt;
+	hdr->ver_flags = AOE_VERSION << 4;
+	hdr->error = 0;
+	hdr->major = htons(major);
+	hdr->minor = minor;
+	hdr->cmd = cmd;
+	hdr->tag = htonl(tag);
+
+	return pkt + AOE_HDR_SIZE;
+}
+
+static void aoe_send(uchar *end)
+{
+	int len = end - (uchar *)NetTxPacket;
+
+	if (len < AOE_MIN_FRAME) {
+		memset(end, 0, AOE_MIN_FRAME - len);
+		len = AOE_MIN_FRAME;
+	}
+	NetSendPacket(NetTxPacket, len);
+}
+
+static void aoe_send_req(struct aoe_req *req)
+{
+	struct aoe_target *t = aoe_cur;
+	struct aoe_ata *ata;
+	uchar *pkt;
+	u64 lba = req->lba;
+	int i;
+
+	pkt = aoe_set_hdr(t->mac, t->major, t->minor, AOE_CMD_ATA, req->tag);
+	ata = (struct aoe_ata *)pkt;
+	ata->aflags = aoe_aflags;
+	ata->err_feature = 0;
+	ata->sectors = req->count;
+	ata->cmd_status = aoe_cmd;
+	for (i = 0; i < 6; i++)
+		ata->lba[i] = lba >> (8 * i);
+	/* LBA mode, for the 28 bit commands */
+	if (!(aoe_aflags & AOE_AFLAG_EXT))
+		ata->lba[3] |= 0xe0;
+	ata->reserved[0] = ata->reserved[1] = 0;
+	pkt += AOE_ATA_SIZE;
+
+	if (aoe_aflags & AOE_AFLAG_WRITE) {
+		memcpy(pkt, aoe_buf + (req->lba - aoe_start) * AOE_SECT_SIZE,
+		       req->count * AOE_SECT_SIZE);
+		pkt += req->count * AOE_SECT_SIZE;
+	}
+	aoe_send(pkt);
+}
+
+/* Fill the window with requests for what has not been asked for yet */
+static void aoe_issue(void)
+{
+	struct aoe_req *req;
+	int i;
+
+	for (i = 0; i < aoe_cur->window && aoe_next < aoe_end; i++) {
+		req = &aoe_reqs[i];
+		if (req->busy)
+			continue;
+		req->busy = 1;
+		req->tag = ++aoe_tag;
+		req->lba = aoe_next;
+		req->count = min(aoe_end - aoe_next, (lbaint_t)aoe_cur->sectors);
+		aoe_next += req->count;
+		aoe_send_req(req);
+	}
+}
+
+static void AoeTimeout(void)
+{
+	int i;
+
+	if (aoe_op == AOE_OP_DISCOVER) {
+		/* whoever has answered by now */
+		NetState = NETLOOP_SUCCESS;
+		return;
+	}
+
+	if (++aoe_retries > AOE_RETRIES) {
+		printf("AoE: e%d.%d not responding\n",
+		       aoe_cur->major, aoe_cur->minor);
+		NetState = NETLOOP_FAIL;
+		return;
+	}
+	puts("T ");
+
+	for (i = 0; i < aoe_cur->window; i++)
+		if (aoe_reqs[i].busy)
+			aoe_send_req(&aoe_reqs[i]);
+	NetSetTimeout(AOE_TIMEOUT, AoeTimeout);
+}
+
+static struct aoe_target *aoe_find(int major, int minor)
+{
+	int i;
+
+	for (i = 0; i < aoe_ndevs; i++)
+		if (aoe_targets[i].major == major &&
+		    aoe_targets[i].minor == minor)
+			return &aoe_targets[i];
+	return NULL;
+}
+
+static void aoe_cfg_reply(Ethernet_t *et, struct aoe_hdr *hdr,
+			  uchar *pkt, unsigned len)
+{
+	struct aoe_cfg *cfg = (struct aoe_cfg *)pkt;
+	struct aoe_target *t;
+	int major = ntohs(hdr->major);
+	int sectors;
+
+	if (len < sizeof(*cfg) ||
+	    (aoe_want_major != AOE_MAJOR_ANY && major != aoe_want_major) ||
+	    (aoe_want_minor != AOE_MINOR_ANY && hdr->minor != aoe_want_minor))
+		return;
+
+	/* seen on another of its interfaces */
+	if (aoe_find(major, hdr->minor))
+		return;
+	if (aoe_ndevs == CONFIG_SYS_AOE_DEVS) {
+		printf("AoE: no room for e%d.%d\n", major, hdr->minor);
+		return;
+	}
+
+	t = &aoe_targets[aoe_ndevs++];
+	memset(t, 0, sizeof(*t));
+	memcpy(t->mac, et->et_src, 6);
+	t->major = major;
+	t->minor = hdr->minor;
+
+	/* A burst larger than the Rx ring would only be dropped */
+	t->window = min(CONFIG_AOE_WINDOW, PKTBUFSRX);
+	if (ntohs(cfg->bufcnt) && ntohs(cfg->bufcnt) < t->window)
+		t->window = ntohs(cfg->bufcnt);
+
+	sectors = (eth_get_mtu() - AOE_HDR_SIZE - AOE_ATA_SIZE) /
+		  AOE_SECT_SIZE;
+	if (cfg->sectors && cfg->sectors < sectors)
+		sectors = cfg->sectors;
+	t->sectors = max(sectors, 1);
+
+	debug("AoE: e%d.%d at %pM, window %d, %d sectors\n", t->major,
+	      t->minor, t->mac, t->window, t->sectors);
+
+	if (aoe_want_major != AOE_MAJOR_ANY && aoe_want_minor != AOE_MINOR_ANY)
+		NetState = NETLOOP_SUCCESS;
+}
+
+/* Pass one frame of type PROT_AOE, 'pkt' is past the Ethernet header */
+void AoeReceive(Ethernet_t *et, uchar *pkt, unsigned len)
+{
+	struct aoe_hdr *hdr = (struct aoe_hdr *)pkt;
+	struct aoe_ata *ata;
+	struct aoe_req *req = NULL;
+	uint tag;
+	int i;
+
+	if (len < AOE_HDR_SIZE || (hdr->ver_flags >> 4) != AOE_VERSION ||
+	    !(hdr->ver_flags & AOE_FLAG_RSP))
+		return;
+	pkt += AOE_HDR_SIZE;
+	len -= AOE_HDR_SIZE;
+
+	if (aoe_op == AOE_OP_DISCOVER) {
+		if (hdr->cmd == AOE_CMD_CFG)
+			aoe_cfg_reply(et, hdr, pkt, len);
+		return;
+	}
+
+	if (hdr->cmd != AOE_CMD_ATA || ntohs(hdr->major) != aoe_cur->major ||
+	    hdr->minor != aoe_cur->minor)
+		return;
+
+	/* Late duplicates of answers already taken find no request */
+	tag = ntohl(hdr->tag);
+	for (i = 0; i < aoe_cur->window; i++) {
+		if (aoe_reqs[i].busy && aoe_reqs[i].tag == tag) {
+			req = &aoe_reqs[i];
+			break;
+		}
+	}
+	if (!req)
+		return;
+
+	ata = (struct aoe_ata *)pkt;
+	if ((hdr->ver_flags & AOE_FLAG_ERR) || len < AOE_ATA_SIZE ||
+	    (ata->cmd_status & (ATA_ERR | ATA_DF))) {
+		printf("AoE: e%d.%d error %d, status %02x at block %llu\n",
+		       aoe_cur->major, aoe_cur->minor, hdr->error,
+		       len < AOE_ATA_SIZE ? 0 : ata->cmd_status,
+		       (unsigned long long)req->lba);
+		NetState = NETLOOP_FAIL;
+		return;
+	}
+	pkt += AOE_ATA_SIZE;
+	len -= AOE_ATA_SIZE;
+
+	if (!(aoe_aflags & AOE_AFLAG_WRITE)) {
+		if (len < req->count * AOE_SECT_SIZE)
+			return;
+		memcpy(aoe_buf + (req->lba - aoe_start) * AOE_SECT_SIZE, pkt,
+		       req->count * AOE_SECT_SIZE);
+	}
+
+	req->busy = 0;
+	aoe_done += req->count;
+	aoe_retries = 0;
+	if (aoe_done == aoe_end - aoe_start) {
+		NetState = NETLOOP_SUCCESS;
+		return;
+	}
+	aoe_issue();
+	NetSetTimeout(AOE_TIMEOUT, AoeTimeout);
+}
+
+void AoeStart(void)
+{
+	struct aoe_cfg *cfg;
+	uchar *pkt;
+
+	if (aoe_op == AOE_OP_DISCOVER) {
+		pkt = aoe_set_hdr(NetBcastAddr, aoe_want_major, aoe_want_minor,
+				  AOE_CMD_CFG, 0);
+		cfg = (struct aoe_cfg *)pkt;
+		memset(cfg, 0, sizeof(*cfg));
+		cfg->ver_ccmd = AOE_VERSION << 4;	/* read config */
+		aoe_send(pkt + sizeof(*cfg));
+		NetSetTimeout(AOE_DISCOVER_TIMEOUT, AoeTimeout);
+		return;
+	}
+
+	memset(aoe_reqs, 0, sizeof(aoe_reqs));
+	aoe_next = aoe_start;
+	aoe_done = 0;
+	aoe_retries = 0;
+	aoe_issue();
+	NetSetTimeout(AOE_TIMEOUT, AoeTimeout);
+}
+
+/* Run an ATA command over 'count' sectors from 'lba' */
+static int aoe_ata(struct aoe_target *t, int cmd, int aflags, lbaint_t lba,
+		   lbaint_t count, void *buf)
+{
+	aoe_op = AOE_OP_ATA;
+	aoe_cur = t;
+	aoe_cmd = cmd;
+	aoe_aflags = aflags;
+	aoe_start = lba;
+	aoe_end = lba + count;
+	aoe_buf = buf;
+
+	if (!count)
+		return 0;
+	return NetLoop(AOE) < 0 ? -1 : 0;
+}
+
+static struct aoe_target *aoe_get(int dev)
+{
+	if (dev < 0 || dev >= aoe_ndevs ||
+	    aoe_targets[dev].blk.if_type != IF_TYPE_AOE)
+		return NULL;
+	return &aoe_targets[dev];
+}
+
+static unsigned long aoe_block_read(int dev, unsigned long start,
+				    lbaint_t blkcnt, void *buffer)
+{
+	struct aoe_target *t = aoe_get(dev);
+	unsigned long long s;
+	int ret;
+
+	if (!t || start + blkcnt > t->blk.lba)
+		return 0;
+
+	if (blkcache_read(IF_TYPE_AOE, dev, start, blkcnt, AOE_SECT_SIZE,
+			  buffer) ||
+	    blkcache_readahead(&t->blk, start, blkcnt, buffer))
+		return blkcnt;
+
+	s = blkstats_start();
+	ret = aoe_ata(t, AOE_ATA_READ_EXT, AOE_AFLAG_EXT, start, blkcnt,
+		      buffer);
+	blkstats_end(IF_TYPE_AOE, dev, BLKSTATS_READ,
+		     ret ? 0 : blkcnt * AOE_SECT_SIZE, s);
+	if (ret)
+		return 0;
+
+	blkcache_fill(IF_TYPE_AOE, dev, start, blkcnt, AOE_SECT_SIZE, buffer);
+	return blkcnt;
+}
+
+static unsigned long aoe_block_write(int dev, unsigned long start,
+				     lbaint_t blkcnt, const void *buffer)
+{
+	struct aoe_target *t = aoe_get(dev);
+	unsigned long long s;
+	int ret;
+
+	if (!t || start + blkcnt > t->blk.lba)
+		return 0;
+
+	dev_invalidate(IF_TYPE_AOE, dev);
+	s = blkstats_start();
+	ret = aoe_ata(t, AOE_ATA_WRITE_EXT, AOE_AFLAG_EXT | AOE_AFLAG_WRITE,
+		      start, blkcnt, (void *)buffer);
+	blkstats_end(IF_TYPE_AOE, dev, BLKSTATS_WRITE,
+		     ret ? 0 : blkcnt * AOE_SECT_SIZE, s);
+
+	return ret ? 0 : blkcnt;
+}
+
+static int aoe_identify(struct aoe_target *t, int dev)
+{
+	block_dev_desc_t *blk = &t->blk;
+	u16 id[ATA_ID_WORDS];
+	u64 n;
+
+	if (aoe_ata(t, ATA_CMD_ID_ATA, 0, 0, 1, id))
+		return -1;
+	ata_swap_buf_le16(id, ATA_ID_WORDS);
+
+	n = ata_id_n_sectors(id);
+	if (n > (lbaint_t)~0) {
+		printf("AoE: e%d.%d: only the first %llu blocks are "
+		       "usable\n", t->major, t->minor,
+		       (unsigned long long)(lbaint_t)~0);
+		n = (lbaint_t)~0;
+	}
+
+	blk->if_type = IF_TYPE_AOE;
+	blk->dev = dev;
+	blk->part_type = PART_TYPE_UNKNOWN;
+	blk->type = DEV_TYPE_HARDDISK;
+#ifdef CONFIG_LBA48
+	blk->lba48 = ata_id_has_lba48(id);
+#endif
+	blk->lba = n;
+	blk->blksz = AOE_SECT_SIZE;
+	ata_id_c_string(id, (uchar *)blk->vendor, ATA_ID_PROD,
+			sizeof(blk->vendor));
+	ata_id_c_string(id, (uchar *)blk->product, ATA_ID_SERNO,
+			sizeof(blk->product));
+	ata_id_c_string(id, (uchar *)blk->revision, ATA_ID_FW_REV,
+			sizeof(blk->revision));
+	blk->block_read = aoe_block_read;
+	blk->block_write = aoe_block_write;
+	blk->priv = t;
+
+	init_part(blk);
+	return 0;
+}
+
+/*
+ * Forget the targets found before, look for new ones and return how
+ * many are usable
+ */
+int aoe_discover(int major, int minor)
+{
+	int i, n, ok = 0;
+
+	for (i = 0; i < aoe_ndevs; i++)
+		dev_invalidate(IF_TYPE_AOE, i);
+	aoe_ndevs = 0;
+
+	aoe_op = AOE_OP_DISCOVER;
+	aoe_want_major = major;
+	aoe_want_minor = minor;
+	if (NetLoop(AOE) < 0)
+		return -1;
+
+	/* identifying runs NetLoop(AOE) again, as do the reads */
+	n = aoe_ndevs;
+	for (i = 0; i < n; i++) {
+		if (aoe_identify(&aoe_targets[i], i))
+			printf("AoE: e%d.%d: identify failed\n",
+			       aoe_targets[i].major, aoe_targets[i].minor);
+		else
+			ok++;
+	}
+	return ok;
+}
+
+void aoe_print_devs(void)
+{
+	struct aoe_target *t;
+	int i;
+
+	for (i = 0; i < aoe_ndevs; i++) {
+		t = aoe_get(i);
+		if (!t)
+			continue;
+		printf("%d: e%d.%d at %pM, %d x %d sectors in flight\n   ",
+		       i, t->major, t->minor, t->mac, t->window, t->sectors);
+		dev_print(&t->blk);
+	}
+}
+
+block_dev_desc_t *aoe_get_dev(int dev)
+{
+	struct aoe_target *t = aoe_get(dev);
+
+	return t ? &t->blk : NULL;
+}
@@ -0,0 +1,69 @@
+/*
+ * ATA over Ethernet client
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __AOE_H__
+#define __AOE_H__
+
+#define AOE_VERSION		1
+
+/* ver_flags */
+#define AOE_FLAG_RSP		0x08	/* response */
+#define AOE_FLAG_ERR		0x04	/* error in 'error' */
+
+/* cmd */
+#define AOE_CMD_ATA		0
+#define AOE_CMD_CFG		1
+
+/* aflags of an ATA command */
+#define AOE_AFLAG_EXT		0x40	/* 48 bit LBA */
+#define AOE_AFLAG_DEV		0x10	/* device/head register bit 4 */
+#define AOE_AFLAG_WRITE		0x01
+
+/* The PIO commands, which every target implements */
+#define AOE_ATA_READ_EXT	0x24
+#define AOE_ATA_WRITE_EXT	0x34
+
+#define AOE_MAJOR_ANY		0xffff
+#define AOE_MINOR_ANY		0xff
+
+#define AOE_SECT_SIZE		512
+
+struct aoe_hdr {
+	uchar	ver_flags;
+	uchar	error;
+	ushort	major;			/* shelf */
+	uchar	minor;			/* slot */
+	uchar	cmd;
+	uint	tag;
+} __attribute__((packed));
+
+struct aoe_ata {
+	uchar	aflags;
+	uchar	err_feature;
+	uchar	sectors;
+	uchar	cmd_status;
+	uchar	lba[6];
+	uchar	reserved[2];
+} __attribute__((packed));
+
+struct aoe_cfg {
+	ushort	bufcnt;			/* requests the target can queue */
+	ushort	fwver;
+	uchar	sectors;		/* per ATA command, 0 if no limit */
+	uchar	ver_ccmd;
+	ushort	cfg_len;
+} __attribute__((packed));
+
+#define AOE_HDR_SIZE		sizeof(struct aoe_hdr)
+#define AOE_ATA_SIZE		sizeof(struct aoe_ata)
+
+extern void	AoeStart(void);		/* Begin the current operation */
+extern void	AoeReceive(Ethernet_t *et, uchar *pkt, unsigned len);
+
+#endif /* __AOE_H__ */
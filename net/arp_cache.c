@@ -0,0 +1,117 @@
+/*
+ * Cache of the ethernet addresses of the hosts we talk to
+ *
+ * Without it, every network command asks for the server's address
+ * again, and the address of one host is forgotten as soon as another
+ * one is looked up.  The table keeps CONFIG_NET_ARP_CACHE_SIZE hosts,
+ * learnt from the ARP packets we receive, for CONFIG_NET_ARP_CACHE_AGE
+ * milliseconds after they were last heard of.  A retry of the network
+ * command throws it all away, in case a host has moved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#include <common.h>
+#include <net.h>
+#include "arp_cache.h"
+
+#ifndef CONFIG_NET_ARP_CACHE_SIZE
+#define CONFIG_NET_ARP_CACHE_SIZE	8
+#endif
+
+#ifndef CONFIG_NET_ARP_CACHE_AGE
+#define CONFIG_NET_ARP_CACHE_AGE	300000UL
+#endif
+
+struct arp_entry {
+	IPaddr_t	ip;		/* 0 for a free entry */
+	uchar		ether[6];
+	ulong		time;		/* get_timer() when last heard of */
+};
+
+static struct arp_entry arp_table[CONFIG_NET_ARP_CACHE_SIZE];
+
+static struct arp_entry *arp_cache_find(IPaddr_t ip)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_NET_ARP_CACHE_SIZE; i++) {
+		if (arp_table[i].ip != ip)
+			continue;
+		if (get_timer(arp_table[i].time) < CONFIG_NET_ARP_CACHE_AGE)
+			return &arp_table[i];
+		arp_table[i].ip = 0;
+		break;
+	}
+	return NULL;
+}
+
+void arp_cache_learn(IPaddr_t ip, const uchar *ether, int add)
+{
+	struct arp_entry *e = arp_cache_find(ip);
+	int i;
+
+	if (!ip || is_multicast_ether_addr(ether) ||
+	    is_zero_ether_addr(ether))
+		return;
+
+	if (!e) {
+		if (!add)
+			return;
+
+		/* a free entry, or else the one heard of longest ago */
+		e = &arp_table[0];
+		for (i = 0; i < CONFIG_NET_ARP_CACHE_SIZE && e->ip; i++)
+			if (!arp_table[i].ip ||
+			    get_timer(arp_table[i].time) > get_timer(e->time))
+				e = &arp_table[i];
+	}
+
+	debug("arp_cache: %pI4 is at %pM\n", &ip, ether);
+	e->ip = ip;
+	memcpy(e->ether, ether, 6);
+	e->time = get_timer(0);
+}
+
+/* The host on our network that packets for dest go to */
+static IPaddr_t arp_cache_next_hop(IPaddr_t dest)
+{
+	if ((dest & NetOurSubnetMask) != (NetOurIP & NetOurSubnetMask) &&
+	    NetOurGatewayIP)
+		return NetOurGatewayIP;
+	return dest;
+}
+
+int arp_cache_resolve(IPaddr_t dest, uchar *ether)
+{
+	struct arp_entry *e = arp_cache_find(arp_cache_next_hop(dest));
+
+	if (!e)
+		return 0;
+
+	memcpy(ether, e->ether, 6);
+	return 1;
+}
+
+void arp_cache_prime(void)
+{
+	IPaddr_t server;
+
+	if (!NetOurIP)
+		return;
+
+	server = NetServerIP ? arp_cache_next_hop(NetServerIP) : 0;
+	if (server && !arp_cache_find(server))
+		ArpRequestFor(server);
+	if (NetOurGatewayIP && NetOurGatewayIP != server &&
+	    !arp_cache_find(NetOurGatewayIP))
+		ArpRequestFor(NetOurGatewayIP);
+}
+
+void arp_cache_flush(void)
+{
+	memset(arp_table, 0, sizeof(arp_table));
+}
@@ -0,0 +1,50 @@
+/*
+ * Cache of the ethernet addresses of the hosts we talk to
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __ARP_CACHE_H__
+#define __ARP_CACHE_H__
+
+/* net.c: ask who has ip, on our network */
+void ArpRequestFor(IPaddr_t ip);
+
+#ifdef CONFIG_NET_ARP_CACHE
+/*
+ * An ARP packet from ip, at ether, has been received; add is set when
+ * it was meant for us or announces ip, else only known hosts are
+ * updated.
+ */
+void arp_cache_learn(IPaddr_t ip, const uchar *ether, int add);
+
+/* 1 if the next hop to dest is known, and its address is in ether */
+int arp_cache_resolve(IPaddr_t dest, uchar *ether);
+
+/* Ask for the server and gateway addresses that are not known yet */
+void arp_cache_prime(void);
+
+void arp_cache_flush(void);
+#else
+static inline void arp_cache_learn(IPaddr_t ip, const uchar *ether, int add)
+{
+}
+
+static inline int arp_cache_resolve(IPaddr_t dest, uchar *ether)
+{
+	return 0;
+}
+
+static inline void arp_cache_prime(void)
+{
+}
+
+static inline void arp_cache_flush(void)
+{
+}
+#endif
+
+#endif /* __ARP_CACHE_H__ */
@@ -329,6 +329,27 @@ BootpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 }
 #endif
 
+/*
+ *	How long to wait for an answer to the request just sent.  With
+ *	CONFIG_BOOTP_TIMEOUT_MIN the first retry comes after that many
+ *	milliseconds, and the wait doubles from there up to TIMEOUT.
+ */
+static ulong BootpTimeoutFor(ulong timeout)
+{
+#ifdef CONFIG_BOOTP_TIMEOUT_MIN
+	ulong t = CONFIG_BOOTP_TIMEOUT_MIN;
+	int n;
+
+	for (n = 1; n < BootpTry && t < TIMEOUT; n++)
+		t <<= 1;
+	if (t < TIMEOUT)
+		return t;
+	return TIMEOUT;
+#else
+	return timeout;
+#endif
+}
+
 /*
  *	Timeout on BOOTP/DHCP request.
  */
@@ -379,6 +400,13 @@ static int DhcpExtended (u8 * e, int message_type, IPaddr_t ServerID, IPaddr_t R
 	*e++ = (576 - 312 + OPT_SIZE) >> 8;
 	*e++ = (576 - 312 + OPT_SIZE) & 0xff;
 
+#if defined(CONFIG_BOOTP_RAPID_COMMIT)
+	if (message_type == DHCP_DISCOVER) {
+		*e++ = 80;	/* Rapid Commit, RFC 4039 */
+		*e++ = 0;
+	}
+#endif
+
 	if (ServerID) {
 		int tmp = ntohl (ServerID);
 
@@ -588,6 +616,9 @@ BootpRequest (void)
 	volatile uchar *pkt, *iphdr;
 	Bootp_t *bp;
 	int ext_len, pktlen, iplen;
+#if defined(CONFIG_CMD_DHCP) && defined(CONFIG_BOOTP_INIT_REBOOT)
+	IPaddr_t LeaseIP = BootpTry ? 0 : getenv_IPaddr("dhcpaddr");
+#endif
 
 #if defined(CONFIG_CMD_DHCP)
 	dhcp_state = INIT;
@@ -683,6 +714,13 @@ BootpRequest (void)
 	copy_filename (bp->bp_file, BootFile, sizeof(bp->bp_file));
 
 	/* Request additional information from the BOOTP/DHCP server */
+#if defined(CONFIG_CMD_DHCP) && defined(CONFIG_BOOTP_INIT_REBOOT)
+	/* First ask for the address we had last time, RFC 2131 INIT-REBOOT */
+	if (LeaseIP)
+		ext_len = DhcpExtended((u8 *)bp->bp_vend, DHCP_REQUEST,
+				       0, LeaseIP);
+	else
+#endif
 #if defined(CONFIG_CMD_DHCP)
 	ext_len = DhcpExtended((u8 *)bp->bp_vend, DHCP_DISCOVER, 0, 0);
 #else
@@ -708,10 +746,14 @@ BootpRequest (void)
 	pktlen = ((int)(pkt-NetTxPacket)) + BOOTP_HDR_SIZE - sizeof(bp->bp_vend) + ext_len;
 	iplen = BOOTP_HDR_SIZE - sizeof(bp->bp_vend) + ext_len;
 	NetSetIP(iphdr, 0xFFFFFFFFL, PORT_BOOTPS, PORT_BOOTPC, iplen);
-	NetSetTimeout(SELECT_TIMEOUT, BootpTimeout);
+	NetSetTimeout(BootpTimeoutFor(SELECT_TIMEOUT), BootpTimeout);
 
 #if defined(CONFIG_CMD_DHCP)
 	dhcp_state = SELECTING;
+#if defined(CONFIG_BOOTP_INIT_REBOOT)
+	if (LeaseIP)
+		dhcp_state = REBOOTING;
+#endif
 	NetSetHandler(DhcpHandler);
 #else
 	NetSetHandler(BootpHandler);
@@ -783,6 +825,10 @@ static void DhcpOptionsProcess (uchar * popt, Bootp_t *bp)
 			break;
 		case 66:	/* Ignore TFTP server name */
 			break;
+#if defined(CONFIG_BOOTP_RAPID_COMMIT)
+		case 80:	/* Rapid Commit, in the ACK to our DISCOVER */
+			break;
+#endif
 		case 67:	/* vendor opt bootfile */
 			/*
 			 * I can't use dhcp_vendorex_proc here because I need
@@ -835,6 +881,27 @@ static int DhcpMessageType(unsigned char *popt)
 	return -1;
 }
 
+#if defined(CONFIG_BOOTP_RAPID_COMMIT)
+/* Does the reply carry the Rapid Commit option? */
+static int DhcpRapidCommit(unsigned char *popt)
+{
+	if (NetReadLong((ulong*)popt) != htonl(BOOTP_VENDOR_MAGIC))
+		return 0;
+
+	popt += 4;
+	while ( *popt != 0xff ) {
+		if ( *popt == 80 )	/* Rapid Commit */
+			return 1;
+		if ( *popt == 0 ) {	/* Pad */
+			popt++;
+			continue;
+		}
+		popt += *(popt + 1) + 2;	/* Scan through all options */
+	}
+	return 0;
+}
+#endif
+
 static void DhcpSendRequestPkt(Bootp_t *bp_offer)
 {
 	volatile uchar *pkt, *iphdr;
@@ -893,6 +960,30 @@ static void DhcpSendRequestPkt(Bootp_t *bp_offer)
 	NetSendPacket(NetTxPacket, pktlen);
 }
 
+/*
+ *	The server has acknowledged our address: take it, and go on.
+ */
+static void DhcpBind(Bootp_t *bp)
+{
+#if defined(CONFIG_BOOTP_INIT_REBOOT)
+	char tmp[22];
+#endif
+
+	if (NetReadLong((ulong*)&bp->bp_vend[0]) == htonl(BOOTP_VENDOR_MAGIC))
+		DhcpOptionsProcess((u8 *)&bp->bp_vend[4], bp);
+	BootpCopyNetParams(bp); /* Store net params from reply */
+	dhcp_state = BOUND;
+	printf ("DHCP client bound to address %pI4\n", &NetOurIP);
+
+#if defined(CONFIG_BOOTP_INIT_REBOOT)
+	/* to be asked for again by the next DHCP request */
+	ip_to_string(NetOurIP, tmp);
+	setenv("dhcpaddr", tmp);
+#endif
+
+	net_auto_load();
+}
+
 /*
  *	Handle DHCP received packets.
  */
@@ -912,7 +1003,35 @@ DhcpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		src, dest, len, dhcp_state);
 
 	switch (dhcp_state) {
+#if defined(CONFIG_BOOTP_INIT_REBOOT)
+	case REBOOTING:
+		switch (DhcpMessageType((u8 *)bp->bp_vend)) {
+		case DHCP_ACK:
+			DhcpBind(bp);
+			return;
+		case DHCP_NAK:
+			/* the lease is gone; BootpTry is set, so DISCOVER */
+			debug("DHCP: lease refused\n");
+			BootpRequest();
+			return;
+		}
+		break;
+#endif
 	case SELECTING:
+#if defined(CONFIG_BOOTP_RAPID_COMMIT)
+		/*
+		 * The server has committed a lease at once, RFC 4039; an
+		 * ACK without the option is not meant for SELECTING, wait
+		 * for an OFFER instead
+		 */
+		if (DhcpMessageType((u8 *)bp->bp_vend) == DHCP_ACK) {
+			if (DhcpRapidCommit((u8 *)bp->bp_vend))
+				DhcpBind(bp);
+			else
+				debug("DHCP: ACK without Rapid Commit ignored\n");
+			return;
+		}
+#endif
 		/*
 		 * Wait an appropriate time for any potential DHCPOFFER packets
 		 * to arrive.  Then select one, and generate DHCPREQUEST response.
@@ -932,7 +1051,7 @@ DhcpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			if (NetReadLong((ulong*)&bp->bp_vend[0]) == htonl(BOOTP_VENDOR_MAGIC))
 				DhcpOptionsProcess((u8 *)&bp->bp_vend[4], bp);
 
-			NetSetTimeout(TIMEOUT, BootpTimeout);
+			NetSetTimeout(BootpTimeoutFor(TIMEOUT), BootpTimeout);
 			DhcpSendRequestPkt(bp);
 #ifdef CONFIG_SYS_BOOTFILE_PREFIX
 		}
@@ -944,13 +1063,7 @@ DhcpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		debug("DHCP State: REQUESTING\n");
 
 		if ( DhcpMessageType((u8 *)bp->bp_vend) == DHCP_ACK ) {
-			if (NetReadLong((ulong*)&bp->bp_vend[0]) == htonl(BOOTP_VENDOR_MAGIC))
-				DhcpOptionsProcess((u8 *)&bp->bp_vend[4], bp);
-			BootpCopyNetParams(bp); /* Store net params from reply */
-			dhcp_state = BOUND;
-			printf ("DHCP client bound to address %pI4\n", &NetOurIP);
-
-			net_auto_load();
+			DhcpBind(bp);
 			return;
 		}
 		break;
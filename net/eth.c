@@ -26,6 +26,7 @@
 #include <net.h>
 #include <miiphy.h>
 #include <phy.h>
+#include <time_acct.h>
 
 void eth_parse_enetaddr(const char *addr, uchar *enetaddr)
 {
@@ -244,7 +245,7 @@ int eth_initialize(bd_t *bis)
 	eth_devices = NULL;
 	eth_current = NULL;
 
-	show_boot_progress (64);
+	bootstage_mark(64);
 #if defined(CONFIG_MII) || defined(CONFIG_CMD_MII)
 	miiphy_init();
 #endif
@@ -271,15 +272,19 @@ int eth_initialize(bd_t *bis)
 #endif
 #if defined(CONFIG_DB64460) || defined(CONFIG_P3Mx)
 	mv6446x_eth_initialize(bis);
+#endif
+#ifdef CONFIG_PHYLIB_EARLY_ANEG
+	/* the drivers have registered their MDIO buses */
+	phy_early_aneg();
 #endif
 	if (!eth_devices) {
 		puts ("No ethernet found.\n");
-		show_boot_progress (-64);
+		bootstage_mark(-64);
 	} else {
 		struct eth_device *dev = eth_devices;
 		char *ethprime = getenv ("ethprime");
 
-		show_boot_progress (65);
+		bootstage_mark(65);
 		do {
 			if (eth_number)
 				puts (", ");
@@ -354,6 +359,59 @@ u32 ether_crc (size_t len, unsigned char const *p)
 #endif
 
 
+#ifdef CONFIG_NET_KEEP_LINK
+static void eth_halt_dev(struct eth_device *dev)
+{
+	debug("Halting %s\n", dev->name);
+	dev->halt(dev);
+	dev->state = ETH_STATE_PASSIVE;
+}
+#endif
+
+#ifdef CONFIG_NET_LINK_SELECT
+/*
+ * Moves on from a current device whose PHY has no link to the next one
+ * that has, rather than have the protocol time out on it first.
+ */
+static void eth_select_link(void)
+{
+	struct eth_device *dev;
+	char *ethrotate;
+
+	ethrotate = getenv("ethrotate");
+	if (ethrotate && strcmp(ethrotate, "no") == 0)
+		return;
+
+	if (phy_link_state(eth_current) != 0)
+		return;
+
+	for (dev = eth_current->next; dev != eth_current; dev = dev->next) {
+		if (phy_link_state(dev) > 0) {
+			printf("%s: no link, using %s\n",
+			       eth_current->name, dev->name);
+			eth_current = dev;
+			eth_current_changed();
+			return;
+		}
+	}
+}
+
+/*
+ * The device after dev, passing over the ones without link, which would
+ * only time out again, up to stop or dev itself.
+ */
+static struct eth_device *eth_next_link(struct eth_device *dev,
+					struct eth_device *stop)
+{
+	struct eth_device *next = dev->next;
+
+	while (next != stop && next != dev && phy_link_state(next) == 0)
+		next = next->next;
+
+	return next;
+}
+#endif
+
 int eth_init(bd_t *bis)
 {
 	int eth_number;
@@ -371,13 +429,39 @@ int eth_init(bd_t *bis)
 		uchar env_enetaddr[6];
 
 		if (eth_getenv_enetaddr_by_index("eth", eth_number,
-						 env_enetaddr))
+						 env_enetaddr)) {
+#ifdef CONFIG_NET_KEEP_LINK
+			/* the address is set up by init() */
+			if (dev->state == ETH_STATE_ACTIVE &&
+			    memcmp(dev->enetaddr, env_enetaddr, 6))
+				eth_halt_dev(dev);
+#endif
 			memcpy(dev->enetaddr, env_enetaddr, 6);
+		}
 
 		++eth_number;
 		dev = dev->next;
 	} while (dev != eth_devices);
 
+#ifdef CONFIG_NET_LINK_SELECT
+	eth_select_link();
+#endif
+
+#ifdef CONFIG_NET_KEEP_LINK
+	/* Only one device is up at a time */
+	dev = eth_devices;
+	do {
+		if (dev != eth_current && dev->state == ETH_STATE_ACTIVE)
+			eth_halt_dev(dev);
+		dev = dev->next;
+	} while (dev != eth_devices);
+
+	if (eth_current->state == ETH_STATE_ACTIVE) {
+		debug("Keeping %s\n", eth_current->name);
+		return 0;
+	}
+#endif
+
 	old_current = eth_current;
 	do {
 		debug("Trying %s\n", eth_current->name);
@@ -405,20 +489,57 @@ void eth_halt(void)
 	eth_current->state = ETH_STATE_PASSIVE;
 }
 
+#ifdef CONFIG_NET_KEEP_LINK
+/*
+ * Halt whatever device is still up: the link is kept from one network
+ * command to the next, but nothing may write to memory once an image
+ * has been started.
+ */
+void eth_halt_all(void)
+{
+	struct eth_device *dev = eth_devices;
+
+	if (!dev)
+		return;
+
+	do {
+		if (dev->state == ETH_STATE_ACTIVE)
+			eth_halt_dev(dev);
+		dev = dev->next;
+	} while (dev != eth_devices);
+}
+#endif
+
 int eth_send(volatile void *packet, int length)
 {
+	unsigned long long t;
+	int ret;
+
 	if (!eth_current)
 		return -1;
 
-	return eth_current->send(eth_current, packet, length);
+	t = time_acct_start();
+	ret = eth_current->send(eth_current, packet, length);
+	time_acct_end(TIME_ACCT_NET, t);
+	return ret;
 }
 
 int eth_rx(void)
 {
+	unsigned long long t;
+	int ret;
+
 	if (!eth_current)
 		return -1;
 
-	return eth_current->recv(eth_current);
+	t = time_acct_start();
+	/* Drain everything the ring holds in one go if we can */
+	if (eth_current->recv_batch)
+		ret = eth_current->recv_batch(eth_current, PKTBUFSRX);
+	else
+		ret = eth_current->recv(eth_current);
+	time_acct_end(TIME_ACCT_NET, t);
+	return ret;
 }
 
 #ifdef CONFIG_API
@@ -488,7 +609,11 @@ void eth_try_another(int first_restart)
 		first_failed = eth_current;
 	}
 
+#ifdef CONFIG_NET_LINK_SELECT
+	eth_current = eth_next_link(eth_current, first_failed);
+#else
 	eth_current = eth_current->next;
+#endif
 
 	eth_current_changed();
 
@@ -528,3 +653,12 @@ char *eth_get_name (void)
 {
 	return (eth_current ? eth_current->name : "unknown");
 }
+
+int eth_get_mtu(void)
+{
+	int mtu = 1500;
+
+	if (eth_current && eth_current->max_mtu > mtu)
+		mtu = eth_current->max_mtu;
+	return min(mtu, ETH_MTU_MAX);
+}
@@ -78,6 +78,9 @@
 #include <watchdog.h>
 #include <command.h>
 #include <net.h>
+#include <load_hash.h>
+#include <load_stream.h>
+#include <dma.h>
 #include "bootp.h"
 #include "tftp.h"
 #ifdef CONFIG_CMD_RARP
@@ -97,6 +100,14 @@
 #if defined(CONFIG_CMD_DNS)
 #include "dns.h"
 #endif
+#if defined(CONFIG_CMD_WGET)
+#include "tcp.h"
+#include "wget.h"
+#endif
+#if defined(CONFIG_CMD_AOE)
+#include "aoe.h"
+#endif
+#include "arp_cache.h"
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -244,13 +255,11 @@ uchar		NetArpWaitPacketBuf[PKTSIZE_ALIGN + PKTALIGN];
 ulong		NetArpWaitTimerStart;
 int		NetArpWaitTry;
 
-void ArpRequest(void)
+void ArpRequestFor(IPaddr_t ip)
 {
 	volatile uchar *pkt;
 	ARP_t *arp;
 
-	debug("ARP broadcast %d\n", NetArpWaitTry);
-
 	pkt = NetTxPacket;
 
 	pkt += NetSetEther(pkt, NetBcastAddr, PROT_ARP);
@@ -269,6 +278,14 @@ void ArpRequest(void)
 	NetWriteIP((uchar *) &arp->ar_data[6], NetOurIP);
 	/* dest ET addr = 0 */
 	memset(&arp->ar_data[10], '\0', 6);
+	NetWriteIP((uchar *) &arp->ar_data[16], ip);
+	(void) eth_send(NetTxPacket, (pkt - NetTxPacket) + ARP_HDR_SIZE);
+}
+
+void ArpRequest(void)
+{
+	debug("ARP broadcast %d\n", NetArpWaitTry);
+
 	if ((NetArpWaitPacketIP & NetOurSubnetMask) !=
 	    (NetOurIP & NetOurSubnetMask)) {
 		if (NetOurGatewayIP == 0) {
@@ -281,8 +298,7 @@ void ArpRequest(void)
 		NetArpWaitReplyIP = NetArpWaitPacketIP;
 	}
 
-	NetWriteIP((uchar *) &arp->ar_data[16], NetArpWaitReplyIP);
-	(void) eth_send(NetTxPacket, (pkt - NetTxPacket) + ARP_HDR_SIZE);
+	ArpRequestFor(NetArpWaitReplyIP);
 }
 
 void ArpTimeoutCheck(void)
@@ -317,6 +333,9 @@ void net_auto_load(void)
 {
 	const char *s = getenv("autoload");
 
+	/* we have just been told who the server is */
+	arp_cache_prime();
+
 	if (s != NULL) {
 		if (*s == 'n') {
 			/*
@@ -339,28 +358,45 @@ void net_auto_load(void)
 	TftpStart(TFTPGET);
 }
 
-static void NetInitLoop(enum proto_t protocol)
+static void net_env_ip(struct env_notifier *n, const char *value)
 {
-	static int env_changed_id;
-	bd_t *bd = gd->bd;
-	int env_id = get_env_id();
-
-	/* update only when the environment has changed */
-	if (env_changed_id != env_id) {
-		NetOurIP = getenv_IPaddr("ipaddr");
-		NetCopyIP(&bd->bi_ip_addr, &NetOurIP);
-		NetOurGatewayIP = getenv_IPaddr("gatewayip");
-		NetOurSubnetMask = getenv_IPaddr("netmask");
-		NetServerIP = getenv_IPaddr("serverip");
-		NetOurNativeVLAN = getenv_VLAN("nvlan");
-		NetOurVLAN = getenv_VLAN("vlan");
+	*(IPaddr_t *)n->priv = string_to_ip(value);
+}
+
+static void net_env_ipaddr(struct env_notifier *n, const char *value)
+{
+	net_env_ip(n, value);
+	NetCopyIP(&gd->bd->bi_ip_addr, &NetOurIP);
+}
+
+static void net_env_vlan(struct env_notifier *n, const char *value)
+{
+	*(ushort *)n->priv = string_to_VLAN(value);
+}
+
+/* Kept up to date by the environment code instead of on every NetLoop() */
+static struct env_notifier net_env[] = {
+	{ "ipaddr",	net_env_ipaddr,	&NetOurIP },
+	{ "gatewayip",	net_env_ip,	&NetOurGatewayIP },
+	{ "netmask",	net_env_ip,	&NetOurSubnetMask },
+	{ "serverip",	net_env_ip,	&NetServerIP },
+	{ "nvlan",	net_env_vlan,	&NetOurNativeVLAN },
+	{ "vlan",	net_env_vlan,	&NetOurVLAN },
 #if defined(CONFIG_CMD_DNS)
-		NetOurDNSIP = getenv_IPaddr("dnsip");
+	{ "dnsip",	net_env_ip,	&NetOurDNSIP },
 #endif
-		env_changed_id = env_id;
-	}
+};
 
-	return;
+static void NetInitLoop(enum proto_t protocol)
+{
+	static int registered;
+	int i;
+
+	if (!registered) {
+		for (i = 0; i < ARRAY_SIZE(net_env); i++)
+			env_notifier_register(&net_env[i]);
+		registered = 1;
+	}
 }
 
 /**********************************************************************/
@@ -373,6 +409,10 @@ int NetLoop(enum proto_t protocol)
 	bd_t *bd = gd->bd;
 	int ret = -1;
 
+	/* the console output before the device is taken over */
+	if (protocol != NETCONS)
+		nc_flush();
+
 	NetRestarted = 0;
 	NetDevExists = 0;
 
@@ -402,7 +442,7 @@ int NetLoop(enum proto_t protocol)
 		NetArpWaitTxPacketSize = 0;
 	}
 
-	eth_halt();
+	eth_park();
 	eth_set_current();
 	if (eth_init(bd) < 0) {
 		eth_halt();
@@ -413,6 +453,10 @@ restart:
 	memcpy(NetOurEther, eth_get_dev()->enetaddr, 6);
 
 	NetState = NETLOOP_CONTINUE;
+#if defined(CONFIG_CMD_WGET)
+	/* forget any connection left over from an earlier run */
+	tcp_reset();
+#endif
 
 	/*
 	 *	Start the ball rolling with the given start function.  From
@@ -424,7 +468,7 @@ restart:
 	switch (net_check_prereq(protocol)) {
 	case 1:
 		/* network not configured */
-		eth_halt();
+		eth_park();
 		return -1;
 
 	case 2:
@@ -434,6 +478,10 @@ restart:
 	case 0:
 		NetDevExists = 1;
 		NetBootFileXferSize = 0;
+		/* the address has yet to be found out for these */
+		if (protocol != BOOTP && protocol != DHCP && protocol != RARP &&
+		    protocol != AOE)
+			arp_cache_prime();
 		switch (protocol) {
 		case TFTPGET:
 #ifdef CONFIG_CMD_TFTPPUT
@@ -442,6 +490,11 @@ restart:
 			/* always use ARP to get server ethernet address */
 			TftpStart(protocol);
 			break;
+#ifdef CONFIG_CMD_TFTP_MULTI
+		case TFTPMULTI:
+			TftpMultiStart();
+			break;
+#endif
 #ifdef CONFIG_CMD_TFTPSRV
 		case TFTPSRV:
 			TftpStartServer();
@@ -497,6 +550,16 @@ restart:
 		case DNS:
 			DnsStart();
 			break;
+#endif
+#if defined(CONFIG_CMD_WGET)
+		case WGET:
+			WgetStart();
+			break;
+#endif
+#if defined(CONFIG_CMD_AOE)
+		case AOE:
+			AoeStart();
+			break;
 #endif
 		default:
 			break;
@@ -532,16 +595,24 @@ restart:
 		}
 #endif
 		/*
-		 *	Check the ethernet for a new packet.  The ethernet
-		 *	receive routine will process it.
+		 *	Check the ethernet for new packets.  The ethernet
+		 *	receive routine will process them; drivers providing
+		 *	recv_batch() hand up every frame that is ready before
+		 *	we get to the ctrl-c and timeout checks below.
 		 */
 		eth_rx();
 
+		/*
+		 *	Program what tftpflash has received so far.
+		 */
+		if (load_stream_poll())
+			NetState = NETLOOP_FAIL;
+
 		/*
 		 *	Abort if ctrl-c was pressed.
 		 */
 		if (ctrlc()) {
-			eth_halt();
+			eth_park();
 			puts("\nAbort\n");
 			goto done;
 		}
@@ -583,6 +654,7 @@ restart:
 			goto restart;
 
 		case NETLOOP_SUCCESS:
+			load_hash_finish();
 			if (NetBootFileXferSize > 0) {
 				char buf[20];
 				printf("Bytes transferred = %ld (%lx hex)\n",
@@ -594,7 +666,7 @@ restart:
 				sprintf(buf, "%lX", (unsigned long)load_addr);
 				setenv("fileaddr", buf);
 			}
-			eth_halt();
+			eth_park();
 			ret = NetBootFileXferSize;
 			goto done;
 
@@ -654,6 +726,8 @@ void NetStartAgain(void)
 
 	NetTryCount++;
 
+	/* a host may have moved */
+	arp_cache_flush();
 	eth_halt();
 #if !defined(CONFIG_NET_DO_NOT_TRY_ANOTHER)
 	eth_try_another(!NetRestarted);
@@ -726,7 +800,8 @@ NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
 	 * if MAC address was not discovered yet, save the packet and do
 	 * an ARP request
 	 */
-	if (memcmp(ether, NetEtherNullAddr, 6) == 0) {
+	if (memcmp(ether, NetEtherNullAddr, 6) == 0 &&
+	    !arp_cache_resolve(dest, ether)) {
 
 		debug("sending ARP for %08x\n", dest);
 
@@ -736,9 +811,9 @@ NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
 		pkt = NetArpWaitTxPacket;
 		pkt += NetSetEther(pkt, NetArpWaitPacketMAC, PROT_IP);
 
-		NetSetIP(pkt, dest, dport, sport, len);
 		memcpy(pkt + IP_HDR_SIZE, (uchar *)NetTxPacket +
 		       (pkt - (uchar *)NetArpWaitTxPacket) + IP_HDR_SIZE, len);
+		NetSetIP(pkt, dest, dport, sport, len);
 
 		/* size of the waiting packet */
 		NetArpWaitTxPacketSize = (pkt - NetArpWaitTxPacket) +
@@ -761,6 +836,54 @@ NetSendUDPPacket(uchar *ether, IPaddr_t dest, int dport, int sport, int len)
 	return 0;	/* transmitted */
 }
 
+#if defined(CONFIG_CMD_WGET)
+int net_send_ip_packet(uchar *ether, IPaddr_t dest, int proto, int len)
+{
+	uchar *pkt;
+
+	/*
+	 * if MAC address was not discovered yet, save the packet and do
+	 * an ARP request
+	 */
+	if (memcmp(ether, NetEtherNullAddr, 6) == 0 &&
+	    !arp_cache_resolve(dest, ether)) {
+
+		debug("sending ARP for %08x\n", dest);
+
+		NetArpWaitPacketIP = dest;
+		NetArpWaitPacketMAC = ether;
+
+		pkt = NetArpWaitTxPacket;
+		pkt += NetSetEther(pkt, NetArpWaitPacketMAC, PROT_IP);
+
+		net_set_ip_header(pkt, dest, proto, len);
+		memcpy(pkt + IP_HDR_SIZE_NO_UDP, (uchar *)NetTxPacket +
+		       (pkt - (uchar *)NetArpWaitTxPacket) +
+		       IP_HDR_SIZE_NO_UDP, len);
+
+		/* size of the waiting packet */
+		NetArpWaitTxPacketSize = (pkt - NetArpWaitTxPacket) +
+			IP_HDR_SIZE_NO_UDP + len;
+
+		/* and do the ARP request */
+		NetArpWaitTry = 1;
+		NetArpWaitTimerStart = get_timer(0);
+		ArpRequest();
+		return 1;	/* waiting */
+	}
+
+	debug("sending IP proto %d to %08x/%pM\n", proto, dest, ether);
+
+	pkt = (uchar *)NetTxPacket;
+	pkt += NetSetEther(pkt, ether, PROT_IP);
+	net_set_ip_header(pkt, dest, proto, len);
+	(void) eth_send(NetTxPacket,
+			(pkt - NetTxPacket) + IP_HDR_SIZE_NO_UDP + len);
+
+	return 0;	/* transmitted */
+}
+#endif
+
 #if defined(CONFIG_CMD_PING)
 static ushort PingSeqNo;
 
@@ -825,7 +948,7 @@ int PingSend(void)
 static void
 PingTimeout(void)
 {
-	eth_halt();
+	eth_park();
 	NetState = NETLOOP_FAIL;	/* we did not get the reply */
 }
 
@@ -1205,13 +1328,19 @@ static void CDPStart(void)
 
 #ifdef CONFIG_IP_DEFRAG
 /*
- * This function collects fragments in a single packet, according
- * to the algorithm in RFC815. It returns NULL or the pointer to
- * a complete packet, in static storage
+ * This function collects fragments in a packet, keeping track of the
+ * 8-byte blocks that have arrived in a bitmap.  Several datagrams may
+ * be reassembled at a time, as with pipelined NFS reads; a fragment
+ * of a new datagram takes a free buffer, or that of the datagram
+ * started longest ago.  It returns NULL or the pointer to a complete
+ * packet, in static storage
  */
 #ifndef CONFIG_NET_MAXDEFRAG
 #define CONFIG_NET_MAXDEFRAG 16384
 #endif
+#ifndef CONFIG_NET_DEFRAG_SLOTS
+#define CONFIG_NET_DEFRAG_SLOTS 2
+#endif
 /*
  * MAXDEFRAG, above, is chosen in the config file and  is real data
  * so we need to add the NFS overhead, which is more than TFTP.
@@ -1224,135 +1353,120 @@ static struct rpc_t rpc_specimen;
 
 #define IP_MAXUDP (IP_PKTSIZE - IP_HDR_SIZE_NO_UDP)
 
-/*
- * this is the packet being assembled, either data or frag control.
- * Fragments go by 8 bytes, so this union must be 8 bytes long
- */
-struct hole {
-	/* first_byte is address of this structure */
-	u16 last_byte;	/* last byte in this hole + 1 (begin of next hole) */
-	u16 next_hole;	/* index of next (in 8-b blocks), 0 == none */
-	u16 prev_hole;	/* index of prev, 0 == none */
-	u16 unused;
+/* one bit for every 8 bytes of payload */
+#define IP_DEFRAG_BLOCKS	((IP_MAXUDP + 7) / 8)
+#define IP_DEFRAG_WORDS		((IP_DEFRAG_BLOCKS + 31) / 32)
+
+struct defrag_slot {
+	uchar	pkt_buff[IP_PKTSIZE] __attribute__((aligned(PKTALIGN)));
+	u32	map[IP_DEFRAG_WORDS];	/* blocks that have arrived */
+	int	blocks;			/* how many of them */
+	int	total_len;		/* payload size, -1 until known */
+	int	busy;
+	ulong	start;			/* get_timer() at the first fragment */
 };
 
+static struct defrag_slot defrag_slots[CONFIG_NET_DEFRAG_SLOTS];
+
+static struct defrag_slot *defrag_slot_get(IP_t *ip)
+{
+	struct defrag_slot *s, *old = &defrag_slots[0];
+	IP_t *localip;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_DEFRAG_SLOTS; i++) {
+		s = &defrag_slots[i];
+		localip = (IP_t *)s->pkt_buff;
+		if (s->busy && localip->ip_id == ip->ip_id &&
+		    localip->ip_p == ip->ip_p &&
+		    NetReadIP(&localip->ip_src) == NetReadIP(&ip->ip_src))
+			return s;
+		if (!old->busy)
+			continue;
+		if (!s->busy || get_timer(s->start) > get_timer(old->start))
+			old = s;
+	}
+
+	/* new packet, reset structs */
+	s = old;
+	memset(s->map, 0, sizeof(s->map));
+	s->blocks = 0;
+	s->total_len = -1;
+	s->busy = 1;
+	s->start = get_timer(0);
+	/* any IP header will work, copy the first we received */
+	memcpy(s->pkt_buff, ip, IP_HDR_SIZE_NO_UDP);
+	return s;
+}
+
+/* Mark blocks [first, first + n) as arrived, return how many were new */
+static int defrag_mark(u32 *map, int first, int n)
+{
+	int added = 0;
+	u32 bit;
+
+	while (n > 0) {
+		if (!(first & 31) && n >= 32) {
+			/* a whole word at once */
+			added += 32 - generic_hweight32(map[first / 32]);
+			map[first / 32] = ~0;
+			first += 32;
+			n -= 32;
+			continue;
+		}
+		bit = 1 << (first & 31);
+		if (!(map[first / 32] & bit)) {
+			map[first / 32] |= bit;
+			added++;
+		}
+		first++;
+		n--;
+	}
+	return added;
+}
+
 static IP_t *__NetDefragment(IP_t *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __attribute__((aligned(PKTALIGN)));
-	static u16 first_hole, total_len;
-	struct hole *payload, *thisfrag, *h, *newh;
-	IP_t *localip = (IP_t *)pkt_buff;
+	struct defrag_slot *s;
+	IP_t *localip;
 	uchar *indata = (uchar *)ip;
-	int offset8, start, len, done = 0;
+	int offset8, start, len;
 	u16 ip_off = ntohs(ip->ip_off);
 
-	/* payload starts after IP header, this fragment is in there */
-	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE_NO_UDP);
 	offset8 =  (ip_off & IP_OFFS);
-	thisfrag = payload + offset8;
 	start = offset8 * 8;
 	len = ntohs(ip->ip_len) - IP_HDR_SIZE_NO_UDP;
 
-	if (start + len > IP_MAXUDP) /* fragment extends too far */
+	if (len <= 0 || start + len > IP_MAXUDP) /* fragment extends too far */
+		return NULL;
+	/* only the last fragment may end in the middle of a block */
+	if ((ip_off & IP_FLAGS_MFRAG) && (len & 7))
 		return NULL;
 
-	if (!total_len || localip->ip_id != ip->ip_id) {
-		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
-		payload[0].last_byte = ~0;
-		payload[0].next_hole = 0;
-		payload[0].prev_hole = 0;
-		first_hole = 0;
-		/* any IP header will work, copy the first we received */
-		memcpy(localip, ip, IP_HDR_SIZE_NO_UDP);
-	}
-
-	/*
-	 * What follows is the reassembly algorithm. We use the payload
-	 * array as a linked list of hole descriptors, as each hole starts
-	 * at a multiple of 8 bytes. However, last byte can be whatever value,
-	 * so it is represented as byte count, not as 8-byte blocks.
-	 */
+	s = defrag_slot_get(ip);
+	localip = (IP_t *)s->pkt_buff;
 
-	h = payload + first_hole;
-	while (h->last_byte < start) {
-		if (!h->next_hole) {
-			/* no hole that far away */
+	if (!(ip_off & IP_FLAGS_MFRAG)) {
+		/* no more fragments: now we know the size */
+		if (s->total_len >= 0 && s->total_len != start + len)
 			return NULL;
-		}
-		h = payload + h->next_hole;
-	}
-
-	/* last fragment may be 1..7 bytes, the "+7" forces acceptance */
-	if (offset8 + ((len + 7) / 8) <= h - payload) {
-		/* no overlap with holes (dup fragment?) */
+		s->total_len = start + len;
+	} else if (s->total_len >= 0 && start + len > s->total_len) {
 		return NULL;
 	}
 
-	if (!(ip_off & IP_FLAGS_MFRAG)) {
-		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
-		h->last_byte = start + len;
-	}
-
-	/*
-	 * There is some overlap: fix the hole list. This code doesn't
-	 * deal with a fragment that overlaps with two different holes
-	 * (thus being a superset of a previously-received fragment).
-	 */
-
-	if ((h >= thisfrag) && (h->last_byte <= start + len)) {
-		/* complete overlap with hole: remove hole */
-		if (!h->prev_hole && !h->next_hole) {
-			/* last remaining hole */
-			done = 1;
-		} else if (!h->prev_hole) {
-			/* first hole */
-			first_hole = h->next_hole;
-			payload[h->next_hole].prev_hole = 0;
-		} else if (!h->next_hole) {
-			/* last hole */
-			payload[h->prev_hole].next_hole = 0;
-		} else {
-			/* in the middle of the list */
-			payload[h->next_hole].prev_hole = h->prev_hole;
-			payload[h->prev_hole].next_hole = h->next_hole;
-		}
-
-	} else if (h->last_byte <= start + len) {
-		/* overlaps with final part of the hole: shorten this hole */
-		h->last_byte = start;
-
-	} else if (h >= thisfrag) {
-		/* overlaps with initial part of the hole: move this hole */
-		newh = thisfrag + (len / 8);
-		*newh = *h;
-		h = newh;
-		if (h->next_hole)
-			payload[h->next_hole].prev_hole = (h - payload);
-		if (h->prev_hole)
-			payload[h->prev_hole].next_hole = (h - payload);
-		else
-			first_hole = (h - payload);
-
-	} else {
-		/* fragment sits in the middle: split the hole */
-		newh = thisfrag + (len / 8);
-		*newh = *h;
-		h->last_byte = start;
-		h->next_hole = (newh - payload);
-		newh->prev_hole = (h - payload);
-		if (newh->next_hole)
-			payload[newh->next_hole].prev_hole = (newh - payload);
-	}
-
 	/* finally copy this fragment and possibly return whole packet */
-	memcpy((uchar *)thisfrag, indata + IP_HDR_SIZE_NO_UDP, len);
-	if (!done)
+	memcpy(s->pkt_buff + IP_HDR_SIZE_NO_UDP + start,
+	       indata + IP_HDR_SIZE_NO_UDP, len);
+	s->blocks += defrag_mark(s->map, offset8, (len + 7) / 8);
+
+	if (s->total_len < 0 || s->blocks != (s->total_len + 7) / 8)
 		return NULL;
 
-	localip->ip_len = htons(total_len);
-	*lenp = total_len + IP_HDR_SIZE_NO_UDP;
+	/* done: the buffer is not touched before the next fragment */
+	s->busy = 0;
+	localip->ip_len = htons(s->total_len);
+	*lenp = s->total_len + IP_HDR_SIZE_NO_UDP;
 	return localip;
 }
 
@@ -1437,6 +1551,14 @@ static void receive_icmp(IP_t *ip, int len, IPaddr_t src_ip, Ethernet_t *et)
 	}
 }
 
+static void __net_store_payload(ulong dst, const void *src, unsigned len)
+{
+	if (dma_memcpy((void *)dst, src, len))
+		memcpy((void *)dst, src, len);
+}
+void net_store_payload(ulong dst, const void *src, unsigned len)
+	__attribute__((weak, alias("__net_store_payload")));
+
 void
 NetReceive(volatile uchar *inpkt, int len)
 {
@@ -1571,6 +1693,12 @@ NetReceive(volatile uchar *inpkt, int len)
 		if (NetOurIP == 0)
 			return;
 
+		/* a host that asks for us or announces itself is known */
+		tmp = NetReadIP(&arp->ar_data[6]);
+		arp_cache_learn(tmp, &arp->ar_data[0],
+				NetReadIP(&arp->ar_data[16]) == NetOurIP ||
+				NetReadIP(&arp->ar_data[16]) == tmp);
+
 		if (NetReadIP(&arp->ar_data[16]) != NetOurIP)
 			return;
 
@@ -1636,6 +1764,11 @@ NetReceive(volatile uchar *inpkt, int len)
 		}
 		break;
 
+#ifdef CONFIG_CMD_AOE
+	case PROT_AOE:
+		AoeReceive(et, (uchar *)ip, len);
+		break;
+#endif
 #ifdef CONFIG_CMD_RARP
 	case PROT_RARP:
 		debug("Got RARP\n");
@@ -1683,7 +1816,8 @@ NetReceive(volatile uchar *inpkt, int len)
 		if ((ip->ip_hl_v & 0x0f) > 0x05)
 			return;
 		/* Check the Checksum of the header */
-		if (!NetCksumOk((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2)) {
+		if (!net_csum_offload(ETH_CSUM_RX) &&
+		    !NetCksumOk((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2)) {
 			puts("checksum bad\n");
 			return;
 		}
@@ -1729,46 +1863,28 @@ NetReceive(volatile uchar *inpkt, int len)
 		if (ip->ip_p == IPPROTO_ICMP) {
 			receive_icmp(ip, len, src_ip, et);
 			return;
+#if defined(CONFIG_CMD_WGET)
+		} else if (ip->ip_p == IPPROTO_TCP) {
+			tcp_receive(ip, len, src_ip);
+			return;
+#endif
 		} else if (ip->ip_p != IPPROTO_UDP) {	/* Only UDP packets */
 			return;
 		}
 
 #ifdef CONFIG_UDP_CHECKSUM
-		if (ip->udp_xsum != 0) {
-			ulong   xsum;
-			ushort *sumptr;
-			ushort  sumlen;
-
-			xsum  = ip->ip_p;
-			xsum += (ntohs(ip->udp_len));
-			xsum += (ntohl(ip->ip_src) >> 16) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_src) >>  0) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_dst) >> 16) & 0x0000ffff;
-			xsum += (ntohl(ip->ip_dst) >>  0) & 0x0000ffff;
-
-			sumlen = ntohs(ip->udp_len);
-			sumptr = (ushort *) &(ip->udp_src);
-
-			while (sumlen > 1) {
-				ushort sumdata;
-
-				sumdata = *sumptr++;
-				xsum += ntohs(sumdata);
-				sumlen -= 2;
-			}
-			if (sumlen > 0) {
-				ushort sumdata;
+		if (ip->udp_xsum != 0 && !net_csum_offload(ETH_CSUM_RX)) {
+			ushort	xsum;
 
-				sumdata = *(unsigned char *) sumptr;
-				sumdata = (sumdata << 8) & 0xff00;
-				xsum += sumdata;
-			}
-			while ((xsum >> 16) != 0) {
-				xsum = (xsum & 0x0000ffff) +
-				       ((xsum >> 16) & 0x0000ffff);
-			}
-			if ((xsum != 0x00000000) && (xsum != 0x0000ffff)) {
-				printf(" UDP wrong checksum %08lx %08x\n",
+			if (ntohs(ip->udp_len) > len - IP_HDR_SIZE_NO_UDP)
+				return;
+			xsum = net_pseudo_cksum(NetReadIP(&ip->ip_src),
+						NetReadIP(&ip->ip_dst),
+						IPPROTO_UDP,
+						(uchar *)&ip->udp_src,
+						ntohs(ip->udp_len));
+			if (xsum != 0xffff) {
+				printf(" UDP wrong checksum %04x %04x\n",
 					xsum, ntohs(ip->udp_xsum));
 				return;
 			}
@@ -1827,6 +1943,12 @@ static int net_check_prereq(enum proto_t protocol)
 #endif
 #if defined(CONFIG_CMD_NFS)
 	case NFS:
+#endif
+#if defined(CONFIG_CMD_WGET)
+	case WGET:
+#endif
+#if defined(CONFIG_CMD_TFTP_MULTI)
+	case TFTPMULTI:
 #endif
 	case TFTPGET:
 	case TFTPPUT:
@@ -1854,6 +1976,7 @@ common:
 	case BOOTP:
 	case CDP:
 	case DHCP:
+	case AOE:
 		if (memcmp(NetOurEther, "\0\0\0\0\0\0", 6) == 0) {
 			extern int eth_get_dev_index(void);
 			int num = eth_get_dev_index();
@@ -1888,20 +2011,73 @@ NetCksumOk(uchar *ptr, int len)
 	return !((NetCksum(ptr, len) + 1) & 0xfffe);
 }
 
-
+/*
+ * One's complement sum of len 16-bit words, taken 32 bits at a time:
+ * the carries pile up in the upper half and are folded in at the end.
+ * Architectures with a faster way provide their own NetCksum().
+ */
 unsigned
-NetCksum(uchar *ptr, int len)
+__NetCksum(uchar *ptr, int len)
 {
-	ulong	xsum;
+	u64	xsum = 0;
 	ushort *p = (ushort *)ptr;
+	u32	*q;
 
-	xsum = 0;
-	while (len-- > 0)
+	if (len > 0 && ((ulong)p & 2)) {
 		xsum += *p++;
+		len--;
+	}
+	q = (u32 *)p;
+	while (len >= 8) {
+		xsum += q[0];
+		xsum += q[1];
+		xsum += q[2];
+		xsum += q[3];
+		q += 4;
+		len -= 8;
+	}
+	while (len >= 2) {
+		xsum += *q++;
+		len -= 2;
+	}
+	if (len > 0)
+		xsum += *(ushort *)q;
+
+	xsum = (xsum & 0xffffffff) + (xsum >> 32);
+	xsum = (xsum & 0xffffffff) + (xsum >> 32);
 	xsum = (xsum & 0xffff) + (xsum >> 16);
 	xsum = (xsum & 0xffff) + (xsum >> 16);
 	return xsum & 0xffff;
 }
+unsigned NetCksum(uchar *ptr, int len)
+	__attribute__((weak, alias("__NetCksum")));
+
+uint net_pseudo_cksum(IPaddr_t src, IPaddr_t dst, int proto,
+		      uchar *seg, unsigned len)
+{
+	ulong	xsum;
+	ushort	odd = 0;
+
+	/* pseudo header; the addresses are already in network order */
+	xsum = NetCksum((uchar *)&src, 2) + NetCksum((uchar *)&dst, 2);
+	xsum += htons(proto) + htons(len);
+
+	xsum += NetCksum(seg, len / 2);
+	if (len & 1) {
+		*(uchar *)&odd = seg[len - 1];
+		xsum += odd;
+	}
+	xsum = (xsum & 0xffff) + (xsum >> 16);
+	xsum = (xsum & 0xffff) + (xsum >> 16);
+	return xsum & 0xffff;
+}
+
+int net_csum_offload(int flags)
+{
+	struct eth_device *dev = eth_get_dev();
+
+	return dev && (dev->csum_offload & flags) == flags;
+}
 
 int
 NetEthHdrSize(void)
@@ -1941,6 +2117,27 @@ NetSetEther(volatile uchar *xet, uchar * addr, uint prot)
 	}
 }
 
+void net_set_ip_header(volatile uchar *xip, IPaddr_t dest, int proto, int len)
+{
+	IP_t *ip = (IP_t *)xip;
+
+	/* IP_HDR_SIZE_NO_UDP / 4 */
+	ip->ip_hl_v  = 0x45;
+	ip->ip_tos   = 0;
+	ip->ip_len   = htons(IP_HDR_SIZE_NO_UDP + len);
+	ip->ip_id    = htons(NetIPID++);
+	ip->ip_off   = htons(IP_FLAGS_DFRAG);	/* Don't fragment */
+	ip->ip_ttl   = 255;
+	ip->ip_p     = proto;
+	ip->ip_sum   = 0;
+	/* already in network byte order */
+	NetCopyIP((void *)&ip->ip_src, &NetOurIP);
+	/* - "" - */
+	NetCopyIP((void *)&ip->ip_dst, &dest);
+	if (!net_csum_offload(ETH_CSUM_TX))
+		ip->ip_sum = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
+}
+
 void
 NetSetIP(volatile uchar *xip, IPaddr_t dest, int dport, int sport, int len)
 {
@@ -1975,7 +2172,16 @@ NetSetIP(volatile uchar *xip, IPaddr_t dest, int dport, int sport, int len)
 	ip->udp_dst  = htons(dport);
 	ip->udp_len  = htons(8 + len);
 	ip->udp_xsum = 0;
+	if (net_csum_offload(ETH_CSUM_TX))
+		return;
 	ip->ip_sum   = ~NetCksum((uchar *)ip, IP_HDR_SIZE_NO_UDP / 2);
+#ifdef CONFIG_UDP_CHECKSUM
+	/* the payload is in place by now; 0 would mean no checksum */
+	ip->udp_xsum = ~net_pseudo_cksum(NetOurIP, dest, IPPROTO_UDP,
+					 (uchar *)&ip->udp_src, 8 + len);
+	if (!ip->udp_xsum)
+		ip->udp_xsum = 0xffff;
+#endif
 }
 
 void copy_filename(char *dst, const char *src, int size)
@@ -1992,7 +2198,8 @@ void copy_filename(char *dst, const char *src, int size)
 
 #if	defined(CONFIG_CMD_NFS)		|| \
 	defined(CONFIG_CMD_SNTP)	|| \
-	defined(CONFIG_CMD_DNS)
+	defined(CONFIG_CMD_DNS)		|| \
+	defined(CONFIG_CMD_WGET)
 /*
  * make port a little random (1024-17407)
  * This keeps the math somewhat trivial to compute, and seems to work with
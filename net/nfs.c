@@ -26,6 +26,7 @@
 #include <command.h>
 #include <net.h>
 #include <malloc.h>
+#include <load_hash.h>
 #include "nfs.h"
 #include "bootp.h"
 
@@ -61,6 +62,43 @@ static char *nfs_filename;
 static char *nfs_path;
 static char nfs_path_buff[2048];
 
+/*
+ * READ pipelining: up to nfs_read_pipeline requests are kept in flight,
+ * each one identified by the RPC transaction id (xid) it was sent with.
+ * Replies may come back in any order; their data is placed by offset.
+ * The first READ is always sent alone so that a symlink or directory
+ * is detected before the pipeline is filled.
+ */
+#define NFS_READ_PIPELINE_MAX	16
+#ifdef CONFIG_NFS_READ_PIPELINE
+#define NFS_READ_PIPELINE	CONFIG_NFS_READ_PIPELINE
+#else
+#define NFS_READ_PIPELINE	1
+#endif
+
+/* NFSv2 limits reads to 8k; beyond one frame we need IP reassembly */
+#ifdef CONFIG_IP_DEFRAG
+#if defined(CONFIG_NET_MAXDEFRAG) && (CONFIG_NET_MAXDEFRAG < 8192)
+#define NFS_READ_SIZE_MAX	CONFIG_NET_MAXDEFRAG
+#else
+#define NFS_READ_SIZE_MAX	8192
+#endif
+#else
+#define NFS_READ_SIZE_MAX	NFS_READ_SIZE
+#endif
+
+/* returned by nfs_read_reply() for replies we are not waiting for */
+#define NFS_READ_STALE		(-10000)
+
+struct nfs_read_slot {
+	unsigned long xid;	/* 0 if the slot is free */
+	int offset;
+};
+
+static struct nfs_read_slot nfs_reads[NFS_READ_PIPELINE_MAX];
+static int nfs_read_pipeline = NFS_READ_PIPELINE;
+static int nfs_eof;		/* file size once known, else -1 */
+
 static __inline__ int
 store_block (uchar * src, unsigned offset, unsigned len)
 {
@@ -85,7 +123,8 @@ store_block (uchar * src, unsigned offset, unsigned len)
 	} else
 #endif /* CONFIG_SYS_DIRECT_FLASH_NFS */
 	{
-		(void)memcpy ((void *)(load_addr + offset), src, len);
+		net_store_payload(load_addr + offset, src, len);
+		load_hash_update(load_addr + offset, src, len);
 	}
 
 	if (NetBootFileXferSize < (offset+len))
@@ -93,6 +132,14 @@ store_block (uchar * src, unsigned offset, unsigned len)
 	return 0;
 }
 
+static unsigned long rpc_xid(uchar *pkt)
+{
+	uint32_t xid;
+
+	memcpy(&xid, pkt, sizeof(xid));
+	return ntohl(xid);
+}
+
 static char*
 basename (char *path)
 {
@@ -346,6 +393,64 @@ nfs_read_req (int offset, int readlen)
 	rpc_req (PROG_NFS, NFS_READ, data, len);
 }
 
+/* Send a READ for the given slot, under a fresh xid */
+static void
+nfs_read_slot_req (struct nfs_read_slot *slot)
+{
+	nfs_read_req (slot->offset, nfs_len);
+	slot->xid = rpc_id;
+}
+
+/* Start reading the file: send the first READ on its own */
+static void
+nfs_read_start (void)
+{
+	memset (nfs_reads, 0, sizeof(nfs_reads));
+	nfs_eof = -1;
+	nfs_reads[0].offset = 0;
+	nfs_offset = nfs_len;
+	nfs_read_slot_req (&nfs_reads[0]);
+}
+
+/* Re-send all outstanding READs, e.g. after a timeout */
+static void
+nfs_read_resend (void)
+{
+	int i;
+
+	for (i = 0; i < nfs_read_pipeline; i++)
+		if (nfs_reads[i].xid)
+			nfs_read_slot_req (&nfs_reads[i]);
+}
+
+/*
+ * Fill free slots with READs for the following blocks.  Returns 1 once
+ * every byte up to the end of the file has arrived.
+ */
+static int
+nfs_read_next (void)
+{
+	int i, busy = 0;
+
+	for (i = 0; i < nfs_read_pipeline; i++) {
+		struct nfs_read_slot *slot = &nfs_reads[i];
+
+		if (slot->xid && nfs_eof >= 0 && slot->offset >= nfs_eof)
+			slot->xid = 0;	/* beyond the end, forget it */
+
+		if (!slot->xid && nfs_eof < 0) {
+			slot->offset = nfs_offset;
+			nfs_offset += nfs_len;
+			nfs_read_slot_req (slot);
+		}
+
+		if (slot->xid)
+			busy++;
+	}
+
+	return !busy;
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -372,7 +477,7 @@ NfsSend (void)
 		nfs_lookup_req (nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req (nfs_offset, nfs_len);
+		nfs_read_resend ();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req ();
@@ -526,14 +631,23 @@ static int
 nfs_read_reply (uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot = NULL;
+	unsigned long xid;
+	int i, rlen, offset;
 
 	debug("%s\n", __func__);
 
 	memcpy ((uchar *)&rpc_pkt, pkt, sizeof(rpc_pkt.u.reply));
 
-	if (ntohl(rpc_pkt.u.reply.id) != rpc_id)
-		return -1;
+	xid = ntohl(rpc_pkt.u.reply.id);
+	for (i = 0; i < nfs_read_pipeline; i++) {
+		if (nfs_reads[i].xid == xid) {
+			slot = &nfs_reads[i];
+			break;
+		}
+	}
+	if (!slot)
+		return NFS_READ_STALE;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -548,16 +662,25 @@ nfs_read_reply (uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);;
 	}
 
-	if ((nfs_offset!=0) && !((nfs_offset) % (NFS_READ_SIZE/2*10*HASHES_PER_LINE))) {
+	offset = slot->offset;
+	slot->xid = 0;
+
+	if ((offset!=0) && !((offset) % (nfs_len/2*10*HASHES_PER_LINE))) {
 		puts ("\n\t ");
 	}
-	if (!(nfs_offset % ((NFS_READ_SIZE/2)*10))) {
+	if (!(offset % ((nfs_len/2)*10))) {
 		putc ('#');
 	}
 
 	rlen = ntohl(rpc_pkt.u.reply.data[18]);
-	if ( store_block ((uchar *)pkt+sizeof(rpc_pkt.u.reply), nfs_offset, rlen) )
+	if (rlen > nfs_len)
 		return -9999;
+	if ( store_block ((uchar *)pkt+sizeof(rpc_pkt.u.reply), offset, rlen) )
+		return -9999;
+
+	/* a short read marks the end of the file */
+	if (rlen < nfs_len && (nfs_eof < 0 || offset + rlen < nfs_eof))
+		nfs_eof = offset + rlen;
 
 	return rlen;
 }
@@ -588,6 +711,16 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 
 	if (dest != NfsOurPort) return;
 
+	/*
+	 * Drop late replies to requests we are not waiting for any more,
+	 * e.g. READs that were still in flight when the file ended.
+	 * Pipelined READs are matched by nfs_read_reply() itself.
+	 */
+	if (len < sizeof(uint32_t))
+		return;
+	if (NfsState != STATE_READ_REQ && rpc_xid(pkt) != rpc_id)
+		return;
+
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
 		rpc_lookup_reply (PROG_MOUNT, pkt, len);
@@ -630,9 +763,7 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 			NfsSend ();
 		} else {
 			NfsState = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			NfsSend ();
+			nfs_read_start ();
 		}
 		break;
 
@@ -653,17 +784,21 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 
 	case STATE_READ_REQ:
 		rlen = nfs_read_reply (pkt, len);
+		if (rlen == NFS_READ_STALE)
+			break;
 		NetSetTimeout (NFS_TIMEOUT, NfsTimeout);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			NfsSend ();
+		if (rlen >= 0) {
+			if (nfs_read_next ()) {
+				NfsDownloadState = NETLOOP_SUCCESS;
+				NfsState = STATE_UMOUNT_REQ;
+				NfsSend ();
+			}
 		}
 		else if ((rlen == -NFSERR_ISDIR)||(rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			NfsState = STATE_READLINK_REQ;
 			NfsSend ();
 		} else {
-			if ( ! rlen ) NfsDownloadState = NETLOOP_SUCCESS;
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend ();
 		}
@@ -675,8 +810,34 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 void
 NfsStart (void)
 {
+	char *ep;
+
 	debug("%s\n", __func__);
 	NfsDownloadState = NETLOOP_FAIL;
+	load_hash_start(load_addr);
+
+	/* Allow the user to choose the READ size and pipeline depth */
+	nfs_len = NFS_READ_SIZE;
+	ep = getenv("nfsreadsize");
+	if (ep != NULL)
+		nfs_len = simple_strtol(ep, NULL, 10);
+	if (nfs_len > NFS_READ_SIZE_MAX)
+		nfs_len = NFS_READ_SIZE_MAX;
+	if (nfs_len < 512)
+		nfs_len = NFS_READ_SIZE;
+	nfs_len &= ~7;	/* keep the hash mark arithmetic simple */
+
+	nfs_read_pipeline = NFS_READ_PIPELINE;
+	ep = getenv("nfspipeline");
+	if (ep != NULL)
+		nfs_read_pipeline = simple_strtol(ep, NULL, 10);
+	if (nfs_read_pipeline < 1)
+		nfs_read_pipeline = 1;
+	if (nfs_read_pipeline > NFS_READ_PIPELINE_MAX)
+		nfs_read_pipeline = NFS_READ_PIPELINE_MAX;
+
+	debug("NFS read size = %d, pipeline = %d\n", nfs_len,
+	      nfs_read_pipeline);
 
 	NfsServerIP = NetServerIP;
 	nfs_path = (char *)nfs_path_buff;
@@ -0,0 +1,421 @@
+/*
+ * Minimal TCP client for U-Boot
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Only what is needed to pull a file from a server is implemented: a
+ * single active connection, in-order reception with a sliding receive
+ * window, delayed ACKs and retransmission of our own SYN, request and
+ * FIN.  Out-of-order segments are dropped and answered with a duplicate
+ * ACK so that the peer's fast retransmit fills the hole quickly.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <net.h>
+#include <asm/unaligned.h>
+#include "tcp.h"
+
+/* Largest segment we accept (Ethernet MTU minus IP and TCP headers) */
+#define TCP_MSS		1460
+/* Receive window we advertise (bytes) */
+#ifndef CONFIG_TCP_WINDOW
+# define CONFIG_TCP_WINDOW	65535
+#endif
+/* Millisecs between timer ticks */
+#define TCP_TICK	100UL
+/* Ticks without progress before retransmitting */
+#define TCP_RTO_TICKS	10
+/* Send an ACK at least every this many full-sized segments */
+#define TCP_ACK_EVERY	2
+#ifndef	CONFIG_NET_RETRY_COUNT
+# define TCP_RETRIES	10
+#else
+# define TCP_RETRIES	(CONFIG_NET_RETRY_COUNT * 2)
+#endif
+
+enum {
+	TCP_CLOSED,
+	TCP_SYN_SENT,
+	TCP_ESTABLISHED,
+	TCP_FIN_WAIT,		/* we closed first			*/
+	TCP_LAST_ACK,		/* peer closed first, our FIN is out	*/
+};
+
+static int	TcpState;
+static IPaddr_t	TcpRemoteIP;
+static int	TcpRemotePort;
+static int	TcpOurPort;
+static uchar	TcpRemoteEther[6];
+
+static uint	TcpSndUna;	/* oldest unacknowledged sequence number */
+static uint	TcpSndNxt;	/* next sequence number to send		 */
+static uint	TcpRcvNxt;	/* next sequence number expected	 */
+static int	TcpWinShift;	/* our window scale, 0 if not agreed	 */
+
+/* The single segment we may have to retransmit */
+static uchar	TcpTxBuf[TCP_MSS];
+static unsigned	TcpTxLen;
+static uint	TcpTxSeq;
+static uchar	TcpTxFlags;
+
+static int	TcpAckPending;	/* segments received but not yet ACKed	 */
+static int	TcpTicks;	/* ticks since the last progress	 */
+static int	TcpRetries;
+
+static tcp_rx_f		*TcpRxHandler;
+static tcp_event_f	*TcpEventHandler;
+
+static void tcp_timer(void);
+
+static ushort tcp_sum(IPaddr_t src, IPaddr_t dst, uchar *seg, unsigned len)
+{
+	return net_pseudo_cksum(src, dst, IPPROTO_TCP, seg, len);
+}
+
+static void tcp_output(uchar flags, uint seq, const uchar *data,
+		       unsigned len)
+{
+	TCP_t	*tcp;
+	uchar	*opt;
+	unsigned hlen = TCP_HDR_SIZE;
+	ulong	win = CONFIG_TCP_WINDOW;
+
+	tcp = (TCP_t *)((uchar *)NetTxPacket + NetEthHdrSize() +
+			IP_HDR_SIZE_NO_UDP);
+	opt = (uchar *)tcp + TCP_HDR_SIZE;
+
+	if (flags & TCP_SYN) {
+		/* MSS */
+		*opt++ = 2;
+		*opt++ = 4;
+		*opt++ = TCP_MSS >> 8;
+		*opt++ = TCP_MSS & 0xff;
+		/* NOP, window scale */
+		*opt++ = 1;
+		*opt++ = 3;
+		*opt++ = 3;
+		*opt++ = TcpWinShift;
+		hlen += 8;
+		/* the window in a SYN is never scaled */
+		if (win > 0xffff)
+			win = 0xffff;
+	} else {
+		win >>= TcpWinShift;
+		if (win > 0xffff)
+			win = 0xffff;
+	}
+
+	if (len)
+		memcpy((uchar *)tcp + hlen, data, len);
+
+	tcp->tcp_src = htons(TcpOurPort);
+	tcp->tcp_dst = htons(TcpRemotePort);
+	put_unaligned_be32(seq, &tcp->tcp_seq);
+	put_unaligned_be32((flags & TCP_ACK) ? TcpRcvNxt : 0, &tcp->tcp_ack);
+	tcp->tcp_off = (hlen / 4) << 4;
+	tcp->tcp_flags = flags;
+	tcp->tcp_win = htons(win);
+	tcp->tcp_xsum = 0;
+	tcp->tcp_urp = 0;
+	tcp->tcp_xsum = ~tcp_sum(NetOurIP, TcpRemoteIP, (uchar *)tcp,
+				 hlen + len);
+
+	if (flags & TCP_ACK)
+		TcpAckPending = 0;
+
+	net_send_ip_packet(TcpRemoteEther, TcpRemoteIP, IPPROTO_TCP,
+			   hlen + len);
+}
+
+static void tcp_send_ack(void)
+{
+	tcp_output(TCP_ACK, TcpSndNxt, NULL, 0);
+}
+
+static void tcp_retransmit(void)
+{
+	tcp_output(TcpTxFlags, TcpTxSeq, TcpTxBuf, TcpTxLen);
+}
+
+static void tcp_event(enum tcp_event ev)
+{
+	tcp_event_f *f = TcpEventHandler;
+
+	if (ev != TCP_EV_CONNECTED)
+		tcp_reset();
+	if (f)
+		(*f)(ev);
+}
+
+static void tcp_timer(void)
+{
+	if (TcpState == TCP_CLOSED)
+		return;
+
+	NetSetTimeout(TCP_TICK, tcp_timer);
+
+	if (TcpAckPending)
+		tcp_send_ack();
+
+	if (++TcpTicks < TCP_RTO_TICKS)
+		return;
+
+	TcpTicks = 0;
+	if (++TcpRetries > TCP_RETRIES) {
+		/* all data is in, the peer just never ACKed our FIN */
+		if (TcpState == TCP_LAST_ACK) {
+			tcp_event(TCP_EV_CLOSED);
+			return;
+		}
+		puts("\nRetry count exceeded\n");
+		tcp_event(TCP_EV_TIMEOUT);
+		return;
+	}
+	puts("T ");
+
+	if (TcpSndUna != TcpSndNxt)
+		tcp_retransmit();
+	else
+		/* nudge the peer in case our last ACK was lost */
+		tcp_send_ack();
+}
+
+static void tcp_parse_options(uchar *opt, unsigned len, int *peer_wscale)
+{
+	while (len > 0) {
+		unsigned olen;
+
+		if (opt[0] == 0)		/* end of options */
+			break;
+		if (opt[0] == 1) {		/* NOP */
+			opt++;
+			len--;
+			continue;
+		}
+		if (len < 2 || opt[1] < 2 || opt[1] > len)
+			break;
+		olen = opt[1];
+		if (opt[0] == 3 && olen == 3)	/* window scale */
+			*peer_wscale = 1;
+		opt += olen;
+		len -= olen;
+	}
+}
+
+void tcp_reset(void)
+{
+	TcpState = TCP_CLOSED;
+	TcpTxLen = 0;
+	TcpAckPending = 0;
+}
+
+void tcp_connect(IPaddr_t dest, int dport, tcp_rx_f *rx, tcp_event_f *event)
+{
+	ulong win;
+
+	tcp_reset();
+
+	TcpRemoteIP = dest;
+	TcpRemotePort = dport;
+	TcpOurPort = random_port();
+	memset(TcpRemoteEther, 0, 6);
+	TcpRxHandler = rx;
+	TcpEventHandler = event;
+
+	/* smallest scale that lets the whole window be advertised */
+	TcpWinShift = 0;
+	for (win = CONFIG_TCP_WINDOW; win > 0xffff && TcpWinShift < 14;
+	     win >>= 1)
+		TcpWinShift++;
+
+	TcpSndUna = get_timer(0) * 64000 + NetIPID;
+	TcpSndNxt = TcpSndUna + 1;
+	TcpRcvNxt = 0;
+	TcpTxFlags = TCP_SYN;
+	TcpTxSeq = TcpSndUna;
+	TcpTxLen = 0;
+	TcpTicks = 0;
+	TcpRetries = 0;
+	TcpState = TCP_SYN_SENT;
+
+	NetSetTimeout(TCP_TICK, tcp_timer);
+	tcp_retransmit();
+}
+
+int tcp_send(const uchar *data, unsigned len)
+{
+	if (TcpState != TCP_ESTABLISHED || TcpSndUna != TcpSndNxt ||
+	    len > TCP_MSS)
+		return -1;
+
+	memcpy(TcpTxBuf, data, len);
+	TcpTxLen = len;
+	TcpTxSeq = TcpSndNxt;
+	TcpTxFlags = TCP_ACK | TCP_PSH;
+	TcpSndNxt += len;
+	TcpTicks = 0;
+	tcp_retransmit();
+	return 0;
+}
+
+void tcp_close(void)
+{
+	if (TcpState != TCP_ESTABLISHED)
+		return;
+
+	if (TcpSndUna == TcpSndNxt) {
+		TcpTxLen = 0;
+		TcpTxSeq = TcpSndNxt;
+		TcpTxFlags = TCP_ACK;
+	}
+	TcpTxFlags |= TCP_FIN;
+	TcpSndNxt++;
+	TcpState = TCP_FIN_WAIT;
+	TcpTicks = 0;
+	tcp_retransmit();
+}
+
+void tcp_receive(IP_t *ip, unsigned len, IPaddr_t src_ip)
+{
+	TCP_t	*tcp = (TCP_t *)((uchar *)ip + IP_HDR_SIZE_NO_UDP);
+	uchar	*data;
+	unsigned hlen, dlen;
+	uint	seq, ack, off;
+	uchar	flags;
+
+	if (TcpState == TCP_CLOSED || len < IP_HDR_SIZE_NO_UDP + TCP_HDR_SIZE)
+		return;
+	len -= IP_HDR_SIZE_NO_UDP;
+
+	if (src_ip != TcpRemoteIP ||
+	    ntohs(tcp->tcp_src) != TcpRemotePort ||
+	    ntohs(tcp->tcp_dst) != TcpOurPort)
+		return;
+
+	hlen = (tcp->tcp_off >> 4) * 4;
+	if (hlen < TCP_HDR_SIZE || hlen > len)
+		return;
+	if (!net_csum_offload(ETH_CSUM_RX) &&
+	    tcp_sum(src_ip, NetReadIP(&ip->ip_dst), (uchar *)tcp, len)
+	    != 0xffff) {
+		debug("tcp: bad checksum\n");
+		return;
+	}
+
+	seq = get_unaligned_be32(&tcp->tcp_seq);
+	ack = get_unaligned_be32(&tcp->tcp_ack);
+	flags = tcp->tcp_flags;
+	data = (uchar *)tcp + hlen;
+	dlen = len - hlen;
+
+	if (TcpState == TCP_SYN_SENT) {
+		int peer_wscale = 0;
+
+		if (!(flags & TCP_ACK) || ack != TcpSndNxt)
+			return;
+		if (flags & TCP_RST) {
+			tcp_event(TCP_EV_RESET);
+			return;
+		}
+		if (!(flags & TCP_SYN))
+			return;
+
+		tcp_parse_options((uchar *)tcp + TCP_HDR_SIZE,
+				  hlen - TCP_HDR_SIZE, &peer_wscale);
+		if (!peer_wscale)
+			TcpWinShift = 0;
+
+		TcpRcvNxt = seq + 1;
+		TcpSndUna = ack;
+		TcpTicks = 0;
+		TcpRetries = 0;
+		TcpState = TCP_ESTABLISHED;
+		tcp_send_ack();
+		tcp_event(TCP_EV_CONNECTED);
+		return;
+	}
+
+	if (flags & TCP_RST) {
+		if (seq == TcpRcvNxt)
+			tcp_event(TCP_EV_RESET);
+		return;
+	}
+
+	if (flags & TCP_SYN) {
+		/* retransmitted SYN/ACK: our ACK of it got lost */
+		tcp_send_ack();
+		return;
+	}
+
+	if ((flags & TCP_ACK) && (int)(ack - TcpSndUna) > 0 &&
+	    (int)(ack - TcpSndNxt) <= 0) {
+		TcpSndUna = ack;
+		TcpTicks = 0;
+		TcpRetries = 0;
+		if (TcpSndUna == TcpSndNxt) {
+			TcpTxLen = 0;
+			if (TcpState == TCP_LAST_ACK) {
+				tcp_event(TCP_EV_CLOSED);
+				return;
+			}
+		}
+	}
+
+	if (dlen == 0 && !(flags & TCP_FIN))
+		return;
+
+	/* accept in-order data only, trimming anything we already have */
+	off = TcpRcvNxt - seq;
+	if ((int)off < 0 || (off >= dlen && !(flags & TCP_FIN)) ||
+	    off > dlen) {
+		/* hole or duplicate: tell the peer what we expect */
+		tcp_send_ack();
+		return;
+	}
+	data += off;
+	dlen -= off;
+
+	TcpTicks = 0;
+	TcpRetries = 0;
+
+	if (dlen) {
+		TcpRcvNxt += dlen;
+		TcpAckPending++;
+		if (TcpState == TCP_ESTABLISHED && TcpRxHandler)
+			(*TcpRxHandler)(data, dlen);
+		/* the handler may have closed the connection */
+		if (TcpState == TCP_CLOSED)
+			return;
+	}
+
+	if (flags & TCP_FIN) {
+		TcpRcvNxt++;
+		if (TcpState == TCP_ESTABLISHED) {
+			/*
+			 * Answer with our own FIN right away.  The timer
+			 * resends it until it is ACKed, and only then is
+			 * the application told the connection is closed.
+			 */
+			TcpTxLen = 0;
+			TcpTxSeq = TcpSndNxt;
+			TcpTxFlags = TCP_ACK | TCP_FIN;
+			TcpSndNxt++;
+			TcpState = TCP_LAST_ACK;
+			TcpTicks = 0;
+			TcpRetries = 0;
+			tcp_retransmit();
+		} else {
+			tcp_send_ack();
+			if (TcpState == TCP_FIN_WAIT)
+				tcp_reset();
+		}
+		return;
+	}
+
+	if (TcpAckPending >= TCP_ACK_EVERY)
+		tcp_send_ack();
+}
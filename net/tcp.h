@@ -0,0 +1,67 @@
+/*
+ * Minimal TCP client for U-Boot
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __TCP_H__
+#define __TCP_H__
+
+/*
+ *	TCP header (RFC 793), without options.  Sequence numbers are not
+ *	naturally aligned in a received frame, so always access them with
+ *	get_unaligned_be32() / put_unaligned_be32().
+ */
+typedef struct {
+	ushort	tcp_src;	/* source port				*/
+	ushort	tcp_dst;	/* destination port			*/
+	uint	tcp_seq;	/* sequence number			*/
+	uint	tcp_ack;	/* acknowledgement number		*/
+	uchar	tcp_off;	/* data offset (in words) << 4		*/
+	uchar	tcp_flags;	/* control bits				*/
+	ushort	tcp_win;	/* receive window			*/
+	ushort	tcp_xsum;	/* checksum				*/
+	ushort	tcp_urp;	/* urgent pointer			*/
+} TCP_t;
+
+#define TCP_HDR_SIZE		(sizeof(TCP_t))
+
+#define TCP_FIN		0x01
+#define TCP_SYN		0x02
+#define TCP_RST		0x04
+#define TCP_PSH		0x08
+#define TCP_ACK		0x10
+
+/* Events reported to the application */
+enum tcp_event {
+	TCP_EV_CONNECTED,	/* three-way handshake completed	*/
+	TCP_EV_CLOSED,		/* peer sent FIN, ours ACKed or given up */
+	TCP_EV_RESET,		/* peer refused or aborted connection	*/
+	TCP_EV_TIMEOUT,		/* retransmissions exhausted		*/
+};
+
+/* In-order payload delivered to the application */
+typedef void tcp_rx_f(uchar *data, unsigned len);
+typedef void tcp_event_f(enum tcp_event ev);
+
+/*
+ * Open a connection to dest:dport.  Only one connection exists at a time;
+ * calling this replaces any previous one.  The TCP layer takes over the
+ * NetLoop timeout handler while the connection is open.
+ */
+extern void tcp_connect(IPaddr_t dest, int dport, tcp_rx_f *rx,
+			tcp_event_f *event);
+/* Queue data for sending; returns 0 on success, -1 if not possible */
+extern int tcp_send(const uchar *data, unsigned len);
+/* Send FIN; the connection is torn down once the peer acknowledges it */
+extern void tcp_close(void);
+/* Drop all connection state without sending anything */
+extern void tcp_reset(void);
+
+/* Called from NetReceive() for every IP packet carrying TCP */
+extern void tcp_receive(IP_t *ip, unsigned len, IPaddr_t src_ip);
+
+#endif /* __TCP_H__ */
@@ -9,6 +9,8 @@
 #include <common.h>
 #include <command.h>
 #include <net.h>
+#include <load_hash.h>
+#include <load_stream.h>
 #include "tftp.h"
 #include "bootp.h"
 
@@ -16,6 +18,10 @@
 #define WELL_KNOWN_PORT	69
 /* Millisecs to timeout for lost pkt */
 #define TIMEOUT		5000UL
+#ifndef CONFIG_TFTP_RTO_MIN
+/* Least retransmission timeout the measured round trips may get to */
+# define CONFIG_TFTP_RTO_MIN	200UL
+#endif
 #ifndef	CONFIG_NET_RETRY_COUNT
 /* # of timeouts before giving up */
 # define TIMEOUT_COUNT	10
@@ -24,6 +30,10 @@
 #endif
 /* Number of "loading" hashes per line (for checking the image size) */
 #define HASHES_PER_LINE	65
+#ifndef CONFIG_TFTP_MULTI_MAX
+/* Files at most in one "tftpboot multi" */
+# define CONFIG_TFTP_MULTI_MAX	4
+#endif
 
 /*
  *	TFTP operations.
@@ -38,6 +48,18 @@
 static ulong TftpTimeoutMSecs = TIMEOUT;
 static int TftpTimeoutCountMax = TIMEOUT_COUNT;
 
+/*
+ * Retransmission timeout of the session, from the round trip times
+ * measured (rfc-6298).  It starts at TftpTimeoutMSecs, which is also
+ * the most it backs off to; a packet that had to be sent again is not
+ * timed.
+ */
+static ulong TftpRTO;		/* ms */
+static ulong TftpSRTT;		/* smoothed round trip time, ms * 8 */
+static ulong TftpRTTVar;	/* its mean deviation, ms * 4 */
+static ulong TftpRTTSent;	/* when the packet being timed was sent */
+static int TftpRTTTiming;
+
 /*
  * These globals govern the timeout behavior when attempting a connection to a
  * TFTP server. TftpRRQTimeoutMSecs specifies the number of milliseconds to
@@ -95,6 +117,7 @@ static int	TftpFinalBlock;	/* 1 if we have sent the last block */
 #define STATE_OACK	5
 #define STATE_RECV_WRQ	6
 #define STATE_SEND_WRQ	7
+#define STATE_SEND_OACK	8
 
 /* default TFTP block size */
 #define TFTP_BLOCK_SIZE		512
@@ -120,19 +143,60 @@ extern flash_info_t flash_info[];
  * Minus eth.hdrs thats 1468.  Can get 2x better throughput with
  * almost-MTU block sizes.  At least try... fall back to 512 if need be.
  * (but those using CONFIG_IP_DEFRAG may want to set a larger block in cfg file)
+ * With jumbo frames, the block fills the MTU of the device; if the blocks
+ * do not get through, we ask again for 1468.
  */
+#define TFTP_ETH_BLOCKSIZE 1468
 #ifdef CONFIG_TFTP_BLOCKSIZE
 #define TFTP_MTU_BLOCKSIZE CONFIG_TFTP_BLOCKSIZE
 #else
-#define TFTP_MTU_BLOCKSIZE 1468
+#define TFTP_MTU_BLOCKSIZE (eth_get_mtu() - 32)
 #endif
 
 static unsigned short TftpBlkSize = TFTP_BLOCK_SIZE;
-static unsigned short TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
+static unsigned short TftpBlkSizeOption;
+/* The server's request port, for rejoining a group or asking again */
+static int TftpServerPort;
+
+#ifdef CONFIG_TFTP_WINDOWSIZE
+/*
+ * RFC 7440 windowed transfers: the server sends TftpWindowSize blocks
+ * before it waits for an ACK.  Blocks arriving out of order within the
+ * window are stored right away and remembered in TftpWindowMap (bit n
+ * set means block TftpLastBlock + n + 1 has been received), so only the
+ * in-order head of the transfer is ever acknowledged.
+ */
+#define TFTP_WINDOWSIZE_MAX	32
+static unsigned short TftpWindowSize = 1;
+static unsigned short TftpWindowSizeOption = CONFIG_TFTP_WINDOWSIZE;
+static unsigned long TftpWindowMap;
+/* last block we have acknowledged */
+static ushort TftpWindowAcked;
+/* block number of the final (short) block, if already received */
+static ushort TftpWindowFinal;
+static int TftpWindowFinalSeen;
+#ifdef CONFIG_CMD_TFTPPUT
+/* windowed uploads: blocks counted from 1, without the 16 bit wrap */
+static ulong TftpPutAcked;	/* last block acknowledged */
+static ulong TftpPutLast;	/* the final block, maybe empty */
+static int TftpPutResent;	/* window sent again since the last ACK */
+#endif
+#endif
+#ifdef CONFIG_CMD_TFTPSRV
+/* options of the write request that go into our OACK */
+#define TFTP_SRV_BLKSIZE	0x01
+#define TFTP_SRV_WINDOWSIZE	0x02
+static int TftpSrvOptions;
+#endif
 
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
-#define MTFTP_BITMAPSIZE	0x1000
+/*
+ * One bit per block number, covering the whole 16 bit sequence space.
+ * Multicast transfers cannot follow a block number wrap (a passive
+ * client may miss the wrap point), so larger files fall back to unicast.
+ */
+#define MTFTP_BITMAPSIZE	(TFTP_SEQUENCE_SIZE / 8)
 static unsigned *Bitmap;
 static int PrevBitmapHole, Mapsize = MTFTP_BITMAPSIZE;
 static uchar ProhibitMcast, MasterClient;
@@ -140,6 +204,8 @@ static uchar Multicast;
 extern IPaddr_t Mcast_addr;
 static int Mcast_port;
 static ulong TftpEndingBlock; /* can get 'last' block before done..*/
+/* Statistics reported when the transfer completes */
+static ulong McastBlocks, McastDuplicates, McastMissed, McastHighest;
 
 static void parse_multicast_oack(char *pkt, int len);
 
@@ -153,6 +219,25 @@ mcast_cleanup(void)
 	Bitmap = NULL;
 	Mcast_addr = Multicast = Mcast_port = 0;
 	TftpEndingBlock = -1;
+	McastBlocks = McastDuplicates = McastMissed = McastHighest = 0;
+}
+
+/*
+ * Account for a received block; the bitmap itself is updated by
+ * store_block().  Returns 1 if the block was already present.
+ */
+static int mcast_note_block(ulong block)
+{
+	if (ext2_test_bit(block - 1, Bitmap)) {
+		McastDuplicates++;
+		return 1;
+	}
+	McastBlocks++;
+	if (block > McastHighest + 1)
+		McastMissed += block - McastHighest - 1;
+	if (block > McastHighest)
+		McastHighest = block;
+	return 0;
 }
 
 #endif	/* CONFIG_MCAST_TFTP */
@@ -185,12 +270,19 @@ store_block(unsigned block, uchar *src, unsigned len)
 	}
 	else
 #endif /* CONFIG_SYS_DIRECT_FLASH_TFTP */
-	{
-		(void)memcpy((void *)(load_addr + offset), src, len);
+	if (load_stream_active()) {
+		/* tftpflash: programmed while the rest comes in */
+		if (load_stream_store(offset, src, len)) {
+			NetState = NETLOOP_FAIL;
+			return;
+		}
+	} else {
+		net_store_payload(load_addr + offset, src, len);
+		load_hash_update(load_addr + offset, src, len);
 	}
 #ifdef CONFIG_MCAST_TFTP
 	if (Multicast)
-		ext2_set_bit(block, Bitmap);
+		(void)ext2_set_bit(block, Bitmap);
 #endif
 
 	if (NetBootFileXferSize < newsize)
@@ -206,6 +298,7 @@ static void new_transfer(void)
 #ifdef CONFIG_CMD_TFTPPUT
 	TftpFinalBlock = 0;
 #endif
+	load_stream_reset();
 }
 
 #ifdef CONFIG_CMD_TFTPPUT
@@ -234,6 +327,108 @@ static int load_block(unsigned block, uchar *dst, unsigned len)
 static void TftpSend(void);
 static void TftpTimeout(void);
 
+static void tftp_rtt_reset(void)
+{
+	TftpRTO = TftpTimeoutMSecs;
+	TftpSRTT = 0;
+	TftpRTTTiming = 0;
+}
+
+/* A packet the server answers has been sent */
+static void tftp_rtt_start(void)
+{
+	TftpRTTTiming = !TftpTimeoutCount;
+	TftpRTTSent = get_timer(0);
+}
+
+/* The answer has arrived */
+static void tftp_rtt_sample(void)
+{
+	ulong rtt;
+	long delta;
+
+	if (!TftpRTTTiming)
+		return;
+	TftpRTTTiming = 0;
+	rtt = get_timer(TftpRTTSent);
+
+	if (!TftpSRTT) {
+		TftpSRTT = (rtt << 3) | 1;	/* nonzero: measured */
+		TftpRTTVar = rtt << 1;
+	} else {
+		delta = rtt - (TftpSRTT >> 3);
+		TftpSRTT += delta;
+		if (delta < 0)
+			delta = -delta;
+		TftpRTTVar += delta - (TftpRTTVar >> 2);
+	}
+
+	/* SRTT + 4 * RTTVAR, at least one tick for the variance */
+	TftpRTO = (TftpSRTT >> 3) + max(TftpRTTVar, 1UL);
+	TftpRTO = max(TftpRTO, (ulong)CONFIG_TFTP_RTO_MIN);
+	TftpRTO = min(TftpRTO, TftpTimeoutMSecs);
+}
+static void update_block_number(void);
+static void tftp_complete(void);
+
+#if defined(CONFIG_CMD_TFTPPUT) && defined(CONFIG_TFTP_WINDOWSIZE)
+/*
+ * Send the blocks of the window after the last one acknowledged, each
+ * read from memory straight into the transmit buffer.
+ */
+static void tftp_put_window(void)
+{
+	ulong block, end = min(TftpPutAcked + TftpWindowSize, TftpPutLast);
+	ulong offset, len;
+	ushort *s;
+
+	for (block = TftpPutAcked + 1; block <= end; block++) {
+		offset = (block - 1) * TftpBlkSize;
+		len = min(NetBootFileXferSize - offset, (ulong)TftpBlkSize);
+
+		s = (ushort *)(NetTxPacket + NetEthHdrSize() + IP_HDR_SIZE);
+		s[0] = htons(TFTP_DATA);
+		s[1] = htons((ushort)block);
+		memcpy(s + 2, (void *)(save_addr + offset), len);
+		NetSendUDPPacket(NetServerEther, TftpRemoteIP, TftpRemotePort,
+				 TftpOurPort, 4 + len);
+	}
+	tftp_rtt_start();
+}
+
+/*
+ * The server has acknowledged block seq of a windowed upload: go on
+ * with the next window.  An ACK of what was acknowledged before means
+ * that the server has lost the start of the window, which is sent
+ * again, but only once: the copies would be acknowledged in turn.
+ */
+static void tftp_put_ack(ushort seq)
+{
+	ushort diff = seq - (ushort)TftpPutAcked;
+
+	if (diff > min(TftpPutAcked + TftpWindowSize, TftpPutLast) -
+	    TftpPutAcked)
+		return;		/* not a block we have sent */
+	if (!diff && TftpPutResent)
+		return;
+	TftpPutResent = !diff;
+
+	TftpTimeoutCountMax = TIMEOUT_COUNT;
+	TftpTimeoutCount = 0;
+	NetSetTimeout(TftpRTO, TftpTimeout);
+
+	while (diff--) {
+		TftpBlock = (ushort)++TftpPutAcked;
+		update_block_number();
+	}
+	if (TftpPutAcked == TftpPutLast) {
+		tftp_complete();
+		return;
+	}
+	tftp_put_window();
+}
+#endif
+
 /**********************************************************************/
 
 static void show_block_marker(void)
@@ -301,6 +496,13 @@ static void tftp_complete(void)
 		putc('#');
 		TftpNumchars++;
 	}
+#endif
+#ifdef CONFIG_MCAST_TFTP
+	if (Multicast)
+		printf("\nMulticast: %lu blocks, %lu duplicates, "
+		       "%lu missed and repaired%s",
+		       McastBlocks, McastDuplicates, McastMissed,
+		       MasterClient ? " (master client)" : "");
 #endif
 	puts("\ndone\n");
 	NetState = NETLOOP_SUCCESS;
@@ -349,20 +551,32 @@ TftpSend(void)
 		debug("send option \"timeout %s\"\n", (char *)pkt);
 		pkt += strlen((char *)pkt) + 1;
 #ifdef CONFIG_TFTP_TSIZE
+		/* a request (re)sent to rejoin a multicast group asks for 0 */
 		pkt += sprintf((char *)pkt, "tsize%c%lu%c",
-				0, NetBootFileXferSize, 0);
+				0, TftpState == STATE_SEND_RRQ ? 0 :
+				NetBootFileXferSize, 0);
 #endif
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, TftpBlkSizeOption, 0);
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		if (TftpWindowSizeOption > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSizeOption, 0);
+#endif
 #ifdef CONFIG_MCAST_TFTP
-		/* Check all preconditions before even trying the option */
-		if (!ProhibitMcast
-		 && (Bitmap = malloc(Mapsize))
-		 && eth_get_dev()->mcast) {
-			free(Bitmap);
-			Bitmap = NULL;
-			pkt += sprintf((char *)pkt, "multicast%c%c", 0, 0);
+		/*
+		 * Check all preconditions before even trying the option.
+		 * When rejoining a group, keep the bitmap we already have.
+		 */
+		if (!ProhibitMcast && !load_stream_active() &&
+		    eth_get_dev()->mcast) {
+			unsigned *map = Bitmap ? NULL : malloc(Mapsize);
+
+			if (Bitmap || map)
+				pkt += sprintf((char *)pkt, "multicast%c%c",
+						0, 0);
+			free(map);
 		}
 #endif /* CONFIG_MCAST_TFTP */
 		len = pkt - xp;
@@ -377,8 +591,32 @@ TftpSend(void)
 		/*..falling..*/
 #endif
 
+#ifdef CONFIG_CMD_TFTPSRV
+	case STATE_SEND_OACK:
+		xp = pkt;
+		s = (ushort *)pkt;
+		*s++ = htons(TFTP_OACK);
+		pkt = (uchar *)s;
+		if (TftpSrvOptions & TFTP_SRV_BLKSIZE)
+			pkt += sprintf((char *)pkt, "blksize%c%d%c",
+					0, TftpBlkSize, 0);
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		if (TftpSrvOptions & TFTP_SRV_WINDOWSIZE)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSize, 0);
+#endif
+		len = pkt - xp;
+		break;
+#endif
+
 	case STATE_RECV_WRQ:
 	case STATE_DATA:
+#if defined(CONFIG_CMD_TFTPPUT) && defined(CONFIG_TFTP_WINDOWSIZE)
+		if (TftpWriting && TftpWindowSize > 1) {
+			tftp_put_window();
+			return;
+		}
+#endif
 		xp = pkt;
 		s = (ushort *)pkt;
 		s[0] = htons(TFTP_ACK);
@@ -421,6 +659,7 @@ TftpSend(void)
 		break;
 	}
 
+	tftp_rtt_start();
 	NetSendUDPPacket(NetServerEther, TftpRemoteIP, TftpRemotePort,
 			 TftpOurPort, len);
 }
@@ -436,6 +675,127 @@ static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 }
 #endif
 
+#ifdef CONFIG_TFTP_WINDOWSIZE
+/*
+ * Handle a DATA packet of a windowed transfer.  TftpBlock holds the
+ * sequence number of the packet, pkt/len its payload.
+ */
+static void tftp_window_data(unsigned src, uchar *pkt, unsigned len)
+{
+	ushort diff, pending;
+
+	if (TftpState == STATE_OACK || TftpState == STATE_SEND_OACK) {
+		/* first block received */
+		TftpState = STATE_DATA;
+		TftpRemotePort = src;
+		new_transfer();
+		TftpWindowMap = 0;
+		TftpWindowAcked = 0;
+		TftpWindowFinalSeen = 0;
+	}
+
+	/* Position of this block relative to the in-order head */
+	diff = (ushort)(TftpBlock - TftpLastBlock);
+	if (diff == 0 || diff > TftpWindowSize) {
+		/* Old duplicate or outside of the window; ignore it. */
+		TftpBlock = TftpLastBlock;
+		return;
+	}
+
+	TftpTimeoutCountMax = TIMEOUT_COUNT;
+	TftpTimeoutCount = 0;
+	NetSetTimeout(TftpRTO, TftpTimeout);
+
+	if (!(TftpWindowMap & (1UL << (diff - 1)))) {
+		/*
+		 * Not wrapped to 16 bits on purpose, so that blocks beyond
+		 * a sequence number wrap land behind the current one.
+		 */
+		store_block(TftpLastBlock + diff - 1, pkt, len);
+		TftpWindowMap |= 1UL << (diff - 1);
+		if (len < TftpBlkSize) {
+			TftpWindowFinal = TftpBlock;
+			TftpWindowFinalSeen = 1;
+		}
+	}
+
+	/* Advance the head over everything received in order */
+	pending = TftpBlock;
+	while (TftpWindowMap & 1) {
+		TftpWindowMap >>= 1;
+		TftpBlock = (ushort)(TftpLastBlock + 1);
+		update_block_number();
+		TftpLastBlock = TftpBlock;
+	}
+	TftpBlock = TftpLastBlock;
+	load_stream_commit(TftpLastBlock * TftpBlkSize + TftpBlockWrapOffset);
+
+	if (TftpWindowFinalSeen && TftpLastBlock == TftpWindowFinal) {
+		TftpSend();
+		tftp_complete();
+		return;
+	}
+
+	/*
+	 * Acknowledge once a whole window has arrived.  If the last block
+	 * of the window (or the final block) shows up while there is still
+	 * a hole, a packet got lost: acknowledge the head right away so
+	 * the server restarts from there instead of waiting for a timeout.
+	 */
+	if ((ushort)(TftpLastBlock - TftpWindowAcked) >= TftpWindowSize ||
+	    (ushort)(pending - TftpWindowAcked) == TftpWindowSize ||
+	    (TftpWindowFinalSeen && pending == TftpWindowFinal)) {
+		TftpWindowAcked = TftpLastBlock;
+		TftpSend();
+	}
+}
+#endif
+
+#ifdef CONFIG_CMD_TFTPSRV
+/*
+ * Take the blksize and windowsize options of a write request, as far
+ * as our own limits go; returns nonzero if there is anything to OACK.
+ */
+static int tftp_srv_options(uchar *pkt, unsigned len)
+{
+	char *p = (char *)pkt, *end = (char *)pkt + len;
+	char *opt, *arg;
+	ulong val;
+
+	TftpSrvOptions = 0;
+
+	/* skip the file name and the mode */
+	p += strnlen(p, end - p) + 1;
+	if (p < end)
+		p += strnlen(p, end - p) + 1;
+
+	while (p < end) {
+		opt = p;
+		p += strnlen(p, end - p) + 1;
+		if (p >= end)
+			break;
+		arg = p;
+		p += strnlen(p, end - p) + 1;
+		if (p > end)
+			break;
+		val = simple_strtoul(arg, NULL, 10);
+
+		if (strcmp(opt, "blksize") == 0 && val >= 8) {
+			TftpBlkSize = min(val, (ulong)TftpBlkSizeOption);
+			TftpSrvOptions |= TFTP_SRV_BLKSIZE;
+		}
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		if (strcmp(opt, "windowsize") == 0 && val >= 1) {
+			TftpWindowSize = min(val, (ulong)TftpWindowSizeOption);
+			TftpSrvOptions |= TFTP_SRV_WINDOWSIZE;
+		}
+#endif
+	}
+	debug("WRQ options: blksize %d\n", TftpBlkSize);
+	return TftpSrvOptions;
+}
+#endif
+
 static void
 TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 	    unsigned len)
@@ -462,6 +822,8 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 	s = (ushort *)pkt;
 	proto = *s++;
 	pkt = (uchar *)s;
+	if (ntohs(proto) != TFTP_WRQ)
+		tftp_rtt_sample();
 	switch (ntohs(proto)) {
 
 	case TFTP_RRQ:
@@ -469,6 +831,12 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 
 	case TFTP_ACK:
 #ifdef CONFIG_CMD_TFTPPUT
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		if (TftpWriting && TftpWindowSize > 1) {
+			tftp_put_ack(ntohs(*s));
+			break;
+		}
+#endif
 		if (TftpWriting) {
 			if (TftpFinalBlock) {
 				tftp_complete();
@@ -482,8 +850,14 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 
 				TftpBlock = (unsigned short)(block + 1);
 				update_block_number();
-				if (ack_ok)
+				if (ack_ok) {
+					/* progress: the timeout starts over */
+					TftpTimeoutCountMax = TIMEOUT_COUNT;
+					TftpTimeoutCount = 0;
+					NetSetTimeout(TftpRTO,
+						      TftpTimeout);
 					TftpSend(); /* Send next data block */
+				}
 			}
 		}
 #endif
@@ -499,7 +873,9 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		TftpRemotePort = src;
 		TftpOurPort = 1024 + (get_timer(0) % 3072);
 		new_transfer();
-		TftpSend(); /* Send ACK(0) */
+		if (tftp_srv_options(pkt, len))
+			TftpState = STATE_SEND_OACK;
+		TftpSend(); /* Send OACK or ACK(0) */
 		break;
 #endif
 
@@ -522,17 +898,35 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				debug("Blocksize ack: %s, %d\n",
 					(char *)pkt+i+8, TftpBlkSize);
 			}
+#ifdef CONFIG_TFTP_WINDOWSIZE
+			if (strcmp((char *)pkt+i, "windowsize") == 0) {
+				TftpWindowSize = (unsigned short)
+					simple_strtoul((char *)pkt+i+11, NULL,
+						       10);
+				if (TftpWindowSize < 1 ||
+				    TftpWindowSize > TftpWindowSizeOption)
+					TftpWindowSize = 1;
+				debug("Windowsize ack: %s, %d\n",
+					(char *)pkt+i+11, TftpWindowSize);
+			}
+#endif
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				TftpTsize = simple_strtoul((char *)pkt+i+6,
 							   NULL, 10);
 				debug("size = %s, %d\n",
 					 (char *)pkt+i+6, TftpTsize);
+				load_stream_size(TftpTsize);
 			}
 #endif
 		}
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len-1);
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		/* Passive clients cannot ACK a window; stay in lock-step */
+		if (Multicast)
+			TftpWindowSize = 1;
+#endif
 		if ((Multicast) && (!MasterClient))
 			TftpState = STATE_DATA;	/* passive.. */
 		else
@@ -542,6 +936,11 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			/* Get ready to send the first block */
 			TftpState = STATE_DATA;
 			TftpBlock++;
+#ifdef CONFIG_TFTP_WINDOWSIZE
+			TftpPutAcked = 0;
+			TftpPutLast = NetBootFileXferSize / TftpBlkSize + 1;
+			TftpPutResent = 0;
+#endif
 		}
 #endif
 		TftpSend(); /* Send ACK or first data block */
@@ -552,13 +951,30 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		len -= 2;
 		TftpBlock = ntohs(*(ushort *)pkt);
 
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		if (TftpWindowSize > 1 &&
+		    (TftpState == STATE_OACK || TftpState == STATE_DATA ||
+		     TftpState == STATE_SEND_OACK)) {
+			tftp_window_data(src, pkt + 2, len);
+			break;
+		}
+#endif
+#ifdef CONFIG_MCAST_TFTP
+		if (Multicast && TftpBlock == 0) {
+			/* the bitmap cannot follow a block number wrap */
+			ProhibitMcast = 1;
+			restart("File too large for multicast TFTP");
+			break;
+		}
+#endif
 		update_block_number();
 
 		if (TftpState == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
 		if (TftpState == STATE_SEND_RRQ || TftpState == STATE_OACK ||
-		    TftpState == STATE_RECV_WRQ) {
+		    TftpState == STATE_RECV_WRQ ||
+		    TftpState == STATE_SEND_OACK) {
 			/* first block received */
 			TftpState = STATE_DATA;
 			TftpRemotePort = src;
@@ -588,51 +1004,55 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 
 		TftpLastBlock = TftpBlock;
 		TftpTimeoutCountMax = TIMEOUT_COUNT;
-		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
-
-		store_block(TftpBlock - 1, pkt + 2, len);
+		TftpTimeoutCount = 0;
+		NetSetTimeout(TftpRTO, TftpTimeout);
 
-		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
-		 */
 #ifdef CONFIG_MCAST_TFTP
-		/* if I am the MasterClient, actively calculate what my next
-		 * needed block is; else I'm passive; not ACKING
-		 */
 		if (Multicast) {
-			if (len < TftpBlkSize)  {
+			ulong hole;
+
+			if (!mcast_note_block(TftpBlock))
+				store_block(TftpBlock - 1, pkt + 2, len);
+			if (len < TftpBlkSize)
 				TftpEndingBlock = TftpBlock;
-			} else if (MasterClient) {
-				TftpBlock = PrevBitmapHole =
-					ext2_find_next_zero_bit(
-						Bitmap,
-						(Mapsize*8),
-						PrevBitmapHole);
-				if (TftpBlock > ((Mapsize*8) - 1)) {
-					printf("tftpfile too big\n");
-					/* try to double it and retry */
-					Mapsize <<= 1;
-					mcast_cleanup();
-					NetStartAgain();
-					return;
+
+			/*
+			 * Every bit below PrevBitmapHole is set, so the
+			 * search for the first missing block can start there.
+			 */
+			hole = ext2_find_next_zero_bit(Bitmap, Mapsize * 8,
+						       PrevBitmapHole);
+			PrevBitmapHole = hole;
+
+			if (hole >= TftpEndingBlock) {
+				/* all there; the master client ACKs the end */
+				if (MasterClient) {
+					TftpBlock = TftpEndingBlock;
+					TftpSend();
 				}
-				TftpLastBlock = TftpBlock;
+				tftp_complete();
+				mcast_cleanup();
+			} else if (MasterClient) {
+				/*
+				 * ACK the block before the first hole: this
+				 * makes the server resend what anybody in the
+				 * group has missed.  Passive clients stay
+				 * quiet and wait to be elected.
+				 */
+				TftpBlock = hole;
+				TftpSend();
 			}
+			break;
 		}
 #endif
+		store_block(TftpBlock - 1, pkt + 2, len);
+
+		/*
+		 *	Acknowledge the block just received, which will prompt
+		 *	the remote for the next one.
+		 */
 		TftpSend();
 
-#ifdef CONFIG_MCAST_TFTP
-		if (Multicast) {
-			if (MasterClient && (TftpBlock >= TftpEndingBlock)) {
-				puts("\nMulticast tftp done\n");
-				mcast_cleanup();
-				NetState = NETLOOP_SUCCESS;
-			}
-		}
-		else
-#endif
 		if (len < TftpBlkSize)
 			tftp_complete();
 		break;
@@ -645,7 +1065,7 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		case TFTP_ERR_FILE_NOT_FOUND:
 		case TFTP_ERR_ACCESS_DENIED:
 			puts("Not retrying...\n");
-			eth_halt();
+			eth_park();
 			NetState = NETLOOP_FAIL;
 			break;
 		case TFTP_ERR_UNDEFINED:
@@ -673,29 +1093,73 @@ TftpTimeout(void)
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
-		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+		TftpRTO = min(TftpRTO << 1, TftpTimeoutMSecs);
+		NetSetTimeout(TftpRTO, TftpTimeout);
+#ifdef CONFIG_MCAST_TFTP
+		/*
+		 * A passive client that hears nothing asks the server again
+		 * (rfc-2090); the reply OACK may elect it as the new master
+		 * client, which then repairs its holes.  The bitmap is kept.
+		 */
+		if (Multicast && !MasterClient && TftpState == STATE_DATA) {
+			TftpState = STATE_SEND_RRQ;
+			TftpRemotePort = TftpServerPort;
+		}
+#endif
+		if (TftpState == STATE_OACK && !TftpWriting &&
+		    TftpBlkSize > TFTP_ETH_BLOCKSIZE &&
+		    TftpBlkSize <= eth_get_mtu() - 32) {
+			/* no jumbo frames on the way; ask again */
+			puts("\nTFTP block size too large, retrying with "
+			     "1468 bytes\n");
+			TftpBlkSizeOption = TFTP_ETH_BLOCKSIZE;
+			TftpBlkSize = TFTP_BLOCK_SIZE;
+			TftpState = STATE_SEND_RRQ;
+			TftpRemotePort = TftpServerPort;
+			TftpOurPort++;
+		}
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		/* The server restarts its window after our ACK */
+		if (TftpWindowSize > 1 && TftpState == STATE_DATA)
+			TftpWindowAcked = TftpLastBlock;
+#endif
 		if (TftpState != STATE_RECV_WRQ)
 			TftpSend();
 	}
 }
 
 
-void TftpStart(enum proto_t protocol)
+/*
+ * Allow the user to choose TFTP blocksize and timeout.
+ * TFTP protocol has a minimal timeout of 1 second.
+ */
+static void tftp_get_env(void)
 {
 	char *ep;             /* Environment pointer */
 
-	/*
-	 * Allow the user to choose TFTP blocksize and timeout.
-	 * TFTP protocol has a minimal timeout of 1 second.
-	 */
 	ep = getenv("tftpblocksize");
 	if (ep != NULL)
 		TftpBlkSizeOption = simple_strtol(ep, NULL, 10);
+	else
+		TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
 
 	ep = getenv("tftptimeout");
 	if (ep != NULL)
 		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
 
+#ifdef CONFIG_TFTP_WINDOWSIZE
+	ep = getenv("tftpwindowsize");
+	if (ep != NULL)
+		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
+	else
+		TftpWindowSizeOption = CONFIG_TFTP_WINDOWSIZE;
+	if (TftpWindowSizeOption < 1)
+		TftpWindowSizeOption = 1;
+	if (TftpWindowSizeOption > TFTP_WINDOWSIZE_MAX)
+		TftpWindowSizeOption = TFTP_WINDOWSIZE_MAX;
+	debug("TFTP windowsize = %i\n", TftpWindowSizeOption);
+#endif
+
 	if (TftpTimeoutMSecs < 1000) {
 		printf("TFTP timeout (%ld ms) too low, "
 			"set minimum = 1000 ms\n",
@@ -705,6 +1169,15 @@ void TftpStart(enum proto_t protocol)
 
 	debug("TFTP blocksize = %i, timeout = %ld ms\n",
 		TftpBlkSizeOption, TftpTimeoutMSecs);
+}
+
+void TftpStart(enum proto_t protocol)
+{
+#ifdef CONFIG_TFTP_PORT
+	char *ep;             /* Environment pointer */
+#endif
+
+	tftp_get_env();
 
 	TftpRemoteIP = NetServerIP;
 	if (BootFile[0] == '\0') {
@@ -775,11 +1248,13 @@ void TftpStart(enum proto_t protocol)
 		printf("Load address: 0x%lx\n", load_addr);
 		puts("Loading: *\b");
 		TftpState = STATE_SEND_RRQ;
+		load_hash_start(load_addr);
 	}
 
 	TftpTimeoutCountMax = TftpRRQTimeoutCountMax;
 
-	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+	tftp_rtt_reset();
+	NetSetTimeout(TftpRTO, TftpTimeout);
 	NetSetHandler(TftpHandler);
 #ifdef CONFIG_CMD_TFTPPUT
 	net_set_icmp_handler(icmp_handler);
@@ -797,12 +1272,17 @@ void TftpStart(enum proto_t protocol)
 	if (ep != NULL)
 		TftpOurPort = simple_strtol(ep, NULL, 10);
 #endif
+	TftpServerPort = TftpRemotePort;
 	TftpBlock = 0;
 
 	/* zero out server ether in case the server ip has changed */
 	memset(NetServerEther, 0, 6);
 	/* Revert TftpBlkSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+#ifdef CONFIG_TFTP_WINDOWSIZE
+	/* Lock-step until the server acknowledges a window */
+	TftpWindowSize = 1;
+#endif
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -814,6 +1294,331 @@ void TftpStart(enum proto_t protocol)
 	TftpSend();
 }
 
+#ifdef CONFIG_CMD_TFTP_MULTI
+/*
+ * Several files read from the server at once, in one NetLoop().  Each
+ * has its own session on a port of its own, in lock-step and without
+ * the options of TftpStart() but blksize and timeout, so that the
+ * round trips and the server's reads of the files overlap.
+ */
+#define STATE_IDLE	0		/* RRQ not sent yet */
+#define STATE_DONE	9
+
+struct tftp_multi {
+	ulong		addr;			/* load address */
+	char		name[MAX_LEN];
+	int		our_port;
+	int		remote_port;
+	int		state;
+	ushort		block;			/* last block received */
+	ushort		blksize;
+	ulong		blocks;			/* blocks received so far */
+	ulong		size;
+	ulong		sent;			/* get_timer() of last send */
+	int		timeouts;
+	int		missing;		/* probing: not there or too big */
+};
+
+static struct tftp_multi TftpMulti[CONFIG_TFTP_MULTI_MAX];
+static int TftpMultiCount;
+static ulong TftpMultiBlocks;		/* all sessions, for the hashes */
+static ulong TftpMultiProbeMax;		/* probing if not 0 */
+
+void TftpMultiClear(void)
+{
+	TftpMultiCount = 0;
+	TftpMultiProbeMax = 0;
+}
+
+/*
+ * Files that are not on the server, or are larger than max_size, only
+ * end their own session rather than the whole transfer.
+ */
+void TftpMultiProbe(ulong max_size)
+{
+	TftpMultiProbeMax = max_size;
+}
+
+long TftpMultiSize(int i)
+{
+	if (i >= TftpMultiCount || TftpMulti[i].state != STATE_DONE ||
+	    TftpMulti[i].missing)
+		return -1;
+	return TftpMulti[i].size;
+}
+
+int TftpMultiAdd(ulong addr, const char *filename)
+{
+	struct tftp_multi *t = &TftpMulti[TftpMultiCount];
+
+	if (TftpMultiCount >= CONFIG_TFTP_MULTI_MAX)
+		return -1;
+
+	t->addr = addr;
+	strncpy(t->name, filename, MAX_LEN);
+	t->name[MAX_LEN - 1] = 0;
+	TftpMultiCount++;
+	return 0;
+}
+
+static void tftp_multi_send(struct tftp_multi *t)
+{
+	uchar *pkt, *xp;
+	ushort *s;
+
+	pkt = (uchar *)(NetTxPacket + NetEthHdrSize() + IP_HDR_SIZE);
+	xp = pkt;
+	s = (ushort *)pkt;
+
+	if (t->state == STATE_IDLE || t->state == STATE_SEND_RRQ) {
+		t->state = STATE_SEND_RRQ;
+		*s++ = htons(TFTP_RRQ);
+		pkt = (uchar *)s;
+		pkt += sprintf((char *)pkt, "%s%coctet%ctimeout%c%lu%c",
+				t->name, 0, 0, 0, TftpTimeoutMSecs / 1000, 0);
+		pkt += sprintf((char *)pkt, "blksize%c%d%c",
+				0, TftpBlkSizeOption, 0);
+	} else {
+		/* OACK, DATA and DONE: acknowledge the last block */
+		*s++ = htons(TFTP_ACK);
+		*s++ = htons(t->block);
+		pkt = (uchar *)s;
+	}
+
+	t->sent = get_timer(0);
+	NetSendUDPPacket(NetServerEther, TftpRemoteIP, t->remote_port,
+			 t->our_port, pkt - xp);
+}
+
+/*
+ * Send the requests that are still to go.  Until the server's ethernet
+ * address is known there is only the one packet waiting for the ARP
+ * reply, so the other sessions start after that.
+ */
+static void tftp_multi_kick(void)
+{
+	int i;
+
+	for (i = 0; i < TftpMultiCount; i++) {
+		if (TftpMulti[i].state != STATE_IDLE)
+			continue;
+		if (i && !memcmp(NetServerEther, NetEtherNullAddr, 6))
+			break;
+		tftp_multi_send(&TftpMulti[i]);
+	}
+}
+
+static void tftp_multi_complete(void)
+{
+	struct tftp_multi *t, *last = NULL;
+	int i;
+
+	for (i = 0; i < TftpMultiCount; i++)
+		if (TftpMulti[i].state != STATE_DONE)
+			return;
+
+	puts("\ndone\n");
+	for (i = 0; i < TftpMultiCount; i++) {
+		t = &TftpMulti[i];
+		if (t->missing)
+			continue;
+		printf("'%s': %lu bytes at 0x%lx\n", t->name, t->size, t->addr);
+		flush_cache(t->addr, t->size);
+		last = t;
+	}
+
+	/* the last one is reported like a single transfer */
+	load_addr = last ? last->addr : load_addr;
+	NetBootFileXferSize = last ? last->size : 0;
+	NetState = NETLOOP_SUCCESS;
+}
+
+static void tftp_multi_missing(struct tftp_multi *t)
+{
+	t->missing = 1;
+	t->state = STATE_DONE;
+	tftp_multi_complete();
+}
+
+static void tftp_multi_data(struct tftp_multi *t, unsigned src,
+			    uchar *pkt, unsigned len)
+{
+	ushort block = ntohs(*(ushort *)pkt);
+	ulong offset;
+
+	if (t->state == STATE_SEND_RRQ || t->state == STATE_OACK) {
+		if (block != 1)
+			return;
+		/* first block: the server talks from its own port now */
+		t->state = STATE_DATA;
+		t->remote_port = src;
+		t->block = 0;
+		t->blocks = 0;
+	}
+
+	/* lock-step: anything but the next block is a duplicate */
+	if (t->state != STATE_DATA || block != (ushort)(t->block + 1)) {
+		/* our ACK of it may have been lost */
+		if (block == t->block && t->blocks)
+			tftp_multi_send(t);
+		return;
+	}
+
+	offset = t->blocks * t->blksize;
+	if (TftpMultiProbeMax && offset + len > TftpMultiProbeMax) {
+		/* the server gives up on its own once we stop acking */
+		tftp_multi_missing(t);
+		return;
+	}
+	net_store_payload(t->addr + offset, pkt + 2, len);
+	t->block = block;
+	t->blocks++;
+	t->size = offset + len;
+	t->timeouts = 0;
+	if (len < t->blksize)
+		t->state = STATE_DONE;
+	tftp_multi_send(t);
+
+	if ((++TftpMultiBlocks % 10) == 0) {
+		putc('#');
+		if ((TftpMultiBlocks % (10 * HASHES_PER_LINE)) == 0)
+			puts("\n\t ");
+	}
+
+	tftp_multi_complete();
+}
+
+static void
+TftpMultiHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
+		 unsigned len)
+{
+	struct tftp_multi *t = NULL;
+	ushort proto, code;
+	int i;
+
+	for (i = 0; i < TftpMultiCount; i++)
+		if (TftpMulti[i].our_port == dest)
+			t = &TftpMulti[i];
+	if (!t || t->state == STATE_IDLE ||
+	    (t->state != STATE_SEND_RRQ && src != t->remote_port))
+		return;
+
+	if (len < 4)
+		return;
+	proto = ntohs(*(ushort *)pkt);
+	pkt += 2;
+	len -= 2;
+
+	switch (proto) {
+	case TFTP_OACK:
+		if (t->state != STATE_SEND_RRQ)
+			break;
+		t->state = STATE_OACK;
+		t->remote_port = src;
+		for (i = 0; i + 8 < len; i++)
+			if (strcmp((char *)pkt + i, "blksize") == 0)
+				t->blksize = (ushort)simple_strtoul(
+					(char *)pkt + i + 8, NULL, 10);
+		t->block = 0;
+		tftp_multi_send(t);
+		break;
+
+	case TFTP_DATA:
+		tftp_multi_data(t, src, pkt, len - 2);
+		break;
+
+	case TFTP_ERROR:
+		code = ntohs(*(ushort *)pkt);
+		if (TftpMultiProbeMax && t->state == STATE_SEND_RRQ &&
+		    (code == TFTP_ERR_FILE_NOT_FOUND ||
+		     code == TFTP_ERR_ACCESS_DENIED)) {
+			tftp_multi_missing(t);
+			break;
+		}
+		printf("\nTFTP error on '%s': '%s' (%d)\n", t->name,
+		       pkt + 2, code);
+		if (code == TFTP_ERR_FILE_NOT_FOUND ||
+		    code == TFTP_ERR_ACCESS_DENIED) {
+			puts("Not retrying...\n");
+			eth_park();
+			NetState = NETLOOP_FAIL;
+		} else {
+			puts("Starting again\n\n");
+			NetStartAgain();
+		}
+		return;
+	}
+
+	tftp_multi_kick();
+}
+
+/* One timer for all the sessions, each with its own deadline */
+#define TFTP_MULTI_TICK		100UL
+
+static void TftpMultiTimeout(void)
+{
+	struct tftp_multi *t;
+	int i;
+
+	NetSetTimeout(TFTP_MULTI_TICK, TftpMultiTimeout);
+
+	for (i = 0; i < TftpMultiCount; i++) {
+		t = &TftpMulti[i];
+		if (t->state == STATE_IDLE || t->state == STATE_DONE ||
+		    get_timer(t->sent) < TftpTimeoutMSecs)
+			continue;
+		if (++t->timeouts > TIMEOUT_COUNT) {
+			restart("Retry count exceeded");
+			return;
+		}
+		puts("T ");
+		tftp_multi_send(t);
+	}
+
+	tftp_multi_kick();
+}
+
+void TftpMultiStart(void)
+{
+	int port = 1024 + (get_timer(0) % 3072);
+	struct tftp_multi *t;
+	int i;
+
+	tftp_get_env();
+
+	TftpRemoteIP = NetServerIP;
+	printf("Using %s device\n", eth_get_name());
+	printf("TFTP from server %pI4; our IP address is %pI4\n",
+	       &TftpRemoteIP, &NetOurIP);
+
+	for (i = 0; i < TftpMultiCount; i++) {
+		t = &TftpMulti[i];
+		printf("Filename '%s', load address 0x%lx\n",
+		       t->name, t->addr);
+
+		/* ports of our own, as in TftpStart(), one per file */
+		t->our_port = 1024 + (port + i - 1024) % 3072;
+		t->remote_port = WELL_KNOWN_PORT;
+		t->state = STATE_IDLE;
+		t->blksize = TFTP_BLOCK_SIZE;
+		t->block = 0;
+		t->blocks = 0;
+		t->size = 0;
+		t->timeouts = 0;
+		t->missing = 0;
+	}
+	puts("Loading: *\b");
+	TftpMultiBlocks = 0;
+
+	/* zero out server ether in case the server ip has changed */
+	memset(NetServerEther, 0, 6);
+
+	NetSetTimeout(TFTP_MULTI_TICK, TftpMultiTimeout);
+	NetSetHandler(TftpMultiHandler);
+	tftp_multi_kick();
+}
+#endif /* CONFIG_CMD_TFTP_MULTI */
+
 #ifdef CONFIG_CMD_TFTPSRV
 void
 TftpStartServer(void)
@@ -825,14 +1630,22 @@ TftpStartServer(void)
 	printf("Load address: 0x%lx\n", load_addr);
 
 	puts("Loading: *\b");
+	load_hash_start(load_addr);
+
+	/* the limits of the options clients may ask for */
+	tftp_get_env();
 
 	TftpTimeoutCountMax = TIMEOUT_COUNT;
 	TftpTimeoutCount = 0;
 	TftpTimeoutMSecs = TIMEOUT;
-	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+	tftp_rtt_reset();
+	NetSetTimeout(TftpRTO, TftpTimeout);
 
 	/* Revert TftpBlkSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+#ifdef CONFIG_TFTP_WINDOWSIZE
+	TftpWindowSize = 1;
+#endif
 	TftpBlock = 0;
 	TftpOurPort = WELL_KNOWN_PORT;
 
@@ -22,6 +22,10 @@ void TftpStart(enum proto_t protocol);	/* Begin TFTP get/put */
 extern void	TftpStartServer(void);	/* Wait for incoming TFTP put */
 #endif
 
+#ifdef CONFIG_CMD_TFTP_MULTI
+extern void	TftpMultiStart(void);	/* Begin the TftpMultiAdd() files */
+#endif
+
 /**********************************************************************/
 
 #endif /* __TFTP_H__ */
@@ -0,0 +1,226 @@
+/*
+ * HTTP image download for U-Boot
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Fetches BootFile ("[host:]path") with a plain HTTP/1.0 GET over the
+ * minimal TCP in tcp.c and streams the body to load_addr.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <net.h>
+#include <load_hash.h>
+#include "tcp.h"
+#include "wget.h"
+
+/* Number of "loading" hashes per line (for checking the image size) */
+#define HASHES_PER_LINE	65
+/* Print a hash mark every this many bytes */
+#define HASH_BYTES	(10 * 1024)
+/* Room for the response status line and headers */
+#define WGET_HDR_SIZE	1024
+
+static IPaddr_t	WgetServerIP;
+static int	WgetServerPort;
+static char	WgetPath[128];
+
+static char	WgetHdr[WGET_HDR_SIZE + 1];
+static unsigned	WgetHdrLen;
+static int	WgetInBody;
+static ulong	WgetContentLength;	/* 0 if not sent by the server */
+static ulong	WgetLastHash;
+static int	WgetHashes;
+
+static void wget_fail(const char *msg)
+{
+	printf("\n%s\n", msg);
+	tcp_reset();
+	eth_park();
+	NetState = NETLOOP_FAIL;
+}
+
+static void wget_done(void)
+{
+	puts("\ndone\n");
+	printf("Bytes transferred = %ld (%lx hex)\n",
+	       NetBootFileXferSize, NetBootFileXferSize);
+	NetState = NETLOOP_SUCCESS;
+}
+
+static void wget_store(uchar *data, unsigned len)
+{
+	if (WgetContentLength &&
+	    NetBootFileXferSize + len > WgetContentLength)
+		len = WgetContentLength - NetBootFileXferSize;
+
+	net_store_payload(load_addr + NetBootFileXferSize, data, len);
+	load_hash_update(load_addr + NetBootFileXferSize, data, len);
+	NetBootFileXferSize += len;
+
+	while (NetBootFileXferSize - WgetLastHash >= HASH_BYTES) {
+		WgetLastHash += HASH_BYTES;
+		if (++WgetHashes % HASHES_PER_LINE == 0)
+			puts("\n\t ");
+		putc('#');
+	}
+
+	if (WgetContentLength && NetBootFileXferSize >= WgetContentLength) {
+		/* got everything; no need to wait for the server's FIN */
+		tcp_close();
+		wget_done();
+	}
+}
+
+/*
+ * Parse the status line and headers collected in WgetHdr.  Returns 0 if
+ * the body may be stored, -1 if the request failed.
+ */
+static int wget_parse_header(void)
+{
+	char *p = WgetHdr;
+	int status;
+
+	if (strncmp(p, "HTTP/", 5) != 0)
+		return -1;
+	p = strchr(p, ' ');
+	if (p == NULL)
+		return -1;
+	status = simple_strtoul(p + 1, NULL, 10);
+	if (status != 200) {
+		char *e = strchr(p + 1, '\r');
+
+		if (e)
+			*e = '\0';
+		printf("\nHTTP error:%s\n", p);
+		return -1;
+	}
+
+	WgetContentLength = 0;
+	while ((p = strstr(p, "\r\n")) != NULL) {
+		p += 2;
+		if (strnicmp(p, "Content-Length:", 15) == 0) {
+			WgetContentLength = simple_strtoul(p + 15, NULL, 10);
+			break;
+		}
+	}
+
+	if (WgetContentLength)
+		printf("Content-Length: %ld\nLoading: *\b", WgetContentLength);
+	else
+		puts("Loading: *\b");
+
+	return 0;
+}
+
+static void wget_rx(uchar *data, unsigned len)
+{
+	unsigned n, old_len;
+	char *end;
+
+	if (WgetInBody) {
+		wget_store(data, len);
+		return;
+	}
+
+	/* collect the header, then hand what follows it to the body path */
+	old_len = WgetHdrLen;
+	n = min(len, WGET_HDR_SIZE - WgetHdrLen);
+	memcpy(WgetHdr + WgetHdrLen, data, n);
+	WgetHdrLen += n;
+	WgetHdr[WgetHdrLen] = '\0';
+
+	end = strstr(WgetHdr, "\r\n\r\n");
+	if (end == NULL) {
+		if (WgetHdrLen == WGET_HDR_SIZE)
+			wget_fail("HTTP header too long");
+		return;
+	}
+
+	/* bytes of this segment that belong to the header */
+	n = end + 4 - WgetHdr - old_len;
+	end[2] = '\0';
+
+	if (wget_parse_header() < 0) {
+		wget_fail("Download failed");
+		return;
+	}
+
+	WgetInBody = 1;
+	if (len > n)
+		wget_store(data + n, len - n);
+}
+
+static void wget_event(enum tcp_event ev)
+{
+	char req[sizeof(WgetPath) + 96];
+	int len;
+
+	switch (ev) {
+	case TCP_EV_CONNECTED:
+		len = sprintf(req, "GET %s HTTP/1.0\r\n"
+			      "Host: %pI4\r\n"
+			      "Connection: close\r\n\r\n",
+			      WgetPath, &WgetServerIP);
+		tcp_send((uchar *)req, len);
+		break;
+	case TCP_EV_CLOSED:
+		if (!WgetInBody) {
+			wget_fail("Connection closed before response");
+		} else if (WgetContentLength &&
+			   NetBootFileXferSize < WgetContentLength) {
+			wget_fail("Connection closed, transfer incomplete");
+		} else {
+			wget_done();
+		}
+		break;
+	case TCP_EV_RESET:
+		wget_fail("Connection refused/reset by server");
+		break;
+	case TCP_EV_TIMEOUT:
+		/* like TFTP, start over; NetLoop may try the next device */
+		NetStartAgain();
+		break;
+	}
+}
+
+void WgetStart(void)
+{
+	char *p, *s;
+
+	WgetServerIP = NetServerIP;
+	WgetServerPort = HTTP_SERVICE_PORT;
+	s = getenv("httpport");
+	if (s != NULL)
+		WgetServerPort = simple_strtol(s, NULL, 10);
+
+	p = strchr(BootFile, ':');
+	if (p != NULL) {
+		WgetServerIP = string_to_ip(BootFile);
+		++p;
+	} else {
+		p = BootFile;
+	}
+	copy_filename(WgetPath, p, sizeof(WgetPath));
+	if (WgetPath[0] == '\0')
+		strcpy(WgetPath, "/");
+
+	printf("Using %s device\n", eth_get_name());
+	printf("HTTP from server %pI4; our IP address is %pI4\n",
+	       &WgetServerIP, &NetOurIP);
+	printf("Filename '%s'.\n", WgetPath);
+	printf("Load address: 0x%lx\n", load_addr);
+
+	WgetHdrLen = 0;
+	WgetInBody = 0;
+	WgetContentLength = 0;
+	WgetLastHash = 0;
+	WgetHashes = 0;
+	NetBootFileXferSize = 0;
+	load_hash_start(load_addr);
+
+	tcp_connect(WgetServerIP, WgetServerPort, wget_rx, wget_event);
+}
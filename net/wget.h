@@ -0,0 +1,17 @@
+/*
+ * HTTP image download for U-Boot
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+
+#ifndef __WGET_H__
+#define __WGET_H__
+
+#define HTTP_SERVICE_PORT	80
+
+extern void	WgetStart(void);	/* Begin HTTP download */
+
+#endif /* __WGET_H__ */
@@ -148,10 +148,22 @@
  * 0x000ff800-0x00100800, 0x001ff800-0x00200800, ..., 0x03fff800-
  * 0x04000000. If the test is run in slow-test mode, it verifies
  * the whole RAM.
+ *
+ * Fast memory test (CONFIG_SYS_POST_MEMORY_FAST):
+ * -----------------------------------------------
+ * Replaces tests 1-4 in slow-test mode, for boards with a lot of RAM.
+ * The RAM is tested in blocks, each written with 64 bit words, four at
+ * a time, and with the caches as they are.  Every word holds its own
+ * address and its complement, xor'ed with one of 0, ~0, 0x55.. and
+ * 0xaa.., so that each bit is both 0 and 1 and no two words are alike.  The block is flushed
+ * and invalidated out of the data cache before being read back, so that
+ * what is checked comes from the RAM.  Once relocated, with
+ * CONFIG_MP_JOBS, the blocks are tested by the secondary cores.
  */
 
 #include <post.h>
 #include <watchdog.h>
+#include <mp_job.h>
 
 #if CONFIG_POST & (CONFIG_SYS_POST_MEMORY | CONFIG_SYS_POST_MEM_REGIONS)
 
@@ -413,6 +425,167 @@ static int memory_post_test4(unsigned long start, unsigned long size)
 	return ret;
 }
 
+#ifdef CONFIG_SYS_POST_MEMORY_FAST
+#ifndef CONFIG_SYS_POST_MEMORY_FAST_BLOCK
+#define CONFIG_SYS_POST_MEMORY_FAST_BLOCK	(1 << 20)
+#endif
+
+#define MEMORY_FAST_JOBS	4
+
+static const unsigned long long fast_xor[] = {
+	0x0000000000000000ULL,
+	0xffffffffffffffffULL,
+	0x5555555555555555ULL,
+	0xaaaaaaaaaaaaaaaaULL,
+};
+
+static inline unsigned long long fast_word(volatile unsigned long long *p,
+					   unsigned long long xor)
+{
+	ulong a = (ulong)p;
+
+	return ((unsigned long long)~a << 32 | a) ^ xor;
+}
+
+/* Number of bad words in the block; *bad is set to the first one */
+static ulong memory_post_fast_block(ulong start, ulong size,
+				    unsigned long long xor,
+				    volatile unsigned long long **bad)
+{
+	volatile unsigned long long *mem = (unsigned long long *)start;
+	volatile unsigned long long *end = mem + size / sizeof(*mem);
+	volatile unsigned long long *p;
+	ulong errs = 0;
+
+	for (p = mem; p < end; p += 4) {
+		p[0] = fast_word(&p[0], xor);
+		p[1] = fast_word(&p[1], xor);
+		p[2] = fast_word(&p[2], xor);
+		p[3] = fast_word(&p[3], xor);
+	}
+
+	flush_dcache_range(start, start + size);
+	invalidate_dcache_range(start, start + size);
+
+	for (p = mem; p < end; p += 4) {
+		if (p[0] != fast_word(&p[0], xor) ||
+		    p[1] != fast_word(&p[1], xor) ||
+		    p[2] != fast_word(&p[2], xor) ||
+		    p[3] != fast_word(&p[3], xor)) {
+			int i;
+
+			for (i = 0; i < 4; i++) {
+				if (p[i] == fast_word(&p[i], xor))
+					continue;
+				if (!errs++)
+					*bad = &p[i];
+			}
+		}
+	}
+
+	return errs;
+}
+
+static void memory_post_fast_log(ulong start, ulong size,
+				 unsigned long long xor)
+{
+	volatile unsigned long long *bad = NULL;
+	unsigned long long val;
+
+	if (!memory_post_fast_block(start, size, xor, &bad))
+		return;
+
+	val = *bad;
+	post_log("Memory error at %08x, wrote %08x%08x, read %08x%08x !\n",
+		 (ulong)bad, (uint)(fast_word(bad, xor) >> 32),
+		 (uint)fast_word(bad, xor), (uint)(val >> 32), (uint)val);
+}
+
+static void memory_post_fast_job(struct mp_job *job)
+{
+	volatile unsigned long long *bad;
+	int i;
+
+	job->result = 0;
+	for (i = 0; i < ARRAY_SIZE(fast_xor) && !job->result; i++)
+		job->result = memory_post_fast_block(job->arg[0], job->arg[1],
+						     fast_xor[i], &bad);
+}
+
+/* Test a block here, logging the first error of each failed pass */
+static int memory_post_fast_here(ulong start, ulong size)
+{
+	volatile unsigned long long *bad;
+	int i, ret = 0;
+
+	for (i = 0; i < ARRAY_SIZE(fast_xor); i++) {
+		if (memory_post_fast_block(start, size, fast_xor[i], &bad)) {
+			memory_post_fast_log(start, size, fast_xor[i]);
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+/* Wait for a job; the block of a failed one is done again to log it */
+static int memory_post_fast_reap(struct mp_job *job)
+{
+	int ret = 0;
+
+	if (job->state == MP_JOB_IDLE)
+		return 0;
+	if (mp_job_wait(job)) {
+		memory_post_fast_here(job->arg[0], job->arg[1]);
+		ret = -1;
+	}
+	job->state = MP_JOB_IDLE;
+
+	return ret;
+}
+
+static int memory_post_test_fast(unsigned long start, unsigned long size)
+{
+	struct mp_job jobs[MEMORY_FAST_JOBS];
+	struct mp_job *job;
+	/* the secondary cores are only there once relocated */
+	int mp = gd->flags & GD_FLG_RELOC;
+	int i, next = 0, ret = 0;
+	ulong len;
+
+	memset(jobs, 0, sizeof(jobs));
+	size &= ~(4 * sizeof(unsigned long long) - 1);
+
+	while (size && !ret) {
+		len = min(size, (ulong)CONFIG_SYS_POST_MEMORY_FAST_BLOCK);
+
+		/* the jobs are started in turn, so this is the oldest */
+		job = &jobs[next];
+		ret = memory_post_fast_reap(job);
+		if (ret)
+			break;
+
+		job->func = memory_post_fast_job;
+		job->arg[0] = start;
+		job->arg[1] = len;
+		if (mp && mp_job_start(job) == 0)
+			next = (next + 1) % MEMORY_FAST_JOBS;
+		else
+			ret = memory_post_fast_here(start, len);
+
+		WATCHDOG_RESET();
+		start += len;
+		size -= len;
+	}
+
+	for (i = 0; i < MEMORY_FAST_JOBS; i++)
+		if (memory_post_fast_reap(&jobs[i]))
+			ret = -1;
+
+	return ret;
+}
+#endif /* CONFIG_SYS_POST_MEMORY_FAST */
+
 static int memory_post_test_lines(unsigned long start, unsigned long size)
 {
 	int ret = 0;
@@ -481,8 +654,13 @@ static int memory_post_tests(unsigned long start, unsigned long size)
 	int ret = 0;
 
 	ret = memory_post_test_lines(start, size);
+#ifdef CONFIG_SYS_POST_MEMORY_FAST
+	if (!ret)
+		ret = memory_post_test_fast(start, size);
+#else
 	if (!ret)
 		ret = memory_post_test_patterns(start, size);
+#endif
 
 	return ret;
 }
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <sys/file.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
@@ -106,6 +107,7 @@ struct environment {
 	unsigned char		*flags;
 	char			*data;
 	enum flag_scheme	flag_scheme;
+	int			dirty;	/* data differ from the flash */
 };
 
 static struct environment environment = {
@@ -207,6 +209,30 @@ static char default_environment[] = {
 	"\0"		/* Termimate struct environment data with 2 NULs */
 };
 
+#ifdef CONFIG_CACHE_FILE
+/*
+ * The environment as last read from or written to the flash, so that
+ * the next fw_printenv needn't read it again.  This has to be on a
+ * tmpfs: the copy must not outlive a reboot, when U-Boot may have
+ * changed the environment.  The header says which copy this is and
+ * how to write the next one; the image has to pass its CRC check.
+ */
+struct env_cache {
+	uint32_t	magic;
+	uint32_t	env_size;
+	char		devname[2][16];
+	ulong		devoff[2];
+	uint8_t		mtd_type[2];
+	uint8_t		dev_current;
+	uint8_t		flag_scheme;
+};
+
+#define ENV_CACHE_MAGIC	0x55456e76	/* "UEnv" */
+
+static int env_cache_read (void);
+static void env_cache_write (void);
+#endif
+
 static int flash_io (int mode);
 static char *envmatch (char * s1, char * s2);
 static int parse_config (void);
@@ -343,6 +369,10 @@ int fw_printenv (int argc, char *argv[])
 
 int fw_env_close(void)
 {
+	/* nothing changed, spare the flash an erase cycle */
+	if (!environment.dirty)
+		return 0;
+
 	/*
 	 * Update CRC
 	 */
@@ -352,9 +382,47 @@ int fw_env_close(void)
 	if (flash_io(O_RDWR)) {
 		fprintf(stderr,
 			"Error: can't write fw_env to flash\n");
+#ifdef CONFIG_CACHE_FILE
+		/* we can't tell what the flash has now */
+		unlink(CONFIG_CACHE_FILE);
+#endif
 			return -1;
 	}
+	environment.dirty = 0;
+
+#ifdef CONFIG_CACHE_FILE
+	env_cache_write();
+#endif
+	return 0;
+}
+
+/*
+ * Serialize the tools against each other: the readers take the lock
+ * shared, fw_setenv exclusive for its whole read-modify-write cycle.
+ * The lock is held until the program exits.  Without the lock
+ * directory (e.g. no /var/lock yet early at boot) we run unlocked.
+ */
+int fw_env_lock(int exclusive)
+{
+#ifdef CONFIG_LOCK_FILE
+	int fd;
+
+	fd = open(CONFIG_LOCK_FILE, O_RDONLY | O_CREAT, 0644);
+	if (fd < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "Can't open %s: %s, not locking\n",
+			CONFIG_LOCK_FILE, strerror(errno));
+#endif
+		return 0;
+	}
 
+	if (flock(fd, exclusive ? LOCK_EX : LOCK_SH)) {
+		fprintf(stderr, "Can't lock %s: %s\n",
+			CONFIG_LOCK_FILE, strerror(errno));
+		close(fd);
+		return -1;
+	}
+#endif
 	return 0;
 }
 
@@ -400,6 +468,11 @@ int fw_env_write(char *name, char *value)
 			return -1;
 		}
 
+		/* same value again */
+		if (value && strcmp (oldval, value) == 0)
+			return 0;
+
+		environment.dirty = 1;
 		if (*++nxt == '\0') {
 			*env = '\0';
 		} else {
@@ -438,6 +511,7 @@ int fw_env_write(char *name, char *value)
 		return -1;
 	}
 
+	environment.dirty = 1;
 	while ((*env = *name++) != '\0')
 		env++;
 	*env = '=';
@@ -747,7 +821,7 @@ static int flash_read_buf (int dev, int fd, void *buf, size_t count,
 /*
  * Write count bytes at offset, but stay within ENVSECTORS (dev) sectors of
  * DEVOFFSET (dev). Similar to the read case above, on NOR and dataflash we
- * erase and write the whole data at once.
+ * erase and write the sectors holding the data at once.
  */
 static int flash_write_buf (int dev, int fd, void *buf, size_t count,
 			    off_t offset, uint8_t mtd_type)
@@ -829,7 +903,8 @@ static int flash_write_buf (int dev, int fd, void *buf, size_t count,
 		 */
 		erasesize = blocklen;
 	} else {
-		erasesize = erase_len;
+		/* only the sectors the environment is in */
+		erasesize = write_total;
 	}
 
 	erase.length = erasesize;
@@ -1041,6 +1116,10 @@ exit:
 		return -1;
 	}
 
+	/* the copy just written is the current one now */
+	if (mode == O_RDWR && rc == 0)
+		dev_current = dev_target;
+
 	return rc;
 }
 
@@ -1104,6 +1183,11 @@ int fw_env_open(void)
 	}
 
 	dev_current = 0;
+#ifdef CONFIG_CACHE_FILE
+	if (env_cache_read () == 0)
+		return 0;
+	dev_current = 0;
+#endif
 	if (flash_io (O_RDONLY))
 		return -1;
 
@@ -1114,6 +1198,7 @@ int fw_env_open(void)
 			fprintf (stderr,
 				"Warning: Bad CRC, using default environment\n");
 			memcpy(environment.data, default_environment, sizeof default_environment);
+			environment.dirty = 1;
 		}
 	} else {
 		flag0 = *environment.flags;
@@ -1164,6 +1249,7 @@ int fw_env_open(void)
 				"Warning: Bad CRC, using default environment\n");
 			memcpy (environment.data, default_environment,
 				sizeof default_environment);
+			environment.dirty = 1;
 			dev_current = 0;
 		} else {
 			switch (environment.flag_scheme) {
@@ -1217,9 +1303,103 @@ int fw_env_open(void)
 			free (addr1);
 		}
 	}
+
+#ifdef CONFIG_CACHE_FILE
+	/* a default environment is not what the flash has */
+	if (!environment.dirty)
+		env_cache_write ();
+#endif
 	return 0;
 }
 
+#ifdef CONFIG_CACHE_FILE
+static void env_cache_header (struct env_cache *c)
+{
+	int i;
+
+	memset (c, 0, sizeof (*c));
+	c->magic = ENV_CACHE_MAGIC;
+	c->env_size = CONFIG_ENV_SIZE;
+	for (i = 0; i <= HaveRedundEnv; i++) {
+		strcpy (c->devname[i], DEVNAME (i));
+		c->devoff[i] = DEVOFFSET (i);
+		c->mtd_type[i] = DEVTYPE (i);
+	}
+	c->dev_current = dev_current;
+	c->flag_scheme = environment.flag_scheme;
+}
+
+/*
+ * Take the environment from the cache, if that is of the devices in
+ * the config (which may have been edited) and intact.  Called with
+ * environment.* pointing into a buffer of ENVSIZE (0) bytes.
+ */
+static int env_cache_read (void)
+{
+	struct env_cache c, want;
+	int fd, i, rc = -1;
+
+	fd = open (CONFIG_CACHE_FILE, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	if (read (fd, &c, sizeof (c)) != sizeof (c))
+		goto out;
+
+	env_cache_header (&want);
+	if (c.magic != want.magic || c.env_size != want.env_size ||
+	    c.dev_current > HaveRedundEnv ||
+	    ENVSIZE (c.dev_current) != c.env_size)
+		goto out;
+	for (i = 0; i <= HaveRedundEnv; i++)
+		if (strcmp (c.devname[i], want.devname[i]) ||
+		    c.devoff[i] != want.devoff[i])
+			goto out;
+
+	if (read (fd, environment.image, c.env_size) != c.env_size)
+		goto out;
+
+	dev_current = c.dev_current;
+	if (crc32 (0, (uint8_t *) environment.data, ENV_SIZE) !=
+	    *environment.crc)
+		goto out;
+
+	DEVTYPE (0) = c.mtd_type[0];
+	DEVTYPE (1) = c.mtd_type[1];
+	environment.flag_scheme = c.flag_scheme;
+	rc = 0;
+out:
+	close (fd);
+	return rc;
+}
+
+/*
+ * Replace the cache by the environment now in the flash.  Readers
+ * hold the lock only shared, so write a new file and rename it.
+ */
+static void env_cache_write (void)
+{
+	char tmp[] = CONFIG_CACHE_FILE ".XXXXXX";
+	struct env_cache c;
+	int fd;
+
+	fd = mkstemp (tmp);
+	if (fd < 0)
+		return;
+
+	env_cache_header (&c);
+	if (write (fd, &c, sizeof (c)) != sizeof (c) ||
+	    write (fd, environment.image, CONFIG_ENV_SIZE) !=
+	    CONFIG_ENV_SIZE ||
+	    close (fd) ||
+	    rename (tmp, CONFIG_CACHE_FILE)) {
+		unlink (tmp);
+		unlink (CONFIG_CACHE_FILE);
+		return;
+	}
+}
+#endif
+
 
 static int parse_config ()
 {
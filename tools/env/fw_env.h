@@ -29,6 +29,16 @@
  */
 #define CONFIG_FILE     "/etc/fw_env.config"
 
+/*
+ * Lock file serializing fw_printenv and fw_setenv, and the copy of
+ * the environment that saves fw_printenv from reading the flash.
+ * The cache must be on a tmpfs, so that it is gone after a reboot;
+ * comment out CONFIG_CACHE_FILE if another program writes the
+ * environment, too.
+ */
+#define CONFIG_LOCK_FILE	"/var/lock/fw_env.lock"
+#define CONFIG_CACHE_FILE	"/var/run/fw_env.cache"
+
 #define HAVE_REDUND /* For systems with 2 env sectors */
 #define DEVICE1_NAME      "/dev/mtd1"
 #define DEVICE2_NAME      "/dev/mtd2"
@@ -52,5 +62,6 @@ extern int fw_parse_script(char *fname);
 extern int fw_env_open(void);
 extern int fw_env_write(char *name, char *value);
 extern int fw_env_close(void);
+extern int fw_env_lock(int exclusive);
 
 extern unsigned	long  crc32	 (unsigned long, const unsigned char *, unsigned);
@@ -30,6 +30,9 @@
 #include "mkimage.h"
 #include <image.h>
 #include <u-boot/crc.h>
+#ifndef __MINGW32__
+#include <pthread.h>
+#endif
 
 static image_header_t header;
 
@@ -47,6 +50,453 @@ static int fit_check_image_types (uint8_t type)
 		return EXIT_FAILURE;
 }
 
+/*
+ * Move the data of one image to a multiple of align from the start of
+ * the blob.  libfdt adds new properties at the start of a node, so a
+ * "data-pad" property in front of "data" takes up the difference.
+ */
+static int fit_align_image (void *fit, int noffset, unsigned int align)
+{
+	const char *data;
+	char *pad;
+	int len, pad_len, ret;
+	unsigned int misalign;
+
+	data = fdt_getprop (fit, noffset, FIT_DATA_PROP, &len);
+	if (!data)
+		return 0;
+	misalign = (data - (const char *)fit) & (align - 1);
+	if (!misalign)
+		return 0;
+
+	/* add the property empty first, so its header is accounted for */
+	if (!fdt_getprop (fit, noffset, FIT_DATA_PAD_PROP, &pad_len)) {
+		ret = fdt_setprop (fit, noffset, FIT_DATA_PAD_PROP, "", 0);
+		if (ret)
+			return ret;
+		pad_len = 0;
+		data = fdt_getprop (fit, noffset, FIT_DATA_PROP, &len);
+		misalign = (data - (const char *)fit) & (align - 1);
+	}
+
+	/* both are a multiple of 4, so the data moves by what we add */
+	pad_len += (align - misalign) & (align - 1);
+	pad = calloc (1, pad_len + 1);
+	if (!pad)
+		return -FDT_ERR_NOSPACE;
+	ret = fdt_setprop (fit, noffset, FIT_DATA_PAD_PROP, pad, pad_len);
+	free (pad);
+	return ret;
+}
+
+/**
+ * fit_align_data - align the data of all images in the blob
+ *
+ * With the data of the kernel and ramdisk images aligned, a FIT loaded
+ * to an aligned address can be booted without copying them: the kernel
+ * runs in place if its load address is where its data ended up (see
+ * mkimage -l), and the ramdisk is used in place.
+ *
+ * The blob file is grown to make room for the padding, and packed
+ * again afterwards.
+ *
+ * returns:
+ *     0 on success, the blob is mapped at *ptrp, sbuf->st_size long
+ *     -1 otherwise
+ */
+static int fit_align_data (struct mkimage_params *params, int tfd,
+			   unsigned char **ptrp, struct stat *sbuf)
+{
+	void *fit = *ptrp;
+	int images_noffset, noffset, ndepth, count = 0, pass, ret;
+	off_t size;
+
+	images_noffset = fdt_path_offset (fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return -1;
+	for (ndepth = 0, noffset = fdt_next_node (fit, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node (fit, noffset, &ndepth))
+		if (ndepth == 1)
+			count++;
+
+	size = fdt_totalsize (fit) + count * (params->align + 64);
+	munmap (fit, sbuf->st_size);
+	*ptrp = NULL;
+	if (ftruncate (tfd, size) < 0)
+		return -1;
+	fit = mmap (0, size, PROT_READ|PROT_WRITE, MAP_SHARED, tfd, 0);
+	if (fit == MAP_FAILED)
+		return -1;
+	*ptrp = fit;
+	sbuf->st_size = size;
+
+	/*
+	 * Pack first, so that packing away the spare room once the data
+	 * has been padded leaves the struct block where it is.  The
+	 * second pass checks that nothing moved, as there is no room
+	 * left to pad again.
+	 */
+	if (fdt_pack (fit) || fdt_open_into (fit, fit, size))
+		return -1;
+
+	for (pass = 0; pass < 2; pass++) {
+		images_noffset = fdt_path_offset (fit, FIT_IMAGES_PATH);
+		for (ndepth = 0,
+		     noffset = fdt_next_node (fit, images_noffset, &ndepth);
+		     (noffset >= 0) && (ndepth > 0);
+		     noffset = fdt_next_node (fit, noffset, &ndepth)) {
+			if (ndepth != 1)
+				continue;
+			ret = fit_align_image (fit, noffset, params->align);
+			if (ret) {
+				fprintf (stderr, "%s: Can't align %s: %s\n",
+					params->cmdname,
+					fit_get_name (fit, noffset, NULL),
+					fdt_strerror (ret));
+				return -1;
+			}
+		}
+		if (pass == 0 && fdt_pack (fit))
+			return -1;
+	}
+
+	return ftruncate (tfd, fdt_totalsize (fit)) < 0 ? -1 : 0;
+}
+
+/**
+ * fit_extract_data - move the data of all images behind the blob
+ *
+ * Every "data" property is replaced by "data-offset" and "data-size",
+ * and the data is placed after the blob, from the first multiple of
+ * four on (see fit_image_get_data_position()).  Only the blob has to
+ * be loaded then to pick a configuration.  With -B, the data of each
+ * image starts at a multiple of align from the start of the file.
+ *
+ * returns:
+ *     0 on success, the file is mapped at *ptrp, sbuf->st_size long
+ *     -1 otherwise
+ */
+static int fit_extract_data (struct mkimage_params *params, int tfd,
+			     unsigned char **ptrp, struct stat *sbuf)
+{
+	void *fit = *ptrp, *buf = NULL;
+	unsigned char *out = NULL;
+	const void *data;
+	int images_noffset, out_images, noffset, ndepth, count = 0, ret = -1;
+	int len, bufsize;
+	uint32_t val;
+	ulong base, pos;
+
+	images_noffset = fdt_path_offset (fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0)
+		return -1;
+	for (ndepth = 0, noffset = fdt_next_node (fit, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node (fit, noffset, &ndepth))
+		if (ndepth == 1)
+			count++;
+
+	/* the new properties can take more room than small data did */
+	bufsize = fdt_totalsize (fit) + count * 64;
+	buf = malloc (bufsize);
+	if (!buf || fdt_open_into (fit, buf, bufsize))
+		goto out;
+
+	/*
+	 * Replace the data by placeholders first, the same size whatever
+	 * the offsets turn out to be, and fill those in once the size of
+	 * the blob is final.  The data itself is still read from fit.
+	 */
+	images_noffset = fdt_path_offset (buf, FIT_IMAGES_PATH);
+	for (ndepth = 0, noffset = fdt_next_node (buf, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node (buf, noffset, &ndepth)) {
+		if (ndepth != 1 ||
+		    !fdt_getprop (buf, noffset, FIT_DATA_PROP, &len))
+			continue;
+		val = cpu_to_uimage (len);
+		if (fdt_delprop (buf, noffset, FIT_DATA_PROP) ||
+		    fdt_setprop (buf, noffset, FIT_DATA_SIZE_PROP,
+				 &val, sizeof (val)) ||
+		    fdt_setprop (buf, noffset, FIT_DATA_OFFSET_PROP,
+				 &val, sizeof (val)))
+			goto out;
+	}
+	if (fdt_pack (buf))
+		goto out;
+
+	/* now lay the data out behind the blob */
+	base = FIT_EXTERNAL_DATA (buf);
+	pos = 0;
+	images_noffset = fdt_path_offset (buf, FIT_IMAGES_PATH);
+	for (ndepth = 0, noffset = fdt_next_node (buf, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node (buf, noffset, &ndepth)) {
+		if (ndepth != 1 ||
+		    !fdt_getprop (buf, noffset, FIT_DATA_SIZE_PROP, NULL))
+			continue;
+		if (params->align)
+			pos = ((base + pos + params->align - 1) &
+			       ~(ulong)(params->align - 1)) - base;
+		val = cpu_to_uimage (pos);
+		if (fdt_setprop_inplace (buf, noffset, FIT_DATA_OFFSET_PROP,
+					 &val, sizeof (val)))
+			goto out;
+		pos += uimage_to_cpu (*(uint32_t *)fdt_getprop (buf, noffset,
+					FIT_DATA_SIZE_PROP, NULL));
+		pos = (pos + 3) & ~3;
+	}
+
+	/* the old blob is where the data comes from, so build it aside */
+	out = calloc (1, base + pos);
+	if (!out)
+		goto out;
+	memcpy (out, buf, fdt_totalsize (buf));
+
+	out_images = fdt_path_offset (out, FIT_IMAGES_PATH);
+	images_noffset = fdt_path_offset (fit, FIT_IMAGES_PATH);
+	for (ndepth = 0, noffset = fdt_next_node (fit, images_noffset, &ndepth);
+	     (noffset >= 0) && (ndepth > 0);
+	     noffset = fdt_next_node (fit, noffset, &ndepth)) {
+		ulong offset;
+		size_t size;
+		int n;
+
+		if (ndepth != 1)
+			continue;
+		data = fdt_getprop (fit, noffset, FIT_DATA_PROP, &len);
+		if (!data)
+			continue;
+		n = fdt_subnode_offset (out, out_images,
+					fit_get_name (fit, noffset, NULL));
+		if (n < 0 ||
+		    fit_image_get_data_position (out, n, &offset, &size) ||
+		    size != len)
+			goto out;
+		memcpy (out + offset, data, len);
+	}
+
+	munmap (fit, sbuf->st_size);
+	*ptrp = NULL;
+	sbuf->st_size = base + pos;
+	if (ftruncate (tfd, sbuf->st_size) < 0 ||
+	    pwrite (tfd, out, sbuf->st_size, 0) != sbuf->st_size)
+		goto out;
+	fit = mmap (0, sbuf->st_size, PROT_READ|PROT_WRITE, MAP_SHARED,
+		    tfd, 0);
+	if (fit == MAP_FAILED)
+		goto out;
+	*ptrp = fit;
+	ret = 0;
+
+out:
+	free (out);
+	free (buf);
+	return ret;
+}
+
+/*
+ * Hashing a FIT of large images takes most of the time mkimage spends
+ * on it, so the hashes are computed by a thread per CPU, the largest
+ * images first, before any value is written.  The values are then set
+ * from the last hash node in the blob to the first, as every one moves
+ * what comes behind it.  This does what fit_set_hashes() does.
+ */
+struct fit_hash_job {
+	int		image_noffset;
+	int		noffset;
+	const void	*data;
+	size_t		size;
+	char		*algo;
+	uint8_t		value[FIT_MAX_HASH_LEN];
+	int		value_len;
+	int		ret;
+};
+
+static struct fit_hash_job **fit_hash_order;
+static int fit_hash_njobs;
+static int fit_hash_next;
+#ifndef __MINGW32__
+static pthread_mutex_t fit_hash_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void *fit_hash_worker (void *arg)
+{
+	struct fit_hash_job *job;
+	int n;
+
+	for (;;) {
+#ifndef __MINGW32__
+		pthread_mutex_lock (&fit_hash_lock);
+#endif
+		n = fit_hash_next++;
+#ifndef __MINGW32__
+		pthread_mutex_unlock (&fit_hash_lock);
+#endif
+		if (n >= fit_hash_njobs)
+			break;
+
+		job = fit_hash_order[n];
+		job->ret = calculate_hash (job->data, job->size, job->algo,
+					   job->value, &job->value_len);
+	}
+	return NULL;
+}
+
+static int fit_hash_cmp (const void *a, const void *b)
+{
+	const struct fit_hash_job *ja = *(struct fit_hash_job **)a;
+	const struct fit_hash_job *jb = *(struct fit_hash_job **)b;
+
+	if (ja->size != jb->size)
+		return ja->size < jb->size ? 1 : -1;
+	return ja->noffset - jb->noffset;
+}
+
+static void fit_hash_run (void)
+{
+#ifndef __MINGW32__
+	pthread_t *threads;
+	long cpus;
+	int i, nthreads = 0;
+
+	cpus = sysconf (_SC_NPROCESSORS_ONLN);
+	if (cpus > fit_hash_njobs)
+		cpus = fit_hash_njobs;
+	threads = cpus > 1 ? calloc (cpus - 1, sizeof (*threads)) : NULL;
+
+	/* this thread is one of them; if no more start, it does it all */
+	for (i = 0; threads && i < cpus - 1; i++) {
+		if (pthread_create (&threads[i], NULL, fit_hash_worker, NULL))
+			break;
+		nthreads++;
+	}
+	fit_hash_worker (NULL);
+	for (i = 0; i < nthreads; i++)
+		pthread_join (threads[i], NULL);
+	free (threads);
+#else
+	fit_hash_worker (NULL);
+#endif
+}
+
+static int fit_set_hashes_parallel (void *fit)
+{
+	struct fit_hash_job *jobs = NULL, *job;
+	int images_noffset, image_noffset, noffset;
+	int idepth, ndepth, njobs = 0, size = 0;
+	const void *data;
+	size_t data_size;
+	char *algo;
+	int i, ret = -1;
+
+	images_noffset = fdt_path_offset (fit, FIT_IMAGES_PATH);
+	if (images_noffset < 0) {
+		printf ("Can't find images parent node '%s' (%s)\n",
+			FIT_IMAGES_PATH, fdt_strerror (images_noffset));
+		return images_noffset;
+	}
+
+	for (idepth = 0,
+	     image_noffset = fdt_next_node (fit, images_noffset, &idepth);
+	     (image_noffset >= 0) && (idepth > 0);
+	     image_noffset = fdt_next_node (fit, image_noffset, &idepth)) {
+		if (idepth != 1)
+			continue;
+
+		if (fit_image_get_data (fit, image_noffset, &data,
+					&data_size)) {
+			printf ("Can't get image data/size\n");
+			goto out;
+		}
+
+		for (ndepth = 0,
+		     noffset = fdt_next_node (fit, image_noffset, &ndepth);
+		     (noffset >= 0) && (ndepth > 0);
+		     noffset = fdt_next_node (fit, noffset, &ndepth)) {
+			if (ndepth != 1 ||
+			    strncmp (fit_get_name (fit, noffset, NULL),
+				     FIT_HASH_NODENAME,
+				     strlen (FIT_HASH_NODENAME)) != 0)
+				continue;
+
+			if (fit_image_hash_get_algo (fit, noffset, &algo)) {
+				printf ("Can't get hash algo property for "
+					"'%s' hash node in '%s' image node\n",
+					fit_get_name (fit, noffset, NULL),
+					fit_get_name (fit, image_noffset,
+						      NULL));
+				goto out;
+			}
+
+			if (njobs == size) {
+				size = size ? 2 * size : 16;
+				job = realloc (jobs, size * sizeof (*jobs));
+				if (!job) {
+					printf ("Out of memory\n");
+					goto out;
+				}
+				jobs = job;
+			}
+			job = &jobs[njobs++];
+			job->image_noffset = image_noffset;
+			job->noffset = noffset;
+			job->data = data;
+			job->size = data_size;
+			job->algo = algo;
+		}
+	}
+
+	if (!njobs) {
+		ret = 0;
+		goto out;
+	}
+
+	fit_hash_order = malloc (njobs * sizeof (*fit_hash_order));
+	if (!fit_hash_order) {
+		printf ("Out of memory\n");
+		goto out;
+	}
+	for (i = 0; i < njobs; i++)
+		fit_hash_order[i] = &jobs[i];
+	qsort (fit_hash_order, njobs, sizeof (*fit_hash_order), fit_hash_cmp);
+	fit_hash_njobs = njobs;
+	fit_hash_next = 0;
+	fit_hash_run ();
+
+	for (i = 0; i < njobs; i++) {
+		job = &jobs[i];
+		if (job->ret) {
+			printf ("Unsupported hash algorithm (%s) for "
+				"'%s' hash node in '%s' image node\n",
+				job->algo, fit_get_name (fit, job->noffset, NULL),
+				fit_get_name (fit, job->image_noffset, NULL));
+			goto out;
+		}
+	}
+
+	/* the offsets in front of a change stay as they are */
+	for (i = njobs - 1; i >= 0; i--) {
+		job = &jobs[i];
+		if (fit_image_hash_set_value (fit, job->noffset, job->value,
+					      job->value_len)) {
+			printf ("Can't set hash value for "
+				"'%s' hash node in '%s' image node\n",
+				fit_get_name (fit, job->noffset, NULL),
+				fit_get_name (fit, job->image_noffset, NULL));
+			goto out;
+		}
+	}
+	ret = 0;
+
+out:
+	free (fit_hash_order);
+	fit_hash_order = NULL;
+	free (jobs);
+	return ret;
+}
+
 /**
  * fit_handle_file - main FIT file processing function
  *
@@ -125,7 +575,7 @@ static int fit_handle_file (struct mkimage_params *params)
 	}
 
 	/* set hashes for images in the blob */
-	if (fit_set_hashes (ptr)) {
+	if (fit_set_hashes_parallel (ptr)) {
 		fprintf (stderr, "%s Can't add hashes to FIT blob",
 				params->cmdname);
 		unlink (tmpfile);
@@ -141,6 +591,21 @@ static int fit_handle_file (struct mkimage_params *params)
 	}
 	debug ("Added timestamp successfully\n");
 
+	/* last, as the hashes and the timestamp move data about */
+	if (params->Eflag) {
+		if (fit_extract_data (params, tfd, &ptr, &sbuf)) {
+			fprintf (stderr, "%s: Can't move image data out of "
+					"the FIT blob\n", params->cmdname);
+			unlink (tmpfile);
+			return (EXIT_FAILURE);
+		}
+	} else if (params->align && fit_align_data (params, tfd, &ptr, &sbuf)) {
+		fprintf (stderr, "%s: Can't align image data to 0x%x\n",
+				params->cmdname, params->align);
+		unlink (tmpfile);
+		return (EXIT_FAILURE);
+	}
+
 	munmap ((void *)ptr, sbuf.st_size);
 	close (tfd);
 
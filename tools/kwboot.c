@@ -16,9 +16,12 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <termios.h>
 #include <sys/mman.h>
+#include <sys/select.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 
 #include "kwbimage.h"
 
@@ -65,6 +68,8 @@ struct kwboot_block {
 
 static int kwboot_verbose = 0;
 
+static int patch;
+
 static void
 kwboot_printv(const char *fmt, ...)
 {
@@ -144,6 +149,43 @@ kwboot_tty_send_char(int fd, unsigned char c)
     return kwboot_tty_send(fd, &c, 1);
 }
 
+static speed_t
+kwboot_tty_speed(int baudrate)
+{
+    switch (baudrate) {
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+#ifdef B460800
+    case 460800:
+        return B460800;
+#endif
+#ifdef B500000
+    case 500000:
+        return B500000;
+#endif
+#ifdef B921600
+    case 921600:
+        return B921600;
+#endif
+#ifdef B1000000
+    case 1000000:
+        return B1000000;
+#endif
+#ifdef B1500000
+    case 1500000:
+        return B1500000;
+#endif
+#ifdef B2000000
+    case 2000000:
+        return B2000000;
+#endif
+    }
+
+    return (speed_t)-1;
+}
+
 static int
 kwboot_open_tty(const char *path, speed_t speed)
 {
@@ -235,7 +277,7 @@ kwboot_xm_makeblock(struct kwboot_block *block,
 }
 
 static int
-kwboot_xm_sendblock(int fd, struct kwboot_block *block)
+kwboot_xm_sendblock(int fd, struct kwboot_block *block, int *nretries)
 {
     int rc, retries;
     char c;
@@ -250,10 +292,8 @@ kwboot_xm_sendblock(int fd, struct kwboot_block *block)
         if (rc)
             break;
 
-        if (c == ACK)
-            kwboot_printv(".");
-        else
-            kwboot_printv("+");
+        if (c != ACK)
+            (*nretries)++;
 
     } while (c == NAK && retries-- > 0);
 
@@ -276,15 +316,32 @@ kwboot_xm_sendblock(int fd, struct kwboot_block *block)
     return rc;
 }
 
+/*
+ * The BootROM only takes 128 byte blocks and wants each of them acked
+ * before the next, so the baud rate is all that makes this faster.
+ */
+static void
+kwboot_progress(size_t sent, size_t size)
+{
+    kwboot_printv("\rSending boot image. %3d%%",
+                  size ? (int)(sent * 100 / size) : 100);
+}
+
 static int
 kwboot_xmodem(int tty, const void *_data, size_t size)
 {
     const uint8_t *data = _data;
-    int rc, pnum, err;
+    int rc, pnum, err, nretries, pct;
+    struct timeval start, end;
+    size_t total;
+    double secs;
 
     pnum = 1;
+    nretries = 0;
+    total = size;
+    pct = -1;
 
-    kwboot_printv("Sending boot image. ");
+    gettimeofday(&start, NULL);
 
     do {
         struct kwboot_block block;
@@ -297,7 +354,12 @@ kwboot_xmodem(int tty, const void *_data, size_t size)
         if (!n)
             break;
 
-        rc = kwboot_xm_sendblock(tty, &block);
+        if ((total - size) * 100 / total != pct) {
+            pct = (total - size) * 100 / total;
+            kwboot_progress(total - size, total);
+        }
+
+        rc = kwboot_xm_sendblock(tty, &block, &nretries);
         if (rc)
             goto out;
 
@@ -307,6 +369,16 @@ kwboot_xmodem(int tty, const void *_data, size_t size)
 
     rc = kwboot_tty_send_char(tty, EOT);
 
+    gettimeofday(&end, NULL);
+    secs = (end.tv_sec - start.tv_sec) +
+        (end.tv_usec - start.tv_usec) / 1000000.0;
+
+    kwboot_progress(total, total);
+    kwboot_printv(", %zu bytes in %.1f s (%.0f bytes/s)",
+                  total, secs, secs > 0 ? total / secs : 0.0);
+    if (nretries)
+        kwboot_printv(", %d retries", nretries);
+
 out:
     kwboot_printv("\n");
     return rc;
@@ -470,7 +542,7 @@ kwboot_img_csum8(void *_data, size_t size)
     for (csum = 0; size-- > 0; data++)
         csum += *data;
 
-	return csum;
+    return csum;
 }
 
 static int
@@ -519,7 +591,7 @@ out:
 static void
 kwboot_usage(FILE *stream, char *progname)
 {
-    fprintf(stream, "Usage: %s { -b <image> [-p] | -d } [ -t ] <tty>\n", progname);
+    fprintf(stream, "Usage: %s { -b <image> [-p] | -d } [ -t ] [ -B <baud> ] <tty>\n", progname);
     fprintf(stream, "\n");
 
     fprintf(stream, "  -b: boot <image>\n");
@@ -531,6 +603,10 @@ kwboot_usage(FILE *stream, char *progname)
 
     fprintf(stream, "  -t: mini terminal\n");
     fprintf(stream, "\n");
+
+    fprintf(stream, "  -B: use <baud> instead of 115200, for a target that\n");
+    fprintf(stream, "      listens faster than the BootROM does\n");
+    fprintf(stream, "\n");
 }
 
 int
@@ -538,6 +614,7 @@ main(int argc, char **argv)
 {
     const char *ttypath, *imgpath;
     int rv, rc, tty, term, prot;
+    speed_t speed;
     void *bootmsg;
     void *img;
     size_t size;
@@ -550,11 +627,12 @@ main(int argc, char **argv)
     term = 0;
     patch = 0;
     size = 0;
+    speed = B115200;
 
     kwboot_verbose = isatty(STDOUT_FILENO);
 
     do {
-        int c = getopt(argc, argv, "hb:dpt");
+        int c = getopt(argc, argv, "hb:dptB:");
         if (c < 0)
             break;
 
@@ -577,6 +655,12 @@ main(int argc, char **argv)
             term = 1;
             break;
 
+        case 'B':
+            speed = kwboot_tty_speed(atoi(optarg));
+            if (speed == (speed_t)-1)
+                goto usage;
+            break;
+
         case 'h':
             rv = 0;
         default:
@@ -595,7 +679,7 @@ main(int argc, char **argv)
 
     ttypath = argv[optind++];
 
-    tty = kwboot_open_tty(ttypath, B115200);
+    tty = kwboot_open_tty(ttypath, speed);
     if (tty < 0) {
         perror(ttypath);
         goto out;
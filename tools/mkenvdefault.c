@@ -0,0 +1,157 @@
+/*
+ * Split the board's default environment up at build time
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Writes a header with default_environment[] as an array of ENTRY,
+ * sorted by name, for himport_table() to put into the hash table
+ * without parsing.  The variables are what himport_r() would make of
+ * the string: comments skipped, escapes resolved, later settings
+ * overriding earlier ones and "name=" deleting a variable.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef __ASSEMBLY__
+#define	__ASSEMBLY__			/* Dirty trick to get only #defines	*/
+#endif
+#define	__ASM_STUB_PROCESSOR_H__	/* don't include asm/processor.		*/
+#include <config.h>
+#undef	__ASSEMBLY__
+
+#include <env_default.h>
+
+struct var {
+	char *name;
+	char *value;
+};
+
+static struct var *vars;
+static int nvars;
+
+static struct var *find_var(const char *name)
+{
+	int i;
+
+	for (i = 0; i < nvars; i++)
+		if (strcmp(vars[i].name, name) == 0)
+			return &vars[i];
+	return NULL;
+}
+
+static void set_var(char *name, char *value)
+{
+	struct var *v = find_var(name);
+
+	if (!value) {
+		if (v)
+			*v = vars[--nvars];
+		return;
+	}
+	if (!v) {
+		vars = realloc(vars, (nvars + 1) * sizeof(*vars));
+		if (!vars) {
+			perror("mkenvdefault");
+			exit(EXIT_FAILURE);
+		}
+		v = &vars[nvars++];
+		v->name = name;
+	}
+	v->value = value;
+}
+
+/* As himport_r() parses a '\0' separated environment */
+static void parse(char *dp, char *end)
+{
+	char *name, *value, *sp;
+
+	while (dp < end && *dp) {
+		while (*dp == ' ' || *dp == '\t')
+			++dp;
+
+		if (*dp == '#') {
+			while (*dp)
+				++dp;
+			++dp;
+			continue;
+		}
+
+		for (name = dp; *dp != '=' && *dp; ++dp)
+			;
+
+		if (*dp == '\0' || *(dp + 1) == '\0') {
+			if (*dp == '=')
+				*dp++ = '\0';
+			*dp++ = '\0';
+			set_var(name, NULL);
+			continue;
+		}
+		*dp++ = '\0';
+
+		for (value = sp = dp; *dp; ++dp) {
+			if (*dp == '\\' && *(dp + 1))
+				++dp;
+			*sp++ = *dp;
+		}
+		*sp = '\0';
+		++dp;
+
+		set_var(name, value);
+	}
+}
+
+static int cmp_var(const void *a, const void *b)
+{
+	return strcmp(((const struct var *)a)->name,
+		      ((const struct var *)b)->name);
+}
+
+static void print_string(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if (isprint((unsigned char)*s))
+			putchar(*s);
+		else
+			printf("\\%03o", (unsigned char)*s);
+	}
+	putchar('"');
+}
+
+int main(void)
+{
+	char *env = malloc(sizeof(default_environment));
+	int i;
+
+	if (!env) {
+		perror("mkenvdefault");
+		return EXIT_FAILURE;
+	}
+	memcpy(env, default_environment, sizeof(default_environment));
+	parse(env, env + sizeof(default_environment));
+	qsort(vars, nvars, sizeof(*vars), cmp_var);
+
+	printf("/* Generated by tools/mkenvdefault, do not edit */\n\n");
+	printf("#define ENV_DEFAULT_VARS\t%d\n\n", nvars);
+	printf("static const ENTRY env_default_table[] = {\n");
+	if (!nvars)
+		printf("\t{ NULL, NULL },\n");
+	for (i = 0; i < nvars; i++) {
+		printf("\t{ ");
+		print_string(vars[i].name);
+		printf(", ");
+		print_string(vars[i].value);
+		printf(" },\n");
+	}
+	printf("};\n");
+
+	return EXIT_SUCCESS;
+}
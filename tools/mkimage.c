@@ -180,6 +180,18 @@ main (int argc, char **argv)
 					genimg_get_arch_id (*++argv)) < 0)
 					usage ();
 				goto NXTARG;
+			case 'B':
+				if (--argc <= 0)
+					usage ();
+				params.align = strtoul (*++argv, &ptr, 16);
+				if (*ptr || params.align < 4 ||
+				    (params.align & (params.align - 1))) {
+					fprintf (stderr,
+						"%s: invalid alignment %s\n",
+						params.cmdname, *argv);
+					exit (EXIT_FAILURE);
+				}
+				goto NXTARG;
 			case 'C':
 				if ((--argc <= 0) ||
 					(params.comp =
@@ -191,6 +203,9 @@ main (int argc, char **argv)
 					usage ();
 				params.dtc = *++argv;
 				goto NXTARG;
+			case 'E':
+				params.Eflag = 1;
+				break;
 
 			case 'O':
 				if ((--argc <= 0) ||
@@ -607,7 +622,9 @@ usage ()
 			 "          -d ==> use image data from 'datafile'\n"
 			 "          -x ==> set XIP (execute in place)\n",
 		params.cmdname);
-	fprintf (stderr, "       %s [-D dtc_options] -f fit-image.its fit-image\n",
+	fprintf (stderr, "       %s [-D dtc_options] [-B align] [-E] -f fit-image.its fit-image\n"
+			 "          -B ==> align image data to 'align' bytes (hex)\n"
+			 "          -E ==> place image data after the FIT blob\n",
 		params.cmdname);
 	fprintf (stderr, "       %s -V ==> print version information and exit\n",
 		params.cmdname);
@@ -56,6 +56,7 @@
 struct mkimage_params {
 	int dflag;
 	int eflag;
+	int Eflag;
 	int fflag;
 	int lflag;
 	int vflag;
@@ -66,6 +67,7 @@ struct mkimage_params {
 	int type;
 	int comp;
 	char *dtc;
+	unsigned int align;
 	unsigned int addr;
 	unsigned int ep;
 	char *imagename;